@@ -33,6 +33,7 @@ using std::function;
 using std::is_same_v;
 using std::make_shared;
 using std::memory_order_relaxed;
+using std::move;
 using std::mt19937;
 using std::random_device;
 using std::shared_ptr;
@@ -52,23 +53,39 @@ ExecutionResult AsyncExecutor::Init() noexcept {
     return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_INVALID_QUEUE_CAP);
   }
 
+  // Work stealing dequeues from the queues of the siblings, which the single
+  // consumer ring buffers do not allow.
+  if (task_load_balancing_scheme_ == TaskLoadBalancingScheme::WorkStealing &&
+      task_queue_type_ == TaskQueueType::RingBuffer) {
+    return FailureExecutionResult(
+        errors::SC_ASYNC_EXECUTOR_INVALID_TASK_QUEUE_TYPE);
+  }
+
   for (size_t i = 0; i < thread_count_; ++i) {
     // TODO We select the CPU affinity just starting at 0 and working our way
     // up. Should we instead randomly assign the CPUs?
     size_t cpu_affinity_number = i % std::thread::hardware_concurrency();
     urgent_task_executor_pool_.push_back(
         make_shared<SingleThreadPriorityAsyncExecutor>(
-            queue_cap_, drop_tasks_on_stop_, cpu_affinity_number));
+            queue_cap_, drop_tasks_on_stop_, cpu_affinity_number,
+            timer_queue_type_));
     auto execution_result = urgent_task_executor_pool_.back()->Init();
     if (!execution_result.Successful()) {
       return execution_result;
     }
     normal_task_executor_pool_.push_back(make_shared<SingleThreadAsyncExecutor>(
-        queue_cap_, drop_tasks_on_stop_, cpu_affinity_number));
+        queue_cap_, drop_tasks_on_stop_, cpu_affinity_number,
+        task_queue_type_));
     execution_result = normal_task_executor_pool_.back()->Init();
     if (!execution_result.Successful()) {
       return execution_result;
     }
+    if (task_load_balancing_scheme_ == TaskLoadBalancingScheme::WorkStealing) {
+      normal_task_executor_pool_.back()->SetWorkStealingCallback(
+          [this, thief_index = i](PooledAsyncTask& task) {
+            return StealNormalTask(thief_index, task);
+          });
+    }
   }
 
   return SuccessExecutionResult();
@@ -133,6 +150,35 @@ ExecutionResult AsyncExecutor::Stop() noexcept {
   return SuccessExecutionResult();
 }
 
+bool AsyncExecutor::StealNormalTask(size_t thief_index,
+                                    PooledAsyncTask& task) noexcept {
+  auto pool_size = normal_task_executor_pool_.size();
+  for (size_t i = 1; i < pool_size; ++i) {
+    auto& victim = normal_task_executor_pool_[(thief_index + i) % pool_size];
+    if (victim->TryStealTask(task)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void AsyncExecutor::WakeUpThiefIfNeeded(
+    const shared_ptr<NormalTaskExecutor>& task_executor) noexcept {
+  if (normal_task_executor_pool_.size() < 2 ||
+      !task_executor->IsExecutingTask() ||
+      task_executor->GetPendingTaskCount() == 0) {
+    return;
+  }
+  auto pool_size = normal_task_executor_pool_.size();
+  auto thief_index =
+      work_stealing_request_counter_.fetch_add(1, memory_order_relaxed) %
+      pool_size;
+  if (normal_task_executor_pool_[thief_index] == task_executor) {
+    thief_index = (thief_index + 1) % pool_size;
+  }
+  normal_task_executor_pool_[thief_index]->RequestWorkStealing();
+}
+
 template <class TaskExecutorType>
 ExecutionResultOr<shared_ptr<TaskExecutorType>> AsyncExecutor::PickTaskExecutor(
     AsyncExecutorAffinitySetting affinity,
@@ -197,7 +243,9 @@ ExecutionResultOr<shared_ptr<TaskExecutorType>> AsyncExecutor::PickTaskExecutor(
     return task_executor_pool.at(picked_index);
   }
 
-  if (task_load_balancing_scheme == TaskLoadBalancingScheme::RoundRobinGlobal) {
+  // Work stealing places the tasks round robin and rebalances them later.
+  if (task_load_balancing_scheme == TaskLoadBalancingScheme::RoundRobinGlobal ||
+      task_load_balancing_scheme == TaskLoadBalancingScheme::WorkStealing) {
     if (task_executor_pool_type == TaskExecutorPoolType::UrgentPool) {
       auto picked_index =
           task_counter_urgent.fetch_add(1) % task_executor_pool.size();
@@ -237,13 +285,32 @@ ExecutionResult AsyncExecutor::Schedule(
     return task_executor->ScheduleFor(work, task.GetExecutionTimestamp());
   }
 
+  return ScheduleNotUrgent(InlineAsyncOperation(work), priority, affinity);
+}
+
+ExecutionResult AsyncExecutor::ScheduleNotUrgent(
+    InlineAsyncOperation work, AsyncPriority priority,
+    AsyncExecutorAffinitySetting affinity) noexcept {
+  if (!running_) {
+    return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_NOT_RUNNING);
+  }
+
   if (priority == AsyncPriority::Normal || priority == AsyncPriority::High) {
     ASSIGN_OR_RETURN(auto task_executor,
                      PickTaskExecutor(affinity, normal_task_executor_pool_,
                                       TaskExecutorPoolType::NotUrgentPool,
                                       task_load_balancing_scheme_));
 
-    return task_executor->Schedule(work, priority);
+    if (task_load_balancing_scheme_ != TaskLoadBalancingScheme::WorkStealing) {
+      return task_executor->ScheduleOperation(
+          move(work), priority, AsyncExecutorAffinitySetting::NonAffinitized);
+    }
+    auto execution_result =
+        task_executor->ScheduleOperation(move(work), priority, affinity);
+    if (execution_result.Successful()) {
+      WakeUpThiefIfNeeded(task_executor);
+    }
+    return execution_result;
   }
 
   return FailureExecutionResult(
@@ -22,6 +22,7 @@
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -31,6 +32,7 @@
 
 #include "async_task.h"
 #include "error_codes.h"
+#include "inline_async_operation.h"
 #include "single_thread_async_executor.h"
 #include "single_thread_priority_async_executor.h"
 
@@ -53,7 +55,14 @@ enum class TaskLoadBalancingScheme {
   /**
    * @brief Random across the executors
    */
-  Random = 2
+  Random = 2,
+  /**
+   * @brief Round Robin across the executors, and idle executors steal pending
+   * normal and high priority tasks from their busy siblings. Tasks affinitized
+   * to the calling executor are only stolen if their executor is starved.
+   * Urgent tasks are not stolen since they are scheduled for a given time.
+   */
+  WorkStealing = 3
 };
 
 /**
@@ -78,16 +87,25 @@ class AsyncExecutor : public AsyncExecutorInterface {
    * the tasks during the stop operation.
    * @param task_load_balancing_scheme indicates the type of load balancing
    * scheme to use for the tasks
+   * @param timer_queue_type indicates the data structure the urgent executors
+   * keep the scheduled tasks in
+   * @param task_queue_type indicates the data structure the normal executors
+   * queue the tasks in. RingBuffer cannot be combined with the WorkStealing
+   * scheme.
    */
-  AsyncExecutor(size_t thread_count, size_t queue_cap,
-                bool drop_tasks_on_stop = false,
-                TaskLoadBalancingScheme task_load_balancing_scheme =
-                    TaskLoadBalancingScheme::RoundRobinGlobal)
+  AsyncExecutor(
+      size_t thread_count, size_t queue_cap, bool drop_tasks_on_stop = false,
+      TaskLoadBalancingScheme task_load_balancing_scheme =
+          TaskLoadBalancingScheme::RoundRobinGlobal,
+      TimerQueueType timer_queue_type = TimerQueueType::PriorityQueue,
+      TaskQueueType task_queue_type = TaskQueueType::ConcurrentQueue)
       : running_(false),
         thread_count_(thread_count),
         queue_cap_(queue_cap),
         drop_tasks_on_stop_(drop_tasks_on_stop),
-        task_load_balancing_scheme_(task_load_balancing_scheme) {}
+        task_load_balancing_scheme_(task_load_balancing_scheme),
+        timer_queue_type_(timer_queue_type),
+        task_queue_type_(task_queue_type) {}
 
   ExecutionResult Init() noexcept override;
 
@@ -102,6 +120,30 @@ class AsyncExecutor : public AsyncExecutorInterface {
       const AsyncOperation& work, AsyncPriority priority,
       AsyncExecutorAffinitySetting affinity) noexcept override;
 
+  /**
+   * @brief Same as above, but the normal and high priority tasks are built
+   * from the callable directly instead of from an AsyncOperation copy of it,
+   * so a callable of up to kInlineAsyncOperationSize bytes is not allocated.
+   * Only used where the executor is known to be an AsyncExecutor.
+   *
+   * @tparam Callable A void() callable other than AsyncOperation.
+   */
+  template <typename Callable,
+            typename = std::enable_if_t<
+                !std::is_same_v<std::decay_t<Callable>, AsyncOperation>>>
+  ExecutionResult Schedule(Callable&& work, AsyncPriority priority,
+                           AsyncExecutorAffinitySetting affinity =
+                               AsyncExecutorAffinitySetting::
+                                   NonAffinitized) noexcept {
+    if (priority == AsyncPriority::Urgent) {
+      // The urgent executors keep the operations as AsyncOperation.
+      return Schedule(AsyncOperation(std::forward<Callable>(work)), priority,
+                      affinity);
+    }
+    return ScheduleNotUrgent(InlineAsyncOperation(std::forward<Callable>(work)),
+                             priority, affinity);
+  }
+
   ExecutionResult ScheduleFor(const AsyncOperation& work,
                               Timestamp timestamp) noexcept override;
 
@@ -122,6 +164,40 @@ class AsyncExecutor : public AsyncExecutorInterface {
   using UrgentTaskExecutor = SingleThreadPriorityAsyncExecutor;
   using NormalTaskExecutor = SingleThreadAsyncExecutor;
 
+  /**
+   * @brief Schedules a normal or high priority task on one of the normal
+   * executors.
+   *
+   * @param work the operation of the task.
+   * @param priority the priority of the task.
+   * @param affinity the affinity with which to schedule the work.
+   * @return ExecutionResult result of the execution with possible error code.
+   */
+  ExecutionResult ScheduleNotUrgent(
+      InlineAsyncOperation work, AsyncPriority priority,
+      AsyncExecutorAffinitySetting affinity) noexcept;
+
+  /**
+   * @brief Steals a task from the normal executors other than the one at
+   * thief_index. Siblings are visited starting from the next one so that
+   * thieves do not all gang up on the same victim.
+   *
+   * @param thief_index the index of the executor looking for work.
+   * @param task the stolen task, if any.
+   * @return true if a task was stolen.
+   */
+  bool StealNormalTask(size_t thief_index,
+                       PooledAsyncTask& task) noexcept;
+
+  /**
+   * @brief If the given executor is busy with a task while others are
+   * waiting on its queues, asks one of its siblings to come and steal them.
+   *
+   * @param task_executor the executor that was just given a task.
+   */
+  void WakeUpThiefIfNeeded(
+      const std::shared_ptr<NormalTaskExecutor>& task_executor) noexcept;
+
   template <class TaskExecutorType>
   ExecutionResultOr<std::shared_ptr<TaskExecutorType>> PickTaskExecutor(
       AsyncExecutorAffinitySetting affinity,
@@ -154,5 +230,11 @@ class AsyncExecutor : public AsyncExecutorInterface {
   /// Load balancing scheme to distribute incoming tasks on to the thread pool
   /// threads.
   TaskLoadBalancingScheme task_load_balancing_scheme_;
+  /// The data structure the urgent executors keep the scheduled tasks in.
+  TimerQueueType timer_queue_type_;
+  /// The data structure the normal executors queue the tasks in.
+  TaskQueueType task_queue_type_;
+  /// Counter to spread the work stealing requests across the executors.
+  std::atomic<uint64_t> work_stealing_request_counter_{0};
 };
 }  // namespace google::scp::core
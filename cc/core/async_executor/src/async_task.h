@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <queue>
@@ -25,6 +26,8 @@
 #include "core/interface/async_executor_interface.h"
 #include "public/core/interface/execution_result.h"
 
+#include "inline_async_operation.h"
+
 namespace google::scp::core {
 /**
  * @brief  Is used by the async executor to encapsulate the async operations
@@ -39,12 +42,12 @@ class AsyncTask {
    * @param async_operation The async operation to be executed.
    */
   AsyncTask(
-      AsyncOperation async_operation = []() {},
+      InlineAsyncOperation async_operation = []() {},
       Timestamp execution_timestamp =
           common::TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks())
-      : async_operation_(async_operation),
+      : async_operation_(std::move(async_operation)),
         execution_timestamp_(execution_timestamp),
-        is_cancelled_(false) {}
+        state_(State::Pending) {}
 
   /**
    * @brief Returns the execution time of the current task.
@@ -55,36 +58,32 @@ class AsyncTask {
 
   /// Calls the current task to be executed.
   void Execute() {
-    cancellation_mutex_.lock();
-    if (is_cancelled_) {
-      cancellation_mutex_.unlock();
+    auto expected_state = State::Pending;
+    if (!state_.compare_exchange_strong(expected_state, State::Executed)) {
       return;
     }
     async_operation_();
-    cancellation_mutex_.unlock();
   }
 
-  /// Calls the current task to be cancelled.
+  /**
+   * @brief Calls the current task to be cancelled. Only a task which has not
+   * started executing yet can be cancelled.
+   *
+   * @return true if the task was cancelled by this call.
+   */
   bool Cancel() {
-    cancellation_mutex_.lock();
-    if (is_cancelled_) {
-      cancellation_mutex_.unlock();
-      return false;
-    }
-
-    is_cancelled_ = true;
-    cancellation_mutex_.unlock();
-    return true;
+    auto expected_state = State::Pending;
+    return state_.compare_exchange_strong(expected_state, State::Cancelled);
   }
 
-  bool IsCancelled() {
-    std::unique_lock lock(cancellation_mutex_);
-    return is_cancelled_;
-  }
+  bool IsCancelled() { return state_.load() == State::Cancelled; }
 
  private:
+  /// The lifecycle of a task. A task leaves the pending state exactly once.
+  enum class State : uint8_t { Pending = 0, Executed = 1, Cancelled = 2 };
+
   /// Async operation to be executed.
-  AsyncOperation async_operation_;
+  InlineAsyncOperation async_operation_;
 
   /**
    * @brief Execution timestamp. A task can be scheduled for the future to be
@@ -92,11 +91,8 @@ class AsyncTask {
    */
   Timestamp execution_timestamp_;
 
-  /// Cancellation mutex
-  std::mutex cancellation_mutex_;
-
-  /// Indicates whether a task was cancelled.
-  bool is_cancelled_;
+  /// The state of the task, replaces a mutex around the cancellation flag.
+  std::atomic<State> state_;
 };
 
 /// Comparer class for the AsyncTasks
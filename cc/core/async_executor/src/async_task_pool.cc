@@ -0,0 +1,139 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "async_task_pool.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "typedef.h"
+
+using std::atomic;
+using std::max;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+using std::mutex;
+using std::unique_lock;
+
+namespace {
+constexpr uint64_t kIndexMask = 0xFFFFFFFF;
+
+constexpr uint64_t MakeHead(uint64_t version, uint64_t index_plus_one) {
+  return (version << 32) | index_plus_one;
+}
+
+constexpr uint64_t GetVersion(uint64_t head) { return head >> 32; }
+
+constexpr uint32_t GetIndexPlusOne(uint64_t head) {
+  return static_cast<uint32_t>(head & kIndexMask);
+}
+}  // namespace
+
+namespace google::scp::core {
+AsyncTaskPool::AsyncTaskPool(size_t max_pooled_tasks)
+    : slab_size_(kAsyncTaskPoolSlabSize),
+      max_slab_count_(
+          max((max_pooled_tasks + kAsyncTaskPoolSlabSize - 1) /
+                  kAsyncTaskPoolSlabSize,
+              static_cast<size_t>(1))),
+      slabs_(new atomic<Node*>[max_slab_count_]),
+      slab_count_(0),
+      free_list_head_(0) {
+  for (size_t i = 0; i < max_slab_count_; i++) {
+    slabs_[i] = nullptr;
+  }
+}
+
+AsyncTaskPool::~AsyncTaskPool() {
+  auto slab_count = slab_count_.load();
+  for (size_t i = 0; i < slab_count; i++) {
+    delete[] slabs_[i].load();
+  }
+}
+
+size_t AsyncTaskPool::GetAllocatedNodeCount() const noexcept {
+  return slab_count_.load() * slab_size_;
+}
+
+AsyncTaskPool::Node* AsyncTaskPool::GetNode(uint32_t index) const noexcept {
+  return &slabs_[index / slab_size_].load(memory_order_acquire)[index %
+                                                                slab_size_];
+}
+
+AsyncTaskPool::Node* AsyncTaskPool::PopFreeNode() noexcept {
+  while (true) {
+    auto head = free_list_head_.load(memory_order_acquire);
+    while (GetIndexPlusOne(head) != 0) {
+      auto* node = GetNode(GetIndexPlusOne(head) - 1);
+      // The node may be popped and pushed back concurrently, in which case the
+      // version of the head changes and the exchange below fails.
+      auto next_index_plus_one =
+          node->next_free_index.load(memory_order_relaxed);
+      auto new_head = MakeHead(GetVersion(head) + 1, next_index_plus_one);
+      if (free_list_head_.compare_exchange_weak(head, new_head,
+                                                memory_order_acquire,
+                                                memory_order_acquire)) {
+        return node;
+      }
+    }
+
+    if (!Grow()) {
+      return nullptr;
+    }
+  }
+}
+
+void AsyncTaskPool::PushFreeNode(Node* node) noexcept {
+  auto head = free_list_head_.load(memory_order_relaxed);
+  do {
+    node->next_free_index.store(GetIndexPlusOne(head), memory_order_relaxed);
+  } while (!free_list_head_.compare_exchange_weak(
+      head, MakeHead(GetVersion(head) + 1, node->index + 1),
+      memory_order_release, memory_order_relaxed));
+}
+
+void AsyncTaskPool::Release(AsyncTask* task) noexcept {
+  task->~AsyncTask();
+  PushFreeNode(reinterpret_cast<Node*>(task));
+}
+
+bool AsyncTaskPool::Grow() noexcept {
+  unique_lock lock(grow_mutex_);
+  // Another thread may have grown the pool while this one was waiting.
+  if (GetIndexPlusOne(free_list_head_.load(memory_order_acquire)) != 0) {
+    return true;
+  }
+
+  auto slab_index = slab_count_.load(memory_order_relaxed);
+  if (slab_index == max_slab_count_) {
+    return false;
+  }
+
+  auto* slab = new (std::nothrow) Node[slab_size_];
+  if (slab == nullptr) {
+    return false;
+  }
+  slabs_[slab_index].store(slab, memory_order_release);
+  slab_count_.store(slab_index + 1, memory_order_release);
+
+  for (size_t i = 0; i < slab_size_; i++) {
+    slab[i].index = static_cast<uint32_t>(slab_index * slab_size_ + i);
+    PushFreeNode(&slab[i]);
+  }
+  return true;
+}
+}  // namespace google::scp::core
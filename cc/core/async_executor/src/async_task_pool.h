@@ -0,0 +1,141 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "async_task.h"
+
+namespace google::scp::core {
+class AsyncTaskPool;
+
+/**
+ * @brief Returns the task to the pool it was acquired from, or deletes it if it
+ * was allocated on the heap because the pool was exhausted.
+ */
+struct AsyncTaskPoolDeleter {
+  void operator()(AsyncTask* task) const noexcept;
+
+  /// The pool owning the task, null for heap allocated tasks.
+  AsyncTaskPool* pool = nullptr;
+};
+
+/// A task owned by an AsyncTaskPool.
+using PooledAsyncTask = std::unique_ptr<AsyncTask, AsyncTaskPoolDeleter>;
+
+/**
+ * @brief A pool of AsyncTask nodes. Nodes are allocated in slabs and recycled
+ * through a lock-free free list, so that in the steady state scheduling a task
+ * neither allocates nor takes a lock. Tasks can be acquired and released from
+ * any thread. Once max_pooled_tasks nodes are in use, tasks fall back to the
+ * heap.
+ *
+ * The pool must outlive all the tasks acquired from it.
+ */
+class AsyncTaskPool {
+ public:
+  /**
+   * @brief Construct a new Async Task Pool object.
+   *
+   * @param max_pooled_tasks the maximum number of nodes the pool allocates.
+   */
+  explicit AsyncTaskPool(size_t max_pooled_tasks);
+
+  ~AsyncTaskPool();
+
+  AsyncTaskPool(const AsyncTaskPool&) = delete;
+  AsyncTaskPool& operator=(const AsyncTaskPool&) = delete;
+
+  /**
+   * @brief Constructs a task on a pooled node.
+   *
+   * @param args the arguments of the AsyncTask constructor.
+   * @return PooledAsyncTask the task.
+   */
+  template <typename... Args>
+  PooledAsyncTask Acquire(Args&&... args) {
+    auto* node = PopFreeNode();
+    if (node == nullptr) {
+      return PooledAsyncTask(new AsyncTask(std::forward<Args>(args)...),
+                             AsyncTaskPoolDeleter{nullptr});
+    }
+    auto* task = new (&node->storage) AsyncTask(std::forward<Args>(args)...);
+    return PooledAsyncTask(task, AsyncTaskPoolDeleter{this});
+  }
+
+  /// Returns the number of nodes allocated by the pool.
+  size_t GetAllocatedNodeCount() const noexcept;
+
+ private:
+  friend struct AsyncTaskPoolDeleter;
+
+  /// A pool node. The task must be the first member so that a task pointer is
+  /// also a node pointer.
+  struct Node {
+    std::aligned_storage_t<sizeof(AsyncTask), alignof(AsyncTask)> storage;
+    /// Index of the next free node.
+    std::atomic<uint32_t> next_free_index;
+    /// Index of this node.
+    uint32_t index;
+  };
+
+  /// Returns the node at the index.
+  Node* GetNode(uint32_t index) const noexcept;
+
+  /// Pops a node from the free list, growing the pool if needed. Returns null
+  /// if the pool is exhausted.
+  Node* PopFreeNode() noexcept;
+
+  /// Destroys the task and pushes its node to the free list.
+  void Release(AsyncTask* task) noexcept;
+
+  /// Pushes the node to the free list.
+  void PushFreeNode(Node* node) noexcept;
+
+  /// Allocates a new slab and pushes its nodes to the free list. Returns false
+  /// if the pool reached its maximum size.
+  bool Grow() noexcept;
+
+  /// Number of nodes per slab.
+  const size_t slab_size_;
+  /// Maximum number of slabs.
+  const size_t max_slab_count_;
+  /// The slabs, only appended to under grow_mutex_.
+  std::unique_ptr<std::atomic<Node*>[]> slabs_;
+  /// Number of allocated slabs.
+  std::atomic<size_t> slab_count_;
+  /**
+   * @brief Head of the free list. The lower 32 bits are the index of the head
+   * node plus one (0 for an empty list), and the upper 32 bits a version which
+   * is bumped on every update to rule out ABA.
+   */
+  std::atomic<uint64_t> free_list_head_;
+  /// Serializes the growth of the pool.
+  std::mutex grow_mutex_;
+};
+
+inline void AsyncTaskPoolDeleter::operator()(AsyncTask* task) const noexcept {
+  if (pool) {
+    pool->Release(task);
+  } else {
+    delete task;
+  }
+}
+}  // namespace google::scp::core
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace google::scp::core {
+/// The size of the inline storage of InlineAsyncOperation. Fits the closures
+/// of FinishContext, which capture an AsyncContext by value.
+static constexpr size_t kInlineAsyncOperationSize = 192;
+
+/**
+ * @brief A move-only void() callable which keeps callables of up to
+ * kInlineAsyncOperationSize bytes inline instead of on the heap. An
+ * AsyncOperation (std::function) fits inline as well, so wrapping one does not
+ * allocate beyond what copying the std::function itself costs.
+ */
+class InlineAsyncOperation {
+ public:
+  InlineAsyncOperation() noexcept : operations_(nullptr) {}
+
+  template <typename Callable,
+            typename = std::enable_if_t<!std::is_same_v<
+                std::decay_t<Callable>, InlineAsyncOperation>>>
+  InlineAsyncOperation(Callable&& callable)  // NOLINT(runtime/explicit)
+      : operations_(&kOperations<std::decay_t<Callable>>) {
+    using CallableType = std::decay_t<Callable>;
+    if constexpr (IsStoredInline<CallableType>()) {
+      new (&storage_) CallableType(std::forward<Callable>(callable));
+    } else {
+      *reinterpret_cast<CallableType**>(&storage_) =
+          new CallableType(std::forward<Callable>(callable));
+    }
+  }
+
+  InlineAsyncOperation(InlineAsyncOperation&& other) noexcept
+      : operations_(other.operations_) {
+    if (operations_) {
+      operations_->move(&other.storage_, &storage_);
+      other.operations_ = nullptr;
+    }
+  }
+
+  InlineAsyncOperation& operator=(InlineAsyncOperation&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      operations_ = other.operations_;
+      if (operations_) {
+        operations_->move(&other.storage_, &storage_);
+        other.operations_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  InlineAsyncOperation(const InlineAsyncOperation&) = delete;
+  InlineAsyncOperation& operator=(const InlineAsyncOperation&) = delete;
+
+  ~InlineAsyncOperation() { Reset(); }
+
+  /// Invokes the callable. Must not be empty.
+  void operator()() { operations_->invoke(&storage_); }
+
+  /// Returns true if a callable is held.
+  explicit operator bool() const noexcept { return operations_ != nullptr; }
+
+  /// Destroys the held callable, if any.
+  void Reset() noexcept {
+    if (operations_) {
+      operations_->destroy(&storage_);
+      operations_ = nullptr;
+    }
+  }
+
+ private:
+  using Storage = std::aligned_storage_t<kInlineAsyncOperationSize,
+                                         alignof(std::max_align_t)>;
+
+  /// Type erased operations on the held callable.
+  struct Operations {
+    void (*invoke)(void* storage);
+    /// Moves the callable from the source storage and destroys the source.
+    void (*move)(void* source, void* destination) noexcept;
+    void (*destroy)(void* storage) noexcept;
+  };
+
+  template <typename CallableType>
+  static constexpr bool IsStoredInline() {
+    return sizeof(CallableType) <= sizeof(Storage) &&
+           alignof(CallableType) <= alignof(Storage) &&
+           std::is_nothrow_move_constructible_v<CallableType>;
+  }
+
+  template <typename CallableType>
+  static CallableType& Get(void* storage) {
+    if constexpr (IsStoredInline<CallableType>()) {
+      return *std::launder(reinterpret_cast<CallableType*>(storage));
+    } else {
+      return **reinterpret_cast<CallableType**>(storage);
+    }
+  }
+
+  template <typename CallableType>
+  static constexpr Operations kOperations = {
+      [](void* storage) { Get<CallableType>(storage)(); },
+      [](void* source, void* destination) noexcept {
+        if constexpr (IsStoredInline<CallableType>()) {
+          auto& callable = Get<CallableType>(source);
+          new (destination) CallableType(std::move(callable));
+          callable.~CallableType();
+        } else {
+          *reinterpret_cast<CallableType**>(destination) =
+              *reinterpret_cast<CallableType**>(source);
+        }
+      },
+      [](void* storage) noexcept {
+        if constexpr (IsStoredInline<CallableType>()) {
+          Get<CallableType>(storage).~CallableType();
+        } else {
+          delete *reinterpret_cast<CallableType**>(storage);
+        }
+      }};
+
+  /// Operations of the held callable, null if empty.
+  const Operations* operations_;
+  /// Inline storage of the callable, or a pointer to it if it does not fit.
+  Storage storage_;
+};
+}  // namespace google::scp::core
@@ -14,22 +14,27 @@
 
 #include "single_thread_async_executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <functional>
 #include <memory>
 #include <thread>
 
+#include "core/common/time_provider/src/time_provider.h"
+
 #include "async_executor_utils.h"
 #include "error_codes.h"
 #include "typedef.h"
 
-using google::scp::core::common::ConcurrentQueue;
+using google::scp::core::common::TimeProvider;
 using std::atomic;
 using std::make_shared;
 using std::make_unique;
+using std::memory_order_relaxed;
+using std::min;
+using std::move;
 using std::mutex;
-using std::shared_ptr;
 using std::thread;
 using std::unique_lock;
 using std::chrono::milliseconds;
@@ -42,10 +47,27 @@ ExecutionResult SingleThreadAsyncExecutor::Init() noexcept {
     return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_INVALID_QUEUE_CAP);
   }
 
-  normal_pri_queue_ =
-      make_shared<ConcurrentQueue<shared_ptr<AsyncTask>>>(queue_cap_);
-  high_pri_queue_ =
-      make_shared<ConcurrentQueue<shared_ptr<AsyncTask>>>(queue_cap_);
+  if (task_queue_type_ != TaskQueueType::ConcurrentQueue &&
+      task_queue_type_ != TaskQueueType::RingBuffer) {
+    return FailureExecutionResult(
+        errors::SC_ASYNC_EXECUTOR_INVALID_TASK_QUEUE_TYPE);
+  }
+
+  if (task_queue_type_ == TaskQueueType::RingBuffer &&
+      queue_cap_ > kMaxRingBufferQueueCap) {
+    return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_INVALID_QUEUE_CAP);
+  }
+
+  // Each task is on one of the queues or executing, so the pool never needs
+  // to grow past what the queues can hold.
+  task_pool_ = make_unique<AsyncTaskPool>(
+      min(3 * static_cast<size_t>(queue_cap_) + 1, kAsyncTaskPoolMaxSize));
+  normal_pri_queue_ = make_shared<TaskQueue>(task_queue_type_, queue_cap_);
+  high_pri_queue_ = make_shared<TaskQueue>(task_queue_type_, queue_cap_);
+  // Affinitized tasks are only queued separately for work stealing, which
+  // needs a multi-consumer queue.
+  affinitized_queue_ =
+      make_shared<TaskQueue>(TaskQueueType::ConcurrentQueue, queue_cap_);
   return SuccessExecutionResult();
 };
 
@@ -54,7 +76,7 @@ ExecutionResult SingleThreadAsyncExecutor::Run() noexcept {
     return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_ALREADY_RUNNING);
   }
 
-  if (!normal_pri_queue_ || !high_pri_queue_) {
+  if (!normal_pri_queue_ || !high_pri_queue_ || !affinitized_queue_) {
     return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_NOT_INITIALIZED);
   }
 
@@ -67,7 +89,11 @@ ExecutionResult SingleThreadAsyncExecutor::Run() noexcept {
           AsyncExecutorUtils::SetAffinity(*affinity_cpu_number);
         }
         ptr->worker_thread_started_ = true;
-        ptr->StartWorker();
+        if (ptr->task_queue_type_ == TaskQueueType::RingBuffer) {
+          ptr->StartRingBufferWorker();
+        } else {
+          ptr->StartWorker();
+        }
         ptr->worker_thread_stopped_ = true;
       },
       this);
@@ -79,51 +105,95 @@ ExecutionResult SingleThreadAsyncExecutor::Run() noexcept {
 
 void SingleThreadAsyncExecutor::StartWorker() noexcept {
   unique_lock<mutex> thread_lock(mutex_);
+  // Set while the last steal attempt succeeded, i.e. the siblings are likely
+  // to still be backed up.
+  bool keep_stealing = false;
 
   while (true) {
     condition_variable_.wait_for(
         thread_lock, milliseconds(kLockWaitTimeInMilliseconds), [&]() {
-          return !is_running_ || high_pri_queue_->Size() > 0 ||
-                 normal_pri_queue_->Size() > 0;
+          return !is_running_ || keep_stealing || GetPendingTaskCount() > 0 ||
+                 work_stealing_requested_.load(memory_order_relaxed);
         });
+    work_stealing_requested_.store(false, memory_order_relaxed);
 
-    if (normal_pri_queue_->Size() == 0 && high_pri_queue_->Size() == 0) {
+    PooledAsyncTask task;
+    if (!TryDequeueOwnTask(task)) {
       if (!is_running_) {
         break;
       }
-      continue;
+      // Our own queues are drained, help the siblings if possible.
+      keep_stealing = work_stealing_callback_ && work_stealing_callback_(task);
+      if (!keep_stealing) {
+        continue;
+      }
+    }
+
+    thread_lock.unlock();
+    if (work_stealing_callback_) {
+      last_task_start_timestamp_.store(
+          TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks(),
+          memory_order_relaxed);
+    }
+    is_executing_task_.store(true, memory_order_relaxed);
+    task->Execute();
+    is_executing_task_.store(false, memory_order_relaxed);
+    thread_lock.lock();
+  }
+}
+
+void SingleThreadAsyncExecutor::StartRingBufferWorker() noexcept {
+  auto has_work = [this]() {
+    return !is_running_.load(memory_order_relaxed) ||
+           GetPendingTaskCount() > 0;
+  };
+
+  while (true) {
+    // The ring buffers only allow this thread to dequeue, so the pending tasks
+    // are dropped here rather than in Stop().
+    if (!is_running_ && drop_tasks_on_stop_) {
+      PooledAsyncTask task;
+      while (TryDequeueOwnTask(task)) {}
+      break;
     }
 
-    shared_ptr<AsyncTask> task;
-    // The priority is with the high pri tasks.
-    if (!high_pri_queue_->TryDequeue(task).Successful() &&
-        !normal_pri_queue_->TryDequeue(task).Successful()) {
+    PooledAsyncTask task;
+    if (!TryDequeueOwnTask(task)) {
+      if (!is_running_ && GetPendingTaskCount() == 0) {
+        break;
+      }
+      parker_.Park(has_work, kRingBufferWorkerSpinCount,
+                   milliseconds(kLockWaitTimeInMilliseconds));
       continue;
     }
 
-    thread_lock.unlock();
+    is_executing_task_.store(true, memory_order_relaxed);
     task->Execute();
-    thread_lock.lock();
+    is_executing_task_.store(false, memory_order_relaxed);
   }
 }
 
+bool SingleThreadAsyncExecutor::TryDequeueOwnTask(
+    PooledAsyncTask& task) noexcept {
+  // The priority is with the high pri tasks, then the affinitized tasks since
+  // they are continuations of work which already ran on this executor.
+  return high_pri_queue_->TryDequeue(task).Successful() ||
+         affinitized_queue_->TryDequeue(task).Successful() ||
+         normal_pri_queue_->TryDequeue(task).Successful();
+}
+
 ExecutionResult SingleThreadAsyncExecutor::Stop() noexcept {
   if (!is_running_) {
     return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_NOT_RUNNING);
   }
 
-  unique_lock<mutex> thread_lock(mutex_);
-  is_running_ = false;
-
-  if (drop_tasks_on_stop_) {
-    shared_ptr<AsyncTask> task;
-    while (normal_pri_queue_->TryDequeue(task).Successful()) {}
-    while (high_pri_queue_->TryDequeue(task).Successful()) {}
+  if (task_queue_type_ == TaskQueueType::RingBuffer) {
+    is_running_ = false;
+    parker_.Unpark();
+  } else {
+    StopWorker();
   }
 
-  condition_variable_.notify_all();
-  thread_lock.unlock();
-
   // To ensure stop can happen cleanly, it is required to wait for the thread to
   // start and exit gracefully. If stop happens before the starting the thread,
   // there is a chance that Stop returns successful but the thread has not been
@@ -135,8 +205,34 @@ ExecutionResult SingleThreadAsyncExecutor::Stop() noexcept {
   return SuccessExecutionResult();
 };
 
+void SingleThreadAsyncExecutor::StopWorker() noexcept {
+  unique_lock<mutex> thread_lock(mutex_);
+  is_running_ = false;
+
+  if (drop_tasks_on_stop_) {
+    PooledAsyncTask task;
+    while (normal_pri_queue_->TryDequeue(task).Successful()) {}
+    while (high_pri_queue_->TryDequeue(task).Successful()) {}
+    while (affinitized_queue_->TryDequeue(task).Successful()) {}
+  }
+
+  condition_variable_.notify_all();
+}
+
 ExecutionResult SingleThreadAsyncExecutor::Schedule(
     const AsyncOperation& work, AsyncPriority priority) noexcept {
+  return Schedule(work, priority, AsyncExecutorAffinitySetting::NonAffinitized);
+}
+
+ExecutionResult SingleThreadAsyncExecutor::Schedule(
+    const AsyncOperation& work, AsyncPriority priority,
+    AsyncExecutorAffinitySetting affinity) noexcept {
+  return ScheduleOperation(InlineAsyncOperation(work), priority, affinity);
+}
+
+ExecutionResult SingleThreadAsyncExecutor::ScheduleOperation(
+    InlineAsyncOperation&& work, AsyncPriority priority,
+    AsyncExecutorAffinitySetting affinity) noexcept {
   if (!is_running_) {
     return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_NOT_RUNNING);
   }
@@ -146,22 +242,77 @@ ExecutionResult SingleThreadAsyncExecutor::Schedule(
         errors::SC_ASYNC_EXECUTOR_INVALID_PRIORITY_TYPE);
   }
 
-  auto task = make_shared<AsyncTask>(work);
+  auto task = task_pool_->Acquire(move(work));
   ExecutionResult execution_result;
-  if (priority == AsyncPriority::Normal) {
-    execution_result = normal_pri_queue_->TryEnqueue(task);
+  if (work_stealing_callback_ &&
+      affinity ==
+          AsyncExecutorAffinitySetting::AffinitizedToCallingAsyncExecutor &&
+      std::this_thread::get_id() == working_thread_id_) {
+    execution_result = affinitized_queue_->TryEnqueue(move(task));
+  } else if (priority == AsyncPriority::Normal) {
+    execution_result = normal_pri_queue_->TryEnqueue(move(task));
   } else {
-    execution_result = high_pri_queue_->TryEnqueue(task);
+    execution_result = high_pri_queue_->TryEnqueue(move(task));
   }
 
   if (!execution_result.Successful()) {
     return RetryExecutionResult(errors::SC_ASYNC_EXECUTOR_EXCEEDING_QUEUE_CAP);
   }
 
-  condition_variable_.notify_one();
+  if (task_queue_type_ == TaskQueueType::RingBuffer) {
+    parker_.Unpark();
+  } else {
+    condition_variable_.notify_one();
+  }
   return SuccessExecutionResult();
 };
 
+void SingleThreadAsyncExecutor::SetWorkStealingCallback(
+    const WorkStealingCallback& work_stealing_callback) noexcept {
+  work_stealing_callback_ = work_stealing_callback;
+}
+
+bool SingleThreadAsyncExecutor::TryStealTask(
+    PooledAsyncTask& task) noexcept {
+  if (task_queue_type_ == TaskQueueType::RingBuffer) {
+    return false;
+  }
+
+  if (high_pri_queue_->TryDequeue(task).Successful() ||
+      normal_pri_queue_->TryDequeue(task).Successful()) {
+    return true;
+  }
+
+  // Affinitized tasks stay with their executor unless it is stuck on a long
+  // running task.
+  if (affinitized_queue_->Size() == 0 ||
+      !is_executing_task_.load(memory_order_relaxed)) {
+    return false;
+  }
+  auto busy_duration =
+      TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks() -
+      last_task_start_timestamp_.load(memory_order_relaxed);
+  if (busy_duration <
+      static_cast<Timestamp>(kWorkStealingStarvationThreshold.count())) {
+    return false;
+  }
+  return affinitized_queue_->TryDequeue(task).Successful();
+}
+
+void SingleThreadAsyncExecutor::RequestWorkStealing() noexcept {
+  work_stealing_requested_.store(true, memory_order_relaxed);
+  condition_variable_.notify_one();
+}
+
+bool SingleThreadAsyncExecutor::IsExecutingTask() const noexcept {
+  return is_executing_task_.load(memory_order_relaxed);
+}
+
+size_t SingleThreadAsyncExecutor::GetPendingTaskCount() const noexcept {
+  return high_pri_queue_->Size() + affinitized_queue_->Size() +
+         normal_pri_queue_->Size();
+}
+
 ExecutionResultOr<thread::id> SingleThreadAsyncExecutor::GetThreadId() const {
   if (!is_running_.load()) {
     return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_NOT_RUNNING);
@@ -16,14 +16,17 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
 
-#include "core/common/concurrent_queue/src/concurrent_queue.h"
 #include "core/interface/async_executor_interface.h"
 
 #include "async_task.h"
+#include "async_task_pool.h"
+#include "task_queue.h"
+#include "worker_parker.h"
 
 namespace google::scp::core {
 /**
@@ -32,15 +35,37 @@ namespace google::scp::core {
  */
 class SingleThreadAsyncExecutor : ServiceInterface {
  public:
+  /**
+   * @brief Invoked by the worker thread once its own queues are empty to steal
+   * a task from one of its siblings. Returns true if a task was stolen.
+   */
+  using WorkStealingCallback = std::function<bool(PooledAsyncTask&)>;
+
+  /**
+   * @brief Construct a new Single Thread Async Executor object.
+   *
+   * @param queue_cap the maximum size of each work queue.
+   * @param drop_tasks_on_stop indicates whether the executor should wait on
+   * the tasks during the stop operation.
+   * @param affinity_cpu_number an optional CPU to have an affinity for.
+   * @param task_queue_type indicates the data structure the tasks are queued
+   * in. RingBuffer queues are allocated upfront, so queue_cap is limited to
+   * kMaxRingBufferQueueCap.
+   */
   explicit SingleThreadAsyncExecutor(
       size_t queue_cap, bool drop_tasks_on_stop = false,
-      std::optional<size_t> affinity_cpu_number = std::nullopt)
+      std::optional<size_t> affinity_cpu_number = std::nullopt,
+      TaskQueueType task_queue_type = TaskQueueType::ConcurrentQueue)
       : is_running_(false),
         worker_thread_started_(false),
         worker_thread_stopped_(false),
         queue_cap_(queue_cap),
         drop_tasks_on_stop_(drop_tasks_on_stop),
-        affinity_cpu_number_(affinity_cpu_number) {}
+        affinity_cpu_number_(affinity_cpu_number),
+        task_queue_type_(task_queue_type),
+        is_executing_task_(false),
+        work_stealing_requested_(false),
+        last_task_start_timestamp_(0) {}
 
   ExecutionResult Init() noexcept override;
 
@@ -58,6 +83,64 @@ class SingleThreadAsyncExecutor : ServiceInterface {
   ExecutionResult Schedule(const AsyncOperation& work,
                            AsyncPriority priority) noexcept;
 
+  /**
+   * @brief Same as above but with the given affinity setting. When work
+   * stealing is enabled, affinitized tasks scheduled from the worker thread of
+   * this executor are kept on a separate queue which siblings only steal from
+   * once the worker is starved, i.e. it has not started a task for
+   * kWorkStealingStarvationThreshold.
+   * @param affinity the affinity with which to schedule the work.
+   */
+  ExecutionResult Schedule(const AsyncOperation& work, AsyncPriority priority,
+                           AsyncExecutorAffinitySetting affinity) noexcept;
+
+  /**
+   * @brief Same as above, but takes the operation of the task as is, so a
+   * callable it was built from directly is not copied through an
+   * AsyncOperation.
+   */
+  ExecutionResult ScheduleOperation(
+      InlineAsyncOperation&& work, AsyncPriority priority,
+      AsyncExecutorAffinitySetting affinity) noexcept;
+
+  /**
+   * @brief Enables work stealing on this executor. Must be called before Run().
+   * Once enabled, the worker thread uses the callback to pull work from its
+   * siblings whenever its own queues are empty. Not supported with RingBuffer
+   * task queues, which only allow the worker thread to dequeue.
+   *
+   * @param work_stealing_callback the callback to steal tasks with.
+   */
+  void SetWorkStealingCallback(
+      const WorkStealingCallback& work_stealing_callback) noexcept;
+
+  /**
+   * @brief Tries to steal a pending task from this executor on behalf of a
+   * sibling. High priority tasks are stolen first, affinitized tasks are only
+   * stolen if this executor is starved. Always fails with RingBuffer task
+   * queues.
+   *
+   * @param task the stolen task, if any.
+   * @return true if a task was stolen.
+   */
+  bool TryStealTask(PooledAsyncTask& task) noexcept;
+
+  /**
+   * @brief Asks the worker thread to wake up and look for work on its
+   * siblings. Used when the caller knows a sibling is backed up.
+   */
+  void RequestWorkStealing() noexcept;
+
+  /**
+   * @brief Returns true if the worker thread is currently executing a task.
+   */
+  bool IsExecutingTask() const noexcept;
+
+  /**
+   * @brief Returns the approximate number of tasks waiting on the queues.
+   */
+  size_t GetPendingTaskCount() const noexcept;
+
   /**
    * @brief Returns the ID of the spawned thread object to enable looking it up
    * via thread IDs later. Will only be populated after Run() is called.
@@ -68,6 +151,23 @@ class SingleThreadAsyncExecutor : ServiceInterface {
   /// Starts the internal worker thread.
   void StartWorker() noexcept;
 
+  /**
+   * @brief Worker loop for RingBuffer task queues. The worker spins on its
+   * queues for a while once they are empty and then parks on parker_.
+   */
+  void StartRingBufferWorker() noexcept;
+
+  /// Stops the worker of ConcurrentQueue executors.
+  void StopWorker() noexcept;
+
+  /**
+   * @brief Dequeues the next task from the queues owned by this executor.
+   *
+   * @param task the dequeued task, if any.
+   * @return true if a task was dequeued.
+   */
+  bool TryDequeueOwnTask(PooledAsyncTask& task) noexcept;
+
   /**
    * @brief While it is true, the running thread will keep listening and
    * picking out work from work queue. While it is false, the thread will try to
@@ -84,12 +184,30 @@ class SingleThreadAsyncExecutor : ServiceInterface {
   bool drop_tasks_on_stop_;
   /// An optional CPU to have an affinity for.
   std::optional<size_t> affinity_cpu_number_;
+  /// The data structure the tasks are queued in.
+  TaskQueueType task_queue_type_;
+  /**
+   * @brief Pool the tasks are allocated from. Declared ahead of the queues so
+   * that it outlives the tasks still pending on them.
+   */
+  std::unique_ptr<AsyncTaskPool> task_pool_;
   /// Queue for accepting the incoming normal priority tasks.
-  std::shared_ptr<common::ConcurrentQueue<std::shared_ptr<AsyncTask>>>
-      normal_pri_queue_;
+  std::shared_ptr<TaskQueue> normal_pri_queue_;
   /// Queue for accepting the incoming high priority tasks.
-  std::shared_ptr<common::ConcurrentQueue<std::shared_ptr<AsyncTask>>>
-      high_pri_queue_;
+  std::shared_ptr<TaskQueue> high_pri_queue_;
+  /// Queue for the affinitized tasks which should stick to this executor. Only
+  /// used when work stealing is enabled.
+  std::shared_ptr<TaskQueue> affinitized_queue_;
+  /// Callback to steal work from the siblings, empty if work stealing is
+  /// disabled.
+  WorkStealingCallback work_stealing_callback_;
+  /// Indicates whether the worker thread is executing a task.
+  std::atomic<bool> is_executing_task_;
+  /// Indicates whether a sibling asked the worker to look for work to steal.
+  std::atomic<bool> work_stealing_requested_;
+  /// The time the worker thread started its last task. Only maintained when
+  /// work stealing is enabled.
+  std::atomic<Timestamp> last_task_start_timestamp_;
   /// A unique pointer to the working thread.
   std::unique_ptr<std::thread> working_thread_;
   /// The ID of the working_thread_.
@@ -104,5 +222,7 @@ class SingleThreadAsyncExecutor : ServiceInterface {
    * element is pushed to the queue.
    */
   std::condition_variable condition_variable_;
+  /// Parks the worker thread of RingBuffer executors while they are idle.
+  WorkerParker parker_;
 };
 }  // namespace google::scp::core
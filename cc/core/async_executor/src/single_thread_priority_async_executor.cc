@@ -39,6 +39,7 @@ using std::shared_ptr;
 using std::thread;
 using std::unique_lock;
 using std::vector;
+using std::weak_ptr;
 using std::chrono::milliseconds;
 using std::chrono::nanoseconds;
 
@@ -48,6 +49,13 @@ ExecutionResult SingleThreadPriorityAsyncExecutor::Init() noexcept {
     return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_INVALID_QUEUE_CAP);
   }
 
+  if (timer_queue_type_ == TimerQueueType::TimerWheel) {
+    timer_wheel_ = make_shared<TimerWheel>(
+        kTimerWheelTickDuration, kTimerWheelSlotCount,
+        TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks());
+    return SuccessExecutionResult();
+  }
+
   queue_ = make_shared<
       priority_queue<shared_ptr<AsyncTask>, vector<shared_ptr<AsyncTask>>,
                      AsyncTaskCompareGreater>>();
@@ -59,7 +67,7 @@ ExecutionResult SingleThreadPriorityAsyncExecutor::Run() noexcept {
     return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_ALREADY_RUNNING);
   }
 
-  if (!queue_) {
+  if (!queue_ && !timer_wheel_) {
     return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_NOT_INITIALIZED);
   }
 
@@ -83,6 +91,11 @@ ExecutionResult SingleThreadPriorityAsyncExecutor::Run() noexcept {
 }
 
 void SingleThreadPriorityAsyncExecutor::StartWorker() noexcept {
+  if (timer_wheel_) {
+    StartTimerWheelWorker();
+    return;
+  }
+
   unique_lock<mutex> thread_lock(mutex_);
   auto wait_timeout_duration_ns = kInfiniteWaitDurationNs;
 
@@ -132,6 +145,57 @@ void SingleThreadPriorityAsyncExecutor::StartWorker() noexcept {
   }
 }
 
+void SingleThreadPriorityAsyncExecutor::StartTimerWheelWorker() noexcept {
+  unique_lock<mutex> thread_lock(mutex_);
+  auto wait_timeout_duration_ns = kInfiniteWaitDurationNs;
+  vector<shared_ptr<AsyncTask>> expired_tasks;
+
+  while (true) {
+    condition_variable_.wait_for(thread_lock, wait_timeout_duration_ns, [&]() {
+      Timestamp current_timestamp =
+          TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks();
+
+      return !is_running_ || update_wait_time_ ||
+             current_timestamp >= next_scheduled_task_timestamp_;
+    });
+
+    if (update_wait_time_) {
+      update_wait_time_ = false;
+    }
+
+    // All the tasks expiring in the elapsed ticks are executed as one batch.
+    timer_wheel_->Advance(
+        TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks(),
+        expired_tasks);
+    if (!expired_tasks.empty()) {
+      thread_lock.unlock();
+      for (auto& task : expired_tasks) {
+        task->Execute();
+      }
+      expired_tasks.clear();
+      thread_lock.lock();
+    }
+
+    if (timer_wheel_->Size() == 0) {
+      if (!is_running_) {
+        break;
+      }
+      next_scheduled_task_timestamp_ = UINT64_MAX;
+      wait_timeout_duration_ns = kInfiniteWaitDurationNs;
+      continue;
+    }
+
+    Timestamp current_timestamp =
+        TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks();
+    next_scheduled_task_timestamp_ = timer_wheel_->GetNextExpiryTimestamp();
+    wait_timeout_duration_ns = nanoseconds(0);
+    if (current_timestamp < next_scheduled_task_timestamp_) {
+      wait_timeout_duration_ns =
+          nanoseconds(next_scheduled_task_timestamp_ - current_timestamp);
+    }
+  }
+}
+
 ExecutionResult SingleThreadPriorityAsyncExecutor::Stop() noexcept {
   if (!is_running_) {
     return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_NOT_RUNNING);
@@ -141,8 +205,12 @@ ExecutionResult SingleThreadPriorityAsyncExecutor::Stop() noexcept {
   is_running_ = false;
 
   if (drop_tasks_on_stop_) {
-    while (queue_->size() > 0) {
-      queue_->pop();
+    if (timer_wheel_) {
+      timer_wheel_->Clear();
+    } else {
+      while (queue_->size() > 0) {
+        queue_->pop();
+      }
     }
   }
 
@@ -173,6 +241,10 @@ ExecutionResult SingleThreadPriorityAsyncExecutor::ScheduleFor(
     return FailureExecutionResult(errors::SC_ASYNC_EXECUTOR_NOT_RUNNING);
   }
 
+  if (timer_wheel_) {
+    return ScheduleOnTimerWheel(work, timestamp, cancellation_callback);
+  }
+
   unique_lock<mutex> thread_lock(mutex_);
 
   if (queue_->size() >= queue_cap_) {
@@ -192,6 +264,35 @@ ExecutionResult SingleThreadPriorityAsyncExecutor::ScheduleFor(
   return SuccessExecutionResult();
 };
 
+ExecutionResult SingleThreadPriorityAsyncExecutor::ScheduleOnTimerWheel(
+    const AsyncOperation& work, Timestamp timestamp,
+    function<bool()>& cancellation_callback) noexcept {
+  unique_lock<mutex> thread_lock(mutex_);
+
+  if (timer_wheel_->Size() >= queue_cap_) {
+    return RetryExecutionResult(errors::SC_ASYNC_EXECUTOR_EXCEEDING_QUEUE_CAP);
+  }
+
+  auto entry = timer_wheel_->Insert(
+      work, timestamp,
+      TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks());
+  // Cancelling removes the task from the wheel right away. Neither the wheel
+  // nor the task are kept alive by the callback.
+  cancellation_callback = [timer_wheel = weak_ptr<TimerWheel>(timer_wheel_),
+                           entry]() {
+    auto timer_wheel_ptr = timer_wheel.lock();
+    return timer_wheel_ptr && timer_wheel_ptr->Cancel(entry);
+  };
+
+  if (timestamp < next_scheduled_task_timestamp_.load()) {
+    next_scheduled_task_timestamp_ = timestamp;
+    update_wait_time_ = true;
+  }
+
+  condition_variable_.notify_one();
+  return SuccessExecutionResult();
+}
+
 ExecutionResultOr<thread::id> SingleThreadPriorityAsyncExecutor::GetThreadId()
     const {
   if (!is_running_.load()) {
@@ -25,8 +25,28 @@
 #include "core/interface/async_executor_interface.h"
 
 #include "async_task.h"
+#include "timer_wheel.h"
 
 namespace google::scp::core {
+/**
+ * @brief The data structure keeping the delayed tasks of a priority executor.
+ */
+enum class TimerQueueType {
+  /**
+   * @brief A binary heap ordered by execution time. Tasks are executed in the
+   * exact order of their timestamps, cancelled tasks are only released once
+   * they reach the top of the heap.
+   */
+  PriorityQueue = 0,
+  /**
+   * @brief A hashed timing wheel with kTimerWheelTickDuration ticks. Scheduling
+   * and cancellation are O(1) and cancelled tasks are released immediately, but
+   * tasks expiring within the same tick are executed in scheduling order. Best
+   * suited for large numbers of pending timers.
+   */
+  TimerWheel = 1
+};
+
 /**
  * @brief A single threaded priority async executor. This executor will have one
  * thread working with one priority queue.
@@ -35,7 +55,8 @@ class SingleThreadPriorityAsyncExecutor : ServiceInterface {
  public:
   explicit SingleThreadPriorityAsyncExecutor(
       size_t queue_cap, bool drop_tasks_on_stop = false,
-      std::optional<size_t> affinity_cpu_number = std::nullopt)
+      std::optional<size_t> affinity_cpu_number = std::nullopt,
+      TimerQueueType timer_queue_type = TimerQueueType::PriorityQueue)
       : is_running_(false),
         worker_thread_started_(false),
         worker_thread_stopped_(false),
@@ -43,7 +64,8 @@ class SingleThreadPriorityAsyncExecutor : ServiceInterface {
         next_scheduled_task_timestamp_(UINT64_MAX),
         queue_cap_(queue_cap),
         drop_tasks_on_stop_(drop_tasks_on_stop),
-        affinity_cpu_number_(affinity_cpu_number) {}
+        affinity_cpu_number_(affinity_cpu_number),
+        timer_queue_type_(timer_queue_type) {}
 
   ExecutionResult Init() noexcept override;
 
@@ -85,6 +107,14 @@ class SingleThreadPriorityAsyncExecutor : ServiceInterface {
   /// Starts the internal worker thread.
   void StartWorker() noexcept;
 
+  /// Starts the internal worker thread of the timer wheel backend.
+  void StartTimerWheelWorker() noexcept;
+
+  /// Schedules the task on the timer wheel backend.
+  ExecutionResult ScheduleOnTimerWheel(
+      const AsyncOperation& work, Timestamp timestamp,
+      std::function<bool()>& cancellation_callback) noexcept;
+
   /**
    * @brief While it is true, the running thread will keep listening and
    * picking out work from work queue. While it is false, the thread will try to
@@ -108,6 +138,8 @@ class SingleThreadPriorityAsyncExecutor : ServiceInterface {
   bool drop_tasks_on_stop_;
   /// An optional CPU to have an affinity for.
   std::optional<size_t> affinity_cpu_number_;
+  /// The data structure to keep the tasks in.
+  TimerQueueType timer_queue_type_;
   /// A unique pointer to the working thread.
   std::unique_ptr<std::thread> working_thread_;
   /// The ID of the working_thread_.
@@ -117,6 +149,9 @@ class SingleThreadPriorityAsyncExecutor : ServiceInterface {
                                       std::vector<std::shared_ptr<AsyncTask>>,
                                       AsyncTaskCompareGreater>>
       queue_;
+  /// Timer wheel for the incoming tasks, used instead of queue_ with the timer
+  /// wheel backend.
+  std::shared_ptr<TimerWheel> timer_wheel_;
   /**
    * @brief Used in combination with the condition variable for signaling the
    * thread that an element is pushed to the queue.
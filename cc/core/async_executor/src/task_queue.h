@@ -0,0 +1,80 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <utility>
+
+#include "core/common/concurrent_queue/src/concurrent_queue.h"
+#include "core/common/concurrent_queue/src/mpsc_ring_queue.h"
+
+#include "async_task_pool.h"
+
+namespace google::scp::core {
+/**
+ * @brief The data structure the tasks of a SingleThreadAsyncExecutor are
+ * queued in.
+ */
+enum class TaskQueueType {
+  /**
+   * @brief TBB based concurrent queue, the worker waits on a condition
+   * variable which producers notify on every task.
+   */
+  ConcurrentQueue = 0,
+  /**
+   * @brief Preallocated lock-free MPSC ring buffer, the worker spins and then
+   * parks on a futex which producers only signal while it is parked. Since the
+   * queue has a single consumer, it cannot be combined with work stealing.
+   */
+  RingBuffer = 1
+};
+
+/// A queue of tasks backed by the data structure of the given type.
+class TaskQueue {
+ public:
+  TaskQueue(TaskQueueType type, size_t queue_cap) {
+    if (type == TaskQueueType::RingBuffer) {
+      ring_queue_ =
+          std::make_unique<common::MpscRingQueue<PooledAsyncTask>>(queue_cap);
+    } else {
+      concurrent_queue_ =
+          std::make_unique<common::ConcurrentQueue<PooledAsyncTask>>(queue_cap);
+    }
+  }
+
+  ExecutionResult TryEnqueue(PooledAsyncTask&& task) noexcept {
+    return ring_queue_ ? ring_queue_->TryEnqueue(std::move(task))
+                       : concurrent_queue_->TryEnqueue(std::move(task));
+  }
+
+  /// Must only be called from one thread at a time with RingBuffer queues.
+  ExecutionResult TryDequeue(PooledAsyncTask& task) noexcept {
+    return ring_queue_ ? ring_queue_->TryDequeue(task)
+                       : concurrent_queue_->TryDequeue(task);
+  }
+
+  size_t Size() noexcept {
+    return ring_queue_ ? ring_queue_->Size() : concurrent_queue_->Size();
+  }
+
+ private:
+  /// Set for ConcurrentQueue queues.
+  std::unique_ptr<common::ConcurrentQueue<PooledAsyncTask>> concurrent_queue_;
+  /// Set for RingBuffer queues.
+  std::unique_ptr<common::MpscRingQueue<PooledAsyncTask>> ring_queue_;
+};
+}  // namespace google::scp::core
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "timer_wheel.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using std::lock_guard;
+using std::max;
+using std::min;
+using std::mutex;
+using std::shared_ptr;
+using std::vector;
+using std::weak_ptr;
+using std::chrono::nanoseconds;
+
+namespace {
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+}  // namespace
+
+namespace google::scp::core {
+TimerWheel::TimerWheel(nanoseconds tick_duration, size_t slot_count,
+                       Timestamp start_timestamp)
+    : tick_duration_ns_(max<Timestamp>(tick_duration.count(), 1)),
+      slot_mask_(RoundUpToPowerOfTwo(max<size_t>(slot_count, 1)) - 1),
+      current_tick_(start_timestamp / tick_duration_ns_),
+      slots_(slot_mask_ + 1, nullptr),
+      ready_list_(nullptr),
+      size_(0) {}
+
+TimerWheel::~TimerWheel() {
+  Clear();
+}
+
+void TimerWheel::Link(const shared_ptr<TimerWheelEntry>& entry,
+                      TimerWheelEntry*& list_head) noexcept {
+  entry->self = entry;
+  entry->list_head = &list_head;
+  entry->previous = nullptr;
+  entry->next = list_head;
+  if (list_head) {
+    list_head->previous = entry.get();
+  }
+  list_head = entry.get();
+  size_++;
+}
+
+void TimerWheel::Unlink(TimerWheelEntry* entry) noexcept {
+  if (entry->previous) {
+    entry->previous->next = entry->next;
+  } else {
+    *entry->list_head = entry->next;
+  }
+  if (entry->next) {
+    entry->next->previous = entry->previous;
+  }
+  entry->previous = nullptr;
+  entry->next = nullptr;
+  entry->list_head = nullptr;
+  size_--;
+  // Must be last, this may release the entry.
+  entry->self.reset();
+}
+
+void TimerWheel::UnlinkAll(TimerWheelEntry*& list_head) noexcept {
+  while (list_head) {
+    Unlink(list_head);
+  }
+}
+
+weak_ptr<TimerWheelEntry> TimerWheel::Insert(
+    const AsyncOperation& work, Timestamp execution_timestamp,
+    Timestamp current_timestamp) noexcept {
+  // Not allocated with make_shared so that the weak references held by the
+  // cancellation callbacks do not pin the memory of the entry.
+  shared_ptr<TimerWheelEntry> entry(
+      new TimerWheelEntry(work, execution_timestamp));
+  // Round up so that a task never expires before its timestamp.
+  entry->deadline_tick =
+      execution_timestamp / tick_duration_ns_ +
+      (execution_timestamp % tick_duration_ns_ == 0 ? 0 : 1);
+
+  lock_guard lock(mutex_);
+  if (execution_timestamp <= current_timestamp ||
+      entry->deadline_tick <= current_tick_) {
+    Link(entry, ready_list_);
+  } else {
+    Link(entry, slots_[entry->deadline_tick & slot_mask_]);
+  }
+  return entry;
+}
+
+bool TimerWheel::Cancel(const weak_ptr<TimerWheelEntry>& entry) noexcept {
+  lock_guard lock(mutex_);
+  auto scheduled_entry = entry.lock();
+  if (!scheduled_entry || !scheduled_entry->list_head) {
+    return false;
+  }
+  Unlink(scheduled_entry.get());
+  return scheduled_entry->task.Cancel();
+}
+
+void TimerWheel::ExpireList(TimerWheelEntry*& list_head, Timestamp tick,
+                            vector<shared_ptr<AsyncTask>>& expired_tasks) {
+  auto* entry = list_head;
+  while (entry) {
+    auto* next = entry->next;
+    if (entry->deadline_tick <= tick) {
+      // Shares the ownership of the entry.
+      expired_tasks.emplace_back(entry->self, &entry->task);
+      Unlink(entry);
+    }
+    entry = next;
+  }
+}
+
+void TimerWheel::Advance(
+    Timestamp current_timestamp,
+    vector<shared_ptr<AsyncTask>>& expired_tasks) noexcept {
+  lock_guard lock(mutex_);
+  ExpireList(ready_list_, UINT64_MAX, expired_tasks);
+
+  auto current_tick = current_timestamp / tick_duration_ns_;
+  if (current_tick <= current_tick_) {
+    return;
+  }
+  // If more than a revolution has passed, every slot is visited once.
+  auto ticks_to_process = min<Timestamp>(current_tick - current_tick_,
+                                         static_cast<Timestamp>(slots_.size()));
+  for (Timestamp i = 1; i <= ticks_to_process; ++i) {
+    auto& slot = slots_[(current_tick_ + i) & slot_mask_];
+    if (slot) {
+      ExpireList(slot, current_tick, expired_tasks);
+    }
+  }
+  current_tick_ = current_tick;
+}
+
+Timestamp TimerWheel::GetNextExpiryTimestamp() noexcept {
+  lock_guard lock(mutex_);
+  if (ready_list_) {
+    return 0;
+  }
+  if (size_ == 0) {
+    return UINT64_MAX;
+  }
+  for (Timestamp tick = current_tick_ + 1;
+       tick <= current_tick_ + slots_.size(); ++tick) {
+    if (slots_[tick & slot_mask_]) {
+      return tick * tick_duration_ns_;
+    }
+  }
+  return (current_tick_ + slots_.size()) * tick_duration_ns_;
+}
+
+size_t TimerWheel::Size() noexcept {
+  lock_guard lock(mutex_);
+  return size_;
+}
+
+void TimerWheel::Clear() noexcept {
+  lock_guard lock(mutex_);
+  for (auto& slot : slots_) {
+    UnlinkAll(slot);
+  }
+  UnlinkAll(ready_list_);
+}
+}  // namespace google::scp::core
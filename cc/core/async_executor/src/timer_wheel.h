@@ -0,0 +1,157 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "core/interface/type_def.h"
+
+#include "async_task.h"
+
+namespace google::scp::core {
+/**
+ * @brief A task pending on the timer wheel. Entries are linked intrusively into
+ * the slots of the wheel and keep themselves alive while linked. Cancellation
+ * callbacks only hold weak references to them so that cancelled and expired
+ * tasks are released right away.
+ */
+struct TimerWheelEntry {
+  TimerWheelEntry(const AsyncOperation& work, Timestamp execution_timestamp)
+      : task(work, execution_timestamp) {}
+
+  /// The task to be executed once the entry expires.
+  AsyncTask task;
+  /// The tick at, or after, which the task is due.
+  Timestamp deadline_tick = 0;
+  /// Previous entry in the same list.
+  TimerWheelEntry* previous = nullptr;
+  /// Next entry in the same list.
+  TimerWheelEntry* next = nullptr;
+  /// The head of the list holding the entry, null if the entry is unlinked.
+  TimerWheelEntry** list_head = nullptr;
+  /// Owning reference held by the wheel while the entry is linked.
+  std::shared_ptr<TimerWheelEntry> self;
+};
+
+/**
+ * @brief A hashed timing wheel of delayed tasks. Time is divided in coarse
+ * ticks and each tick is hashed to one of the slots of the wheel. Scheduling
+ * and cancelling a task are O(1), and all the tasks expiring in the same tick
+ * are handed out as a single batch. Tasks further than a full revolution ahead
+ * share slots with nearer ones and are skipped until their tick arrives.
+ *
+ * The wheel is thread-safe.
+ */
+class TimerWheel {
+ public:
+  /**
+   * @brief Construct a new Timer Wheel object.
+   *
+   * @param tick_duration the granularity of the wheel. Tasks never expire
+   * before their timestamp but may expire up to one tick after it.
+   * @param slot_count the number of slots on the wheel. Rounded up to a power
+   * of two.
+   * @param start_timestamp the steady clock timestamp of the first tick.
+   */
+  TimerWheel(std::chrono::nanoseconds tick_duration, size_t slot_count,
+             Timestamp start_timestamp);
+
+  ~TimerWheel();
+
+  /**
+   * @brief Adds a task to the wheel. Tasks that are already due are put on
+   * the ready list and expire on the next call to Advance().
+   *
+   * @param work the work to be executed.
+   * @param execution_timestamp the timestamp the work is due at.
+   * @param current_timestamp the current steady clock timestamp.
+   * @return std::weak_ptr<TimerWheelEntry> a handle to cancel the task with.
+   */
+  std::weak_ptr<TimerWheelEntry> Insert(const AsyncOperation& work,
+                                        Timestamp execution_timestamp,
+                                        Timestamp current_timestamp) noexcept;
+
+  /**
+   * @brief Removes the task from the wheel and marks it as cancelled. The task
+   * is released immediately.
+   *
+   * @param entry the handle returned by Insert().
+   * @return true if the task was pending and is now cancelled.
+   */
+  bool Cancel(const std::weak_ptr<TimerWheelEntry>& entry) noexcept;
+
+  /**
+   * @brief Moves the clock of the wheel forward and collects all the tasks
+   * that expired up to the given timestamp.
+   *
+   * @param current_timestamp the current steady clock timestamp.
+   * @param expired_tasks the expired tasks are appended here. They keep their
+   * entries alive until they are released.
+   */
+  void Advance(Timestamp current_timestamp,
+               std::vector<std::shared_ptr<AsyncTask>>& expired_tasks) noexcept;
+
+  /**
+   * @brief Returns the earliest timestamp at which Advance() may yield a task,
+   * UINT64_MAX if the wheel is empty. This is a lower bound, the slot it
+   * points to may only hold tasks of later revolutions.
+   */
+  Timestamp GetNextExpiryTimestamp() noexcept;
+
+  /// Returns the number of pending tasks on the wheel.
+  size_t Size() noexcept;
+
+  /// Drops all the pending tasks.
+  void Clear() noexcept;
+
+ private:
+  /// Links the entry at the front of the list.
+  void Link(const std::shared_ptr<TimerWheelEntry>& entry,
+            TimerWheelEntry*& list_head) noexcept;
+
+  /**
+   * @brief Unlinks the entry from its list and drops the reference of the wheel
+   * to it. The entry is released unless the caller holds a reference.
+   */
+  void Unlink(TimerWheelEntry* entry) noexcept;
+
+  /// Unlinks all the entries of the list.
+  void UnlinkAll(TimerWheelEntry*& list_head) noexcept;
+
+  /// Moves the entries of the list which are due at tick to expired_tasks.
+  void ExpireList(TimerWheelEntry*& list_head, Timestamp tick,
+                  std::vector<std::shared_ptr<AsyncTask>>& expired_tasks);
+
+  /// The duration of a tick in nanoseconds.
+  const Timestamp tick_duration_ns_;
+  /// Mask to map a tick to its slot.
+  const size_t slot_mask_;
+  /// The last tick which was processed.
+  Timestamp current_tick_;
+  /// The heads of the entry lists of the slots of the wheel.
+  std::vector<TimerWheelEntry*> slots_;
+  /// Tasks which were already due when scheduled.
+  TimerWheelEntry* ready_list_;
+  /// Number of pending entries.
+  size_t size_;
+  /// Protects the wheel.
+  std::mutex mutex_;
+};
+}  // namespace google::scp::core
@@ -30,4 +30,24 @@ static const size_t kSleepDurationMs = 10;
 static constexpr std::chrono::nanoseconds kInfiniteWaitDurationNs =
     std::chrono::duration_cast<std::chrono::nanoseconds>(
         std::chrono::hours(87600));  // 10 years
+/// The tick duration of the timer wheels of the priority executors.
+static constexpr std::chrono::nanoseconds kTimerWheelTickDuration =
+    std::chrono::milliseconds(1);
+/// The number of slots on the timer wheels of the priority executors.
+static constexpr size_t kTimerWheelSlotCount = 4096;
+/// The maximum queue cap of executors using ring buffer task queues, which
+/// are allocated upfront.
+static constexpr size_t kMaxRingBufferQueueCap = 1 << 24;
+/// The number of times a ring buffer worker polls its queues before parking.
+static constexpr size_t kRingBufferWorkerSpinCount = 64;
+/// The number of task nodes allocated at once by the task pools.
+static constexpr size_t kAsyncTaskPoolSlabSize = 256;
+/// The maximum number of task nodes of the task pool of an executor.
+static constexpr size_t kAsyncTaskPoolMaxSize = 64 * 1024;
+/**
+ * @brief When work stealing is enabled, the affinitized tasks of a worker which
+ * has not started any task for this long can be stolen by its siblings.
+ */
+static constexpr std::chrono::nanoseconds kWorkStealingStarvationThreshold =
+    std::chrono::milliseconds(10);
 }  // namespace google::scp::core
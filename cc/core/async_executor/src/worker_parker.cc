@@ -0,0 +1,46 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "worker_parker.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::seconds;
+
+namespace google::scp::core {
+void WorkerParker::Wait(nanoseconds timeout) noexcept {
+  auto timeout_seconds = duration_cast<seconds>(timeout);
+  timespec relative_timeout;
+  relative_timeout.tv_sec = timeout_seconds.count();
+  relative_timeout.tv_nsec = (timeout - timeout_seconds).count();
+  // Returns right away if a producer already reset the state. Spurious wake
+  // ups are fine since the worker re-checks its queues.
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state_), FUTEX_WAIT_PRIVATE,
+          static_cast<uint32_t>(State::Parked), &relative_timeout, nullptr, 0);
+}
+
+void WorkerParker::Wake() noexcept {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state_), FUTEX_WAKE_PRIVATE,
+          1, nullptr, nullptr, 0);
+}
+}  // namespace google::scp::core
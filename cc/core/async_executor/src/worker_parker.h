@@ -0,0 +1,91 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace google::scp::core {
+/**
+ * @brief Parks a single worker thread until producers signal new work. The
+ * worker spins for a while before sleeping on a futex, and producers only make
+ * the wake up system call when the worker is actually parked, so that a busy
+ * worker costs producers a single atomic load.
+ */
+class WorkerParker {
+ public:
+  WorkerParker() : state_(State::Running) {}
+
+  /**
+   * @brief Blocks the worker until has_work returns true, Unpark() is called
+   * or the timeout expires. has_work is polled for spin_count iterations
+   * first.
+   *
+   * @param has_work returns true if the worker has something to do.
+   * @param spin_count the number of polls before parking.
+   * @param timeout the maximum time to stay parked.
+   */
+  template <typename Predicate>
+  void Park(const Predicate& has_work, size_t spin_count,
+            std::chrono::nanoseconds timeout) noexcept {
+    for (size_t i = 0; i < spin_count; i++) {
+      if (has_work()) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+
+    state_.store(State::Parked, std::memory_order_relaxed);
+    // Pairs with the fence in Unpark(): either the producer sees the parked
+    // state, or this thread sees the work it published.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!has_work()) {
+      Wait(timeout);
+    }
+    state_.store(State::Running, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Wakes up the worker if it is parked. Must be called after the work
+   * is published.
+   */
+  void Unpark() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (state_.load(std::memory_order_relaxed) == State::Parked &&
+        state_.exchange(State::Running, std::memory_order_relaxed) ==
+            State::Parked) {
+      Wake();
+    }
+  }
+
+ private:
+  enum class State : uint32_t { Running = 0, Parked = 1 };
+
+  /// Sleeps on the futex as long as the state is parked.
+  void Wait(std::chrono::nanoseconds timeout) noexcept;
+
+  /// Wakes up the thread sleeping on the futex.
+  void Wake() noexcept;
+
+  /// The futex word.
+  std::atomic<State> state_;
+  static_assert(sizeof(std::atomic<State>) == sizeof(uint32_t),
+                "The futex word must be 32 bits.");
+};
+}  // namespace google::scp::core
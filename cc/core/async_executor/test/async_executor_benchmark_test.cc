@@ -0,0 +1,133 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "core/async_executor/src/async_executor.h"
+#include "core/common/time_provider/src/time_provider.h"
+#include "public/core/test/interface/execution_result_matchers.h"
+
+using google::scp::core::common::TimeProvider;
+using std::atomic;
+using std::cout;
+using std::endl;
+using std::make_shared;
+using std::mutex;
+using std::shared_ptr;
+using std::sort;
+using std::thread;
+using std::unique_lock;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::chrono::nanoseconds;
+using std::this_thread::sleep_for;
+
+namespace google::scp::core::test {
+class AsyncExecutorBenchmarkTest : public ::testing::Test {
+ protected:
+  /**
+   * @brief Runs a workload where a few producers enqueue expensive tasks in
+   * bursts next to a stream of cheap tasks, and reports the tail of the
+   * queueing latency of the cheap tasks.
+   */
+  void RunSkewedProducersWorkload(TaskLoadBalancingScheme scheme) {
+    AsyncExecutor executor(thread_count_, 100000 /* queue_cap */,
+                           false /* drop_tasks_on_stop */, scheme);
+    EXPECT_SUCCESS(executor.Init());
+    EXPECT_SUCCESS(executor.Run());
+
+    atomic<bool> start = false;
+    atomic<int64_t> executed_count = 0;
+    mutex latencies_mutex;
+    vector<int64_t> latencies_ns;
+    latencies_ns.reserve(total_task_count_);
+
+    auto producer = [&](int producer_id) {
+      while (!start) {}
+      for (int i = 0; i < task_schedule_count_per_thread_; i++) {
+        auto scheduled_at = TimeProvider::GetSteadyTimestampInNanoseconds();
+        // The first producer is the heavy hitter, every slow_task_period_-th
+        // of its tasks is slow.
+        auto is_slow_task = producer_id == 0 && i % slow_task_period_ == 0;
+        EXPECT_SUCCESS(executor.Schedule(
+            [&, scheduled_at, is_slow_task]() {
+              auto latency = TimeProvider::GetSteadyTimestampInNanoseconds() -
+                             scheduled_at;
+              if (is_slow_task) {
+                sleep_for(slow_task_duration_);
+              } else {
+                unique_lock lock(latencies_mutex);
+                latencies_ns.push_back(latency.count());
+              }
+              executed_count++;
+            },
+            AsyncPriority::Normal));
+      }
+    };
+
+    vector<thread> producers;
+    for (int i = 0; i < num_threads_scheduling_tasks_; i++) {
+      producers.emplace_back(producer, i);
+    }
+
+    auto start_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+    start = true;
+    for (auto& producer_thread : producers) {
+      producer_thread.join();
+    }
+    while (executed_count != total_task_count_) {
+      sleep_for(milliseconds(5));
+    }
+    auto end_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+    EXPECT_SUCCESS(executor.Stop());
+
+    sort(latencies_ns.begin(), latencies_ns.end());
+    auto percentile = [&](double p) {
+      return duration_cast<microseconds>(
+                 nanoseconds(latencies_ns[static_cast<size_t>(
+                     p * (latencies_ns.size() - 1))]))
+          .count();
+    };
+    cout << (duration_cast<milliseconds>(end_ns - start_ns)).count()
+         << " milliseconds elapsed, queueing latency p50 " << percentile(0.5)
+         << "us p99 " << percentile(0.99) << "us p999 " << percentile(0.999)
+         << "us" << endl;
+  }
+
+  size_t thread_count_ = 8;
+  int num_threads_scheduling_tasks_ = 4;
+  int task_schedule_count_per_thread_ = 20000;
+  int64_t total_task_count_ =
+      num_threads_scheduling_tasks_ * task_schedule_count_per_thread_;
+  int slow_task_period_ = 100;
+  milliseconds slow_task_duration_ = milliseconds(2);
+};
+
+TEST_F(AsyncExecutorBenchmarkTest, SkewedProducersRoundRobinGlobal) {
+  GTEST_SKIP();
+  RunSkewedProducersWorkload(TaskLoadBalancingScheme::RoundRobinGlobal);
+}
+
+TEST_F(AsyncExecutorBenchmarkTest, SkewedProducersWorkStealing) {
+  GTEST_SKIP();
+  RunSkewedProducersWorkload(TaskLoadBalancingScheme::WorkStealing);
+}
+}  // namespace google::scp::core::test
@@ -331,6 +331,131 @@ TEST(AsyncExecutorTests, CountWorkMultipleThread) {
   EXPECT_EQ(count, queue_cap);
 }
 
+TEST(AsyncExecutorTests, WorkStealingDrainsBlockedExecutorQueue) {
+  int queue_cap = 50;
+  AsyncExecutor executor(2, queue_cap, false /* drop_tasks_on_stop */,
+                         TaskLoadBalancingScheme::WorkStealing);
+  EXPECT_SUCCESS(executor.Init());
+  EXPECT_SUCCESS(executor.Run());
+
+  // Blocks one of the executors, the tasks queued behind the blocking task
+  // must be picked up by the other executor.
+  atomic<bool> blocker_started(false);
+  atomic<bool> release_blocker(false);
+  EXPECT_SUCCESS(executor.Schedule(
+      [&]() {
+        blocker_started = true;
+        while (!release_blocker) {
+          sleep_for(UNIT_TEST_SHORT_SLEEP_MS);
+        }
+      },
+      AsyncPriority::Normal));
+  WaitUntil([&]() { return blocker_started.load(); });
+
+  atomic<int> count(0);
+  for (int i = 0; i < queue_cap; i++) {
+    EXPECT_SUCCESS(executor.Schedule([&]() { count++; },
+                                     i % 2 == 0 ? AsyncPriority::Normal
+                                                : AsyncPriority::High));
+  }
+  WaitUntil([&]() { return count == queue_cap; });
+  EXPECT_EQ(count, queue_cap);
+  EXPECT_FALSE(release_blocker.load());
+
+  release_blocker = true;
+  EXPECT_SUCCESS(executor.Stop());
+}
+
+TEST(AsyncExecutorTests, WorkStealingKeepsAffinitizedTasksSticky) {
+  int queue_cap = 10;
+  AsyncExecutor executor(2, queue_cap, false /* drop_tasks_on_stop */,
+                         TaskLoadBalancingScheme::WorkStealing);
+  EXPECT_SUCCESS(executor.Init());
+  EXPECT_SUCCESS(executor.Run());
+
+  atomic<int> count(0);
+  EXPECT_SUCCESS(executor.Schedule(
+      [&]() {
+        auto thread_id = std::this_thread::get_id();
+        for (int i = 0; i < queue_cap; i++) {
+          EXPECT_SUCCESS(executor.Schedule(
+              [&count, thread_id = thread_id]() {
+                EXPECT_EQ(std::this_thread::get_id(), thread_id);
+                count++;
+              },
+              AsyncPriority::Normal,
+              AsyncExecutorAffinitySetting::AffinitizedToCallingAsyncExecutor));
+        }
+      },
+      AsyncPriority::Normal));
+
+  WaitUntil([&]() { return count == queue_cap; });
+  EXPECT_EQ(count, queue_cap);
+  EXPECT_SUCCESS(executor.Stop());
+}
+
+TEST(AsyncExecutorTests, WorkStealingStealsAffinitizedTasksWhenStarved) {
+  AsyncExecutor executor(2, 10, false /* drop_tasks_on_stop */,
+                         TaskLoadBalancingScheme::WorkStealing);
+  EXPECT_SUCCESS(executor.Init());
+  EXPECT_SUCCESS(executor.Run());
+
+  // The parent blocks its executor until the affinitized child runs, so the
+  // child can only run if a sibling steals it.
+  atomic<bool> child_executed(false);
+  atomic<bool> parent_finished(false);
+  EXPECT_SUCCESS(executor.Schedule(
+      [&]() {
+        auto thread_id = std::this_thread::get_id();
+        EXPECT_SUCCESS(executor.Schedule(
+            [&, thread_id = thread_id]() {
+              EXPECT_NE(std::this_thread::get_id(), thread_id);
+              child_executed = true;
+            },
+            AsyncPriority::Normal,
+            AsyncExecutorAffinitySetting::AffinitizedToCallingAsyncExecutor));
+        while (!child_executed) {
+          sleep_for(UNIT_TEST_SHORT_SLEEP_MS);
+        }
+        parent_finished = true;
+      },
+      AsyncPriority::Normal));
+
+  WaitUntil([&]() { return parent_finished.load(); });
+  EXPECT_TRUE(child_executed.load());
+  EXPECT_SUCCESS(executor.Stop());
+}
+
+TEST(AsyncExecutorTests, RingBufferCannotBeCombinedWithWorkStealing) {
+  AsyncExecutor executor(2, 10, false /* drop_tasks_on_stop */,
+                         TaskLoadBalancingScheme::WorkStealing,
+                         TimerQueueType::PriorityQueue,
+                         TaskQueueType::RingBuffer);
+  EXPECT_THAT(executor.Init(),
+              ResultIs(FailureExecutionResult(
+                  errors::SC_ASYNC_EXECUTOR_INVALID_TASK_QUEUE_TYPE)));
+}
+
+TEST(AsyncExecutorTests, RingBufferCountWorkMultipleThread) {
+  int queue_cap = 50;
+  AsyncExecutor executor(4, queue_cap, false /* drop_tasks_on_stop */,
+                         TaskLoadBalancingScheme::RoundRobinGlobal,
+                         TimerQueueType::PriorityQueue,
+                         TaskQueueType::RingBuffer);
+  EXPECT_SUCCESS(executor.Init());
+  EXPECT_SUCCESS(executor.Run());
+
+  atomic<int> count(0);
+  for (int i = 0; i < queue_cap; i++) {
+    EXPECT_SUCCESS(executor.Schedule([&]() { count++; },
+                                     i % 2 == 0 ? AsyncPriority::Normal
+                                                : AsyncPriority::High));
+  }
+  WaitUntil([&]() { return count == queue_cap; });
+  EXPECT_EQ(count, queue_cap);
+  EXPECT_SUCCESS(executor.Stop());
+}
+
 TEST(AsyncExecutorTests, AsyncContextCallback) {
   AsyncExecutor executor(1, 10);
   executor.Init();
@@ -0,0 +1,118 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/async_executor/src/async_task_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "core/async_executor/src/typedef.h"
+
+using std::atomic;
+using std::make_shared;
+using std::move;
+using std::thread;
+using std::vector;
+
+namespace google::scp::core::test {
+TEST(AsyncTaskPoolTest, RecyclesReleasedTasks) {
+  AsyncTaskPool pool(kAsyncTaskPoolSlabSize);
+  EXPECT_EQ(pool.GetAllocatedNodeCount(), 0);
+
+  int execution_count = 0;
+  auto task = pool.Acquire([&]() { execution_count++; }, 1234);
+  EXPECT_EQ(pool.GetAllocatedNodeCount(), kAsyncTaskPoolSlabSize);
+  EXPECT_EQ(task->GetExecutionTimestamp(), 1234);
+  task->Execute();
+  EXPECT_EQ(execution_count, 1);
+
+  auto* released_task = task.get();
+  task.reset();
+  task = pool.Acquire();
+  EXPECT_EQ(task.get(), released_task);
+  EXPECT_EQ(pool.GetAllocatedNodeCount(), kAsyncTaskPoolSlabSize);
+}
+
+TEST(AsyncTaskPoolTest, ReleasesTheOperationWithTheTask) {
+  AsyncTaskPool pool(kAsyncTaskPoolSlabSize);
+  auto counter = make_shared<int>(0);
+  auto task = pool.Acquire([counter]() {});
+  EXPECT_EQ(counter.use_count(), 2);
+  task.reset();
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST(AsyncTaskPoolTest, FallsBackToTheHeapOnceExhausted) {
+  AsyncTaskPool pool(kAsyncTaskPoolSlabSize);
+  vector<PooledAsyncTask> tasks;
+  for (size_t i = 0; i < kAsyncTaskPoolSlabSize + 10; i++) {
+    tasks.push_back(pool.Acquire());
+  }
+  EXPECT_EQ(pool.GetAllocatedNodeCount(), kAsyncTaskPoolSlabSize);
+  EXPECT_EQ(tasks.back().get_deleter().pool, nullptr);
+  EXPECT_EQ(tasks.front().get_deleter().pool, &pool);
+
+  // Once tasks are returned, the pool is used again.
+  tasks.clear();
+  auto task = pool.Acquire();
+  EXPECT_EQ(task.get_deleter().pool, &pool);
+}
+
+TEST(AsyncTaskPoolTest, GrowsInSlabs) {
+  AsyncTaskPool pool(4 * kAsyncTaskPoolSlabSize);
+  vector<PooledAsyncTask> tasks;
+  for (size_t i = 0; i < 2 * kAsyncTaskPoolSlabSize + 1; i++) {
+    tasks.push_back(pool.Acquire());
+    EXPECT_EQ(tasks.back().get_deleter().pool, &pool);
+  }
+  EXPECT_EQ(pool.GetAllocatedNodeCount(), 3 * kAsyncTaskPoolSlabSize);
+}
+
+TEST(AsyncTaskPoolTest, ConcurrentAcquireAndRelease) {
+  AsyncTaskPool pool(kAsyncTaskPoolSlabSize);
+  atomic<size_t> execution_count = 0;
+  size_t thread_count = 8;
+  size_t iteration_count = 20000;
+
+  vector<thread> threads;
+  for (size_t i = 0; i < thread_count; i++) {
+    threads.emplace_back([&]() {
+      vector<PooledAsyncTask> tasks;
+      for (size_t j = 0; j < iteration_count; j++) {
+        tasks.push_back(pool.Acquire([&]() { execution_count++; }));
+        // Release in batches so that the free list is shared by the threads.
+        if (tasks.size() == 16) {
+          for (auto& task : tasks) {
+            task->Execute();
+          }
+          tasks.clear();
+        }
+      }
+      for (auto& task : tasks) {
+        task->Execute();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(execution_count, thread_count * iteration_count);
+  EXPECT_EQ(pool.GetAllocatedNodeCount(), kAsyncTaskPoolSlabSize);
+}
+}  // namespace google::scp::core::test
@@ -16,9 +16,18 @@
 
 #include <gtest/gtest.h>
 
+#include <array>
+#include <memory>
+
+#include "core/async_executor/src/inline_async_operation.h"
 #include "core/common/time_provider/src/time_provider.h"
 
 using google::scp::core::common::TimeProvider;
+using std::array;
+using std::make_shared;
+using std::make_unique;
+using std::move;
+using std::shared_ptr;
 
 namespace google::scp::core::test {
 TEST(AsyncTaskTests, BasicTests) {
@@ -31,4 +40,61 @@ TEST(AsyncTaskTests, BasicTests) {
   AsyncTask async_task1(func, 1234);
   EXPECT_EQ(async_task1.GetExecutionTimestamp(), 1234);
 }
+
+TEST(AsyncTaskTests, ExecuteAndCancelAreExclusive) {
+  int execution_count = 0;
+  AsyncTask executed_task([&]() { execution_count++; });
+  executed_task.Execute();
+  executed_task.Execute();
+  EXPECT_EQ(execution_count, 1);
+  EXPECT_FALSE(executed_task.Cancel());
+  EXPECT_FALSE(executed_task.IsCancelled());
+
+  AsyncTask cancelled_task([&]() { execution_count++; });
+  EXPECT_TRUE(cancelled_task.Cancel());
+  EXPECT_FALSE(cancelled_task.Cancel());
+  EXPECT_TRUE(cancelled_task.IsCancelled());
+  cancelled_task.Execute();
+  EXPECT_EQ(execution_count, 1);
+}
+
+TEST(AsyncTaskTests, InlineAsyncOperationStoresSmallCallablesInline) {
+  auto counter = make_shared<int>(0);
+  InlineAsyncOperation operation([counter]() { (*counter)++; });
+  EXPECT_EQ(counter.use_count(), 2);
+
+  InlineAsyncOperation moved_operation(move(operation));
+  EXPECT_FALSE(operation);
+  EXPECT_TRUE(moved_operation);
+  EXPECT_EQ(counter.use_count(), 2);
+  moved_operation();
+  EXPECT_EQ(*counter, 1);
+
+  moved_operation.Reset();
+  EXPECT_FALSE(moved_operation);
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST(AsyncTaskTests, InlineAsyncOperationSupportsLargeAndMoveOnlyCallables) {
+  auto counter = make_shared<int>(0);
+  array<char, 2 * kInlineAsyncOperationSize> payload = {};
+  payload[0] = 1;
+  InlineAsyncOperation large_operation(
+      [counter, payload]() { (*counter) += payload[0]; });
+  InlineAsyncOperation moved_operation;
+  moved_operation = move(large_operation);
+  EXPECT_FALSE(large_operation);
+  moved_operation();
+  EXPECT_EQ(*counter, 1);
+
+  auto value = make_unique<int>(5);
+  InlineAsyncOperation move_only_operation(
+      [counter, value = move(value)]() { (*counter) += *value; });
+  move_only_operation();
+  EXPECT_EQ(*counter, 6);
+
+  moved_operation = InlineAsyncOperation();
+  move_only_operation.Reset();
+  EXPECT_EQ(counter.use_count(), 1);
+}
 }  // namespace google::scp::core::test
@@ -14,11 +14,15 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdlib>
 #include <functional>
+#include <new>
+#include <string>
 #include <vector>
 
 #include "core/async_executor/src/single_thread_async_executor.h"
 #include "core/common/time_provider/src/time_provider.h"
+#include "core/interface/async_context.h"
 #include "public/core/test/interface/execution_result_matchers.h"
 
 using google::scp::core::ExecutionResult;
@@ -26,17 +30,42 @@ using google::scp::core::FailureExecutionResult;
 using google::scp::core::SuccessExecutionResult;
 using google::scp::core::common::TimeProvider;
 using std::atomic;
+using std::bad_alloc;
 using std::cout;
 using std::endl;
 using std::function;
 using std::make_shared;
+using std::memory_order_relaxed;
 using std::rand;
 using std::shared_ptr;
+using std::string;
 using std::thread;
 using std::vector;
 using std::chrono::duration_cast;
 using std::chrono::milliseconds;
 using std::this_thread::sleep_for;
+using std::this_thread::yield;
+
+namespace {
+/// Whether the allocations are counted, only while a benchmark measures them.
+atomic<bool> is_counting_allocations = false;
+/// Number of allocations made through operator new while counting.
+atomic<uint64_t> allocation_count = 0;
+}  // namespace
+
+void* operator new(size_t size) {
+  if (is_counting_allocations.load(memory_order_relaxed)) {
+    allocation_count.fetch_add(1, memory_order_relaxed);
+  }
+  if (auto* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
 
 namespace google::scp::core::test {
 class SingleThreadAsyncExecutorBenchmarkTest : public ::testing::Test {
@@ -50,6 +79,100 @@ class SingleThreadAsyncExecutorBenchmarkTest : public ::testing::Test {
     EXPECT_SUCCESS(async_executor_->Run());
   }
 
+  /**
+   * @brief Schedules small tasks from producer_count threads as fast as the
+   * queue allows and reports the throughput.
+   */
+  void RunProducersWorkload(TaskQueueType task_queue_type,
+                            int producer_count) {
+    int64_t task_count = 4000000;
+    int64_t task_count_per_producer = task_count / producer_count;
+    SingleThreadAsyncExecutor executor(
+        65536 /* queue_cap */, false /* drop_tasks_on_stop */,
+        std::nullopt /* affinity_cpu_number */, task_queue_type);
+    EXPECT_SUCCESS(executor.Init());
+    EXPECT_SUCCESS(executor.Run());
+
+    atomic<bool> start = false;
+    auto producer = [&]() {
+      while (!start) {}
+      for (int64_t i = 0; i < task_count_per_producer; i++) {
+        while (!executor.Schedule(test_work_function_, AsyncPriority::Normal)
+                    .Successful()) {
+          yield();
+        }
+      }
+    };
+    vector<thread> producers;
+    for (int i = 0; i < producer_count; i++) {
+      producers.emplace_back(producer);
+    }
+
+    auto start_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+    start = true;
+    for (auto& producer_thread : producers) {
+      producer_thread.join();
+    }
+    while (execution_count_ != task_count_per_producer * producer_count * 5) {
+      sleep_for(milliseconds(1));
+    }
+    auto end_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+    EXPECT_SUCCESS(executor.Stop());
+
+    auto elapsed_ms = duration_cast<milliseconds>(end_ns - start_ns).count();
+    cout << producer_count << " producers, " << elapsed_ms
+         << " milliseconds elapsed, "
+         << task_count_per_producer * producer_count * 1000 /
+                std::max<int64_t>(elapsed_ms, 1)
+         << " tasks/sec" << endl;
+  }
+
+  /**
+   * @brief Schedules task_count tasks with the schedule function, and reports
+   * the throughput and the allocations per task. The allocations are only
+   * counted from the first to the last task.
+   */
+  void RunAllocationsWorkload(const string& name,
+                              const function<ExecutionResult()>& schedule) {
+    SetUpExecutor();
+    int64_t task_count = 2000000;
+    // Keep the backlog bounded so that the steady state is measured rather
+    // than the growth of the queues.
+    int64_t max_pending_task_count = 10000;
+
+    // The matchers of EXPECT_SUCCESS allocate, so failures are only counted in
+    // the measured loop.
+    int64_t failure_count = 0;
+
+    allocation_count = 0;
+    is_counting_allocations = true;
+    auto start_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+    for (int64_t i = 0; i < task_count; i++) {
+      while (i - execution_count_.load() / 5 > max_pending_task_count) {
+        yield();
+      }
+      if (!schedule().Successful()) {
+        failure_count++;
+      }
+    }
+    while (execution_count_ != (task_count - failure_count) * 5) {
+      yield();
+    }
+    auto end_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+    is_counting_allocations = false;
+    EXPECT_EQ(failure_count, 0);
+
+    auto elapsed_ms = duration_cast<milliseconds>(end_ns - start_ns).count();
+    cout << name << ": " << elapsed_ms << " milliseconds elapsed, "
+         << task_count * 1000 / std::max<int64_t>(elapsed_ms, 1)
+         << " tasks/sec, "
+         << static_cast<double>(allocation_count.load()) / task_count
+         << " allocations/task" << endl;
+
+    EXPECT_SUCCESS(async_executor_->Stop());
+    execution_count_ = 0;
+  }
+
   int num_threads_scheduling_tasks_ = 10;
   int task_schedule_count_per_thread_ = 1000000;
   shared_ptr<SingleThreadAsyncExecutor> async_executor_;
@@ -139,4 +262,59 @@ TEST_F(SingleThreadAsyncExecutorBenchmarkTest, PerfTestSmallTaskMixedPriority) {
     threads[i].join();
   }
 }
+
+TEST_F(SingleThreadAsyncExecutorBenchmarkTest, PerfTestSmallTaskAllocations) {
+  GTEST_SKIP();
+  RunAllocationsWorkload("Small AsyncOperation", [&]() {
+    return async_executor_->Schedule(test_work_function_, AsyncPriority::High);
+  });
+
+  // The size of the closures of FinishContext, which capture the context.
+  AsyncContext<string, string> context;
+  auto finish_context_like_work = [this, context]() {
+    execution_count_ += 5;
+  };
+  RunAllocationsWorkload("AsyncContext capture as AsyncOperation", [&]() {
+    return async_executor_->Schedule(AsyncOperation(finish_context_like_work),
+                                     AsyncPriority::High);
+  });
+  RunAllocationsWorkload("AsyncContext capture inline", [&]() {
+    return async_executor_->ScheduleOperation(
+        InlineAsyncOperation(finish_context_like_work), AsyncPriority::High,
+        AsyncExecutorAffinitySetting::NonAffinitized);
+  });
+}
+
+TEST_F(SingleThreadAsyncExecutorBenchmarkTest,
+       PerfTestConcurrentQueue1Producer) {
+  GTEST_SKIP();
+  RunProducersWorkload(TaskQueueType::ConcurrentQueue, 1);
+}
+
+TEST_F(SingleThreadAsyncExecutorBenchmarkTest,
+       PerfTestConcurrentQueue4Producers) {
+  GTEST_SKIP();
+  RunProducersWorkload(TaskQueueType::ConcurrentQueue, 4);
+}
+
+TEST_F(SingleThreadAsyncExecutorBenchmarkTest,
+       PerfTestConcurrentQueue16Producers) {
+  GTEST_SKIP();
+  RunProducersWorkload(TaskQueueType::ConcurrentQueue, 16);
+}
+
+TEST_F(SingleThreadAsyncExecutorBenchmarkTest, PerfTestRingBuffer1Producer) {
+  GTEST_SKIP();
+  RunProducersWorkload(TaskQueueType::RingBuffer, 1);
+}
+
+TEST_F(SingleThreadAsyncExecutorBenchmarkTest, PerfTestRingBuffer4Producers) {
+  GTEST_SKIP();
+  RunProducersWorkload(TaskQueueType::RingBuffer, 4);
+}
+
+TEST_F(SingleThreadAsyncExecutorBenchmarkTest, PerfTestRingBuffer16Producers) {
+  GTEST_SKIP();
+  RunProducersWorkload(TaskQueueType::RingBuffer, 16);
+}
 }  // namespace google::scp::core::test
@@ -20,6 +20,7 @@
 #include <chrono>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "core/async_executor/mock/mock_async_executor_with_internals.h"
 #include "core/async_executor/src/error_codes.h"
@@ -267,6 +268,45 @@ TEST(SingleThreadAsyncExecutorTests, AsyncContextCallback) {
   executor.Stop();
 }
 
+TEST(SingleThreadAsyncExecutorTests, TryStealTaskFromBusyExecutor) {
+  SingleThreadAsyncExecutor executor(10);
+  EXPECT_SUCCESS(executor.Init());
+  EXPECT_SUCCESS(executor.Run());
+
+  atomic<bool> blocker_started(false);
+  atomic<bool> release_blocker(false);
+  EXPECT_SUCCESS(executor.Schedule(
+      [&]() {
+        blocker_started = true;
+        while (!release_blocker) {
+          std::this_thread::sleep_for(UNIT_TEST_SHORT_SLEEP_MS);
+        }
+      },
+      AsyncPriority::Normal));
+  WaitUntil([&]() { return blocker_started.load(); });
+  EXPECT_TRUE(executor.IsExecutingTask());
+
+  atomic<int> count(0);
+  EXPECT_SUCCESS(executor.Schedule([&]() { count++; }, AsyncPriority::Normal));
+  EXPECT_SUCCESS(
+      executor.Schedule([&]() { count += 10; }, AsyncPriority::High));
+  EXPECT_EQ(executor.GetPendingTaskCount(), 2);
+
+  // High priority tasks are stolen first.
+  PooledAsyncTask task;
+  EXPECT_TRUE(executor.TryStealTask(task));
+  task->Execute();
+  EXPECT_EQ(count, 10);
+  EXPECT_TRUE(executor.TryStealTask(task));
+  task->Execute();
+  EXPECT_EQ(count, 11);
+  EXPECT_FALSE(executor.TryStealTask(task));
+  EXPECT_EQ(executor.GetPendingTaskCount(), 0);
+
+  release_blocker = true;
+  EXPECT_SUCCESS(executor.Stop());
+}
+
 TEST(SingleThreadAsyncExecutorTests, FinishWorkWhenStopInMiddle) {
   int queue_cap = 6;
   SingleThreadAsyncExecutor executor(queue_cap);
@@ -298,4 +338,121 @@ TEST(SingleThreadAsyncExecutorTests, FinishWorkWhenStopInMiddle) {
 
   EXPECT_EQ(medium_count + normal_count, queue_cap);
 }
+
+TEST(SingleThreadAsyncExecutorTests, RingBufferCannotInitWithTooBigQueueCap) {
+  SingleThreadAsyncExecutor executor(kMaxRingBufferQueueCap + 1, false,
+                                     std::nullopt, TaskQueueType::RingBuffer);
+  EXPECT_THAT(executor.Init(),
+              ResultIs(FailureExecutionResult(
+                  errors::SC_ASYNC_EXECUTOR_INVALID_QUEUE_CAP)));
+}
+
+TEST(SingleThreadAsyncExecutorTests, RingBufferExceedingQueueCapSchedule) {
+  int queue_cap = 3;
+  SingleThreadAsyncExecutor executor(queue_cap, false, std::nullopt,
+                                     TaskQueueType::RingBuffer);
+  EXPECT_SUCCESS(executor.Init());
+  EXPECT_SUCCESS(executor.Run());
+
+  atomic<bool> release_blocker = false;
+  atomic<bool> blocker_started = false;
+  EXPECT_SUCCESS(executor.Schedule(
+      [&]() {
+        blocker_started = true;
+        while (!release_blocker) {}
+      },
+      AsyncPriority::Normal));
+  WaitUntil([&]() { return blocker_started.load(); });
+
+  for (int i = 0; i < queue_cap; i++) {
+    EXPECT_SUCCESS(executor.Schedule([&]() {}, AsyncPriority::Normal));
+  }
+  EXPECT_EQ(
+      executor.Schedule([&]() {}, AsyncPriority::Normal),
+      RetryExecutionResult(errors::SC_ASYNC_EXECUTOR_EXCEEDING_QUEUE_CAP));
+
+  // Only the worker thread dequeues from ring buffers.
+  PooledAsyncTask task;
+  EXPECT_FALSE(executor.TryStealTask(task));
+
+  release_blocker = true;
+  EXPECT_SUCCESS(executor.Stop());
+}
+
+TEST(SingleThreadAsyncExecutorTests, RingBufferCountWorkMultipleProducers) {
+  int queue_cap = 16;
+  SingleThreadAsyncExecutor executor(queue_cap, false, std::nullopt,
+                                     TaskQueueType::RingBuffer);
+  EXPECT_SUCCESS(executor.Init());
+  EXPECT_SUCCESS(executor.Run());
+
+  atomic<int> count(0);
+  int producer_count = 4;
+  int task_count_per_producer = 1000;
+  std::vector<std::thread> producers;
+  for (int i = 0; i < producer_count; i++) {
+    producers.emplace_back([&]() {
+      for (int j = 0; j < task_count_per_producer; j++) {
+        auto priority = j % 2 ? AsyncPriority::Normal : AsyncPriority::High;
+        while (!executor.Schedule([&]() { count++; }, priority).Successful()) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  int task_count = producer_count * task_count_per_producer;
+  WaitUntil([&]() { return count == task_count; });
+  EXPECT_SUCCESS(executor.Stop());
+  EXPECT_EQ(count, task_count);
+}
+
+TEST(SingleThreadAsyncExecutorTests, RingBufferWakesUpParkedWorker) {
+  SingleThreadAsyncExecutor executor(10, false, std::nullopt,
+                                     TaskQueueType::RingBuffer);
+  EXPECT_SUCCESS(executor.Init());
+  EXPECT_SUCCESS(executor.Run());
+
+  atomic<int> count(0);
+  for (int i = 0; i < 5; i++) {
+    // Gives the worker time to park between the tasks.
+    std::this_thread::sleep_for(UNIT_TEST_SHORT_SLEEP_MS);
+    EXPECT_SUCCESS(executor.Schedule([&]() { count++; }, AsyncPriority::High));
+    WaitUntil([&]() { return count == i + 1; });
+  }
+  EXPECT_SUCCESS(executor.Stop());
+}
+
+TEST(SingleThreadAsyncExecutorTests, RingBufferDropTasksOnStop) {
+  SingleThreadAsyncExecutor executor(10, true /* drop_tasks_on_stop */,
+                                     std::nullopt, TaskQueueType::RingBuffer);
+  EXPECT_SUCCESS(executor.Init());
+  EXPECT_SUCCESS(executor.Run());
+
+  atomic<bool> release_blocker = false;
+  atomic<bool> blocker_started = false;
+  atomic<int> count(0);
+  EXPECT_SUCCESS(executor.Schedule(
+      [&]() {
+        blocker_started = true;
+        while (!release_blocker) {}
+      },
+      AsyncPriority::Normal));
+  WaitUntil([&]() { return blocker_started.load(); });
+  for (int i = 0; i < 5; i++) {
+    EXPECT_SUCCESS(executor.Schedule([&]() { count++; }, AsyncPriority::High));
+  }
+
+  // Releases the blocker once Stop() has flagged the executor as stopped.
+  std::thread releaser([&]() {
+    WaitUntil([&]() { return !executor.GetThreadId().Successful(); });
+    release_blocker = true;
+  });
+  EXPECT_SUCCESS(executor.Stop());
+  releaser.join();
+  EXPECT_EQ(count, 0);
+}
 }  // namespace google::scp::core::test
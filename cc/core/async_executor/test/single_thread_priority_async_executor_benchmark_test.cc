@@ -0,0 +1,121 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <malloc.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <functional>
+#include <vector>
+
+#include "core/async_executor/src/single_thread_priority_async_executor.h"
+#include "core/common/time_provider/src/time_provider.h"
+#include "public/core/test/interface/execution_result_matchers.h"
+
+using google::scp::core::common::TimeProvider;
+using std::cout;
+using std::endl;
+using std::function;
+using std::ifstream;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::hours;
+using std::chrono::milliseconds;
+using std::chrono::nanoseconds;
+
+namespace {
+/// Returns the resident set size of the process in megabytes.
+size_t GetRssInMb() {
+  size_t total_pages = 0;
+  size_t resident_pages = 0;
+  ifstream statm("/proc/self/statm");
+  statm >> total_pages >> resident_pages;
+  return resident_pages * sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
+
+/// Returns the heap memory in use in megabytes. Unlike the RSS, this drops as
+/// soon as memory is freed.
+size_t GetHeapInUseInMb() {
+  return mallinfo2().uordblks / (1024 * 1024);
+}
+}  // namespace
+
+namespace google::scp::core::test {
+class SingleThreadPriorityAsyncExecutorBenchmarkTest : public ::testing::Test {
+ protected:
+  /**
+   * @brief Schedules timer_count_ far ahead timers, then cancels all of them
+   * and reports the throughput of both phases along with the RSS.
+   */
+  void RunPendingTimersWorkload(TimerQueueType timer_queue_type) {
+    SingleThreadPriorityAsyncExecutor executor(
+        timer_count_, false /* drop_tasks_on_stop */, std::nullopt,
+        timer_queue_type);
+    EXPECT_SUCCESS(executor.Init());
+    EXPECT_SUCCESS(executor.Run());
+
+    auto rss_before_mb = GetRssInMb();
+    auto heap_before_mb = GetHeapInUseInMb();
+    vector<function<bool()>> cancellation_callbacks(timer_count_);
+    auto base_timestamp =
+        TimeProvider::GetSteadyTimestampInNanoseconds() + hours(1);
+
+    auto start_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+    for (size_t i = 0; i < timer_count_; i++) {
+      // Spread the timers over a minute.
+      auto timestamp = base_timestamp + milliseconds(i % 60000);
+      EXPECT_SUCCESS(executor.ScheduleFor([]() {}, timestamp.count(),
+                                          cancellation_callbacks[i]));
+    }
+    auto schedule_end_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+    auto rss_pending_mb = GetRssInMb();
+    auto heap_pending_mb = GetHeapInUseInMb();
+
+    for (auto& cancellation_callback : cancellation_callbacks) {
+      cancellation_callback();
+    }
+    auto cancel_end_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+    auto heap_cancelled_mb = GetHeapInUseInMb();
+
+    auto per_second = [&](nanoseconds elapsed) {
+      return static_cast<uint64_t>(timer_count_ * 1e9 / elapsed.count());
+    };
+    cout << timer_count_ << " timers: scheduled "
+         << per_second(schedule_end_ns - start_ns) << " timers/sec, cancelled "
+         << per_second(cancel_end_ns - schedule_end_ns)
+         << " timers/sec, RSS growth with pending timers "
+         << rss_pending_mb - rss_before_mb << " MB, heap in use "
+         << heap_pending_mb - heap_before_mb
+         << " MB pending and after cancellation "
+         << heap_cancelled_mb - heap_before_mb << " MB" << endl;
+
+    EXPECT_SUCCESS(executor.Stop());
+  }
+
+  size_t timer_count_ = 1000000;
+};
+
+TEST_F(SingleThreadPriorityAsyncExecutorBenchmarkTest,
+       PendingTimersPriorityQueue) {
+  GTEST_SKIP();
+  RunPendingTimersWorkload(TimerQueueType::PriorityQueue);
+}
+
+TEST_F(SingleThreadPriorityAsyncExecutorBenchmarkTest,
+       PendingTimersTimerWheel) {
+  GTEST_SKIP();
+  RunPendingTimersWorkload(TimerQueueType::TimerWheel);
+}
+}  // namespace google::scp::core::test
@@ -308,4 +308,100 @@ TEST(SingleThreadPriorityAsyncExecutorTests,
   EXPECT_SUCCESS(executor.Stop());
 }
 
+TEST(SingleThreadPriorityAsyncExecutorTests, TimerWheelCountWork) {
+  int queue_cap = 10;
+  SingleThreadPriorityAsyncExecutor executor(
+      queue_cap, false /* drop_tasks_on_stop */, std::nullopt,
+      TimerQueueType::TimerWheel);
+  EXPECT_SUCCESS(executor.Init());
+  EXPECT_SUCCESS(executor.Run());
+
+  atomic<int> count(0);
+  auto now = TimeProvider::GetSteadyTimestampInNanoseconds();
+  for (int i = 0; i < queue_cap; i++) {
+    EXPECT_SUCCESS(executor.ScheduleFor(
+        [&]() { count++; }, (now + milliseconds(i * 20)).count()));
+  }
+  EXPECT_THAT(executor.ScheduleFor([&]() {}, 1234),
+              ResultIs(RetryExecutionResult(
+                  errors::SC_ASYNC_EXECUTOR_EXCEEDING_QUEUE_CAP)));
+
+  WaitUntil([&]() { return count == queue_cap; }, seconds(30));
+  EXPECT_EQ(count, queue_cap);
+  EXPECT_SUCCESS(executor.Stop());
+}
+
+TEST(SingleThreadPriorityAsyncExecutorTests,
+     TimerWheelDoesNotExecuteTasksBeforeTheirTime) {
+  SingleThreadPriorityAsyncExecutor executor(
+      10, false /* drop_tasks_on_stop */, std::nullopt,
+      TimerQueueType::TimerWheel);
+  EXPECT_SUCCESS(executor.Init());
+  EXPECT_SUCCESS(executor.Run());
+
+  atomic<bool> executed(false);
+  auto scheduled_timestamp =
+      (TimeProvider::GetSteadyTimestampInNanoseconds() + milliseconds(100))
+          .count();
+  EXPECT_SUCCESS(executor.ScheduleFor(
+      [&]() {
+        EXPECT_GE(TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks(),
+                  scheduled_timestamp);
+        executed = true;
+      },
+      scheduled_timestamp));
+  WaitUntil([&]() { return executed.load(); }, seconds(30));
+  EXPECT_SUCCESS(executor.Stop());
+}
+
+TEST(SingleThreadPriorityAsyncExecutorTests, TimerWheelTaskCancellation) {
+  int queue_cap = 3;
+  SingleThreadPriorityAsyncExecutor executor(
+      queue_cap, false /* drop_tasks_on_stop */, std::nullopt,
+      TimerQueueType::TimerWheel);
+  EXPECT_SUCCESS(executor.Init());
+  EXPECT_SUCCESS(executor.Run());
+
+  for (int i = 0; i < queue_cap; i++) {
+    function<bool()> cancellation_callback;
+    auto far_ahead_timestamp =
+        (TimeProvider::GetSteadyTimestampInNanoseconds() + hours(24)).count();
+
+    EXPECT_SUCCESS(executor.ScheduleFor([&]() { EXPECT_EQ(true, false); },
+                                        far_ahead_timestamp,
+                                        cancellation_callback));
+
+    EXPECT_EQ(cancellation_callback(), true);
+    EXPECT_EQ(cancellation_callback(), false);
+  }
+
+  // Cancelled tasks free up their space in the queue right away.
+  for (int i = 0; i < queue_cap; i++) {
+    function<bool()> cancellation_callback;
+    auto far_ahead_timestamp =
+        (TimeProvider::GetSteadyTimestampInNanoseconds() + hours(24)).count();
+    EXPECT_SUCCESS(executor.ScheduleFor([&]() { EXPECT_EQ(true, false); },
+                                        far_ahead_timestamp,
+                                        cancellation_callback));
+    EXPECT_EQ(cancellation_callback(), true);
+  }
+
+  // This should exit quickly and should not get stuck.
+  EXPECT_SUCCESS(executor.Stop());
+}
+
+TEST(SingleThreadPriorityAsyncExecutorTests, TimerWheelDropTasksOnStop) {
+  SingleThreadPriorityAsyncExecutor executor(
+      10, true /* drop_tasks_on_stop */, std::nullopt,
+      TimerQueueType::TimerWheel);
+  EXPECT_SUCCESS(executor.Init());
+  EXPECT_SUCCESS(executor.Run());
+
+  auto far_ahead_timestamp =
+      (TimeProvider::GetSteadyTimestampInNanoseconds() + hours(24)).count();
+  EXPECT_SUCCESS(executor.ScheduleFor([&]() { EXPECT_EQ(true, false); },
+                                      far_ahead_timestamp));
+  // This should exit quickly and should not get stuck.
+  EXPECT_SUCCESS(executor.Stop());
+}
 }  // namespace google::scp::core::test
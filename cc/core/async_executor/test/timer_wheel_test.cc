@@ -0,0 +1,126 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/async_executor/src/timer_wheel.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+using std::shared_ptr;
+using std::vector;
+using std::chrono::nanoseconds;
+
+namespace google::scp::core::test {
+class TimerWheelTest : public ::testing::Test {
+ protected:
+  /// Ticks of 10ns on a wheel of 8 slots starting at 1000.
+  TimerWheel timer_wheel_{nanoseconds(10), 8, 1000};
+  vector<shared_ptr<AsyncTask>> expired_tasks_;
+};
+
+TEST_F(TimerWheelTest, ExpiresTasksNotBeforeTheirTimestamp) {
+  int executed = 0;
+  timer_wheel_.Insert([&]() { executed++; }, 1025, 1000);
+  EXPECT_EQ(timer_wheel_.Size(), 1);
+
+  timer_wheel_.Advance(1024, expired_tasks_);
+  EXPECT_TRUE(expired_tasks_.empty());
+  // The tick of the task starts at 1030.
+  EXPECT_EQ(timer_wheel_.GetNextExpiryTimestamp(), 1030);
+
+  timer_wheel_.Advance(1030, expired_tasks_);
+  ASSERT_EQ(expired_tasks_.size(), 1);
+  expired_tasks_[0]->Execute();
+  EXPECT_EQ(executed, 1);
+  EXPECT_EQ(timer_wheel_.Size(), 0);
+  EXPECT_EQ(timer_wheel_.GetNextExpiryTimestamp(), UINT64_MAX);
+}
+
+TEST_F(TimerWheelTest, DueTasksExpireOnNextAdvance) {
+  timer_wheel_.Insert([]() {}, 900, 1000);
+  timer_wheel_.Insert([]() {}, 1005, 1005);
+  EXPECT_EQ(timer_wheel_.GetNextExpiryTimestamp(), 0);
+
+  timer_wheel_.Advance(1005, expired_tasks_);
+  EXPECT_EQ(expired_tasks_.size(), 2);
+  EXPECT_EQ(timer_wheel_.Size(), 0);
+}
+
+TEST_F(TimerWheelTest, TasksOfLaterRevolutionsAreSkipped) {
+  // 1010 and 1090 hash to the same slot.
+  timer_wheel_.Insert([]() {}, 1010, 1000);
+  timer_wheel_.Insert([]() {}, 1090, 1000);
+
+  timer_wheel_.Advance(1010, expired_tasks_);
+  EXPECT_EQ(expired_tasks_.size(), 1);
+  EXPECT_EQ(timer_wheel_.Size(), 1);
+
+  timer_wheel_.Advance(1089, expired_tasks_);
+  EXPECT_EQ(expired_tasks_.size(), 1);
+
+  timer_wheel_.Advance(1090, expired_tasks_);
+  EXPECT_EQ(expired_tasks_.size(), 2);
+  EXPECT_EQ(timer_wheel_.Size(), 0);
+}
+
+TEST_F(TimerWheelTest, AdvanceOverMultipleRevolutions) {
+  for (Timestamp timestamp = 1010; timestamp < 1500; timestamp += 7) {
+    timer_wheel_.Insert([]() {}, timestamp, 1000);
+  }
+  auto size = timer_wheel_.Size();
+
+  timer_wheel_.Advance(10000, expired_tasks_);
+  EXPECT_EQ(expired_tasks_.size(), size);
+  EXPECT_EQ(timer_wheel_.Size(), 0);
+}
+
+TEST_F(TimerWheelTest, CancelReleasesTheTask) {
+  auto entry = timer_wheel_.Insert([]() {}, 1050, 1000);
+  EXPECT_FALSE(entry.expired());
+
+  EXPECT_TRUE(timer_wheel_.Cancel(entry));
+  EXPECT_TRUE(entry.expired());
+  EXPECT_EQ(timer_wheel_.Size(), 0);
+  EXPECT_FALSE(timer_wheel_.Cancel(entry));
+
+  timer_wheel_.Advance(2000, expired_tasks_);
+  EXPECT_TRUE(expired_tasks_.empty());
+}
+
+TEST_F(TimerWheelTest, CannotCancelExpiredTask) {
+  auto entry = timer_wheel_.Insert([]() {}, 1050, 1000);
+  timer_wheel_.Advance(1050, expired_tasks_);
+  EXPECT_EQ(expired_tasks_.size(), 1);
+  EXPECT_FALSE(timer_wheel_.Cancel(entry));
+  // The expired task keeps its entry alive until released.
+  EXPECT_FALSE(entry.expired());
+  expired_tasks_.clear();
+  EXPECT_TRUE(entry.expired());
+}
+
+TEST_F(TimerWheelTest, Clear) {
+  auto entry = timer_wheel_.Insert([]() {}, 1050, 1000);
+  timer_wheel_.Insert([]() {}, 100, 1000);
+  EXPECT_EQ(timer_wheel_.Size(), 2);
+
+  timer_wheel_.Clear();
+  EXPECT_EQ(timer_wheel_.Size(), 0);
+  EXPECT_FALSE(timer_wheel_.Cancel(entry));
+  timer_wheel_.Advance(2000, expired_tasks_);
+  EXPECT_TRUE(expired_tasks_.empty());
+}
+}  // namespace google::scp::core::test
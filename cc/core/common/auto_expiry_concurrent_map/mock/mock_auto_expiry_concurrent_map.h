@@ -47,6 +47,17 @@ class MockAutoExpiryConcurrentMap
     AutoExpiryConcurrentMap<TKey, TValue, TCompare>::RunGarbageCollector();
   }
 
+  /// Adds the entry of the key to the expiry index, e.g. after inserting it
+  /// directly into the underlying map or moving its expiration time back.
+  void AddToExpiryIndex(const TKey& key) {
+    std::shared_ptr<typename AutoExpiryConcurrentMap<
+        TKey, TValue, TCompare>::AutoExpiryConcurrentMapEntry>
+        entry;
+    GetUnderlyingConcurrentMap().Find(key, entry);
+    AutoExpiryConcurrentMap<TKey, TValue, TCompare>::AddToExpiryIndex(key,
+                                                                      entry);
+  }
+
   bool IsEvictable(TKey& key) {
     std::shared_ptr<typename AutoExpiryConcurrentMap<
         TKey, TValue, TCompare>::AutoExpiryConcurrentMapEntry>
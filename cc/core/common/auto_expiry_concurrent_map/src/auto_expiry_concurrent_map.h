@@ -19,6 +19,8 @@
 #include <atomic>
 #include <chrono>
 #include <functional>
+#include <iterator>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -33,10 +35,20 @@
 #include "error_codes.h"
 
 namespace google::scp::core::common {
+/// The time span covered by a bucket of the expiry index.
+static constexpr std::chrono::nanoseconds
+    kAutoExpiryConcurrentMapExpiryBucketDuration = std::chrono::seconds(1);
+
 /**
  * @brief AutoExpiryConcurrentMap provides auto cleanup functionality on
  * top of a concurrent map which is a multi producers and multi consumers map
  * support to be used generically.
+ *
+ * Entries are tracked by an expiry index which buckets them by their
+ * expiration time, so that garbage collection only visits the buckets which
+ * are due instead of scanning the whole map. Extending the lifetime of an
+ * entry does not move it in the index; when its bucket comes due the entry is
+ * moved to the bucket of its new expiration time instead.
  */
 template <class TKey, class TValue,
           typename TCompare = oneapi::tbb::tbb_hash_compare<TKey>>
@@ -48,7 +60,10 @@ class AutoExpiryConcurrentMap : public ServiceInterface {
    */
   struct AutoExpiryConcurrentMapEntry {
     AutoExpiryConcurrentMapEntry(TValue& entry, size_t expiration_in_seconds)
-        : entry(entry), being_evicted(false), is_evictable(true) {
+        : entry(entry),
+          being_evicted(false),
+          is_evictable(true),
+          expiry_index_generation(0) {
       expiration_time = (TimeProvider::GetSteadyTimestampInNanoseconds() +
                          std::chrono::seconds(expiration_in_seconds))
                             .count();
@@ -67,8 +82,6 @@ class AutoExpiryConcurrentMap : public ServiceInterface {
             errors::SC_AUTO_EXPIRY_CONCURRENT_MAP_INVALID_EXPIRATION);
       }
 
-      std::shared_lock<std::shared_timed_mutex> lock(record_lock);
-
       if (being_evicted) {
         return FailureExecutionResult(
             errors::SC_AUTO_EXPIRY_CONCURRENT_MAP_ENTRY_BEING_DELETED);
@@ -78,6 +91,14 @@ class AutoExpiryConcurrentMap : public ServiceInterface {
                          std::chrono::seconds(expiration_seconds))
                             .count();
 
+      // The garbage collector marks the entry before reading its expiration
+      // time, so if the entry is still not marked here, the collector will see
+      // the extended expiration time.
+      if (being_evicted) {
+        return FailureExecutionResult(
+            errors::SC_AUTO_EXPIRY_CONCURRENT_MAP_ENTRY_BEING_DELETED);
+      }
+
       return SuccessExecutionResult();
     }
 
@@ -94,23 +115,28 @@ class AutoExpiryConcurrentMap : public ServiceInterface {
       return expiration_time < current_time;
     }
 
-    /**
-     * @brief Locks the record and gets exclusive access. After the write is
-     * acquired, the expiration will be ignored until the lock is released.
-     */
-    std::shared_timed_mutex record_lock;
-
     /// An instance of the actual entry of the map.
     TValue entry;
 
-    /// Indicates if the entry is being deleted.
-    bool being_evicted;
+    /**
+     * @brief Indicates if the entry is being deleted. Only the garbage
+     * collector sets it, after which the expiration will be ignored until it
+     * is cleared.
+     */
+    std::atomic<bool> being_evicted;
 
     /// Indicates if the entry is evictable.
-    bool is_evictable;
+    std::atomic<bool> is_evictable;
 
     /// Expiration of the entry in the memory
     std::atomic<core::Timestamp> expiration_time;
+
+    /**
+     * @brief Bumped every time the entry is added to the expiry index. Only the
+     * index item carrying the latest generation is live, the others are
+     * skipped.
+     */
+    std::atomic<uint64_t> expiry_index_generation;
   };
 
   /**
@@ -178,21 +204,18 @@ class AutoExpiryConcurrentMap : public ServiceInterface {
     auto pair = std::make_pair(key_value.first, record);
     auto execution_result = concurrent_map_.Insert(pair, record);
 
-    if (!execution_result.Successful()) {
+    if (execution_result.Successful()) {
+      AddToExpiryIndex(key_value.first, record);
+    } else {
       if (execution_result !=
           FailureExecutionResult(
               core::errors::SC_CONCURRENT_MAP_ENTRY_ALREADY_EXISTS)) {
         return execution_result;
       }
 
-      std::shared_lock<std::shared_timed_mutex> lock(record->record_lock);
-      if (block_entry_while_eviction_ && record->being_evicted) {
-        return FailureExecutionResult(
-            errors::SC_AUTO_EXPIRY_CONCURRENT_MAP_ENTRY_BEING_DELETED);
-      }
-
-      if (extend_entry_lifetime_on_access_ && !record->being_evicted) {
-        record->ExtendExpiration(map_entry_lifetime_seconds_);
+      auto access_result = AccessEntry(*record);
+      if (!access_result.Successful()) {
+        return access_result;
       }
     }
 
@@ -214,14 +237,9 @@ class AutoExpiryConcurrentMap : public ServiceInterface {
     auto execution_result = concurrent_map_.Find(key, record);
 
     if (execution_result.Successful()) {
-      std::shared_lock<std::shared_timed_mutex> lock(record->record_lock);
-      if (block_entry_while_eviction_ && record->being_evicted) {
-        return FailureExecutionResult(
-            errors::SC_AUTO_EXPIRY_CONCURRENT_MAP_ENTRY_BEING_DELETED);
-      }
-
-      if (extend_entry_lifetime_on_access_ && !record->being_evicted) {
-        record->ExtendExpiration(map_entry_lifetime_seconds_);
+      auto access_result = AccessEntry(*record);
+      if (!access_result.Successful()) {
+        return access_result;
       }
 
       out_value = record->entry;
@@ -269,7 +287,6 @@ class AutoExpiryConcurrentMap : public ServiceInterface {
     std::shared_ptr<AutoExpiryConcurrentMapEntry> record;
     auto execution_result = concurrent_map_.Find(key, record);
     if (execution_result.Successful()) {
-      std::shared_lock<std::shared_timed_mutex> lock(record->record_lock);
       if (record->being_evicted) {
         return FailureExecutionResult(
             errors::SC_AUTO_EXPIRY_CONCURRENT_MAP_ENTRY_BEING_DELETED);
@@ -279,7 +296,14 @@ class AutoExpiryConcurrentMap : public ServiceInterface {
         record->ExtendExpiration(map_entry_lifetime_seconds_);
       }
 
-      record->is_evictable = false;
+      // Same ordering as ExtendExpiration(), the garbage collector reads the
+      // flag after marking the entry.
+      auto was_evictable = record->is_evictable.exchange(false);
+      if (record->being_evicted) {
+        record->is_evictable = was_evictable;
+        return FailureExecutionResult(
+            errors::SC_AUTO_EXPIRY_CONCURRENT_MAP_ENTRY_BEING_DELETED);
+      }
     }
     return execution_result;
   }
@@ -294,7 +318,6 @@ class AutoExpiryConcurrentMap : public ServiceInterface {
     std::shared_ptr<AutoExpiryConcurrentMapEntry> record;
     auto execution_result = concurrent_map_.Find(key, record);
     if (execution_result.Successful()) {
-      std::shared_lock<std::shared_timed_mutex> lock(record->record_lock);
       if (record->being_evicted) {
         return FailureExecutionResult(
             errors::SC_AUTO_EXPIRY_CONCURRENT_MAP_ENTRY_BEING_DELETED);
@@ -343,37 +366,41 @@ class AutoExpiryConcurrentMap : public ServiceInterface {
    * alert must be raised.
    */
   void RunGarbageCollector() {
-    std::vector<TKey> keys;
-    auto execution_result = concurrent_map_.Keys(keys);
-    if (!execution_result.Successful()) {
-      // Reschedule
-      ScheduleGarbageCollection();
-      return;
-    }
+    auto current_time =
+        TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks();
+    auto due_items = PopDueExpiryIndexItems(current_time);
 
     std::vector<std::pair<TKey, std::shared_ptr<AutoExpiryConcurrentMapEntry>>>
         elements_to_remove;
 
-    for (auto key : keys) {
-      std::shared_ptr<AutoExpiryConcurrentMapEntry> value;
-      auto execution_result = concurrent_map_.Find(key, value);
-      if (!execution_result.Successful()) {
-        // TODO: log and continue
+    for (auto& item : due_items) {
+      auto value = item.record.lock();
+      // The entry was erased or has been added to the index again since.
+      if (!value || value->expiry_index_generation != item.generation) {
+        continue;
+      }
+
+      std::shared_ptr<AutoExpiryConcurrentMapEntry> current_value;
+      auto execution_result = concurrent_map_.Find(item.key, current_value);
+      if (!execution_result.Successful() || current_value != value) {
         continue;
       }
 
-      std::unique_lock<std::shared_timed_mutex> lock(value->record_lock,
-                                                     std::defer_lock);
-      if (!lock.try_lock()) {
+      bool being_evicted = false;
+      if (!value->being_evicted.compare_exchange_strong(being_evicted, true)) {
+        AddToExpiryIndex(item.key, value);
         continue;
       }
 
+      // Readers update these before checking being_evicted, so they are read
+      // only after marking the entry.
       if (!value->is_evictable || !value->IsExpired()) {
+        value->being_evicted = false;
+        AddToExpiryIndex(item.key, value);
         continue;
       }
 
-      value->being_evicted = true;
-      elements_to_remove.push_back(std::make_pair(key, value));
+      elements_to_remove.push_back(std::make_pair(item.key, value));
     }
 
     if (elements_to_remove.size() == 0) {
@@ -409,16 +436,16 @@ class AutoExpiryConcurrentMap : public ServiceInterface {
       auto execution_result = concurrent_map_.Erase(key);
       if (!execution_result.Successful()) {
         // TODO: Log this.
-        std::unique_lock<std::shared_timed_mutex> lock(
-            std::get<1>(key_value_pair)->record_lock);
         std::get<1>(key_value_pair)->being_evicted = false;
+        AddToExpiryIndex(key, std::get<1>(key_value_pair));
       }
     } else {
       // TODO: Log.
       // Set the loaded flag to true since we dont want to keep it unavailable.
-      std::unique_lock<std::shared_timed_mutex> lock(
-          std::get<1>(key_value_pair)->record_lock);
       std::get<1>(key_value_pair)->being_evicted = false;
+      // The entry is still expired, the next round retries it.
+      AddToExpiryIndex(std::get<0>(key_value_pair),
+                       std::get<1>(key_value_pair));
     }
 
     // Last callback
@@ -429,10 +456,95 @@ class AutoExpiryConcurrentMap : public ServiceInterface {
     ScheduleGarbageCollection();
   }
 
+  /**
+   * @brief Adds the entry to the bucket of the expiry index covering its
+   * current expiration time. Any previous index item of the entry becomes
+   * stale.
+   *
+   * @param key The key of the entry.
+   * @param record The entry.
+   */
+  void AddToExpiryIndex(
+      const TKey& key,
+      const std::shared_ptr<AutoExpiryConcurrentMapEntry>& record) noexcept {
+    ExpiryIndexItem item = {key, record, ++record->expiry_index_generation};
+    auto bucket = GetExpiryBucket(record->expiration_time);
+
+    std::lock_guard<std::mutex> lock(expiry_index_mutex_);
+    expiry_index_[bucket].push_back(std::move(item));
+  }
+
   ConcurrentMap<TKey, std::shared_ptr<AutoExpiryConcurrentMapEntry>, TCompare>
       concurrent_map_;
 
  private:
+  /// An entry of the expiry index.
+  struct ExpiryIndexItem {
+    TKey key;
+    /// Does not keep erased entries alive until their bucket is due.
+    std::weak_ptr<AutoExpiryConcurrentMapEntry> record;
+    /// The expiry index generation of the entry when the item was added.
+    uint64_t generation;
+  };
+
+  static uint64_t GetExpiryBucket(core::Timestamp expiration_time) noexcept {
+    return expiration_time /
+           kAutoExpiryConcurrentMapExpiryBucketDuration.count();
+  }
+
+  /**
+   * @brief Removes the buckets of the expiry index which may contain expired
+   * entries and returns their items.
+   *
+   * @param current_time The current steady time.
+   */
+  std::vector<ExpiryIndexItem> PopDueExpiryIndexItems(
+      core::Timestamp current_time) noexcept {
+    std::vector<ExpiryIndexItem> due_items;
+    auto current_bucket = GetExpiryBucket(current_time);
+
+    std::lock_guard<std::mutex> lock(expiry_index_mutex_);
+    auto due_end = expiry_index_.upper_bound(current_bucket);
+    for (auto it = expiry_index_.begin(); it != due_end; ++it) {
+      if (due_items.empty()) {
+        due_items = std::move(it->second);
+      } else {
+        std::move(it->second.begin(), it->second.end(),
+                  std::back_inserter(due_items));
+      }
+    }
+    expiry_index_.erase(expiry_index_.begin(), due_end);
+    return due_items;
+  }
+
+  /**
+   * @brief Applies the access policies of the map to an existing entry.
+   *
+   * @param record The entry being accessed.
+   * @return ExecutionResult Failure if the access must be blocked because the
+   * entry is being evicted.
+   */
+  ExecutionResult AccessEntry(AutoExpiryConcurrentMapEntry& record) noexcept {
+    if (block_entry_while_eviction_ && record.being_evicted) {
+      return FailureExecutionResult(
+          errors::SC_AUTO_EXPIRY_CONCURRENT_MAP_ENTRY_BEING_DELETED);
+    }
+
+    if (extend_entry_lifetime_on_access_) {
+      auto execution_result =
+          record.ExtendExpiration(map_entry_lifetime_seconds_);
+      // The garbage collector may have marked the entry in the meantime.
+      if (block_entry_while_eviction_ &&
+          execution_result ==
+              FailureExecutionResult(
+                  errors::SC_AUTO_EXPIRY_CONCURRENT_MAP_ENTRY_BEING_DELETED)) {
+        return execution_result;
+      }
+    }
+
+    return SuccessExecutionResult();
+  }
+
   /// The map entry lifetime in seconds.
   const size_t map_entry_lifetime_seconds_;
   // Indicates whether to extend the entries lifetime on access.
@@ -452,5 +564,12 @@ class AutoExpiryConcurrentMap : public ServiceInterface {
   std::mutex sync_mutex;
   /// Indicates whther the component stopped
   bool is_running_;
+  /**
+   * @brief The expiry index. Maps the expiry buckets to the entries whose
+   * expiration time fell in the bucket when they were added to it.
+   */
+  std::map<uint64_t, std::vector<ExpiryIndexItem>> expiry_index_;
+  /// Guards expiry_index_.
+  std::mutex expiry_index_mutex_;
 };
 }  // namespace google::scp::core::common
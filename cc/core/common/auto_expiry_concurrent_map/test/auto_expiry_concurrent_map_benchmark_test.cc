@@ -0,0 +1,116 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "core/async_executor/mock/mock_async_executor.h"
+#include "core/common/auto_expiry_concurrent_map/mock/mock_auto_expiry_concurrent_map.h"
+#include "core/common/time_provider/src/time_provider.h"
+#include "public/core/test/interface/execution_result_matchers.h"
+
+using google::scp::core::async_executor::mock::MockAsyncExecutor;
+using google::scp::core::common::AutoExpiryConcurrentMap;
+using google::scp::core::common::auto_expiry_concurrent_map::mock::
+    MockAutoExpiryConcurrentMap;
+using std::cout;
+using std::endl;
+using std::function;
+using std::make_pair;
+using std::make_shared;
+using std::shared_ptr;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+namespace google::scp::core::common::test {
+class BenchmarkEntry {};
+
+using UnderlyingEntry = AutoExpiryConcurrentMap<
+    int, shared_ptr<BenchmarkEntry>,
+    oneapi::tbb::tbb_hash_compare<int>>::AutoExpiryConcurrentMapEntry;
+
+class AutoExpiryConcurrentMapBenchmarkTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    mock_async_executor_ = make_shared<MockAsyncExecutor>();
+    mock_async_executor_->schedule_for_mock =
+        [&](const AsyncOperation& work, Timestamp,
+            function<bool()>& cancellation_callback) {
+          cancellation_callback = []() { return true; };
+          return SuccessExecutionResult();
+        };
+  }
+
+  /**
+   * @brief Fills a map with map_size entries, expires expired_count of them
+   * and reports how long a garbage collection round takes.
+   */
+  void RunGarbageCollectionWorkload(int map_size, int expired_count) {
+    size_t deleted_count = 0;
+    auto on_before_element_deletion_callback =
+        [&](int&, shared_ptr<BenchmarkEntry>&, function<void(bool)> deleter) {
+          deleted_count++;
+          deleter(true);
+        };
+    MockAutoExpiryConcurrentMap<int, shared_ptr<BenchmarkEntry>>
+        auto_expiry_map(60 /* map_entry_lifetime_seconds */,
+                        true /* extend_entry_lifetime_on_access */,
+                        true /* block_entry_while_eviction */,
+                        on_before_element_deletion_callback,
+                        mock_async_executor_);
+    EXPECT_SUCCESS(auto_expiry_map.Run());
+
+    auto value = make_shared<BenchmarkEntry>();
+    for (int i = 0; i < map_size; i++) {
+      auto pair = make_pair(i, value);
+      EXPECT_SUCCESS(auto_expiry_map.Insert(pair, value));
+    }
+    for (int i = 0; i < expired_count; i++) {
+      shared_ptr<UnderlyingEntry> underlying_entry;
+      auto_expiry_map.GetUnderlyingConcurrentMap().Find(i, underlying_entry);
+      underlying_entry->expiration_time = 0;
+      auto_expiry_map.AddToExpiryIndex(i);
+    }
+
+    auto start_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+    auto_expiry_map.RunGarbageCollector();
+    auto end_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+
+    EXPECT_EQ(deleted_count, expired_count);
+    EXPECT_EQ(auto_expiry_map.Size(), map_size - expired_count);
+    cout << map_size << " entries, " << expired_count << " expired, "
+         << duration_cast<microseconds>(end_ns - start_ns).count()
+         << " microseconds garbage collection pause" << endl;
+    EXPECT_SUCCESS(auto_expiry_map.Stop());
+  }
+
+  shared_ptr<MockAsyncExecutor> mock_async_executor_;
+};
+
+TEST_F(AutoExpiryConcurrentMapBenchmarkTest, PerfTestGarbageCollectionPause) {
+  GTEST_SKIP();
+  for (int map_size : {10000, 100000, 1000000}) {
+    RunGarbageCollectionWorkload(map_size, 0);
+    RunGarbageCollectionWorkload(map_size, 1000);
+  }
+}
+}  // namespace google::scp::core::common::test
@@ -38,13 +38,10 @@ using google::scp::core::common::auto_expiry_concurrent_map::mock::
     MockAutoExpiryConcurrentMap;
 using google::scp::core::test::ResultIs;
 using google::scp::core::test::WaitUntil;
-using std::defer_lock;
 using std::find;
 using std::function;
 using std::make_shared;
-using std::shared_lock;
 using std::shared_ptr;
-using std::shared_timed_mutex;
 using std::static_pointer_cast;
 using std::vector;
 using std::chrono::seconds;
@@ -419,30 +416,105 @@ TEST_F(AutoExpiryConcurrentMapTest, GarbageCollection) {
 
   shared_ptr<UnderlyingEntry> underlying_entry;
   auto_expiry_map.GetUnderlyingConcurrentMap().Find(3, underlying_entry);
-  underlying_entry->expiration_time = 0;
-
-  shared_lock<shared_timed_mutex> lock(underlying_entry->record_lock);
 
+  // Not due yet.
   auto_expiry_map.RunGarbageCollector();
   EXPECT_EQ(keys_to_be_deleted.size(), 0);
 
-  lock.unlock();
+  underlying_entry->expiration_time = 0;
+  auto_expiry_map.AddToExpiryIndex(3);
   underlying_entry->is_evictable = false;
 
   auto_expiry_map.RunGarbageCollector();
   EXPECT_EQ(keys_to_be_deleted.size(), 0);
 
   underlying_entry->expiration_time = UINT64_MAX;
+  auto_expiry_map.AddToExpiryIndex(3);
   auto_expiry_map.RunGarbageCollector();
   EXPECT_EQ(keys_to_be_deleted.size(), 0);
 
   underlying_entry->expiration_time = 0;
   underlying_entry->is_evictable = true;
+  auto_expiry_map.AddToExpiryIndex(3);
   auto_expiry_map.RunGarbageCollector();
   EXPECT_EQ(keys_to_be_deleted.size(), 1);
   EXPECT_EQ(keys_to_be_deleted[0], 3);
 }
 
+TEST_F(AutoExpiryConcurrentMapTest, GarbageCollectionRevisitsExtendedEntries) {
+  vector<int> keys_to_be_deleted;
+  auto on_before_element_deletion_callback_ =
+      [&](int& key, shared_ptr<EmptyEntry>&,
+          function<void(bool can_delete)> deleter) {
+        keys_to_be_deleted.push_back(key);
+      };
+
+  MockAutoExpiryConcurrentMap<int, shared_ptr<EmptyEntry>> auto_expiry_map(
+      cache_lifetime_, true, true, on_before_element_deletion_callback_,
+      mock_async_executor_);
+
+  EXPECT_SUCCESS(auto_expiry_map.Run());
+
+  auto entry = make_shared<EmptyEntry>();
+  auto pair = make_pair(3, entry);
+  EXPECT_SUCCESS(auto_expiry_map.Insert(pair, entry));
+
+  shared_ptr<UnderlyingEntry> underlying_entry;
+  auto_expiry_map.GetUnderlyingConcurrentMap().Find(3, underlying_entry);
+  underlying_entry->expiration_time = 0;
+  auto_expiry_map.AddToExpiryIndex(3);
+
+  // Accessing the entry extends its lifetime, so the due index item moves the
+  // entry to a later bucket.
+  EXPECT_SUCCESS(auto_expiry_map.Find(3, entry));
+  auto_expiry_map.RunGarbageCollector();
+  EXPECT_EQ(keys_to_be_deleted.size(), 0);
+
+  underlying_entry->expiration_time = 0;
+  auto_expiry_map.RunGarbageCollector();
+  EXPECT_EQ(keys_to_be_deleted.size(), 0);
+
+  auto_expiry_map.AddToExpiryIndex(3);
+  auto_expiry_map.RunGarbageCollector();
+  EXPECT_EQ(keys_to_be_deleted.size(), 1);
+}
+
+TEST_F(AutoExpiryConcurrentMapTest, GarbageCollectionSkipsErasedEntries) {
+  vector<int> keys_to_be_deleted;
+  auto on_before_element_deletion_callback_ =
+      [&](int& key, shared_ptr<EmptyEntry>&,
+          function<void(bool can_delete)> deleter) {
+        keys_to_be_deleted.push_back(key);
+      };
+
+  MockAutoExpiryConcurrentMap<int, shared_ptr<EmptyEntry>> auto_expiry_map(
+      cache_lifetime_, true, true, on_before_element_deletion_callback_,
+      mock_async_executor_);
+
+  EXPECT_SUCCESS(auto_expiry_map.Run());
+
+  auto entry = make_shared<EmptyEntry>();
+  auto pair = make_pair(3, entry);
+  EXPECT_SUCCESS(auto_expiry_map.Insert(pair, entry));
+
+  shared_ptr<UnderlyingEntry> underlying_entry;
+  auto_expiry_map.GetUnderlyingConcurrentMap().Find(3, underlying_entry);
+  underlying_entry->expiration_time = 0;
+  auto_expiry_map.AddToExpiryIndex(3);
+
+  // Re-inserting the key after erasing it must not let the old index item
+  // evict the new entry.
+  int key = 3;
+  EXPECT_SUCCESS(auto_expiry_map.Erase(key));
+  EXPECT_SUCCESS(auto_expiry_map.Insert(pair, entry));
+  auto_expiry_map.RunGarbageCollector();
+  EXPECT_EQ(keys_to_be_deleted.size(), 0);
+
+  EXPECT_SUCCESS(auto_expiry_map.Erase(key));
+  auto_expiry_map.RunGarbageCollector();
+  EXPECT_EQ(keys_to_be_deleted.size(), 0);
+}
+
 TEST_F(AutoExpiryConcurrentMapTest, OnRemoveEntryFromCacheLogged) {
   vector<int> keys_to_be_deleted;
   auto on_before_element_deletion_callback_ =
@@ -527,6 +599,7 @@ TEST_F(AutoExpiryConcurrentMapTest, NoDeletionForUnloadedData) {
   auto underlying_pair = make_pair(3, underlying_entry);
   auto_expiry_map.GetUnderlyingConcurrentMap().Insert(underlying_pair,
                                                       underlying_entry);
+  auto_expiry_map.AddToExpiryIndex(3);
   underlying_entry->is_evictable = false;
   EXPECT_SUCCESS(auto_expiry_map.Run());
 
@@ -562,6 +635,7 @@ TEST_F(AutoExpiryConcurrentMapTest, NoDeletionForUnExpired) {
   auto_expiry_map.GetUnderlyingConcurrentMap().Insert(underlying_pair,
                                                       underlying_entry);
   underlying_entry->expiration_time = 999999999999999999;
+  auto_expiry_map.AddToExpiryIndex(3);
 
   EXPECT_SUCCESS(auto_expiry_map.Run());
 
@@ -593,13 +667,16 @@ TEST(AutoExpiryConcurrentMapDeletionTest, DeletionForExpired) {
                                                       underlying_entry);
   underlying_entry->expiration_time = 0;
   underlying_entry->is_evictable = true;
+  auto_expiry_map.AddToExpiryIndex(3);
 
   entry = make_shared<EmptyEntry>();
+  underlying_entry = make_shared<UnderlyingEntry>(entry, 0);
   underlying_pair = make_pair(5, underlying_entry);
   auto_expiry_map.GetUnderlyingConcurrentMap().Insert(underlying_pair,
                                                       underlying_entry);
   underlying_entry->expiration_time = 0;
   underlying_entry->is_evictable = true;
+  auto_expiry_map.AddToExpiryIndex(5);
   EXPECT_SUCCESS(auto_expiry_map.Run());
 
   WaitUntil([&]() { return total_count == 2; });
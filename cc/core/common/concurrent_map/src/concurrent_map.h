@@ -16,17 +16,42 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "oneapi/tbb/concurrent_hash_map.h"
 #include "public/core/interface/execution_result.h"
 
 #include "error_codes.h"
 
 namespace google::scp::core::common {
+/// The default number of shards of a ConcurrentMap in Sharded mode.
+static constexpr size_t kConcurrentMapDefaultShardCount = 64;
+
+/// The synchronization modes of ConcurrentMap.
+enum class ConcurrentMapMode {
+  /**
+   * @brief A single TBB concurrent_hash_map. All the operations share a
+   * map-wide lock, which Keys() takes exclusively.
+   */
+  GlobalLock = 0,
+  /**
+   * @brief The keys are spread over shards, each with its own lock, and no
+   * lock spans the whole map. Each shard also keeps a copy-on-write list of
+   * its keys, so Keys() only holds a shard lock to take a reference to the
+   * list, and the keys are copied with no lock held. A writer copies the list
+   * before changing it only while a Keys() call still refers to it.
+   */
+  Sharded = 1,
+};
+
 /**
  * @brief ConcurrentMap provides multi producers and multi consumers map
  * support to be used generically.
@@ -41,6 +66,24 @@ class ConcurrentMap {
  public:
   // TODO: We might need to look into keeping the size constant.
 
+  /**
+   * @brief Construct a new Concurrent Map object
+   *
+   * @param mode The synchronization mode of the map.
+   * @param shard_count The number of shards in Sharded mode.
+   */
+  explicit ConcurrentMap(
+      ConcurrentMapMode mode = ConcurrentMapMode::GlobalLock,
+      size_t shard_count = kConcurrentMapDefaultShardCount)
+      : mode_(mode) {
+    if (mode_ == ConcurrentMapMode::Sharded) {
+      for (size_t i = 0; i < std::max(shard_count, static_cast<size_t>(1));
+           i++) {
+        shards_.push_back(std::make_unique<Shard>());
+      }
+    }
+  }
+
   /**
    * @brief Inserts an element into a concurrent map. The caller must provider
    * the key value pair to be inserted into the map. However due to concurrency
@@ -56,6 +99,20 @@ class ConcurrentMap {
    * @return ExecutionResult The execution result of the operation.
    */
   ExecutionResult Insert(std::pair<TKey, TValue> key_value, TValue& out_value) {
+    if (mode_ == ConcurrentMapMode::Sharded) {
+      auto& shard = GetShard(key_value.first);
+      std::unique_lock lock(shard.mutex);
+      auto [it, inserted] = shard.map.try_emplace(
+          std::move(key_value.first), ShardEntry{std::move(key_value.second)});
+      out_value = it->second.value;
+      if (!inserted) {
+        return FailureExecutionResult(
+            errors::SC_CONCURRENT_MAP_ENTRY_ALREADY_EXISTS);
+      }
+      AddKey(shard, it);
+      return SuccessExecutionResult();
+    }
+
     std::shared_lock lock(concurrent_map_mutex_);
 
     typename ConcurrentMapImpl::accessor map_accessor;
@@ -81,22 +138,91 @@ class ConcurrentMap {
    * @return ExecutionResult The execution result of the operation.
    */
   ExecutionResult Find(const TKey& key, TValue& out_value) {
+    return FindAndApply(
+        key, [&out_value](const TValue& value) { out_value = value; });
+  }
+
+  /**
+   * @brief Finds an element within the map with the provided key and applies
+   * the function to it in place, instead of copying the value out. The
+   * function runs while the element is locked for reading, so it must be short
+   * and must not access the map. It is called directly, without a
+   * std::function, so Find() does not pay for an indirect call.
+   *
+   * @tparam Function Callable as void(const TValue&).
+   * @param key The key to be found from the map.
+   * @param function The function to apply to the value.
+   * @return ExecutionResult The execution result of the operation.
+   */
+  template <typename Function>
+  ExecutionResult FindAndApply(const TKey& key, Function&& function) {
+    if (mode_ == ConcurrentMapMode::Sharded) {
+      auto& shard = GetShard(key);
+      std::shared_lock lock(shard.mutex);
+      auto it = shard.map.find(key);
+      if (it == shard.map.end()) {
+        return FailureExecutionResult(
+            errors::SC_CONCURRENT_MAP_ENTRY_DOES_NOT_EXIST);
+      }
+      function(it->second.value);
+      return SuccessExecutionResult();
+    }
+
     std::shared_lock lock(concurrent_map_mutex_);
 
-    typename ConcurrentMapImpl::accessor map_accessor;
+    typename ConcurrentMapImpl::const_accessor map_accessor;
     ExecutionResult execution_result = SuccessExecutionResult();
 
     if (!concurrent_map_.find(map_accessor, key)) {
       execution_result = FailureExecutionResult(
           errors::SC_CONCURRENT_MAP_ENTRY_DOES_NOT_EXIST);
     } else {
-      out_value = map_accessor->second;
+      function(map_accessor->second);
     }
 
     map_accessor.release();
     return execution_result;
   }
 
+  /**
+   * @brief Inserts the key value pair if the key does not exist, otherwise
+   * applies the function to the existing value in place. The function runs
+   * while the element is locked for writing, so it must be short and must not
+   * access the map.
+   *
+   * @tparam Function Callable as void(TValue&).
+   * @param key_value A pair of key value to be inserted if the key does not
+   * exist.
+   * @param function The function to apply to the existing value.
+   * @return ExecutionResult The execution result of the operation.
+   */
+  template <typename Function>
+  ExecutionResult Upsert(std::pair<TKey, TValue> key_value,
+                         Function&& function) {
+    if (mode_ == ConcurrentMapMode::Sharded) {
+      auto& shard = GetShard(key_value.first);
+      std::unique_lock lock(shard.mutex);
+      auto [it, inserted] = shard.map.try_emplace(
+          std::move(key_value.first), ShardEntry{std::move(key_value.second)});
+      if (inserted) {
+        AddKey(shard, it);
+      } else {
+        function(it->second.value);
+      }
+      return SuccessExecutionResult();
+    }
+
+    std::shared_lock lock(concurrent_map_mutex_);
+
+    typename ConcurrentMapImpl::accessor map_accessor;
+    if (!concurrent_map_.insert(map_accessor, std::move(key_value))) {
+      function(map_accessor->second);
+    }
+
+    map_accessor.release();
+    return SuccessExecutionResult();
+  }
+
   /**
    * @brief Erases an element from the map with the provided key. If the key
    * does not exist the erase operation will return a proper error code to the
@@ -106,6 +232,19 @@ class ConcurrentMap {
    * @return ExecutionResult The execution result of the operation.
    */
   ExecutionResult Erase(const TKey& key) {
+    if (mode_ == ConcurrentMapMode::Sharded) {
+      auto& shard = GetShard(key);
+      std::unique_lock lock(shard.mutex);
+      auto it = shard.map.find(key);
+      if (it == shard.map.end()) {
+        return FailureExecutionResult(
+            errors::SC_CONCURRENT_MAP_ENTRY_DOES_NOT_EXIST);
+      }
+      RemoveKey(shard, it->second.key_index);
+      shard.map.erase(it);
+      return SuccessExecutionResult();
+    }
+
     std::shared_lock lock(concurrent_map_mutex_);
     ExecutionResult execution_result = SuccessExecutionResult();
 
@@ -118,16 +257,31 @@ class ConcurrentMap {
   }
 
   /**
-   * @brief Gets all the keys in the current concurrent map. This is a very
-   * expensive operation due to locking.
+   * @brief Gets all the keys in the current concurrent map. In GlobalLock mode
+   * this is a very expensive operation due to locking. In Sharded mode the
+   * keys of each shard are copied from a snapshot taken without blocking its
+   * writers, so the result is a consistent snapshot of every shard, but not of
+   * the map as a whole.
    *
    * @param keys A vector of the keys to be filled in once looked up.
    * @return ExecutionResult The execution result of the operation.
    */
   ExecutionResult Keys(std::vector<TKey>& keys) {
+    keys.clear();
+    if (mode_ == ConcurrentMapMode::Sharded) {
+      for (auto& shard : shards_) {
+        std::shared_ptr<const std::vector<TKey>> shard_keys;
+        {
+          std::shared_lock lock(shard->mutex);
+          shard_keys = shard->keys;
+        }
+        keys.insert(keys.end(), shard_keys->begin(), shard_keys->end());
+      }
+      return SuccessExecutionResult();
+    }
+
     std::unique_lock lock(concurrent_map_mutex_);
 
-    keys.clear();
     for (auto it = concurrent_map_.begin(); it != concurrent_map_.end(); ++it) {
       keys.push_back(it->first);
     }
@@ -140,9 +294,98 @@ class ConcurrentMap {
    *
    * @return size_t
    */
-  size_t Size() const { return concurrent_map_.size(); }
+  size_t Size() const {
+    if (mode_ == ConcurrentMapMode::Sharded) {
+      size_t size = 0;
+      for (auto& shard : shards_) {
+        std::shared_lock lock(shard->mutex);
+        size += shard->map.size();
+      }
+      return size;
+    }
+    return concurrent_map_.size();
+  }
 
  private:
+  /// Adapts TCompare to the hasher interface of the hash map of the shards.
+  struct Hash {
+    size_t operator()(const TKey& key) const {
+      // Mixes the hash since it can be the identity for integral keys.
+      return static_cast<uint64_t>(TCompare().hash(key)) *
+             0x9E3779B97F4A7C15ULL;
+    }
+  };
+
+  /// Adapts TCompare to the key equality interface of the hash map of the
+  /// shards.
+  struct KeyEqual {
+    bool operator()(const TKey& left, const TKey& right) const {
+      return TCompare().equal(left, right);
+    }
+  };
+
+  /// An element of a shard, with the position of its key in the key list.
+  struct ShardEntry {
+    TValue value;
+    size_t key_index = 0;
+  };
+
+  /// A shard of the map in Sharded mode.
+  struct Shard {
+    absl::flat_hash_map<TKey, ShardEntry, Hash, KeyEqual> map;
+    /// The keys of the map, shared with the Keys() calls copying them.
+    std::shared_ptr<std::vector<TKey>> keys =
+        std::make_shared<std::vector<TKey>>();
+    mutable std::shared_mutex mutex;
+  };
+
+  using ShardIterator =
+      typename absl::flat_hash_map<TKey, ShardEntry, Hash, KeyEqual>::iterator;
+
+  /// Returns the key list of the shard to be changed, copying it first if a
+  /// Keys() call still refers to it. Must be called under the write lock.
+  static std::vector<TKey>& GetWritableKeys(Shard& shard) {
+    // No new reference can be taken under the write lock, so the count can
+    // only drop and a stale value at most causes an extra copy.
+    if (shard.keys.use_count() > 1) {
+      shard.keys = std::make_shared<std::vector<TKey>>(*shard.keys);
+    } else {
+      // Orders the reads of the Keys() call which released the list before
+      // its writes here.
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *shard.keys;
+  }
+
+  /// Adds the key of a newly inserted element to the key list of the shard.
+  static void AddKey(Shard& shard, ShardIterator it) {
+    auto& keys = GetWritableKeys(shard);
+    it->second.key_index = keys.size();
+    keys.push_back(it->first);
+  }
+
+  /// Removes the key at the index from the key list of the shard, by moving
+  /// the last key in its place.
+  static void RemoveKey(Shard& shard, size_t key_index) {
+    auto& keys = GetWritableKeys(shard);
+    if (key_index + 1 != keys.size()) {
+      keys[key_index] = std::move(keys.back());
+      shard.map.find(keys[key_index])->second.key_index = key_index;
+    }
+    keys.pop_back();
+  }
+
+  Shard& GetShard(const TKey& key) const {
+    // Uses the upper bits, the hash maps of the shards rely on the lower ones.
+    auto hash = static_cast<uint64_t>(Hash()(key));
+    return *shards_[(hash >> 32) % shards_.size()];
+  }
+
+  /// The synchronization mode of the map.
+  const ConcurrentMapMode mode_;
+  /// The shards of the map in Sharded mode.
+  std::vector<std::unique_ptr<Shard>> shards_;
+
   /// Concurrent map implementation.
   ConcurrentMapImpl concurrent_map_;
 
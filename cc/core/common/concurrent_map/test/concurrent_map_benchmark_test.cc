@@ -0,0 +1,140 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/common/concurrent_map/src/concurrent_map.h"
+#include "core/common/time_provider/src/time_provider.h"
+
+using google::scp::core::common::ConcurrentMap;
+using google::scp::core::common::ConcurrentMapMode;
+using google::scp::core::common::TimeProvider;
+using std::atomic;
+using std::cout;
+using std::endl;
+using std::make_pair;
+using std::mt19937;
+using std::string;
+using std::thread;
+using std::uniform_int_distribution;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+
+namespace google::scp::core::common::test {
+class ConcurrentMapBenchmarkTest : public ::testing::Test {
+ protected:
+  /**
+   * @brief Runs operation_count_ operations from thread_count threads, of
+   * which find_percentage percent are Find and the rest are evenly split
+   * between Insert and Erase, and reports the throughput. Another thread lists
+   * the keys of the map every keys_interval_ms milliseconds.
+   */
+  void RunWorkload(ConcurrentMapMode mode, int thread_count,
+                   int find_percentage) {
+    ConcurrentMap<int, string> map(mode);
+    for (int key = 0; key < key_count_; key += 2) {
+      string value;
+      map.Insert(make_pair(key, string(value_size_, 'a')), value);
+    }
+
+    atomic<bool> start = false;
+    atomic<bool> stop = false;
+    auto worker = [&](int id) {
+      mt19937 random(id);
+      uniform_int_distribution<int> key_distribution(0, key_count_ - 1);
+      uniform_int_distribution<int> operation_distribution(0, 99);
+      while (!start) {}
+      for (int i = 0; i < operation_count_ / thread_count; i++) {
+        auto key = key_distribution(random);
+        auto operation = operation_distribution(random);
+        if (operation < find_percentage) {
+          size_t size = 0;
+          map.FindAndApply(key,
+                           [&](const string& value) { size = value.size(); });
+        } else if (operation % 2 == 0) {
+          string value;
+          map.Insert(make_pair(key, string(value_size_, 'a')), value);
+        } else {
+          map.Erase(key);
+        }
+      }
+    };
+    thread keys_thread([&]() {
+      while (!stop) {
+        vector<int> keys;
+        map.Keys(keys);
+        std::this_thread::sleep_for(milliseconds(keys_interval_ms_));
+      }
+    });
+
+    vector<thread> threads;
+    for (int i = 0; i < thread_count; i++) {
+      threads.emplace_back(worker, i);
+    }
+    auto start_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+    start = true;
+    for (auto& worker_thread : threads) {
+      worker_thread.join();
+    }
+    auto end_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+    stop = true;
+    keys_thread.join();
+
+    auto elapsed_ms = duration_cast<milliseconds>(end_ns - start_ns).count();
+    cout << (mode == ConcurrentMapMode::Sharded ? "Sharded" : "GlobalLock")
+         << ", " << thread_count << " threads, " << find_percentage
+         << "% finds, " << elapsed_ms << " milliseconds elapsed, "
+         << static_cast<int64_t>(operation_count_) * 1000 /
+                std::max<int64_t>(elapsed_ms, 1)
+         << " operations/sec" << endl;
+  }
+
+  int key_count_ = 100000;
+  int value_size_ = 64;
+  int operation_count_ = 4000000;
+  int keys_interval_ms_ = 10;
+};
+
+TEST_F(ConcurrentMapBenchmarkTest, PerfTestReadHeavy) {
+  GTEST_SKIP();
+  for (auto mode :
+       {ConcurrentMapMode::GlobalLock, ConcurrentMapMode::Sharded}) {
+    for (int thread_count : {1, 4, 16}) {
+      RunWorkload(mode, thread_count, 95);
+    }
+  }
+}
+
+TEST_F(ConcurrentMapBenchmarkTest, PerfTestMixed) {
+  GTEST_SKIP();
+  for (auto mode :
+       {ConcurrentMapMode::GlobalLock, ConcurrentMapMode::Sharded}) {
+    for (int thread_count : {1, 4, 16}) {
+      RunWorkload(mode, thread_count, 50);
+    }
+  }
+}
+}  // namespace google::scp::core::common::test
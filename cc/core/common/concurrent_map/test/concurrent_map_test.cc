@@ -18,6 +18,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <atomic>
 #include <thread>
 #include <vector>
@@ -28,10 +29,13 @@
 
 using google::scp::core::ExecutionResult;
 using google::scp::core::common::ConcurrentMap;
+using google::scp::core::common::ConcurrentMapMode;
 using google::scp::core::test::ResultIs;
 using google::scp::core::test::ScpTestBase;
 using std::atomic;
+using std::find;
 using std::make_pair;
+using std::sort;
 using std::thread;
 using std::vector;
 using std::this_thread::yield;
@@ -136,4 +140,152 @@ TEST_F(ConcurrentMapTests, GetKeys) {
     EXPECT_EQ(true, false);
   }
 }
+
+TEST_F(ConcurrentMapTests, ShardedInsertFindErase) {
+  ConcurrentMap<int, int> map(ConcurrentMapMode::Sharded, 4);
+
+  int value;
+  EXPECT_SUCCESS(map.Insert(make_pair(1, 1), value));
+  EXPECT_EQ(value, 1);
+  EXPECT_THAT(map.Insert(make_pair(1, 2), value),
+              ResultIs(FailureExecutionResult(
+                  errors::SC_CONCURRENT_MAP_ENTRY_ALREADY_EXISTS)));
+  EXPECT_EQ(value, 1);
+
+  EXPECT_SUCCESS(map.Insert(make_pair(2, 2), value));
+  EXPECT_EQ(map.Size(), 2);
+
+  EXPECT_SUCCESS(map.Find(2, value));
+  EXPECT_EQ(value, 2);
+
+  EXPECT_SUCCESS(map.Erase(2));
+  EXPECT_THAT(map.Erase(2),
+              ResultIs(FailureExecutionResult(
+                  errors::SC_CONCURRENT_MAP_ENTRY_DOES_NOT_EXIST)));
+  EXPECT_THAT(map.Find(2, value),
+              ResultIs(FailureExecutionResult(
+                  errors::SC_CONCURRENT_MAP_ENTRY_DOES_NOT_EXIST)));
+  EXPECT_EQ(map.Size(), 1);
+}
+
+TEST_F(ConcurrentMapTests, ShardedGetKeys) {
+  ConcurrentMap<Uuid, Uuid, UuidCompare> map(ConcurrentMapMode::Sharded);
+
+  vector<Uuid> inserted_keys;
+  for (int i = 0; i < 100; i++) {
+    auto key = Uuid::GenerateUuid();
+    inserted_keys.push_back(key);
+    EXPECT_SUCCESS(map.Insert(make_pair(key, key), key));
+  }
+
+  vector<Uuid> keys;
+  EXPECT_SUCCESS(map.Keys(keys));
+  EXPECT_EQ(keys.size(), inserted_keys.size());
+  for (auto& key : inserted_keys) {
+    EXPECT_NE(find(keys.begin(), keys.end(), key), keys.end());
+  }
+}
+
+TEST_F(ConcurrentMapTests, ShardedGetKeysAfterErase) {
+  ConcurrentMap<int, int> map(ConcurrentMapMode::Sharded, 2);
+
+  int value;
+  for (int key = 0; key < 10; key++) {
+    EXPECT_SUCCESS(map.Insert(make_pair(key, key), value));
+  }
+
+  vector<int> keys_before_erase;
+  EXPECT_SUCCESS(map.Keys(keys_before_erase));
+  for (int key = 0; key < 10; key += 2) {
+    EXPECT_SUCCESS(map.Erase(key));
+  }
+
+  vector<int> keys;
+  EXPECT_SUCCESS(map.Keys(keys));
+  sort(keys.begin(), keys.end());
+  EXPECT_EQ(keys, (vector<int>{1, 3, 5, 7, 9}));
+  EXPECT_EQ(keys_before_erase.size(), 10);
+
+  for (int key = 1; key < 10; key += 2) {
+    EXPECT_SUCCESS(map.Find(key, value));
+    EXPECT_EQ(value, key);
+  }
+}
+
+TEST_F(ConcurrentMapTests, FindAndApply) {
+  for (auto mode :
+       {ConcurrentMapMode::GlobalLock, ConcurrentMapMode::Sharded}) {
+    ConcurrentMap<int, vector<int>> map(mode);
+
+    vector<int> value;
+    EXPECT_SUCCESS(map.Insert(make_pair(1, vector<int>{1, 2, 3}), value));
+
+    size_t size = 0;
+    EXPECT_SUCCESS(map.FindAndApply(
+        1, [&](const vector<int>& value) { size = value.size(); }));
+    EXPECT_EQ(size, 3);
+
+    EXPECT_THAT(map.FindAndApply(2, [&](const vector<int>&) { size = 0; }),
+                ResultIs(FailureExecutionResult(
+                    errors::SC_CONCURRENT_MAP_ENTRY_DOES_NOT_EXIST)));
+    EXPECT_EQ(size, 3);
+  }
+}
+
+TEST_F(ConcurrentMapTests, Upsert) {
+  for (auto mode :
+       {ConcurrentMapMode::GlobalLock, ConcurrentMapMode::Sharded}) {
+    ConcurrentMap<int, int> map(mode);
+
+    auto increment = [](int& value) { value++; };
+    EXPECT_SUCCESS(map.Upsert(make_pair(1, 10), increment));
+
+    int value;
+    EXPECT_SUCCESS(map.Find(1, value));
+    EXPECT_EQ(value, 10);
+
+    EXPECT_SUCCESS(map.Upsert(make_pair(1, 10), increment));
+    EXPECT_SUCCESS(map.Find(1, value));
+    EXPECT_EQ(value, 11);
+  }
+}
+
+TEST_F(ConcurrentMapTests, ShardedConcurrentUpsertAndKeys) {
+  ConcurrentMap<int, int> map(ConcurrentMapMode::Sharded);
+  int thread_count = 4;
+  int key_count = 1000;
+  atomic<bool> stop = false;
+
+  // Snapshots are taken while the writers are running.
+  thread reader([&]() {
+    while (!stop) {
+      vector<int> keys;
+      EXPECT_SUCCESS(map.Keys(keys));
+      EXPECT_LE(keys.size(), key_count);
+      yield();
+    }
+  });
+
+  vector<thread> writers;
+  for (int i = 0; i < thread_count; i++) {
+    writers.emplace_back([&]() {
+      for (int key = 0; key < key_count; key++) {
+        EXPECT_SUCCESS(
+            map.Upsert(make_pair(key, 1), [](int& value) { value++; }));
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  stop = true;
+  reader.join();
+
+  EXPECT_EQ(map.Size(), key_count);
+  for (int key = 0; key < key_count; key++) {
+    int value;
+    EXPECT_SUCCESS(map.Find(key, value));
+    EXPECT_EQ(value, thread_count);
+  }
+}
 }  // namespace google::scp::core::common::test
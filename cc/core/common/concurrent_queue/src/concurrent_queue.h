@@ -18,6 +18,7 @@
 
 #include <atomic>
 #include <memory>
+#include <utility>
 
 #include "oneapi/tbb/concurrent_queue.h"
 
@@ -54,6 +55,18 @@ class ConcurrentQueue {
     return SuccessExecutionResult();
   }
 
+  /**
+   * @brief Same as above but moves the element into the queue, which allows
+   * move-only elements.
+   * @param element the element to be queued.
+   */
+  ExecutionResult TryEnqueue(T&& element) noexcept {
+    if (!queue_->try_push(std::move(element))) {
+      return FailureExecutionResult(errors::SC_CONCURRENT_QUEUE_CANNOT_ENQUEUE);
+    }
+    return SuccessExecutionResult();
+  }
+
   /**
    * @brief Dequeue an element if possible. If there is no element the result
    * will contain the proper error code.
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "error_codes.h"
+
+namespace google::scp::core::common {
+/// The cache line size the hot fields of the ring queue are padded to.
+static constexpr size_t kMpscRingQueueCacheLineSize = 64;
+
+/**
+ * @brief MpscRingQueue is a bounded lock-free ring buffer for multiple
+ * producers and a single consumer. Producers claim slots with a CAS on the
+ * enqueue position and publish them through a per-slot sequence number, the
+ * consumer never contends with them. The enqueue and dequeue positions live on
+ * separate cache lines.
+ *
+ * The buffer is allocated upfront, its size is max_size rounded up to a power
+ * of two, but at most max_size elements are queued at a time.
+ *
+ * TryDequeue must only be called from one thread at a time.
+ */
+template <class T>
+class MpscRingQueue {
+ public:
+  /**
+   * @brief Construct a new Mpsc Ring Queue object
+   * @param max_size Maximum size of the queue
+   */
+  explicit MpscRingQueue(size_t max_size)
+      : max_size_(max_size),
+        mask_(RoundUpToPowerOfTwo(max_size) - 1),
+        cells_(std::make_unique<Cell[]>(mask_ + 1)),
+        enqueue_position_(0),
+        dequeue_position_(0) {
+    for (size_t i = 0; i <= mask_; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpscRingQueue() = delete;
+  MpscRingQueue(const MpscRingQueue&) = delete;
+  MpscRingQueue& operator=(const MpscRingQueue&) = delete;
+
+  /**
+   * @brief Enqueues an element into the queue if possible. This function is
+   * thread-safe.
+   * @param element the element to be queued.
+   */
+  ExecutionResult TryEnqueue(T&& element) noexcept {
+    auto position = enqueue_position_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& cell = cells_[position & mask_];
+      auto sequence = cell.sequence.load(std::memory_order_acquire);
+      auto difference =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+      if (difference == 0) {
+        // The slot is free, but the queue may still be at max_size if it is
+        // not a power of two.
+        if (position - dequeue_position_.load(std::memory_order_acquire) >=
+            max_size_) {
+          break;
+        }
+        if (enqueue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          cell.element = std::move(element);
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return SuccessExecutionResult();
+        }
+      } else if (difference < 0) {
+        // The consumer has not released the slot of the previous lap yet.
+        break;
+      } else {
+        position = enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+    return FailureExecutionResult(errors::SC_CONCURRENT_QUEUE_CANNOT_ENQUEUE);
+  }
+
+  /**
+   * @brief Same as above but copies the element.
+   * @param element the element to be queued.
+   */
+  ExecutionResult TryEnqueue(const T& element) noexcept {
+    T copy(element);
+    return TryEnqueue(std::move(copy));
+  }
+
+  /**
+   * @brief Dequeue an element if possible. If there is no element the result
+   * will contain the proper error code. Elements whose slot is claimed but not
+   * yet published by their producer are not visible.
+   * @param element the element to be dequeued
+   * @return ExecutionResult result of the operation.
+   */
+  ExecutionResult TryDequeue(T& element) noexcept {
+    auto position = dequeue_position_.load(std::memory_order_relaxed);
+    auto& cell = cells_[position & mask_];
+    if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+      return FailureExecutionResult(errors::SC_CONCURRENT_QUEUE_CANNOT_DEQUEUE);
+    }
+    element = std::move(cell.element);
+    cell.element = T();
+    cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+    dequeue_position_.store(position + 1, std::memory_order_release);
+    return SuccessExecutionResult();
+  }
+
+  /**
+   * @brief Provides the size of the elements in the queue. Due to the nature of
+   * the concurrent queue, this value will be approximate. It includes the
+   * elements being published.
+   * @return size_t number of elements in the queue.
+   */
+  size_t Size() const noexcept {
+    auto dequeue_position = dequeue_position_.load(std::memory_order_acquire);
+    return enqueue_position_.load(std::memory_order_acquire) - dequeue_position;
+  }
+
+ private:
+  /// A slot of the ring buffer.
+  struct Cell {
+    /**
+     * @brief Equal to the position of the slot when it is free for the
+     * producer of that position, and to the position plus one once the element
+     * is published for the consumer.
+     */
+    std::atomic<size_t> sequence;
+    T element;
+  };
+
+  static size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  /// Maximum number of queued elements.
+  const size_t max_size_;
+  /// Mask to map a position to its slot.
+  const size_t mask_;
+  /// The slots of the ring buffer.
+  std::unique_ptr<Cell[]> cells_;
+  /// The position the next producer writes to.
+  alignas(kMpscRingQueueCacheLineSize) std::atomic<size_t> enqueue_position_;
+  /// The position the consumer reads from next.
+  alignas(kMpscRingQueueCacheLineSize) std::atomic<size_t> dequeue_position_;
+};
+}  // namespace google::scp::core::common
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core/common/concurrent_queue/src/mpsc_ring_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "core/test/scp_test_base.h"
+#include "public/core/test/interface/execution_result_matchers.h"
+
+using google::scp::core::common::MpscRingQueue;
+using google::scp::core::test::ResultIs;
+using google::scp::core::test::ScpTestBase;
+
+using std::atomic;
+using std::make_unique;
+using std::thread;
+using std::unique_ptr;
+using std::vector;
+using std::this_thread::yield;
+
+namespace google::scp::core::common::test {
+
+class MpscRingQueueTests : public ScpTestBase {};
+
+TEST_F(MpscRingQueueTests, CreateQueueTest) {
+  MpscRingQueue<int> queue(10);
+
+  EXPECT_EQ(queue.Size(), 0);
+}
+
+TEST_F(MpscRingQueueTests, ErrorOnMaxSize) {
+  MpscRingQueue<int> empty_queue(0);
+  EXPECT_THAT(empty_queue.TryEnqueue(1),
+              ResultIs(FailureExecutionResult(
+                  errors::SC_CONCURRENT_QUEUE_CANNOT_ENQUEUE)));
+
+  // The cap is honored even though it is not a power of two.
+  MpscRingQueue<int> queue(3);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_SUCCESS(queue.TryEnqueue(i));
+  }
+  EXPECT_THAT(queue.TryEnqueue(3),
+              ResultIs(FailureExecutionResult(
+                  errors::SC_CONCURRENT_QUEUE_CANNOT_ENQUEUE)));
+  EXPECT_EQ(queue.Size(), 3);
+
+  int element;
+  EXPECT_SUCCESS(queue.TryDequeue(element));
+  EXPECT_EQ(element, 0);
+  EXPECT_SUCCESS(queue.TryEnqueue(3));
+}
+
+TEST_F(MpscRingQueueTests, ErrorOnNoElement) {
+  MpscRingQueue<int> queue(1);
+
+  int i;
+  auto result = queue.TryDequeue(i);
+
+  EXPECT_THAT(result, ResultIs(FailureExecutionResult(
+                          errors::SC_CONCURRENT_QUEUE_CANNOT_DEQUEUE)));
+}
+
+TEST_F(MpscRingQueueTests, WrapsAroundInOrder) {
+  MpscRingQueue<unique_ptr<int>> queue(4);
+
+  for (int i = 0; i < 100; i++) {
+    EXPECT_SUCCESS(queue.TryEnqueue(make_unique<int>(i)));
+    EXPECT_SUCCESS(queue.TryEnqueue(make_unique<int>(i)));
+    unique_ptr<int> element;
+    EXPECT_SUCCESS(queue.TryDequeue(element));
+    EXPECT_EQ(*element, i);
+    EXPECT_SUCCESS(queue.TryDequeue(element));
+    EXPECT_EQ(*element, i);
+  }
+  EXPECT_EQ(queue.Size(), 0);
+}
+
+TEST_F(MpscRingQueueTests, MultiThreadedEnqueue) {
+  MpscRingQueue<int> queue(100);
+  size_t producer_count = 8;
+  int element_count_per_producer = 10000;
+  vector<atomic<int>> last_elements(producer_count);
+  for (auto& last_element : last_elements) {
+    last_element = -1;
+  }
+
+  vector<thread> producers;
+  for (size_t i = 0; i < producer_count; ++i) {
+    producers.emplace_back([i, &queue, element_count_per_producer]() {
+      for (int j = 0; j < element_count_per_producer; j++) {
+        int element = i * element_count_per_producer + j;
+        while (!queue.TryEnqueue(element).Successful()) {
+          yield();
+        }
+      }
+    });
+  }
+
+  // Elements of a given producer come out in the order they were queued.
+  size_t total_element_count = producer_count * element_count_per_producer;
+  for (size_t i = 0; i < total_element_count; i++) {
+    int element;
+    while (!queue.TryDequeue(element).Successful()) {
+      yield();
+    }
+    auto producer = element / element_count_per_producer;
+    EXPECT_LT(last_elements[producer], element);
+    last_elements[producer] = element;
+  }
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  EXPECT_EQ(queue.Size(), 0);
+}
+}  // namespace google::scp::core::common::test
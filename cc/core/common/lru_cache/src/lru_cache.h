@@ -44,11 +44,13 @@ class LruCache {
   TVal& Get(const TKey& key) {
     std::lock_guard lock(data_mutex_);
 
-    auto existing_element = data_[key];
-    auto value = std::get<1>(existing_element);
-    // Set to update the freshness of the element
-    InternalSet(key, value);
-    return std::get<1>(data_[key]);
+    auto& existing_element = data_[key];
+    auto& freshness_iterator = std::get<0>(existing_element);
+    // Move the key to the front of the list to update the freshness of the
+    // element. This keeps the iterator valid and does not copy the value.
+    freshness_list_.splice(freshness_list_.begin(), freshness_list_,
+                           freshness_iterator);
+    return std::get<1>(existing_element);
   }
 
   size_t Size() {
@@ -0,0 +1,245 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
+
+namespace google::scp::core::common {
+/// The default number of shards of a ShardedLruCache.
+static constexpr size_t kShardedLruCacheDefaultShardCount = 16;
+/**
+ * @brief The minimum number of entries per shard. Small caches use fewer
+ * shards so that keys hashing to the same shard do not evict each other while
+ * the cache is far from full.
+ */
+static constexpr size_t kShardedLruCacheMinShardCapacity = 8;
+
+/**
+ * @brief Approximate Least Recently Used (LRU) cache which scales with
+ * concurrent readers.
+ *
+ * The keys are spread over shards, each with its own lock, and reads only take
+ * the lock of their shard in shared mode. Values are stored as
+ * shared_ptr<const TVal> so that reads hand out a reference instead of a copy,
+ * and a value stays valid after it is evicted for as long as it is referenced.
+ *
+ * Recency is tracked with the CLOCK algorithm: a read only sets the reference
+ * bit of the entry, and on eviction a hand sweeps the entries of the shard,
+ * clearing reference bits until it finds an entry which was not read since the
+ * last sweep. When all the entries were read, the oldest insertion is evicted.
+ *
+ * @tparam TKey
+ * @tparam TVal
+ */
+template <typename TKey, typename TVal>
+class ShardedLruCache {
+ public:
+  /**
+   * @brief Construct a new Sharded Lru Cache object.
+   *
+   * @param capacity the maximum number of entries of the cache.
+   * @param shard_count the maximum number of shards. The capacity is split
+   * evenly across the shards.
+   */
+  explicit ShardedLruCache(
+      size_t capacity, size_t shard_count = kShardedLruCacheDefaultShardCount)
+      : capacity_(capacity) {
+    shard_count = std::max(
+        std::min(shard_count, capacity / kShardedLruCacheMinShardCapacity),
+        static_cast<size_t>(1));
+    for (size_t i = 0; i < shard_count; i++) {
+      auto shard_capacity =
+          capacity / shard_count + (i < capacity % shard_count ? 1 : 0);
+      shards_.push_back(std::make_unique<Shard>(shard_capacity));
+    }
+  }
+
+  void Set(const TKey& key, std::shared_ptr<const TVal> value) {
+    GetShard(key).Set(key, std::move(value));
+  }
+
+  void Set(const TKey& key, TVal value) {
+    Set(key, std::make_shared<const TVal>(std::move(value)));
+  }
+
+  /**
+   * @brief Looks up the value of the key and marks the entry as recently
+   * used.
+   *
+   * @return std::shared_ptr<const TVal> the value, null if the key is not in
+   * the cache.
+   */
+  std::shared_ptr<const TVal> Get(const TKey& key) {
+    return GetShard(key).Get(key);
+  }
+
+  size_t Size() {
+    size_t size = 0;
+    for (auto& shard : shards_) {
+      size += shard->Size();
+    }
+    return size;
+  }
+
+  size_t Capacity() { return capacity_; }
+
+  bool Contains(const TKey& key) { return GetShard(key).Contains(key); }
+
+  void Clear() {
+    for (auto& shard : shards_) {
+      shard->Clear();
+    }
+  }
+
+  /// Returns a snapshot of the entries. The shards are visited one at a time.
+  absl::flat_hash_map<TKey, std::shared_ptr<const TVal>> GetAll() {
+    absl::flat_hash_map<TKey, std::shared_ptr<const TVal>> result;
+    for (auto& shard : shards_) {
+      shard->GetAll(result);
+    }
+    return result;
+  }
+
+ private:
+  /// A slot of a shard.
+  struct Entry {
+    TKey key;
+    std::shared_ptr<const TVal> value;
+    /// Set when the entry is read, cleared by the clock hand.
+    std::atomic<bool> referenced{false};
+  };
+
+  /// A shard of the cache, with its own lock and clock.
+  class Shard {
+   public:
+    explicit Shard(size_t capacity)
+        : capacity_(capacity),
+          entries_(std::make_unique<Entry[]>(capacity)),
+          clock_hand_(0) {}
+
+    void Set(const TKey& key, std::shared_ptr<const TVal> value) {
+      std::unique_lock lock(mutex_);
+      if (capacity_ == 0) {
+        return;
+      }
+
+      auto existing = index_.find(key);
+      if (existing != index_.end()) {
+        auto& entry = entries_[existing->second];
+        entry.value = std::move(value);
+        entry.referenced.store(true, std::memory_order_relaxed);
+        return;
+      }
+
+      // Entries are only removed by Clear(), so the first index_.size() slots
+      // are the occupied ones.
+      size_t slot = index_.size();
+      if (slot == capacity_) {
+        slot = Evict();
+      }
+      auto& entry = entries_[slot];
+      entry.key = key;
+      entry.value = std::move(value);
+      entry.referenced.store(false, std::memory_order_relaxed);
+      index_.emplace(key, slot);
+    }
+
+    std::shared_ptr<const TVal> Get(const TKey& key) {
+      std::shared_lock lock(mutex_);
+      auto existing = index_.find(key);
+      if (existing == index_.end()) {
+        return nullptr;
+      }
+      auto& entry = entries_[existing->second];
+      // Avoids dirtying the cache line when the bit is already set.
+      if (!entry.referenced.load(std::memory_order_relaxed)) {
+        entry.referenced.store(true, std::memory_order_relaxed);
+      }
+      return entry.value;
+    }
+
+    bool Contains(const TKey& key) {
+      std::shared_lock lock(mutex_);
+      return index_.contains(key);
+    }
+
+    size_t Size() {
+      std::shared_lock lock(mutex_);
+      return index_.size();
+    }
+
+    void Clear() {
+      std::unique_lock lock(mutex_);
+      for (size_t i = 0; i < index_.size(); i++) {
+        entries_[i].value.reset();
+      }
+      index_.clear();
+      clock_hand_ = 0;
+    }
+
+    void GetAll(
+        absl::flat_hash_map<TKey, std::shared_ptr<const TVal>>& result) {
+      std::shared_lock lock(mutex_);
+      for (auto& kv : index_) {
+        result[kv.first] = entries_[kv.second].value;
+      }
+    }
+
+   private:
+    /// Advances the clock hand to the next entry which was not referenced
+    /// since the last sweep, removes it from the index and returns its slot.
+    size_t Evict() {
+      while (entries_[clock_hand_].referenced.exchange(
+          false, std::memory_order_relaxed)) {
+        clock_hand_ = (clock_hand_ + 1) % capacity_;
+      }
+      auto slot = clock_hand_;
+      clock_hand_ = (clock_hand_ + 1) % capacity_;
+      index_.erase(entries_[slot].key);
+      return slot;
+    }
+
+    const size_t capacity_;
+    /// Maps the keys to their slot in entries_.
+    absl::flat_hash_map<TKey, size_t> index_;
+    std::unique_ptr<Entry[]> entries_;
+    /// The next slot to be considered for eviction.
+    size_t clock_hand_;
+    /// Taken in shared mode for reads, which only touch the atomic reference
+    /// bits of the entries.
+    std::shared_mutex mutex_;
+  };
+
+  Shard& GetShard(const TKey& key) {
+    // Uses the upper bits, the hash maps of the shards rely on the lower ones.
+    auto hash = static_cast<uint64_t>(absl::Hash<TKey>{}(key));
+    return *shards_[(hash >> 32) % shards_.size()];
+  }
+
+  const size_t capacity_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+}  // namespace google::scp::core::common
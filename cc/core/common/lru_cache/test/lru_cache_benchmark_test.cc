@@ -0,0 +1,155 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/common/lru_cache/src/lru_cache.h"
+#include "core/common/lru_cache/src/sharded_lru_cache.h"
+#include "core/common/time_provider/src/time_provider.h"
+
+using google::scp::core::common::TimeProvider;
+using std::atomic;
+using std::cout;
+using std::endl;
+using std::string;
+using std::thread;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+
+namespace google::scp::core::common::test {
+class LruCacheBenchmarkTest : public ::testing::Test {
+ protected:
+  /**
+   * @brief Runs a read-mostly workload, similar to the code object lookups of
+   * the Roma dispatcher, from thread_count threads and reports the throughput.
+   *
+   * @param read_value reads a value from the cache and returns its size.
+   * @param write_value writes a value to the cache.
+   */
+  template <typename ReadFunction, typename WriteFunction>
+  void RunWorkload(size_t thread_count, ReadFunction read_value,
+                   WriteFunction write_value) {
+    for (uint64_t key = 0; key < key_count_; key++) {
+      write_value(key);
+    }
+
+    atomic<bool> start = false;
+    atomic<uint64_t> checksum = 0;
+    vector<thread> threads;
+    for (size_t i = 0; i < thread_count; i++) {
+      threads.emplace_back([&, i]() {
+        while (!start) {}
+        uint64_t local_checksum = 0;
+        uint64_t key = i;
+        for (size_t j = 0; j < operation_count_per_thread_; j++) {
+          key = (key * 6364136223846793005ULL + 1442695040888963407ULL);
+          auto bounded_key = (key >> 33) % key_count_;
+          if (j % write_period_ == 0) {
+            write_value(bounded_key);
+          } else {
+            local_checksum += read_value(bounded_key);
+          }
+        }
+        checksum += local_checksum;
+      });
+    }
+
+    auto start_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+    start = true;
+    for (auto& t : threads) {
+      t.join();
+    }
+    auto end_ns = TimeProvider::GetSteadyTimestampInNanoseconds();
+
+    auto elapsed_ms = duration_cast<milliseconds>(end_ns - start_ns).count();
+    cout << thread_count << " threads, " << elapsed_ms
+         << " milliseconds elapsed, "
+         << thread_count * operation_count_per_thread_ * 1000 /
+                std::max<int64_t>(elapsed_ms, 1)
+         << " operations/sec (checksum " << checksum << ")" << endl;
+  }
+
+  void RunLruCache(size_t thread_count) {
+    LruCache<uint64_t, string> cache(capacity_);
+    RunWorkload(
+        thread_count,
+        [&](uint64_t key) {
+          // Get returns a reference which is only valid until the next write,
+          // so readers have to copy the value.
+          string value = cache.Get(key);
+          return value.size();
+        },
+        [&](uint64_t key) { cache.Set(key, value_); });
+  }
+
+  void RunShardedLruCache(size_t thread_count) {
+    ShardedLruCache<uint64_t, string> cache(capacity_);
+    RunWorkload(
+        thread_count,
+        [&](uint64_t key) {
+          auto value = cache.Get(key);
+          return value ? value->size() : 0;
+        },
+        [&](uint64_t key) { cache.Set(key, value_); });
+  }
+
+  size_t capacity_ = 1000;
+  /// All the keys fit in the cache since LruCache::Get is not safe against a
+  /// concurrent eviction of the key.
+  uint64_t key_count_ = 1000;
+  size_t operation_count_per_thread_ = 500000;
+  size_t write_period_ = 20;
+  /// Values are large, like the source code of code objects.
+  string value_ = string(4096, 'a');
+};
+
+TEST_F(LruCacheBenchmarkTest, LruCache1Thread) {
+  GTEST_SKIP();
+  RunLruCache(1);
+}
+
+TEST_F(LruCacheBenchmarkTest, LruCache4Threads) {
+  GTEST_SKIP();
+  RunLruCache(4);
+}
+
+TEST_F(LruCacheBenchmarkTest, LruCache16Threads) {
+  GTEST_SKIP();
+  RunLruCache(16);
+}
+
+TEST_F(LruCacheBenchmarkTest, ShardedLruCache1Thread) {
+  GTEST_SKIP();
+  RunShardedLruCache(1);
+}
+
+TEST_F(LruCacheBenchmarkTest, ShardedLruCache4Threads) {
+  GTEST_SKIP();
+  RunShardedLruCache(4);
+}
+
+TEST_F(LruCacheBenchmarkTest, ShardedLruCache16Threads) {
+  GTEST_SKIP();
+  RunShardedLruCache(16);
+}
+}  // namespace google::scp::core::common::test
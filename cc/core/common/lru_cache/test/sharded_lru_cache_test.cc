@@ -0,0 +1,190 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core/common/lru_cache/src/sharded_lru_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::atomic;
+using std::make_shared;
+using std::string;
+using std::thread;
+using std::to_string;
+using std::vector;
+
+namespace google::scp::core::common::test {
+TEST(ShardedLruCacheTest, CanAddAndGetElement) {
+  ShardedLruCache<string, string> cache(10);
+  auto key = "Some Key";
+  auto value = "Some value";
+
+  EXPECT_EQ(cache.Get(key), nullptr);
+  cache.Set(key, value);
+
+  EXPECT_TRUE(cache.Contains(key));
+  auto read_value = cache.Get(key);
+  ASSERT_NE(read_value, nullptr);
+  EXPECT_EQ(*read_value, value);
+}
+
+TEST(ShardedLruCacheTest, GetDoesNotCopyTheValue) {
+  ShardedLruCache<string, string> cache(10);
+  auto value = make_shared<const string>("Some value");
+  cache.Set("Some Key", value);
+
+  EXPECT_EQ(cache.Get("Some Key").get(), value.get());
+  EXPECT_EQ(cache.Get("Some Key").get(), cache.Get("Some Key").get());
+}
+
+TEST(ShardedLruCacheTest, ValuesOutliveTheirEviction) {
+  ShardedLruCache<string, string> cache(1);
+  cache.Set("Key1", "Value1");
+  auto read_value = cache.Get("Key1");
+
+  cache.Set("Key2", "Value2");
+  EXPECT_FALSE(cache.Contains("Key1"));
+  EXPECT_EQ(*read_value, "Value1");
+}
+
+TEST(ShardedLruCacheTest, ClearShouldEmptyCache) {
+  ShardedLruCache<string, string> cache(10);
+  cache.Set("Some Key", "Some value");
+  EXPECT_EQ(cache.Size(), 1);
+
+  cache.Clear();
+
+  EXPECT_EQ(cache.Size(), 0);
+  EXPECT_FALSE(cache.Contains("Some Key"));
+
+  cache.Set("Some Key", "Some value");
+  EXPECT_EQ(cache.Size(), 1);
+}
+
+TEST(ShardedLruCacheTest, ShouldReplaceOldestItem) {
+  ShardedLruCache<string, string> cache(5);
+
+  for (int i = 0; i < 5; i++) {
+    auto key = "Some Key" + to_string(i);
+    cache.Set(key, "Some value" + to_string(i));
+    EXPECT_NE(cache.Get(key), nullptr);
+  }
+  EXPECT_EQ(cache.Size(), 5);
+
+  // Every element was read, so the oldest one is evicted.
+  cache.Set("New key", "New Value");
+  EXPECT_TRUE(cache.Contains("New key"));
+  EXPECT_EQ(cache.Size(), 5);
+  EXPECT_FALSE(cache.Contains("Some Key0"));
+  for (int i = 1; i < 5; i++) {
+    EXPECT_EQ(*cache.Get("Some Key" + to_string(i)),
+              "Some value" + to_string(i));
+  }
+}
+
+TEST(ShardedLruCacheTest, LruPolicyShouldBeAffectedByGets) {
+  ShardedLruCache<string, string> cache(2);
+  cache.Set("Key1", "Value1");
+  cache.Set("Key2", "Value2");
+
+  // Touch key1, so that key2 is evicted.
+  EXPECT_EQ(*cache.Get("Key1"), "Value1");
+  cache.Set("Key3", "Value3");
+
+  EXPECT_FALSE(cache.Contains("Key2"));
+  EXPECT_TRUE(cache.Contains("Key1"));
+  EXPECT_TRUE(cache.Contains("Key3"));
+}
+
+TEST(ShardedLruCacheTest, LruPolicyShouldBeAffectedBySets) {
+  ShardedLruCache<string, string> cache(2);
+  cache.Set("Key1", "Value1");
+  cache.Set("Key2", "Value2");
+
+  // Touch key1, so that key2 is evicted.
+  cache.Set("Key1", "NewValue1");
+  cache.Set("Key3", "Value3");
+
+  EXPECT_FALSE(cache.Contains("Key2"));
+  EXPECT_EQ(*cache.Get("Key1"), "NewValue1");
+  EXPECT_TRUE(cache.Contains("Key3"));
+}
+
+TEST(ShardedLruCacheTest, ShouldBeAbleToGetAllItems) {
+  ShardedLruCache<string, string> cache(100);
+  for (int i = 0; i < 50; i++) {
+    cache.Set("Key" + to_string(i), "Value" + to_string(i));
+  }
+
+  auto all_items = cache.GetAll();
+
+  EXPECT_EQ(all_items.size(), 50);
+  for (int i = 0; i < 50; i++) {
+    EXPECT_EQ(*all_items["Key" + to_string(i)], "Value" + to_string(i));
+  }
+}
+
+TEST(ShardedLruCacheTest, ShardedCacheHonorsItsCapacity) {
+  size_t capacity = 1000;
+  ShardedLruCache<int, int> cache(capacity, 16);
+  EXPECT_EQ(cache.Capacity(), capacity);
+
+  for (int i = 0; i < 10000; i++) {
+    cache.Set(i, i);
+    EXPECT_LE(cache.Size(), capacity);
+  }
+  // Every shard is full.
+  EXPECT_EQ(cache.Size(), capacity);
+}
+
+TEST(ShardedLruCacheTest, ConcurrentReadsAndWrites) {
+  ShardedLruCache<int, string> cache(64);
+  atomic<bool> stop = false;
+  atomic<int> mismatch_count = 0;
+
+  // One writer and three readers go over more keys than the cache holds.
+  vector<thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&, i]() {
+      int key = i;
+      while (!stop) {
+        key = (key + 7) % 256;
+        if (i == 0) {
+          cache.Set(key, to_string(key));
+          continue;
+        }
+        auto value = cache.Get(key);
+        if (value && *value != to_string(key)) {
+          mismatch_count++;
+        }
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  stop = true;
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(mismatch_count, 0);
+  EXPECT_LE(cache.Size(), 64);
+}
+}  // namespace google::scp::core::common::test
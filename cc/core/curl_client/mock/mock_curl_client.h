@@ -33,6 +33,10 @@ class MockCurlClient : public HttpClientInterface {
   MOCK_METHOD(ExecutionResult, PerformRequest,
               ((AsyncContext<HttpRequest, HttpResponse>&)),
               (override, noexcept));
+
+  MOCK_METHOD(ExecutionResult, PerformStreamingRequest,
+              ((ConsumerStreamingContext<HttpRequest, HttpResponse>&)),
+              (override, noexcept));
 };
 
 }  // namespace google::scp::core::test
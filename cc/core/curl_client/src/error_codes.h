@@ -83,4 +83,30 @@ DEFINE_ERROR_CODE(SC_CURL_CLIENT_REQUEST_BAD_REGEX_PARSING, SC_CURL_CLIENT,
                   0x0010, "Response code could not be parsed",
                   HttpStatusCode::BAD_REQUEST);
 
+DEFINE_ERROR_CODE(SC_CURL_CLIENT_RESPONSE_STREAM_ABORTED, SC_CURL_CLIENT,
+                  0x0011, "Streaming the response body was aborted",
+                  HttpStatusCode::BAD_REQUEST);
+
+DEFINE_ERROR_CODE(SC_CURL_CLIENT_CURL_MULTI_INIT_ERROR, SC_CURL_CLIENT, 0x0012,
+                  "Initializing the CURL multi engine failed",
+                  HttpStatusCode::BAD_REQUEST);
+
+DEFINE_ERROR_CODE(SC_CURL_CLIENT_CURL_MULTI_ENGINE_NOT_RUNNING, SC_CURL_CLIENT,
+                  0x0013, "The CURL multi engine is not running",
+                  HttpStatusCode::SERVICE_UNAVAILABLE);
+
+DEFINE_ERROR_CODE(SC_CURL_CLIENT_CURL_MULTI_ENGINE_STOPPED, SC_CURL_CLIENT,
+                  0x0014, "The CURL multi engine stopped before the request "
+                  "completed",
+                  HttpStatusCode::SERVICE_UNAVAILABLE);
+
+DEFINE_ERROR_CODE(SC_CURL_CLIENT_CURL_MULTI_ADD_HANDLE_ERROR, SC_CURL_CLIENT,
+                  0x0015, "Adding the request to the CURL multi engine failed",
+                  HttpStatusCode::BAD_REQUEST);
+
+DEFINE_ERROR_CODE(SC_CURL_CLIENT_RESPONSE_QUEUE_FULL, SC_CURL_CLIENT, 0x0016,
+                  "The consumer of the streamed response did not keep up "
+                  "with the response body",
+                  HttpStatusCode::SERVICE_UNAVAILABLE);
+
 }  // namespace google::scp::core::errors
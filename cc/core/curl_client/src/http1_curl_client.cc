@@ -15,47 +15,90 @@
  */
 #include "http1_curl_client.h"
 
+#include <cstring>
 #include <utility>
 
+#include "core/common/time_provider/src/time_provider.h"
+
 #include "http1_curl_wrapper.h"
 
 using google::scp::core::common::RetryStrategy;
 using google::scp::core::common::RetryStrategyType;
+using google::scp::core::common::TimeProvider;
 using std::make_shared;
+using std::make_unique;
 using std::move;
 using std::shared_ptr;
 
 namespace {
 constexpr char kHttp1CurlClient[] = "Http1CurlClient";
-}
+}  // namespace
 
 namespace google::scp::core {
+namespace {
+/**
+ * @brief Whether a push to the full response queue of the streaming context
+ * may be tried again once the consumer caught up, which is until the context
+ * is over.
+ */
+bool CanWaitForConsumer(
+    ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context) {
+  return !streaming_context.IsCancelled() &&
+         !streaming_context.IsMarkedDone() &&
+         TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks() <
+             streaming_context.expiration_time;
+}
+}  // namespace
 
 Http1CurlClient::Http1CurlClient(
     const shared_ptr<AsyncExecutorInterface>& cpu_async_executor,
     const shared_ptr<AsyncExecutorInterface>& io_async_executor,
     shared_ptr<Http1CurlWrapperProvider> curl_wrapper_provider,
-    common::RetryStrategyOptions retry_strategy_options)
-    : curl_wrapper_provider_(curl_wrapper_provider),
+    common::RetryStrategyOptions retry_strategy_options,
+    Http1CurlClientMode mode)
+    : mode_(mode),
+      curl_wrapper_provider_(curl_wrapper_provider),
       cpu_async_executor_(cpu_async_executor),
       io_async_executor_(io_async_executor),
       operation_dispatcher_(io_async_executor,
-                            RetryStrategy(retry_strategy_options)) {}
+                            RetryStrategy(retry_strategy_options)) {
+  if (mode_ == Http1CurlClientMode::Multi) {
+    multi_engine_ = make_unique<Http1CurlMultiEngine>(cpu_async_executor,
+                                                      curl_wrapper_provider);
+  }
+}
 
 ExecutionResult Http1CurlClient::Init() noexcept {
+  if (multi_engine_) {
+    return multi_engine_->Init();
+  }
   return SuccessExecutionResult();
 }
 
 ExecutionResult Http1CurlClient::Run() noexcept {
+  if (multi_engine_) {
+    return multi_engine_->Run();
+  }
   return SuccessExecutionResult();
 }
 
 ExecutionResult Http1CurlClient::Stop() noexcept {
+  if (multi_engine_) {
+    return multi_engine_->Stop();
+  }
   return SuccessExecutionResult();
 }
 
 ExecutionResult Http1CurlClient::PerformRequest(
     AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept {
+  if (multi_engine_) {
+    operation_dispatcher_.Dispatch<AsyncContext<HttpRequest, HttpResponse>>(
+        http_context, [this](auto& http_context) {
+          return multi_engine_->Execute(http_context);
+        });
+    return SuccessExecutionResult();
+  }
+
   auto wrapper_or = curl_wrapper_provider_->MakeWrapper();
   RETURN_IF_FAILURE(wrapper_or.result());
   operation_dispatcher_.Dispatch<AsyncContext<HttpRequest, HttpResponse>>(
@@ -78,4 +121,130 @@ ExecutionResult Http1CurlClient::PerformRequest(
   return SuccessExecutionResult();
 }
 
+ExecutionResult Http1CurlClient::PerformStreamingRequest(
+    ConsumerStreamingContext<HttpRequest, HttpResponse>&
+        streaming_context) noexcept {
+  shared_ptr<Http1CurlWrapper> wrapper;
+  if (!multi_engine_) {
+    auto wrapper_or = curl_wrapper_provider_->MakeWrapper();
+    RETURN_IF_FAILURE(wrapper_or.result());
+    wrapper = move(*wrapper_or);
+  }
+  operation_dispatcher_.DispatchConsumerStreaming<HttpRequest, HttpResponse>(
+      streaming_context, [this, wrapper](auto& streaming_context) {
+        auto response_stream = make_shared<ResponseStream>();
+        auto request = make_shared<HttpRequest>(*streaming_context.request);
+        request->response_body_chunk_callback =
+            [this, streaming_context, response_stream](
+                const HttpResponse& response, const uint8_t* data,
+                size_t chunk_length) mutable {
+              return OnStreamingResponseBodyChunk(
+                  streaming_context, response_stream, response, data,
+                  chunk_length);
+            };
+
+        if (multi_engine_) {
+          AsyncContext<HttpRequest, HttpResponse> http_context(
+              move(request),
+              [this, streaming_context,
+               response_stream](auto& http_context) mutable {
+                OnStreamingRequestCompleted(streaming_context, *response_stream,
+                                            http_context.result);
+              },
+              streaming_context);
+          return multi_engine_->Execute(http_context);
+        }
+
+        auto response_or = wrapper->PerformRequest(*request);
+        OnStreamingRequestCompleted(streaming_context, *response_stream,
+                                    response_or.result());
+        return SuccessExecutionResult();
+      });
+  return SuccessExecutionResult();
+}
+
+HttpResponseBodyChunkAction Http1CurlClient::OnStreamingResponseBodyChunk(
+    ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+    const shared_ptr<ResponseStream>& response_stream,
+    const HttpResponse& response, const uint8_t* data,
+    size_t chunk_length) noexcept {
+  // The end of the body only yields a response if the body was empty, so that
+  // the consumer still receives the headers.
+  if (chunk_length == 0 && response_stream->has_pushed_response) {
+    return HttpResponseBodyChunkAction::Continue;
+  }
+  HttpResponse chunk;
+  chunk.code = response.code;
+  chunk.headers = response.headers;
+  chunk.body = BytesBuffer(chunk_length);
+  if (chunk_length > 0) {
+    memcpy(chunk.body.bytes->data(), data, chunk_length);
+  }
+  chunk.body.length = chunk_length;
+
+  response_stream->push_result = streaming_context.TryPushResponse(chunk);
+  if (!response_stream->push_result.Successful() &&
+      CanWaitForConsumer(streaming_context)) {
+    if (multi_engine_ && chunk_length > 0) {
+      // The event loop must not block, the transfer holds the chunk back until
+      // the consumer processed a response.
+      response_stream->push_result = SuccessExecutionResult();
+      response_stream->is_paused = true;
+      return HttpResponseBodyChunkAction::Pause;
+    }
+    // curl_easy_perform cannot be resumed from another thread, and waiting
+    // here would hold the io thread, so the stream fails instead.
+    response_stream->push_result =
+        FailureExecutionResult(errors::SC_CURL_CLIENT_RESPONSE_QUEUE_FULL);
+  }
+  if (!response_stream->push_result.Successful()) {
+    SCP_ERROR_CONTEXT(kHttp1CurlClient, streaming_context,
+                      response_stream->push_result,
+                      "Failed to push the response body chunk.");
+    return HttpResponseBodyChunkAction::Abort;
+  }
+  response_stream->has_pushed_response = true;
+
+  response_stream->push_result = cpu_async_executor_->Schedule(
+      [this, streaming_context, response_stream]() mutable {
+        streaming_context.ProcessNextMessage();
+        if (response_stream->is_paused.exchange(false)) {
+          multi_engine_->ResumeTransfers();
+        }
+      },
+      AsyncPriority::Normal);
+  if (!response_stream->push_result.Successful()) {
+    SCP_ERROR_CONTEXT(kHttp1CurlClient, streaming_context,
+                      response_stream->push_result,
+                      "Failed to schedule processing the response body chunk.");
+    return HttpResponseBodyChunkAction::Abort;
+  }
+  return HttpResponseBodyChunkAction::Continue;
+}
+
+void Http1CurlClient::OnStreamingRequestCompleted(
+    ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+    const ResponseStream& response_stream, ExecutionResult result) noexcept {
+  if (!response_stream.push_result.Successful()) {
+    result = response_stream.push_result;
+  }
+
+  if (!result.Successful()) {
+    SCP_ERROR_CONTEXT(kHttp1CurlClient, streaming_context, result,
+                      "Streaming the response failed.");
+  }
+  if (result.status == ExecutionStatus::Retry) {
+    if (!response_stream.has_pushed_response) {
+      // Nothing reached the consumer yet, the dispatcher retries the request.
+      streaming_context.result = result;
+      streaming_context.Finish();
+      return;
+    }
+    // Retrying would hand the consumer the start of the body again.
+    result = FailureExecutionResult(result.status_code);
+  }
+
+  FinishStreamingContext(result, streaming_context, cpu_async_executor_);
+}
+
 }  // namespace google::scp::core
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 
 #include "cc/core/interface/async_context.h"
@@ -25,9 +26,20 @@
 #include "public/core/interface/execution_result.h"
 
 #include "error_codes.h"
+#include "http1_curl_multi_engine.h"
 #include "http1_curl_wrapper.h"
 
 namespace google::scp::core {
+/// How Http1CurlClient performs the requests.
+enum class Http1CurlClientMode {
+  /// Each request blocks a thread of the io executor in curl_easy_perform, on
+  /// a new CURL handle.
+  Blocking = 0,
+  /// The requests are multiplexed onto the event loop thread of a
+  /// Http1CurlMultiEngine, which reuses the CURL handles and the connections.
+  Multi = 1,
+};
+
 
 /*! @copydoc HttpClientInterface
  *  This client is explicitly an HTTP1 client, not HTTP2.
@@ -42,6 +54,7 @@ class Http1CurlClient : public HttpClientInterface {
    * @param time_duraton_ms delay time duration in ms for http client retry
    * strategy.
    * @param total_retries total retry counts.
+   * @param mode how the requests are performed.
    */
   explicit Http1CurlClient(
       const std::shared_ptr<AsyncExecutorInterface>& cpu_async_executor,
@@ -51,7 +64,8 @@ class Http1CurlClient : public HttpClientInterface {
       common::RetryStrategyOptions retry_strategy_options =
           common::RetryStrategyOptions(common::RetryStrategyType::Exponential,
                                        kDefaultRetryStrategyDelayInMs,
-                                       kDefaultRetryStrategyMaxRetries));
+                                       kDefaultRetryStrategyMaxRetries),
+      Http1CurlClientMode mode = Http1CurlClientMode::Blocking);
 
   ExecutionResult Init() noexcept override;
   ExecutionResult Run() noexcept override;
@@ -60,13 +74,62 @@ class Http1CurlClient : public HttpClientInterface {
   ExecutionResult PerformRequest(
       AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept override;
 
+  /**
+   * @copydoc HttpClientInterface::PerformStreamingRequest
+   * In the Blocking mode, the stream fails with
+   * SC_CURL_CLIENT_RESPONSE_QUEUE_FULL if the response queue of the context is
+   * full, as the io thread must not wait for the consumer. In the Multi mode,
+   * the transfer is paused instead and resumed once the consumer processed a
+   * response.
+   */
+  ExecutionResult PerformStreamingRequest(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>&
+          streaming_context) noexcept override;
+
  private:
+  /// The state of a streamed response across its body chunks.
+  struct ResponseStream {
+    /// True once a response was pushed to the streaming context.
+    bool has_pushed_response = false;
+    /// The result of the last push, the stream is aborted on failure.
+    ExecutionResult push_result = SuccessExecutionResult();
+    /// True while the transfer is paused for the consumer to catch up.
+    std::atomic<bool> is_paused{false};
+  };
+
+  /**
+   * @brief Is called for each chunk of a streamed response body. Pushes the
+   * chunk to the streaming context and schedules its processing. In the Multi
+   * mode, pauses the transfer while the response queue of the context is full,
+   * in the Blocking mode, aborts it.
+   *
+   * @return HttpResponseBodyChunkAction Continue if the chunk was pushed, Pause
+   * if the queue is full, Abort if the stream must be aborted.
+   */
+  HttpResponseBodyChunkAction OnStreamingResponseBodyChunk(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+      const std::shared_ptr<ResponseStream>& response_stream,
+      const HttpResponse& response, const uint8_t* data,
+      size_t chunk_length) noexcept;
+
+  /**
+   * @brief Finishes the streaming context with the result of its request, or
+   * hands it back to the dispatcher for a retry if nothing was pushed to the
+   * context yet.
+   */
+  void OnStreamingRequestCompleted(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+      const ResponseStream& response_stream, ExecutionResult result) noexcept;
+
+  const Http1CurlClientMode mode_;
   std::shared_ptr<Http1CurlWrapperProvider> curl_wrapper_provider_;
 
   const std::shared_ptr<AsyncExecutorInterface> cpu_async_executor_,
       io_async_executor_;
   /// Operation dispatcher
   common::OperationDispatcher operation_dispatcher_;
+  /// The engine performing the requests in the Multi mode.
+  std::unique_ptr<Http1CurlMultiEngine> multi_engine_;
 };
 
 }  // namespace google::scp::core
@@ -0,0 +1,393 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "http1_curl_multi_engine.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <mutex>
+#include <utility>
+
+#include "core/common/global_logger/src/global_logger.h"
+#include "core/common/uuid/src/uuid.h"
+
+#include "error_codes.h"
+
+using google::scp::core::common::kZeroUuid;
+using std::make_shared;
+using std::make_unique;
+using std::max;
+using std::move;
+using std::nullopt;
+using std::shared_lock;
+using std::shared_ptr;
+using std::thread;
+using std::unique_lock;
+using std::unique_ptr;
+using std::chrono::ceil;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace {
+constexpr char kHttp1CurlMultiEngine[] = "Http1CurlMultiEngine";
+/// The maximum number of events handled per wait of the event loop.
+constexpr int kMaxEpollEvents = 256;
+}  // namespace
+
+namespace google::scp::core {
+Http1CurlMultiEngine::Http1CurlMultiEngine(
+    const shared_ptr<AsyncExecutorInterface>& async_executor,
+    shared_ptr<Http1CurlWrapperProvider> curl_wrapper_provider,
+    size_t max_connections_per_host, size_t max_pooled_handles)
+    : async_executor_(async_executor),
+      curl_wrapper_provider_(move(curl_wrapper_provider)),
+      max_connections_per_host_(max_connections_per_host),
+      max_pooled_handles_(max_pooled_handles),
+      pending_contexts_(kHttp1CurlMultiEnginePendingQueueSize),
+      is_running_(false),
+      is_resume_requested_(false),
+      multi_handle_(nullptr),
+      epoll_fd_(-1),
+      wake_up_fd_(-1) {}
+
+Http1CurlMultiEngine::~Http1CurlMultiEngine() {
+  if (is_running_) {
+    Stop();
+  }
+  if (multi_handle_) {
+    curl_multi_cleanup(multi_handle_);
+  }
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+  }
+  if (wake_up_fd_ >= 0) {
+    close(wake_up_fd_);
+  }
+}
+
+ExecutionResult Http1CurlMultiEngine::Init() noexcept {
+  multi_handle_ = curl_multi_init();
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  wake_up_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (!multi_handle_ || epoll_fd_ < 0 || wake_up_fd_ < 0) {
+    auto result =
+        FailureExecutionResult(errors::SC_CURL_CLIENT_CURL_MULTI_INIT_ERROR);
+    SCP_ERROR(kHttp1CurlMultiEngine, kZeroUuid, result,
+              "Failed to initialize the CURL multi handle or epoll.");
+    return result;
+  }
+
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = wake_up_fd_;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_up_fd_, &event) != 0) {
+    auto result =
+        FailureExecutionResult(errors::SC_CURL_CLIENT_CURL_MULTI_INIT_ERROR);
+    SCP_ERROR(kHttp1CurlMultiEngine, kZeroUuid, result,
+              "Failed to watch the wake up event.");
+    return result;
+  }
+
+  curl_multi_setopt(multi_handle_, CURLMOPT_SOCKETFUNCTION, OnSocketUpdate);
+  curl_multi_setopt(multi_handle_, CURLMOPT_SOCKETDATA, this);
+  curl_multi_setopt(multi_handle_, CURLMOPT_TIMERFUNCTION, OnTimerUpdate);
+  curl_multi_setopt(multi_handle_, CURLMOPT_TIMERDATA, this);
+  curl_multi_setopt(multi_handle_, CURLMOPT_MAX_HOST_CONNECTIONS,
+                    static_cast<long>(max_connections_per_host_));  // NOLINT
+  // Keeps as many idle connections alive as there are pooled handles.
+  curl_multi_setopt(multi_handle_, CURLMOPT_MAXCONNECTS,
+                    static_cast<long>(max_pooled_handles_));  // NOLINT
+  return SuccessExecutionResult();
+}
+
+ExecutionResult Http1CurlMultiEngine::Run() noexcept {
+  unique_lock lock(running_mutex_);
+  is_running_ = true;
+  event_loop_thread_ = make_unique<thread>([this]() { RunEventLoop(); });
+  return SuccessExecutionResult();
+}
+
+ExecutionResult Http1CurlMultiEngine::Stop() noexcept {
+  {
+    unique_lock lock(running_mutex_);
+    is_running_ = false;
+  }
+  WakeUp();
+  if (event_loop_thread_ && event_loop_thread_->joinable()) {
+    event_loop_thread_->join();
+  }
+
+  // No request can be queued anymore, and the event loop is done with the
+  // transfers.
+  auto result =
+      FailureExecutionResult(errors::SC_CURL_CLIENT_CURL_MULTI_ENGINE_STOPPED);
+  for (auto& [handle, transfer] : transfers_) {
+    curl_multi_remove_handle(multi_handle_, handle);
+    SCP_ERROR_CONTEXT(kHttp1CurlMultiEngine, transfer->http_context, result,
+                      "The request is dropped as the engine stopped.");
+    FinishContext(result, transfer->http_context, async_executor_);
+  }
+  transfers_.clear();
+
+  AsyncContext<HttpRequest, HttpResponse> http_context;
+  while (pending_contexts_.TryDequeue(http_context).Successful()) {
+    SCP_ERROR_CONTEXT(kHttp1CurlMultiEngine, http_context, result,
+                      "The request is dropped as the engine stopped.");
+    FinishContext(result, http_context, async_executor_);
+  }
+  return SuccessExecutionResult();
+}
+
+ExecutionResult Http1CurlMultiEngine::Execute(
+    AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept {
+  {
+    shared_lock lock(running_mutex_);
+    if (!is_running_) {
+      return FailureExecutionResult(
+          errors::SC_CURL_CLIENT_CURL_MULTI_ENGINE_NOT_RUNNING);
+    }
+    RETURN_IF_FAILURE(pending_contexts_.TryEnqueue(http_context));
+  }
+  WakeUp();
+  return SuccessExecutionResult();
+}
+
+void Http1CurlMultiEngine::ResumeTransfers() noexcept {
+  is_resume_requested_ = true;
+  WakeUp();
+}
+
+void Http1CurlMultiEngine::WakeUp() noexcept {
+  uint64_t value = 1;
+  // The counter only fails to be incremented when it would overflow, in which
+  // case the event loop is already due to wake up.
+  if (write(wake_up_fd_, &value, sizeof(value)) < 0) {}
+}
+
+void Http1CurlMultiEngine::RunEventLoop() noexcept {
+  epoll_event events[kMaxEpollEvents];
+  int running_transfer_count = 0;
+  while (is_running_) {
+    int timeout_ms = -1;
+    for (const auto& deadline : {timer_deadline_, paused_retry_deadline_}) {
+      if (!deadline) {
+        continue;
+      }
+      int deadline_timeout_ms = max<int64_t>(
+          ceil<milliseconds>(*deadline - steady_clock::now()).count(), 0);
+      if (timeout_ms < 0 || deadline_timeout_ms < timeout_ms) {
+        timeout_ms = deadline_timeout_ms;
+      }
+    }
+
+    auto event_count =
+        epoll_wait(epoll_fd_, events, kMaxEpollEvents, timeout_ms);
+    for (int i = 0; i < event_count; i++) {
+      if (events[i].data.fd == wake_up_fd_) {
+        uint64_t value;
+        if (read(wake_up_fd_, &value, sizeof(value)) < 0) {}
+        StartPendingTransfers();
+        continue;
+      }
+
+      int action = 0;
+      if (events[i].events & EPOLLIN) {
+        action |= CURL_CSELECT_IN;
+      }
+      if (events[i].events & EPOLLOUT) {
+        action |= CURL_CSELECT_OUT;
+      }
+      if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+        action |= CURL_CSELECT_ERR;
+      }
+      curl_multi_socket_action(multi_handle_, events[i].data.fd, action,
+                               &running_transfer_count);
+    }
+
+    if (timer_deadline_ && steady_clock::now() >= *timer_deadline_) {
+      timer_deadline_ = nullopt;
+      curl_multi_socket_action(multi_handle_, CURL_SOCKET_TIMEOUT, 0,
+                               &running_transfer_count);
+    }
+
+    ResumePausedTransfers();
+    ProcessCompletedTransfers();
+  }
+}
+
+void Http1CurlMultiEngine::ResumePausedTransfers() noexcept {
+  auto now = steady_clock::now();
+  auto is_resume_due =
+      is_resume_requested_.exchange(false) ||
+      (paused_retry_deadline_ && now >= *paused_retry_deadline_);
+  auto has_paused_transfers = false;
+  for (auto& [handle, transfer] : transfers_) {
+    if (!transfer->wrapper->IsResponseStreamPaused()) {
+      continue;
+    }
+    if (is_resume_due) {
+      transfer->wrapper->ResumeResponseStream();
+    }
+    has_paused_transfers |= transfer->wrapper->IsResponseStreamPaused();
+  }
+
+  if (!has_paused_transfers) {
+    paused_retry_deadline_ = nullopt;
+  } else if (is_resume_due || !paused_retry_deadline_) {
+    paused_retry_deadline_ =
+        now + kHttp1CurlMultiEnginePausedTransferRetryInterval;
+  }
+}
+
+void Http1CurlMultiEngine::StartPendingTransfers() noexcept {
+  AsyncContext<HttpRequest, HttpResponse> http_context;
+  while (pending_contexts_.TryDequeue(http_context).Successful()) {
+    StartTransfer(http_context);
+  }
+}
+
+void Http1CurlMultiEngine::StartTransfer(
+    AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept {
+  auto wrapper_or = AcquireWrapper();
+  if (!wrapper_or.Successful()) {
+    FinishContext(wrapper_or.result(), http_context, async_executor_);
+    return;
+  }
+
+  auto transfer = make_unique<Transfer>();
+  transfer->wrapper = move(*wrapper_or);
+  transfer->http_context = http_context;
+  // The request is kept alive by the context of the transfer.
+  auto execution_result =
+      transfer->wrapper->PrepareRequest(*transfer->http_context.request);
+  if (!execution_result.Successful()) {
+    ReleaseWrapper(move(transfer->wrapper));
+    FinishContext(execution_result, http_context, async_executor_);
+    return;
+  }
+
+  auto* handle = transfer->wrapper->GetHandle();
+  auto code = curl_multi_add_handle(multi_handle_, handle);
+  if (code != CURLM_OK) {
+    execution_result = RetryExecutionResult(
+        errors::SC_CURL_CLIENT_CURL_MULTI_ADD_HANDLE_ERROR);
+    SCP_ERROR_CONTEXT(kHttp1CurlMultiEngine, http_context, execution_result,
+                      "Failed to add the request to the multi handle: %s",
+                      curl_multi_strerror(code));
+    ReleaseWrapper(move(transfer->wrapper));
+    FinishContext(execution_result, http_context, async_executor_);
+    return;
+  }
+  transfers_.emplace(handle, move(transfer));
+}
+
+void Http1CurlMultiEngine::ProcessCompletedTransfers() noexcept {
+  int queued_message_count = 0;
+  while (auto* message =
+             curl_multi_info_read(multi_handle_, &queued_message_count)) {
+    if (message->msg != CURLMSG_DONE) {
+      continue;
+    }
+    auto* handle = message->easy_handle;
+    auto perform_result = message->data.result;
+    curl_multi_remove_handle(multi_handle_, handle);
+
+    auto transfer = transfers_.find(handle);
+    if (transfer == transfers_.end()) {
+      continue;
+    }
+    auto completed_transfer = move(transfer->second);
+    transfers_.erase(transfer);
+    FinishTransfer(*completed_transfer, perform_result);
+  }
+}
+
+void Http1CurlMultiEngine::FinishTransfer(Transfer& transfer,
+                                          CURLcode perform_result) noexcept {
+  auto response_or = transfer.wrapper->CompleteRequest(perform_result);
+  ReleaseWrapper(move(transfer.wrapper));
+  if (!response_or.Successful()) {
+    FinishContext(response_or.result(), transfer.http_context,
+                  async_executor_);
+    return;
+  }
+  transfer.http_context.response =
+      make_shared<HttpResponse>(move(*response_or));
+  FinishContext(SuccessExecutionResult(), transfer.http_context,
+                async_executor_);
+}
+
+ExecutionResultOr<shared_ptr<Http1CurlWrapper>>
+Http1CurlMultiEngine::AcquireWrapper() noexcept {
+  if (idle_wrappers_.empty()) {
+    return curl_wrapper_provider_->MakeWrapper();
+  }
+  auto wrapper = move(idle_wrappers_.back());
+  idle_wrappers_.pop_back();
+  return wrapper;
+}
+
+void Http1CurlMultiEngine::ReleaseWrapper(
+    shared_ptr<Http1CurlWrapper> wrapper) noexcept {
+  if (idle_wrappers_.size() >= max_pooled_handles_) {
+    return;
+  }
+  wrapper->Reset();
+  idle_wrappers_.push_back(move(wrapper));
+}
+
+int Http1CurlMultiEngine::OnSocketUpdate(CURL* handle, curl_socket_t socket,
+                                         int what, void* engine,
+                                         void* socket_data) {
+  auto* multi_engine = static_cast<Http1CurlMultiEngine*>(engine);
+  if (what == CURL_POLL_REMOVE) {
+    // Fails if CURL already closed the socket, which removes it as well.
+    epoll_ctl(multi_engine->epoll_fd_, EPOLL_CTL_DEL, socket, nullptr);
+    return 0;
+  }
+
+  epoll_event event = {};
+  event.data.fd = socket;
+  if (what == CURL_POLL_IN || what == CURL_POLL_INOUT) {
+    event.events |= EPOLLIN;
+  }
+  if (what == CURL_POLL_OUT || what == CURL_POLL_INOUT) {
+    event.events |= EPOLLOUT;
+  }
+  if (epoll_ctl(multi_engine->epoll_fd_, EPOLL_CTL_MOD, socket, &event) != 0 &&
+      errno == ENOENT) {
+    epoll_ctl(multi_engine->epoll_fd_, EPOLL_CTL_ADD, socket, &event);
+  }
+  return 0;
+}
+
+int Http1CurlMultiEngine::OnTimerUpdate(CURLM* multi_handle,
+                                        long timeout_ms,  // NOLINT(runtime/int)
+                                        void* engine) {
+  auto* multi_engine = static_cast<Http1CurlMultiEngine*>(engine);
+  if (timeout_ms < 0) {
+    multi_engine->timer_deadline_ = nullopt;
+  } else {
+    multi_engine->timer_deadline_ =
+        steady_clock::now() + milliseconds(timeout_ms);
+  }
+  return 0;
+}
+}  // namespace google::scp::core
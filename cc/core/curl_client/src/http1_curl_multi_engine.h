@@ -0,0 +1,195 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "core/common/concurrent_queue/src/concurrent_queue.h"
+#include "core/interface/async_context.h"
+#include "core/interface/async_executor_interface.h"
+#include "core/interface/http_types.h"
+#include "core/interface/service_interface.h"
+#include "public/core/interface/execution_result.h"
+
+#include "http1_curl_wrapper.h"
+
+namespace google::scp::core {
+/// The default maximum number of connections per host of the multi engine.
+static constexpr size_t kDefaultHttp1MaxConnectionsPerHost = 32;
+/// The default maximum number of idle CURL handles kept for reuse.
+static constexpr size_t kDefaultHttp1MaxPooledCurlHandles = 256;
+/// The maximum number of requests waiting to be picked up by the event loop.
+static constexpr size_t kHttp1CurlMultiEnginePendingQueueSize = 100000;
+/// How often the transfers paused by their response body chunk callback are
+/// resumed if they are not resumed explicitly.
+static constexpr std::chrono::milliseconds
+    kHttp1CurlMultiEnginePausedTransferRetryInterval =
+        std::chrono::milliseconds(10);
+
+/**
+ * @brief Http1CurlMultiEngine performs HTTP/1.1 requests without blocking. A
+ * single event loop thread drives all the transfers through a CURL multi
+ * handle: the sockets of the transfers are watched with epoll and handed to
+ * curl_multi_socket_action as they become ready, so that hundreds of requests
+ * can be in flight on the one thread.
+ *
+ * The CURL handles are pooled and reused across requests, and the multi
+ * handle keeps the connections alive to reuse them for later requests to the
+ * same host.
+ */
+class Http1CurlMultiEngine : public ServiceInterface {
+ public:
+  /**
+   * @brief Construct a new Http1 Curl Multi Engine object
+   *
+   * @param async_executor the executor the contexts are finished on.
+   * @param curl_wrapper_provider the provider of the CURL handles.
+   * @param max_connections_per_host the maximum number of connections to a
+   * host. Requests beyond it wait for a connection to be free.
+   * @param max_pooled_handles the maximum number of idle CURL handles kept for
+   * reuse.
+   */
+  explicit Http1CurlMultiEngine(
+      const std::shared_ptr<AsyncExecutorInterface>& async_executor,
+      std::shared_ptr<Http1CurlWrapperProvider> curl_wrapper_provider =
+          std::make_shared<Http1CurlWrapperProvider>(),
+      size_t max_connections_per_host = kDefaultHttp1MaxConnectionsPerHost,
+      size_t max_pooled_handles = kDefaultHttp1MaxPooledCurlHandles);
+
+  ~Http1CurlMultiEngine();
+
+  ExecutionResult Init() noexcept override;
+  ExecutionResult Run() noexcept override;
+  ExecutionResult Stop() noexcept override;
+
+  /**
+   * @brief Executes the http request. The context is finished on the async
+   * executor once the response is complete. Requests still in flight when the
+   * engine stops are failed.
+   *
+   * @param http_context The context of the http operation.
+   * @return ExecutionResult The execution result of the operation.
+   */
+  ExecutionResult Execute(
+      AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept;
+
+  /**
+   * @brief Resumes the transfers paused by their response body chunk callback.
+   * Each callback is handed the chunk it did not take again, and may pause
+   * its transfer once more. The paused transfers are also resumed
+   * periodically, so that they progress without being resumed explicitly.
+   */
+  void ResumeTransfers() noexcept;
+
+ private:
+  /// A request in flight on the multi handle.
+  struct Transfer {
+    std::shared_ptr<Http1CurlWrapper> wrapper;
+    AsyncContext<HttpRequest, HttpResponse> http_context;
+  };
+
+  /// Waits for socket events and timeouts and drives the transfers until the
+  /// engine stops.
+  void RunEventLoop() noexcept;
+
+  /// Adds the requests queued by Execute to the multi handle.
+  void StartPendingTransfers() noexcept;
+
+  /// Adds the request to the multi handle, or finishes its context on
+  /// failure.
+  void StartTransfer(
+      AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept;
+
+  /// Finishes the contexts of the transfers the multi handle completed.
+  void ProcessCompletedTransfers() noexcept;
+
+  /// Resumes the paused transfers if asked to or if they are due for a retry,
+  /// and tracks when to retry the ones still paused.
+  void ResumePausedTransfers() noexcept;
+
+  /// Collects the response of the transfer, returns its handle to the pool
+  /// and finishes its context.
+  void FinishTransfer(Transfer& transfer, CURLcode perform_result) noexcept;
+
+  /// Takes an idle CURL handle from the pool, or makes a new one.
+  ExecutionResultOr<std::shared_ptr<Http1CurlWrapper>>
+  AcquireWrapper() noexcept;
+
+  /// Resets the CURL handle and returns it to the pool if there is room.
+  void ReleaseWrapper(std::shared_ptr<Http1CurlWrapper> wrapper) noexcept;
+
+  /// Wakes the event loop up.
+  void WakeUp() noexcept;
+
+  /**
+   * @brief Is called by CURL to tell which events to watch a socket for.
+   * https://curl.se/libcurl/c/CURLMOPT_SOCKETFUNCTION.html
+   */
+  static int OnSocketUpdate(CURL* handle, curl_socket_t socket, int what,
+                            void* engine, void* socket_data);
+
+  /**
+   * @brief Is called by CURL to tell when to call curl_multi_socket_action
+   * for timeouts next.
+   * https://curl.se/libcurl/c/CURLMOPT_TIMERFUNCTION.html
+   */
+  static int OnTimerUpdate(CURLM* multi_handle,
+                           long timeout_ms,  // NOLINT(runtime/int)
+                           void* engine);
+
+  /// The executor the contexts are finished on.
+  std::shared_ptr<AsyncExecutorInterface> async_executor_;
+  /// The provider of the CURL handles.
+  std::shared_ptr<Http1CurlWrapperProvider> curl_wrapper_provider_;
+  const size_t max_connections_per_host_;
+  const size_t max_pooled_handles_;
+
+  /// The requests waiting to be picked up by the event loop.
+  common::ConcurrentQueue<AsyncContext<HttpRequest, HttpResponse>>
+      pending_contexts_;
+  /// Guards is_running_ against requests being queued while the engine stops.
+  std::shared_mutex running_mutex_;
+  std::atomic<bool> is_running_;
+  /// Set by ResumeTransfers for the event loop to resume the paused transfers.
+  std::atomic<bool> is_resume_requested_;
+
+  /// The fields below are only accessed by the event loop thread while it
+  /// runs.
+  CURLM* multi_handle_;
+  int epoll_fd_;
+  /// Written to by WakeUp to interrupt the wait of the event loop.
+  int wake_up_fd_;
+  /// When curl_multi_socket_action is to be called for timeouts next.
+  std::optional<std::chrono::steady_clock::time_point> timer_deadline_;
+  /// When the paused transfers are to be resumed next, if any is paused.
+  std::optional<std::chrono::steady_clock::time_point> paused_retry_deadline_;
+  /// The transfers in flight, keyed by their CURL handle.
+  std::unordered_map<CURL*, std::unique_ptr<Transfer>> transfers_;
+  /// The idle CURL handles.
+  std::vector<std::shared_ptr<Http1CurlWrapper>> idle_wrappers_;
+  std::unique_ptr<std::thread> event_loop_thread_;
+};
+}  // namespace google::scp::core
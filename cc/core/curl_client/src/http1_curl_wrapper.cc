@@ -121,12 +121,15 @@ size_t ResponsePayloadHandler(char* contents, size_t byte_size,
                               size_t num_bytes, void* output) {
   BytesBuffer* output_buffer = static_cast<BytesBuffer*>(output);
   size_t contents_length = byte_size * num_bytes;
-  output_buffer->bytes = make_shared<vector<Byte>>(contents_length);
-  for (size_t i = 0; i < contents_length; i++) {
-    output_buffer->bytes->at(i) = contents[i];
+  // The body may arrive in several chunks, each is appended.
+  if (!output_buffer->bytes) {
+    output_buffer->bytes = make_shared<vector<Byte>>();
   }
-  output_buffer->length = contents_length;
-  output_buffer->capacity = contents_length;
+  output_buffer->bytes->resize(output_buffer->length);
+  output_buffer->bytes->insert(output_buffer->bytes->end(), contents,
+                               contents + contents_length);
+  output_buffer->length = output_buffer->bytes->size();
+  output_buffer->capacity = output_buffer->bytes->capacity();
   return contents_length;
 }
 
@@ -276,11 +279,35 @@ void Http1CurlWrapper::SetUpPutData(const BytesBuffer& body) {
   curl_easy_setopt(curl_.get(), CURLOPT_INFILESIZE_LARGE, body.length);
 }
 
-// Performs the request. Logs any error that occurs and returns the status
-// of the request. If the request was successful, response_ will now hold the
-// body of the response.
-ExecutionResultOr<HttpResponse> Http1CurlWrapper::PerformRequest(
-    const HttpRequest& request) {
+size_t Http1CurlWrapper::ResponseBodyChunkHandler(char* contents,
+                                                  size_t byte_size,
+                                                  size_t num_bytes,
+                                                  void* output) {
+  auto* wrapper = static_cast<Http1CurlWrapper*>(output);
+  size_t contents_length = byte_size * num_bytes;
+  if (contents_length == 0) {
+    return 0;
+  }
+  long http_code = 0;  // NOLINT(runtime/int)
+  curl_easy_getinfo(wrapper->curl_.get(), CURLINFO_RESPONSE_CODE, &http_code);
+  wrapper->response_.code = static_cast<errors::HttpStatusCode>(http_code);
+  switch (wrapper->request_->response_body_chunk_callback(
+      wrapper->response_, reinterpret_cast<const uint8_t*>(contents),
+      contents_length)) {
+    case HttpResponseBodyChunkAction::Continue:
+      return contents_length;
+    case HttpResponseBodyChunkAction::Pause:
+      // CURL keeps the chunk and hands it over again once resumed.
+      wrapper->is_response_stream_paused_ = true;
+      return CURL_WRITEFUNC_PAUSE;
+    case HttpResponseBodyChunkAction::Abort:
+    default:
+      wrapper->is_response_stream_aborted_ = true;
+      return 0;
+  }
+}
+
+ExecutionResult Http1CurlWrapper::PrepareRequest(const HttpRequest& request) {
   if (!request.path || request.path->empty()) {
     return FailureExecutionResult(errors::SC_CURL_CLIENT_NO_PATH_SUPPLIED);
   }
@@ -311,31 +338,100 @@ ExecutionResultOr<HttpResponse> Http1CurlWrapper::PerformRequest(
 
   curl_easy_setopt(curl_.get(), CURLOPT_URL, uri->c_str());
 
-  HttpResponse response;
-  response.headers = make_shared<HttpHeaders>();
-  SetUpResponseHeaderHandler(response.headers.get());
+  request_ = &request;
+  if (header_list.has_value()) {
+    header_list_ = move(*header_list);
+  }
+  is_response_stream_aborted_ = false;
+  is_response_stream_paused_ = false;
+  response_ = HttpResponse();
+  response_.headers = make_shared<HttpHeaders>();
+  SetUpResponseHeaderHandler(response_.headers.get());
 
   // Add the handler indicating what to do with the returned HTTP response.
-  curl_easy_setopt(curl_.get(), CURLOPT_WRITEFUNCTION, ResponsePayloadHandler);
-  curl_easy_setopt(curl_.get(), CURLOPT_WRITEDATA, &response.body);
+  if (request.response_body_chunk_callback) {
+    curl_easy_setopt(curl_.get(), CURLOPT_WRITEFUNCTION,
+                     ResponseBodyChunkHandler);
+    curl_easy_setopt(curl_.get(), CURLOPT_WRITEDATA, this);
+  } else {
+    curl_easy_setopt(curl_.get(), CURLOPT_WRITEFUNCTION,
+                     ResponsePayloadHandler);
+    curl_easy_setopt(curl_.get(), CURLOPT_WRITEDATA, &response_.body);
+  }
   curl_easy_setopt(curl_.get(), CURLOPT_TIMEOUT, kCurlOptTimeout);
   curl_easy_setopt(curl_.get(), CURLOPT_FAILONERROR, kTrueAsLong);
+  // Signals cannot be used for timeouts when the handle is driven from
+  // threads other than the main one.
+  curl_easy_setopt(curl_.get(), CURLOPT_NOSIGNAL, kTrueAsLong);
+  curl_easy_setopt(curl_.get(), CURLOPT_TCP_KEEPALIVE, kTrueAsLong);
   // Create a buffer to place any error messages in.
-  string err_str(CURL_ERROR_SIZE, '\0');
-  curl_easy_setopt(curl_.get(), CURLOPT_ERRORBUFFER, err_str.data());
+  error_buffer_.assign(CURL_ERROR_SIZE, '\0');
+  curl_easy_setopt(curl_.get(), CURLOPT_ERRORBUFFER, error_buffer_.data());
+  return SuccessExecutionResult();
+}
 
-  // Execute the request.
-  CURLcode perform_res = curl_easy_perform(curl_.get());
-  if (perform_res != CURLE_OK) {
+ExecutionResultOr<HttpResponse> Http1CurlWrapper::CompleteRequest(
+    CURLcode perform_result) {
+  auto* request = request_;
+  request_ = nullptr;
+  curl_easy_setopt(curl_.get(), CURLOPT_HTTPHEADER, nullptr);
+  header_list_.reset();
+  if (is_response_stream_aborted_) {
+    auto result = FailureExecutionResult(
+        errors::SC_CURL_CLIENT_RESPONSE_STREAM_ABORTED);
+    SCP_ERROR(kHttp1CurlWrapper, kZeroUuid, result,
+              "CURL HTTP request aborted by the response body chunk callback");
+    return result;
+  }
+  if (perform_result != CURLE_OK) {
+    auto err_str = string(error_buffer_.c_str());
     auto result = GetExecutionResultFromCurlError(err_str);
     if (err_str.empty()) err_str = "<empty>";
     SCP_ERROR(kHttp1CurlWrapper, kZeroUuid, result,
               "CURL HTTP request failed with error code: %s, message: %s",
-              curl_easy_strerror(perform_res), err_str.c_str());
+              curl_easy_strerror(perform_result), err_str.c_str());
     return result;
   }
-  response.code = errors::HttpStatusCode::OK;
-  return response;
+  response_.code = errors::HttpStatusCode::OK;
+  if (request->response_body_chunk_callback) {
+    // Signals the end of the body.
+    request->response_body_chunk_callback(response_, nullptr, 0);
+  }
+  return move(response_);
+}
+
+// Performs the request. Logs any error that occurs and returns the status
+// of the request. If the request was successful, the response holds the body
+// of the response.
+ExecutionResultOr<HttpResponse> Http1CurlWrapper::PerformRequest(
+    const HttpRequest& request) {
+  RETURN_IF_FAILURE(PrepareRequest(request));
+
+  // Execute the request.
+  return CompleteRequest(curl_easy_perform(curl_.get()));
+}
+
+void Http1CurlWrapper::Reset() {
+  curl_easy_reset(curl_.get());
+  request_ = nullptr;
+  header_list_.reset();
+  response_ = HttpResponse();
+  is_response_stream_paused_ = false;
+}
+
+bool Http1CurlWrapper::IsResponseStreamPaused() const {
+  return is_response_stream_paused_;
+}
+
+void Http1CurlWrapper::ResumeResponseStream() {
+  is_response_stream_paused_ = false;
+  // Hands the held back chunk to the callback again, which may pause the
+  // transfer once more.
+  curl_easy_pause(curl_.get(), CURLPAUSE_CONT);
+}
+
+CURL* Http1CurlWrapper::GetHandle() const {
+  return curl_.get();
 }
 
 Http1CurlWrapper::Http1CurlWrapper(CURL* curl) {
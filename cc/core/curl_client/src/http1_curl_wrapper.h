@@ -47,9 +47,41 @@ class Http1CurlWrapper {
   virtual ExecutionResultOr<HttpResponse> PerformRequest(
       const HttpRequest& request);
 
+  // Sets up the CURL handle for the request without performing it, so that the
+  // transfer can be driven by a CURL multi handle instead. The request must
+  // outlive the transfer.
+  ExecutionResult PrepareRequest(const HttpRequest& request);
+
+  // Collects the result of the transfer set up by PrepareRequest once it
+  // completed with perform_result. Logs any error that occurs and returns the
+  // status of the request if it failed or an HttpResponse.
+  ExecutionResultOr<HttpResponse> CompleteRequest(CURLcode perform_result);
+
+  // Resets the options of the CURL handle and drops the state of the last
+  // request, so that the handle can be reused for another request. The live
+  // connections and caches of the handle are kept.
+  void Reset();
+
+  // Returns true if the response body chunk callback paused the transfer.
+  // Pausing is only supported for transfers driven by a CURL multi handle.
+  bool IsResponseStreamPaused() const;
+
+  // Resumes the transfer paused by the response body chunk callback, which is
+  // handed the chunk it did not take again. Must be called on the thread
+  // driving the transfer.
+  void ResumeResponseStream();
+
+  // Returns the CURL handle.
+  CURL* GetHandle() const;
+
   virtual ~Http1CurlWrapper() = default;
 
  private:
+  // Hands the contents to the response body chunk callback of the request
+  // being performed. output is the Http1CurlWrapper*.
+  static size_t ResponseBodyChunkHandler(char* contents, size_t byte_size,
+                                         size_t num_bytes, void* output);
+
   // Adds headers to the CURL instance. Returns the curl_slist containing the
   // headers.
   ExecutionResultOr<std::unique_ptr<curl_slist, CurlListDeleter>>
@@ -66,6 +98,19 @@ class Http1CurlWrapper {
   void SetUpPutData(const BytesBuffer& body);
 
   std::unique_ptr<CURL, CurlHandleDeleter> curl_;
+
+  // The request set up by PrepareRequest.
+  const HttpRequest* request_ = nullptr;
+  // The response of the request being performed.
+  HttpResponse response_;
+  // The headers of the request being performed.
+  std::unique_ptr<curl_slist, CurlListDeleter> header_list_;
+  // The buffer CURL places error messages in.
+  std::string error_buffer_;
+  // Set if the response body chunk callback aborted the request.
+  bool is_response_stream_aborted_ = false;
+  // Set while the response body chunk callback has the transfer paused.
+  bool is_response_stream_paused_ = false;
 };
 
 // Simple class to provide Http1CurlWrappers in clients.
@@ -19,19 +19,32 @@
 
 #include <gmock/gmock.h>
 
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "core/async_executor/src/async_executor.h"
 #include "core/curl_client/src/error_codes.h"
 #include "core/curl_client/src/http1_curl_wrapper.h"
 #include "core/test/utils/conditional_wait.h"
+#include "core/test/utils/http1_helper/test_http1_server.h"
 #include "public/core/test/interface/execution_result_matchers.h"
 
 using std::atomic_bool;
 using std::make_shared;
 using std::move;
+using std::mutex;
 using std::shared_ptr;
 using std::string;
+using std::thread;
+using std::unique_lock;
 using std::unique_ptr;
+using std::vector;
+using std::chrono::milliseconds;
+using std::this_thread::sleep_for;
 using testing::AtLeast;
+using testing::ElementsAre;
 using testing::ExplainMatchResult;
 using testing::InSequence;
 using testing::IsSupersetOf;
@@ -184,5 +197,226 @@ TEST_F(Http1CurlClientTest, FailureEnds) {
   WaitUntil([&finished]() { return finished.load(); });
 }
 
+/// Hands each of the chunks to the chunk callback of the request.
+auto StreamChunks(vector<string> chunks) {
+  return [chunks](
+             const HttpRequest& request) -> ExecutionResultOr<HttpResponse> {
+    HttpResponse response;
+    response.code = errors::HttpStatusCode::OK;
+    response.headers = make_shared<HttpHeaders>();
+    response.headers->insert({"key", "value"});
+    for (const auto& chunk : chunks) {
+      if (request.response_body_chunk_callback(
+              response, reinterpret_cast<const uint8_t*>(chunk.data()),
+              chunk.size()) != HttpResponseBodyChunkAction::Continue) {
+        return FailureExecutionResult(
+            errors::SC_CURL_CLIENT_RESPONSE_STREAM_ABORTED);
+      }
+    }
+    request.response_body_chunk_callback(response, nullptr, 0);
+    return response;
+  };
+}
+
+class Http1CurlClientStreamingTest : public Http1CurlClientTest {
+ protected:
+  /**
+   * @brief Performs the streaming request on the context and collects the
+   * pushed responses until the context finishes.
+   */
+  void PerformAndCollect(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>& context) {
+    context.request = make_shared<HttpRequest>();
+    context.process_callback = [this](auto& context, bool is_finish) {
+      unique_lock lock(mutex_);
+      while (auto response = context.TryGetNextResponse()) {
+        EXPECT_EQ(response->code, errors::HttpStatusCode::OK);
+        EXPECT_THAT(*response->headers, IsSupersetOf({Pair("key", "value")}));
+        chunks_.push_back(response->body.ToString());
+      }
+      if (is_finish) {
+        result_ = context.result;
+        finished_ = true;
+      }
+    };
+
+    ASSERT_THAT(subject_.PerformStreamingRequest(context), IsSuccessful());
+    WaitUntil([this]() { return finished_.load(); });
+  }
+
+  mutex mutex_;
+  vector<string> chunks_;
+  ExecutionResult result_;
+  atomic_bool finished_{false};
+};
+
+TEST_F(Http1CurlClientStreamingTest, StreamsResponseBodyChunks) {
+  EXPECT_CALL(*wrapper_, PerformRequest)
+      .WillOnce(StreamChunks({"ab", "cd", "ef"}));
+
+  ConsumerStreamingContext<HttpRequest, HttpResponse> context;
+  PerformAndCollect(context);
+
+  EXPECT_SUCCESS(result_);
+  EXPECT_THAT(chunks_, ElementsAre("ab", "cd", "ef"));
+}
+
+TEST_F(Http1CurlClientStreamingTest, EmptyBodyYieldsOneResponse) {
+  EXPECT_CALL(*wrapper_, PerformRequest).WillOnce(StreamChunks({}));
+
+  ConsumerStreamingContext<HttpRequest, HttpResponse> context;
+  PerformAndCollect(context);
+
+  EXPECT_SUCCESS(result_);
+  EXPECT_THAT(chunks_, ElementsAre(""));
+}
+
+TEST_F(Http1CurlClientStreamingTest, FailsFastWhenQueueIsFull) {
+  EXPECT_CALL(*wrapper_, PerformRequest)
+      .WillOnce(StreamChunks({"ab", "cd", "ef"}));
+
+  ConsumerStreamingContext<HttpRequest, HttpResponse> context(
+      /*max_num_outstanding_responses=*/1);
+  context.request = make_shared<HttpRequest>();
+  // The consumer never takes the responses off the queue, so the second chunk
+  // finds it full.
+  context.process_callback = [this](auto& context, bool is_finish) {
+    if (is_finish) {
+      result_ = context.result;
+      finished_ = true;
+    }
+  };
+
+  ASSERT_THAT(subject_.PerformStreamingRequest(context), IsSuccessful());
+  WaitUntil([this]() { return finished_.load(); });
+
+  EXPECT_THAT(result_, ResultIs(FailureExecutionResult(
+                           errors::SC_CURL_CLIENT_RESPONSE_QUEUE_FULL)));
+}
+
+TEST_F(Http1CurlClientStreamingTest, RetriesWhenNothingWasStreamed) {
+  {
+    InSequence seq;
+    EXPECT_CALL(*wrapper_, PerformRequest)
+        .Times(2)
+        .WillRepeatedly(Return(
+            RetryExecutionResult(errors::SC_CURL_CLIENT_REQUEST_FAILED)));
+    EXPECT_CALL(*wrapper_, PerformRequest).WillOnce(StreamChunks({"ab"}));
+  }
+
+  ConsumerStreamingContext<HttpRequest, HttpResponse> context;
+  PerformAndCollect(context);
+
+  EXPECT_SUCCESS(result_);
+  EXPECT_THAT(chunks_, ElementsAre("ab"));
+}
+
+TEST_F(Http1CurlClientStreamingTest, DoesNotRetryOnceStreamed) {
+  EXPECT_CALL(*wrapper_, PerformRequest)
+      .WillOnce([](const HttpRequest& request)
+                    -> ExecutionResultOr<HttpResponse> {
+        HttpResponse response;
+        response.code = errors::HttpStatusCode::OK;
+        response.headers = make_shared<HttpHeaders>(
+            HttpHeaders({{"key", "value"}}));
+        string chunk = "ab";
+        request.response_body_chunk_callback(
+            response, reinterpret_cast<const uint8_t*>(chunk.data()),
+            chunk.size());
+        return RetryExecutionResult(errors::SC_CURL_CLIENT_REQUEST_FAILED);
+      });
+
+  ConsumerStreamingContext<HttpRequest, HttpResponse> context;
+  PerformAndCollect(context);
+
+  EXPECT_THAT(result_, ResultIs(FailureExecutionResult(
+                           errors::SC_CURL_CLIENT_REQUEST_FAILED)));
+  EXPECT_THAT(chunks_, ElementsAre("ab"));
+}
+
+TEST_F(Http1CurlClientStreamingTest, CancellationAbortsTheRequest) {
+  EXPECT_CALL(*wrapper_, PerformRequest)
+      .WillOnce(StreamChunks({"ab", "cd"}));
+
+  ConsumerStreamingContext<HttpRequest, HttpResponse> context;
+  context.TryCancel();
+  PerformAndCollect(context);
+
+  EXPECT_THAT(result_, ResultIs(FailureExecutionResult(
+                           errors::SC_STREAMING_CONTEXT_CANCELLED)));
+  EXPECT_TRUE(chunks_.empty());
+}
+
+TEST(Http1CurlClientMultiStreamingTest, PausesTransferForSlowConsumer) {
+  string body(1048576, 'a');
+  for (size_t i = 0; i < body.size(); i++) {
+    body[i] = 'a' + i % 26;
+  }
+  TestHttp1Server server;
+  server.SetResponseBody(BytesBuffer(body));
+
+  auto cpu_async_executor =
+      make_shared<AsyncExecutor>(/*thread_count=*/2, /*queue_cap=*/1000);
+  auto io_async_executor =
+      make_shared<AsyncExecutor>(/*thread_count=*/2, /*queue_cap=*/1000);
+  ASSERT_SUCCESS(cpu_async_executor->Init());
+  ASSERT_SUCCESS(io_async_executor->Init());
+  ASSERT_SUCCESS(cpu_async_executor->Run());
+  ASSERT_SUCCESS(io_async_executor->Run());
+  Http1CurlClient subject(
+      cpu_async_executor, io_async_executor,
+      make_shared<Http1CurlWrapperProvider>(),
+      common::RetryStrategyOptions(common::RetryStrategyType::Exponential,
+                                   /*time_duration_ms=*/1UL,
+                                   /*total_retries=*/10),
+      Http1CurlClientMode::Multi);
+  ASSERT_SUCCESS(subject.Init());
+  ASSERT_SUCCESS(subject.Run());
+
+  ConsumerStreamingContext<HttpRequest, HttpResponse> context(
+      /*max_num_outstanding_responses=*/1);
+  context.request = make_shared<HttpRequest>();
+  context.request->method = HttpMethod::GET;
+  context.request->path = make_shared<Uri>(server.GetPath());
+  atomic_bool finished(false);
+  ExecutionResult result;
+  // The responses are only taken off the queue by the consumer thread.
+  context.process_callback = [&](auto& context, bool is_finish) {
+    if (is_finish) {
+      result = context.result;
+      finished = true;
+    }
+  };
+  ASSERT_SUCCESS(subject.PerformStreamingRequest(context));
+
+  string streamed_body;
+  thread consumer([&]() {
+    while (true) {
+      // Checked before taking a response, all of them are pushed by the time
+      // the context finishes.
+      auto is_finished = finished.load();
+      auto response = context.TryGetNextResponse();
+      if (response == nullptr) {
+        if (is_finished) {
+          return;
+        }
+        sleep_for(milliseconds(1));
+        continue;
+      }
+      streamed_body.append(response->body.ToString());
+      // Reads slower than the server writes.
+      sleep_for(milliseconds(1));
+    }
+  });
+  consumer.join();
+
+  EXPECT_SUCCESS(result);
+  EXPECT_EQ(streamed_body, body);
+
+  EXPECT_SUCCESS(subject.Stop());
+  EXPECT_SUCCESS(io_async_executor->Stop());
+  EXPECT_SUCCESS(cpu_async_executor->Stop());
+}
+
 }  // namespace
 }  // namespace google::scp::core::test
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "core/curl_client/src/http1_curl_multi_engine.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "core/async_executor/src/async_executor.h"
+#include "core/curl_client/src/error_codes.h"
+#include "core/test/utils/conditional_wait.h"
+#include "core/test/utils/http1_helper/test_http1_server.h"
+#include "public/core/test/interface/execution_result_matchers.h"
+
+using boost::beast::http::status;
+using std::atomic;
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+
+namespace google::scp::core::test {
+namespace {
+
+constexpr char kResponseBody[] = "response body";
+
+/// Counts the CURL handles made by the engine.
+class CountingCurlWrapperProvider : public Http1CurlWrapperProvider {
+ public:
+  ExecutionResultOr<shared_ptr<Http1CurlWrapper>> MakeWrapper() override {
+    wrapper_count++;
+    return Http1CurlWrapper::MakeWrapper();
+  }
+
+  atomic<size_t> wrapper_count{0};
+};
+
+class Http1CurlMultiEngineTest : public ::testing::Test {
+ protected:
+  Http1CurlMultiEngineTest()
+      : async_executor_(
+            make_shared<AsyncExecutor>(/*thread_count=*/2, /*queue_cap=*/100)),
+        provider_(make_shared<CountingCurlWrapperProvider>()),
+        engine_(async_executor_, provider_) {
+    assert(async_executor_->Init().Successful());
+    assert(async_executor_->Run().Successful());
+    server_.SetResponseBody(BytesBuffer(kResponseBody));
+  }
+
+  ~Http1CurlMultiEngineTest() {
+    engine_.Stop();
+    assert(async_executor_->Stop().Successful());
+  }
+
+  AsyncContext<HttpRequest, HttpResponse> MakeContext(
+      atomic<size_t>& finished_count) {
+    AsyncContext<HttpRequest, HttpResponse> http_context;
+    http_context.request = make_shared<HttpRequest>();
+    http_context.request->method = HttpMethod::GET;
+    http_context.request->path = make_shared<Uri>(server_.GetPath());
+    http_context.callback = [&finished_count](auto& http_context) {
+      EXPECT_SUCCESS(http_context.result);
+      ASSERT_NE(http_context.response, nullptr);
+      EXPECT_EQ(http_context.response->code, errors::HttpStatusCode::OK);
+      EXPECT_EQ(http_context.response->body.ToString(), kResponseBody);
+      finished_count++;
+    };
+    return http_context;
+  }
+
+  shared_ptr<AsyncExecutorInterface> async_executor_;
+  shared_ptr<CountingCurlWrapperProvider> provider_;
+  TestHttp1Server server_;
+  Http1CurlMultiEngine engine_;
+};
+
+TEST_F(Http1CurlMultiEngineTest, ExecuteFailsWhenNotRunning) {
+  atomic<size_t> finished_count = 0;
+  auto http_context = MakeContext(finished_count);
+  EXPECT_THAT(engine_.Execute(http_context),
+              ResultIs(FailureExecutionResult(
+                  errors::SC_CURL_CLIENT_CURL_MULTI_ENGINE_NOT_RUNNING)));
+
+  ASSERT_SUCCESS(engine_.Init());
+  ASSERT_SUCCESS(engine_.Run());
+  ASSERT_SUCCESS(engine_.Stop());
+  EXPECT_THAT(engine_.Execute(http_context),
+              ResultIs(FailureExecutionResult(
+                  errors::SC_CURL_CLIENT_CURL_MULTI_ENGINE_NOT_RUNNING)));
+  EXPECT_EQ(finished_count, 0);
+}
+
+TEST_F(Http1CurlMultiEngineTest, ExecutesConcurrentRequests) {
+  ASSERT_SUCCESS(engine_.Init());
+  ASSERT_SUCCESS(engine_.Run());
+
+  constexpr size_t kRequestCount = 20;
+  atomic<size_t> finished_count = 0;
+  for (size_t i = 0; i < kRequestCount; i++) {
+    auto http_context = MakeContext(finished_count);
+    ASSERT_SUCCESS(engine_.Execute(http_context));
+  }
+  WaitUntil([&]() { return finished_count == kRequestCount; });
+  EXPECT_LE(provider_->wrapper_count, kRequestCount);
+}
+
+TEST_F(Http1CurlMultiEngineTest, ReusesCurlHandles) {
+  ASSERT_SUCCESS(engine_.Init());
+  ASSERT_SUCCESS(engine_.Run());
+
+  atomic<size_t> finished_count = 0;
+  for (size_t i = 1; i <= 3; i++) {
+    auto http_context = MakeContext(finished_count);
+    ASSERT_SUCCESS(engine_.Execute(http_context));
+    WaitUntil([&]() { return finished_count == i; });
+  }
+  EXPECT_EQ(provider_->wrapper_count, 1);
+}
+
+TEST_F(Http1CurlMultiEngineTest, PropagatesErrors) {
+  ASSERT_SUCCESS(engine_.Init());
+  ASSERT_SUCCESS(engine_.Run());
+  server_.SetResponseStatus(status::not_found);
+
+  atomic<bool> finished = false;
+  AsyncContext<HttpRequest, HttpResponse> http_context;
+  http_context.request = make_shared<HttpRequest>();
+  http_context.request->method = HttpMethod::GET;
+  http_context.request->path = make_shared<Uri>(server_.GetPath());
+  http_context.callback = [&finished](auto& http_context) {
+    EXPECT_THAT(http_context.result,
+                ResultIs(FailureExecutionResult(
+                    errors::SC_CURL_CLIENT_REQUEST_NOT_FOUND)));
+    finished = true;
+  };
+  ASSERT_SUCCESS(engine_.Execute(http_context));
+  WaitUntil([&]() { return finished.load(); });
+}
+
+TEST_F(Http1CurlMultiEngineTest, FailsUnreachableHosts) {
+  ASSERT_SUCCESS(engine_.Init());
+  ASSERT_SUCCESS(engine_.Run());
+
+  auto port_or = GetUnusedPortNumber();
+  ASSERT_SUCCESS(port_or.result());
+  atomic<bool> finished = false;
+  AsyncContext<HttpRequest, HttpResponse> http_context;
+  http_context.request = make_shared<HttpRequest>();
+  http_context.request->method = HttpMethod::GET;
+  http_context.request->path =
+      make_shared<Uri>("http://localhost:" + std::to_string(*port_or));
+  http_context.callback = [&finished](auto& http_context) {
+    EXPECT_FALSE(http_context.result.Successful());
+    finished = true;
+  };
+  ASSERT_SUCCESS(engine_.Execute(http_context));
+  WaitUntil([&]() { return finished.load(); });
+}
+}  // namespace
+}  // namespace google::scp::core::test
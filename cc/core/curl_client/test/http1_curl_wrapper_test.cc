@@ -81,6 +81,51 @@ TEST_F(Http1CurlWrapperTest, GetWorks) {
   EXPECT_EQ(server_.Request().method(), boost::beast::http::verb::get);
 }
 
+TEST_F(Http1CurlWrapperTest, GetStreamsResponseBody) {
+  HttpRequest request;
+  request.method = HttpMethod::GET;
+  request.path = make_shared<Uri>(server_.GetPath());
+  string streamed_body;
+  bool end_of_body = false;
+  request.response_body_chunk_callback = [&](const HttpResponse& response,
+                                             const uint8_t* data,
+                                             size_t length) {
+    EXPECT_EQ(response.code, errors::HttpStatusCode::OK);
+    EXPECT_THAT(*response.headers, IsSupersetOf({Pair("resp1", "resp_val1")}));
+    if (length == 0) {
+      end_of_body = true;
+    } else {
+      streamed_body.append(reinterpret_cast<const char*>(data), length);
+    }
+    return HttpResponseBodyChunkAction::Continue;
+  };
+
+  server_.SetResponseBody(BytesBuffer(response_body_));
+  server_.SetResponseHeaders(HttpHeaders({{"resp1", "resp_val1"}}));
+
+  auto response_or = subject_->PerformRequest(request);
+  ASSERT_THAT(response_or, IsSuccessful());
+  EXPECT_EQ(response_or->body.length, 0);
+  EXPECT_EQ(streamed_body, response_body_);
+  EXPECT_TRUE(end_of_body);
+}
+
+TEST_F(Http1CurlWrapperTest, GetAbortsStreamingResponseBody) {
+  HttpRequest request;
+  request.method = HttpMethod::GET;
+  request.path = make_shared<Uri>(server_.GetPath());
+  request.response_body_chunk_callback =
+      [](const HttpResponse&, const uint8_t*, size_t) {
+        return HttpResponseBodyChunkAction::Abort;
+      };
+
+  server_.SetResponseBody(BytesBuffer(response_body_));
+
+  EXPECT_THAT(subject_->PerformRequest(request).result(),
+              ResultIs(FailureExecutionResult(
+                  errors::SC_CURL_CLIENT_RESPONSE_STREAM_ABORTED)));
+}
+
 TEST_F(Http1CurlWrapperTest, GetWorksWithHeaders) {
   HttpRequest request;
   request.method = HttpMethod::GET;
@@ -50,10 +50,37 @@ class MockHttpClient : public HttpClientInterface {
     return SuccessExecutionResult();
   }
 
+  ExecutionResult PerformStreamingRequest(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>& context) noexcept {
+    if (perform_streaming_request_mock) {
+      return perform_streaming_request_mock(context);
+    }
+
+    if (!http_get_result_mock.Successful()) {
+      context.result = http_get_result_mock;
+      context.MarkDone();
+      context.Finish();
+      return SuccessExecutionResult();
+    }
+
+    if (*request_mock.path == *context.request->path) {
+      context.TryPushResponse(response_mock);
+      context.ProcessNextMessage();
+      context.result = SuccessExecutionResult();
+    }
+
+    context.MarkDone();
+    context.Finish();
+    return SuccessExecutionResult();
+  }
+
   HttpRequest request_mock;
   HttpResponse response_mock;
   ExecutionResult http_get_result_mock = SuccessExecutionResult();
   std::function<ExecutionResult(AsyncContext<HttpRequest, HttpResponse>&)>
       perform_request_mock;
+  std::function<ExecutionResult(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>&)>
+      perform_streaming_request_mock;
 };
 }  // namespace google::scp::core::http2_client::mock
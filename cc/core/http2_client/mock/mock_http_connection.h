@@ -26,8 +26,12 @@ class MockHttpConnection : public HttpConnection {
  public:
   MockHttpConnection(
       const std::shared_ptr<AsyncExecutorInterface>& async_executor,
-      const std::string& host, const std::string& service, bool is_https)
-      : HttpConnection(async_executor, host, service, is_https) {}
+      const std::string& host, const std::string& service, bool is_https,
+      size_t max_concurrent_streams =
+          kDefaultHttp2MaxConcurrentStreamsPerConnection)
+      : HttpConnection(async_executor, host, service, is_https,
+                       kDefaultHttp2ReadTimeoutInSeconds,
+                       max_concurrent_streams) {}
 
   void CancelPendingCallbacks() noexcept {
     HttpConnection::CancelPendingCallbacks();
@@ -41,6 +45,16 @@ class MockHttpConnection : public HttpConnection {
 
   void SetIsReady() { is_ready_ = true; }
 
+  void SetInFlightStreamCount(size_t count) { in_flight_stream_count_ = count; }
+
+  void OnRequestResponseClosed(
+      common::Uuid& request_id,
+      AsyncContext<HttpRequest, HttpResponse>& http_context,
+      uint32_t error_code) noexcept {
+    HttpConnection::OnRequestResponseClosed(request_id, http_context,
+                                            error_code);
+  }
+
   auto& GetPendingNetworkCallbacks() { return pending_network_calls_; }
 };
 }  // namespace google::scp::core::http2_client::mock
@@ -31,8 +31,17 @@ class MockHttpConnectionPool : public HttpConnectionPool {
  public:
   MockHttpConnectionPool(
       const std::shared_ptr<AsyncExecutorInterface>& async_executor,
-      size_t max_connection_per_host)
-      : HttpConnectionPool(async_executor, max_connection_per_host) {}
+      size_t max_connection_per_host,
+      HttpConnectionSelectionPolicy selection_policy =
+          HttpConnectionSelectionPolicy::RoundRobin,
+      std::vector<std::string> prewarm_uris = {})
+      : HttpConnectionPool(async_executor, max_connection_per_host,
+                           kDefaultHttp2ReadTimeoutInSeconds, selection_policy,
+                           kDefaultHttp2MaxConcurrentStreamsPerConnection,
+                           kDefaultHttp2MaxPendingRequestsPerHost,
+                           /*io_context_pool=*/nullptr,
+                           /*complete_callbacks_inline=*/false,
+                           std::move(prewarm_uris)) {}
 
   std::shared_ptr<HttpConnection> CreateHttpConnection(
       std::string host, std::string service, bool is_https,
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "chained_bytes_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using std::make_shared;
+using std::max;
+using std::min;
+using std::vector;
+
+namespace google::scp::core {
+ChainedBytesBuffer::ChainedBytesBuffer(size_t expected_length)
+    : expected_length_(expected_length), length_(0) {}
+
+void ChainedBytesBuffer::Append(const uint8_t* data, size_t length) noexcept {
+  while (length > 0) {
+    if (blocks_.empty() ||
+        blocks_.back()->size() == blocks_.back()->capacity()) {
+      size_t block_size;
+      if (blocks_.empty() && expected_length_ > 0) {
+        block_size = max(expected_length_, length);
+      } else {
+        // Doubles the buffer so that the number of blocks stays logarithmic.
+        block_size = max({kChainedBytesBufferBlockSize, length, length_});
+      }
+      blocks_.push_back(make_shared<vector<Byte>>());
+      blocks_.back()->reserve(block_size);
+    }
+
+    auto& block = *blocks_.back();
+    auto to_copy = min(length, block.capacity() - block.size());
+    auto* chunk = reinterpret_cast<const Byte*>(data);
+    block.insert(block.end(), chunk, chunk + to_copy);
+    data += to_copy;
+    length -= to_copy;
+    length_ += to_copy;
+  }
+}
+
+BytesBuffer ChainedBytesBuffer::Release() noexcept {
+  BytesBuffer buffer;
+  // A single block is handed out as is unless most of it is unused, e.g. for
+  // a small body of unknown length.
+  if (blocks_.size() == 1 &&
+      blocks_[0]->capacity() - blocks_[0]->size() <= blocks_[0]->size()) {
+    buffer.bytes = blocks_[0];
+  } else {
+    buffer.bytes = make_shared<vector<Byte>>(length_);
+    size_t offset = 0;
+    for (auto& block : blocks_) {
+      memcpy(buffer.bytes->data() + offset, block->data(), block->size());
+      offset += block->size();
+    }
+  }
+  buffer.length = length_;
+  buffer.capacity = length_;
+
+  blocks_.clear();
+  length_ = 0;
+  return buffer;
+}
+}  // namespace google::scp::core
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "core/interface/type_def.h"
+
+namespace google::scp::core {
+/// The minimum size of the blocks of a ChainedBytesBuffer.
+static constexpr size_t kChainedBytesBufferBlockSize = 64 * 1024;
+
+/**
+ * @brief Collects a body which arrives in chunks. Chunks are appended to a
+ * chain of blocks, so that a growing body is never reallocated and copied
+ * again, and the chain is turned into a contiguous BytesBuffer once at the
+ * end. When the total length is known upfront, the body fits a single block
+ * which is handed out without any further copy.
+ */
+class ChainedBytesBuffer {
+ public:
+  /**
+   * @brief Construct a new Chained Bytes Buffer object.
+   *
+   * @param expected_length the expected total length, 0 if unknown.
+   */
+  explicit ChainedBytesBuffer(size_t expected_length = 0);
+
+  /**
+   * @brief Appends a chunk to the buffer.
+   *
+   * @param data the chunk.
+   * @param length the length of the chunk.
+   */
+  void Append(const uint8_t* data, size_t length) noexcept;
+
+  /// Returns the total length of the appended chunks.
+  size_t Length() const noexcept { return length_; }
+
+  /**
+   * @brief Moves the content of the buffer into a contiguous BytesBuffer. The
+   * buffer is empty afterwards.
+   *
+   * @return BytesBuffer the content.
+   */
+  BytesBuffer Release() noexcept;
+
+ private:
+  /// The blocks of the buffer, all of them but the last one are full.
+  std::vector<std::shared_ptr<std::vector<Byte>>> blocks_;
+  /// The expected total length, 0 if unknown.
+  size_t expected_length_;
+  /// The total length of the appended chunks.
+  size_t length_;
+};
+}  // namespace google::scp::core
@@ -174,4 +174,19 @@ DEFINE_ERROR_CODE(SC_HTTP2_CLIENT_HTTP_REQUEST_RESPONSE_STATUS_UNKNOWN,
 DEFINE_ERROR_CODE(SC_HTTP2_CLIENT_HTTP_CONNECTION_NOT_READY, SC_HTTP2_CLIENT,
                   0x0035, "Http connection is not ready",
                   HttpStatusCode::INTERNAL_SERVER_ERROR);
+DEFINE_ERROR_CODE(SC_HTTP2_CLIENT_CONNECTION_POOL_SATURATED, SC_HTTP2_CLIENT,
+                  0x0036,
+                  "All the connections to the host are at their concurrent "
+                  "streams limit",
+                  HttpStatusCode::SERVICE_UNAVAILABLE);
+DEFINE_ERROR_CODE(SC_HTTP2_CLIENT_PREPARED_REQUEST_PATH_MISMATCH,
+                  SC_HTTP2_CLIENT, 0x0037,
+                  "The path of the request is not the uri of the prepared "
+                  "endpoint",
+                  HttpStatusCode::BAD_REQUEST);
+DEFINE_ERROR_CODE(SC_HTTP2_CLIENT_RESPONSE_BODY_HELD_BACK_LIMIT_EXCEEDED,
+                  SC_HTTP2_CLIENT, 0x0038,
+                  "The consumer of the streamed response is too far behind "
+                  "the response body",
+                  HttpStatusCode::SERVICE_UNAVAILABLE);
 }  // namespace google::scp::core::errors
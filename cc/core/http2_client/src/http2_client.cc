@@ -16,35 +16,84 @@
 
 #include "http2_client.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "core/common/time_provider/src/time_provider.h"
 
 using google::scp::core::common::kZeroUuid;
 using google::scp::core::common::RetryStrategy;
 using google::scp::core::common::RetryStrategyType;
+using google::scp::core::common::TimeProvider;
+using std::bind;
+using std::make_shared;
 using std::make_unique;
+using std::min;
+using std::move;
+using std::optional;
 using std::shared_ptr;
+using std::unique_lock;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::nanoseconds;
+using std::placeholders::_1;
 
 constexpr char kHttpClient[] = "Http2Client";
+/// How long to wait for the consumer before retrying to push the held back
+/// chunks of a stream. The delay doubles, up to the max, while the consumer
+/// takes nothing off the queue.
+constexpr milliseconds kStreamingPushRetryDelay = milliseconds(1);
+constexpr milliseconds kMaxStreamingPushRetryDelay = milliseconds(64);
 
 namespace google::scp::core {
 HttpClient::HttpClient(shared_ptr<AsyncExecutorInterface>& async_executor,
                        HttpClientOptions options)
-    : http_connection_pool_(make_unique<HttpConnectionPool>(
+    : async_executor_(async_executor),
+      io_context_pool_(options.io_options.use_shared_io_threads
+                           ? make_shared<HttpIoContextPool>(
+                                 options.io_options.io_thread_count,
+                                 options.io_options.pin_io_threads)
+                           : nullptr),
+      http_connection_pool_(make_unique<HttpConnectionPool>(
           async_executor, options.max_connections_per_host,
-          options.http2_read_timeout_in_sec)),
+          options.http2_read_timeout_in_sec,
+          options.connection_selection_policy,
+          options.max_concurrent_streams_per_connection,
+          options.max_pending_requests_per_host, io_context_pool_,
+          options.io_options.complete_callbacks_inline,
+          options.prewarm_uris)),
       operation_dispatcher_(async_executor,
-                            RetryStrategy(options.retry_strategy_options)) {}
+                            RetryStrategy(options.retry_strategy_options)),
+      max_held_back_response_body_bytes_(
+          options.max_held_back_response_body_bytes) {}
 
 ExecutionResult HttpClient::Init() noexcept {
+  if (io_context_pool_) {
+    RETURN_IF_FAILURE(io_context_pool_->Init());
+  }
   return http_connection_pool_->Init();
 }
 
 ExecutionResult HttpClient::Run() noexcept {
+  if (io_context_pool_) {
+    RETURN_IF_FAILURE(io_context_pool_->Run());
+  }
   return http_connection_pool_->Run();
 }
 
 ExecutionResult HttpClient::Stop() noexcept {
-  return http_connection_pool_->Stop();
+  // The connections are stopped while the io threads still run them.
+  RETURN_IF_FAILURE(http_connection_pool_->Stop());
+  if (io_context_pool_) {
+    return io_context_pool_->Stop();
+  }
+  return SuccessExecutionResult();
 }
 
 ExecutionResult HttpClient::PerformRequest(
@@ -52,21 +101,292 @@ ExecutionResult HttpClient::PerformRequest(
   operation_dispatcher_.Dispatch<AsyncContext<HttpRequest, HttpResponse>>(
       http_context,
       [this](AsyncContext<HttpRequest, HttpResponse>& http_context) mutable {
-        shared_ptr<HttpConnection> http_connection;
-        auto execution_result = http_connection_pool_->GetConnection(
-            http_context.request->path, http_connection);
-        if (!execution_result.Successful()) {
-          return execution_result;
-        }
+        return http_connection_pool_->Execute(http_context);
+      });
 
-        SCP_DEBUG_CONTEXT(
-            kHttpClient, http_context,
-            "Executing request on connection %p. Retry count: %lld",
-            http_connection.get(), http_context.retry_count);
+  return SuccessExecutionResult();
+}
 
-        return http_connection->Execute(http_context);
+ExecutionResultOr<shared_ptr<const HttpPreparedEndpoint>>
+HttpClient::PrepareEndpoint(const shared_ptr<Uri>& uri,
+                            const HttpHeaders& static_headers) noexcept {
+  shared_ptr<const HttpPreparedEndpoint> endpoint;
+  RETURN_IF_FAILURE(
+      http_connection_pool_->PrepareEndpoint(uri, static_headers, endpoint));
+  return endpoint;
+}
+
+ExecutionResult HttpClient::PerformPreparedRequest(
+    const shared_ptr<const HttpPreparedEndpoint>& endpoint,
+    AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept {
+  operation_dispatcher_.Dispatch<AsyncContext<HttpRequest, HttpResponse>>(
+      http_context,
+      [this, endpoint](
+          AsyncContext<HttpRequest, HttpResponse>& http_context) mutable {
+        return http_connection_pool_->Execute(endpoint, http_context);
       });
 
   return SuccessExecutionResult();
 }
+
+ExecutionResult HttpClient::PerformStreamingRequest(
+    ConsumerStreamingContext<HttpRequest, HttpResponse>&
+        streaming_context) noexcept {
+  operation_dispatcher_.DispatchConsumerStreaming<HttpRequest, HttpResponse>(
+      streaming_context,
+      [this](ConsumerStreamingContext<HttpRequest, HttpResponse>&
+                 streaming_context) mutable {
+        auto response_stream = make_shared<ResponseStream>();
+        auto request = make_shared<HttpRequest>(*streaming_context.request);
+        request->response_body_chunk_callback =
+            [this, streaming_context, response_stream](
+                const HttpResponse& response, const uint8_t* data,
+                size_t chunk_length) mutable {
+              return OnStreamingResponseBodyChunk(
+                  streaming_context, response_stream, response, data,
+                  chunk_length);
+            };
+        AsyncContext<HttpRequest, HttpResponse> http_context(
+            move(request),
+            bind(&HttpClient::OnStreamingRequestCompleted, this,
+                 streaming_context, response_stream, _1),
+            streaming_context);
+
+        SCP_DEBUG_CONTEXT(kHttpClient, streaming_context,
+                          "Executing streaming request. Retry count: %lld",
+                          streaming_context.retry_count);
+
+        return http_connection_pool_->Execute(http_context);
+      });
+
+  return SuccessExecutionResult();
+}
+
+HttpResponseBodyChunkAction HttpClient::OnStreamingResponseBodyChunk(
+    ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+    const shared_ptr<ResponseStream>& response_stream,
+    const HttpResponse& response, const uint8_t* data,
+    size_t chunk_length) noexcept {
+  size_t pushed_count = 0;
+  {
+    unique_lock lock(response_stream->mutex);
+    if (!response_stream->push_result.Successful()) {
+      return HttpResponseBodyChunkAction::Abort;
+    }
+    // The body of an unsuccessful response is not handed to the consumer, the
+    // request fails or is retried once it completes.
+    if (static_cast<int>(response.code) / 100 != 2) {
+      return HttpResponseBodyChunkAction::Continue;
+    }
+    // The end of the body only yields a response if the body was empty, so
+    // that the consumer still receives the status code and the headers.
+    if (chunk_length == 0 && (response_stream->has_pushed_response ||
+                              !response_stream->pending_chunks.empty())) {
+      return HttpResponseBodyChunkAction::Continue;
+    }
+
+    HttpResponse chunk;
+    chunk.code = response.code;
+    chunk.headers = response.headers;
+    chunk.body = BytesBuffer(chunk_length);
+    if (chunk_length > 0) {
+      memcpy(chunk.body.bytes->data(), data, chunk_length);
+    }
+    chunk.body.length = chunk_length;
+
+    // The chunk queues up behind the ones held back already to keep the order.
+    response_stream->pending_bytes += chunk_length;
+    response_stream->pending_chunks.push_back(move(chunk));
+    pushed_count = PushPendingChunks(streaming_context, *response_stream);
+    if (response_stream->push_result.Successful() &&
+        response_stream->pending_bytes > max_held_back_response_body_bytes_) {
+      // nghttp2 keeps receiving the body regardless, so the stream is failed
+      // rather than holding back an unbounded amount of it.
+      response_stream->push_result = FailureExecutionResult(
+          errors::SC_HTTP2_CLIENT_RESPONSE_BODY_HELD_BACK_LIMIT_EXCEEDED);
+      SCP_ERROR_CONTEXT(kHttpClient, streaming_context,
+                        response_stream->push_result,
+                        "Held back %zu response body bytes.",
+                        response_stream->pending_bytes);
+      response_stream->pending_chunks.clear();
+      response_stream->pending_bytes = 0;
+    }
+  }
+
+  ScheduleStreamProcessing(streaming_context, response_stream, pushed_count);
+  unique_lock lock(response_stream->mutex);
+  if (!response_stream->push_result.Successful()) {
+    return HttpResponseBodyChunkAction::Abort;
+  }
+  return HttpResponseBodyChunkAction::Continue;
+}
+
+size_t HttpClient::PushPendingChunks(
+    ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+    ResponseStream& response_stream) noexcept {
+  size_t pushed_count = 0;
+  while (!response_stream.pending_chunks.empty()) {
+    auto push_result = streaming_context.TryPushResponse(
+        response_stream.pending_chunks.front());
+    if (!push_result.Successful()) {
+      // The response queue is full, the chunks are held back until the
+      // consumer catches up, unless the context is over.
+      if (streaming_context.IsCancelled() || streaming_context.IsMarkedDone() ||
+          TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks() >=
+              streaming_context.expiration_time) {
+        SCP_ERROR_CONTEXT(kHttpClient, streaming_context, push_result,
+                          "Failed to push the response body chunk.");
+        response_stream.push_result = push_result;
+        response_stream.pending_chunks.clear();
+        response_stream.pending_bytes = 0;
+      }
+      break;
+    }
+    response_stream.pending_bytes -=
+        response_stream.pending_chunks.front().body.length;
+    response_stream.pending_chunks.pop_front();
+    response_stream.has_pushed_response = true;
+    pushed_count++;
+  }
+  return pushed_count;
+}
+
+void HttpClient::ScheduleStreamProcessing(
+    ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+    const shared_ptr<ResponseStream>& response_stream,
+    size_t pushed_count) noexcept {
+  for (size_t i = 0; i < pushed_count; i++) {
+    auto schedule_result = async_executor_->Schedule(
+        [this, streaming_context, response_stream]() mutable {
+          streaming_context.ProcessNextMessage();
+          ResumeResponseStream(streaming_context, response_stream);
+        },
+        AsyncPriority::Normal);
+    if (!schedule_result.Successful()) {
+      SCP_ERROR_CONTEXT(
+          kHttpClient, streaming_context, schedule_result,
+          "Failed to schedule processing the response body chunk.");
+      FailResponseStream(streaming_context, response_stream, schedule_result);
+      return;
+    }
+  }
+
+  milliseconds retry_delay;
+  {
+    unique_lock lock(response_stream->mutex);
+    if (response_stream->pending_chunks.empty() ||
+        response_stream->is_retry_scheduled) {
+      return;
+    }
+    response_stream->is_retry_scheduled = true;
+    // The consumer is polled less often while it takes nothing off the queue.
+    response_stream->retry_delay =
+        pushed_count > 0 || response_stream->retry_delay == milliseconds::zero()
+            ? kStreamingPushRetryDelay
+            : min(response_stream->retry_delay * 2,
+                  kMaxStreamingPushRetryDelay);
+    retry_delay = response_stream->retry_delay;
+  }
+  // The consumer may take the responses off the queue outside of the
+  // processing of the context, so the push is retried after a while as well.
+  auto schedule_result = async_executor_->ScheduleFor(
+      [this, streaming_context, response_stream]() mutable {
+        {
+          unique_lock lock(response_stream->mutex);
+          response_stream->is_retry_scheduled = false;
+        }
+        ResumeResponseStream(streaming_context, response_stream);
+      },
+      TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks() +
+          duration_cast<nanoseconds>(retry_delay).count());
+  if (!schedule_result.Successful()) {
+    SCP_ERROR_CONTEXT(
+        kHttpClient, streaming_context, schedule_result,
+        "Failed to schedule pushing the held back response body chunks.");
+    FailResponseStream(streaming_context, response_stream, schedule_result);
+  }
+}
+
+void HttpClient::ResumeResponseStream(
+    ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+    const shared_ptr<ResponseStream>& response_stream) noexcept {
+  size_t pushed_count = 0;
+  optional<ExecutionResult> completion_result;
+  {
+    unique_lock lock(response_stream->mutex);
+    if (response_stream->pending_chunks.empty()) {
+      return;
+    }
+    pushed_count = PushPendingChunks(streaming_context, *response_stream);
+    if (response_stream->pending_chunks.empty()) {
+      completion_result.swap(response_stream->completion_result);
+    }
+  }
+
+  ScheduleStreamProcessing(streaming_context, response_stream, pushed_count);
+  if (completion_result) {
+    CompleteStreamingRequest(streaming_context, *response_stream,
+                             *completion_result);
+  }
+}
+
+void HttpClient::FailResponseStream(
+    ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+    const shared_ptr<ResponseStream>& response_stream,
+    const ExecutionResult& result) noexcept {
+  optional<ExecutionResult> completion_result;
+  {
+    unique_lock lock(response_stream->mutex);
+    response_stream->push_result = result;
+    response_stream->pending_chunks.clear();
+    response_stream->pending_bytes = 0;
+    completion_result.swap(response_stream->completion_result);
+  }
+  if (completion_result) {
+    CompleteStreamingRequest(streaming_context, *response_stream,
+                             *completion_result);
+  }
+}
+
+void HttpClient::OnStreamingRequestCompleted(
+    ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+    const shared_ptr<ResponseStream>& response_stream,
+    AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept {
+  {
+    unique_lock lock(response_stream->mutex);
+    if (!response_stream->pending_chunks.empty()) {
+      // Finishing the context now would drop the held back chunks.
+      response_stream->completion_result = http_context.result;
+      return;
+    }
+  }
+  CompleteStreamingRequest(streaming_context, *response_stream,
+                           http_context.result);
+}
+
+void HttpClient::CompleteStreamingRequest(
+    ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+    ResponseStream& response_stream, ExecutionResult result) noexcept {
+  bool has_pushed_response;
+  {
+    unique_lock lock(response_stream.mutex);
+    if (!response_stream.push_result.Successful()) {
+      result = response_stream.push_result;
+    }
+    has_pushed_response = response_stream.has_pushed_response;
+  }
+
+  if (result.status == ExecutionStatus::Retry) {
+    if (!has_pushed_response) {
+      // Nothing reached the consumer yet, the dispatcher retries the request.
+      streaming_context.result = result;
+      streaming_context.Finish();
+      return;
+    }
+    // Retrying would hand the consumer the start of the body again.
+    result = FailureExecutionResult(result.status_code);
+  }
+
+  FinishStreamingContext(result, streaming_context, async_executor_);
+}
 }  // namespace google::scp::core
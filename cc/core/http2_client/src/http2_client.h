@@ -16,7 +16,13 @@
 
 #pragma once
 
+#include <chrono>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include "cc/core/interface/async_context.h"
 #include "cc/core/interface/http_client_interface.h"
@@ -28,6 +34,19 @@
 #include "http_connection_pool.h"
 
 namespace google::scp::core {
+/// How the http connections are run.
+struct HttpIoOptions {
+  /// If true, the connections are multiplexed onto a fixed set of io threads
+  /// shared by the client, instead of running a thread per connection.
+  bool use_shared_io_threads = false;
+  /// The number of shared io threads, one per core if 0.
+  size_t io_thread_count = 0;
+  /// If true, the shared io threads are pinned to the cores.
+  bool pin_io_threads = false;
+  /// If true, the callbacks of the requests are invoked on the io threads
+  /// instead of the async executor. Only suitable for cheap callbacks.
+  bool complete_callbacks_inline = false;
+};
 
 struct HttpClientOptions {
   HttpClientOptions()
@@ -35,14 +54,39 @@ struct HttpClientOptions {
             common::RetryStrategyType::Exponential,
             kDefaultRetryStrategyDelayInMs, kDefaultRetryStrategyMaxRetries)),
         max_connections_per_host(kDefaultMaxConnectionsPerHost),
-        http2_read_timeout_in_sec(kDefaultHttp2ReadTimeoutInSeconds) {}
+        http2_read_timeout_in_sec(kDefaultHttp2ReadTimeoutInSeconds),
+        connection_selection_policy(
+            HttpConnectionSelectionPolicy::LeastOutstandingStreams),
+        max_concurrent_streams_per_connection(
+            kDefaultHttp2MaxConcurrentStreamsPerConnection),
+        max_pending_requests_per_host(kDefaultHttp2MaxPendingRequestsPerHost),
+        io_options(HttpIoOptions()),
+        max_held_back_response_body_bytes(
+            kDefaultHttp2MaxHeldBackResponseBodyBytes) {}
 
-  HttpClientOptions(common::RetryStrategyOptions retry_strategy_options,
-                    size_t max_connections_per_host,
-                    TimeDuration http2_read_timeout_in_sec)
+  HttpClientOptions(
+      common::RetryStrategyOptions retry_strategy_options,
+      size_t max_connections_per_host, TimeDuration http2_read_timeout_in_sec,
+      HttpConnectionSelectionPolicy connection_selection_policy =
+          HttpConnectionSelectionPolicy::LeastOutstandingStreams,
+      size_t max_concurrent_streams_per_connection =
+          kDefaultHttp2MaxConcurrentStreamsPerConnection,
+      size_t max_pending_requests_per_host =
+          kDefaultHttp2MaxPendingRequestsPerHost,
+      HttpIoOptions io_options = HttpIoOptions(),
+      std::vector<std::string> prewarm_uris = {},
+      size_t max_held_back_response_body_bytes =
+          kDefaultHttp2MaxHeldBackResponseBodyBytes)
       : retry_strategy_options(retry_strategy_options),
         max_connections_per_host(max_connections_per_host),
-        http2_read_timeout_in_sec(http2_read_timeout_in_sec) {}
+        http2_read_timeout_in_sec(http2_read_timeout_in_sec),
+        connection_selection_policy(connection_selection_policy),
+        max_concurrent_streams_per_connection(
+            max_concurrent_streams_per_connection),
+        max_pending_requests_per_host(max_pending_requests_per_host),
+        io_options(io_options),
+        prewarm_uris(std::move(prewarm_uris)),
+        max_held_back_response_body_bytes(max_held_back_response_body_bytes) {}
 
   /// Retry strategy options.
   const common::RetryStrategyOptions retry_strategy_options;
@@ -50,8 +94,24 @@ struct HttpClientOptions {
   const size_t max_connections_per_host;
   /// nghttp client read timeout.
   const TimeDuration http2_read_timeout_in_sec;
+  /// How the connection of a host is chosen for a request.
+  const HttpConnectionSelectionPolicy connection_selection_policy;
+  /// Max streams in flight per http connection.
+  const size_t max_concurrent_streams_per_connection;
+  /// Max requests queued per host while its connections are saturated.
+  const size_t max_pending_requests_per_host;
+  /// How the http connections are run.
+  const HttpIoOptions io_options;
+  /// The uris of the hosts to connect to when the client runs.
+  const std::vector<std::string> prewarm_uris;
+  /// Max response body bytes held back per stream while the consumer of a
+  /// streaming request is behind, the stream fails past it.
+  const size_t max_held_back_response_body_bytes;
 };
 
+/// An endpoint prepared with HttpClient::PrepareEndpoint.
+using HttpPreparedEndpoint = HttpConnectionPool::PreparedEndpoint;
+
 /*! @copydoc HttpClientInterface
  */
 class HttpClient : public HttpClientInterface {
@@ -75,11 +135,174 @@ class HttpClient : public HttpClientInterface {
   ExecutionResult PerformRequest(
       AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept override;
 
+  ExecutionResult PerformStreamingRequest(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>&
+          streaming_context) noexcept override;
+
+  /**
+   * @brief Prepares an endpoint to send many requests to. The uri is parsed,
+   * its host resolved to its connections and the static headers encoded once,
+   * so that PerformPreparedRequest skips that work for every request. The
+   * connections to the host are established if they are not yet.
+   *
+   * @param uri The uri of the endpoint.
+   * @param static_headers The headers sent with every request to the endpoint.
+   * @return ExecutionResultOr<std::shared_ptr<const HttpPreparedEndpoint>> The
+   * prepared endpoint, which is valid for as long as the client runs.
+   */
+  ExecutionResultOr<std::shared_ptr<const HttpPreparedEndpoint>>
+  PrepareEndpoint(const std::shared_ptr<Uri>& uri,
+                  const HttpHeaders& static_headers = HttpHeaders()) noexcept;
+
+  /**
+   * @brief Performs a HTTP request to a prepared endpoint. The path of the
+   * request may be left empty, in which case it is set to the uri of the
+   * endpoint, and is otherwise rejected unless it is that uri. The query and
+   * the headers of the request are added to the ones of the endpoint.
+   *
+   * @param endpoint The endpoint prepared by PrepareEndpoint.
+   * @param http_context the context of HTTP action.
+   * @return ExecutionResult the execution result of the action.
+   */
+  ExecutionResult PerformPreparedRequest(
+      const std::shared_ptr<const HttpPreparedEndpoint>& endpoint,
+      AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept;
+
  private:
+  /// The state of a streamed response across its body chunks.
+  struct ResponseStream {
+    /// Guards the state, which the io thread of the request and the async
+    /// executor both access.
+    std::mutex mutex;
+    /// The chunks held back while the response queue of the context is full,
+    /// in the order they arrived.
+    std::deque<HttpResponse> pending_chunks;
+    /// The number of body bytes of the held back chunks.
+    size_t pending_bytes = 0;
+    /// True once a response was pushed to the streaming context.
+    bool has_pushed_response = false;
+    /// The result of the pushes, the stream is aborted on failure.
+    ExecutionResult push_result = SuccessExecutionResult();
+    /// True while a retry of pushing the held back chunks is scheduled.
+    bool is_retry_scheduled = false;
+    /// The delay of the retry, doubled while the retries push nothing.
+    std::chrono::milliseconds retry_delay = std::chrono::milliseconds::zero();
+    /// The result of the request if it completed while chunks were still held
+    /// back. The context is finished with it once they are pushed.
+    std::optional<ExecutionResult> completion_result;
+  };
+
+  /**
+   * @brief Is called for each chunk of a streamed response body. Pushes the
+   * chunk to the streaming context and schedules its processing. The nghttp2
+   * session cannot hold the body back, so while the response queue of the
+   * context is full the chunk is held back in the stream instead, and pushed
+   * once the consumer catches up. The stream fails once more than
+   * max_held_back_response_body_bytes are held back.
+   *
+   * @param streaming_context The streaming context of the operation.
+   * @param response_stream The state of the stream.
+   * @param response The response holding the status code and headers.
+   * @param data A chunk of response body data.
+   * @param chunk_length The current chunk length, 0 for the end of the body.
+   * @return HttpResponseBodyChunkAction Continue if the chunk was pushed, held
+   * back or skipped, Abort if the stream must be aborted.
+   */
+  HttpResponseBodyChunkAction OnStreamingResponseBodyChunk(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+      const std::shared_ptr<ResponseStream>& response_stream,
+      const HttpResponse& response, const uint8_t* data,
+      size_t chunk_length) noexcept;
+
+  /**
+   * @brief Pushes the held back chunks of the stream to the streaming context
+   * until its response queue is full. The mutex of the stream must be held.
+   *
+   * @param streaming_context The streaming context of the operation.
+   * @param response_stream The state of the stream.
+   * @return size_t The number of chunks pushed.
+   */
+  size_t PushPendingChunks(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+      ResponseStream& response_stream) noexcept;
+
+  /**
+   * @brief Schedules the processing of the chunks pushed to the streaming
+   * context, and a retry of pushing the chunks still held back if any.
+   *
+   * @param streaming_context The streaming context of the operation.
+   * @param response_stream The state of the stream.
+   * @param pushed_count The number of chunks pushed.
+   */
+  void ScheduleStreamProcessing(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+      const std::shared_ptr<ResponseStream>& response_stream,
+      size_t pushed_count) noexcept;
+
+  /**
+   * @brief Is called once the consumer had the chance to take responses off
+   * the queue. Pushes the held back chunks of the stream, and finishes the
+   * streaming context if the request completed meanwhile.
+   *
+   * @param streaming_context The streaming context of the operation.
+   * @param response_stream The state of the stream.
+   */
+  void ResumeResponseStream(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+      const std::shared_ptr<ResponseStream>& response_stream) noexcept;
+
+  /**
+   * @brief Aborts the stream with the result, and finishes the streaming
+   * context if the request completed meanwhile.
+   *
+   * @param streaming_context The streaming context of the operation.
+   * @param response_stream The state of the stream.
+   * @param result The result to abort the stream with.
+   */
+  void FailResponseStream(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+      const std::shared_ptr<ResponseStream>& response_stream,
+      const ExecutionResult& result) noexcept;
+
+  /**
+   * @brief Is called when the http request of a streaming request completes.
+   * Finishes the streaming context unless chunks are still held back, in
+   * which case it is finished once they are pushed.
+   *
+   * @param streaming_context The streaming context of the operation.
+   * @param response_stream The state of the stream.
+   * @param http_context The context of the completed http request.
+   */
+  void OnStreamingRequestCompleted(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+      const std::shared_ptr<ResponseStream>& response_stream,
+      AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept;
+
+  /**
+   * @brief Finishes the streaming context with the result of its request, or
+   * retries the request if nothing was pushed to the context yet.
+   *
+   * @param streaming_context The streaming context of the operation.
+   * @param response_stream The state of the stream.
+   * @param result The result of the http request.
+   */
+  void CompleteStreamingRequest(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>& streaming_context,
+      ResponseStream& response_stream, ExecutionResult result) noexcept;
+
+  /// An instance of the async executor.
+  std::shared_ptr<AsyncExecutorInterface> async_executor_;
+
+  /// The io threads shared by the connections, if enabled.
+  std::shared_ptr<HttpIoContextPool> io_context_pool_;
+
   /// An instance of the connection pool that is used by the http client.
   std::unique_ptr<HttpConnectionPool> http_connection_pool_;
 
   /// Operation dispatcher
   common::OperationDispatcher operation_dispatcher_;
+
+  /// Max response body bytes held back per stream.
+  const size_t max_held_back_response_body_bytes_;
 };
 }  // namespace google::scp::core
@@ -17,7 +17,9 @@
 #include "http_connection.h"
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <utility>
@@ -31,6 +33,7 @@
 
 #include "absl/strings/str_cat.h"
 #include "cc/core/common/global_logger/src/global_logger.h"
+#include "cc/core/common/time_provider/src/time_provider.h"
 #include "cc/core/common/uuid/src/uuid.h"
 #include "cc/core/interface/async_context.h"
 #include "cc/core/interface/http_client_interface.h"
@@ -50,17 +53,23 @@ using boost::asio::ssl::context;
 using boost::posix_time::seconds;
 using boost::system::error_code;
 using google::scp::core::common::kZeroUuid;
+using google::scp::core::common::TimeProvider;
 using google::scp::core::common::ToString;
 using google::scp::core::common::Uuid;
 using google::scp::core::utils::GetEscapedUriWithQuery;
 using nghttp2::asio_http2::header_map;
 using nghttp2::asio_http2::client::configure_tls_context;
+using nghttp2::asio_http2::client::request;
 using nghttp2::asio_http2::client::response;
 using nghttp2::asio_http2::client::session;
 using std::bind;
 using std::make_pair;
 using std::make_shared;
 using std::make_unique;
+using std::max;
+using std::min;
+using std::move;
+using std::promise;
 using std::shared_ptr;
 using std::string;
 using std::to_string;
@@ -68,7 +77,6 @@ using std::vector;
 using std::placeholders::_1;
 using std::placeholders::_2;
 
-static constexpr char kContentLengthHeader[] = "content-length";
 static constexpr char kHttp2Client[] = "Http2Client";
 static constexpr char kHttpMethodGetTag[] = "GET";
 static constexpr char kHttpMethodPostTag[] = "POST";
@@ -77,21 +85,37 @@ namespace google::scp::core {
 HttpConnection::HttpConnection(
     const shared_ptr<AsyncExecutorInterface>& async_executor,
     const string& host, const string& service, bool is_https,
-    TimeDuration http2_read_timeout_in_sec)
+    TimeDuration http2_read_timeout_in_sec, size_t max_concurrent_streams,
+    shared_ptr<io_context> io_context, bool complete_callbacks_inline)
     : async_executor_(async_executor),
       host_(host),
       service_(service),
       is_https_(is_https),
       http2_read_timeout_in_sec_(http2_read_timeout_in_sec),
+      shared_io_context_(move(io_context)),
+      complete_callbacks_inline_(complete_callbacks_inline),
       tls_context_(context::sslv23),
       is_ready_(false),
-      is_dropped_(false) {}
+      is_dropped_(false),
+      in_flight_stream_count_(0),
+      configured_max_concurrent_streams_(
+          max(max_concurrent_streams, size_t(1))),
+      max_concurrent_streams_(configured_max_concurrent_streams_),
+      streams_since_limit_change_(0),
+      is_recycling_(false),
+      recycle_attempt_count_(0) {}
 
 ExecutionResult HttpConnection::Init() noexcept {
   try {
-    io_service_ = make_unique<io_service>();
-    work_guard_ = make_unique<executor_work_guard<io_context::executor_type>>(
-        make_work_guard(io_service_->get_executor()));
+    if (shared_io_context_) {
+      // The io context is run by its owner.
+      io_service_ = shared_io_context_;
+    } else {
+      io_service_ = make_shared<io_service>();
+      work_guard_ =
+          make_unique<executor_work_guard<io_context::executor_type>>(
+              make_work_guard(io_service_->get_executor()));
+    }
 
     tls_context_.set_default_verify_paths();
     error_code ec;
@@ -112,6 +136,7 @@ ExecutionResult HttpConnection::Init() noexcept {
       session_ = make_shared<session>(*io_service_, host_, service_);
     }
 
+    connect_start_timestamp_ = TimeProvider::GetSteadyTimestampInNanoseconds();
     session_->read_timeout(seconds(http2_read_timeout_in_sec_));
     session_->on_connect(bind(&HttpConnection::OnConnectionCreated, this, _1));
     session_->on_error(bind(&HttpConnection::OnConnectionError, this));
@@ -127,6 +152,9 @@ ExecutionResult HttpConnection::Init() noexcept {
 }
 
 ExecutionResult HttpConnection::Run() noexcept {
+  if (shared_io_context_) {
+    return SuccessExecutionResult();
+  }
   worker_ = make_shared<std::thread>([this]() {
     try {
       io_service_->run();
@@ -139,6 +167,10 @@ ExecutionResult HttpConnection::Run() noexcept {
 }
 
 ExecutionResult HttpConnection::Stop() noexcept {
+  if (shared_io_context_) {
+    return StopOnSharedIoContext();
+  }
+
   if (session_) {
     // Post session_->shutdown in io_service to make sure only one thread invoke
     // the session.
@@ -159,7 +191,7 @@ ExecutionResult HttpConnection::Stop() noexcept {
       SCP_INFO(kHttp2Client, kZeroUuid, "IO service is stopping.");
     });
 
-    if (worker_->joinable()) {
+    if (worker_ && worker_->joinable()) {
       worker_->join();
     }
 
@@ -175,11 +207,42 @@ ExecutionResult HttpConnection::Stop() noexcept {
   }
 }
 
+ExecutionResult HttpConnection::StopOnSharedIoContext() noexcept {
+  if (session_) {
+    // The session must only be used on its io thread. Waits for the shutdown
+    // unless it is already on the io thread, or the io context is no longer
+    // running.
+    if (io_service_->stopped() ||
+        io_service_->get_executor().running_in_this_thread()) {
+      session_->shutdown();
+    } else {
+      promise<void> shutdown;
+      post(*io_service_, [this, &shutdown]() {
+        session_->shutdown();
+        SCP_INFO(kHttp2Client, kZeroUuid, "Session is being shutdown.");
+        shutdown.set_value();
+      });
+      shutdown.get_future().wait();
+    }
+  }
+
+  is_ready_ = false;
+  CancelPendingCallbacks();
+  return SuccessExecutionResult();
+}
+
 void HttpConnection::OnConnectionCreated(tcp::resolver::iterator) noexcept {
   post(*io_service_, [this]() mutable {
+    auto connect_duration = TimeProvider::GetSteadyTimestampInNanoseconds() -
+                            connect_start_timestamp_;
     SCP_INFO(kHttp2Client, kZeroUuid,
-             "Connection %p for host %s is established.", this, host_.c_str());
+             "Connection %p for host %s is established in %lld ns.", this,
+             host_.c_str(), connect_duration.count());
+    recycle_attempt_count_ = 0;
     is_ready_ = true;
+    if (ready_callback_) {
+      ready_callback_(connect_duration);
+    }
   });
 }
 
@@ -216,8 +279,8 @@ void HttpConnection::CancelPendingCallbacks() noexcept {
       continue;
     }
 
-    // If Erase() failed, which means the context has being Finished.
-    if (!pending_network_calls_.Erase(key).Successful()) {
+    // If the release failed, which means the context has being Finished.
+    if (!ReleasePendingNetworkCall(key)) {
       continue;
     }
 
@@ -240,6 +303,14 @@ void HttpConnection::CancelPendingCallbacks() noexcept {
 void HttpConnection::Reset() noexcept {
   is_ready_ = false;
   is_dropped_ = false;
+  // The peer the connection reconnects to may accept more streams.
+  max_concurrent_streams_ = configured_max_concurrent_streams_;
+  streams_since_limit_change_ = 0;
+  if (shared_io_context_ && session_ && !io_service_->stopped()) {
+    // The handlers of the session may still be queued on the shared io
+    // context, the session is released after them.
+    post(*io_service_, [session = move(session_)]() {});
+  }
   session_ = nullptr;
 }
 
@@ -251,9 +322,111 @@ bool HttpConnection::IsReady() noexcept {
   return is_ready_.load();
 }
 
-ExecutionResult HttpConnection::Execute(
+size_t HttpConnection::GetInFlightStreamCount() noexcept {
+  return in_flight_stream_count_.load(std::memory_order_relaxed);
+}
+
+size_t HttpConnection::GetMaxConcurrentStreams() noexcept {
+  return max_concurrent_streams_.load(std::memory_order_relaxed);
+}
+
+bool HttpConnection::IsSaturated() noexcept {
+  return GetInFlightStreamCount() >= GetMaxConcurrentStreams();
+}
+
+void HttpConnection::SetStreamReleasedCallback(
+    std::function<void()> stream_released_callback) noexcept {
+  stream_released_callback_ = move(stream_released_callback);
+}
+
+void HttpConnection::FinishHttpContext(
+    const ExecutionResult& result,
     AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept {
+  if (complete_callbacks_inline_) {
+    http_context.result = result;
+    http_context.Finish();
+    return;
+  }
+  FinishContext(result, http_context, async_executor_);
+}
+
+void HttpConnection::SetReadyCallback(
+    std::function<void(std::chrono::nanoseconds)> ready_callback) noexcept {
+  ready_callback_ = move(ready_callback);
+}
+
+bool HttpConnection::TryStartRecycling() noexcept {
+  bool is_recycling = false;
+  return is_recycling_.compare_exchange_strong(is_recycling, true);
+}
+
+void HttpConnection::FinishRecycling() noexcept {
+  is_recycling_ = false;
+}
+
+size_t HttpConnection::GetRecycleAttemptCount() noexcept {
+  return recycle_attempt_count_.load();
+}
+
+ExecutionResult HttpConnection::Recycle() noexcept {
+  recycle_attempt_count_++;
+  Stop();
+  Reset();
+  auto execution_result = Init();
+  if (execution_result.Successful()) {
+    execution_result = Run();
+  }
+  if (!execution_result.Successful()) {
+    // Picked up again for recycling by the pool.
+    is_dropped_ = true;
+  }
+  return execution_result;
+}
+
+bool HttpConnection::ReleasePendingNetworkCall(Uuid& request_id) noexcept {
+  if (!pending_network_calls_.Erase(request_id).Successful()) {
+    return false;
+  }
+  ReleaseReservedStream();
+  return true;
+}
+
+void HttpConnection::ReserveStream() noexcept {
+  in_flight_stream_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void HttpConnection::ReleaseReservedStream() noexcept {
+  in_flight_stream_count_.fetch_sub(1, std::memory_order_relaxed);
+  if (stream_released_callback_) {
+    stream_released_callback_();
+  }
+}
+
+bool HttpConnection::TryReserveStream() noexcept {
+  auto in_flight_stream_count =
+      in_flight_stream_count_.load(std::memory_order_relaxed);
+  do {
+    if (in_flight_stream_count >= GetMaxConcurrentStreams()) {
+      return false;
+    }
+  } while (!in_flight_stream_count_.compare_exchange_weak(
+      in_flight_stream_count, in_flight_stream_count + 1,
+      std::memory_order_relaxed));
+  return true;
+}
+
+ExecutionResult HttpConnection::Execute(
+    AsyncContext<HttpRequest, HttpResponse>& http_context,
+    const shared_ptr<const HttpEncodedEndpoint>& endpoint) noexcept {
+  ReserveStream();
+  return ExecuteOnReservedStream(http_context, endpoint);
+}
+
+ExecutionResult HttpConnection::ExecuteOnReservedStream(
+    AsyncContext<HttpRequest, HttpResponse>& http_context,
+    const shared_ptr<const HttpEncodedEndpoint>& endpoint) noexcept {
   if (!is_ready_) {
+    ReleaseReservedStream();
     auto failure =
         RetryExecutionResult(errors::SC_HTTP2_CLIENT_NO_CONNECTION_ESTABLISHED);
     SCP_ERROR_CONTEXT(kHttp2Client, http_context, failure,
@@ -267,25 +440,26 @@ ExecutionResult HttpConnection::Execute(
   auto pair = make_pair(request_id, http_context);
   auto execution_result = pending_network_calls_.Insert(pair, http_context);
   if (!execution_result.Successful()) {
+    ReleaseReservedStream();
     return execution_result;
   }
 
-  post(*io_service_, [this, http_context, request_id]() mutable {
-    SendHttpRequest(request_id, http_context);
+  post(*io_service_, [this, http_context, request_id, endpoint]() mutable {
+    SendHttpRequest(request_id, http_context, endpoint);
   });
   return SuccessExecutionResult();
 }
 
 void HttpConnection::SendHttpRequest(
-    Uuid& request_id,
-    AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept {
+    Uuid& request_id, AsyncContext<HttpRequest, HttpResponse>& http_context,
+    const shared_ptr<const HttpEncodedEndpoint>& endpoint) noexcept {
   string method;
   if (http_context.request->method == HttpMethod::GET) {
     method = kHttpMethodGetTag;
   } else if (http_context.request->method == HttpMethod::POST) {
     method = kHttpMethodPostTag;
   } else {
-    if (!pending_network_calls_.Erase(request_id).Successful()) {
+    if (!ReleasePendingNetworkCall(request_id)) {
       return;
     }
 
@@ -293,51 +467,79 @@ void HttpConnection::SendHttpRequest(
         errors::SC_HTTP2_CLIENT_HTTP_METHOD_NOT_SUPPORTED);
     SCP_ERROR_CONTEXT(kHttp2Client, http_context, http_context.result,
                       "Failed as request method not supported.");
-    FinishContext(http_context.result, http_context, async_executor_);
+    FinishHttpContext(http_context.result, http_context);
     return;
   }
 
-  // Copy headers
+  // Copy headers, the static headers of an endpoint are already encoded.
   header_map headers;
+  if (endpoint) {
+    headers = endpoint->headers;
+  }
   if (http_context.request->headers) {
     for (const auto& [header, value] : *http_context.request->headers) {
       headers.insert({header, {value, false}});
     }
   }
 
-  // TODO: handle large data, avoid copy
-  string body;
-  if (http_context.request->body.length > 0) {
-    body = {http_context.request->body.bytes->begin(),
-            http_context.request->body.bytes->end()};
-  }
+  const auto& body = http_context.request->body;
 
   // Erase the header if it is already present.
   headers.erase(kContentLengthHeader);
   headers.insert(
-      {string(kContentLengthHeader), {std::to_string(body.length()), false}});
+      {string(kContentLengthHeader), {std::to_string(body.length), false}});
 
   // Erase the header if it is already present.
   headers.erase(kClientActivityIdHeader);
   headers.insert({string(kClientActivityIdHeader),
                   {ToString(http_context.activity_id), false}});
 
-  auto uri = GetEscapedUriWithQuery(*http_context.request);
-  if (!uri.Successful()) {
-    if (!pending_network_calls_.Erase(request_id).Successful()) {
+  // The uri of an endpoint is used as is unless a query is to be appended.
+  const string* uri = endpoint ? &endpoint->uri : nullptr;
+  const auto& query = http_context.request->query;
+  string escaped_uri;
+  if (!uri || (query && !query->empty())) {
+    auto escaped_uri_or = uri ? GetEscapedUriWithQuery(*uri, *query)
+                              : GetEscapedUriWithQuery(*http_context.request);
+    if (!escaped_uri_or.Successful()) {
+      if (!ReleasePendingNetworkCall(request_id)) {
+        return;
+      }
+
+      SCP_ERROR_CONTEXT(kHttp2Client, http_context, escaped_uri_or.result(),
+                        "Failed escaping URI.");
+      FinishHttpContext(escaped_uri_or.result(), http_context);
       return;
     }
-
-    SCP_ERROR_CONTEXT(kHttp2Client, http_context, uri.result(),
-                      "Failed escaping URI.");
-    FinishContext(uri.result(), http_context, async_executor_);
-    return;
+    escaped_uri = move(*escaped_uri_or);
+    uri = &escaped_uri;
   }
 
   error_code ec;
-  auto http_request = session_->submit(ec, method, uri.value(), body, headers);
+  const request* http_request;
+  if (body.length > 0) {
+    // The body is read straight from the request buffer, which the generator
+    // keeps alive, into the DATA frames.
+    http_request = session_->submit(
+        ec, method, *uri,
+        [body, offset = static_cast<size_t>(0)](
+            uint8_t* data, size_t length,
+            uint32_t* data_flags) mutable -> ssize_t {
+          auto to_copy = min(length, body.length - offset);
+          memcpy(data, body.bytes->data() + offset, to_copy);
+          offset += to_copy;
+          if (offset == body.length) {
+            *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+          }
+          return to_copy;
+        },
+        move(headers));
+  } else {
+    http_request =
+        session_->submit(ec, method, *uri, string(), move(headers));
+  }
   if (ec) {
-    if (!pending_network_calls_.Erase(request_id).Successful()) {
+    if (!ReleasePendingNetworkCall(request_id)) {
       return;
     }
 
@@ -347,7 +549,7 @@ void HttpConnection::SendHttpRequest(
                       "Http request failed for the client with error code %s!",
                       ec.message().c_str());
 
-    FinishContext(http_context.result, http_context, async_executor_);
+    FinishHttpContext(http_context.result, http_context);
 
     OnConnectionError();
     return;
@@ -355,7 +557,8 @@ void HttpConnection::SendHttpRequest(
 
   http_context.response = make_shared<HttpResponse>();
   http_request->on_response(
-      bind(&HttpConnection::OnResponseCallback, this, http_context, _1));
+      bind(&HttpConnection::OnResponseCallback, this, http_context,
+           http_request, _1));
   http_request->on_close(bind(&HttpConnection::OnRequestResponseClosed, this,
                               request_id, http_context, _1));
 }
@@ -363,10 +566,37 @@ void HttpConnection::SendHttpRequest(
 void HttpConnection::OnRequestResponseClosed(
     Uuid& request_id, AsyncContext<HttpRequest, HttpResponse>& http_context,
     uint32_t error_code) noexcept {
-  if (!pending_network_calls_.Erase(request_id).Successful()) {
+  if (!ReleasePendingNetworkCall(request_id)) {
     return;
   }
 
+  if (error_code == NGHTTP2_REFUSED_STREAM) {
+    // The peer is at its SETTINGS_MAX_CONCURRENT_STREAMS, which the nghttp2
+    // asio session does not expose. Learn it from the streams in flight.
+    auto max_concurrent_streams =
+        max(in_flight_stream_count_.load(std::memory_order_relaxed),
+            size_t(1));
+    streams_since_limit_change_ = 0;
+    if (max_concurrent_streams < GetMaxConcurrentStreams()) {
+      max_concurrent_streams_ = max_concurrent_streams;
+      SCP_INFO_CONTEXT(kHttp2Client, http_context,
+                       "Connection %p lowered its concurrent streams limit to "
+                       "%zu as the peer refused a stream.",
+                       this, max_concurrent_streams);
+    }
+  } else if (!error_code) {
+    // The peer may have raised its limit again, which is probed one stream at
+    // a time.
+    auto max_concurrent_streams = GetMaxConcurrentStreams();
+    if (max_concurrent_streams < configured_max_concurrent_streams_ &&
+        streams_since_limit_change_.fetch_add(1) + 1 >=
+            kHttp2StreamsToRaiseConcurrentStreamsLimit &&
+        max_concurrent_streams_.compare_exchange_strong(
+            max_concurrent_streams, max_concurrent_streams + 1)) {
+      streams_since_limit_change_ = 0;
+    }
+  }
+
   auto result =
       ConvertHttpStatusCodeToExecutionResult(http_context.response->code);
 
@@ -393,12 +623,12 @@ void HttpConnection::OnRequestResponseClosed(
         static_cast<int>(http_context.response->code));
   }
 
-  FinishContext(http_context.result, http_context, async_executor_);
+  FinishHttpContext(http_context.result, http_context);
 }
 
 void HttpConnection::OnResponseCallback(
     AsyncContext<HttpRequest, HttpResponse>& http_context,
-    const response& http_response) noexcept {
+    const request* http_request, const response& http_response) noexcept {
   http_context.response->headers = make_shared<HttpHeaders>();
   http_context.response->code =
       static_cast<errors::HttpStatusCode>(http_response.status_code());
@@ -420,29 +650,42 @@ void HttpConnection::OnResponseCallback(
     http_context.response->headers->insert({header, value.value});
   }
 
-  if (http_response.content_length() >= 0) {
-    http_context.response->body.bytes = make_shared<vector<Byte>>();
-    http_context.response->body.bytes->reserve(http_response.content_length());
-    http_context.response->body.capacity = http_response.content_length();
+  if (http_context.request->response_body_chunk_callback) {
+    http_response.on_data(bind(&HttpConnection::OnResponseBodyChunkCallback,
+                               this, http_context, http_request, _1, _2));
+    return;
   }
 
+  auto body_buffer = make_shared<ChainedBytesBuffer>(
+      http_response.content_length() > 0 ? http_response.content_length() : 0);
   http_response.on_data(bind(&HttpConnection::OnResponseBodyCallback, this,
-                             http_context, _1, _2));
+                             http_context, body_buffer, _1, _2));
 }
 
 void HttpConnection::OnResponseBodyCallback(
-    AsyncContext<HttpRequest, HttpResponse>& http_context, const uint8_t* data,
+    AsyncContext<HttpRequest, HttpResponse>& http_context,
+    const shared_ptr<ChainedBytesBuffer>& body_buffer, const uint8_t* data,
     size_t chunk_length) noexcept {
   auto is_last_chunk = chunk_length == 0UL;
   if (!is_last_chunk) {
-    auto& body = http_context.response->body;
-    auto& body_buffer = *http_context.response->body.bytes;
-    if (body_buffer.capacity() < body_buffer.size() + chunk_length) {
-      body_buffer.reserve(body_buffer.size() + chunk_length);
-      body.capacity = body_buffer.size() + chunk_length;
-    }
-    std::copy(data, data + chunk_length, std::back_inserter(body_buffer));
-    http_context.response->body.length += chunk_length;
+    body_buffer->Append(data, chunk_length);
+  } else {
+    http_context.response->body = body_buffer->Release();
+  }
+}
+
+void HttpConnection::OnResponseBodyChunkCallback(
+    AsyncContext<HttpRequest, HttpResponse>& http_context,
+    const request* http_request, const uint8_t* data,
+    size_t chunk_length) noexcept {
+  // The nghttp2 session takes in the data as it arrives, so the stream cannot
+  // be paused and a pause aborts the request.
+  auto action = http_context.request->response_body_chunk_callback(
+      *http_context.response, data, chunk_length);
+  if (action != HttpResponseBodyChunkAction::Continue && chunk_length > 0) {
+    SCP_DEBUG_CONTEXT(kHttp2Client, http_context,
+                      "Response body chunk callback aborted the request.");
+    http_request->cancel(NGHTTP2_CANCEL);
   }
 }
 
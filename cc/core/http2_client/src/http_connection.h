@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
 #include <thread>
@@ -28,9 +30,27 @@
 #include "core/common/concurrent_map/src/concurrent_map.h"
 #include "public/core/interface/execution_result.h"
 
+#include "chained_bytes_buffer.h"
 #include "error_codes.h"
 
 namespace google::scp::core {
+/// The content length header, which is set per request.
+static constexpr char kContentLengthHeader[] = "content-length";
+/// The number of streams that complete without a refusal before a lowered
+/// concurrent streams limit is raised by one again.
+static constexpr size_t kHttp2StreamsToRaiseConcurrentStreamsLimit = 32;
+
+/**
+ * @brief The parts of the requests to an endpoint that are encoded once for
+ * all of them, see HttpConnectionPool::PrepareEndpoint.
+ */
+struct HttpEncodedEndpoint {
+  /// The uri of the endpoint, the escaped query of a request is appended.
+  std::string uri;
+  /// The static headers of the endpoint in the form nghttp2 submits them.
+  nghttp2::asio_http2::header_map headers;
+};
+
 /**
  * @brief HttpConnection uses nghttp2 to establish http2 connections with the
  * remote hosts.
@@ -45,12 +65,25 @@ class HttpConnection : public ServiceInterface {
    * @param service The port of the connection.
    * @param is_https If the connection is https, must be set to true.
    * @param http2_read_timeout_in_sec nghttp2 read timeout in second.
+   * @param max_concurrent_streams The max number of streams in flight on the
+   * connection. Lowered when the peer refuses streams, raised back one stream
+   * at a time as streams complete and restored when the connection is reset.
+   * @param io_context The io context shared with other connections to run the
+   * connection on. If null, the connection runs its own io context on a
+   * dedicated thread.
+   * @param complete_callbacks_inline If true, the callbacks of the requests
+   * are invoked on the io thread instead of the async executor. Only suitable
+   * for cheap callbacks.
    */
-  HttpConnection(const std::shared_ptr<AsyncExecutorInterface>& async_executor,
-                 const std::string& host, const std::string& service,
-                 bool is_https,
-                 TimeDuration http2_read_timeout_in_sec =
-                     kDefaultHttp2ReadTimeoutInSeconds);
+  HttpConnection(
+      const std::shared_ptr<AsyncExecutorInterface>& async_executor,
+      const std::string& host, const std::string& service, bool is_https,
+      TimeDuration http2_read_timeout_in_sec =
+          kDefaultHttp2ReadTimeoutInSeconds,
+      size_t max_concurrent_streams =
+          kDefaultHttp2MaxConcurrentStreamsPerConnection,
+      std::shared_ptr<boost::asio::io_context> io_context = nullptr,
+      bool complete_callbacks_inline = false);
 
   ExecutionResult Init() noexcept override;
   ExecutionResult Run() noexcept override;
@@ -60,10 +93,52 @@ class HttpConnection : public ServiceInterface {
    * @brief Executes the http request and processes the response.
    *
    * @param http_context The context of the http operation.
+   * @param endpoint If set, the uri and the static headers of the request are
+   * taken from the endpoint instead of being escaped and encoded again.
    * @return ExecutionResult The execution result of the operation.
    */
   ExecutionResult Execute(
-      AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept;
+      AsyncContext<HttpRequest, HttpResponse>& http_context,
+      const std::shared_ptr<const HttpEncodedEndpoint>& endpoint =
+          nullptr) noexcept;
+
+  /**
+   * @brief Executes the http request on a stream reserved beforehand with
+   * TryReserveStream. The reservation is released if the request cannot be
+   * executed.
+   *
+   * @param http_context The context of the http operation.
+   * @param endpoint If set, the uri and the static headers of the request are
+   * taken from the endpoint instead of being escaped and encoded again.
+   * @return ExecutionResult The execution result of the operation.
+   */
+  ExecutionResult ExecuteOnReservedStream(
+      AsyncContext<HttpRequest, HttpResponse>& http_context,
+      const std::shared_ptr<const HttpEncodedEndpoint>& endpoint =
+          nullptr) noexcept;
+
+  /**
+   * @brief Reserves a stream for a request if the connection is not at its
+   * limit of streams in flight. The check and the reservation are a single
+   * atomic step, so concurrent callers cannot exceed the limit.
+   *
+   * @return true The stream is reserved, the caller must execute a request on
+   * it with ExecuteOnReservedStream.
+   * @return false The connection is saturated.
+   */
+  bool TryReserveStream() noexcept;
+
+  /**
+   * @brief Reserves a stream for a request regardless of the limit of streams
+   * in flight.
+   */
+  void ReserveStream() noexcept;
+
+  /**
+   * @brief Releases a stream reserved for a request which is not executed, and
+   * notifies the stream released callback.
+   */
+  void ReleaseReservedStream() noexcept;
 
   /**
    * @brief Indicates whether the connection to the remote server is dropped.
@@ -87,16 +162,82 @@ class HttpConnection : public ServiceInterface {
    */
   void Reset() noexcept;
 
+  /**
+   * @brief Gets the number of requests executed on the connection which are
+   * not completed yet.
+   */
+  size_t GetInFlightStreamCount() noexcept;
+
+  /**
+   * @brief Gets the max number of streams in flight on the connection.
+   */
+  size_t GetMaxConcurrentStreams() noexcept;
+
+  /**
+   * @brief Indicates whether the connection is at its limit of streams in
+   * flight.
+   */
+  bool IsSaturated() noexcept;
+
+  /**
+   * @brief Sets the callback invoked each time a request executed on the
+   * connection completes. Must be set before the connection is used.
+   *
+   * @param stream_released_callback The callback.
+   */
+  void SetStreamReleasedCallback(
+      std::function<void()> stream_released_callback) noexcept;
+
+  /**
+   * @brief Sets the callback invoked each time the connection becomes ready,
+   * with the time it took since the connection started to connect. Must be
+   * set before the connection runs.
+   *
+   * @param ready_callback The callback.
+   */
+  void SetReadyCallback(
+      std::function<void(std::chrono::nanoseconds)> ready_callback) noexcept;
+
+  /**
+   * @brief Marks the connection as being recycled.
+   *
+   * @return true The connection was not being recycled, the caller must call
+   * FinishRecycling once done.
+   * @return false The connection is already being recycled.
+   */
+  bool TryStartRecycling() noexcept;
+
+  /**
+   * @brief Marks the connection as no longer being recycled.
+   */
+  void FinishRecycling() noexcept;
+
+  /**
+   * @brief Gets the number of times the connection was recycled since it was
+   * last ready.
+   */
+  size_t GetRecycleAttemptCount() noexcept;
+
+  /**
+   * @brief Stops, resets and runs the connection again to reconnect to the
+   * remote host. If it fails, the connection stays dropped.
+   *
+   * @return ExecutionResult The execution result of the operation.
+   */
+  ExecutionResult Recycle() noexcept;
+
  protected:
   /**
    * @brief Executes the http requests and sends it over the wire.
    *
    * @param request_id The id of the request.
    * @param http_context The http context of the operation.
+   * @param endpoint The encoded endpoint of the request, if any.
    */
   void SendHttpRequest(
       common::Uuid& request_id,
-      AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept;
+      AsyncContext<HttpRequest, HttpResponse>& http_context,
+      const std::shared_ptr<const HttpEncodedEndpoint>& endpoint) noexcept;
 
   /**
    * @brief Is called when the request/response stream is closed either
@@ -116,23 +257,49 @@ class HttpConnection : public ServiceInterface {
    * @brief Is called when the response is available to the request issuer.
    *
    * @param http_context The http context of the operation.
+   * @param http_request The http request object.
    * @param http_response The http response object.
    */
   void OnResponseCallback(
       AsyncContext<HttpRequest, HttpResponse>& http_context,
+      const nghttp2::asio_http2::client::request* http_request,
       const nghttp2::asio_http2::client::response& http_response) noexcept;
 
   /**
    * @brief Is called when the body of the stream is available to be read.
    *
    * @param http_context The http context of the operation.
+   * @param body_buffer The buffer collecting the response body.
    * @param data A chunk of response body data.
    * @param chunk_length The current chunk length.
    */
   void OnResponseBodyCallback(
       AsyncContext<HttpRequest, HttpResponse>& http_context,
+      const std::shared_ptr<ChainedBytesBuffer>& body_buffer,
+      const uint8_t* data, size_t chunk_length) noexcept;
+
+  /**
+   * @brief Is called when the body of the stream is available to be read and
+   * the request streams the response body to its chunk callback. Cancels the
+   * stream if the callback asks to abort or to pause, as the stream cannot be
+   * paused.
+   *
+   * @param http_context The http context of the operation.
+   * @param http_request The http request object.
+   * @param data A chunk of response body data.
+   * @param chunk_length The current chunk length.
+   */
+  void OnResponseBodyChunkCallback(
+      AsyncContext<HttpRequest, HttpResponse>& http_context,
+      const nghttp2::asio_http2::client::request* http_request,
       const uint8_t* data, size_t chunk_length) noexcept;
 
+  /**
+   * @brief Stops the connection running on a shared io context, which keeps
+   * running for the other connections.
+   */
+  ExecutionResult StopOnSharedIoContext() noexcept;
+
   /**
    * @brief Is called when the connection to the remote host is established.
    */
@@ -143,6 +310,27 @@ class HttpConnection : public ServiceInterface {
    */
   void OnConnectionError() noexcept;
 
+  /**
+   * @brief Finishes the http context with the result, on the io thread or on
+   * the async executor.
+   *
+   * @param result The result of the operation.
+   * @param http_context The http context of the operation.
+   */
+  void FinishHttpContext(
+      const ExecutionResult& result,
+      AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept;
+
+  /**
+   * @brief Removes the request from the pending network calls and releases
+   * its stream.
+   *
+   * @param request_id The id of the request.
+   * @return true The request was pending and is now released.
+   * @return false The request was already released.
+   */
+  bool ReleasePendingNetworkCall(common::Uuid& request_id) noexcept;
+
   /**
    * @brief Cancels all the pending callbacks. This is used during connection
    * drop or stop.
@@ -169,8 +357,12 @@ class HttpConnection : public ServiceInterface {
 
   /// http2 read timeout in seconds.
   TimeDuration http2_read_timeout_in_sec_;
+  /// The io context shared with other connections, if any.
+  const std::shared_ptr<boost::asio::io_context> shared_io_context_;
+  /// Whether the callbacks are invoked on the io thread.
+  const bool complete_callbacks_inline_;
   /// The asio io_service to provide http functionality.
-  std::unique_ptr<boost::asio::io_service> io_service_;
+  std::shared_ptr<boost::asio::io_service> io_service_;
   /// The worker guard to run the io_service_.
   std::unique_ptr<
       boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>
@@ -188,5 +380,25 @@ class HttpConnection : public ServiceInterface {
   common::ConcurrentMap<common::Uuid, AsyncContext<HttpRequest, HttpResponse>,
                         common::UuidCompare>
       pending_network_calls_;
+  /// The number of entries of pending_network_calls_, plus the streams
+  /// reserved for requests which are not executed yet.
+  std::atomic<size_t> in_flight_stream_count_;
+  /// The configured max number of streams in flight on the connection.
+  const size_t configured_max_concurrent_streams_;
+  /// The max number of streams in flight on the connection, at most the
+  /// configured one.
+  std::atomic<size_t> max_concurrent_streams_;
+  /// The streams completed since the limit was last lowered or raised.
+  std::atomic<size_t> streams_since_limit_change_;
+  /// Invoked each time a pending network call is released.
+  std::function<void()> stream_released_callback_;
+  /// Invoked each time the connection becomes ready.
+  std::function<void(std::chrono::nanoseconds)> ready_callback_;
+  /// When the connection started to connect.
+  std::chrono::nanoseconds connect_start_timestamp_;
+  /// Indicates if the connection is being recycled.
+  std::atomic<bool> is_recycling_;
+  /// The number of recycles since the connection was last ready.
+  std::atomic<size_t> recycle_attempt_count_;
 };
 }  // namespace google::scp::core
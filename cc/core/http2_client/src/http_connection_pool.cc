@@ -32,6 +32,7 @@
 #include <nghttp2/asio_http2_client.h>
 
 #include "cc/core/common/global_logger/src/global_logger.h"
+#include "cc/core/common/time_provider/src/time_provider.h"
 #include "cc/core/interface/async_context.h"
 #include "cc/core/interface/http_client_interface.h"
 #include "public/core/interface/execution_result.h"
@@ -43,11 +44,19 @@ using boost::algorithm::to_lower;
 using boost::system::error_code;
 using google::scp::core::common::kZeroUuid;
 using nghttp2::asio_http2::host_service_from_uri;
-using std::lock_guard;
+using google::scp::core::common::TimeProvider;
 using std::make_shared;
+using std::map;
+using std::move;
+using std::shared_lock;
 using std::shared_ptr;
 using std::string;
+using std::unique_lock;
 using std::vector;
+using std::weak_ptr;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::nanoseconds;
 
 static constexpr char kHttpsTag[] = "https";
 static constexpr char kHttpTag[] = "http";
@@ -60,11 +69,31 @@ ExecutionResult HttpConnectionPool::Init() noexcept {
 
 ExecutionResult HttpConnectionPool::Run() noexcept {
   is_running_ = true;
+
+  // Connects to the configured hosts ahead of their first request.
+  for (const auto& prewarm_uri : prewarm_uris_) {
+    shared_ptr<HttpConnectionPoolEntry> entry;
+    auto execution_result =
+        GetPoolEntry(make_shared<Uri>(prewarm_uri), entry);
+    if (!execution_result.Successful()) {
+      SCP_ERROR(kHttpConnection, kZeroUuid, execution_result,
+                "Failed to prewarm the connections to %s",
+                prewarm_uri.c_str());
+      return execution_result;
+    }
+  }
   return SuccessExecutionResult();
 }
 
 ExecutionResult HttpConnectionPool::Stop() noexcept {
-  is_running_ = false;
+  {
+    // Waits for the connections being recycled.
+    unique_lock lock(recycling_mutex_);
+    is_running_ = false;
+  }
+  // The tasks scheduled on the async executor capture the pool.
+  DrainScheduledTasks();
+
   vector<string> keys;
   auto execution_result = connections_.Keys(keys);
   if (!execution_result.Successful()) {
@@ -84,6 +113,16 @@ ExecutionResult HttpConnectionPool::Stop() noexcept {
         return execution_result;
       }
     }
+
+    PendingRequest pending_request;
+    while (entry->pending_contexts.TryDequeue(pending_request).Successful()) {
+      auto result = FailureExecutionResult(
+          errors::SC_HTTP2_CLIENT_CONNECTION_POOL_IS_NOT_AVAILABLE);
+      SCP_ERROR_CONTEXT(kHttpConnection, pending_request.http_context, result,
+                        "The queued request is dropped as the connection pool "
+                        "stopped.");
+      FinishContext(result, pending_request.http_context, async_executor_);
+    }
   }
 
   return SuccessExecutionResult();
@@ -92,13 +131,107 @@ ExecutionResult HttpConnectionPool::Stop() noexcept {
 shared_ptr<HttpConnection> HttpConnectionPool::CreateHttpConnection(
     string host, string service, bool is_https,
     TimeDuration http2_read_timeout_in_sec) {
-  return make_shared<HttpConnection>(async_executor_, host, service, is_https,
-                                     http2_read_timeout_in_sec_);
+  return make_shared<HttpConnection>(
+      async_executor_, host, service, is_https, http2_read_timeout_in_sec_,
+      max_concurrent_streams_per_connection_,
+      io_context_pool_ ? io_context_pool_->GetIoContext() : nullptr,
+      complete_callbacks_inline_);
 }
 
 ExecutionResult HttpConnectionPool::GetConnection(
     const shared_ptr<Uri>& uri,
     shared_ptr<HttpConnection>& connection) noexcept {
+  shared_ptr<HttpConnectionPoolEntry> http_connection_entry;
+  auto execution_result = GetPoolEntry(uri, http_connection_entry);
+  if (!execution_result.Successful()) {
+    return execution_result;
+  }
+  return SelectConnection(*http_connection_entry, connection);
+}
+
+ExecutionResult HttpConnectionPool::Execute(
+    AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept {
+  shared_ptr<HttpConnectionPoolEntry> http_connection_entry;
+  auto execution_result =
+      GetPoolEntry(http_context.request->path, http_connection_entry);
+  if (!execution_result.Successful()) {
+    return execution_result;
+  }
+  return ExecuteOnEntry(*http_connection_entry, http_context,
+                        /*endpoint=*/nullptr);
+}
+
+ExecutionResult HttpConnectionPool::PrepareEndpoint(
+    const shared_ptr<Uri>& uri, const HttpHeaders& static_headers,
+    shared_ptr<const PreparedEndpoint>& endpoint) noexcept {
+  shared_ptr<HttpConnectionPoolEntry> http_connection_entry;
+  auto execution_result = GetPoolEntry(uri, http_connection_entry);
+  if (!execution_result.Successful()) {
+    return execution_result;
+  }
+
+  auto encoded = make_shared<HttpEncodedEndpoint>();
+  encoded->uri = *uri;
+  for (const auto& [header, value] : static_headers) {
+    if (header == kContentLengthHeader || header == kClientActivityIdHeader) {
+      continue;
+    }
+    encoded->headers.insert({header, {value, false}});
+  }
+
+  auto prepared_endpoint = make_shared<PreparedEndpoint>();
+  prepared_endpoint->uri = uri;
+  prepared_endpoint->encoded = move(encoded);
+  prepared_endpoint->pool_entry = move(http_connection_entry);
+  endpoint = move(prepared_endpoint);
+  return SuccessExecutionResult();
+}
+
+ExecutionResult HttpConnectionPool::Execute(
+    const shared_ptr<const PreparedEndpoint>& endpoint,
+    AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept {
+  if (!is_running_) {
+    return FailureExecutionResult(
+        errors::SC_HTTP2_CLIENT_CONNECTION_POOL_IS_NOT_AVAILABLE);
+  }
+  // The request goes to the uri of the endpoint, a request that names another
+  // one is rejected rather than sent to the endpoint.
+  auto& path = http_context.request->path;
+  if (!path || path->empty()) {
+    path = endpoint->uri;
+  } else if (*path != *endpoint->uri) {
+    return FailureExecutionResult(
+        errors::SC_HTTP2_CLIENT_PREPARED_REQUEST_PATH_MISMATCH);
+  }
+  return ExecuteOnEntry(*endpoint->pool_entry, http_context,
+                        endpoint->encoded);
+}
+
+ExecutionResult HttpConnectionPool::GetInFlightStreamCounts(
+    map<string, vector<size_t>>& in_flight_stream_counts) noexcept {
+  vector<string> keys;
+  auto execution_result = connections_.Keys(keys);
+  if (!execution_result.Successful()) {
+    return execution_result;
+  }
+
+  for (const auto& key : keys) {
+    shared_ptr<HttpConnectionPoolEntry> entry;
+    if (!connections_.Find(key, entry).Successful() ||
+        !entry->is_initialized.load()) {
+      continue;
+    }
+    auto& counts = in_flight_stream_counts[key];
+    for (auto& connection : entry->http_connections) {
+      counts.push_back(connection->GetInFlightStreamCount());
+    }
+  }
+  return SuccessExecutionResult();
+}
+
+ExecutionResult HttpConnectionPool::GetPoolEntry(
+    const shared_ptr<Uri>& uri,
+    shared_ptr<HttpConnectionPoolEntry>& entry) noexcept {
   if (!is_running_) {
     return FailureExecutionResult(
         errors::SC_HTTP2_CLIENT_CONNECTION_POOL_IS_NOT_AVAILABLE);
@@ -123,12 +256,24 @@ ExecutionResult HttpConnectionPool::GetConnection(
     return FailureExecutionResult(errors::SC_HTTP2_CLIENT_INVALID_URI);
   }
 
-  auto http_connection_entry = make_shared<HttpConnectionPoolEntry>();
+  auto http_connection_entry =
+      make_shared<HttpConnectionPoolEntry>(max_pending_requests_per_host_);
   auto pair = std::make_pair(host + ":" + service, http_connection_entry);
   if (connections_.Insert(pair, http_connection_entry).Successful()) {
     for (size_t i = 0; i < max_connections_per_host_; ++i) {
       auto http_connection = CreateHttpConnection(host, service, is_https,
                                                   http2_read_timeout_in_sec_);
+      http_connection->SetStreamReleasedCallback(
+          [this, entry = weak_ptr<HttpConnectionPoolEntry>(
+                     http_connection_entry)]() { OnStreamReleased(entry); });
+      http_connection->SetReadyCallback(
+          [this, entry = weak_ptr<HttpConnectionPoolEntry>(
+                     http_connection_entry)](nanoseconds connect_duration) {
+            OnConnectionReady(connect_duration);
+            // Requests might be queued while the other connections are
+            // saturated.
+            OnStreamReleased(entry);
+          });
       http_connection_entry->http_connections.push_back(http_connection);
       auto execution_result = http_connection->Init();
 
@@ -150,13 +295,80 @@ ExecutionResult HttpConnectionPool::GetConnection(
   }
 
   if (!http_connection_entry->is_initialized.load()) {
+    not_ready_count_.fetch_add(1, std::memory_order_relaxed);
     return RetryExecutionResult(
         errors::SC_HTTP2_CLIENT_NO_CONNECTION_ESTABLISHED);
   }
 
-  auto value = http_connection_entry->order_counter.fetch_add(1);
+  entry = http_connection_entry;
+  return SuccessExecutionResult();
+}
+
+ExecutionResult HttpConnectionPool::SelectConnection(
+    HttpConnectionPoolEntry& entry,
+    shared_ptr<HttpConnection>& connection) noexcept {
+  if (selection_policy_ == HttpConnectionSelectionPolicy::RoundRobin) {
+    return SelectRoundRobinConnection(entry, connection);
+  }
+  return SelectLeastLoadedConnection(entry, connection);
+}
+
+ExecutionResult HttpConnectionPool::SelectConnectionAndReserveStream(
+    HttpConnectionPoolEntry& entry,
+    shared_ptr<HttpConnection>& connection) noexcept {
+  if (selection_policy_ == HttpConnectionSelectionPolicy::RoundRobin) {
+    // Round robin does not enforce the limit of streams of the connections.
+    auto execution_result = SelectRoundRobinConnection(entry, connection);
+    if (execution_result.Successful()) {
+      connection->ReserveStream();
+    }
+    return execution_result;
+  }
+
+  while (true) {
+    auto execution_result = SelectLeastLoadedConnection(entry, connection);
+    // Another request may have taken the last stream of the connection since
+    // it was chosen, the choice is then made again.
+    if (!execution_result.Successful() || connection->TryReserveStream()) {
+      return execution_result;
+    }
+  }
+}
+
+ExecutionResult HttpConnectionPool::ExecuteOnEntry(
+    HttpConnectionPoolEntry& entry,
+    AsyncContext<HttpRequest, HttpResponse>& http_context,
+    const shared_ptr<const HttpEncodedEndpoint>& endpoint) noexcept {
+  shared_ptr<HttpConnection> connection;
+  auto execution_result = SelectConnectionAndReserveStream(entry, connection);
+  if (execution_result ==
+      RetryExecutionResult(errors::SC_HTTP2_CLIENT_CONNECTION_POOL_SATURATED)) {
+    // The caller retries the request later if the queue is full as well.
+    if (!entry.pending_contexts
+             .TryEnqueue(PendingRequest{http_context, endpoint})
+             .Successful()) {
+      return execution_result;
+    }
+    // A stream might have been released before the request was queued.
+    ExecutePendingContexts(entry);
+    return SuccessExecutionResult();
+  }
+  if (!execution_result.Successful()) {
+    return execution_result;
+  }
+
+  SCP_DEBUG_CONTEXT(kHttpConnection, http_context,
+                    "Executing request on connection %p. Retry count: %lld",
+                    connection.get(), http_context.retry_count);
+  return connection->ExecuteOnReservedStream(http_context, endpoint);
+}
+
+ExecutionResult HttpConnectionPool::SelectRoundRobinConnection(
+    HttpConnectionPoolEntry& entry,
+    shared_ptr<HttpConnection>& connection) noexcept {
+  auto value = entry.order_counter.fetch_add(1);
   auto connections_index = value % max_connections_per_host_;
-  connection = http_connection_entry->http_connections.at(connections_index);
+  connection = entry.http_connections.at(connections_index);
 
   if (connection->IsDropped()) {
     RecycleConnection(connection);
@@ -165,9 +377,8 @@ ExecutionResult HttpConnectionPool::GetConnection(
     // waste.
     if (!connection->IsReady()) {
       size_t cur_index = connections_index;
-      for (int i = 0; i < http_connection_entry->http_connections.size(); i++) {
-        auto http_connection =
-            http_connection_entry->http_connections[cur_index];
+      for (int i = 0; i < entry.http_connections.size(); i++) {
+        auto http_connection = entry.http_connections[cur_index];
         if (http_connection->IsReady()) {
           connection = http_connection;
           break;
@@ -176,6 +387,7 @@ ExecutionResult HttpConnectionPool::GetConnection(
       }
       // Return a retry if we are not able to pick a ready connection.
       if (!connection->IsReady()) {
+        not_ready_count_.fetch_add(1, std::memory_order_relaxed);
         return RetryExecutionResult(
             errors::SC_HTTP2_CLIENT_HTTP_CONNECTION_NOT_READY);
       }
@@ -185,20 +397,271 @@ ExecutionResult HttpConnectionPool::GetConnection(
   return SuccessExecutionResult();
 }
 
+ExecutionResult HttpConnectionPool::SelectLeastLoadedConnection(
+    HttpConnectionPoolEntry& entry,
+    shared_ptr<HttpConnection>& connection) noexcept {
+  auto& http_connections = entry.http_connections;
+  shared_ptr<HttpConnection> selected_connection;
+  bool has_ready_connection = false;
+  auto consider_connection = [&](shared_ptr<HttpConnection> candidate) {
+    if (candidate->IsDropped()) {
+      RecycleConnection(candidate);
+    }
+    if (!candidate->IsReady()) {
+      return;
+    }
+    has_ready_connection = true;
+    if (candidate->IsSaturated()) {
+      return;
+    }
+    if (!selected_connection ||
+        candidate->GetInFlightStreamCount() <
+            selected_connection->GetInFlightStreamCount()) {
+      selected_connection = candidate;
+    }
+  };
+
+  if (selection_policy_ == HttpConnectionSelectionPolicy::PowerOfTwoChoices &&
+      http_connections.size() > 1) {
+    // Scrambles the counter so that consecutive requests sample unrelated
+    // pairs of distinct connections.
+    uint64_t sample = entry.order_counter.fetch_add(1) * 0x9E3779B97F4A7C15ULL;
+    auto connection_count = http_connections.size();
+    auto first_index = (sample >> 32) % connection_count;
+    auto second_index =
+        (first_index + 1 + (sample & 0xFFFFFFFF) % (connection_count - 1)) %
+        connection_count;
+    consider_connection(http_connections[first_index]);
+    consider_connection(http_connections[second_index]);
+  }
+
+  // Falls back to scanning all the connections when neither sample is usable.
+  if (!selected_connection) {
+    for (auto& http_connection : http_connections) {
+      consider_connection(http_connection);
+    }
+  }
+
+  if (!selected_connection) {
+    if (has_ready_connection) {
+      return RetryExecutionResult(
+          errors::SC_HTTP2_CLIENT_CONNECTION_POOL_SATURATED);
+    }
+    not_ready_count_.fetch_add(1, std::memory_order_relaxed);
+    return RetryExecutionResult(
+        errors::SC_HTTP2_CLIENT_HTTP_CONNECTION_NOT_READY);
+  }
+
+  connection = selected_connection;
+  return SuccessExecutionResult();
+}
+
+void HttpConnectionPool::OnStreamReleased(
+    const weak_ptr<HttpConnectionPoolEntry>& entry) noexcept {
+  auto http_connection_entry = entry.lock();
+  if (!http_connection_entry ||
+      http_connection_entry->pending_contexts.Size() == 0) {
+    return;
+  }
+
+  if (!BeginScheduledTask()) {
+    return;
+  }
+  // The stream is released on the thread of its connection, which must not be
+  // blocked by recycling connections while choosing one.
+  auto execution_result = async_executor_->Schedule(
+      [this, http_connection_entry]() {
+        ExecutePendingContexts(*http_connection_entry);
+        EndScheduledTask();
+      },
+      AsyncPriority::Normal);
+  if (!execution_result.Successful()) {
+    SCP_ERROR(kHttpConnection, kZeroUuid, execution_result,
+              "Failed to schedule the execution of the queued requests.");
+    EndScheduledTask();
+  }
+}
+
+bool HttpConnectionPool::BeginScheduledTask() noexcept {
+  unique_lock lock(scheduled_tasks_mutex_);
+  if (!is_running_) {
+    return false;
+  }
+  scheduled_task_count_++;
+  return true;
+}
+
+void HttpConnectionPool::EndScheduledTask() noexcept {
+  unique_lock lock(scheduled_tasks_mutex_);
+  if (--scheduled_task_count_ == 0) {
+    scheduled_tasks_condition_.notify_all();
+  }
+}
+
+void HttpConnectionPool::DrainScheduledTasks() noexcept {
+  unique_lock lock(scheduled_tasks_mutex_);
+  for (auto it = delayed_recycling_tasks_.begin();
+       it != delayed_recycling_tasks_.end();) {
+    auto& task = it->second;
+    if (!task.is_scheduled) {
+      // RecycleConnection cancels the task once it is scheduled.
+      task.is_cancelled = true;
+      it++;
+      continue;
+    }
+    // A task that could not be cancelled is about to run.
+    if (task.cancel && task.cancel()) {
+      task.connection->FinishRecycling();
+      scheduled_task_count_--;
+    }
+    it = delayed_recycling_tasks_.erase(it);
+  }
+  scheduled_tasks_condition_.wait(
+      lock, [this]() { return scheduled_task_count_ == 0; });
+}
+
+void HttpConnectionPool::ExecutePendingContexts(
+    HttpConnectionPoolEntry& entry) noexcept {
+  while (is_running_ && entry.pending_contexts.Size() > 0) {
+    shared_ptr<HttpConnection> connection;
+    if (!SelectConnectionAndReserveStream(entry, connection).Successful()) {
+      return;
+    }
+
+    PendingRequest pending_request;
+    if (!entry.pending_contexts.TryDequeue(pending_request).Successful()) {
+      connection->ReleaseReservedStream();
+      return;
+    }
+
+    auto& http_context = pending_request.http_context;
+    SCP_DEBUG_CONTEXT(kHttpConnection, http_context,
+                      "Executing queued request on connection %p.",
+                      connection.get());
+    auto execution_result =
+        connection->ExecuteOnReservedStream(http_context,
+                                            pending_request.endpoint);
+    if (!execution_result.Successful()) {
+      // A retry result is retried by the dispatcher of the request.
+      FinishContext(execution_result, http_context, async_executor_);
+    }
+  }
+}
+
 void HttpConnectionPool::RecycleConnection(
     std::shared_ptr<HttpConnection>& connection) noexcept {
-  lock_guard lock(connection_lock_);
+  if (!connection->IsDropped() || !connection->TryStartRecycling()) {
+    return;
+  }
 
-  if (!connection->IsDropped()) {
+  // The first reconnection is immediate, the following ones back off
+  // exponentially until the connection is ready again.
+  auto attempt_count = connection->GetRecycleAttemptCount();
+  TimeDuration backoff_ms = 0;
+  if (attempt_count > 0) {
+    backoff_ms = kHttp2ConnectionRecycleMaxBackoffInMs;
+    if (attempt_count <= kHttp2ConnectionRecycleMaxBackoffDoublings) {
+      backoff_ms = std::min(kHttp2ConnectionRecycleInitialBackoffInMs
+                                << (attempt_count - 1),
+                            kHttp2ConnectionRecycleMaxBackoffInMs);
+    }
+  }
+
+  if (!BeginScheduledTask()) {
+    connection->FinishRecycling();
+    return;
+  }
+  // The task is registered before it is scheduled, and unregisters itself
+  // when it starts, so that Stop can cancel it during its backoff.
+  uint64_t task_id;
+  {
+    unique_lock tasks_lock(scheduled_tasks_mutex_);
+    task_id = next_recycling_task_id_++;
+    delayed_recycling_tasks_[task_id].connection = connection;
+  }
+  std::function<bool()> cancel;
+  auto execution_result = async_executor_->ScheduleFor(
+      [this, connection, task_id]() {
+        {
+          unique_lock tasks_lock(scheduled_tasks_mutex_);
+          delayed_recycling_tasks_.erase(task_id);
+        }
+        {
+          shared_lock lock(recycling_mutex_);
+          if (is_running_) {
+            auto execution_result = connection->Recycle();
+            if (execution_result.Successful()) {
+              SCP_DEBUG(kHttpConnection, common::kZeroUuid,
+                        "Successfully recycled connection %p",
+                        connection.get());
+            } else {
+              SCP_ERROR(kHttpConnection, common::kZeroUuid, execution_result,
+                        "Failed to recycle connection %p", connection.get());
+            }
+          }
+        }
+        connection->FinishRecycling();
+        EndScheduledTask();
+      },
+      TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks() +
+          duration_cast<nanoseconds>(milliseconds(backoff_ms)).count(),
+      cancel);
+  if (!execution_result.Successful()) {
+    {
+      unique_lock tasks_lock(scheduled_tasks_mutex_);
+      delayed_recycling_tasks_.erase(task_id);
+    }
+    SCP_ERROR(kHttpConnection, common::kZeroUuid, execution_result,
+              "Failed to schedule recycling connection %p", connection.get());
+    connection->FinishRecycling();
+    EndScheduledTask();
     return;
   }
 
-  connection->Stop();
-  connection->Reset();
-  connection->Init();
-  connection->Run();
+  {
+    unique_lock tasks_lock(scheduled_tasks_mutex_);
+    auto task_it = delayed_recycling_tasks_.find(task_id);
+    // The task already started.
+    if (task_it == delayed_recycling_tasks_.end()) {
+      return;
+    }
+    if (!task_it->second.is_cancelled) {
+      task_it->second.cancel = move(cancel);
+      task_it->second.is_scheduled = true;
+      return;
+    }
+    delayed_recycling_tasks_.erase(task_it);
+  }
+  // Stop came while the task was being scheduled.
+  if (cancel && cancel()) {
+    connection->FinishRecycling();
+    EndScheduledTask();
+  }
+}
+
+void HttpConnectionPool::OnConnectionReady(
+    nanoseconds connect_duration) noexcept {
+  connect_count_.fetch_add(1, std::memory_order_relaxed);
+  connect_duration_total_ns_.fetch_add(connect_duration.count(),
+                                       std::memory_order_relaxed);
+  auto max_connect_duration_ns =
+      connect_duration_max_ns_.load(std::memory_order_relaxed);
+  while (static_cast<uint64_t>(connect_duration.count()) >
+             max_connect_duration_ns &&
+         !connect_duration_max_ns_.compare_exchange_weak(
+             max_connect_duration_ns, connect_duration.count(),
+             std::memory_order_relaxed)) {}
+}
 
-  SCP_DEBUG(kHttpConnection, common::kZeroUuid,
-            "Successfully recycled connection %p", connection.get());
+HttpConnectionReadinessMetrics
+HttpConnectionPool::GetConnectionReadinessMetrics() noexcept {
+  HttpConnectionReadinessMetrics metrics;
+  metrics.connect_count = connect_count_.load(std::memory_order_relaxed);
+  metrics.total_connect_duration_ns =
+      connect_duration_total_ns_.load(std::memory_order_relaxed);
+  metrics.max_connect_duration_ns =
+      connect_duration_max_ns_.load(std::memory_order_relaxed);
+  metrics.not_ready_count = not_ready_count_.load(std::memory_order_relaxed);
+  return metrics;
 }
 }  // namespace google::scp::core
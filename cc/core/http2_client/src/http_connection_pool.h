@@ -17,69 +17,183 @@
 
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <nghttp2/asio_http2_client.h>
 
 #include "cc/core/interface/async_context.h"
 #include "core/common/concurrent_map/src/concurrent_map.h"
+#include "core/common/concurrent_queue/src/concurrent_queue.h"
 #include "public/core/interface/execution_result.h"
 
 #include "error_codes.h"
 #include "http_connection.h"
+#include "http_io_context_pool.h"
 
 namespace google::scp::core {
+/// The delay before the second attempt to reconnect a dropped connection.
+static constexpr TimeDuration kHttp2ConnectionRecycleInitialBackoffInMs = 100;
+/// The max delay between two attempts to reconnect a dropped connection.
+static constexpr TimeDuration kHttp2ConnectionRecycleMaxBackoffInMs = 10000;
+/// The number of attempts after which the backoff is at its max.
+static constexpr size_t kHttp2ConnectionRecycleMaxBackoffDoublings = 16;
+
+/// How long the connections of a pool took to connect, and how often requests
+/// found no ready connection. The connect durations are measured per
+/// connection, they are not the time requests waited for a connection.
+struct HttpConnectionReadinessMetrics {
+  /// The number of times a connection connected.
+  uint64_t connect_count = 0;
+  /// The total time from starting to connect to being connected, over all the
+  /// connections.
+  uint64_t total_connect_duration_ns = 0;
+  /// The longest time from starting to connect to being connected.
+  uint64_t max_connect_duration_ns = 0;
+  /// The number of request attempts which found no ready connection and had
+  /// to be retried.
+  uint64_t not_ready_count = 0;
+};
+
+/// How the connection of a host is chosen for a request.
+enum class HttpConnectionSelectionPolicy {
+  /// The connections are chosen in turn, regardless of their load.
+  RoundRobin = 0,
+  /// The ready connection with the fewest streams in flight is chosen.
+  LeastOutstandingStreams = 1,
+  /// Two connections are sampled and the one with fewer streams in flight is
+  /// chosen, which avoids scanning all the connections of the host.
+  PowerOfTwoChoices = 2,
+};
+
 /**
  * @brief Provides connection pool functionality. Once the object is created,
  * the caller can get a connection to the remote host by calling get connection.
- * The order of the connections is chosen in a round robin fashion.
+ * The order of the connections is chosen according to the selection policy.
+ *
+ * With the load aware policies, the connections at their limit of concurrent
+ * streams are skipped. Once all the connections of a host are saturated, the
+ * requests executed through the pool are queued per host and executed as
+ * streams are released.
  *
+ * Dropped connections are reconnected in the background on the async
+ * executor, with an exponential backoff, while the requests are served by the
+ * other connections of the host.
  */
 class HttpConnectionPool : public ServiceInterface {
  protected:
+  /// A request queued while all the connections of its host are saturated.
+  struct PendingRequest {
+    /// The context of the http operation.
+    AsyncContext<HttpRequest, HttpResponse> http_context;
+    /// The encoded endpoint of the request, if it was prepared.
+    std::shared_ptr<const HttpEncodedEndpoint> endpoint;
+  };
+
   /**
    * @brief The http connection pool entry to be kept in the concurrent map of
    * the active connections.
    */
   struct HttpConnectionPoolEntry {
-    HttpConnectionPoolEntry() : is_initialized(false), order_counter(0) {}
+    explicit HttpConnectionPoolEntry(size_t max_pending_requests)
+        : is_initialized(false),
+          order_counter(0),
+          pending_contexts(max_pending_requests) {}
 
     /// The current cached connections.
     std::vector<std::shared_ptr<HttpConnection>> http_connections;
     /// Indicates whether the entry is initialized.
     std::atomic<bool> is_initialized;
-    /// Is used to apply a round robin fashion selection of the connections.
+    /// Is used to apply a round robin fashion selection of the connections,
+    /// and to sample the connections for the power of two choices.
     std::atomic<uint64_t> order_counter;
+    /// The requests waiting for a stream while all the connections are
+    /// saturated.
+    common::ConcurrentQueue<PendingRequest> pending_contexts;
   };
 
  public:
+  /**
+   * @brief An endpoint resolved once by PrepareEndpoint. The requests executed
+   * on it skip parsing the uri, looking its host up in the pool and encoding
+   * the static headers.
+   */
+  struct PreparedEndpoint {
+    /// The uri of the endpoint, set as the path of the requests without one.
+    std::shared_ptr<Uri> uri;
+    /// The uri and the static headers encoded for the connections.
+    std::shared_ptr<const HttpEncodedEndpoint> encoded;
+    /// The pool entry of the host of the endpoint.
+    std::shared_ptr<HttpConnectionPoolEntry> pool_entry;
+  };
+
   /**
    * @brief Constructs a new Http Connection Pool object
    *
    * @param async_executor An instance of the async executor.
    * @param max_connections_per_host The max number of connections created per
    * host.
+   * @param http2_read_timeout_in_sec nghttp2 read timeout in second.
+   * @param selection_policy How the connection of a host is chosen.
+   * @param max_concurrent_streams_per_connection The max number of streams in
+   * flight per connection, used by the load aware policies.
+   * @param max_pending_requests_per_host The max number of requests queued per
+   * host while its connections are saturated.
+   * @param io_context_pool The io contexts to run the connections on. If
+   * null, each connection runs its own io context on a dedicated thread.
+   * @param complete_callbacks_inline If true, the callbacks of the requests
+   * are invoked on the io threads instead of the async executor.
+   * @param prewarm_uris The uris of the hosts to connect to at Run, ahead of
+   * their first request.
    */
   explicit HttpConnectionPool(
       const std::shared_ptr<AsyncExecutorInterface>& async_executor,
       size_t max_connections_per_host = kDefaultMaxConnectionsPerHost,
       TimeDuration http2_read_timeout_in_sec =
-          kDefaultHttp2ReadTimeoutInSeconds)
+          kDefaultHttp2ReadTimeoutInSeconds,
+      HttpConnectionSelectionPolicy selection_policy =
+          HttpConnectionSelectionPolicy::RoundRobin,
+      size_t max_concurrent_streams_per_connection =
+          kDefaultHttp2MaxConcurrentStreamsPerConnection,
+      size_t max_pending_requests_per_host =
+          kDefaultHttp2MaxPendingRequestsPerHost,
+      std::shared_ptr<HttpIoContextPool> io_context_pool = nullptr,
+      bool complete_callbacks_inline = false,
+      std::vector<std::string> prewarm_uris = {})
       : async_executor_(async_executor),
         max_connections_per_host_(max_connections_per_host),
         http2_read_timeout_in_sec_(http2_read_timeout_in_sec),
-        is_running_(false) {}
+        selection_policy_(selection_policy),
+        max_concurrent_streams_per_connection_(
+            max_concurrent_streams_per_connection),
+        max_pending_requests_per_host_(max_pending_requests_per_host),
+        io_context_pool_(io_context_pool),
+        complete_callbacks_inline_(complete_callbacks_inline),
+        prewarm_uris_(std::move(prewarm_uris)),
+        is_running_(false),
+        connect_count_(0),
+        connect_duration_total_ns_(0),
+        connect_duration_max_ns_(0),
+        not_ready_count_(0) {}
 
   ExecutionResult Init() noexcept;
   ExecutionResult Run() noexcept;
   ExecutionResult Stop() noexcept;
 
   /**
-   * @brief Gets a connection for the provided uri.
+   * @brief Gets a connection for the provided uri. No stream is reserved on
+   * the connection, so the limit of streams in flight is only enforced for
+   * the requests executed through the pool.
    *
    * @param uri The uri to create a http connection to.
    * @param connection The created/cached connection.
@@ -89,7 +203,174 @@ class HttpConnectionPool : public ServiceInterface {
       const std::shared_ptr<Uri>& uri,
       std::shared_ptr<HttpConnection>& connection) noexcept;
 
+  /**
+   * @brief Executes the http request on a connection to the host of its path.
+   * If all the connections of the host are saturated, the request is queued
+   * until a stream is released.
+   *
+   * @param http_context The context of the http operation.
+   * @return ExecutionResult The execution result of the operation.
+   */
+  ExecutionResult Execute(
+      AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept;
+
+  /**
+   * @brief Resolves the host of the uri to its pool entry, creating its
+   * connections if needed, and encodes the uri and the static headers once
+   * for all the requests to the endpoint. The content length and the client
+   * activity id headers are set per request and cannot be static.
+   *
+   * @param uri The uri of the endpoint.
+   * @param static_headers The headers sent with every request to the endpoint.
+   * @param endpoint The prepared endpoint.
+   * @return ExecutionResult The execution result of the operation.
+   */
+  ExecutionResult PrepareEndpoint(
+      const std::shared_ptr<Uri>& uri, const HttpHeaders& static_headers,
+      std::shared_ptr<const PreparedEndpoint>& endpoint) noexcept;
+
+  /**
+   * @brief Executes the http request on a connection to the prepared endpoint,
+   * in the same way as Execute. The path of the request is set to the uri of
+   * the endpoint if empty, its query and headers are added to the ones of the
+   * endpoint.
+   *
+   * @param endpoint The endpoint prepared by PrepareEndpoint.
+   * @param http_context The context of the http operation.
+   * @return ExecutionResult The execution result of the operation.
+   */
+  ExecutionResult Execute(
+      const std::shared_ptr<const PreparedEndpoint>& endpoint,
+      AsyncContext<HttpRequest, HttpResponse>& http_context) noexcept;
+
+  /**
+   * @brief Gets the number of streams in flight on each connection, keyed by
+   * the host and port of the connections.
+   *
+   * @param in_flight_stream_counts The counts, in the order of the
+   * connections of each host.
+   * @return ExecutionResult The execution result of the operation.
+   */
+  ExecutionResult GetInFlightStreamCounts(
+      std::map<std::string, std::vector<size_t>>&
+          in_flight_stream_counts) noexcept;
+
+  /**
+   * @brief Gets the connect durations of the connections and the number of
+   * requests which found no ready connection since the pool was created.
+   */
+  HttpConnectionReadinessMetrics GetConnectionReadinessMetrics() noexcept;
+
  protected:
+  /**
+   * @brief Gets the pool entry of the host of the uri, and creates its
+   * connections for the first time.
+   *
+   * @param uri The uri to create the http connections to.
+   * @param entry The created/cached entry.
+   * @return ExecutionResult The execution result of the operation.
+   */
+  ExecutionResult GetPoolEntry(
+      const std::shared_ptr<Uri>& uri,
+      std::shared_ptr<HttpConnectionPoolEntry>& entry) noexcept;
+
+  /**
+   * @brief Chooses a connection of the entry according to the selection
+   * policy.
+   *
+   * @param entry The pool entry of the host.
+   * @param connection The chosen connection.
+   * @return ExecutionResult The execution result of the operation.
+   */
+  ExecutionResult SelectConnection(
+      HttpConnectionPoolEntry& entry,
+      std::shared_ptr<HttpConnection>& connection) noexcept;
+
+  /**
+   * @brief Chooses a connection of the entry according to the selection
+   * policy and reserves a stream on it. With the least loaded policies, the
+   * connection is chosen again if it became saturated since it was chosen.
+   *
+   * @param entry The pool entry of the host.
+   * @param connection The chosen connection, holding a stream reserved for the
+   * caller.
+   * @return ExecutionResult The execution result of the operation.
+   */
+  ExecutionResult SelectConnectionAndReserveStream(
+      HttpConnectionPoolEntry& entry,
+      std::shared_ptr<HttpConnection>& connection) noexcept;
+
+  /**
+   * @brief Executes the http request on a connection of the entry, or queues
+   * it if all the connections are saturated.
+   *
+   * @param entry The pool entry of the host of the request.
+   * @param http_context The context of the http operation.
+   * @param endpoint The encoded endpoint of the request, if it was prepared.
+   * @return ExecutionResult The execution result of the operation.
+   */
+  ExecutionResult ExecuteOnEntry(
+      HttpConnectionPoolEntry& entry,
+      AsyncContext<HttpRequest, HttpResponse>& http_context,
+      const std::shared_ptr<const HttpEncodedEndpoint>& endpoint) noexcept;
+
+  /**
+   * @brief Chooses the connection of the entry in a round robin fashion.
+   */
+  ExecutionResult SelectRoundRobinConnection(
+      HttpConnectionPoolEntry& entry,
+      std::shared_ptr<HttpConnection>& connection) noexcept;
+
+  /**
+   * @brief Chooses the ready connection of the entry with the fewest streams
+   * in flight among a sample of two connections, or among all of them.
+   */
+  ExecutionResult SelectLeastLoadedConnection(
+      HttpConnectionPoolEntry& entry,
+      std::shared_ptr<HttpConnection>& connection) noexcept;
+
+  /**
+   * @brief Is called when a stream of a connection of the entry is released.
+   * Schedules the execution of the requests queued on the entry, if any.
+   *
+   * @param entry The pool entry of the host of the connection.
+   */
+  void OnStreamReleased(
+      const std::weak_ptr<HttpConnectionPoolEntry>& entry) noexcept;
+
+  /**
+   * @brief Executes the requests queued on the entry for as long as one of its
+   * connections has a stream available.
+   *
+   * @param entry The pool entry of the host.
+   */
+  void ExecutePendingContexts(HttpConnectionPoolEntry& entry) noexcept;
+
+  /**
+   * @brief Counts a task that the pool schedules on the async executor, so
+   * that Stop waits for it. Fails once the pool is stopping.
+   *
+   * @return bool Whether the task may be scheduled.
+   */
+  bool BeginScheduledTask() noexcept;
+
+  /// @brief Is called when a task counted by BeginScheduledTask is over.
+  void EndScheduledTask() noexcept;
+
+  /**
+   * @brief Cancels the recycling tasks that did not start yet and waits for
+   * the other scheduled tasks to be over.
+   */
+  void DrainScheduledTasks() noexcept;
+
+  /**
+   * @brief Is called when a connection becomes ready.
+   *
+   * @param connect_duration The time from starting to connect to being
+   * connected.
+   */
+  void OnConnectionReady(std::chrono::nanoseconds connect_duration) noexcept;
+
   /**
    * @brief Create a Http Connection object
    *
@@ -104,7 +385,9 @@ class HttpConnectionPool : public ServiceInterface {
 
   /**
    * @brief If a connection goes bad for any reason, the connection pool will
-   * recycle the connection by stopping it and reseting the object.
+   * recycle the connection by stopping it and reseting the object. The
+   * connection is recycled on the async executor, after a backoff if it
+   * failed to become ready since it was last recycled.
    *
    * @param connection The connection to be recycled.
    */
@@ -120,6 +403,24 @@ class HttpConnectionPool : public ServiceInterface {
   /// http2 connection read timeout in seconds.
   TimeDuration http2_read_timeout_in_sec_;
 
+  /// How the connection of a host is chosen.
+  const HttpConnectionSelectionPolicy selection_policy_;
+
+  /// Max number of streams in flight per connection.
+  const size_t max_concurrent_streams_per_connection_;
+
+  /// Max number of requests queued per host.
+  const size_t max_pending_requests_per_host_;
+
+  /// The io contexts shared by the connections, if any.
+  const std::shared_ptr<HttpIoContextPool> io_context_pool_;
+
+  /// Whether the callbacks are invoked on the io threads.
+  const bool complete_callbacks_inline_;
+
+  /// The uris of the hosts to connect to at Run.
+  const std::vector<std::string> prewarm_uris_;
+
   /// The pool of all the connections.
   core::common::ConcurrentMap<std::string,
                               std::shared_ptr<HttpConnectionPoolEntry>>
@@ -127,7 +428,34 @@ class HttpConnectionPool : public ServiceInterface {
 
   /// Indicates whether the connection pool is running.
   std::atomic<bool> is_running_;
-  /// Mutex for recycling connection
-  std::mutex connection_lock_;
+  /// Held shared while recycling a connection, and exclusively to stop.
+  std::shared_mutex recycling_mutex_;
+
+  /// Guards the counts of the tasks scheduled on the async executor, which
+  /// capture the pool and must be over before it is stopped.
+  std::mutex scheduled_tasks_mutex_;
+  std::condition_variable scheduled_tasks_condition_;
+  size_t scheduled_task_count_ = 0;
+  /// A recycling task that may still wait for its backoff.
+  struct DelayedRecyclingTask {
+    /// Cancels the task, unset until the task is scheduled.
+    std::function<bool()> cancel;
+    /// The connection the task recycles.
+    std::shared_ptr<HttpConnection> connection;
+    /// Whether the task was handed to the async executor.
+    bool is_scheduled = false;
+    /// Set by Stop when the task was not scheduled yet, so that it is
+    /// cancelled once it is.
+    bool is_cancelled = false;
+  };
+  /// The recycling tasks that did not start yet by task ID.
+  std::unordered_map<uint64_t, DelayedRecyclingTask> delayed_recycling_tasks_;
+  uint64_t next_recycling_task_id_ = 0;
+
+  /// The metrics of the connect durations and of the not ready connections.
+  std::atomic<uint64_t> connect_count_;
+  std::atomic<uint64_t> connect_duration_total_ns_;
+  std::atomic<uint64_t> connect_duration_max_ns_;
+  std::atomic<uint64_t> not_ready_count_;
 };
 }  // namespace google::scp::core
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "http_io_context_pool.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+#include "core/async_executor/src/async_executor_utils.h"
+#include "core/common/global_logger/src/global_logger.h"
+#include "core/common/uuid/src/uuid.h"
+
+using boost::asio::executor_work_guard;
+using boost::asio::io_context;
+using boost::asio::make_work_guard;
+using google::scp::core::common::kZeroUuid;
+using std::make_shared;
+using std::make_unique;
+using std::shared_ptr;
+using std::thread;
+
+static constexpr char kHttpIoContextPool[] = "HttpIoContextPool";
+
+namespace google::scp::core {
+HttpIoContextPool::HttpIoContextPool(size_t thread_count, bool pin_threads)
+    : thread_count_(thread_count > 0
+                        ? thread_count
+                        : std::max(thread::hardware_concurrency(), 1u)),
+      pin_threads_(pin_threads),
+      order_counter_(0) {}
+
+ExecutionResult HttpIoContextPool::Init() noexcept {
+  for (size_t i = 0; i < thread_count_; i++) {
+    auto context = make_shared<io_context>(/*concurrency_hint=*/1);
+    work_guards_.push_back(
+        make_unique<executor_work_guard<io_context::executor_type>>(
+            make_work_guard(context->get_executor())));
+    io_contexts_.push_back(context);
+  }
+  return SuccessExecutionResult();
+}
+
+ExecutionResult HttpIoContextPool::Run() noexcept {
+  for (size_t i = 0; i < thread_count_; i++) {
+    threads_.emplace_back([this, i]() {
+      if (pin_threads_) {
+        // The connections keep working unpinned if the core is not available.
+        AsyncExecutorUtils::SetAffinity(i % thread::hardware_concurrency());
+      }
+      while (true) {
+        try {
+          io_contexts_[i]->run();
+          return;
+        } catch (...) {
+          // A handler of a connection threw, the other connections of the io
+          // context keep being served.
+          SCP_ERROR(kHttpIoContextPool, kZeroUuid,
+                    FailureExecutionResult(SC_UNKNOWN),
+                    "An io context handler threw an exception.");
+        }
+      }
+    });
+  }
+  return SuccessExecutionResult();
+}
+
+ExecutionResult HttpIoContextPool::Stop() noexcept {
+  // The connections are stopped first, so that only their pending handlers are
+  // left to run. The io contexts are not stopped, each thread returns once its
+  // io context ran out of handlers, which release the sessions of the
+  // connections among others.
+  for (auto& work_guard : work_guards_) {
+    work_guard->reset();
+  }
+  for (auto& io_thread : threads_) {
+    if (io_thread.joinable()) {
+      io_thread.join();
+    }
+  }
+  threads_.clear();
+  return SuccessExecutionResult();
+}
+
+shared_ptr<io_context> HttpIoContextPool::GetIoContext() noexcept {
+  return io_contexts_[order_counter_.fetch_add(1) % io_contexts_.size()];
+}
+
+size_t HttpIoContextPool::GetThreadCount() const noexcept {
+  return thread_count_;
+}
+}  // namespace google::scp::core
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+
+#include "core/interface/service_interface.h"
+#include "public/core/interface/execution_result.h"
+
+namespace google::scp::core {
+/**
+ * @brief HttpIoContextPool runs a fixed set of io contexts, each on its own
+ * thread, which the http connections are multiplexed onto instead of running
+ * an io context and a thread per connection.
+ */
+class HttpIoContextPool : public ServiceInterface {
+ public:
+  /**
+   * @brief Construct a new Http Io Context Pool object
+   *
+   * @param thread_count The number of io contexts and threads, one per core
+   * if 0.
+   * @param pin_threads If true, the thread of the i-th io context is pinned to
+   * the core i modulo the number of cores.
+   */
+  explicit HttpIoContextPool(size_t thread_count = 0, bool pin_threads = false);
+
+  ExecutionResult Init() noexcept override;
+  ExecutionResult Run() noexcept override;
+  ExecutionResult Stop() noexcept override;
+
+  /**
+   * @brief Gets the io context for a new connection. The io contexts are
+   * handed out in a round robin fashion.
+   */
+  std::shared_ptr<boost::asio::io_context> GetIoContext() noexcept;
+
+  /// Gets the number of io contexts.
+  size_t GetThreadCount() const noexcept;
+
+ private:
+  /// The number of io contexts and threads.
+  const size_t thread_count_;
+  /// Whether the threads are pinned to the cores.
+  const bool pin_threads_;
+  /// The io contexts.
+  std::vector<std::shared_ptr<boost::asio::io_context>> io_contexts_;
+  /// Keep the io contexts running while no connection uses them.
+  std::vector<std::unique_ptr<boost::asio::executor_work_guard<
+      boost::asio::io_context::executor_type>>>
+      work_guards_;
+  /// The threads running the io contexts.
+  std::vector<std::thread> threads_;
+  /// Is used to hand out the io contexts in a round robin fashion.
+  std::atomic<uint64_t> order_counter_;
+};
+}  // namespace google::scp::core
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core/http2_client/src/chained_bytes_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+
+using std::string;
+
+namespace google::scp::core::test {
+namespace {
+/// Appends the string to the buffer in chunks of chunk_size bytes.
+void AppendInChunks(ChainedBytesBuffer& buffer, const string& data,
+                    size_t chunk_size) {
+  for (size_t offset = 0; offset < data.size(); offset += chunk_size) {
+    buffer.Append(reinterpret_cast<const uint8_t*>(data.data()) + offset,
+                  std::min(chunk_size, data.size() - offset));
+  }
+}
+
+string MakeData(size_t length) {
+  string data(length, 0);
+  for (size_t i = 0; i < length; i++) {
+    data[i] = static_cast<char>(i * 31 + 7);
+  }
+  return data;
+}
+}  // namespace
+
+TEST(ChainedBytesBufferTest, EmptyBuffer) {
+  ChainedBytesBuffer buffer;
+  EXPECT_EQ(buffer.Length(), 0);
+
+  auto bytes_buffer = buffer.Release();
+  EXPECT_EQ(bytes_buffer.length, 0);
+  ASSERT_NE(bytes_buffer.bytes, nullptr);
+  EXPECT_EQ(bytes_buffer.bytes->size(), 0);
+}
+
+TEST(ChainedBytesBufferTest, UnknownLength) {
+  auto data = MakeData(10 * kChainedBytesBufferBlockSize + 123);
+  ChainedBytesBuffer buffer;
+  AppendInChunks(buffer, data, 16 * 1024 + 1);
+  EXPECT_EQ(buffer.Length(), data.size());
+
+  auto bytes_buffer = buffer.Release();
+  EXPECT_EQ(bytes_buffer.length, data.size());
+  EXPECT_EQ(bytes_buffer.capacity, data.size());
+  EXPECT_EQ(bytes_buffer.ToString(), data);
+  EXPECT_EQ(buffer.Length(), 0);
+}
+
+TEST(ChainedBytesBufferTest, SmallBodyOfUnknownLengthIsCompacted) {
+  auto data = MakeData(13);
+  ChainedBytesBuffer buffer;
+  AppendInChunks(buffer, data, 5);
+
+  auto bytes_buffer = buffer.Release();
+  EXPECT_EQ(bytes_buffer.ToString(), data);
+  EXPECT_LT(bytes_buffer.bytes->capacity(), kChainedBytesBufferBlockSize);
+}
+
+TEST(ChainedBytesBufferTest, KnownLengthFitsASingleBlock) {
+  auto data = MakeData(3 * kChainedBytesBufferBlockSize);
+  ChainedBytesBuffer buffer(data.size());
+  AppendInChunks(buffer, data, 4096);
+
+  // The block is allocated at the expected length and handed out as is.
+  auto bytes_buffer = buffer.Release();
+  EXPECT_EQ(bytes_buffer.ToString(), data);
+  EXPECT_EQ(bytes_buffer.bytes->capacity(), data.size());
+}
+
+TEST(ChainedBytesBufferTest, LongerThanExpected) {
+  auto data = MakeData(2 * kChainedBytesBufferBlockSize);
+  ChainedBytesBuffer buffer(kChainedBytesBufferBlockSize / 2);
+  AppendInChunks(buffer, data, 3000);
+
+  auto bytes_buffer = buffer.Release();
+  EXPECT_EQ(bytes_buffer.length, data.size());
+  EXPECT_EQ(bytes_buffer.ToString(), data);
+}
+}  // namespace google::scp::core::test
@@ -0,0 +1,177 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <nghttp2/asio_http2_server.h>
+
+#include "core/async_executor/src/async_executor.h"
+#include "core/common/time_provider/src/time_provider.h"
+#include "core/http2_client/src/http2_client.h"
+#include "core/test/utils/conditional_wait.h"
+#include "public/core/test/interface/execution_result_matchers.h"
+
+using google::scp::core::common::RetryStrategyOptions;
+using google::scp::core::common::RetryStrategyType;
+using google::scp::core::common::TimeProvider;
+using nghttp2::asio_http2::server::http2;
+using nghttp2::asio_http2::server::request;
+using nghttp2::asio_http2::server::response;
+using std::atomic;
+using std::cout;
+using std::endl;
+using std::function;
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+
+namespace google::scp::core::test {
+class Http2ClientBenchmarkTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    boost::system::error_code ec;
+    server_.num_threads(1);
+    server_.handle("/test", [](const request& req, const response& res) {
+      res.write_head(200);
+      res.end("hello, world\n");
+    });
+    server_.listen_and_serve(ec, "localhost", "0", /*asynchronous=*/true);
+    ASSERT_FALSE(ec);
+    uri_ = make_shared<Uri>("http://localhost:" +
+                            std::to_string(server_.ports()[0]) + "/test");
+
+    async_executor_ = make_shared<AsyncExecutor>(/*thread_count=*/1,
+                                                 /*queue_cap=*/100000);
+    EXPECT_SUCCESS(async_executor_->Init());
+    EXPECT_SUCCESS(async_executor_->Run());
+    // A single connection, so that the client work is done on one io thread.
+    http_client_ = make_shared<HttpClient>(
+        async_executor_,
+        HttpClientOptions(RetryStrategyOptions(RetryStrategyType::Exponential,
+                                               kDefaultRetryStrategyDelayInMs,
+                                               kDefaultRetryStrategyMaxRetries),
+                          /*max_connections_per_host=*/1,
+                          kDefaultHttp2ReadTimeoutInSeconds));
+    EXPECT_SUCCESS(http_client_->Init());
+    EXPECT_SUCCESS(http_client_->Run());
+  }
+
+  void TearDown() override {
+    EXPECT_SUCCESS(http_client_->Stop());
+    EXPECT_SUCCESS(async_executor_->Stop());
+    server_.stop();
+    server_.join();
+  }
+
+  /**
+   * @brief Sends the requests with at most in_flight_count_ of them in flight,
+   * and reports the requests per second, and per CPU second of the process.
+   * The server runs in the process as well.
+   */
+  void RunWorkload(
+      const string& name,
+      function<ExecutionResult(AsyncContext<HttpRequest, HttpResponse>&)>
+          perform_request,
+      function<shared_ptr<HttpRequest>()> make_request) {
+    atomic<size_t> sent_count = 0;
+    atomic<size_t> finished_count = 0;
+    function<void()> send_request = [&]() {
+      if (sent_count.fetch_add(1) >= request_count_) {
+        return;
+      }
+      AsyncContext<HttpRequest, HttpResponse> http_context(
+          make_request(),
+          [&](AsyncContext<HttpRequest, HttpResponse>& http_context) {
+            EXPECT_SUCCESS(http_context.result);
+            finished_count++;
+            send_request();
+          });
+      EXPECT_SUCCESS(perform_request(http_context));
+    };
+
+    auto start_cpu = std::clock();
+    auto start = TimeProvider::GetSteadyTimestampInNanoseconds();
+    for (size_t i = 0; i < in_flight_count_; i++) {
+      send_request();
+    }
+    WaitUntil([&]() { return finished_count == request_count_; },
+              milliseconds(60000));
+    auto elapsed_ms = duration_cast<milliseconds>(
+                          TimeProvider::GetSteadyTimestampInNanoseconds() -
+                          start)
+                          .count();
+    auto cpu_ms = (std::clock() - start_cpu) * 1000 / CLOCKS_PER_SEC;
+
+    cout << name << ": " << request_count_ << " requests in " << elapsed_ms
+         << " ms, " << request_count_ * 1000 / std::max<int64_t>(elapsed_ms, 1)
+         << " requests/s, "
+         << request_count_ * 1000 / std::max<int64_t>(cpu_ms, 1)
+         << " requests per CPU second" << endl;
+  }
+
+  http2 server_;
+  shared_ptr<Uri> uri_;
+  shared_ptr<AsyncExecutorInterface> async_executor_;
+  shared_ptr<HttpClient> http_client_;
+  size_t request_count_ = 200000;
+  size_t in_flight_count_ = 64;
+};
+
+TEST_F(Http2ClientBenchmarkTest, PerformRequest) {
+  GTEST_SKIP();
+  RunWorkload(
+      "PerformRequest",
+      [&](AsyncContext<HttpRequest, HttpResponse>& http_context) {
+        return http_client_->PerformRequest(http_context);
+      },
+      [&]() {
+        auto request = make_shared<HttpRequest>();
+        request->method = HttpMethod::GET;
+        request->path = uri_;
+        request->headers = make_shared<HttpHeaders>(
+            HttpHeaders{{"x-static-header-1", "value-1"},
+                        {"x-static-header-2", "value-2"}});
+        return request;
+      });
+}
+
+TEST_F(Http2ClientBenchmarkTest, PerformPreparedRequest) {
+  GTEST_SKIP();
+  auto endpoint = http_client_->PrepareEndpoint(
+      uri_, HttpHeaders{{"x-static-header-1", "value-1"},
+                        {"x-static-header-2", "value-2"}});
+  ASSERT_SUCCESS(endpoint.result());
+  RunWorkload(
+      "PerformPreparedRequest",
+      [&](AsyncContext<HttpRequest, HttpResponse>& http_context) {
+        return http_client_->PerformPreparedRequest(*endpoint, http_context);
+      },
+      [&]() {
+        auto request = make_shared<HttpRequest>();
+        request->method = HttpMethod::GET;
+        return request;
+      });
+}
+}  // namespace google::scp::core::test
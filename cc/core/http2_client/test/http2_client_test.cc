@@ -23,6 +23,7 @@
 #include <functional>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -34,6 +35,7 @@
 
 #include "core/async_executor/mock/mock_async_executor.h"
 #include "core/async_executor/src/async_executor.h"
+#include "core/common/time_provider/src/time_provider.h"
 #include "core/interface/async_context.h"
 #include "core/test/utils/auto_init_run_stop.h"
 #include "core/test/utils/conditional_wait.h"
@@ -49,6 +51,7 @@ using google::scp::core::AsyncExecutor;
 using google::scp::core::SuccessExecutionResult;
 using google::scp::core::TimeDuration;
 using google::scp::core::async_executor::mock::MockAsyncExecutor;
+using google::scp::core::common::TimeProvider;
 using google::scp::core::common::RetryStrategyOptions;
 using google::scp::core::common::RetryStrategyType;
 using google::scp::core::test::AutoInitRunStop;
@@ -59,6 +62,7 @@ using std::atomic;
 using std::bind;
 using std::future;
 using std::make_shared;
+using std::mutex;
 using std::promise;
 using std::shared_ptr;
 using std::string;
@@ -117,6 +121,30 @@ class HttpServer {
       res.end("hello, world\n");
     });
 
+    server.handle("/echo", [](const request& req, const response& res) {
+      auto body = make_shared<string>();
+      req.on_data([&res, body](const uint8_t* data, size_t length) {
+        if (length == 0) {
+          res.write_head(200u);
+          res.end(*body);
+          return;
+        }
+        body->append(reinterpret_cast<const char*>(data), length);
+      });
+    });
+
+    server.handle("/pingpong_headers",
+                  [](const request& req, const response& res) {
+                    header_map headers;
+                    for (const auto& [name, value] : req.header()) {
+                      if (name != "content-length") {
+                        headers.insert({name, value});
+                      }
+                    }
+                    res.write_head(200, headers);
+                    res.end();
+                  });
+
     server.handle(
         "/pingpong_query_param", [](const request& req, const response& res) {
           res.write_head(200, {{"query_param", {req.uri().raw_query.c_str()}}});
@@ -253,6 +281,107 @@ TEST_F(HttpClientTestII, Success) {
   done.get_future().get();
 }
 
+TEST_F(HttpClientTestII, PerformPreparedRequestSendsTheStaticHeaders) {
+  auto endpoint = http_client->PrepareEndpoint(
+      make_shared<Uri>("http://localhost:" +
+                       std::to_string(server->PortInUse()) +
+                       "/pingpong_headers"),
+      HttpHeaders{{"static-header", "foo"}});
+  ASSERT_SUCCESS(endpoint.result());
+
+  for (int i = 0; i < 3; i++) {
+    auto request = make_shared<HttpRequest>();
+    request->method = HttpMethod::GET;
+    request->headers = make_shared<HttpHeaders>();
+    request->headers->insert({"request-header", std::to_string(i)});
+    promise<void> done;
+    AsyncContext<HttpRequest, HttpResponse> context(
+        move(request), [&](AsyncContext<HttpRequest, HttpResponse>& context) {
+          EXPECT_SUCCESS(context.result);
+          auto& headers = *context.response->headers;
+          EXPECT_EQ(headers.find("static-header")->second, "foo");
+          EXPECT_EQ(headers.find("request-header")->second, std::to_string(i));
+          EXPECT_NE(headers.find(kClientActivityIdHeader), headers.end());
+          done.set_value();
+        });
+
+    EXPECT_SUCCESS(http_client->PerformPreparedRequest(*endpoint, context));
+    done.get_future().get();
+  }
+}
+
+TEST_F(HttpClientTestII, PerformPreparedRequestEscapesTheQuery) {
+  auto endpoint = http_client->PrepareEndpoint(make_shared<Uri>(
+      "http://localhost:" + std::to_string(server->PortInUse()) +
+      "/pingpong_query_param"));
+  ASSERT_SUCCESS(endpoint.result());
+
+  auto request = make_shared<HttpRequest>();
+  request->method = HttpMethod::GET;
+  request->query = make_shared<string>("foo=!@#$");
+  promise<void> done;
+  AsyncContext<HttpRequest, HttpResponse> context(
+      move(request), [&](AsyncContext<HttpRequest, HttpResponse>& context) {
+        EXPECT_SUCCESS(context.result);
+        auto query_param_it = context.response->headers->find("query_param");
+        EXPECT_NE(query_param_it, context.response->headers->end());
+        EXPECT_EQ(query_param_it->second, "foo=%21%40%23%24");
+        done.set_value();
+      });
+
+  EXPECT_SUCCESS(http_client->PerformPreparedRequest(*endpoint, context));
+  done.get_future().get();
+}
+
+TEST_F(HttpClientTestII, PerformPreparedRequestWithEmptyPathAppendsTheQuery) {
+  auto endpoint = http_client->PrepareEndpoint(make_shared<Uri>(
+      "http://localhost:" + std::to_string(server->PortInUse()) +
+      "/pingpong_query_param"));
+  ASSERT_SUCCESS(endpoint.result());
+
+  auto request = make_shared<HttpRequest>();
+  request->method = HttpMethod::GET;
+  request->path = make_shared<Uri>("");
+  request->query = make_shared<string>("foo=bar");
+  promise<void> done;
+  AsyncContext<HttpRequest, HttpResponse> context(
+      move(request), [&](AsyncContext<HttpRequest, HttpResponse>& context) {
+        EXPECT_SUCCESS(context.result);
+        auto query_param_it = context.response->headers->find("query_param");
+        EXPECT_NE(query_param_it, context.response->headers->end());
+        EXPECT_EQ(query_param_it->second, "foo=bar");
+        done.set_value();
+      });
+
+  EXPECT_SUCCESS(http_client->PerformPreparedRequest(*endpoint, context));
+  done.get_future().get();
+}
+
+TEST_F(HttpClientTestII, PerformPreparedRequestRejectsAnotherPath) {
+  auto endpoint = http_client->PrepareEndpoint(make_shared<Uri>(
+      "http://localhost:" + std::to_string(server->PortInUse()) +
+      "/pingpong_query_param"));
+  ASSERT_SUCCESS(endpoint.result());
+
+  auto request = make_shared<HttpRequest>();
+  request->method = HttpMethod::GET;
+  request->path = make_shared<Uri>("http://localhost:" +
+                                   std::to_string(server->PortInUse()) +
+                                   "/pingpong_headers");
+  promise<void> done;
+  AsyncContext<HttpRequest, HttpResponse> context(
+      move(request), [&](AsyncContext<HttpRequest, HttpResponse>& context) {
+        EXPECT_THAT(
+            context.result,
+            ResultIs(FailureExecutionResult(
+                errors::SC_HTTP2_CLIENT_PREPARED_REQUEST_PATH_MISMATCH)));
+        done.set_value();
+      });
+
+  EXPECT_SUCCESS(http_client->PerformPreparedRequest(*endpoint, context));
+  done.get_future().get();
+}
+
 TEST_F(HttpClientTestII, SingleQueryIsEscaped) {
   auto request = make_shared<HttpRequest>();
   request->method = HttpMethod::GET;
@@ -388,6 +517,223 @@ TEST_F(HttpClientTestII, LargeData) {
   WaitUntil([&]() { return finished.load(); });
 }
 
+TEST_F(HttpClientTestII, LargeRequestBody) {
+  auto request = make_shared<HttpRequest>();
+  request->method = HttpMethod::POST;
+  request->path = make_shared<string>(
+      "http://localhost:" + std::to_string(server->PortInUse()) + "/echo");
+  string body(1048576UL, 0);
+  RAND_bytes(reinterpret_cast<uint8_t*>(body.data()), body.size());
+  request->body = BytesBuffer(body);
+  atomic<bool> finished(false);
+  AsyncContext<HttpRequest, HttpResponse> context(
+      move(request), [&](AsyncContext<HttpRequest, HttpResponse>& context) {
+        EXPECT_SUCCESS(context.result);
+        EXPECT_EQ(context.response->body.length, body.size());
+        EXPECT_EQ(context.response->body.ToString(), body);
+        finished.store(true);
+      });
+
+  EXPECT_SUCCESS(http_client->PerformRequest(context));
+  WaitUntil([&]() { return finished.load(); });
+}
+
+TEST_F(HttpClientTestII, ResponseBodyChunkCallback) {
+  auto request = make_shared<HttpRequest>();
+  size_t to_generate = 1048576UL;
+  request->path = make_shared<string>(
+      "http://localhost:" + std::to_string(server->PortInUse()) + "/random");
+  request->query = make_shared<string>("length=" + std::to_string(to_generate));
+  string streamed_body;
+  size_t chunk_count = 0;
+  bool end_of_body = false;
+  request->response_body_chunk_callback = [&](const HttpResponse& response,
+                                              const uint8_t* data,
+                                              size_t length) {
+    EXPECT_EQ(response.code, errors::HttpStatusCode::OK);
+    if (length == 0) {
+      end_of_body = true;
+      return HttpResponseBodyChunkAction::Continue;
+    }
+    chunk_count++;
+    streamed_body.append(reinterpret_cast<const char*>(data), length);
+    return HttpResponseBodyChunkAction::Continue;
+  };
+  atomic<bool> finished(false);
+  AsyncContext<HttpRequest, HttpResponse> context(
+      move(request), [&](AsyncContext<HttpRequest, HttpResponse>& context) {
+        EXPECT_SUCCESS(context.result);
+        // The body was handed to the callback instead.
+        EXPECT_EQ(context.response->body.length, 0);
+        EXPECT_TRUE(end_of_body);
+        EXPECT_GT(chunk_count, 1);
+        ASSERT_EQ(streamed_body.size(), to_generate + SHA256_DIGEST_LENGTH);
+        uint8_t hash[SHA256_DIGEST_LENGTH];
+        const auto* data =
+            reinterpret_cast<const uint8_t*>(streamed_body.data());
+        SHA256(data, to_generate, hash);
+        EXPECT_EQ(memcmp(hash, data + to_generate, SHA256_DIGEST_LENGTH), 0);
+        finished.store(true);
+      });
+
+  EXPECT_SUCCESS(http_client->PerformRequest(context));
+  WaitUntil([&]() { return finished.load(); });
+}
+
+TEST_F(HttpClientTestII, PerformStreamingRequest) {
+  size_t to_generate = 1048576UL;
+  ConsumerStreamingContext<HttpRequest, HttpResponse> context;
+  context.request = make_shared<HttpRequest>();
+  context.request->path = make_shared<string>(
+      "http://localhost:" + std::to_string(server->PortInUse()) + "/random");
+  context.request->query =
+      make_shared<string>("length=" + std::to_string(to_generate));
+  mutex streamed_body_mutex;
+  string streamed_body;
+  size_t chunk_count = 0;
+  atomic<bool> finished(false);
+  context.process_callback = [&](auto& context, bool is_finish) {
+    std::unique_lock lock(streamed_body_mutex);
+    while (auto response = context.TryGetNextResponse()) {
+      EXPECT_EQ(response->code, errors::HttpStatusCode::OK);
+      chunk_count++;
+      streamed_body.append(response->body.ToString());
+    }
+    if (!is_finish) {
+      return;
+    }
+    EXPECT_SUCCESS(context.result);
+    EXPECT_GT(chunk_count, 1);
+    ASSERT_EQ(streamed_body.size(), to_generate + SHA256_DIGEST_LENGTH);
+    uint8_t hash[SHA256_DIGEST_LENGTH];
+    const auto* data = reinterpret_cast<const uint8_t*>(streamed_body.data());
+    SHA256(data, to_generate, hash);
+    EXPECT_EQ(memcmp(hash, data + to_generate, SHA256_DIGEST_LENGTH), 0);
+    finished.store(true);
+  };
+
+  EXPECT_SUCCESS(http_client->PerformStreamingRequest(context));
+  WaitUntil([&]() { return finished.load(); });
+}
+
+TEST_F(HttpClientTestII, PerformStreamingRequestWaitsForSlowConsumer) {
+  size_t to_generate = 1048576UL;
+  ConsumerStreamingContext<HttpRequest, HttpResponse> context(
+      /*max_num_outstanding_responses=*/1);
+  context.request = make_shared<HttpRequest>();
+  context.request->path = make_shared<string>(
+      "http://localhost:" + std::to_string(server->PortInUse()) + "/random");
+  context.request->query =
+      make_shared<string>("length=" + std::to_string(to_generate));
+  atomic<bool> finished(false);
+  ExecutionResult result;
+  // The responses are only taken off the queue by the consumer thread.
+  context.process_callback = [&](auto& context, bool is_finish) {
+    if (is_finish) {
+      result = context.result;
+      finished.store(true);
+    }
+  };
+
+  EXPECT_SUCCESS(http_client->PerformStreamingRequest(context));
+  string streamed_body;
+  size_t chunk_count = 0;
+  thread consumer([&]() {
+    while (true) {
+      // Checked before taking a response, all of them are pushed by the time
+      // the context finishes.
+      auto is_finished = finished.load();
+      auto response = context.TryGetNextResponse();
+      if (response == nullptr) {
+        if (is_finished) {
+          return;
+        }
+        std::this_thread::sleep_for(milliseconds(1));
+        continue;
+      }
+      chunk_count++;
+      streamed_body.append(response->body.ToString());
+      // Reads slower than the server writes.
+      std::this_thread::sleep_for(milliseconds(1));
+    }
+  });
+  consumer.join();
+
+  EXPECT_SUCCESS(result);
+  EXPECT_GT(chunk_count, 1);
+  ASSERT_EQ(streamed_body.size(), to_generate + SHA256_DIGEST_LENGTH);
+  uint8_t hash[SHA256_DIGEST_LENGTH];
+  const auto* data = reinterpret_cast<const uint8_t*>(streamed_body.data());
+  SHA256(data, to_generate, hash);
+  EXPECT_EQ(memcmp(hash, data + to_generate, SHA256_DIGEST_LENGTH), 0);
+}
+
+TEST_F(HttpClientTestII,
+       PerformStreamingRequestFailsWhenConsumerDoesNotCatchUpInTime) {
+  ConsumerStreamingContext<HttpRequest, HttpResponse> context(
+      /*max_num_outstanding_responses=*/1);
+  context.request = make_shared<HttpRequest>();
+  context.request->path = make_shared<string>(
+      "http://localhost:" + std::to_string(server->PortInUse()) + "/random");
+  context.request->query = make_shared<string>("length=1048576");
+  context.expiration_time = (TimeProvider::GetSteadyTimestampInNanoseconds() +
+                             std::chrono::seconds(1))
+                                .count();
+  atomic<bool> finished(false);
+  // The consumer never takes the responses off the queue.
+  context.process_callback = [&](auto& context, bool is_finish) {
+    if (!is_finish) {
+      return;
+    }
+    EXPECT_THAT(context.result,
+                ResultIs(FailureExecutionResult(
+                    errors::SC_CONCURRENT_QUEUE_CANNOT_ENQUEUE)));
+    finished.store(true);
+  };
+
+  EXPECT_SUCCESS(http_client->PerformStreamingRequest(context));
+  WaitUntil([&]() { return finished.load(); });
+}
+
+TEST_F(HttpClientTestII,
+       PerformStreamingRequestFailsWhenTooMuchOfTheBodyIsHeldBack) {
+  auto options = HttpClientOptions(
+      RetryStrategyOptions(RetryStrategyType::Exponential,
+                           kDefaultRetryStrategyDelayInMs,
+                           kDefaultRetryStrategyMaxRetries),
+      kDefaultMaxConnectionsPerHost, kHttp2ReadTimeoutInSeconds,
+      HttpConnectionSelectionPolicy::LeastOutstandingStreams,
+      kDefaultHttp2MaxConcurrentStreamsPerConnection,
+      kDefaultHttp2MaxPendingRequestsPerHost, HttpIoOptions(),
+      /*prewarm_uris=*/{},
+      /*max_held_back_response_body_bytes=*/64 * 1024);
+  HttpClient client(async_executor, options);
+  AutoInitRunStop to_handle_client(client);
+
+  ConsumerStreamingContext<HttpRequest, HttpResponse> context(
+      /*max_num_outstanding_responses=*/1);
+  context.request = make_shared<HttpRequest>();
+  context.request->path = make_shared<string>(
+      "http://localhost:" + std::to_string(server->PortInUse()) + "/random");
+  context.request->query = make_shared<string>("length=1048576");
+  atomic<bool> finished(false);
+  // The consumer never takes the responses off the queue, and the context
+  // does not expire before the limit is reached.
+  context.process_callback = [&](auto& context, bool is_finish) {
+    if (!is_finish) {
+      return;
+    }
+    EXPECT_THAT(
+        context.result,
+        ResultIs(FailureExecutionResult(
+            errors::SC_HTTP2_CLIENT_RESPONSE_BODY_HELD_BACK_LIMIT_EXCEEDED)));
+    finished.store(true);
+  };
+
+  EXPECT_SUCCESS(client.PerformStreamingRequest(context));
+  WaitUntil([&]() { return finished.load(); });
+}
+
 TEST_F(HttpClientTestII, ClientFinishesContextWhenServerIsStopped) {
   auto request = make_shared<HttpRequest>();
   request->method = HttpMethod::GET;
@@ -14,7 +14,13 @@
 
 #include <gtest/gtest.h>
 
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "cc/core/async_executor/mock/mock_async_executor.h"
+#include "cc/core/common/time_provider/src/time_provider.h"
 #include "cc/core/http2_client/mock/mock_http_connection.h"
 #include "cc/core/http2_client/mock/mock_http_connection_pool_with_overrides.h"
 #include "cc/core/http2_client/src/error_codes.h"
@@ -23,6 +29,7 @@
 #include "public/core/test/interface/execution_result_matchers.h"
 
 using google::scp::core::async_executor::mock::MockAsyncExecutor;
+using google::scp::core::common::TimeProvider;
 using google::scp::core::http2_client::mock::MockHttpConnection;
 using google::scp::core::http2_client::mock::MockHttpConnectionPool;
 
@@ -47,9 +54,39 @@ class HttpConnectionPoolTest : public testing::Test {
     EXPECT_SUCCESS(async_executor_->Stop());
   }
 
+  /**
+   * @brief Replaces the connection pool with one using the selection policy,
+   * whose connections are ready and have in_flight_stream_counts[i] streams in
+   * flight out of max_concurrent_streams.
+   */
+  void RecreatePool(HttpConnectionSelectionPolicy selection_policy,
+                    std::vector<size_t> in_flight_stream_counts,
+                    size_t max_concurrent_streams = 10) {
+    EXPECT_SUCCESS(connection_pool_->Stop());
+    connection_pool_ = std::make_unique<MockHttpConnectionPool>(
+        async_executor_, in_flight_stream_counts.size(), selection_policy);
+    connection_pool_->create_connection_override_ =
+        [this, in_flight_stream_counts, max_concurrent_streams,
+         create_connection_counter = size_t(0)](
+            std::string host, std::string service, bool is_https) mutable {
+          auto connection = std::make_shared<MockHttpConnection>(
+              async_executor_, host, service, is_https, max_concurrent_streams);
+          connection->SetIsNotDropped();
+          connection->SetIsReady();
+          connection->SetInFlightStreamCount(
+              in_flight_stream_counts[create_connection_counter++]);
+          mock_connections_.push_back(connection);
+          std::shared_ptr<HttpConnection> connection_ptr = connection;
+          return connection_ptr;
+        };
+    EXPECT_SUCCESS(connection_pool_->Init());
+    EXPECT_SUCCESS(connection_pool_->Run());
+  }
+
   std::shared_ptr<AsyncExecutorInterface> async_executor_;
   std::unique_ptr<MockHttpConnectionPool> connection_pool_;
   size_t num_connections_per_host_ = 10;
+  std::vector<std::shared_ptr<MockHttpConnection>> mock_connections_;
 };
 
 TEST_F(HttpConnectionPoolTest, GetConnectionCreatesConnectionsForTheFirstTime) {
@@ -328,4 +365,296 @@ TEST_F(HttpConnectionPoolTest,
   EXPECT_EQ(connection2, connections[0]);
 }
 
+TEST_F(HttpConnectionPoolTest,
+       LeastOutstandingStreamsReturnsConnectionWithFewestStreams) {
+  RecreatePool(HttpConnectionSelectionPolicy::LeastOutstandingStreams,
+               {4, 2, 7, 3});
+
+  auto uri = std::make_shared<Uri>("https://www.google.com:80");
+  std::shared_ptr<HttpConnection> connection;
+  EXPECT_SUCCESS(connection_pool_->GetConnection(uri, connection));
+  EXPECT_EQ(connection, mock_connections_[1]);
+
+  mock_connections_[1]->SetInFlightStreamCount(5);
+  EXPECT_SUCCESS(connection_pool_->GetConnection(uri, connection));
+  EXPECT_EQ(connection, mock_connections_[3]);
+}
+
+TEST_F(HttpConnectionPoolTest,
+       LeastOutstandingStreamsSkipsConnectionsThatAreNotReady) {
+  RecreatePool(HttpConnectionSelectionPolicy::LeastOutstandingStreams,
+               {4, 2, 7, 3});
+  auto uri = std::make_shared<Uri>("https://www.google.com:80");
+  std::shared_ptr<HttpConnection> connection;
+  EXPECT_SUCCESS(connection_pool_->GetConnection(uri, connection));
+
+  mock_connections_[1]->SetIsNotReady();
+  EXPECT_SUCCESS(connection_pool_->GetConnection(uri, connection));
+  EXPECT_EQ(connection, mock_connections_[3]);
+
+  for (auto& mock_connection : mock_connections_) {
+    mock_connection->SetIsNotReady();
+  }
+  EXPECT_THAT(connection_pool_->GetConnection(uri, connection),
+              test::ResultIs(RetryExecutionResult(
+                  errors::SC_HTTP2_CLIENT_HTTP_CONNECTION_NOT_READY)));
+}
+
+TEST_F(HttpConnectionPoolTest, PowerOfTwoChoicesSkipsSaturatedConnections) {
+  RecreatePool(HttpConnectionSelectionPolicy::PowerOfTwoChoices,
+               {10, 10, 3, 10, 10, 10}, /*max_concurrent_streams=*/10);
+
+  auto uri = std::make_shared<Uri>("https://www.google.com:80");
+  for (int i = 0; i < 20; i++) {
+    std::shared_ptr<HttpConnection> connection;
+    EXPECT_SUCCESS(connection_pool_->GetConnection(uri, connection));
+    EXPECT_EQ(connection, mock_connections_[2]);
+  }
+}
+
+TEST_F(HttpConnectionPoolTest, PowerOfTwoChoicesPrefersLessLoadedConnection) {
+  RecreatePool(HttpConnectionSelectionPolicy::PowerOfTwoChoices, {0, 9},
+               /*max_concurrent_streams=*/10);
+
+  auto uri = std::make_shared<Uri>("https://www.google.com:80");
+  for (int i = 0; i < 20; i++) {
+    std::shared_ptr<HttpConnection> connection;
+    EXPECT_SUCCESS(connection_pool_->GetConnection(uri, connection));
+    EXPECT_EQ(connection, mock_connections_[0]);
+  }
+}
+
+TEST_F(HttpConnectionPoolTest,
+       GetConnectionOnSaturatedConnectionsReturnsRetry) {
+  RecreatePool(HttpConnectionSelectionPolicy::LeastOutstandingStreams,
+               {10, 10}, /*max_concurrent_streams=*/10);
+
+  auto uri = std::make_shared<Uri>("https://www.google.com:80");
+  std::shared_ptr<HttpConnection> connection;
+  EXPECT_THAT(connection_pool_->GetConnection(uri, connection),
+              test::ResultIs(RetryExecutionResult(
+                  errors::SC_HTTP2_CLIENT_CONNECTION_POOL_SATURATED)));
+}
+
+TEST_F(HttpConnectionPoolTest, ExecuteQueuesRequestsOnSaturatedConnections) {
+  RecreatePool(HttpConnectionSelectionPolicy::LeastOutstandingStreams,
+               {10, 10}, /*max_concurrent_streams=*/10);
+
+  std::atomic<bool> finished(false);
+  AsyncContext<HttpRequest, HttpResponse> http_context(
+      std::make_shared<HttpRequest>(),
+      [&](AsyncContext<HttpRequest, HttpResponse>& http_context) {
+        EXPECT_THAT(
+            http_context.result,
+            test::ResultIs(FailureExecutionResult(
+                errors::SC_HTTP2_CLIENT_CONNECTION_POOL_IS_NOT_AVAILABLE)));
+        finished = true;
+      });
+  http_context.request->path =
+      std::make_shared<Uri>("https://www.google.com:80");
+  EXPECT_SUCCESS(connection_pool_->Execute(http_context));
+  EXPECT_FALSE(finished);
+
+  // The queued requests are dropped when the pool stops.
+  EXPECT_SUCCESS(connection_pool_->Stop());
+  test::WaitUntil([&]() { return finished.load(); });
+}
+
+TEST_F(HttpConnectionPoolTest, GetInFlightStreamCountsReturnsTheCounts) {
+  RecreatePool(HttpConnectionSelectionPolicy::LeastOutstandingStreams,
+               {4, 2, 7});
+
+  auto uri = std::make_shared<Uri>("https://www.google.com:80");
+  std::shared_ptr<HttpConnection> connection;
+  EXPECT_SUCCESS(connection_pool_->GetConnection(uri, connection));
+
+  std::map<std::string, std::vector<size_t>> in_flight_stream_counts;
+  EXPECT_SUCCESS(
+      connection_pool_->GetInFlightStreamCounts(in_flight_stream_counts));
+  EXPECT_EQ(in_flight_stream_counts.size(), 1);
+  EXPECT_EQ(in_flight_stream_counts["www.google.com:80"],
+            (std::vector<size_t>{4, 2, 7}));
+}
+
+TEST_F(HttpConnectionPoolTest, RecycleConnectionSchedulesASingleRecycle) {
+  std::vector<Timestamp> scheduled_timestamps;
+  std::dynamic_pointer_cast<MockAsyncExecutor>(async_executor_)
+      ->schedule_for_mock = [&](const AsyncOperation& work,
+                                Timestamp timestamp,
+                                std::function<bool()>& cancellation_callback) {
+    scheduled_timestamps.push_back(timestamp);
+    cancellation_callback = []() { return true; };
+    return SuccessExecutionResult();
+  };
+
+  std::shared_ptr<HttpConnection> connection =
+      std::make_shared<MockHttpConnection>(async_executor_, "localhost", "80",
+                                           /*is_https=*/false);
+  // Ready connections are not recycled.
+  connection_pool_->RecycleConnection(connection);
+  EXPECT_EQ(scheduled_timestamps.size(), 0);
+
+  std::dynamic_pointer_cast<MockHttpConnection>(connection)->SetIsDropped();
+  auto now = TimeProvider::GetSteadyTimestampInNanosecondsAsClockTicks();
+  connection_pool_->RecycleConnection(connection);
+  // The connection is already being recycled.
+  connection_pool_->RecycleConnection(connection);
+  ASSERT_EQ(scheduled_timestamps.size(), 1);
+  // The first attempt is not delayed.
+  EXPECT_LE(scheduled_timestamps[0],
+            now + std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::milliseconds(
+                          kHttp2ConnectionRecycleInitialBackoffInMs))
+                      .count());
+
+  connection->FinishRecycling();
+  connection_pool_->RecycleConnection(connection);
+  EXPECT_EQ(scheduled_timestamps.size(), 2);
+}
+
+TEST_F(HttpConnectionPoolTest, StopCancelsTheRecyclingWaitingForItsBackoff) {
+  AsyncOperation scheduled_work;
+  bool is_cancelled = false;
+  std::dynamic_pointer_cast<MockAsyncExecutor>(async_executor_)
+      ->schedule_for_mock = [&](const AsyncOperation& work,
+                                Timestamp timestamp,
+                                std::function<bool()>& cancellation_callback) {
+    scheduled_work = work;
+    cancellation_callback = [&]() {
+      is_cancelled = true;
+      return true;
+    };
+    return SuccessExecutionResult();
+  };
+
+  std::shared_ptr<HttpConnection> connection =
+      std::make_shared<MockHttpConnection>(async_executor_, "localhost", "80",
+                                           /*is_https=*/false);
+  std::dynamic_pointer_cast<MockHttpConnection>(connection)->SetIsDropped();
+  connection_pool_->RecycleConnection(connection);
+  EXPECT_TRUE(scheduled_work);
+
+  // Stop does not wait for the backoff of the recycling, which no longer
+  // runs.
+  EXPECT_SUCCESS(connection_pool_->Stop());
+  EXPECT_TRUE(is_cancelled);
+  EXPECT_TRUE(connection->TryStartRecycling());
+
+  // Nothing is scheduled once the pool stopped.
+  scheduled_work = nullptr;
+  connection->FinishRecycling();
+  connection_pool_->RecycleConnection(connection);
+  EXPECT_FALSE(scheduled_work);
+}
+
+TEST_F(HttpConnectionPoolTest, RunPrewarmsTheConnectionsOfTheUris) {
+  EXPECT_SUCCESS(connection_pool_->Stop());
+  connection_pool_ = std::make_unique<MockHttpConnectionPool>(
+      async_executor_, num_connections_per_host_,
+      HttpConnectionSelectionPolicy::RoundRobin,
+      std::vector<std::string>{"https://www.google.com:80"});
+  connection_pool_->create_connection_override_ =
+      [this](std::string host, std::string service, bool is_https) {
+        std::shared_ptr<HttpConnection> connection =
+            std::make_shared<MockHttpConnection>(async_executor_, host,
+                                                 service, is_https);
+        return connection;
+      };
+  EXPECT_SUCCESS(connection_pool_->Init());
+  EXPECT_TRUE(connection_pool_->GetConnectionsMap().empty());
+
+  EXPECT_SUCCESS(connection_pool_->Run());
+  auto map = connection_pool_->GetConnectionsMap();
+  EXPECT_EQ(map.size(), 1);
+  EXPECT_EQ(map["www.google.com:80"].size(), num_connections_per_host_);
+}
+
+TEST_F(HttpConnectionPoolTest,
+       GetConnectionReadinessMetricsCountsNotReadyConnections) {
+  connection_pool_->create_connection_override_ =
+      [this](std::string host, std::string service, bool is_https) {
+        auto connection = std::make_shared<MockHttpConnection>(
+            async_executor_, host, service, is_https);
+        connection->SetIsDropped();
+        connection->SetIsNotReady();
+        std::shared_ptr<HttpConnection> connection_ptr = connection;
+        return connection_ptr;
+      };
+  connection_pool_->recycle_connection_override_ =
+      [](std::shared_ptr<HttpConnection>&) {};
+
+  auto uri = std::make_shared<Uri>("https://www.google.com:80");
+  std::shared_ptr<HttpConnection> connection;
+  EXPECT_THAT(connection_pool_->GetConnection(uri, connection),
+              test::ResultIs(RetryExecutionResult(
+                  errors::SC_HTTP2_CLIENT_HTTP_CONNECTION_NOT_READY)));
+
+  auto metrics = connection_pool_->GetConnectionReadinessMetrics();
+  EXPECT_EQ(metrics.not_ready_count, 1);
+  EXPECT_EQ(metrics.connect_count, 0);
+}
+
+TEST_F(HttpConnectionPoolTest, PrepareEndpointEncodesTheStaticHeaders) {
+  auto uri = std::make_shared<Uri>("https://www.google.com:80/path");
+  HttpHeaders static_headers{{"static-header", "value"},
+                             {"content-length", "10"},
+                             {kClientActivityIdHeader, "id"}};
+  std::shared_ptr<const HttpConnectionPool::PreparedEndpoint> endpoint;
+  EXPECT_SUCCESS(
+      connection_pool_->PrepareEndpoint(uri, static_headers, endpoint));
+
+  EXPECT_EQ(endpoint->uri, uri);
+  EXPECT_EQ(endpoint->encoded->uri, *uri);
+  // The per request headers are not static.
+  ASSERT_EQ(endpoint->encoded->headers.size(), 1);
+  EXPECT_EQ(endpoint->encoded->headers.begin()->first, "static-header");
+  EXPECT_EQ(endpoint->encoded->headers.begin()->second.value, "value");
+
+  auto map = connection_pool_->GetConnectionsMap();
+  EXPECT_EQ(map.size(), 1);
+  EXPECT_EQ(map["www.google.com:80"].size(), num_connections_per_host_);
+  EXPECT_EQ(endpoint->pool_entry->http_connections,
+            map["www.google.com:80"]);
+}
+
+TEST_F(HttpConnectionPoolTest, PrepareEndpointFailsOnInvalidUris) {
+  std::shared_ptr<const HttpConnectionPool::PreparedEndpoint> endpoint;
+  EXPECT_THAT(connection_pool_->PrepareEndpoint(
+                  std::make_shared<Uri>("ftp://www.google.com:80"),
+                  HttpHeaders(), endpoint),
+              test::ResultIs(FailureExecutionResult(
+                  errors::SC_HTTP2_CLIENT_INVALID_URI)));
+  EXPECT_EQ(endpoint, nullptr);
+}
+
+TEST_F(HttpConnectionPoolTest, ExecuteOnAPreparedEndpointQueuesTheRequest) {
+  RecreatePool(HttpConnectionSelectionPolicy::LeastOutstandingStreams,
+               {10, 10}, /*max_concurrent_streams=*/10);
+  auto uri = std::make_shared<Uri>("https://www.google.com:80");
+  std::shared_ptr<const HttpConnectionPool::PreparedEndpoint> endpoint;
+  EXPECT_SUCCESS(
+      connection_pool_->PrepareEndpoint(uri, HttpHeaders(), endpoint));
+
+  std::atomic<bool> finished(false);
+  AsyncContext<HttpRequest, HttpResponse> http_context(
+      std::make_shared<HttpRequest>(),
+      [&](AsyncContext<HttpRequest, HttpResponse>& http_context) {
+        EXPECT_THAT(
+            http_context.result,
+            test::ResultIs(FailureExecutionResult(
+                errors::SC_HTTP2_CLIENT_CONNECTION_POOL_IS_NOT_AVAILABLE)));
+        finished = true;
+      });
+  EXPECT_SUCCESS(connection_pool_->Execute(endpoint, http_context));
+  // The path of the request is the uri of the endpoint.
+  EXPECT_EQ(http_context.request->path, uri);
+  EXPECT_FALSE(finished);
+
+  EXPECT_SUCCESS(connection_pool_->Stop());
+  test::WaitUntil([&]() { return finished.load(); });
+  EXPECT_THAT(connection_pool_->Execute(endpoint, http_context),
+              test::ResultIs(FailureExecutionResult(
+                  errors::SC_HTTP2_CLIENT_CONNECTION_POOL_IS_NOT_AVAILABLE)));
+}
+
 }  // namespace google::scp::core
@@ -35,6 +35,7 @@
 #include "core/async_executor/mock/mock_async_executor.h"
 #include "core/async_executor/src/async_executor.h"
 #include "core/http2_client/mock/mock_http_connection.h"
+#include "core/http2_client/src/http_io_context_pool.h"
 #include "core/test/utils/conditional_wait.h"
 #include "public/core/interface/execution_result.h"
 #include "public/core/test/interface/execution_result_matchers.h"
@@ -55,6 +56,7 @@ using google::scp::core::test::WaitUntil;
 using std::atomic;
 using std::bind;
 using std::future;
+using std::make_pair;
 using std::make_shared;
 using std::promise;
 using std::shared_ptr;
@@ -132,6 +134,40 @@ TEST(HttpConnectionTest, SimpleRequest) {
   server.join();
 }
 
+TEST(HttpConnectionTest, TryReserveStreamNeverExceedsTheLimit) {
+  constexpr size_t kMaxConcurrentStreams = 4;
+  auto async_executor = make_shared<MockAsyncExecutor>();
+  MockHttpConnection connection(async_executor, "localhost", "80", false,
+                                kMaxConcurrentStreams);
+
+  atomic<size_t> reserved_count = 0;
+  vector<thread> threads;
+  for (int i = 0; i < 8; i++) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < 100; j++) {
+        if (connection.TryReserveStream()) {
+          reserved_count++;
+        }
+      }
+    });
+  }
+  for (auto& reserving_thread : threads) {
+    reserving_thread.join();
+  }
+  EXPECT_EQ(reserved_count.load(), kMaxConcurrentStreams);
+  EXPECT_EQ(connection.GetInFlightStreamCount(), kMaxConcurrentStreams);
+  EXPECT_FALSE(connection.TryReserveStream());
+
+  // The reservation is released when the request cannot be executed.
+  AsyncContext<HttpRequest, HttpResponse> http_context;
+  http_context.request = make_shared<HttpRequest>();
+  EXPECT_THAT(connection.ExecuteOnReservedStream(http_context),
+              ResultIs(RetryExecutionResult(
+                  errors::SC_HTTP2_CLIENT_NO_CONNECTION_ESTABLISHED)));
+  EXPECT_EQ(connection.GetInFlightStreamCount(), kMaxConcurrentStreams - 1);
+  EXPECT_TRUE(connection.TryReserveStream());
+}
+
 TEST(HttpConnectionTest, CancelCallbacks) {
   http2 server;
   boost::system::error_code ec;
@@ -263,4 +299,103 @@ TEST(HttpConnectionTest, StopRemovesCallback) {
   server.join();
 }
 
+TEST(HttpConnectionTest, ConcurrentStreamsLimitRecoversFromRefusedStreams) {
+  auto async_executor = make_shared<MockAsyncExecutor>();
+  MockHttpConnection connection(async_executor, "localhost", "80",
+                                /*is_https=*/false,
+                                /*max_concurrent_streams=*/10);
+
+  // Closes a stream of the connection while in_flight_count streams, itself
+  // included, are in flight.
+  auto close_stream = [&](size_t in_flight_count, uint32_t error_code) {
+    AsyncContext<HttpRequest, HttpResponse> http_context;
+    http_context.request = make_shared<HttpRequest>();
+    http_context.response = make_shared<HttpResponse>();
+    http_context.response->code = errors::HttpStatusCode::OK;
+    http_context.callback = [](auto&) {};
+    auto request_id = Uuid::GenerateUuid();
+    auto pair = make_pair(request_id, http_context);
+    EXPECT_SUCCESS(
+        connection.GetPendingNetworkCallbacks().Insert(pair, http_context));
+    connection.SetInFlightStreamCount(in_flight_count);
+    connection.OnRequestResponseClosed(request_id, http_context, error_code);
+  };
+
+  // The peer refuses the fourth stream in flight.
+  close_stream(4, NGHTTP2_REFUSED_STREAM);
+  EXPECT_EQ(connection.GetMaxConcurrentStreams(), 3);
+
+  // The limit is probed upwards as streams complete.
+  for (size_t i = 0; i < kHttp2StreamsToRaiseConcurrentStreamsLimit - 1; i++) {
+    close_stream(1, 0);
+  }
+  EXPECT_EQ(connection.GetMaxConcurrentStreams(), 3);
+  close_stream(1, 0);
+  EXPECT_EQ(connection.GetMaxConcurrentStreams(), 4);
+
+  // A refusal starts the count over.
+  close_stream(2, NGHTTP2_REFUSED_STREAM);
+  EXPECT_EQ(connection.GetMaxConcurrentStreams(), 1);
+
+  // The configured limit is restored when the connection is recycled.
+  connection.Reset();
+  EXPECT_EQ(connection.GetMaxConcurrentStreams(), 10);
+  close_stream(1, 0);
+  EXPECT_EQ(connection.GetMaxConcurrentStreams(), 10);
+}
+
+TEST(HttpConnectionTest, RunsOnSharedIoContextWithInlineCallbacks) {
+  http2 server;
+  boost::system::error_code ec;
+  server.num_threads(1);
+  server.handle("/test", [](const request& req, const response& res) {
+    res.write_head(200);
+    res.end();
+  });
+  server.listen_and_serve(ec, "localhost", "0", true);
+
+  HttpIoContextPool io_context_pool(/*thread_count=*/1);
+  EXPECT_SUCCESS(io_context_pool.Init());
+  EXPECT_SUCCESS(io_context_pool.Run());
+
+  auto async_executor = make_shared<MockAsyncExecutor>();
+  HttpConnection connection(async_executor, "localhost",
+                            to_string(server.ports()[0]), /*is_https=*/false,
+                            kDefaultHttp2ReadTimeoutInSeconds,
+                            kDefaultHttp2MaxConcurrentStreamsPerConnection,
+                            io_context_pool.GetIoContext(),
+                            /*complete_callbacks_inline=*/true);
+  EXPECT_SUCCESS(connection.Init());
+  EXPECT_SUCCESS(connection.Run());
+  WaitUntil([&]() { return connection.IsReady(); });
+
+  constexpr int kRequestCount = 10;
+  atomic<int> completed_count = 0;
+  atomic<bool> completed_on_caller_thread = false;
+  auto caller_thread_id = std::this_thread::get_id();
+  vector<AsyncContext<HttpRequest, HttpResponse>> http_contexts(kRequestCount);
+  for (auto& http_context : http_contexts) {
+    http_context.request = make_shared<HttpRequest>();
+    http_context.request->path = make_shared<string>("http://localhost/test");
+    http_context.request->method = HttpMethod::GET;
+    http_context.callback =
+        [&](AsyncContext<HttpRequest, HttpResponse>& context) {
+          EXPECT_SUCCESS(context.result);
+          if (std::this_thread::get_id() == caller_thread_id) {
+            completed_on_caller_thread = true;
+          }
+          completed_count++;
+        };
+    EXPECT_SUCCESS(connection.Execute(http_context));
+  }
+  WaitUntil([&]() { return completed_count.load() == kRequestCount; });
+  EXPECT_FALSE(completed_on_caller_thread.load());
+
+  // The connection is stopped ahead of the io contexts it runs on.
+  EXPECT_SUCCESS(connection.Stop());
+  EXPECT_SUCCESS(io_context_pool.Stop());
+
+  server.stop();
+  server.join();
+}
 }  // namespace google::scp::core
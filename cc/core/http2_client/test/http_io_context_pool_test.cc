@@ -0,0 +1,108 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "core/http2_client/src/http_io_context_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "core/test/utils/conditional_wait.h"
+#include "public/core/test/interface/execution_result_matchers.h"
+
+using boost::asio::io_context;
+using boost::asio::post;
+using std::atomic;
+using std::mutex;
+using std::scoped_lock;
+using std::set;
+using std::shared_ptr;
+using std::thread;
+
+namespace google::scp::core::test {
+TEST(HttpIoContextPoolTest, DefaultsToOneThreadPerCore) {
+  HttpIoContextPool pool;
+  EXPECT_EQ(pool.GetThreadCount(),
+            std::max(thread::hardware_concurrency(), 1u));
+}
+
+TEST(HttpIoContextPoolTest, HandsOutIoContextsInRoundRobin) {
+  HttpIoContextPool pool(/*thread_count=*/3);
+  EXPECT_SUCCESS(pool.Init());
+  EXPECT_SUCCESS(pool.Run());
+
+  set<io_context*> io_contexts;
+  for (int i = 0; i < 6; i++) {
+    io_contexts.insert(pool.GetIoContext().get());
+  }
+  EXPECT_EQ(io_contexts.size(), 3);
+  EXPECT_SUCCESS(pool.Stop());
+}
+
+TEST(HttpIoContextPoolTest, RunsHandlersOnAThreadPerIoContext) {
+  HttpIoContextPool pool(/*thread_count=*/2, /*pin_threads=*/true);
+  EXPECT_SUCCESS(pool.Init());
+  EXPECT_SUCCESS(pool.Run());
+
+  mutex thread_ids_mutex;
+  set<thread::id> thread_ids;
+  atomic<int> handler_count = 0;
+  for (int i = 0; i < 20; i++) {
+    post(*pool.GetIoContext(), [&]() {
+      scoped_lock lock(thread_ids_mutex);
+      thread_ids.insert(std::this_thread::get_id());
+      handler_count++;
+    });
+  }
+  WaitUntil([&]() { return handler_count == 20; });
+  EXPECT_EQ(thread_ids.size(), 2);
+  EXPECT_EQ(thread_ids.count(std::this_thread::get_id()), 0);
+  EXPECT_SUCCESS(pool.Stop());
+}
+
+TEST(HttpIoContextPoolTest, KeepsRunningAfterAHandlerThrows) {
+  HttpIoContextPool pool(/*thread_count=*/1);
+  EXPECT_SUCCESS(pool.Init());
+  EXPECT_SUCCESS(pool.Run());
+
+  atomic<bool> handled = false;
+  auto io_context = pool.GetIoContext();
+  post(*io_context, []() { throw std::runtime_error("handler error"); });
+  post(*io_context, [&]() { handled = true; });
+  WaitUntil([&]() { return handled.load(); });
+  EXPECT_SUCCESS(pool.Stop());
+}
+
+TEST(HttpIoContextPoolTest, StopRunsThePendingHandlers) {
+  HttpIoContextPool pool(/*thread_count=*/1);
+  EXPECT_SUCCESS(pool.Init());
+  EXPECT_SUCCESS(pool.Run());
+
+  atomic<int> handler_count = 0;
+  auto io_context = pool.GetIoContext();
+  post(*io_context, [&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    handler_count++;
+    // Posted while the pool is stopping.
+    post(*io_context, [&]() { handler_count++; });
+  });
+  EXPECT_SUCCESS(pool.Stop());
+  EXPECT_EQ(handler_count, 2);
+}
+}  // namespace google::scp::core::test
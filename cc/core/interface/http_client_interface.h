@@ -22,6 +22,7 @@
 #include "async_context.h"
 #include "http_types.h"
 #include "service_interface.h"
+#include "streaming_context.h"
 #include "type_def.h"
 
 namespace google::scp::core {
@@ -39,5 +40,23 @@ class HttpClientInterface : public ServiceInterface {
    */
   virtual ExecutionResult PerformRequest(
       AsyncContext<HttpRequest, HttpResponse>& context) noexcept = 0;
+
+  /**
+   * @brief Performs a HTTP request and streams the response body. An
+   * HttpResponse is pushed to the context for each chunk of the body as it
+   * arrives, holding the status code, the headers and the chunk. A response
+   * without a body yields a single HttpResponse with an empty body. The
+   * context is finished once the body is complete.
+   *
+   * The response queue of the context bounds how far the consumer may fall
+   * behind. While it is full, the body is held back until the consumer catches
+   * up or the context expires. Cancelling the context aborts the request.
+   *
+   * @param context the streaming context of HTTP action.
+   * @return ExecutionResult the execution result of the action.
+   */
+  virtual ExecutionResult PerformStreamingRequest(
+      ConsumerStreamingContext<HttpRequest, HttpResponse>&
+          context) noexcept = 0;
 };
 }  // namespace google::scp::core
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <optional>
@@ -44,6 +45,20 @@ struct AuthContext {
   std::shared_ptr<std::string> authorized_domain;
 };
 
+struct HttpResponse;
+
+/// What a transport does after handing a response body chunk to the response
+/// body chunk callback of a request.
+enum class HttpResponseBodyChunkAction {
+  /// The chunk was taken, the transfer goes on.
+  Continue = 0,
+  /// The chunk was not taken. The transfer is paused and the same chunk is
+  /// handed over again once the transfer resumes.
+  Pause = 1,
+  /// The request is aborted.
+  Abort = 2,
+};
+
 /// Http request object.
 struct HttpRequest {
   virtual ~HttpRequest() = default;
@@ -64,6 +79,19 @@ struct HttpRequest {
   BytesBuffer body;
   /// Represents the context of authentication and/or authorization.
   AuthContext auth_context;
+  /**
+   * @brief If set, the response body is handed to this callback chunk by chunk
+   * as it arrives instead of being collected into the body of the response.
+   * The response passed along holds the status code and the headers. The end
+   * of the body is signaled by a chunk of length 0. The data is only valid for
+   * the duration of the call. The returned action tells whether to go on,
+   * pause or abort the transfer. Only transports that can hold data back
+   * support pausing, the others abort the request instead. The end of the body
+   * cannot be paused.
+   */
+  std::function<HttpResponseBodyChunkAction(
+      const HttpResponse& response, const uint8_t* data, size_t length)>
+      response_body_chunk_callback;
 };
 
 /// Http response object.
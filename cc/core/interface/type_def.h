@@ -130,5 +130,13 @@ static constexpr TimeDuration kDefaultRetryStrategyDelayInMs = 101;
 // The default config value for HttpClientOptions
 static constexpr size_t kDefaultMaxConnectionsPerHost = 2;
 static constexpr TimeDuration kDefaultHttp2ReadTimeoutInSeconds = 60;
+/// The default limit of concurrent streams per http2 connection, the minimum
+/// recommended value of SETTINGS_MAX_CONCURRENT_STREAMS in RFC 9113.
+static constexpr size_t kDefaultHttp2MaxConcurrentStreamsPerConnection = 100;
+static constexpr size_t kDefaultHttp2MaxPendingRequestsPerHost = 10000;
+/// The default limit of the response body bytes held back per stream while
+/// the consumer of a streaming request is behind.
+static constexpr size_t kDefaultHttp2MaxHeldBackResponseBodyBytes =
+    16 * 1024 * 1024;
 
 }  // namespace google::scp::core
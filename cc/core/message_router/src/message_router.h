@@ -58,6 +58,7 @@ class MessageRouter : public MessageRouterInterface<google::protobuf::Any,
  private:
   // TODO(b/229794047): Figures out a better way to store the request_type to
   // have a better performance.
-  common::ConcurrentMap<std::string, AsyncAction> actions_;
+  common::ConcurrentMap<std::string, AsyncAction> actions_{
+      common::ConcurrentMapMode::Sharded};
 };
 }  // namespace google::scp::core
@@ -34,9 +34,20 @@ using std::string;
 namespace google::scp::core::utils {
 ExecutionResultOr<std::string> GetEscapedUriWithQuery(
     const HttpRequest& request) {
+  if (!request.path) {
+    return FailureExecutionResult(core::errors::SC_CORE_UTILS_INVALID_INPUT);
+  }
   if (!request.query || request.query->empty()) {
     return *request.path;
   }
+  return GetEscapedUriWithQuery(*request.path, *request.query);
+}
+
+ExecutionResultOr<std::string> GetEscapedUriWithQuery(const string& uri,
+                                                      const string& query) {
+  if (query.empty()) {
+    return uri;
+  }
 
   CURL* curl_handle = curl_easy_init();
   if (!curl_handle) {
@@ -45,7 +56,7 @@ ExecutionResultOr<std::string> GetEscapedUriWithQuery(
 
   string escaped_query;
   // The "value" portion of each parameter needs to be escaped.
-  for (const auto& query_part : absl::StrSplit(*request.query, "&")) {
+  for (const auto& query_part : absl::StrSplit(query, "&")) {
     if (!escaped_query.empty()) absl::StrAppend(&escaped_query, "&");
 
     std::pair<string, string> name_and_value =
@@ -58,6 +69,6 @@ ExecutionResultOr<std::string> GetEscapedUriWithQuery(
   }
 
   curl_easy_cleanup(curl_handle);
-  return absl::StrCat(*request.path, "?", escaped_query);
+  return absl::StrCat(uri, "?", escaped_query);
 }
 }  // namespace google::scp::core::utils
@@ -31,4 +31,15 @@ namespace google::scp::core::utils {
  */
 ExecutionResultOr<std::string> GetEscapedUriWithQuery(
     const HttpRequest& request);
+
+/**
+ * @brief Get the Escaped URI from a URI and a query
+ * Appends the query (after being escaped) to the URI and returns it.
+ *
+ * @param uri
+ * @param query
+ * @return ExecutionResultOr<std::string>
+ */
+ExecutionResultOr<std::string> GetEscapedUriWithQuery(const std::string& uri,
+                                                      const std::string& query);
 }  // namespace google::scp::core::utils
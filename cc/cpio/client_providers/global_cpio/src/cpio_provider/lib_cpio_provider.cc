@@ -42,12 +42,18 @@ using google::scp::core::AsyncExecutorInterface;
 using google::scp::core::ExecutionResult;
 using google::scp::core::FailureExecutionResult;
 using google::scp::core::Http1CurlClient;
+using google::scp::core::Http1CurlClientMode;
+using google::scp::core::Http1CurlWrapperProvider;
 using google::scp::core::HttpClient;
 using google::scp::core::HttpClientInterface;
 using google::scp::core::MessageRouter;
 using google::scp::core::MessageRouterInterface;
 using google::scp::core::SuccessExecutionResult;
+using google::scp::core::kDefaultRetryStrategyDelayInMs;
+using google::scp::core::kDefaultRetryStrategyMaxRetries;
 using google::scp::core::common::kZeroUuid;
+using google::scp::core::common::RetryStrategyOptions;
+using google::scp::core::common::RetryStrategyType;
 using google::scp::core::errors::
     SC_LIB_CPIO_ROVIDER_CPU_ASYNC_EXECUTOR_ALREADY_EXISTS;
 using google::scp::core::errors::
@@ -216,8 +222,15 @@ ExecutionResult LibCpioProvider::GetHttp1Client(
     return execution_result;
   }
 
-  http1_client_ =
-      make_shared<Http1CurlClient>(cpu_async_executor, io_async_executor);
+  // Multiplexes the requests onto an event loop instead of blocking a thread
+  // of the IO executor per request.
+  http1_client_ = make_shared<Http1CurlClient>(
+      cpu_async_executor, io_async_executor,
+      make_shared<Http1CurlWrapperProvider>(),
+      RetryStrategyOptions(RetryStrategyType::Exponential,
+                           kDefaultRetryStrategyDelayInMs,
+                           kDefaultRetryStrategyMaxRetries),
+      Http1CurlClientMode::Multi);
   execution_result = http1_client_->Init();
   if (!execution_result.Successful()) {
     SCP_ERROR(kLibCpioProvider, kZeroUuid, execution_result,
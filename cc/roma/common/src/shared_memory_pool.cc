@@ -16,10 +16,13 @@
 
 #include "shared_memory_pool.h"
 
+#include <algorithm>
 #include <exception>
 #include <limits>
 #include <mutex>
 
+using std::adopt_lock;
+using std::atomic;
 using std::lock_guard;
 using std::memory_order_relaxed;
 using std::memory_order_release;
@@ -29,6 +32,7 @@ namespace google::scp::roma::common {
 
 thread_local SharedMemoryPool* SharedMemoryPool::default_mempool_of_thread_ =
     nullptr;
+thread_local RoleId SharedMemoryPool::role_of_thread_;
 
 SharedMemoryPool::SharedMemoryPool()
     : base_addr_(nullptr),
@@ -37,26 +41,49 @@ SharedMemoryPool::SharedMemoryPool()
       allocated_size_(0UL),
       head_(nullptr),
       first_free_(nullptr),
-      tail_(nullptr) {}
+      tail_(nullptr),
+      size_classes_enabled_(false),
+      slab_size_(0UL),
+      size_class_object_size_(0UL),
+      size_class_requested_size_(0UL),
+      large_allocation_count_(0UL),
+      cache_refill_count_(0UL),
+      cache_flush_count_(0UL),
+      block_lock_contention_count_(0UL),
+      central_lock_contention_count_(0UL),
+      cache_lock_contention_count_(0UL) {}
 
-SharedMemoryPool::SharedMemoryPool(void* memory, size_t size)
-    : base_addr_(memory),
-      capacity_(size),
-      block_count_(0UL),
-      allocated_size_(0UL),
-      head_(nullptr),
-      first_free_(nullptr),
-      tail_(nullptr) {
-  Init(memory, size);
+SharedMemoryPool::SharedMemoryPool(void* memory, size_t size,
+                                   bool enable_size_classes)
+    : SharedMemoryPool() {
+  Init(memory, size, enable_size_classes);
 }
 
-void SharedMemoryPool::Init(void* memory, size_t size) {
+void SharedMemoryPool::Init(void* memory, size_t size,
+                            bool enable_size_classes) {
   base_addr_ = memory;
   capacity_ = size;
   head_ = Block::Create(memory, size - kBlockDataOffset);
   first_free_ = head_;
   tail_ = head_;
   block_count_ = 1;
+  size_classes_enabled_ = enable_size_classes;
+}
+
+void SharedMemoryPool::LockCountingContention(
+    ShmMutex& mutex, atomic<size_t>& contention_count) {
+  if (!mutex.try_lock()) {
+    contention_count.fetch_add(1, memory_order_relaxed);
+    mutex.lock();
+  }
+}
+
+size_t SharedMemoryPool::GetSizeClass(size_t size) {
+  size_t size_class = 0;
+  while (size_class < kSizeClassCount && kSizeClasses[size_class] < size) {
+    size_class++;
+  }
+  return size_class;
 }
 
 size_t SharedMemoryPool::TailSpace() const {
@@ -170,7 +197,19 @@ SharedMemoryPool::Block* SharedMemoryPool::AllocateByLinearSearch(size_t size) {
 }
 
 void* SharedMemoryPool::Allocate(size_t size) {
-  lock_guard lock(alloc_mutex_);
+  if (size_classes_enabled_) {
+    auto size_class = GetSizeClass(size);
+    if (size_class < kSizeClassCount) {
+      return AllocateFromSizeClass(size, size_class);
+    }
+    large_allocation_count_.fetch_add(1, memory_order_relaxed);
+  }
+  return AllocateBlock(size);
+}
+
+void* SharedMemoryPool::AllocateBlock(size_t size) {
+  LockCountingContention(alloc_mutex_, block_lock_contention_count_);
+  lock_guard lock(alloc_mutex_, adopt_lock);
   // Try allocating from first free block, if fail then allocate from tail.
   Block* block = AllocateFromFirstFree(size);
   if (block != nullptr) {
@@ -188,15 +227,22 @@ void* SharedMemoryPool::Allocate(size_t size) {
 void SharedMemoryPool::Deallocate(void* pointer) {
   // Deallocation is mostly just flipping the free bit on the block. Hence we do
   // not need to lock the mutex. This hence requires all changes made to the
-  // pool to be consistent and atomic.
+  // pool to be consistent and atomic. The objects of the size classes go back
+  // to the free lists instead.
   uintptr_t base = reinterpret_cast<uintptr_t>(pointer) - kBlockDataOffset;
   uintptr_t first_block_addr = reinterpret_cast<uintptr_t>(head_);
-  uintptr_t last_block_addr = reinterpret_cast<uintptr_t>(tail_);
-  if (base < first_block_addr || base > last_block_addr) {
+  // The objects of the size classes may lie past the tail block, when their
+  // slab took the tail block whole.
+  uintptr_t pool_end_addr = reinterpret_cast<uintptr_t>(base_addr_) + capacity_;
+  if (base < first_block_addr || base >= pool_end_addr) {
     throw std::runtime_error(
         "Trying to deallocate memory that does not belong to this pool.");
   }
   Block* block = reinterpret_cast<Block*>(base);
+  if (block->IsSizeClassObject()) {
+    DeallocateToSizeClass(block);
+    return;
+  }
   allocated_size_ -= block->data_size_ + kBlockDataOffset;
 
   // If this block is before first_free_, set as first_free_
@@ -207,4 +253,147 @@ void SharedMemoryPool::Deallocate(void* pointer) {
   block->SetFree();
 }
 
+void* SharedMemoryPool::AllocateFromSizeClass(size_t size,
+                                              size_t size_class) {
+  Block* object = nullptr;
+  auto role = role_of_thread_;
+  if (role.Bad()) {
+    LockCountingContention(central_mutex_, central_lock_contention_count_);
+    lock_guard lock(central_mutex_, adopt_lock);
+    auto& free_list = central_free_lists_[size_class];
+    if (free_list.head == nullptr &&
+        !RefillFromCentral(free_list, size_class)) {
+      return nullptr;
+    }
+    object = free_list.Pop();
+  } else {
+    auto& cache = role_caches_[role.IsDispatcher() ? 0 : 1];
+    LockCountingContention(cache.mutex, cache_lock_contention_count_);
+    lock_guard lock(cache.mutex, adopt_lock);
+    auto& free_list = cache.free_lists[size_class];
+    if (free_list.head == nullptr) {
+      LockCountingContention(central_mutex_, central_lock_contention_count_);
+      lock_guard central_lock(central_mutex_, adopt_lock);
+      if (!RefillFromCentral(free_list, size_class)) {
+        return nullptr;
+      }
+      cache_refill_count_.fetch_add(1, memory_order_relaxed);
+    }
+    object = free_list.Pop();
+  }
+
+  object->data_size_ = size;
+  object->SetAllocated();
+  size_class_object_size_.fetch_add(kSizeClasses[size_class] + kBlockDataOffset,
+                                    memory_order_relaxed);
+  size_class_requested_size_.fetch_add(size, memory_order_relaxed);
+  return object->Begin();
+}
+
+void SharedMemoryPool::DeallocateToSizeClass(Block* object) {
+  auto size_class = object->GetSizeClass();
+  size_class_object_size_.fetch_sub(kSizeClasses[size_class] + kBlockDataOffset,
+                                    memory_order_relaxed);
+  size_class_requested_size_.fetch_sub(object->data_size_,
+                                       memory_order_relaxed);
+  object->SetFree();
+
+  auto role = role_of_thread_;
+  if (role.Bad()) {
+    LockCountingContention(central_mutex_, central_lock_contention_count_);
+    lock_guard lock(central_mutex_, adopt_lock);
+    central_free_lists_[size_class].Push(object);
+    return;
+  }
+
+  // The object goes to the cache of the role freeing it, which is usually
+  // not the role that allocated it.
+  auto& cache = role_caches_[role.IsDispatcher() ? 0 : 1];
+  LockCountingContention(cache.mutex, cache_lock_contention_count_);
+  lock_guard lock(cache.mutex, adopt_lock);
+  auto& free_list = cache.free_lists[size_class];
+  free_list.Push(object);
+  if (free_list.count >= 2 * kCacheBatchSize) {
+    LockCountingContention(central_mutex_, central_lock_contention_count_);
+    lock_guard central_lock(central_mutex_, adopt_lock);
+    FlushToCentral(free_list, size_class);
+    cache_flush_count_.fetch_add(1, memory_order_relaxed);
+  }
+}
+
+bool SharedMemoryPool::RefillFromCentral(FreeList& free_list,
+                                         size_t size_class) {
+  auto& central_free_list = central_free_lists_[size_class];
+  if (central_free_list.head == nullptr) {
+    // Carve a new slab into objects.
+    auto* slab = reinterpret_cast<uint8_t*>(AllocateBlock(kSlabSize));
+    if (slab == nullptr) {
+      return false;
+    }
+    slab_size_.fetch_add(kSlabSize + kBlockDataOffset, memory_order_relaxed);
+    size_t object_size = kSizeClasses[size_class] + kBlockDataOffset;
+    uint32_t flags = Block::kBitSizeClassObject |
+                     static_cast<uint32_t>(size_class)
+                         << Block::kSizeClassShift;
+    for (size_t offset = 0; offset + object_size <= kSlabSize;
+         offset += object_size) {
+      auto* object = Block::Create(slab + offset, 0);
+      object->flags.store(flags, memory_order_relaxed);
+      central_free_list.Push(object);
+    }
+  }
+  // The central lists serve the threads without a role directly.
+  if (&free_list == &central_free_list) {
+    return true;
+  }
+  for (size_t i = 0; i < kCacheBatchSize && central_free_list.head != nullptr;
+       i++) {
+    free_list.Push(central_free_list.Pop());
+  }
+  return true;
+}
+
+void SharedMemoryPool::FlushToCentral(FreeList& free_list, size_t size_class) {
+  auto& central_free_list = central_free_lists_[size_class];
+  for (size_t i = 0; i < kCacheBatchSize && free_list.head != nullptr; i++) {
+    central_free_list.Push(free_list.Pop());
+  }
+}
+
+SharedMemoryPool::Stats SharedMemoryPool::GetStats() {
+  Stats stats;
+  {
+    lock_guard lock(alloc_mutex_);
+    stats.allocated_size = allocated_size_.load();
+    stats.block_count = block_count_;
+    // Adjacent free blocks are merged lazily, so they are counted as one.
+    size_t free_run_size = 0;
+    for (Block* block = head_; block != nullptr; block = block->next_) {
+      if (block->IsFree()) {
+        free_run_size += block->data_size_ + kBlockDataOffset;
+      }
+      if (free_run_size > 0 &&
+          (!block->IsFree() || block->next_ == nullptr)) {
+        // The data of the merged block doesn't include its header.
+        auto free_block_size = free_run_size - kBlockDataOffset;
+        stats.free_block_count++;
+        stats.free_size += free_block_size;
+        stats.largest_free_block_size =
+            std::max(stats.largest_free_block_size, free_block_size);
+        free_run_size = 0;
+      }
+    }
+  }
+  stats.slab_size = slab_size_.load();
+  stats.size_class_object_size = size_class_object_size_.load();
+  stats.size_class_requested_size = size_class_requested_size_.load();
+  stats.large_allocation_count = large_allocation_count_.load();
+  stats.cache_refill_count = cache_refill_count_.load();
+  stats.cache_flush_count = cache_flush_count_.load();
+  stats.block_lock_contention_count = block_lock_contention_count_.load();
+  stats.central_lock_contention_count = central_lock_contention_count_.load();
+  stats.cache_lock_contention_count = cache_lock_contention_count_.load();
+  return stats;
+}
+
 }  // namespace google::scp::roma::common
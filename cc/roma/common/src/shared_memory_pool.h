@@ -22,6 +22,7 @@
 #include <new>
 #include <type_traits>
 
+#include "role_id.h"
 #include "shared_memory.h"
 #include "shm_mutex.h"
 
@@ -43,6 +44,14 @@ class LocalPoolFixture;
  *   - Otherwise, allocate from the tail.
  * This way the allocated memory are more cache friendly, and search should
  * succeed in semi-constant time.
+ *
+ * Optionally, the small allocations are served by size classes instead: each
+ * size class carves fixed size objects out of slabs allocated as above, and
+ * keeps the freed objects in free lists. Each role (the dispatcher and the
+ * worker) caches the objects in lists of its own, which are refilled from and
+ * flushed to the central lists in batches, so that the roles do not contend
+ * with each other on the common path. Allocations larger than the largest
+ * size class fall back to the blocks.
  */
 class SharedMemoryPool {
   /// The memory blocks, implemented as singly linked list
@@ -57,6 +66,11 @@ class SharedMemoryPool {
     /// allocated.
     std::atomic<uint32_t> flags;
     static constexpr uint32_t kBitAllocated = 0x00000001;
+    /// Set on the objects of the size classes, which are carved out of a slab
+    /// block rather than linked in the list of blocks. Their data_size_ is the
+    /// requested size, and their size class is stored in the flags.
+    static constexpr uint32_t kBitSizeClassObject = 0x00000002;
+    static constexpr uint32_t kSizeClassShift = 8;
 
     /// The actual data location. We use max_align_t here to guarantee
     /// alignment. The actual size isn't 1, but defined by \a data_size_. Also
@@ -96,6 +110,16 @@ class SharedMemoryPool {
     /// If this block is free.
     inline bool IsFree() const { return !(flags.load() & kBitAllocated); }
 
+    /// If this block is an object of a size class.
+    inline bool IsSizeClassObject() const {
+      return flags.load(std::memory_order_relaxed) & kBitSizeClassObject;
+    }
+
+    /// The size class of this object of a size class.
+    inline size_t GetSizeClass() const {
+      return flags.load(std::memory_order_relaxed) >> kSizeClassShift;
+    }
+
     /// Align up an integral number to the max alignment required.
     template <typename T>
     static T AlignUp(T t) {
@@ -179,12 +203,57 @@ class SharedMemoryPool {
     static void operator delete[](void*) = delete;
   };
 
+  /// Statistics of the pool, see GetStats().
+  struct Stats {
+    /// Sum of all allocated block sizes, including overheads and the slabs.
+    size_t allocated_size = 0;
+    /// Number of blocks, and of free blocks once adjacent ones are merged.
+    size_t block_count = 0;
+    size_t free_block_count = 0;
+    /// The free space of the blocks, and the largest free block.
+    size_t free_size = 0;
+    size_t largest_free_block_size = 0;
+    /// The size of the slabs of the size classes, of their objects in use and
+    /// the size requested for those objects.
+    size_t slab_size = 0;
+    size_t size_class_object_size = 0;
+    size_t size_class_requested_size = 0;
+    /// Number of allocations larger than the largest size class.
+    size_t large_allocation_count = 0;
+    /// Number of batches moved from and to the central lists by the roles.
+    size_t cache_refill_count = 0;
+    size_t cache_flush_count = 0;
+    /// Number of times a lock of the pool was held by another thread when
+    /// acquiring it, for the blocks, the central lists and the role caches.
+    size_t block_lock_contention_count = 0;
+    size_t central_lock_contention_count = 0;
+    size_t cache_lock_contention_count = 0;
+
+    /// The share of the free space that is not in the largest free block.
+    double GetExternalFragmentation() const {
+      return free_size == 0 ? 0.0
+                            : 1.0 - static_cast<double>(
+                                        largest_free_block_size) /
+                                        free_size;
+    }
+
+    /// The share of the size class objects in use that was not requested.
+    double GetInternalFragmentation() const {
+      return size_class_object_size == 0
+                 ? 0.0
+                 : 1.0 - static_cast<double>(size_class_requested_size) /
+                             size_class_object_size;
+    }
+  };
+
   /// Constructs empty memory pool
   SharedMemoryPool();
   /// Constructs the memory pool with allocated \a memory and \a size.
-  SharedMemoryPool(void* memory, size_t size);
-  /// Initialize the pool with allocated \a memory and \a size.
-  void Init(void* memory, size_t size);
+  SharedMemoryPool(void* memory, size_t size,
+                   bool enable_size_classes = false);
+  /// Initialize the pool with allocated \a memory and \a size. If \a
+  /// enable_size_classes, the small allocations are served by size classes.
+  void Init(void* memory, size_t size, bool enable_size_classes = false);
   /// Allocate (at least) \a size bytes. See doc of SharedMemoryPool for
   /// allocation strategies.
   [[nodiscard]] void* Allocate(size_t size);
@@ -207,6 +276,14 @@ class SharedMemoryPool {
 
   size_t GetAllocatedSize() { return allocated_size_.load(); }
 
+  /// Get the statistics of the pool. This walks the blocks under the
+  /// allocation lock, so it is meant for monitoring rather than hot paths.
+  Stats GetStats();
+
+  /// Set the role of this thread, whose cache serves the size classes. The
+  /// threads without a role use the central lists directly.
+  static void SetThisThreadRole(RoleId role) { role_of_thread_ = role; }
+
   /// Set the default mempool for this thread. This is useful when we have a
   /// thread working on a designated pool, and this allows default-construction
   /// of ShmAllocators, so that it eases the construction of objects.
@@ -226,10 +303,72 @@ class SharedMemoryPool {
   friend class test::LocalPoolFixture;
   /// The offset of data relative to the beginning of a Block.
   static constexpr size_t kBlockDataOffset = offsetof(Block, data);
+  /// The data sizes of the size classes. They are multiples of the block
+  /// alignment, so that the objects of a slab stay aligned.
+  static constexpr size_t kSizeClasses[] = {
+      16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048};
+  static constexpr size_t kSizeClassCount =
+      sizeof(kSizeClasses) / sizeof(kSizeClasses[0]);
+  /// The size of the slabs the objects of the size classes are carved out of.
+  static constexpr size_t kSlabSize = 64 * 1024;
+  /// The number of objects moved between a role cache and the central lists
+  /// at once. A cache is flushed when it holds twice as many.
+  static constexpr size_t kCacheBatchSize = 32;
+  /// The roles caching objects: the dispatcher and the worker.
+  static constexpr size_t kCacheRoleCount = 2;
+
+  /// A list of free objects of a size class, linked by Block::next_.
+  struct FreeList {
+    Block* head = nullptr;
+    size_t count = 0;
+
+    void Push(Block* object) {
+      object->next_ = head;
+      head = object;
+      count++;
+    }
+
+    Block* Pop() {
+      Block* object = head;
+      head = object->next_;
+      count--;
+      return object;
+    }
+  };
+
+  /// The free objects cached by a role.
+  struct RoleCache {
+    ShmMutex mutex;
+    FreeList free_lists[kSizeClassCount];
+  };
 
   /// This is the default mem pool of the current thread. Set by
   /// SetThisThreadMemPool().
   static thread_local SharedMemoryPool* default_mempool_of_thread_;
+  /// The role of the current thread. Set by SetThisThreadRole().
+  static thread_local RoleId role_of_thread_;
+
+  /// Lock \a mutex, counting in \a contention_count if it was held.
+  static void LockCountingContention(
+      ShmMutex& mutex, std::atomic<size_t>& contention_count);
+
+  /// Get the smallest size class fitting \a size, or kSizeClassCount if
+  /// none does.
+  static size_t GetSizeClass(size_t size);
+
+  /// Allocate a block of (at least) \a size bytes.
+  void* AllocateBlock(size_t size);
+  /// Allocate an object of \a size bytes from \a size_class.
+  void* AllocateFromSizeClass(size_t size, size_t size_class);
+  /// Return an object of a size class to the free lists.
+  void DeallocateToSizeClass(Block* object);
+  /// Move a batch of free objects of \a size_class from the central lists to
+  /// \a free_list, carving a new slab if needed. Must hold central_mutex_.
+  /// \return false if the pool is out of memory.
+  bool RefillFromCentral(FreeList& free_list, size_t size_class);
+  /// Move a batch of free objects from \a free_list to the central lists.
+  /// Must hold central_mutex_.
+  void FlushToCentral(FreeList& free_list, size_t size_class);
 
   /// The space remaining at the tail block.
   size_t TailSpace() const;
@@ -261,6 +400,25 @@ class SharedMemoryPool {
   std::atomic<Block*> first_free_;
   /// The tail block.
   Block* tail_;
+
+  /// If the small allocations are served by size classes.
+  bool size_classes_enabled_;
+  /// The mutex for the central lists.
+  ShmMutex central_mutex_;
+  /// The free objects shared by all the roles.
+  FreeList central_free_lists_[kSizeClassCount];
+  /// The free objects of each role.
+  RoleCache role_caches_[kCacheRoleCount];
+  /// Statistics of the size classes, see Stats.
+  std::atomic<size_t> slab_size_;
+  std::atomic<size_t> size_class_object_size_;
+  std::atomic<size_t> size_class_requested_size_;
+  std::atomic<size_t> large_allocation_count_;
+  std::atomic<size_t> cache_refill_count_;
+  std::atomic<size_t> cache_flush_count_;
+  std::atomic<size_t> block_lock_contention_count_;
+  std::atomic<size_t> central_lock_contention_count_;
+  std::atomic<size_t> cache_lock_contention_count_;
 };
 
 }  // namespace google::scp::roma::common
@@ -64,11 +64,12 @@ class ShmMutexBase {
       return true;
     }
     // There is no way to know the failure reason by this signature. So we just
-    // crash if not graceful failure.
-    if (errno != EBUSY || errno != EAGAIN) {
+    // crash if not graceful failure. pthread_mutex_trylock returns the error
+    // number rather than setting errno.
+    if (ret != EBUSY && ret != EAGAIN) {
       throw std::runtime_error(
           std::string("Failed to try_lock mutex due to internal errno=") +
-          std::to_string(errno));
+          std::to_string(ret));
     }
     return false;
   }
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "roma/common/src/role_id.h"
+#include "roma/common/src/shared_memory_pool.h"
+
+using std::atomic;
+using std::cout;
+using std::deque;
+using std::endl;
+using std::make_unique;
+using std::mutex;
+using std::thread;
+using std::unique_lock;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace google::scp::roma::common::test {
+/**
+ * @brief Runs pairs of dispatcher and worker threads over a pool, the way a
+ * request and its response cross the roles: each thread allocates a mix of
+ * small and large objects, hands them to the other role, and frees what the
+ * other role handed to it. Reports the throughput and the pool statistics.
+ */
+static void RunMixedRoleWorkload(bool enable_size_classes) {
+  constexpr size_t kPairCount = 4;
+  constexpr size_t kAllocationsPerThread = 40000;
+  constexpr size_t kMemSize = 256 * 1024 * 1024;
+
+  auto mem = make_unique<char[]>(kMemSize);
+  SharedMemoryPool pool(mem.get(), kMemSize, enable_size_classes);
+
+  // The objects handed over from one role to the other, per pair.
+  struct Handoff {
+    mutex handoff_mutex;
+    deque<void*> to_worker;
+    deque<void*> to_dispatcher;
+  };
+  vector<Handoff> handoffs(kPairCount);
+  atomic<size_t> failed_allocation_count = 0;
+
+  auto run_role = [&](size_t pair, bool is_dispatcher) {
+    SharedMemoryPool::SetThisThreadRole(RoleId(pair, is_dispatcher));
+    auto& handoff = handoffs[pair];
+    auto& outbox = is_dispatcher ? handoff.to_worker : handoff.to_dispatcher;
+    auto& inbox = is_dispatcher ? handoff.to_dispatcher : handoff.to_worker;
+    uint64_t seed = pair * 2 + is_dispatcher + 1;
+    vector<void*> received;
+    for (size_t i = 0; i < kAllocationsPerThread; i++) {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      // One in sixteen allocations is a large payload, the others are the
+      // strings and nodes of a request.
+      size_t size = (seed >> 33) % 16 == 0 ? 4096 + (seed >> 40) % 61440
+                                           : 8 + (seed >> 40) % 500;
+      auto p = pool.Allocate(size);
+      {
+        unique_lock lock(handoff.handoff_mutex);
+        if (p != nullptr) {
+          outbox.push_back(p);
+        } else {
+          failed_allocation_count++;
+        }
+        while (!inbox.empty()) {
+          received.push_back(inbox.front());
+          inbox.pop_front();
+        }
+      }
+      for (auto q : received) {
+        pool.Deallocate(q);
+      }
+      received.clear();
+    }
+  };
+
+  auto start = steady_clock::now();
+  vector<thread> threads;
+  for (size_t pair = 0; pair < kPairCount; pair++) {
+    threads.emplace_back(run_role, pair, true /*is_dispatcher*/);
+    threads.emplace_back(run_role, pair, false /*is_dispatcher*/);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  auto elapsed_ms =
+      duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+  auto stats = pool.GetStats();
+  cout << (enable_size_classes ? "Size classes" : "Blocks only") << ": "
+       << kPairCount * 2 * kAllocationsPerThread * 1000 /
+              std::max<int64_t>(elapsed_ms, 1)
+       << " allocations/s, " << failed_allocation_count
+       << " failed allocations, external fragmentation "
+       << stats.GetExternalFragmentation() << ", internal fragmentation "
+       << stats.GetInternalFragmentation() << ", lock contentions (block "
+       << stats.block_lock_contention_count << ", central "
+       << stats.central_lock_contention_count << ", cache "
+       << stats.cache_lock_contention_count << ")" << endl;
+
+  for (auto& handoff : handoffs) {
+    for (auto p : handoff.to_worker) {
+      pool.Deallocate(p);
+    }
+    for (auto p : handoff.to_dispatcher) {
+      pool.Deallocate(p);
+    }
+  }
+  SharedMemoryPool::SetThisThreadRole(RoleId());
+}
+
+TEST(SharedMemoryPoolBenchmarkTest, MixedRoleWorkloadWithBlocksOnly) {
+  GTEST_SKIP();
+  RunMixedRoleWorkload(/*enable_size_classes=*/false);
+}
+
+TEST(SharedMemoryPoolBenchmarkTest, MixedRoleWorkloadWithSizeClasses) {
+  GTEST_SKIP();
+  RunMixedRoleWorkload(/*enable_size_classes=*/true);
+}
+}  // namespace google::scp::roma::common::test
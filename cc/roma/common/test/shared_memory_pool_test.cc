@@ -20,6 +20,7 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <iostream>
@@ -28,9 +29,11 @@
 #include <vector>
 
 #include "core/test/utils/conditional_wait.h"
+#include "roma/common/src/role_id.h"
 
 using google::scp::core::test::WaitUntil;
 using std::atomic;
+using std::find;
 using std::make_unique;
 using std::thread;
 using std::unique_ptr;
@@ -235,4 +238,123 @@ TEST_F(LocalPoolFixture, LinearSearchLogic) {
   EXPECT_EQ(tail_sticky_val, 0x1337C0DE);
 }
 
+class SizeClassPoolFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    constexpr size_t mem_size = 1024 * 1024 * 64;
+    mem_ = make_unique<char[]>(mem_size);
+    pool_ = make_unique<SharedMemoryPool>(mem_.get(), mem_size,
+                                          true /*enable_size_classes*/);
+  }
+
+  void TearDown() override { SharedMemoryPool::SetThisThreadRole(RoleId()); }
+
+  unique_ptr<char[]> mem_;
+  unique_ptr<SharedMemoryPool> pool_;
+};
+
+TEST_F(SizeClassPoolFixture, ReusesFreedObjects) {
+  SharedMemoryPool::SetThisThreadRole(RoleId(0, true /*is_dispatcher*/));
+  vector<void*> allocations;
+  for (int i = 0; i < 100; ++i) {
+    auto p = pool_->Allocate(19);  // <- a prime number to test out alignment
+    ASSERT_NE(p, nullptr);
+    memset(p, 0, 19);
+    uintptr_t ptr_val = reinterpret_cast<uintptr_t>(p);
+    EXPECT_EQ(ptr_val & (alignof(max_align_t) - 1), 0);
+    allocations.push_back(p);
+  }
+  auto stats = pool_->GetStats();
+  EXPECT_GT(stats.slab_size, 0);
+  EXPECT_EQ(stats.size_class_requested_size, 100 * 19);
+  EXPECT_GT(stats.size_class_object_size, stats.size_class_requested_size);
+  EXPECT_GT(stats.GetInternalFragmentation(), 0.0);
+  EXPECT_EQ(stats.large_allocation_count, 0);
+
+  for (auto p : allocations) {
+    pool_->Deallocate(p);
+  }
+  stats = pool_->GetStats();
+  EXPECT_EQ(stats.size_class_object_size, 0);
+  EXPECT_EQ(stats.size_class_requested_size, 0);
+  EXPECT_GT(stats.cache_flush_count, 0);
+
+  // The objects are reused rather than new slabs being carved.
+  auto slab_size = stats.slab_size;
+  auto p = pool_->Allocate(19);
+  EXPECT_NE(find(allocations.begin(), allocations.end(), p),
+            allocations.end());
+  EXPECT_EQ(pool_->GetStats().slab_size, slab_size);
+}
+
+TEST_F(SizeClassPoolFixture, FallsBackToBlocksForLargeAllocations) {
+  auto p = pool_->Allocate(4096);
+  ASSERT_NE(p, nullptr);
+  auto stats = pool_->GetStats();
+  EXPECT_EQ(stats.large_allocation_count, 1);
+  EXPECT_EQ(stats.slab_size, 0);
+  EXPECT_GE(stats.allocated_size, 4096);
+  pool_->Deallocate(p);
+  EXPECT_EQ(pool_->GetAllocatedSize(), 0);
+}
+
+TEST_F(SizeClassPoolFixture, ServesThreadsWithoutARole) {
+  vector<void*> allocations;
+  for (size_t size = 1; size <= 2048; size *= 2) {
+    auto p = pool_->Allocate(size);
+    ASSERT_NE(p, nullptr);
+    memset(p, 0xEF, size);
+    allocations.push_back(p);
+  }
+  for (auto p : allocations) {
+    pool_->Deallocate(p);
+  }
+  auto stats = pool_->GetStats();
+  EXPECT_EQ(stats.size_class_object_size, 0);
+  EXPECT_EQ(stats.cache_refill_count, 0);
+}
+
+TEST_F(SizeClassPoolFixture, ObjectsCanBeFreedByTheOtherRole) {
+  static constexpr int kNumObjects = 1000;
+  vector<void*> allocations(kNumObjects);
+  thread dispatcher([&]() {
+    SharedMemoryPool::SetThisThreadRole(RoleId(0, true /*is_dispatcher*/));
+    for (int i = 0; i < kNumObjects; ++i) {
+      allocations[i] = pool_->Allocate(i % 500 + 1);
+      memset(allocations[i], 0, i % 500 + 1);
+    }
+  });
+  dispatcher.join();
+  thread worker([&]() {
+    SharedMemoryPool::SetThisThreadRole(RoleId(0, false /*is_dispatcher*/));
+    for (auto p : allocations) {
+      pool_->Deallocate(p);
+    }
+  });
+  worker.join();
+
+  auto stats = pool_->GetStats();
+  EXPECT_EQ(stats.size_class_object_size, 0);
+  EXPECT_GT(stats.cache_refill_count, 0);
+  EXPECT_GT(stats.cache_flush_count, 0);
+}
+
+TEST_F(SizeClassPoolFixture, ReportsExternalFragmentation) {
+  auto* first = pool_->Allocate(4096);
+  auto* sticky = pool_->Allocate(4096);
+  auto* second = pool_->Allocate(8192);
+  auto* tail_sticky = pool_->Allocate(4096);
+  pool_->Deallocate(first);
+  pool_->Deallocate(second);
+
+  auto stats = pool_->GetStats();
+  // The free blocks: first, second and the tail.
+  EXPECT_EQ(stats.free_block_count, 3);
+  EXPECT_GT(stats.GetExternalFragmentation(), 0.0);
+  pool_->Deallocate(sticky);
+  pool_->Deallocate(tail_sticky);
+  EXPECT_EQ(pool_->GetStats().free_block_count, 1);
+  EXPECT_EQ(pool_->GetStats().GetExternalFragmentation(), 0.0);
+}
+
 }  // namespace google::scp::roma::common::test
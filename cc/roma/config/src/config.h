@@ -50,6 +50,43 @@ struct JsEngineResourceConstraints {
   size_t maximum_heap_size_in_mb = 0;
 };
 
+struct JsContextPoolOptions {
+  /**
+   * @brief The number of JS contexts, with the code version already
+   * evaluated, that a worker keeps ready for each loaded code version.
+   * Invocations take a context from the pool instead of creating one and
+   * evaluating the code, so they only pay for the handler call. If left as
+   * zero, every invocation creates a new context.
+   *
+   */
+  size_t pool_size = 0;
+
+  /**
+   * @brief The number of invocations a pooled context serves before it is
+   * replaced with a fresh one. Global state the handler leaves behind is seen
+   * by the later invocations on the same context, so handlers relying on a
+   * pristine global object should use 1. A context is also replaced when an
+   * invocation on it fails.
+   *
+   */
+  size_t max_context_uses = 100;
+};
+
+/// How the sandboxed service chooses the worker of a request.
+enum class WorkerSelectionPolicy {
+  /// The workers are chosen in turn, regardless of their load.
+  RoundRobin = 0,
+  /// The worker with the fewest requests queued or running is chosen.
+  LeastOutstanding = 1,
+  /// Two workers are sampled and the one with fewer outstanding requests is
+  /// chosen, which avoids scanning all the workers.
+  PowerOfTwoChoices = 2,
+  /// The requests of a code version are routed to the same few workers, so
+  /// that their isolates keep the compilation context of the version warm.
+  /// Spills over to the least loaded worker when those are backed up.
+  CodeVersionAffinity = 3,
+};
+
 class Config {
  public:
   /**
@@ -78,6 +115,14 @@ class Config {
    */
   size_t ipc_memory_size_in_mb = 0;
 
+  /**
+   * @brief Whether the IPC shared memory serves the small allocations, such as
+   * the strings and the queue nodes of the requests, by size classes cached
+   * per role, instead of searching the blocks of the segment under a single
+   * lock.
+   */
+  bool enable_ipc_memory_size_classes = false;
+
   /**
    * @brief The maximum number of pages that the WASM memory can use. Each page
    * is 64KiB. Will be clamped to 65536 (4GiB) if larger. If left at zero, the
@@ -123,6 +168,54 @@ class Config {
    */
   size_t code_version_cache_size = 5;
 
+  /**
+   * @brief If true, the requests are queued for the workers and each worker
+   * takes the next request as soon as it completes one, instead of each
+   * request holding a thread of the async executor while it runs. Running a
+   * request on a worker is still a blocking call, so each worker is driven by
+   * a thread of its own that waits for as long as the request runs. Only
+   * supported with the sandboxed service.
+   *
+   */
+  bool enable_worker_request_queues = false;
+
+  /**
+   * @brief How the worker of a request is chosen. With the worker request
+   * queues, the requests any worker can run are taken by the first idle
+   * worker, so only the code version affinity applies. Only supported with
+   * the sandboxed service.
+   *
+   */
+  WorkerSelectionPolicy worker_selection_policy =
+      WorkerSelectionPolicy::LeastOutstanding;
+
+  /**
+   * @brief The pool of pre-initialized JS contexts of each code version. Only
+   * supported with the sandboxed service.
+   *
+   */
+  JsContextPoolOptions js_context_pool_options;
+
+  /**
+   * @brief The size in MB of the memory shared with each sandboxed worker,
+   * through which the requests and responses are exchanged in place instead
+   * of being serialized over the sandbox RPC. Requests that do not fit are
+   * serialized, and responses that do not fit are read back from the worker
+   * through a separate serialized call. If left as zero, all the requests are
+   * serialized. Only supported with the sandboxed service.
+   *
+   */
+  size_t worker_shared_memory_arena_size_mb = 0;
+
+  /**
+   * @brief Whether to boot the sandboxed workers from a V8 startup snapshot
+   * that already has the registered function bindings built in it. The
+   * snapshot is created once by the first worker, and also boots the workers
+   * when they are restarted. Only supported with the sandboxed service.
+   *
+   */
+  bool boot_workers_from_startup_snapshot = false;
+
   /**
    * @brief Register a function binding object
    *
@@ -150,6 +243,18 @@ class Config {
     function_binding.release();
   }
 
+  /**
+   * @brief Register an async function binding v2 object. Only supported with
+   * the sandboxed service.
+   *
+   * @param function_binding
+   */
+  void RegisterFunctionBinding(
+      std::unique_ptr<AsyncFunctionBindingObjectV2> function_binding) {
+    async_function_bindings_v2_.emplace_back(function_binding.get());
+    function_binding.release();
+  }
+
   /**
    * @brief Get a copy of the registered function binding objects
    *
@@ -169,6 +274,15 @@ class Config {
         function_bindings_v2_.begin(), function_bindings_v2_.end());
   }
 
+  void GetFunctionBindings(
+      std::vector<std::shared_ptr<AsyncFunctionBindingObjectV2>>&
+          function_bindings) const {
+    function_bindings =
+        std::vector<std::shared_ptr<AsyncFunctionBindingObjectV2>>(
+            async_function_bindings_v2_.begin(),
+            async_function_bindings_v2_.end());
+  }
+
   /**
    * Configures the constraints with reasonable default values based on the
    * provided heap size limit. `initial_heap_size_in_bytes` should be smaller
@@ -206,6 +320,12 @@ class Config {
    */
   std::vector<std::shared_ptr<FunctionBindingObjectV2>> function_bindings_v2_;
 
+  /**
+   * @brief User-registered async JS/C++ function bindings
+   */
+  std::vector<std::shared_ptr<AsyncFunctionBindingObjectV2>>
+      async_function_bindings_v2_;
+
   /// v8 heap resource constraints.
   JsEngineResourceConstraints js_engine_resource_constraints_;
 };
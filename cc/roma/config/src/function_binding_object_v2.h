@@ -34,4 +34,26 @@ class FunctionBindingObjectV2 {
    */
   std::function<void(proto::FunctionBindingIoProto&)> function;
 };
+
+/**
+ * @brief A function binding whose Javascript function returns a Promise, which
+ * is resolved with the output once the C++ function completes, so that the
+ * worker does not block on it and several calls can be in flight.
+ */
+class AsyncFunctionBindingObjectV2 {
+ public:
+  /**
+   * @brief The name by which Javascript code can call this function.
+   */
+  std::string function_name;
+
+  /**
+   * @brief The function that will be bound to a Javascript function. It is
+   * passed the IO proto and a callback to call once the output is set in the
+   * proto, possibly from another thread. The proto is valid until then.
+   */
+  std::function<void(proto::FunctionBindingIoProto&,
+                     std::function<void()> on_completed)>
+      function;
+};
 }  // namespace google::scp::roma
@@ -37,6 +37,19 @@ static constexpr char kTimeoutMsTag[] = "TimeoutMs";
 /// @brief Default value for request execution timeout. If no timeout tag is
 /// set, the default value will be used.
 static constexpr int kDefaultExecutionTimeoutMs = 5000;
+/// @brief The key of the tag selecting the format of the inputs and of the
+/// response of a JS handler invocation. If no IO format tag is set,
+/// kIoFormatJson is used.
+static constexpr char kIoFormatTag[] = "IoFormat";
+/// @brief The inputs are JSON text, and the response is the result of the
+/// handler as JSON text.
+static constexpr char kIoFormatJson[] = "Json";
+/// @brief The inputs are passed to the handler as strings, without being
+/// parsed, and the handler returns a string, which is the response as is.
+static constexpr char kIoFormatString[] = "String";
+/// @brief The inputs and the response are v8::ValueSerializer blobs, which
+/// saves the JSON text round trip for large structured payloads.
+static constexpr char kIoFormatSerialized[] = "Serialized";
 
 // The code object containing untrusted code to be loaded into the Worker.
 struct CodeObject {
@@ -96,6 +109,8 @@ struct ResponseObject {
   std::string id;
   // The response of the execution.
   std::string resp;
+  // The format of the response, see kIoFormatTag.
+  std::string io_format = kIoFormatJson;
   // Execution metrics. Any key should be checked for existence.
   absl::flat_hash_map<std::string, int64_t> metrics;
 };
@@ -139,4 +154,9 @@ absl::Status RomaInit(const Config& config = Config());
 // Stop roma service, which will internally kill all workers and fail all
 // outstanding requests at best effort.
 absl::Status RomaStop();
+
+// Export the histograms of the execution metrics of the requests that
+// completed so far, in the Prometheus text format. Can only be called once
+// Roma is initialized.
+absl::StatusOr<std::string> ScrapeMetrics();
 }  // namespace google::scp::roma
@@ -32,10 +32,11 @@ using std::make_unique;
 using std::unique_ptr;
 
 IpcChannel::IpcChannel(SharedMemorySegment& shared_memory,
-                       size_t worker_queue_capacity)
+                       size_t worker_queue_capacity, bool enable_size_classes)
     : shared_memory_(shared_memory),
       mem_pool_(),
       worker_queue_capacity_(worker_queue_capacity),
+      enable_size_classes_(enable_size_classes),
       last_code_object_without_inputs_(nullptr),
       pending_request_(false) {}
 
@@ -47,7 +48,8 @@ ExecutionResult IpcChannel::Init() noexcept {
     // TODO return error
   }
   size_t pool_size = shared_memory_.Size() - sizeof(*this);
-  mem_pool_.Init(reinterpret_cast<void*>(pool_location), pool_size);
+  mem_pool_.Init(reinterpret_cast<void*>(pool_location), pool_size,
+                 enable_size_classes_);
   auto ctx = SharedMemoryPool::SwitchTo(mem_pool_);
   work_container_ = std::make_unique<WorkContainer>(worker_queue_capacity_);
 
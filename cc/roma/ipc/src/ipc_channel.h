@@ -42,8 +42,15 @@ using common::ShmAllocator;
  */
 class IpcChannel : public IpcChannelInterface<Request, Response> {
  public:
+  /**
+   * @param shared_memory The segment the channel and its pool reside in.
+   * @param worker_queue_capacity The capacity of the work container.
+   * @param enable_size_classes Whether the pool serves the small allocations
+   * by size classes.
+   */
   explicit IpcChannel(SharedMemorySegment& shared_memory,
-                      size_t worker_queue_capacity);
+                      size_t worker_queue_capacity,
+                      bool enable_size_classes = false);
 
   /// Create a mempool allocator for type T.
   template <typename T>
@@ -106,6 +113,7 @@ class IpcChannel : public IpcChannelInterface<Request, Response> {
   SharedMemoryPool mem_pool_;
 
   size_t worker_queue_capacity_;
+  bool enable_size_classes_;
   std::unique_ptr<WorkContainer> work_container_;
   // The last code object item contained in the request that was popped from
   // this channel. Note that this code object will NOT include the inputs.
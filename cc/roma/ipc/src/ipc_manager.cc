@@ -47,6 +47,8 @@ IpcManager::IpcManager(Config config) {
   worker_queue_capacity_ = config.worker_queue_max_items > 0
                                ? config.worker_queue_max_items
                                : kWorkerQueueCapacity;
+
+  enable_size_classes_ = config.enable_ipc_memory_size_classes;
 }
 
 ExecutionResult IpcManager::Init() noexcept {
@@ -60,7 +62,8 @@ ExecutionResult IpcManager::Init() noexcept {
     }
     // Construct an IpcChannel right on the shared memory segment.
     auto* ipc_channel_ptr =
-        new (shared_mem.Get()) IpcChannel(shared_mem, worker_queue_capacity_);
+        new (shared_mem.Get()) IpcChannel(shared_mem, worker_queue_capacity_,
+                                          enable_size_classes_);
     // Construct the unique_ptr
     auto& ipc_channel = ipc_channels_.emplace_back(ipc_channel_ptr);
     ipc_channel->Init();
@@ -98,6 +101,7 @@ ExecutionResult IpcManager::SetUpIpcForMyProcess(RoleId role) {
   }
   my_process_role_ = role;
   my_thread_role_ = role;
+  SharedMemoryPool::SetThisThreadRole(role);
   for (uint32_t i = 0; i < num_processes_; ++i) {
     if (i == role.GetId()) {
       continue;
@@ -121,6 +125,7 @@ ExecutionResult IpcManager::SetUpIpcForMyThread(RoleId role) {
         core::errors::SC_ROMA_IPC_MANAGER_INVALID_INDEX);
   }
   my_thread_role_ = role;
+  SharedMemoryPool::SetThisThreadRole(role);
   ipc_channels_[role.GetId()]->GetMemPool().SetThisThreadMemPool();
   return SuccessExecutionResult();
 }
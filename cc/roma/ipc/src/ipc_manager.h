@@ -52,9 +52,13 @@ class IpcManager : public IpcManagerInterface<Request, Response> {
         : old_role(my_thread_role_),
           memory_ctx(ipc_mgr.GetIpcChannel(role).GetMemPool()) {
       my_thread_role_ = role;
+      SharedMemoryPool::SetThisThreadRole(role);
     }
 
-    ~Context() { IpcManager::my_thread_role_ = old_role; }
+    ~Context() {
+      IpcManager::my_thread_role_ = old_role;
+      SharedMemoryPool::SetThisThreadRole(old_role);
+    }
 
     // Disable heap allocations, so that it can only be used on stack.
     static void* operator new(size_t) = delete;
@@ -131,6 +135,8 @@ class IpcManager : public IpcManagerInterface<Request, Response> {
   size_t shm_segment_size_;
   /// The capacity of worker container for each ipc channel.
   size_t worker_queue_capacity_;
+  /// Whether the memory pools serve the small allocations by size classes.
+  bool enable_size_classes_;
 };
 
 }  // namespace google::scp::roma::ipc
@@ -36,6 +36,7 @@ using google::scp::roma::roma_service::RomaService;
 using absl::OkStatus;
 using absl::Status;
 using absl::StatusCode;
+using absl::StatusOr;
 using google::scp::core::errors::GetErrorMessage;
 using google::scp::core::os::linux::SystemResourceInfoProviderLinux;
 using std::make_unique;
@@ -191,6 +192,16 @@ Status BatchExecute(vector<InvocationRequestSharedInput>& batch,
   return BatchExecuteInternal(batch, batch_callback);
 }
 
+StatusOr<string> ScrapeMetrics() {
+#if defined(_SCP_ROMA_SANDBOXED_LIBRARY)
+  auto* roma_service = RomaService::Instance();
+  return roma_service->Dispatcher().GetMetricHistograms().ToPrometheusText();
+#else
+  return Status(StatusCode::kUnimplemented,
+                "Roma ScrapeMetrics is only supported by the sandboxed Roma.");
+#endif
+}
+
 Status LoadCodeObj(unique_ptr<CodeObject> code_object, Callback callback) {
   if (code_object->version_num == 0) {
     return Status(StatusCode::kInternal,
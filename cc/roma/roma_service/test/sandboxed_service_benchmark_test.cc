@@ -0,0 +1,256 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/common/time_provider/src/time_provider.h"
+#include "core/test/utils/conditional_wait.h"
+#include "roma/config/src/config.h"
+#include "roma/interface/roma.h"
+
+using google::scp::core::common::TimeProvider;
+using google::scp::core::test::WaitUntil;
+using std::atomic;
+using std::cout;
+using std::endl;
+using std::make_unique;
+using std::move;
+using std::mutex;
+using std::sort;
+using std::string;
+using std::thread;
+using std::to_string;
+using std::unique_lock;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::milliseconds;
+using std::this_thread::sleep_for;
+
+namespace google::scp::roma::test {
+/**
+ * @brief Runs a workload where a slow request is interleaved with fast ones,
+ * and reports the throughput and the latency percentiles of the requests.
+ */
+static void RunMixedDurationWorkload(bool enable_worker_request_queues) {
+  constexpr size_t kRequestCount = 20000;
+  constexpr size_t kSlowRequestPeriod = 10;
+
+  Config config;
+  config.number_of_workers = 4;
+  config.worker_queue_max_items = kRequestCount;
+  config.enable_worker_request_queues = enable_worker_request_queues;
+  ASSERT_TRUE(RomaInit(config).ok());
+
+  atomic<bool> load_finished = false;
+  auto code_obj = make_unique<CodeObject>();
+  code_obj->id = "foo";
+  code_obj->version_num = 1;
+  code_obj->js = R"JS_CODE(
+    function Handler(iterations) {
+      let sum = 0;
+      for (let i = 0; i < iterations; i++) { sum += i; }
+      return sum;
+    }
+  )JS_CODE";
+  ASSERT_TRUE(LoadCodeObj(move(code_obj),
+                          [&](unique_ptr<absl::StatusOr<ResponseObject>> resp) {
+                            EXPECT_TRUE(resp->ok());
+                            load_finished = true;
+                          })
+                  .ok());
+  WaitUntil([&]() { return load_finished.load(); });
+
+  mutex latencies_mutex;
+  vector<int64_t> latencies_ns;
+  latencies_ns.reserve(kRequestCount);
+  atomic<size_t> finished_count = 0;
+
+  auto start = TimeProvider::GetSteadyTimestampInNanoseconds();
+  for (size_t i = 0; i < kRequestCount; i++) {
+    auto execution_obj = make_unique<InvocationRequestStrInput>();
+    execution_obj->id = "foo";
+    execution_obj->version_num = 1;
+    execution_obj->handler_name = "Handler";
+    execution_obj->input.push_back(
+        i % kSlowRequestPeriod == 0 ? "1000000" : "1000");
+    auto dispatched_at = TimeProvider::GetSteadyTimestampInNanoseconds();
+    auto status = Execute(
+        move(execution_obj),
+        [&, dispatched_at](unique_ptr<absl::StatusOr<ResponseObject>> resp) {
+          EXPECT_TRUE(resp->ok());
+          auto latency =
+              TimeProvider::GetSteadyTimestampInNanoseconds() - dispatched_at;
+          {
+            unique_lock lock(latencies_mutex);
+            latencies_ns.push_back(latency.count());
+          }
+          finished_count++;
+        });
+    EXPECT_TRUE(status.ok());
+  }
+  WaitUntil([&]() { return finished_count == kRequestCount; },
+            milliseconds(300000));
+  auto elapsed_ms = (TimeProvider::GetSteadyTimestampInNanoseconds() - start)
+                        .count() /
+                    1000000;
+
+  sort(latencies_ns.begin(), latencies_ns.end());
+  cout << (enable_worker_request_queues ? "Worker request queues"
+                                        : "Async executor")
+       << " dispatch: "
+       << kRequestCount * 1000 / std::max<int64_t>(elapsed_ms, 1)
+       << " requests/s, p50 latency "
+       << latencies_ns[latencies_ns.size() / 2] / 1000 << " us, p99 latency "
+       << latencies_ns[latencies_ns.size() * 99 / 100] / 1000 << " us" << endl;
+
+  EXPECT_TRUE(RomaStop().ok());
+}
+
+/**
+ * @brief Runs a workload where each request makes a number of calls to a
+ * function binding which takes a millisecond to complete, like a lookup in a
+ * remote store, and reports the throughput of the requests.
+ */
+static void RunParallelBindingCallsWorkload(bool use_async_binding,
+                                            size_t calls_per_request) {
+  constexpr size_t kRequestCount = 500;
+  constexpr auto kBindingCallLatency = milliseconds(1);
+
+  Config config;
+  config.number_of_workers = 4;
+  config.worker_queue_max_items = kRequestCount;
+  string code;
+  if (use_async_binding) {
+    auto function_binding_object = make_unique<AsyncFunctionBindingObjectV2>();
+    function_binding_object->function_name = "lookup";
+    function_binding_object->function =
+        [kBindingCallLatency](proto::FunctionBindingIoProto& io,
+                              std::function<void()> on_completed) {
+          thread([&io, on_completed, kBindingCallLatency]() {
+            sleep_for(kBindingCallLatency);
+            io.set_output_string(io.input_string());
+            on_completed();
+          }).detach();
+        };
+    config.RegisterFunctionBinding(move(function_binding_object));
+    code = R"JS_CODE(
+      async function Handler(calls) {
+        const lookups = [];
+        for (let i = 0; i < calls; i++) { lookups.push(lookup("key" + i)); }
+        return (await Promise.all(lookups)).length;
+      }
+    )JS_CODE";
+  } else {
+    auto function_binding_object = make_unique<FunctionBindingObjectV2>();
+    function_binding_object->function_name = "lookup";
+    function_binding_object->function =
+        [kBindingCallLatency](proto::FunctionBindingIoProto& io) {
+          sleep_for(kBindingCallLatency);
+          io.set_output_string(io.input_string());
+        };
+    config.RegisterFunctionBinding(move(function_binding_object));
+    code = R"JS_CODE(
+      function Handler(calls) {
+        const lookups = [];
+        for (let i = 0; i < calls; i++) { lookups.push(lookup("key" + i)); }
+        return lookups.length;
+      }
+    )JS_CODE";
+  }
+  ASSERT_TRUE(RomaInit(config).ok());
+
+  atomic<bool> load_finished = false;
+  auto code_obj = make_unique<CodeObject>();
+  code_obj->id = "foo";
+  code_obj->version_num = 1;
+  code_obj->js = code;
+  ASSERT_TRUE(LoadCodeObj(move(code_obj),
+                          [&](unique_ptr<absl::StatusOr<ResponseObject>> resp) {
+                            EXPECT_TRUE(resp->ok());
+                            load_finished = true;
+                          })
+                  .ok());
+  WaitUntil([&]() { return load_finished.load(); });
+
+  atomic<size_t> finished_count = 0;
+  auto start = TimeProvider::GetSteadyTimestampInNanoseconds();
+  for (size_t i = 0; i < kRequestCount; i++) {
+    auto execution_obj = make_unique<InvocationRequestStrInput>();
+    execution_obj->id = "foo";
+    execution_obj->version_num = 1;
+    execution_obj->handler_name = "Handler";
+    execution_obj->input.push_back(to_string(calls_per_request));
+    auto status =
+        Execute(move(execution_obj),
+                [&](unique_ptr<absl::StatusOr<ResponseObject>> resp) {
+                  EXPECT_TRUE(resp->ok());
+                  if (resp->ok()) {
+                    EXPECT_EQ((*resp)->resp, to_string(calls_per_request));
+                  }
+                  finished_count++;
+                });
+    EXPECT_TRUE(status.ok());
+  }
+  WaitUntil([&]() { return finished_count == kRequestCount; },
+            milliseconds(300000));
+  auto elapsed_ms = (TimeProvider::GetSteadyTimestampInNanoseconds() - start)
+                        .count() /
+                    1000000;
+
+  cout << (use_async_binding ? "Async" : "Sync") << " binding, "
+       << calls_per_request << " calls per request: "
+       << kRequestCount * 1000 / std::max<int64_t>(elapsed_ms, 1)
+       << " requests/s" << endl;
+
+  EXPECT_TRUE(RomaStop().ok());
+}
+
+TEST(SandboxedServiceBenchmarkTest, SyncBindingCalls) {
+  GTEST_SKIP();
+  for (size_t calls_per_request : {1, 4, 16}) {
+    RunParallelBindingCallsWorkload(/*use_async_binding=*/false,
+                                    calls_per_request);
+  }
+}
+
+TEST(SandboxedServiceBenchmarkTest, AsyncBindingCalls) {
+  GTEST_SKIP();
+  for (size_t calls_per_request : {1, 4, 16}) {
+    RunParallelBindingCallsWorkload(/*use_async_binding=*/true,
+                                    calls_per_request);
+  }
+}
+
+TEST(SandboxedServiceBenchmarkTest, AsyncExecutorDispatch) {
+  GTEST_SKIP();
+  RunMixedDurationWorkload(/*enable_worker_request_queues=*/false);
+}
+
+TEST(SandboxedServiceBenchmarkTest, WorkerRequestQueuesDispatch) {
+  GTEST_SKIP();
+  RunMixedDurationWorkload(/*enable_worker_request_queues=*/true);
+}
+}  // namespace google::scp::roma::test
@@ -724,6 +724,76 @@ TEST(SandboxedServiceTest,
   EXPECT_TRUE(status.ok());
 }
 
+void AsyncStringInStringOutFunction(proto::FunctionBindingIoProto& io,
+                                    std::function<void()> on_completed) {
+  // Completes the call from another thread, as an asynchronous client would.
+  thread([&io, on_completed]() {
+    io.set_output_string(io.input_string() + " String from C++");
+    on_completed();
+  }).detach();
+}
+
+TEST(SandboxedServiceTest, CanRegisterAsyncBindingAndExecuteCodeThatAwaitsIt) {
+  Config config;
+  config.number_of_workers = 2;
+  auto function_binding_object = make_unique<AsyncFunctionBindingObjectV2>();
+  function_binding_object->function = AsyncStringInStringOutFunction;
+  function_binding_object->function_name = "cool_function";
+  config.RegisterFunctionBinding(move(function_binding_object));
+
+  auto status = RomaInit(config);
+  EXPECT_TRUE(status.ok());
+
+  string result;
+  atomic<bool> load_finished = false;
+  atomic<bool> execute_finished = false;
+
+  {
+    auto code_obj = make_unique<CodeObject>();
+    code_obj->id = "foo";
+    code_obj->version_num = 1;
+    code_obj->js = R"JS_CODE(
+    async function Handler(input) {
+      const outputs = await Promise.all(
+          [cool_function(input), cool_function(input)]);
+      return outputs.join(" and ");
+    }
+    )JS_CODE";
+
+    status = LoadCodeObj(move(code_obj),
+                         [&](unique_ptr<absl::StatusOr<ResponseObject>> resp) {
+                           EXPECT_TRUE(resp->ok());
+                           load_finished.store(true);
+                         });
+    EXPECT_TRUE(status.ok());
+  }
+
+  {
+    auto execution_obj = make_unique<InvocationRequestStrInput>();
+    execution_obj->id = "foo";
+    execution_obj->version_num = 1;
+    execution_obj->handler_name = "Handler";
+    execution_obj->input.push_back("\"Foobar\"");
+
+    status = Execute(move(execution_obj),
+                     [&](unique_ptr<absl::StatusOr<ResponseObject>> resp) {
+                       EXPECT_TRUE(resp->ok());
+                       if (resp->ok()) {
+                         auto& code_resp = **resp;
+                         result = code_resp.resp;
+                       }
+                       execute_finished.store(true);
+                     });
+    EXPECT_TRUE(status.ok());
+  }
+  WaitUntil([&]() { return load_finished.load(); }, 10s);
+  WaitUntil([&]() { return execute_finished.load(); }, 10s);
+  EXPECT_EQ(result, R"("Foobar String from C++ and Foobar String from C++")");
+
+  status = RomaStop();
+  EXPECT_TRUE(status.ok());
+}
+
 void StringInStringOutFunctionWithRequestIdCheck(
     proto::FunctionBindingIoProto& io) {
   // Should be able to read the request ID
@@ -1477,6 +1547,18 @@ TEST(SandboxedServiceTest, ShouldGetMetricsInResponse) {
               << "\n roma.metric.code_run_ns:"
               << resp->value().metrics["roma.metric.code_run_ns"] << std::endl;
 
+          for (auto metric : {"roma.metric.dispatch_queueing_ns",
+                              "roma.metric.sandbox_ipc_ns",
+                              "roma.metric.context_setup_ns",
+                              "roma.metric.input_parsing_ns",
+                              "roma.metric.handler_execution_ns",
+                              "roma.metric.output_serialization_ns",
+                              "roma.metric.js_heap_used_bytes",
+                              "roma.metric.binding_call_count",
+                              "roma.metric.binding_wall_ns"}) {
+            EXPECT_TRUE(resp->value().metrics.contains(metric)) << metric;
+          }
+
           execute_finished.store(true);
         });
     EXPECT_TRUE(status.ok());
@@ -1485,6 +1567,14 @@ TEST(SandboxedServiceTest, ShouldGetMetricsInResponse) {
   WaitUntil([&]() { return execute_finished.load(); }, 10s);
   EXPECT_EQ(result, R"("Hello world! \"Foobar\"")");
 
+  // The metrics of the execution are aggregated, but not those of the load.
+  auto metrics_or = ScrapeMetrics();
+  ASSERT_TRUE(metrics_or.ok());
+  EXPECT_NE(metrics_or->find("# TYPE roma_metric_handler_execution_ns"),
+            string::npos);
+  EXPECT_NE(metrics_or->find("roma_metric_code_run_ns_count 1\n"),
+            string::npos);
+
   status = RomaStop();
   EXPECT_TRUE(status.ok());
 }
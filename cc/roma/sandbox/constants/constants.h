@@ -31,9 +31,6 @@ static constexpr char kRequestActionExecute[] = "Execute";
 static constexpr char kJsEngineOneTimeSetupWasmPagesKey[] =
     "MaxWasmNumberOfPages";
 
-static constexpr char kFuctionBindingMetadataFunctionName[] =
-    "roma.js_function_binding_name";
-
 static constexpr char kMetadataRomaRequestId[] = "roma.request.id";
 
 static constexpr int kCodeVersionCacheSize = 5;
@@ -51,6 +48,50 @@ static constexpr char kExecutionMetricSandboxedJsEngineCallNs[] =
 // overhead for serializing data. In nanoseconds.
 static constexpr char kExecutionMetricJsEngineCallNs[] =
     "roma.metric.code_run_ns";
+// Label for the number of requests queued or running on the worker when the
+// request was assigned to it.
+static constexpr char kExecutionMetricWorkerQueueDepth[] =
+    "roma.metric.worker_queue_depth";
+// Label for the moving average of the time the worker takes to run a request,
+// including this one. In nanoseconds.
+static constexpr char kExecutionMetricWorkerAverageExecutionNs[] =
+    "roma.metric.worker_average_execution_ns";
+// Label for the time the request waited to be picked up after it was
+// dispatched, in the async executor or the worker request queue. In
+// nanoseconds.
+static constexpr char kExecutionMetricDispatchQueueingNs[] =
+    "roma.metric.dispatch_queueing_ns";
+// Label for the time taken to pass the request into the sandbox and the
+// response out of it, which is the sandboxed run time less the run time inside
+// of the sandbox. In nanoseconds.
+static constexpr char kExecutionMetricSandboxIpcNs[] =
+    "roma.metric.sandbox_ipc_ns";
+// Label for the time taken to get a JS context ready to run the handler in. In
+// nanoseconds.
+static constexpr char kExecutionMetricContextSetupNs[] =
+    "roma.metric.context_setup_ns";
+// Label for the time taken to turn the input into JS arguments. In
+// nanoseconds.
+static constexpr char kExecutionMetricInputParsingNs[] =
+    "roma.metric.input_parsing_ns";
+// Label for the time taken to run the handler, including settling the promise
+// it returned. In nanoseconds.
+static constexpr char kExecutionMetricHandlerExecutionNs[] =
+    "roma.metric.handler_execution_ns";
+// Label for the time taken to turn the handler result into the response. In
+// nanoseconds.
+static constexpr char kExecutionMetricOutputSerializationNs[] =
+    "roma.metric.output_serialization_ns";
+// Label for the size of the JS heap in use once the handler ran. In bytes.
+static constexpr char kExecutionMetricJsHeapUsedBytes[] =
+    "roma.metric.js_heap_used_bytes";
+// Label for the number of native function binding calls the handler made.
+static constexpr char kExecutionMetricBindingCallCount[] =
+    "roma.metric.binding_call_count";
+// Label for the time the handler was blocked on native function binding calls.
+// In nanoseconds.
+static constexpr char kExecutionMetricBindingWallNs[] =
+    "roma.metric.binding_wall_ns";
 
 static constexpr char kDefaultRomaRequestId[] = "roma.defaults.request.id";
 }  // namespace google::scp::roma::sandbox::constants
@@ -42,14 +42,26 @@ using std::this_thread::sleep_for;
 
 namespace google::scp::roma::sandbox::dispatcher {
 ExecutionResult Dispatcher::Init() noexcept {
+  if (dispatch_mode_ == DispatchMode::WorkerRequestQueues) {
+    worker_request_queue_ =
+        make_unique<WorkerRequestQueue>(worker_pool_->GetPoolSize());
+    return worker_request_queue_->Init();
+  }
   return SuccessExecutionResult();
 }
 
 ExecutionResult Dispatcher::Run() noexcept {
+  if (worker_request_queue_) {
+    return worker_request_queue_->Run();
+  }
   return SuccessExecutionResult();
 }
 
 ExecutionResult Dispatcher::Stop() noexcept {
+  // The queued requests are run while the workers are still up.
+  if (worker_request_queue_) {
+    return worker_request_queue_->Stop();
+  }
   return SuccessExecutionResult();
 }
 
@@ -102,17 +114,14 @@ ExecutionResult Dispatcher::ReloadCachedCodeObjects(
 
   for (auto& kv : all_cached_code_objects) {
     auto& cached_code = kv.second;
-    unique_ptr<CodeObject> ptr_cached_code;
-    ptr_cached_code.reset(&cached_code);
 
     auto run_code_request_or =
         request_converter::RequestConverter<CodeObject>::FromUserProvided(
-            ptr_cached_code, ptr_cached_code->js.empty()
-                                 ? constants::kRequestTypeWasm
-                                 : constants::kRequestTypeJavascript);
+            cached_code, cached_code->js.empty()
+                             ? constants::kRequestTypeWasm
+                             : constants::kRequestTypeJavascript);
 
     if (!run_code_request_or.result().Successful()) {
-      ptr_cached_code.release();
       pending_requests_ -= all_cached_code_objects.size();
       return run_code_request_or.result();
     }
@@ -121,12 +130,9 @@ ExecutionResult Dispatcher::ReloadCachedCodeObjects(
     auto run_code_result_or = worker->RunCode(*run_code_request_or);
     if (!run_code_result_or.result().Successful()) {
       _ROMA_LOG_ERROR("Reloading the code object failed.");
-      ptr_cached_code.release();
       pending_requests_ -= all_cached_code_objects.size();
       return run_code_result_or.result();
     }
-
-    ptr_cached_code.release();
   }
 
   pending_requests_ -= all_cached_code_objects.size();
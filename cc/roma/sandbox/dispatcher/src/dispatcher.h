@@ -18,6 +18,7 @@
 
 #include <atomic>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -26,30 +27,52 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "core/async_executor/src/async_executor.h"
-#include "core/common/lru_cache/src/lru_cache.h"
+#include "core/common/lru_cache/src/sharded_lru_cache.h"
+#include "core/common/time_provider/src/stopwatch.h"
+#include "core/common/time_provider/src/time_provider.h"
 #include "core/interface/service_interface.h"
 #include "public/core/interface/execution_result.h"
+#include "roma/config/src/config.h"
 #include "roma/interface/roma.h"
 #include "roma/sandbox/logging/src/logging.h"
 #include "roma/sandbox/worker_api/src/worker_api.h"
 #include "roma/sandbox/worker_pool/src/worker_pool.h"
 
 #include "error_codes.h"
+#include "metric_histograms.h"
 #include "request_converter.h"
 #include "request_validator.h"
+#include "worker_request_queue.h"
+#include "worker_selector.h"
 
 namespace google::scp::roma::sandbox::dispatcher {
+/// How the dispatcher runs the requests on the workers.
+enum class DispatchMode {
+  /// Each request runs on a thread of the async executor, which is blocked
+  /// for as long as the worker executes the request.
+  AsyncExecutor = 0,
+  /// The requests are queued for the workers, and each worker takes the next
+  /// request once it completes one. No executor thread waits on the workers,
+  /// but each worker has a thread of its own blocked while a request runs.
+  WorkerRequestQueues = 1,
+};
+
 class Dispatcher : public core::ServiceInterface {
  public:
   Dispatcher(std::shared_ptr<core::AsyncExecutor>& async_executor,
              std::shared_ptr<worker_pool::WorkerPool>& worker_pool,
-             size_t max_pending_requests, size_t code_version_cache_size)
+             size_t max_pending_requests, size_t code_version_cache_size,
+             DispatchMode dispatch_mode = DispatchMode::AsyncExecutor,
+             WorkerSelectionPolicy worker_selection_policy =
+                 WorkerSelectionPolicy::LeastOutstanding)
       : async_executor_(async_executor),
         worker_pool_(worker_pool),
-        worker_index_(0),
         pending_requests_(0),
         max_pending_requests_(max_pending_requests),
-        code_object_cache_(code_version_cache_size) {
+        code_object_cache_(code_version_cache_size),
+        dispatch_mode_(dispatch_mode),
+        worker_selection_policy_(worker_selection_policy),
+        worker_selector_(worker_pool->GetPoolSize(), worker_selection_policy) {
     if (max_pending_requests == 0) {
       auto message = std::string(__FILE__) + ":" + std::to_string(__LINE__) +
                      ":max_pending_requests cannot be zero.";
@@ -141,6 +164,16 @@ class Dispatcher : public core::ServiceInterface {
   core::ExecutionResult Broadcast(std::unique_ptr<CodeObject> code_object,
                                   Callback broadcast_callback) noexcept;
 
+  /**
+   * @brief Get the histograms of the metrics of the invocation requests that
+   * completed successfully.
+   *
+   * @return MetricHistograms& The histograms, which can be scraped.
+   */
+  MetricHistograms& GetMetricHistograms() noexcept {
+    return metric_histograms_;
+  }
+
  private:
   /**
    * @brief The internal dispatch function which puts a request into a worker
@@ -172,16 +205,7 @@ class Dispatcher : public core::ServiceInterface {
       return validation_result;
     }
 
-    size_t index = 0;
-
-    if (worker_index != -1) {
-      index = worker_index;
-    } else {
-      auto num_workers = worker_pool_->GetPoolSize();
-      index = worker_index_.fetch_add(1) % num_workers;
-      worker_index_ = worker_index_.load() % num_workers;
-    }
-
+    auto version_num = request->version_num;
     if constexpr (std::is_same<RequestT, CodeObject>::value) {
       code_object_cache_.Set(request->version_num, *request);
     }
@@ -191,89 +215,152 @@ class Dispatcher : public core::ServiceInterface {
     auto shared_request =
         std::make_shared<std::unique_ptr<RequestT>>(std::move(request));
 
-    auto schedule_result = async_executor_->Schedule(
-        [this, index, shared_request, callback] {
-          auto request = std::move(*shared_request);
-          std::unique_ptr<absl::StatusOr<ResponseObject>> response_or;
-
-          auto worker_or = worker_pool_->GetWorker(index);
-          if (!worker_or.result().Successful()) {
-            response_or = std::make_unique<absl::StatusOr<ResponseObject>>(
-                absl::Status(absl::StatusCode::kInternal,
-                             core::errors::GetErrorMessage(
-                                 worker_or.result().status_code)));
-            callback(::std::move(response_or));
-            pending_requests_--;
-            return;
-          }
+    // Runs the request on the worker it was assigned to, queue_depth being
+    // the number of requests outstanding on the worker ahead of it.
+    auto dispatched_at =
+        core::common::TimeProvider::GetSteadyTimestampInNanoseconds();
+    auto run = [this, shared_request, callback, dispatched_at](
+                   size_t index, size_t queue_depth) {
+      auto queueing_ns =
+          core::common::TimeProvider::GetSteadyTimestampInNanoseconds() -
+          dispatched_at;
+      auto request = std::move(*shared_request);
+      std::unique_ptr<absl::StatusOr<ResponseObject>> response_or;
+
+      auto worker_or = worker_pool_->GetWorker(index);
+      if (!worker_or.result().Successful()) {
+        response_or = std::make_unique<absl::StatusOr<ResponseObject>>(
+            absl::Status(absl::StatusCode::kInternal,
+                         core::errors::GetErrorMessage(
+                             worker_or.result().status_code)));
+        worker_selector_.OnRequestCompleted(index, -1);
+        callback(::std::move(response_or));
+        pending_requests_--;
+        return;
+      }
 
-          if (!code_object_cache_.Contains(request->version_num)) {
-            response_or = std::make_unique<absl::StatusOr<ResponseObject>>(
-                absl::Status(absl::StatusCode::kInternal,
-                             "Could not find code version in cache."));
-            callback(::std::move(response_or));
-            pending_requests_--;
-            return;
-          }
+      auto cached_code_object = code_object_cache_.Get(request->version_num);
+      if (!cached_code_object) {
+        response_or = std::make_unique<absl::StatusOr<ResponseObject>>(
+            absl::Status(absl::StatusCode::kInternal,
+                         "Could not find code version in cache."));
+        worker_selector_.OnRequestCompleted(index, -1);
+        callback(::std::move(response_or));
+        pending_requests_--;
+        return;
+      }
 
-          auto request_type =
-              code_object_cache_.Get(request->version_num).js.empty()
-                  ? constants::kRequestTypeWasm
-                  : constants::kRequestTypeJavascript;
-
-          auto run_code_request_or =
-              request_converter::RequestConverter<RequestT>::FromUserProvided(
-                  request, request_type);
-          if (!run_code_request_or.result().Successful()) {
-            response_or = std::make_unique<absl::StatusOr<ResponseObject>>(
-                absl::Status(absl::StatusCode::kInternal,
-                             core::errors::GetErrorMessage(
-                                 run_code_request_or.result().status_code)));
-            callback(::std::move(response_or));
-            pending_requests_--;
-            return;
+      auto request_type = cached_code_object->js.empty()
+                              ? constants::kRequestTypeWasm
+                              : constants::kRequestTypeJavascript;
+
+      auto run_code_request_or =
+          request_converter::RequestConverter<RequestT>::FromUserProvided(
+              request, request_type);
+      if (!run_code_request_or.result().Successful()) {
+        response_or = std::make_unique<absl::StatusOr<ResponseObject>>(
+            absl::Status(absl::StatusCode::kInternal,
+                         core::errors::GetErrorMessage(
+                             run_code_request_or.result().status_code)));
+        worker_selector_.OnRequestCompleted(index, -1);
+        callback(::std::move(response_or));
+        pending_requests_--;
+        return;
+      }
+
+      core::common::Stopwatch stopwatch;
+      stopwatch.Start();
+      auto run_code_response_or = (*worker_or)->RunCode(*run_code_request_or);
+      worker_selector_.OnRequestCompleted(index, stopwatch.Stop().count());
+      if (!run_code_response_or.result().Successful()) {
+        response_or = std::make_unique<absl::StatusOr<ResponseObject>>(
+            absl::Status(absl::StatusCode::kInternal,
+                         core::errors::GetErrorMessage(
+                             run_code_response_or.result().status_code)));
+
+        if (run_code_response_or.result().Retryable()) {
+          // This means that the worker crashed and the request could be
+          // retried, however, we need to reload the worker with the cached
+          // code.
+          auto reload_result = ReloadCachedCodeObjects(*worker_or);
+          if (!reload_result.Successful()) {
+            _ROMA_LOG_ERROR(
+                "The worker crashed and was restarted but reloading the "
+                "worker cache failed.");
           }
+        }
 
-          auto run_code_response_or =
-              (*worker_or)->RunCode(*run_code_request_or);
-          if (!run_code_response_or.result().Successful()) {
-            response_or = std::make_unique<absl::StatusOr<ResponseObject>>(
-                absl::Status(absl::StatusCode::kInternal,
-                             core::errors::GetErrorMessage(
-                                 run_code_response_or.result().status_code)));
-
-            if (run_code_response_or.result().Retryable()) {
-              // This means that the worker crashed and the request could be
-              // retried, however, we need to reload the worker with the cached
-              // code.
-              auto reload_result = ReloadCachedCodeObjects(*worker_or);
-              if (!reload_result.Successful()) {
-                _ROMA_LOG_ERROR(
-                    "The worker crashed and was restarted but reloading the "
-                    "worker cache failed.");
-              }
-            }
+        callback(::std::move(response_or));
+        pending_requests_--;
+        return;
+      }
 
-            callback(::std::move(response_or));
-            pending_requests_--;
-            return;
-          }
+      ResponseObject response_object;
+      response_or =
+          std::make_unique<absl::StatusOr<ResponseObject>>(response_object);
+      response_or->value().id = request->id;
+      response_or->value().resp = move(*run_code_response_or->response);
+      // The worker produced the response in the format the request asked for.
+      auto io_format = request->tags.find(kIoFormatTag);
+      if (io_format != request->tags.end()) {
+        response_or->value().io_format = io_format->second;
+      }
+      for (auto& kv : run_code_response_or->metrics) {
+        response_or->value().metrics[kv.first] = kv.second;
+      }
+      response_or->value()
+          .metrics[constants::kExecutionMetricWorkerQueueDepth] = queue_depth;
+      response_or->value()
+          .metrics[constants::kExecutionMetricWorkerAverageExecutionNs] =
+          worker_selector_.GetAverageExecutionTimeNs(index);
+      response_or->value()
+          .metrics[constants::kExecutionMetricDispatchQueueingNs] =
+          queueing_ns.count();
+      // Only the invocations are aggregated, not the code loads.
+      if constexpr (!std::is_same<RequestT, CodeObject>::value) {
+        metric_histograms_.RecordAll(response_or->value().metrics);
+      }
+      callback(::std::move(response_or));
+      pending_requests_--;
+    };
+
+    // Counted ahead of scheduling, as the request might complete right away.
+    pending_requests_++;
+    core::ExecutionResult schedule_result;
+    std::optional<size_t> index;
+    if (worker_index != -1) {
+      index = worker_index;
+    } else if (dispatch_mode_ == DispatchMode::AsyncExecutor ||
+               worker_selection_policy_ ==
+                   WorkerSelectionPolicy::CodeVersionAffinity) {
+      index = worker_selector_.SelectWorker(version_num);
+    }
 
-          ResponseObject response_object;
-          response_or =
-              std::make_unique<absl::StatusOr<ResponseObject>>(response_object);
-          response_or->value().id = request->id;
-          response_or->value().resp = move(*run_code_response_or->response);
-          for (auto& kv : run_code_response_or->metrics) {
-            response_or->value().metrics[kv.first] = kv.second;
-          }
-          callback(::std::move(response_or));
-          pending_requests_--;
-        },
-        core::AsyncPriority::Normal);
+    if (!index) {
+      // The request is taken by the first idle worker, which is the least
+      // loaded one.
+      schedule_result = worker_request_queue_->Enqueue(
+          [this, run](size_t index) {
+            run(index, worker_selector_.OnRequestAssigned(index));
+          });
+    } else {
+      auto queue_depth = worker_selector_.OnRequestAssigned(*index);
+      if (dispatch_mode_ == DispatchMode::WorkerRequestQueues) {
+        schedule_result = worker_request_queue_->Enqueue(
+            [run, queue_depth](size_t index) { run(index, queue_depth); },
+            index);
+      } else {
+        schedule_result = async_executor_->Schedule(
+            [run, index = *index, queue_depth] { run(index, queue_depth); },
+            core::AsyncPriority::Normal);
+      }
+      if (!schedule_result.Successful()) {
+        worker_selector_.OnRequestCompleted(*index, -1);
+      }
+    }
 
-    if (schedule_result.Successful()) {
-      pending_requests_++;
+    if (!schedule_result.Successful()) {
+      pending_requests_--;
     }
 
     return schedule_result;
@@ -284,9 +371,17 @@ class Dispatcher : public core::ServiceInterface {
 
   std::shared_ptr<core::AsyncExecutor> async_executor_;
   std::shared_ptr<worker_pool::WorkerPool> worker_pool_;
-  std::atomic<size_t> worker_index_;
   std::atomic<size_t> pending_requests_;
   const size_t max_pending_requests_;
-  core::common::LruCache<uint64_t, CodeObject> code_object_cache_;
+  /// Read on every request, so lookups are sharded and do not copy the code.
+  core::common::ShardedLruCache<uint64_t, CodeObject> code_object_cache_;
+  const DispatchMode dispatch_mode_;
+  /// Queues the requests for the workers in the worker request queues mode.
+  std::unique_ptr<WorkerRequestQueue> worker_request_queue_;
+  const WorkerSelectionPolicy worker_selection_policy_;
+  /// Chooses the workers of the requests and tracks their load.
+  WorkerSelector worker_selector_;
+  /// Aggregates the metrics of the requests.
+  MetricHistograms metric_histograms_;
 };
 }  // namespace google::scp::roma::sandbox::dispatcher
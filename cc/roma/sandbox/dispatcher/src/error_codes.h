@@ -32,4 +32,10 @@ DEFINE_ERROR_CODE(SC_ROMA_DISPATCHER_DISPATCH_DISALLOWED_DUE_TO_CAPACITY,
                   "Dispatch is disallowed since the number of unfinished "
                   "requests is at capacity.",
                   HttpStatusCode::BAD_REQUEST)
+
+DEFINE_ERROR_CODE(SC_ROMA_DISPATCHER_WORKER_QUEUE_NOT_RUNNING,
+                  SC_ROMA_DISPATCHER, 0x0003,
+                  "The requests cannot be queued for the workers since the "
+                  "queue is not running.",
+                  HttpStatusCode::SERVICE_UNAVAILABLE)
 }  // namespace google::scp::core::errors
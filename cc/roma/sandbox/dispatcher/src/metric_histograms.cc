@@ -0,0 +1,130 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "metric_histograms.h"
+
+#include <cctype>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+
+using std::lock_guard;
+using std::make_unique;
+using std::memory_order_relaxed;
+using std::mutex;
+using std::numeric_limits;
+using std::string;
+using std::to_string;
+
+namespace {
+/// Replaces the characters that are not allowed in Prometheus metric names.
+string ToPrometheusName(const string& name) {
+  string prometheus_name = name;
+  for (auto& c : prometheus_name) {
+    if (!isalnum(static_cast<unsigned char>(c)) && c != '_') {
+      c = '_';
+    }
+  }
+  return prometheus_name;
+}
+}  // namespace
+
+namespace google::scp::roma::sandbox::dispatcher {
+size_t MetricHistograms::GetBucketIndex(int64_t value) noexcept {
+  if (value <= 0) {
+    return 0;
+  }
+  return 64 - __builtin_clzll(static_cast<uint64_t>(value));
+}
+
+int64_t MetricHistograms::GetBucketUpperBound(size_t bucket_index) noexcept {
+  if (bucket_index >= kMetricHistogramBucketCount - 1) {
+    return numeric_limits<int64_t>::max();
+  }
+  return (int64_t{1} << bucket_index) - 1;
+}
+
+MetricHistograms::Histogram& MetricHistograms::GetHistogram(
+    const string& name) noexcept {
+  lock_guard<mutex> lock(histograms_mutex_);
+  auto& histogram = histograms_[name];
+  if (!histogram) {
+    histogram = make_unique<Histogram>();
+  }
+  return *histogram;
+}
+
+void MetricHistograms::Record(const string& name, int64_t value) noexcept {
+  auto& histogram = GetHistogram(name);
+  histogram.bucket_counts[GetBucketIndex(value)].fetch_add(
+      1, memory_order_relaxed);
+  histogram.sum.fetch_add(value, memory_order_relaxed);
+  histogram.count.fetch_add(1, memory_order_relaxed);
+}
+
+MetricHistogramSnapshot MetricHistograms::GetSnapshot(
+    const string& name) noexcept {
+  MetricHistogramSnapshot snapshot;
+  lock_guard<mutex> lock(histograms_mutex_);
+  auto histogram = histograms_.find(name);
+  if (histogram == histograms_.end()) {
+    return snapshot;
+  }
+
+  snapshot.count = histogram->second->count.load(memory_order_relaxed);
+  snapshot.sum = histogram->second->sum.load(memory_order_relaxed);
+  for (size_t i = 0; i < kMetricHistogramBucketCount; i++) {
+    snapshot.bucket_counts[i] =
+        histogram->second->bucket_counts[i].load(memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+string MetricHistograms::ToPrometheusText() noexcept {
+  string text;
+  lock_guard<mutex> lock(histograms_mutex_);
+  for (auto& [name, histogram] : histograms_) {
+    auto prometheus_name = ToPrometheusName(name);
+    text += "# TYPE " + prometheus_name + " histogram\n";
+
+    // The buckets are cumulative, and the ones above the largest value
+    // recorded are left out as they all equal the count. The count is taken
+    // from the buckets, so that it agrees with them while values are recorded.
+    uint64_t bucket_counts[kMetricHistogramBucketCount];
+    size_t last_bucket = 0;
+    for (size_t i = 0; i < kMetricHistogramBucketCount; i++) {
+      bucket_counts[i] = histogram->bucket_counts[i].load(memory_order_relaxed);
+      if (bucket_counts[i] > 0) {
+        last_bucket = i;
+      }
+    }
+    uint64_t count = 0;
+    for (size_t i = 0; i <= last_bucket; i++) {
+      count += bucket_counts[i];
+      text += prometheus_name + "_bucket{le=\"" +
+              to_string(GetBucketUpperBound(i)) + "\"} " + to_string(count) +
+              "\n";
+    }
+
+    text += prometheus_name + "_bucket{le=\"+Inf\"} " + to_string(count) + "\n";
+    text += prometheus_name + "_sum " +
+            to_string(histogram->sum.load(memory_order_relaxed)) + "\n";
+    text += prometheus_name + "_count " + to_string(count) + "\n";
+  }
+  return text;
+}
+}  // namespace google::scp::roma::sandbox::dispatcher
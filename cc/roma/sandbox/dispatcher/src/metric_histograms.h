@@ -0,0 +1,101 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace google::scp::roma::sandbox::dispatcher {
+/// The number of buckets of a histogram. Bucket 0 counts the values up to 0,
+/// and bucket N the values in [2^(N-1), 2^N).
+static constexpr size_t kMetricHistogramBucketCount = 64;
+
+/// The values recorded in a histogram.
+struct MetricHistogramSnapshot {
+  uint64_t count = 0;
+  int64_t sum = 0;
+  std::vector<uint64_t> bucket_counts =
+      std::vector<uint64_t>(kMetricHistogramBucketCount, 0);
+};
+
+/**
+ * @brief Aggregates the execution metrics of the requests into histograms
+ * with power of two buckets, one per metric, which can be scraped as text.
+ * Recording is thread safe.
+ */
+class MetricHistograms {
+ public:
+  /**
+   * @brief Records a value in the histogram of the metric.
+   *
+   * @param name The name of the metric.
+   * @param value The value to record.
+   */
+  void Record(const std::string& name, int64_t value) noexcept;
+
+  /**
+   * @brief Records each of the metrics in its histogram.
+   *
+   * @tparam MetricsT The map type of the metrics.
+   * @param metrics The metrics by name.
+   */
+  template <typename MetricsT>
+  void RecordAll(const MetricsT& metrics) noexcept {
+    for (const auto& [name, value] : metrics) {
+      Record(name, value);
+    }
+  }
+
+  /// Gets the values recorded for the metric, empty if there are none.
+  MetricHistogramSnapshot GetSnapshot(const std::string& name) noexcept;
+
+  /**
+   * @brief Exports the histograms in the Prometheus text format. The names of
+   * the metrics have the characters not allowed by the format replaced with
+   * underscores.
+   *
+   * @return std::string The exported histograms.
+   */
+  std::string ToPrometheusText() noexcept;
+
+  /// Gets the index of the bucket the value is counted in.
+  static size_t GetBucketIndex(int64_t value) noexcept;
+
+  /// Gets the largest value counted in the bucket.
+  static int64_t GetBucketUpperBound(size_t bucket_index) noexcept;
+
+ private:
+  struct Histogram {
+    std::atomic<uint64_t> count{0};
+    std::atomic<int64_t> sum{0};
+    std::atomic<uint64_t> bucket_counts[kMetricHistogramBucketCount] = {};
+  };
+
+  /// Gets the histogram of the metric, creating it if needed.
+  Histogram& GetHistogram(const std::string& name) noexcept;
+
+  /// Guards the map, the histograms themselves are updated without it.
+  std::mutex histograms_mutex_;
+  /// The histograms by metric name, ordered for the export.
+  std::map<std::string, std::unique_ptr<Histogram>> histograms_;
+};
+}  // namespace google::scp::roma::sandbox::dispatcher
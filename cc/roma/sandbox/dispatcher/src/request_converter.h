@@ -120,12 +120,15 @@ struct RequestConverter<InvocationRequestSharedInput> {
  */
 template <>
 struct RequestConverter<CodeObject> {
+  /// CodeObjectPtrT is a unique_ptr to a request, or a shared_ptr to a cached
+  /// code object.
+  template <typename CodeObjectPtrT>
   static core::ExecutionResultOr<worker_api::WorkerApi::RunCodeRequest>
-  FromUserProvided(const std::unique_ptr<CodeObject>& request,
+  FromUserProvided(const CodeObjectPtrT& request,
                    const std::string& request_type) {
     worker_api::WorkerApi::RunCodeRequest run_code_request;
-    RunRequestFromInputRequestCommon<std::unique_ptr<CodeObject>>(
-        run_code_request, request);
+    RunRequestFromInputRequestCommon<CodeObjectPtrT>(run_code_request,
+                                                     request);
     run_code_request
         .metadata[google::scp::roma::sandbox::constants::kRequestAction] =
         google::scp::roma::sandbox::constants::kRequestActionLoad;
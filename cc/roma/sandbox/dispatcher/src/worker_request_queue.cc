@@ -0,0 +1,136 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "worker_request_queue.h"
+
+#include <optional>
+#include <utility>
+
+#include "error_codes.h"
+
+using google::scp::core::ExecutionResult;
+using google::scp::core::FailureExecutionResult;
+using google::scp::core::SuccessExecutionResult;
+using google::scp::core::errors::SC_ROMA_DISPATCHER_WORKER_QUEUE_NOT_RUNNING;
+using std::deque;
+using std::move;
+using std::mutex;
+using std::optional;
+using std::thread;
+using std::unique_lock;
+
+namespace google::scp::roma::sandbox::dispatcher {
+WorkerRequestQueue::WorkerRequestQueue(size_t worker_count)
+    : worker_count_(worker_count),
+      worker_requests_(worker_count),
+      is_running_(false) {}
+
+WorkerRequestQueue::~WorkerRequestQueue() {
+  Stop();
+}
+
+ExecutionResult WorkerRequestQueue::Init() noexcept {
+  return SuccessExecutionResult();
+}
+
+ExecutionResult WorkerRequestQueue::Run() noexcept {
+  {
+    unique_lock<mutex> lock(mutex_);
+    is_running_ = true;
+  }
+  for (size_t worker_index = 0; worker_index < worker_count_; worker_index++) {
+    threads_.emplace_back([this, worker_index]() { RunWorker(worker_index); });
+  }
+  return SuccessExecutionResult();
+}
+
+ExecutionResult WorkerRequestQueue::Stop() noexcept {
+  {
+    unique_lock<mutex> lock(mutex_);
+    is_running_ = false;
+  }
+  condition_.notify_all();
+  for (auto& worker_thread : threads_) {
+    if (worker_thread.joinable()) {
+      worker_thread.join();
+    }
+  }
+  threads_.clear();
+  return SuccessExecutionResult();
+}
+
+ExecutionResult WorkerRequestQueue::Enqueue(
+    Work work, optional<size_t> worker_index) noexcept {
+  {
+    unique_lock<mutex> lock(mutex_);
+    if (!is_running_) {
+      return FailureExecutionResult(
+          SC_ROMA_DISPATCHER_WORKER_QUEUE_NOT_RUNNING);
+    }
+    if (worker_index) {
+      worker_requests_.at(*worker_index).push_back(move(work));
+    } else {
+      shared_requests_.push_back(move(work));
+    }
+  }
+  // A request addressed to a worker has to wake that worker up in particular.
+  if (worker_index) {
+    condition_.notify_all();
+  } else {
+    condition_.notify_one();
+  }
+  return SuccessExecutionResult();
+}
+
+size_t WorkerRequestQueue::GetPendingCount() noexcept {
+  unique_lock<mutex> lock(mutex_);
+  auto pending_count = shared_requests_.size();
+  for (const auto& requests : worker_requests_) {
+    pending_count += requests.size();
+  }
+  return pending_count;
+}
+
+bool WorkerRequestQueue::TryTakeWork(size_t worker_index,
+                                     Work& work) noexcept {
+  for (auto* requests :
+       {&worker_requests_[worker_index], &shared_requests_}) {
+    if (!requests->empty()) {
+      work = move(requests->front());
+      requests->pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkerRequestQueue::RunWorker(size_t worker_index) noexcept {
+  while (true) {
+    Work work;
+    {
+      unique_lock<mutex> lock(mutex_);
+      condition_.wait(lock, [&]() {
+        return TryTakeWork(worker_index, work) || !is_running_;
+      });
+      // The queued requests are run before stopping.
+      if (!work) {
+        return;
+      }
+    }
+    work(worker_index);
+  }
+}
+}  // namespace google::scp::roma::sandbox::dispatcher
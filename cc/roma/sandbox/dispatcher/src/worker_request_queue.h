@@ -0,0 +1,93 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "core/interface/service_interface.h"
+#include "public/core/interface/execution_result.h"
+
+namespace google::scp::roma::sandbox::dispatcher {
+/**
+ * @brief Queues the requests of the workers. Each worker is driven by a thread
+ * of its own, which takes the next request as soon as the worker completes the
+ * previous one: first the requests addressed to the worker, then the ones any
+ * worker can run. An idle worker thus never waits while requests are queued
+ * behind a busy one. The thread is blocked while the worker runs a request, as
+ * running code in the sandbox is a synchronous call.
+ */
+class WorkerRequestQueue : public core::ServiceInterface {
+ public:
+  /// A request of the queue, run with the index of the worker taking it.
+  using Work = std::function<void(size_t worker_index)>;
+
+  /**
+   * @brief Construct a new Worker Request Queue object
+   *
+   * @param worker_count The number of workers, and of threads driving them.
+   */
+  explicit WorkerRequestQueue(size_t worker_count);
+
+  ~WorkerRequestQueue();
+
+  core::ExecutionResult Init() noexcept override;
+
+  core::ExecutionResult Run() noexcept override;
+
+  /**
+   * @brief Stops the queue once the queued requests are run.
+   */
+  core::ExecutionResult Stop() noexcept override;
+
+  /**
+   * @brief Queues a request.
+   *
+   * @param work The request.
+   * @param worker_index The worker to run the request on, any worker if not
+   * set.
+   * @return core::ExecutionResult Whether the request was queued.
+   */
+  core::ExecutionResult Enqueue(
+      Work work, std::optional<size_t> worker_index = std::nullopt) noexcept;
+
+  /// Gets the number of requests waiting for a worker.
+  size_t GetPendingCount() noexcept;
+
+ private:
+  /// Runs the requests of the worker until the queue stops.
+  void RunWorker(size_t worker_index) noexcept;
+
+  /// Takes the next request of the worker, if any. Must hold mutex_.
+  bool TryTakeWork(size_t worker_index, Work& work) noexcept;
+
+  const size_t worker_count_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  /// The requests any worker can run.
+  std::deque<Work> shared_requests_;
+  /// The requests addressed to each worker.
+  std::vector<std::deque<Work>> worker_requests_;
+  bool is_running_;
+  std::vector<std::thread> threads_;
+};
+}  // namespace google::scp::roma::sandbox::dispatcher
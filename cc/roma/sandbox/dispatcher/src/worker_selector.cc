@@ -0,0 +1,160 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "worker_selector.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+using std::make_unique;
+using std::memory_order_relaxed;
+using std::numeric_limits;
+
+namespace {
+/// Mixes the bits of the value, see splitmix64.
+uint64_t Mix(uint64_t value) {
+  value += 0x9e3779b97f4a7c15;
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+  return value ^ (value >> 31);
+}
+}  // namespace
+
+namespace google::scp::roma::sandbox::dispatcher {
+WorkerSelector::WorkerSelector(size_t worker_count,
+                               WorkerSelectionPolicy selection_policy)
+    : worker_count_(worker_count),
+      selection_policy_(selection_policy),
+      worker_loads_(make_unique<WorkerLoad[]>(worker_count)),
+      order_counter_(0) {}
+
+size_t WorkerSelector::SelectWorker(uint64_t code_version) noexcept {
+  switch (selection_policy_) {
+    case WorkerSelectionPolicy::LeastOutstanding:
+      return SelectLeastOutstandingWorker();
+    case WorkerSelectionPolicy::PowerOfTwoChoices:
+      return SelectPowerOfTwoChoicesWorker();
+    case WorkerSelectionPolicy::CodeVersionAffinity:
+      return SelectCodeVersionAffinityWorker(code_version);
+    case WorkerSelectionPolicy::RoundRobin:
+    default:
+      return order_counter_.fetch_add(1, memory_order_relaxed) %
+             worker_count_;
+  }
+}
+
+size_t WorkerSelector::OnRequestAssigned(size_t worker_index) noexcept {
+  return worker_loads_[worker_index].outstanding_request_count.fetch_add(
+      1, memory_order_relaxed);
+}
+
+void WorkerSelector::OnRequestCompleted(size_t worker_index,
+                                        int64_t execution_time_ns) noexcept {
+  auto& worker_load = worker_loads_[worker_index];
+  worker_load.outstanding_request_count.fetch_sub(1, memory_order_relaxed);
+  if (execution_time_ns < 0) {
+    return;
+  }
+  // The requests of a worker complete one at a time, a lost update only skews
+  // the average slightly.
+  auto average =
+      worker_load.average_execution_time_ns.load(memory_order_relaxed);
+  average += (execution_time_ns - average) * kWorkerExecutionTimeDecay / 1024;
+  worker_load.average_execution_time_ns.store(average, memory_order_relaxed);
+}
+
+size_t WorkerSelector::GetOutstandingRequestCount(
+    size_t worker_index) noexcept {
+  return worker_loads_[worker_index].outstanding_request_count.load(
+      memory_order_relaxed);
+}
+
+int64_t WorkerSelector::GetAverageExecutionTimeNs(
+    size_t worker_index) noexcept {
+  return worker_loads_[worker_index].average_execution_time_ns.load(
+      memory_order_relaxed);
+}
+
+size_t WorkerSelector::SelectLeastOutstandingWorker() noexcept {
+  auto offset = order_counter_.fetch_add(1, memory_order_relaxed);
+  size_t selected_index = 0;
+  auto selected_count = numeric_limits<size_t>::max();
+  for (size_t i = 0; i < worker_count_; i++) {
+    auto index = (offset + i) % worker_count_;
+    auto count = GetOutstandingRequestCount(index);
+    if (count < selected_count) {
+      selected_index = index;
+      selected_count = count;
+    }
+  }
+  return selected_index;
+}
+
+size_t WorkerSelector::SelectPowerOfTwoChoicesWorker() noexcept {
+  if (worker_count_ == 1) {
+    return 0;
+  }
+  auto sample = Mix(order_counter_.fetch_add(1, memory_order_relaxed));
+  size_t first_index = sample % worker_count_;
+  // A distinct second worker.
+  size_t second_index =
+      (first_index + 1 + (sample >> 32) % (worker_count_ - 1)) % worker_count_;
+  return GetOutstandingRequestCount(second_index) <
+                 GetOutstandingRequestCount(first_index)
+             ? second_index
+             : first_index;
+}
+
+size_t WorkerSelector::SelectCodeVersionAffinityWorker(
+    uint64_t code_version) noexcept {
+  // Rendezvous hashing: the workers with the highest scores for the version
+  // are its workers, which stays stable for a given number of workers.
+  size_t affinity_index = 0;
+  uint64_t best_score = 0;
+  size_t affinity_count = numeric_limits<size_t>::max();
+  auto affinity_worker_count =
+      std::min(kCodeVersionAffinityWorkerCount, worker_count_);
+  for (size_t rank = 0; rank < affinity_worker_count; rank++) {
+    // Finds the worker of the next highest score.
+    size_t index_at_rank = 0;
+    uint64_t score_at_rank = 0;
+    bool found = false;
+    for (size_t index = 0; index < worker_count_; index++) {
+      auto score = Mix(code_version ^ Mix(index));
+      if ((rank == 0 || score < best_score) &&
+          (!found || score > score_at_rank)) {
+        index_at_rank = index;
+        score_at_rank = score;
+        found = true;
+      }
+    }
+    best_score = score_at_rank;
+    auto count = GetOutstandingRequestCount(index_at_rank);
+    if (count < affinity_count) {
+      affinity_index = index_at_rank;
+      affinity_count = count;
+    }
+  }
+
+  auto least_loaded_index = SelectLeastOutstandingWorker();
+  if (affinity_count > GetOutstandingRequestCount(least_loaded_index) +
+                           kCodeVersionAffinitySpillThreshold) {
+    return least_loaded_index;
+  }
+  return affinity_index;
+}
+}  // namespace google::scp::roma::sandbox::dispatcher
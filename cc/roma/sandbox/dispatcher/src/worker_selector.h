@@ -0,0 +1,107 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "roma/config/src/config.h"
+
+namespace google::scp::roma::sandbox::dispatcher {
+/// The number of workers the requests of a code version are routed to.
+static constexpr size_t kCodeVersionAffinityWorkerCount = 2;
+/// How many more outstanding requests than the least loaded worker the
+/// workers of a code version may have before its requests spill over.
+static constexpr size_t kCodeVersionAffinitySpillThreshold = 2;
+/// The weight of the latest execution time in the per worker average, in
+/// 1/1024th.
+static constexpr int64_t kWorkerExecutionTimeDecay = 128;
+
+/**
+ * @brief Tracks the outstanding requests and the execution time of each
+ * worker, and chooses the worker of the requests according to the selection
+ * policy.
+ */
+class WorkerSelector {
+ public:
+  /**
+   * @brief Construct a new Worker Selector object
+   *
+   * @param worker_count The number of workers.
+   * @param selection_policy How the worker of a request is chosen.
+   */
+  WorkerSelector(size_t worker_count, WorkerSelectionPolicy selection_policy);
+
+  /**
+   * @brief Chooses the worker of a request.
+   *
+   * @param code_version The code version of the request.
+   * @return size_t The index of the worker.
+   */
+  size_t SelectWorker(uint64_t code_version) noexcept;
+
+  /**
+   * @brief Counts a request as outstanding on the worker, until
+   * OnRequestCompleted is called for it.
+   *
+   * @return size_t The number of requests outstanding on the worker before
+   * this one.
+   */
+  size_t OnRequestAssigned(size_t worker_index) noexcept;
+
+  /**
+   * @brief Is called once a request assigned to the worker completes.
+   *
+   * @param worker_index The index of the worker.
+   * @param execution_time_ns The time the worker spent on the request, or a
+   * negative value if it is not to be accounted for.
+   */
+  void OnRequestCompleted(size_t worker_index,
+                          int64_t execution_time_ns) noexcept;
+
+  /// Gets the number of requests queued or running on the worker.
+  size_t GetOutstandingRequestCount(size_t worker_index) noexcept;
+
+  /// Gets the moving average of the execution time of the worker.
+  int64_t GetAverageExecutionTimeNs(size_t worker_index) noexcept;
+
+ private:
+  /// The load of a worker.
+  struct WorkerLoad {
+    std::atomic<size_t> outstanding_request_count{0};
+    std::atomic<int64_t> average_execution_time_ns{0};
+  };
+
+  /// Chooses the worker with the fewest outstanding requests, starting the
+  /// scan at a rotating offset so that ties are spread.
+  size_t SelectLeastOutstandingWorker() noexcept;
+
+  /// Chooses the less loaded of two sampled workers.
+  size_t SelectPowerOfTwoChoicesWorker() noexcept;
+
+  /// Chooses the less loaded of the workers of the code version, or the least
+  /// loaded worker if they are backed up.
+  size_t SelectCodeVersionAffinityWorker(uint64_t code_version) noexcept;
+
+  const size_t worker_count_;
+  const WorkerSelectionPolicy selection_policy_;
+  std::unique_ptr<WorkerLoad[]> worker_loads_;
+  /// Drives the round robin, the scan offsets and the sampling.
+  std::atomic<uint64_t> order_counter_;
+};
+}  // namespace google::scp::roma::sandbox::dispatcher
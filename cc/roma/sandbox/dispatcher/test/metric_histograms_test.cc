@@ -0,0 +1,105 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "roma/sandbox/dispatcher/src/metric_histograms.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using std::numeric_limits;
+using std::string;
+using std::thread;
+using std::unordered_map;
+using std::vector;
+
+namespace google::scp::roma::sandbox::dispatcher::test {
+TEST(MetricHistogramsTest, ValuesAreCountedInPowerOfTwoBuckets) {
+  EXPECT_EQ(MetricHistograms::GetBucketIndex(-1), 0);
+  EXPECT_EQ(MetricHistograms::GetBucketIndex(0), 0);
+  EXPECT_EQ(MetricHistograms::GetBucketIndex(1), 1);
+  EXPECT_EQ(MetricHistograms::GetBucketIndex(2), 2);
+  EXPECT_EQ(MetricHistograms::GetBucketIndex(3), 2);
+  EXPECT_EQ(MetricHistograms::GetBucketIndex(4), 3);
+  EXPECT_EQ(MetricHistograms::GetBucketIndex(1000), 10);
+  EXPECT_EQ(MetricHistograms::GetBucketIndex(numeric_limits<int64_t>::max()),
+            kMetricHistogramBucketCount - 1);
+
+  EXPECT_EQ(MetricHistograms::GetBucketUpperBound(0), 0);
+  EXPECT_EQ(MetricHistograms::GetBucketUpperBound(1), 1);
+  EXPECT_EQ(MetricHistograms::GetBucketUpperBound(10), 1023);
+  EXPECT_EQ(
+      MetricHistograms::GetBucketUpperBound(kMetricHistogramBucketCount - 1),
+      numeric_limits<int64_t>::max());
+}
+
+TEST(MetricHistogramsTest, RecordsTheMetricsInTheirHistograms) {
+  MetricHistograms histograms;
+  histograms.RecordAll(unordered_map<string, int64_t>{{"a", 1}, {"b", 5}});
+  histograms.Record("a", 3);
+
+  auto snapshot = histograms.GetSnapshot("a");
+  EXPECT_EQ(snapshot.count, 2);
+  EXPECT_EQ(snapshot.sum, 4);
+  EXPECT_EQ(snapshot.bucket_counts[1], 1);
+  EXPECT_EQ(snapshot.bucket_counts[2], 1);
+
+  snapshot = histograms.GetSnapshot("b");
+  EXPECT_EQ(snapshot.count, 1);
+  EXPECT_EQ(snapshot.bucket_counts[3], 1);
+
+  EXPECT_EQ(histograms.GetSnapshot("c").count, 0);
+}
+
+TEST(MetricHistogramsTest, ExportsTheHistogramsInThePrometheusFormat) {
+  MetricHistograms histograms;
+  histograms.Record("roma.metric.code_run_ns", 1);
+  histograms.Record("roma.metric.code_run_ns", 3);
+  histograms.Record("roma.metric.code_run_ns", 2);
+
+  EXPECT_EQ(histograms.ToPrometheusText(),
+            "# TYPE roma_metric_code_run_ns histogram\n"
+            "roma_metric_code_run_ns_bucket{le=\"0\"} 0\n"
+            "roma_metric_code_run_ns_bucket{le=\"1\"} 1\n"
+            "roma_metric_code_run_ns_bucket{le=\"3\"} 3\n"
+            "roma_metric_code_run_ns_bucket{le=\"+Inf\"} 3\n"
+            "roma_metric_code_run_ns_sum 6\n"
+            "roma_metric_code_run_ns_count 3\n");
+}
+
+TEST(MetricHistogramsTest, CanRecordConcurrently) {
+  MetricHistograms histograms;
+  vector<thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&histograms, i]() {
+      for (int j = 0; j < 1000; j++) {
+        histograms.Record("metric_" + std::to_string(j % 2), i);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(histograms.GetSnapshot("metric_0").count, 2000);
+  EXPECT_EQ(histograms.GetSnapshot("metric_1").count, 2000);
+  EXPECT_EQ(histograms.GetSnapshot("metric_0").sum, 3000);
+}
+}  // namespace google::scp::roma::sandbox::dispatcher::test
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "roma/sandbox/dispatcher/src/worker_request_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "core/test/utils/conditional_wait.h"
+#include "public/core/test/interface/execution_result_matchers.h"
+#include "roma/sandbox/dispatcher/src/error_codes.h"
+
+using google::scp::core::FailureExecutionResult;
+using google::scp::core::errors::SC_ROMA_DISPATCHER_WORKER_QUEUE_NOT_RUNNING;
+using google::scp::core::test::ResultIs;
+using google::scp::core::test::WaitUntil;
+using std::atomic;
+using std::vector;
+
+namespace google::scp::roma::sandbox::dispatcher::test {
+TEST(WorkerRequestQueueTest, EnqueueFailsWhenNotRunning) {
+  WorkerRequestQueue queue(/*worker_count=*/1);
+  EXPECT_SUCCESS(queue.Init());
+  EXPECT_THAT(queue.Enqueue([](size_t) {}),
+              ResultIs(FailureExecutionResult(
+                  SC_ROMA_DISPATCHER_WORKER_QUEUE_NOT_RUNNING)));
+
+  EXPECT_SUCCESS(queue.Run());
+  EXPECT_SUCCESS(queue.Stop());
+  EXPECT_THAT(queue.Enqueue([](size_t) {}),
+              ResultIs(FailureExecutionResult(
+                  SC_ROMA_DISPATCHER_WORKER_QUEUE_NOT_RUNNING)));
+}
+
+TEST(WorkerRequestQueueTest, IdleWorkersTakeTheQueuedRequests) {
+  WorkerRequestQueue queue(/*worker_count=*/2);
+  EXPECT_SUCCESS(queue.Init());
+  EXPECT_SUCCESS(queue.Run());
+
+  atomic<bool> release_busy_worker = false;
+  atomic<int> busy_worker_index = -1;
+  EXPECT_SUCCESS(queue.Enqueue([&](size_t worker_index) {
+    busy_worker_index = worker_index;
+    WaitUntil([&]() { return release_busy_worker.load(); });
+  }));
+  WaitUntil([&]() { return busy_worker_index != -1; });
+
+  // The requests are not held behind the busy worker.
+  atomic<int> finished_count = 0;
+  for (int i = 0; i < 10; i++) {
+    EXPECT_SUCCESS(queue.Enqueue([&](size_t worker_index) {
+      EXPECT_NE(worker_index, busy_worker_index);
+      finished_count++;
+    }));
+  }
+  WaitUntil([&]() { return finished_count == 10; });
+
+  release_busy_worker = true;
+  EXPECT_SUCCESS(queue.Stop());
+}
+
+TEST(WorkerRequestQueueTest, AddressedRequestsRunOnTheirWorker) {
+  WorkerRequestQueue queue(/*worker_count=*/3);
+  EXPECT_SUCCESS(queue.Init());
+  EXPECT_SUCCESS(queue.Run());
+
+  atomic<int> finished_count = 0;
+  for (size_t target_index = 0; target_index < 3; target_index++) {
+    EXPECT_SUCCESS(queue.Enqueue(
+        [&, target_index](size_t worker_index) {
+          EXPECT_EQ(worker_index, target_index);
+          finished_count++;
+        },
+        target_index));
+  }
+  WaitUntil([&]() { return finished_count == 3; });
+  EXPECT_SUCCESS(queue.Stop());
+}
+
+TEST(WorkerRequestQueueTest, StopRunsTheQueuedRequests) {
+  WorkerRequestQueue queue(/*worker_count=*/1);
+  EXPECT_SUCCESS(queue.Init());
+  EXPECT_SUCCESS(queue.Run());
+
+  atomic<bool> worker_started = false;
+  atomic<bool> release_worker = false;
+  atomic<int> finished_count = 0;
+  EXPECT_SUCCESS(queue.Enqueue([&](size_t) {
+    worker_started = true;
+    WaitUntil([&]() { return release_worker.load(); });
+    finished_count++;
+  }));
+  WaitUntil([&]() { return worker_started.load(); });
+  for (int i = 0; i < 5; i++) {
+    EXPECT_SUCCESS(queue.Enqueue([&](size_t) { finished_count++; }));
+  }
+  EXPECT_EQ(queue.GetPendingCount(), 5);
+
+  release_worker = true;
+  EXPECT_SUCCESS(queue.Stop());
+  EXPECT_EQ(finished_count, 6);
+  EXPECT_EQ(queue.GetPendingCount(), 0);
+}
+}  // namespace google::scp::roma::sandbox::dispatcher::test
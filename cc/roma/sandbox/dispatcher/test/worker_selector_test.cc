@@ -0,0 +1,142 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "roma/sandbox/dispatcher/src/worker_selector.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+
+using std::set;
+
+namespace google::scp::roma::sandbox::dispatcher::test {
+TEST(WorkerSelectorTest, RoundRobinRotatesOverTheWorkers) {
+  WorkerSelector selector(/*worker_count=*/3,
+                          WorkerSelectionPolicy::RoundRobin);
+  selector.OnRequestAssigned(0);
+  EXPECT_EQ(selector.SelectWorker(1), 0);
+  EXPECT_EQ(selector.SelectWorker(1), 1);
+  EXPECT_EQ(selector.SelectWorker(1), 2);
+  EXPECT_EQ(selector.SelectWorker(1), 0);
+}
+
+TEST(WorkerSelectorTest, LeastOutstandingSelectsTheLeastLoadedWorker) {
+  WorkerSelector selector(/*worker_count=*/3,
+                          WorkerSelectionPolicy::LeastOutstanding);
+  selector.OnRequestAssigned(0);
+  selector.OnRequestAssigned(0);
+  selector.OnRequestAssigned(1);
+  selector.OnRequestAssigned(2);
+  selector.OnRequestAssigned(2);
+  for (int i = 0; i < 5; i++) {
+    EXPECT_EQ(selector.SelectWorker(1), 1);
+  }
+
+  selector.OnRequestCompleted(0, -1);
+  selector.OnRequestCompleted(0, -1);
+  EXPECT_EQ(selector.SelectWorker(1), 0);
+}
+
+TEST(WorkerSelectorTest, LeastOutstandingSpreadsTheTies) {
+  WorkerSelector selector(/*worker_count=*/4,
+                          WorkerSelectionPolicy::LeastOutstanding);
+  set<size_t> selected_workers;
+  for (int i = 0; i < 4; i++) {
+    selected_workers.insert(selector.SelectWorker(1));
+  }
+  EXPECT_EQ(selected_workers.size(), 4);
+}
+
+TEST(WorkerSelectorTest, PowerOfTwoChoicesAvoidsTheMostLoadedWorker) {
+  WorkerSelector selector(/*worker_count=*/2,
+                          WorkerSelectionPolicy::PowerOfTwoChoices);
+  selector.OnRequestAssigned(1);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(selector.SelectWorker(1), 0);
+  }
+
+  WorkerSelector single_worker_selector(
+      /*worker_count=*/1, WorkerSelectionPolicy::PowerOfTwoChoices);
+  EXPECT_EQ(single_worker_selector.SelectWorker(1), 0);
+}
+
+TEST(WorkerSelectorTest, CodeVersionAffinityKeepsAVersionOnItsWorkers) {
+  for (uint64_t version = 1; version < 20; version++) {
+    WorkerSelector selector(/*worker_count=*/8,
+                            WorkerSelectionPolicy::CodeVersionAffinity);
+    set<size_t> selected_workers;
+    for (int i = 0; i < 6; i++) {
+      auto index = selector.SelectWorker(version);
+      selected_workers.insert(index);
+      selector.OnRequestAssigned(index);
+    }
+    EXPECT_EQ(selected_workers.size(), kCodeVersionAffinityWorkerCount);
+
+    // The workers of the version do not depend on the load.
+    for (auto index : selected_workers) {
+      while (selector.GetOutstandingRequestCount(index) > 0) {
+        selector.OnRequestCompleted(index, -1);
+      }
+    }
+    for (int i = 0; i < 4; i++) {
+      auto index = selector.SelectWorker(version);
+      EXPECT_EQ(selected_workers.count(index), 1);
+      selector.OnRequestAssigned(index);
+    }
+  }
+}
+
+TEST(WorkerSelectorTest, CodeVersionAffinitySpillsOverWhenBackedUp) {
+  WorkerSelector selector(/*worker_count=*/4,
+                          WorkerSelectionPolicy::CodeVersionAffinity);
+  set<size_t> affinity_workers;
+  // Loads the workers of the version up to the spill threshold.
+  for (size_t i = 0;
+       i < kCodeVersionAffinityWorkerCount *
+               (kCodeVersionAffinitySpillThreshold + 1);
+       i++) {
+    auto index = selector.SelectWorker(7);
+    affinity_workers.insert(index);
+    selector.OnRequestAssigned(index);
+  }
+  EXPECT_EQ(affinity_workers.size(), kCodeVersionAffinityWorkerCount);
+
+  auto index = selector.SelectWorker(7);
+  EXPECT_EQ(affinity_workers.count(index), 0);
+  EXPECT_EQ(selector.GetOutstandingRequestCount(index), 0);
+}
+
+TEST(WorkerSelectorTest, TracksTheLoadOfTheWorkers) {
+  WorkerSelector selector(/*worker_count=*/2,
+                          WorkerSelectionPolicy::LeastOutstanding);
+  EXPECT_EQ(selector.OnRequestAssigned(1), 0);
+  EXPECT_EQ(selector.OnRequestAssigned(1), 1);
+  EXPECT_EQ(selector.GetOutstandingRequestCount(0), 0);
+  EXPECT_EQ(selector.GetOutstandingRequestCount(1), 2);
+
+  selector.OnRequestCompleted(1, 1024);
+  EXPECT_EQ(selector.GetOutstandingRequestCount(1), 1);
+  EXPECT_EQ(selector.GetAverageExecutionTimeNs(1),
+            1024 * kWorkerExecutionTimeDecay / 1024);
+
+  // Requests that did not run are not part of the average.
+  selector.OnRequestCompleted(1, -1);
+  EXPECT_EQ(selector.GetOutstandingRequestCount(1), 0);
+  EXPECT_EQ(selector.GetAverageExecutionTimeNs(1),
+            1024 * kWorkerExecutionTimeDecay / 1024);
+  EXPECT_EQ(selector.GetAverageExecutionTimeNs(0), 0);
+}
+}  // namespace google::scp::roma::sandbox::dispatcher::test
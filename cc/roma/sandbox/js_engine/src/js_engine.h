@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -50,6 +51,10 @@ struct JsEngineExecutionResponse {
    * The response of the JS/WASM execution
    */
   std::string response;
+  /**
+   * The metrics of the JS/WASM execution
+   */
+  std::unordered_map<std::string, int64_t> metrics;
 };
 
 /**
@@ -103,5 +108,14 @@ class JsEngine : public core::ServiceInterface {
       const std::vector<absl::string_view>& input,
       const std::unordered_map<std::string, std::string>& metadata,
       const RomaJsEngineCompilationContext& context) noexcept = 0;
+
+  /**
+   * @brief Creates a startup snapshot of the engine with everything that is
+   * registered in it ahead of any code, from which other instances of the
+   * engine can be booted.
+   * @return The serialized startup snapshot.
+   */
+  virtual core::ExecutionResultOr<std::string>
+  CreateStartupSnapshot() noexcept = 0;
 };
 }  // namespace google::scp::roma::sandbox::js_engine
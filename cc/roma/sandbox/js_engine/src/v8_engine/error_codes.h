@@ -79,6 +79,20 @@ DEFINE_ERROR_CODE(
     "Create compilation context failed with empty source code.",
     HttpStatusCode::BAD_REQUEST)
 
+DEFINE_ERROR_CODE(SC_ROMA_V8_ENGINE_INVALID_IO_FORMAT, SC_ROMA_V8_ENGINE,
+                  0x000D, "The IO format of the request is not supported.",
+                  HttpStatusCode::BAD_REQUEST)
+
+DEFINE_ERROR_CODE(SC_ROMA_V8_ENGINE_COULD_NOT_SERIALIZE_OUTPUT,
+                  SC_ROMA_V8_ENGINE, 0x000E,
+                  "Error serializing the output of the handler.",
+                  HttpStatusCode::BAD_REQUEST)
+
+DEFINE_ERROR_CODE(SC_ROMA_V8_ENGINE_INVALID_STARTUP_SNAPSHOT,
+                  SC_ROMA_V8_ENGINE, 0x000F,
+                  "The startup snapshot is not valid for this engine.",
+                  HttpStatusCode::BAD_REQUEST)
+
 REGISTER_COMPONENT_CODE(SC_ROMA_V8_ISOLATE_VISITOR_FUNCTION_BINDING, 0x0A01)
 
 DEFINE_ERROR_CODE(SC_ROMA_V8_ISOLATE_VISITOR_FUNCTION_BINDING_INVALID_ISOLATE,
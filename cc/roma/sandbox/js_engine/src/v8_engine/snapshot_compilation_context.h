@@ -50,7 +50,19 @@ class SnapshotCompilationContext {
   /// An instance of UnboundScript used to cache compiled code in isolate.
   v8::Global<v8::UnboundScript> unbound_script;
 
+  /// A context of the isolate with the code evaluated, ready to run a
+  /// handler.
+  struct PooledContext {
+    v8::Global<v8::Context> context;
+    /// The number of invocations the context served.
+    size_t use_count = 0;
+  };
+
+  /// The contexts ready for the next invocations, see JsContextPoolOptions.
+  std::vector<PooledContext> context_pool;
+
   ~SnapshotCompilationContext() {
+    context_pool.clear();
     unbound_script.Reset();
 
     if (v8_isolate) {
@@ -16,8 +16,12 @@
 
 #pragma once
 
+#include <cstdint>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "core/interface/type_def.h"
 #include "include/v8.h"
 #include "public/core/interface/execution_result.h"
 
@@ -30,5 +34,42 @@ class V8IsolateVisitor {
 
   virtual void AddExternalReferences(
       std::vector<intptr_t>& external_references) noexcept = 0;
+
+  /**
+   * @brief Wait for some of the async calls made from the isolate to
+   * complete, and settle their promises. Must be called within the isolate.
+   *
+   * @param isolate
+   * @param timeout_ms how long to wait for a call to complete. The calls that
+   * do not complete in time are rejected.
+   * @return Whether there were calls to wait for.
+   */
+  virtual bool SettlePendingCalls(v8::Isolate* isolate,
+                                  core::TimeDuration timeout_ms) noexcept {
+    return false;
+  }
+
+  /**
+   * @brief Abandon the async calls made from the isolate that are still in
+   * flight, once the invocation that made them is over. Must be called within
+   * the isolate.
+   *
+   * @param isolate
+   */
+  virtual void AbandonPendingCalls(v8::Isolate* isolate) noexcept {}
+
+  /**
+   * @brief Reset the metrics that the visitor tracks for an invocation, ahead
+   * of the invocation.
+   */
+  virtual void ResetInvocationMetrics() noexcept {}
+
+  /**
+   * @brief Add the metrics that the visitor tracked since the last reset.
+   *
+   * @param metrics The metrics of the invocation.
+   */
+  virtual void AddInvocationMetrics(
+      std::unordered_map<std::string, int64_t>& metrics) noexcept {}
 };
 }  // namespace google::scp::roma::sandbox::js_engine::v8_js_engine
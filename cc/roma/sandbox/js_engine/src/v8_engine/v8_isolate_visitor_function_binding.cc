@@ -16,11 +16,14 @@
 
 #include "v8_isolate_visitor_function_binding.h"
 
+#include <algorithm>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "cc/roma/interface/function_binding_io.pb.h"
+#include "core/common/time_provider/src/stopwatch.h"
 #include "roma/common/src/containers.h"
 #include "roma/config/src/type_converter.h"
 #include "roma/sandbox/constants/constants.h"
@@ -31,6 +34,8 @@
 using google::scp::core::ExecutionResult;
 using google::scp::core::FailureExecutionResult;
 using google::scp::core::SuccessExecutionResult;
+using google::scp::core::TimeDuration;
+using google::scp::core::common::Stopwatch;
 using google::scp::core::errors::
     SC_ROMA_V8_ENGINE_COULD_NOT_REGISTER_FUNCTION_BINDING;
 using google::scp::core::errors::
@@ -38,7 +43,12 @@ using google::scp::core::errors::
 using google::scp::core::errors::
     SC_ROMA_V8_ISOLATE_VISITOR_FUNCTION_BINDING_INVALID_ISOLATE;
 using google::scp::roma::proto::FunctionBindingIoProto;
+using google::scp::roma::sandbox::constants::kExecutionMetricBindingCallCount;
+using google::scp::roma::sandbox::constants::kExecutionMetricBindingWallNs;
 using google::scp::roma::sandbox::constants::kMetadataRomaRequestId;
+using std::any_of;
+using std::move;
+using std::pair;
 using std::string;
 using std::to_string;
 using std::unordered_map;
@@ -49,12 +59,14 @@ using v8::External;
 using v8::Function;
 using v8::FunctionCallbackInfo;
 using v8::FunctionTemplate;
+using v8::Global;
 using v8::HandleScope;
 using v8::Isolate;
 using v8::Local;
 using v8::Map;
 using v8::Object;
 using v8::ObjectTemplate;
+using v8::Promise;
 using v8::String;
 using v8::Undefined;
 using v8::Value;
@@ -82,57 +94,105 @@ static bool V8TypesToProto(const FunctionCallbackInfo<Value>& info,
   }
 
   auto isolate = info.GetIsolate();
+  auto context = isolate->GetCurrentContext();
   auto function_parameter = info[0];
 
-  // Try to convert to one of the supported types
-  string string_native;
-  vector<string> vector_of_string_native;
-  unordered_map<string, string> map_of_string_native;
-
-  if (TypeConverter<string>::FromV8(isolate, function_parameter,
-                                    &string_native)) {
-    proto.set_input_string(string_native);
-  } else if (TypeConverter<vector<string>>::FromV8(isolate, function_parameter,
-                                                   &vector_of_string_native)) {
-    proto.mutable_input_list_of_string()->mutable_data()->Add(
-        vector_of_string_native.begin(), vector_of_string_native.end());
-  } else if (TypeConverter<unordered_map<string, string>>::FromV8(
-                 isolate, function_parameter, &map_of_string_native)) {
-    for (auto&& kvp : map_of_string_native) {
-      (*proto.mutable_input_map_of_string()->mutable_data())[kvp.first] =
-          kvp.second;
+  // Try to convert to one of the supported types. The values are written into
+  // the proto in place, without going through intermediate containers.
+  if (function_parameter->IsString()) {
+    return TypeConverter<string>::FromV8(isolate, function_parameter,
+                                         proto.mutable_input_string());
+  }
+
+  if (function_parameter->IsArray()) {
+    auto array = function_parameter.As<Array>();
+    auto data = proto.mutable_input_list_of_string()->mutable_data();
+    data->Reserve(array->Length());
+    for (uint32_t i = 0; i < array->Length(); i++) {
+      Local<Value> item;
+      if (!array->Get(context, i).ToLocal(&item) ||
+          !TypeConverter<string>::FromV8(isolate, item, data->Add())) {
+        proto.clear_input_list_of_string();
+        return false;
+      }
     }
-  } else {
-    // Unknown type
-    return false;
+    return true;
   }
 
-  return true;
+  if (function_parameter->IsMap()) {
+    // This turns the map into an array of size Size()*2, where index N is a
+    // key, and N+1 is the value for the given key.
+    auto map_as_array = function_parameter.As<Map>()->AsArray();
+    auto data = proto.mutable_input_map_of_string()->mutable_data();
+    string key;
+    for (uint32_t i = 0; i < map_as_array->Length(); i += 2) {
+      Local<Value> v8_key;
+      Local<Value> v8_value;
+      if (!map_as_array->Get(context, i).ToLocal(&v8_key) ||
+          !map_as_array->Get(context, i + 1).ToLocal(&v8_value) ||
+          !TypeConverter<string>::FromV8(isolate, v8_key, &key) ||
+          !TypeConverter<string>::FromV8(isolate, v8_value, &(*data)[key])) {
+        proto.clear_input_map_of_string();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Unknown type
+  return false;
 }
 
 static Local<Value> ProtoToV8Type(Isolate* isolate,
                                   const FunctionBindingIoProto& proto) {
+  auto context = isolate->GetCurrentContext();
+
   if (proto.has_output_string()) {
     return TypeConverter<string>::ToV8(isolate, proto.output_string());
   } else if (proto.has_output_list_of_string()) {
-    auto len = proto.output_list_of_string().data().size();
-    vector<string> output_list;
-    for (int i = 0; i < len; i++) {
-      output_list.push_back(proto.output_list_of_string().data().at(i));
+    auto& data = proto.output_list_of_string().data();
+    auto array = Array::New(isolate, data.size());
+    for (int i = 0; i < data.size(); i++) {
+      array->Set(context, i, TypeConverter<string>::ToV8(isolate, data.at(i)))
+          .Check();
     }
-    return TypeConverter<vector<string>>::ToV8(isolate, output_list);
+    return array;
   } else if (proto.has_output_map_of_string()) {
-    unordered_map<string, string> output_map;
+    auto map = Map::New(isolate);
     for (auto& [key, value] : proto.output_map_of_string().data()) {
-      output_map[key] = value;
+      if (map->Set(context, TypeConverter<string>::ToV8(isolate, key),
+                   TypeConverter<string>::ToV8(isolate, value))
+              .IsEmpty()) {
+        return Undefined(isolate);
+      }
     }
-    return TypeConverter<unordered_map<string, string>>::ToV8(isolate,
-                                                              output_map);
+    return map;
   }
 
   return Undefined(isolate);
 }
 
+static void SetRequestIdInMetadata(Isolate* isolate, Local<Context>& context,
+                                   FunctionBindingIoProto& proto) {
+  // Read the request ID from the global object in the context
+  auto request_id_label =
+      TypeConverter<string>::ToV8(isolate, kMetadataRomaRequestId).As<String>();
+  auto roma_request_id_maybe =
+      context->Global()->Get(context, request_id_label);
+  Local<Value> roma_request_id;
+  string roma_request_id_native;
+  if (roma_request_id_maybe.ToLocal(&roma_request_id) &&
+      TypeConverter<string>::FromV8(isolate, roma_request_id,
+                                    &roma_request_id_native)) {
+    // Set the request ID in the function call metadata so that it is accessible
+    // when the function is invoked in the user-provided binding.
+    (*proto.mutable_metadata())[kMetadataRomaRequestId] =
+        roma_request_id_native;
+  } else {
+    _ROMA_LOG_ERROR("Could not read request ID from metadata in hook.");
+  }
+}
+
 void V8IsolateVisitorFunctionBinding::GlobalV8FunctionCallback(
     const FunctionCallbackInfo<Value>& info) {
   auto isolate = info.GetIsolate();
@@ -147,9 +207,9 @@ void V8IsolateVisitorFunctionBinding::GlobalV8FunctionCallback(
     return;
   }
 
-  Local<External> binding_info_pair_external = Local<External>::Cast(data);
-  auto binding_info_pair =
-      reinterpret_cast<BindingPair*>(binding_info_pair_external->Value());
+  Local<External> binding_reference_external = Local<External>::Cast(data);
+  auto binding_reference = reinterpret_cast<BindingReference*>(
+      binding_reference_external->Value());
 
   FunctionBindingIoProto function_invocation_proto;
   if (!V8TypesToProto(info, function_invocation_proto)) {
@@ -157,32 +217,15 @@ void V8IsolateVisitorFunctionBinding::GlobalV8FunctionCallback(
     return;
   }
 
-  // Read the request ID from the global object in the context
-  auto request_id_label =
-      TypeConverter<string>::ToV8(isolate, kMetadataRomaRequestId).As<String>();
-  auto roma_request_id_maybe =
-      context->Global()->Get(context, request_id_label);
-  Local<Value> roma_request_id;
-  string roma_request_id_native;
-  if (roma_request_id_maybe.ToLocal(&roma_request_id) &&
-      TypeConverter<string>::FromV8(isolate, roma_request_id,
-                                    &roma_request_id_native)) {
-    // Set the request ID in the function call metadata so that it is accessible
-    // when the function is invoked in the user-provided binding.
-    (*function_invocation_proto.mutable_metadata())[kMetadataRomaRequestId] =
-        roma_request_id_native;
-  } else {
-    _ROMA_LOG_ERROR("Could not read request ID from metadata in hook.");
-  }
-
-  string native_function_name = binding_info_pair->first;
-  if (native_function_name.empty()) {
-    isolate->ThrowError(kCouldNotRunFunctionBinding);
-    return;
-  }
+  SetRequestIdInMetadata(isolate, context, function_invocation_proto);
 
-  auto result = binding_info_pair->second->function_invoker_->Invoke(
-      native_function_name, function_invocation_proto);
+  auto visitor = binding_reference->visitor;
+  Stopwatch stopwatch;
+  stopwatch.Start();
+  auto result = visitor->function_invoker_->Invoke(
+      binding_reference->function_id, function_invocation_proto);
+  visitor->binding_wall_ns_ += stopwatch.Stop().count();
+  visitor->binding_call_count_++;
   if (!result.Successful()) {
     isolate->ThrowError(kCouldNotRunFunctionBinding);
     return;
@@ -201,6 +244,151 @@ void V8IsolateVisitorFunctionBinding::GlobalV8FunctionCallback(
   info.GetReturnValue().Set(returned_value);
 }
 
+void V8IsolateVisitorFunctionBinding::GlobalV8AsyncFunctionCallback(
+    const FunctionCallbackInfo<Value>& info) {
+  auto isolate = info.GetIsolate();
+  auto context = isolate->GetCurrentContext();
+  Isolate::Scope isolate_scope(isolate);
+  HandleScope handle_scope(isolate);
+
+  auto data = info.Data();
+
+  if (data.IsEmpty()) {
+    isolate->ThrowError(kUnexpectedDataInBindingCallback);
+    return;
+  }
+
+  Local<External> binding_reference_external = Local<External>::Cast(data);
+  auto binding_reference = reinterpret_cast<BindingReference*>(
+      binding_reference_external->Value());
+
+  FunctionBindingIoProto function_invocation_proto;
+  if (!V8TypesToProto(info, function_invocation_proto)) {
+    isolate->ThrowError(kCouldNotConvertJsFunctionInputToNative);
+    return;
+  }
+
+  SetRequestIdInMetadata(isolate, context, function_invocation_proto);
+
+  Local<Promise::Resolver> resolver;
+  if (!Promise::Resolver::New(context).ToLocal(&resolver)) {
+    isolate->ThrowError(kCouldNotRunFunctionBinding);
+    return;
+  }
+
+  // The promise is settled once the call completes, see SettlePendingCalls.
+  auto visitor = binding_reference->visitor;
+  auto call_id_or = visitor->function_invoker_->InvokeAsync(
+      binding_reference->function_id, function_invocation_proto);
+  if (!call_id_or.result().Successful()) {
+    isolate->ThrowError(kCouldNotRunFunctionBinding);
+    return;
+  }
+  visitor->binding_call_count_++;
+  visitor->pending_calls_.emplace(
+      *call_id_or,
+      PendingCall{isolate, Global<Context>(isolate, context),
+                  Global<Promise::Resolver>(isolate, resolver)});
+
+  info.GetReturnValue().Set(resolver->GetPromise());
+}
+
+bool V8IsolateVisitorFunctionBinding::SettlePendingCalls(
+    Isolate* isolate, TimeDuration timeout_ms) noexcept {
+  auto has_pending_call =
+      any_of(pending_calls_.begin(), pending_calls_.end(),
+             [isolate](const auto& pending_call) {
+               return pending_call.second.isolate == isolate;
+             });
+  if (!has_pending_call) {
+    return false;
+  }
+
+  HandleScope handle_scope(isolate);
+  vector<pair<uint64_t, FunctionBindingIoProto>> completed_calls;
+  Stopwatch stopwatch;
+  stopwatch.Start();
+  auto result =
+      function_invoker_->WaitForCompletedCalls(completed_calls, timeout_ms);
+  binding_wall_ns_ += stopwatch.Stop().count();
+  if (!result.Successful()) {
+    // The calls in flight did not complete in time, or can no longer complete.
+    for (auto& [call_id, pending_call] : pending_calls_) {
+      if (pending_call.isolate != isolate) {
+        continue;
+      }
+      auto context = pending_call.context.Get(isolate);
+      auto error_message =
+          TypeConverter<string>::ToV8(isolate, kCouldNotRunFunctionBinding);
+      pending_call.resolver.Get(isolate)
+          ->Reject(context, v8::Exception::Error(error_message.As<String>()))
+          .Check();
+    }
+    AbandonPendingCalls(isolate);
+    return true;
+  }
+
+  for (auto& [call_id, function_invocation_proto] : completed_calls) {
+    auto pending_call_it = pending_calls_.find(call_id);
+    if (pending_call_it == pending_calls_.end()) {
+      continue;
+    }
+    auto pending_call = move(pending_call_it->second);
+    pending_calls_.erase(pending_call_it);
+    // The invocation that made the call is over.
+    if (pending_call.isolate != isolate) {
+      continue;
+    }
+
+    auto context = pending_call.context.Get(isolate);
+    Context::Scope context_scope(context);
+    auto resolver = pending_call.resolver.Get(isolate);
+    Local<Value> returned_value;
+    if (function_invocation_proto.errors().size() == 0) {
+      returned_value = ProtoToV8Type(isolate, function_invocation_proto);
+    }
+    if (!returned_value.IsEmpty() && !returned_value->IsUndefined()) {
+      resolver->Resolve(context, returned_value).Check();
+      continue;
+    }
+    auto error_message = TypeConverter<string>::ToV8(
+        isolate, function_invocation_proto.errors().size() > 0
+                     ? kErrorInFunctionBindingInvocation
+                     : KCouldNotConvertNativeFunctionReturnToV8Type);
+    resolver->Reject(context, v8::Exception::Error(error_message.As<String>()))
+        .Check();
+  }
+
+  return true;
+}
+
+void V8IsolateVisitorFunctionBinding::AbandonPendingCalls(
+    Isolate* isolate) noexcept {
+  vector<uint64_t> call_ids;
+  for (auto it = pending_calls_.begin(); it != pending_calls_.end();) {
+    if (it->second.isolate == isolate) {
+      call_ids.push_back(it->first);
+      it = pending_calls_.erase(it);
+    } else {
+      it++;
+    }
+  }
+  if (!call_ids.empty()) {
+    function_invoker_->AbandonCalls(call_ids);
+  }
+}
+
+void V8IsolateVisitorFunctionBinding::ResetInvocationMetrics() noexcept {
+  binding_call_count_ = 0;
+  binding_wall_ns_ = 0;
+}
+
+void V8IsolateVisitorFunctionBinding::AddInvocationMetrics(
+    unordered_map<string, int64_t>& metrics) noexcept {
+  metrics[kExecutionMetricBindingCallCount] = binding_call_count_;
+  metrics[kExecutionMetricBindingWallNs] = binding_wall_ns_;
+}
+
 ExecutionResult V8IsolateVisitorFunctionBinding::Visit(
     Isolate* isolate, Local<ObjectTemplate>& global_object_template) noexcept {
   if (!isolate) {
@@ -219,11 +407,23 @@ ExecutionResult V8IsolateVisitorFunctionBinding::Visit(
 
     // Convert the function binding name to a v8 type
     auto binding_name =
-        TypeConverter<string>::ToV8(isolate, binding_refer->first).As<String>();
+        TypeConverter<string>::ToV8(isolate, binding_refer->function_name)
+            .As<String>();
 
     global_object_template->Set(binding_name, function_template);
   }
 
+  for (auto binding_refer : async_binding_references_) {
+    Local<External> binding_context_pair =
+        External::New(isolate, reinterpret_cast<void*>(binding_refer.get()));
+    auto function_template = FunctionTemplate::New(
+        isolate, &GlobalV8AsyncFunctionCallback, binding_context_pair);
+    auto binding_name =
+        TypeConverter<string>::ToV8(isolate, binding_refer->function_name)
+            .As<String>();
+    global_object_template->Set(binding_name, function_template);
+  }
+
   return SuccessExecutionResult();
 }
 
@@ -235,8 +435,14 @@ void V8IsolateVisitorFunctionBinding::AddExternalReferences(
     external_references.push_back(
         reinterpret_cast<intptr_t>(binding_refer.get()));
   }
+  for (auto binding_refer : async_binding_references_) {
+    external_references.push_back(
+        reinterpret_cast<intptr_t>(binding_refer.get()));
+  }
   external_references.push_back(
       reinterpret_cast<intptr_t>(&GlobalV8FunctionCallback));
+  external_references.push_back(
+      reinterpret_cast<intptr_t>(&GlobalV8AsyncFunctionCallback));
 }
 
 }  // namespace google::scp::roma::sandbox::js_engine::v8_js_engine
@@ -16,9 +16,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
-#include <utility>
+#include <unordered_map>
 #include <vector>
 
 #include "include/v8.h"
@@ -34,15 +35,44 @@ class V8IsolateVisitorFunctionBinding : public V8IsolateVisitor {
    * @brief Create a V8IsolateVisitorFunctionBinding instance
    * @param function_names is a list of the names of the functions that can be
    * registered in the v8 context.
+   * @param function_invoker is used to call the native functions.
+   * @param async_function_names is a list of the names of the functions that
+   * return a Promise, which is resolved once the native function completes.
+   * @param function_ids is the list of the IDs by which the functions of
+   * function_names are called, which the native function table assigned to
+   * them.
+   * @param async_function_ids is the list of the IDs by which the functions of
+   * async_function_names are called.
+   *
+   * If the IDs are not given, a function is called by its position in
+   * function_names followed by async_function_names.
    */
   V8IsolateVisitorFunctionBinding(
       const std::vector<std::string>& function_names,
       const std::shared_ptr<native_function_binding::NativeFunctionInvoker>&
-          function_invoker)
+          function_invoker,
+      const std::vector<std::string>& async_function_names =
+          std::vector<std::string>(),
+      const std::vector<uint32_t>& function_ids = std::vector<uint32_t>(),
+      const std::vector<uint32_t>& async_function_ids =
+          std::vector<uint32_t>())
       : function_names_(function_names), function_invoker_(function_invoker) {
-    for (auto function_name : function_names_) {
-      auto pair = std::pair(function_name, this);
-      binding_references_.push_back(std::make_shared<BindingPair>(pair));
+    uint32_t function_id = 0;
+    for (size_t i = 0; i < function_names_.size(); i++) {
+      binding_references_.push_back(
+          std::make_shared<BindingReference>(BindingReference{
+              function_names_[i],
+              i < function_ids.size() ? function_ids[i] : function_id, this}));
+      function_id++;
+    }
+    for (size_t i = 0; i < async_function_names.size(); i++) {
+      async_binding_references_.push_back(
+          std::make_shared<BindingReference>(BindingReference{
+              async_function_names[i],
+              i < async_function_ids.size() ? async_function_ids[i]
+                                            : function_id,
+              this}));
+      function_id++;
     }
   }
 
@@ -53,15 +83,47 @@ class V8IsolateVisitorFunctionBinding : public V8IsolateVisitor {
   void AddExternalReferences(
       std::vector<intptr_t>& external_references) noexcept override;
 
+  bool SettlePendingCalls(v8::Isolate* isolate,
+                          core::TimeDuration timeout_ms) noexcept override;
+
+  void AbandonPendingCalls(v8::Isolate* isolate) noexcept override;
+
+  void ResetInvocationMetrics() noexcept override;
+
+  void AddInvocationMetrics(
+      std::unordered_map<std::string, int64_t>& metrics) noexcept override;
+
  private:
-  typedef std::pair<std::string, V8IsolateVisitorFunctionBinding*> BindingPair;
-  std::vector<std::shared_ptr<BindingPair>> binding_references_;
+  /// The data of the JS function of a binding.
+  struct BindingReference {
+    std::string function_name;
+    uint32_t function_id;
+    V8IsolateVisitorFunctionBinding* visitor;
+  };
+  std::vector<std::shared_ptr<BindingReference>> binding_references_;
+  std::vector<std::shared_ptr<BindingReference>> async_binding_references_;
+
+  /// An async call in flight, with the promise it returned to JS.
+  struct PendingCall {
+    v8::Isolate* isolate;
+    v8::Global<v8::Context> context;
+    v8::Global<v8::Promise::Resolver> resolver;
+  };
+  /// The async calls in flight by call ID.
+  std::unordered_map<uint64_t, PendingCall> pending_calls_;
 
   static void GlobalV8FunctionCallback(
       const v8::FunctionCallbackInfo<v8::Value>& info);
 
+  static void GlobalV8AsyncFunctionCallback(
+      const v8::FunctionCallbackInfo<v8::Value>& info);
+
   const std::vector<std::string> function_names_;
   std::shared_ptr<native_function_binding::NativeFunctionInvoker>
       function_invoker_;
+  /// The number of calls made since the last reset.
+  int64_t binding_call_count_ = 0;
+  /// The time spent blocked on calls since the last reset, in nanoseconds.
+  int64_t binding_wall_ns_ = 0;
 };
 }  // namespace google::scp::roma::sandbox::js_engine::v8_js_engine
@@ -17,13 +17,17 @@
 #include "v8_js_engine.h"
 
 #include <algorithm>
+#include <chrono>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "absl/cleanup/cleanup.h"
 #include "absl/strings/string_view.h"
+#include "core/common/time_provider/src/stopwatch.h"
 #include "public/core/interface/execution_result.h"
 #include "roma/config/src/type_converter.h"
 #include "roma/sandbox/constants/constants.h"
@@ -38,6 +42,7 @@ using google::scp::core::ExecutionResult;
 using google::scp::core::ExecutionResultOr;
 using google::scp::core::FailureExecutionResult;
 using google::scp::core::SuccessExecutionResult;
+using google::scp::core::common::Stopwatch;
 using google::scp::core::errors::GetErrorMessage;
 using google::scp::core::errors::
     SC_ROMA_V8_ENGINE_COULD_NOT_CONVERT_OUTPUT_TO_JSON;
@@ -47,12 +52,26 @@ using google::scp::core::errors::SC_ROMA_V8_ENGINE_COULD_NOT_CREATE_ISOLATE;
 using google::scp::core::errors::
     SC_ROMA_V8_ENGINE_COULD_NOT_FIND_HANDLER_BY_NAME;
 using google::scp::core::errors::SC_ROMA_V8_ENGINE_COULD_NOT_PARSE_SCRIPT_INPUT;
+using google::scp::core::errors::SC_ROMA_V8_ENGINE_COULD_NOT_SERIALIZE_OUTPUT;
 using google::scp::core::errors::
     SC_ROMA_V8_ENGINE_CREATE_COMPILATION_CONTEXT_FAILED_WITH_EMPTY_CODE;
 using google::scp::core::errors::SC_ROMA_V8_ENGINE_ERROR_INVOKING_HANDLER;
+using google::scp::core::errors::SC_ROMA_V8_ENGINE_INVALID_IO_FORMAT;
+using google::scp::core::errors::SC_ROMA_V8_ENGINE_INVALID_STARTUP_SNAPSHOT;
 using google::scp::core::errors::SC_ROMA_V8_ENGINE_ISOLATE_NOT_INITIALIZED;
 using google::scp::roma::kDefaultExecutionTimeoutMs;
+using google::scp::roma::kIoFormatJson;
+using google::scp::roma::kIoFormatSerialized;
+using google::scp::roma::kIoFormatString;
+using google::scp::roma::kIoFormatTag;
 using google::scp::roma::TypeConverter;
+using google::scp::roma::sandbox::constants::kExecutionMetricContextSetupNs;
+using google::scp::roma::sandbox::constants::
+    kExecutionMetricHandlerExecutionNs;
+using google::scp::roma::sandbox::constants::kExecutionMetricInputParsingNs;
+using google::scp::roma::sandbox::constants::kExecutionMetricJsHeapUsedBytes;
+using google::scp::roma::sandbox::constants::
+    kExecutionMetricOutputSerializationNs;
 using google::scp::roma::sandbox::constants::kJsEngineOneTimeSetupWasmPagesKey;
 using google::scp::roma::sandbox::constants::kMaxNumberOfWasm32BitMemPages;
 using google::scp::roma::sandbox::constants::kMetadataRomaRequestId;
@@ -74,11 +93,16 @@ using std::stringstream;
 using std::to_string;
 using std::unordered_map;
 using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
 using v8::Array;
 using v8::ArrayBuffer;
 using v8::Context;
 using v8::Function;
+using v8::Global;
 using v8::HandleScope;
+using v8::HeapStatistics;
 using v8::Int32;
 using v8::Isolate;
 using v8::JSON;
@@ -95,16 +119,6 @@ using v8::WasmModuleObject;
 namespace {
 constexpr char kTimeoutErrorMsg[] = "ROMA: Request execution timeout.";
 
-shared_ptr<string> GetCodeFromContext(
-    const RomaJsEngineCompilationContext& context) {
-  shared_ptr<string> code;
-
-  if (context.has_context) {
-    code = static_pointer_cast<string>(context.context);
-  }
-
-  return code;
-}
 
 ExecutionResult GetError(Isolate*& isolate, TryCatch& try_catch,
                          uint64_t& error_code) {
@@ -159,11 +173,77 @@ ExecutionResult CreateV8Context(
   return SuccessExecutionResult();
 }
 
+/**
+ * @brief Drops the calls that an invocation left pending in the isolate
+ * visitors when the invocation ends, so that no promise of an ended invocation
+ * is settled later on.
+ */
+class PendingCallsGuard {
+ public:
+  PendingCallsGuard(
+      v8::Isolate* isolate,
+      const std::vector<std::shared_ptr<V8IsolateVisitor>>& isolate_visitors)
+      : isolate_(isolate), isolate_visitors_(isolate_visitors) {}
+
+  ~PendingCallsGuard() {
+    for (auto& visitor : isolate_visitors_) {
+      visitor->AbandonPendingCalls(isolate_);
+    }
+  }
+
+ private:
+  v8::Isolate* isolate_;
+  const std::vector<std::shared_ptr<V8IsolateVisitor>>& isolate_visitors_;
+};
+
+/**
+ * @brief Runs the microtasks of the isolate and settles the calls that the
+ * isolate visitors have in flight until the promise is no longer pending or no
+ * call is left to settle.
+ *
+ * @param isolate
+ * @param isolate_visitors
+ * @param promise
+ * @param deadline the time after which the calls in flight are no longer
+ * waited for, since the watchdog timed the execution out.
+ */
+void SettlePromise(
+    v8::Isolate* isolate,
+    const std::vector<std::shared_ptr<V8IsolateVisitor>>& isolate_visitors,
+    Local<v8::Promise>& promise, steady_clock::time_point deadline) noexcept {
+  while (true) {
+    isolate->PerformMicrotaskCheckpoint();
+    if (promise->State() != v8::Promise::kPending ||
+        isolate->IsExecutionTerminating()) {
+      return;
+    }
+
+    auto remaining_ms =
+        duration_cast<milliseconds>(deadline - steady_clock::now()).count();
+    auto settled_calls = false;
+    for (auto& visitor : isolate_visitors) {
+      settled_calls |= visitor->SettlePendingCalls(
+          isolate, remaining_ms > 0 ? remaining_ms : 0);
+    }
+    if (!settled_calls) {
+      return;
+    }
+  }
+}
+
 }  // namespace
 
 namespace google::scp::roma::sandbox::js_engine::v8_js_engine {
 
 ExecutionResult V8JsEngine::Init() noexcept {
+  if (!startup_snapshot_.empty()) {
+    v8::StartupData startup_data{startup_snapshot_.data(),
+                                 static_cast<int>(startup_snapshot_.size())};
+    if (!startup_data.IsValid()) {
+      return FailureExecutionResult(
+          SC_ROMA_V8_ENGINE_INVALID_STARTUP_SNAPSHOT);
+    }
+  }
   return SuccessExecutionResult();
 }
 
@@ -175,7 +255,6 @@ ExecutionResult V8JsEngine::Stop() noexcept {
   if (execution_watchdog_) {
     execution_watchdog_->Stop();
   }
-  DisposeIsolate();
   return SuccessExecutionResult();
 }
 
@@ -217,9 +296,7 @@ ExecutionResult V8JsEngine::OneTimeSetup(
   return SuccessExecutionResult();
 }
 
-core::ExecutionResult V8JsEngine::CreateSnapshot(v8::StartupData& startup_data,
-                                                 const string& js_code,
-                                                 string& err_msg) noexcept {
+ExecutionResultOr<string> V8JsEngine::CreateStartupSnapshot() noexcept {
   v8::SnapshotCreator creator(external_references_.data());
   v8::Isolate* isolate = creator.GetIsolate();
 
@@ -230,10 +307,42 @@ core::ExecutionResult V8JsEngine::CreateSnapshot(v8::StartupData& startup_data,
     auto execution_result =
         CreateV8Context(isolate, isolate_visitors_, context);
     RETURN_IF_FAILURE(execution_result);
+    creator.SetDefaultContext(context);
+  }
+  auto startup_data =
+      creator.CreateBlob(v8::SnapshotCreator::FunctionCodeHandling::kClear);
+  string startup_snapshot(startup_data.data, startup_data.raw_size);
+  delete[] startup_data.data;
+  return startup_snapshot;
+}
+
+core::ExecutionResult V8JsEngine::CreateSnapshot(v8::StartupData& startup_data,
+                                                 const string& js_code,
+                                                 string& err_msg) noexcept {
+  // When booted from a startup snapshot, its default context already has the
+  // global object template built in it.
+  v8::StartupData startup_snapshot{startup_snapshot_.data(),
+                                   static_cast<int>(startup_snapshot_.size())};
+  v8::SnapshotCreator creator(
+      external_references_.data(),
+      startup_snapshot_.empty() ? nullptr : &startup_snapshot);
+  v8::Isolate* isolate = creator.GetIsolate();
+
+  {
+    Isolate::Scope isolate_scope(isolate);
+    HandleScope handle_scope(isolate);
+    Local<Context> context;
+    if (startup_snapshot_.empty()) {
+      auto execution_result =
+          CreateV8Context(isolate, isolate_visitors_, context);
+      RETURN_IF_FAILURE(execution_result);
+    } else {
+      context = Context::New(isolate);
+    }
 
     Context::Scope context_scope(context);
     //  Compile and run JavaScript code object.
-    execution_result = ExecutionUtils::CompileRunJS(js_code, err_msg);
+    auto execution_result = ExecutionUtils::CompileRunJS(js_code, err_msg);
     RETURN_IF_FAILURE(execution_result);
 
     // Set above context with compiled and run code as the default context for
@@ -284,15 +393,7 @@ ExecutionResultOr<v8::Isolate*> V8JsEngine::CreateIsolate(
   return isolate;
 }
 
-void V8JsEngine::DisposeIsolate() noexcept {
-  if (v8_isolate_) {
-    v8_isolate_->Dispose();
-    v8_isolate_ = nullptr;
-  }
-}
-
-void V8JsEngine::StartWatchdogTimer(
-    v8::Isolate* isolate,
+int V8JsEngine::GetExecutionTimeoutMs(
     const unordered_map<string, string>& metadata) noexcept {
   // Get the timeout value from metadata. If no timeout tag is set, the
   // default value kDefaultExecutionTimeoutMs will be used.
@@ -308,8 +409,26 @@ void V8JsEngine::StartWatchdogTimer(
                       GetErrorMessage(timeout_int_or.result().status_code));
     }
   }
+  return timeout_ms;
+}
 
-  execution_watchdog_->StartTimer(isolate, timeout_ms);
+void V8JsEngine::StartWatchdogTimer(
+    v8::Isolate* isolate,
+    const unordered_map<string, string>& metadata) noexcept {
+  execution_watchdog_->StartTimer(isolate, GetExecutionTimeoutMs(metadata));
+}
+
+ExecutionResultOr<string> V8JsEngine::GetIoFormat(
+    const unordered_map<string, string>& metadata) noexcept {
+  auto io_format_or = WorkerUtils::GetValueFromMetadata(metadata, kIoFormatTag);
+  if (!io_format_or.result().Successful()) {
+    return string(kIoFormatJson);
+  }
+  if (*io_format_or != kIoFormatJson && *io_format_or != kIoFormatString &&
+      *io_format_or != kIoFormatSerialized) {
+    return FailureExecutionResult(SC_ROMA_V8_ENGINE_INVALID_IO_FORMAT);
+  }
+  return io_format_or;
 }
 
 void V8JsEngine::StopWatchdogTimer() noexcept {
@@ -368,6 +487,53 @@ V8JsEngine::CreateCompilationContext(const string& code,
   return out_context;
 }
 
+ExecutionResult V8JsEngine::CreateExecutionContext(
+    SnapshotCompilationContext& compilation_context,
+    Local<Context>& v8_context, string& err_msg) noexcept {
+  v8_context = Context::New(compilation_context.v8_isolate);
+
+  // Binding UnboundScript to the context when the compilation context is
+  // kUnboundScript.
+  if (compilation_context.cache_type == CacheType::kUnboundScript) {
+    Context::Scope context_scope(v8_context);
+    auto result = ExecutionUtils::BindUnboundScript(
+        compilation_context.unbound_script, err_msg);
+    if (!result.Successful()) {
+      _ROMA_LOG_ERROR(string("BindUnboundScript failed with ") + err_msg);
+      return result;
+    }
+  }
+
+  return SuccessExecutionResult();
+}
+
+void V8JsEngine::FillContextPool(
+    SnapshotCompilationContext& compilation_context,
+    const unordered_map<string, string>& metadata) noexcept {
+  auto v8_isolate = compilation_context.v8_isolate;
+  auto& context_pool = compilation_context.context_pool;
+  if (context_pool.size() >= context_pool_options_.pool_size) {
+    return;
+  }
+
+  Isolate::Scope isolate_scope(v8_isolate);
+  HandleScope handle_scope(v8_isolate);
+
+  // The top-level code of the code version runs in every new context.
+  StartWatchdogTimer(v8_isolate, metadata);
+  while (context_pool.size() < context_pool_options_.pool_size) {
+    Local<Context> v8_context;
+    string err_msg;
+    auto result =
+        CreateExecutionContext(compilation_context, v8_context, err_msg);
+    if (!result.Successful()) {
+      break;
+    }
+    context_pool.push_back({Global<Context>(v8_isolate, v8_context), 0});
+  }
+  StopWatchdogTimer();
+}
+
 ExecutionResultOr<JsEngineExecutionResponse> V8JsEngine::CompileAndRunJs(
     const string& code, const string& function_name,
     const vector<string_view>& input,
@@ -402,28 +568,46 @@ ExecutionResultOr<JsEngineExecutionResponse> V8JsEngine::CompileAndRunJs(
   // No function_name just return execution_response which may contain
   // RomaJsEngineCompilationContext.
   if (function_name.empty()) {
+    // Loading the code version warms up its contexts.
+    FillContextPool(*current_compilation_context, metadata);
     return execution_response;
   }
 
+  auto io_format_or = GetIoFormat(metadata);
+  RETURN_IF_FAILURE(io_format_or.result());
+  const auto& io_format = *io_format_or;
+
   Isolate::Scope isolate_scope(v8_isolate);
   // Create a handle scope to keep the temporary object references.
   HandleScope handle_scope(v8_isolate);
   // Set up an exception handler before calling the Process function
   TryCatch try_catch(v8_isolate);
 
-  Local<Context> v8_context = Context::New(v8_isolate);
-  Context::Scope context_scope(v8_context);
+  // Each phase of the invocation is timed, to be reported in the metrics.
+  Stopwatch phase_stopwatch;
+  phase_stopwatch.Start();
 
-  // Binding UnboundScript to current context when the compilation context is
-  // kUnboundScript.
-  if (current_compilation_context->cache_type == CacheType::kUnboundScript) {
-    auto result = ExecutionUtils::BindUnboundScript(
-        current_compilation_context->unbound_script, err_msg);
+  // A pooled context already has the code evaluated, so only the handler is
+  // left to run.
+  Local<Context> v8_context;
+  size_t context_use_count = 0;
+  auto& context_pool = current_compilation_context->context_pool;
+  if (!context_pool.empty()) {
+    v8_context = Local<Context>::New(v8_isolate, context_pool.back().context);
+    context_use_count = context_pool.back().use_count;
+    context_pool.pop_back();
+  } else {
+    auto result = CreateExecutionContext(*current_compilation_context,
+                                         v8_context, err_msg);
     if (!result.Successful()) {
-      _ROMA_LOG_ERROR(string("BindUnboundScript failed with ") + err_msg);
       return result;
     }
   }
+  Context::Scope context_scope(v8_context);
+  PendingCallsGuard pending_calls_guard(v8_isolate, isolate_visitors_);
+  for (auto& visitor : isolate_visitors_) {
+    visitor->ResetInvocationMetrics();
+  }
 
   Local<Value> handler;
   auto result = ExecutionUtils::GetJsHandler(function_name, handler, err_msg);
@@ -431,16 +615,31 @@ ExecutionResultOr<JsEngineExecutionResponse> V8JsEngine::CompileAndRunJs(
     _ROMA_LOG_ERROR(string("GetJsHandler failed with ") + err_msg);
     return result;
   }
+  auto& metrics = execution_response.metrics;
+  metrics[kExecutionMetricContextSetupNs] = phase_stopwatch.Stop().count();
 
   // Start execution watchdog to timeout the execution if it runs overtime.
   StartWatchdogTimer(v8_isolate, metadata);
+  // End execution_watchdog_ on every return, in case it terminates the cached
+  // isolate while it runs the next invocation.
+  absl::Cleanup stop_watchdog_timer = [this]() { StopWatchdogTimer(); };
+  auto deadline =
+      steady_clock::now() + milliseconds(GetExecutionTimeoutMs(metadata));
 
   string execution_response_string;
   {
     Local<Function> handler_func = handler.As<Function>();
+    phase_stopwatch.Start();
 
     auto argc = input.size();
-    Local<Array> argv_array = ExecutionUtils::ParseAsJsInput(input);
+    Local<Array> argv_array;
+    if (io_format == kIoFormatSerialized) {
+      argv_array = ExecutionUtils::DeserializeAsJsInput(input);
+    } else if (io_format == kIoFormatString) {
+      argv_array = ExecutionUtils::StringsAsJsInput(input);
+    } else {
+      argv_array = ExecutionUtils::ParseAsJsInput(input);
+    }
     // If argv_array size doesn't match with input. Input conversion failed.
     if (argv_array.IsEmpty() || argv_array->Length() != argc) {
       auto exception_result =
@@ -468,7 +667,9 @@ ExecutionResultOr<JsEngineExecutionResponse> V8JsEngine::CompileAndRunJs(
     } else {
       _ROMA_LOG_ERROR("Could not read request ID from metadata.");
     }
+    metrics[kExecutionMetricInputParsingNs] = phase_stopwatch.Stop().count();
 
+    phase_stopwatch.Start();
     Local<Value> result;
     if (!handler_func->Call(v8_context, v8_context->Global(), argc, argv)
              .ToLocal(&result)) {
@@ -477,6 +678,9 @@ ExecutionResultOr<JsEngineExecutionResponse> V8JsEngine::CompileAndRunJs(
     }
 
     if (result->IsPromise()) {
+      auto promise = result.As<v8::Promise>();
+      SettlePromise(v8_isolate, isolate_visitors_, promise, deadline);
+
       string error_msg;
       auto execution_result =
           ExecutionUtils::V8PromiseHandler(v8_isolate, result, error_msg);
@@ -485,61 +689,157 @@ ExecutionResultOr<JsEngineExecutionResponse> V8JsEngine::CompileAndRunJs(
         return GetError(v8_isolate, try_catch, execution_result.status_code);
       }
     }
+    metrics[kExecutionMetricHandlerExecutionNs] =
+        phase_stopwatch.Stop().count();
+
+    phase_stopwatch.Start();
+    if (io_format == kIoFormatSerialized) {
+      if (!ExecutionUtils::SerializeValue(v8_isolate, v8_context, result,
+                                          execution_response_string)) {
+        return GetError(v8_isolate, try_catch,
+                        SC_ROMA_V8_ENGINE_COULD_NOT_SERIALIZE_OUTPUT);
+      }
+    } else {
+      Local<String> result_string;
+      if (io_format == kIoFormatString) {
+        // The handler has to return a string, which is the response as is.
+        if (!result->IsString()) {
+          return GetError(
+              v8_isolate, try_catch,
+              SC_ROMA_V8_ENGINE_COULD_NOT_CONVERT_OUTPUT_TO_STRING);
+        }
+        result_string = result.As<String>();
+      } else if (!JSON::Stringify(v8_context, result)
+                      .ToLocal(&result_string)) {
+        return GetError(v8_isolate, try_catch,
+                        SC_ROMA_V8_ENGINE_COULD_NOT_CONVERT_OUTPUT_TO_JSON);
+      }
 
-    auto result_json_maybe = JSON::Stringify(v8_context, result);
-    Local<String> result_json;
-    if (!result_json_maybe.ToLocal(&result_json)) {
-      return GetError(v8_isolate, try_catch,
-                      SC_ROMA_V8_ENGINE_COULD_NOT_CONVERT_OUTPUT_TO_JSON);
-    }
-
-    auto conversion_worked = TypeConverter<string>::FromV8(
-        v8_isolate, result_json, &execution_response_string);
-    if (!conversion_worked) {
-      return GetError(v8_isolate, try_catch,
-                      SC_ROMA_V8_ENGINE_COULD_NOT_CONVERT_OUTPUT_TO_STRING);
+      auto conversion_worked = TypeConverter<string>::FromV8(
+          v8_isolate, result_string, &execution_response_string);
+      if (!conversion_worked) {
+        return GetError(v8_isolate, try_catch,
+                        SC_ROMA_V8_ENGINE_COULD_NOT_CONVERT_OUTPUT_TO_STRING);
+      }
     }
+    metrics[kExecutionMetricOutputSerializationNs] =
+        phase_stopwatch.Stop().count();
   }
 
   execution_response.response = execution_response_string;
 
-  // End execution_watchdog_ in case it terminate the standby isolate.
-  StopWatchdogTimer();
+  HeapStatistics heap_statistics;
+  v8_isolate->GetHeapStatistics(&heap_statistics);
+  metrics[kExecutionMetricJsHeapUsedBytes] = heap_statistics.used_heap_size();
+  for (auto& visitor : isolate_visitors_) {
+    visitor->AddInvocationMetrics(metrics);
+  }
+
+  // The context pool is filled under a timer of its own.
+  std::move(stop_watchdog_timer).Invoke();
+
+  // The context is only reused after a successful invocation, and replaced
+  // once it served its share of invocations.
+  if (context_pool_options_.pool_size > 0) {
+    if (context_use_count + 1 < context_pool_options_.max_context_uses) {
+      context_pool.push_back(
+          {Global<Context>(v8_isolate, v8_context), context_use_count + 1});
+    }
+    FillContextPool(*current_compilation_context, metadata);
+  }
 
   return execution_response;
 }
 
+ExecutionResultOr<RomaJsEngineCompilationContext>
+V8JsEngine::CreateWasmCompilationContext(const string& code,
+                                         string& err_msg) noexcept {
+  auto isolate_or = CreateIsolate();
+  RETURN_IF_FAILURE(isolate_or.result());
+
+  auto wasm_context = make_shared<WasmCompilationContext>();
+  // Owns the isolate from here on, so that it is disposed on failures.
+  wasm_context->v8_isolate = *isolate_or;
+  auto isolate = wasm_context->v8_isolate;
+
+  {
+    Isolate::Scope isolate_scope(isolate);
+    HandleScope handle_scope(isolate);
+    Local<Context> v8_context;
+    auto execution_result =
+        CreateV8Context(isolate, isolate_visitors_, v8_context);
+    RETURN_IF_FAILURE(execution_result);
+
+    Context::Scope context_scope(v8_context);
+    Local<WasmModuleObject> wasm_module;
+    execution_result = ExecutionUtils::CompileWASM(code, wasm_module, err_msg);
+    RETURN_IF_FAILURE(execution_result);
+
+    // Instantiating reports the errors of the module at load time, as
+    // compiling and running it on every request used to.
+    execution_result = ExecutionUtils::InstantiateWASM(wasm_module, err_msg);
+    RETURN_IF_FAILURE(execution_result);
+
+    wasm_context->wasm_module.Reset(isolate, wasm_module);
+  }
+
+  RomaJsEngineCompilationContext out_context;
+  out_context.has_context = true;
+  out_context.context = wasm_context;
+  return out_context;
+}
+
 ExecutionResultOr<JsEngineExecutionResponse> V8JsEngine::CompileAndRunWasm(
     const string& code, const string& function_name,
     const vector<string_view>& input,
     const std::unordered_map<std::string, std::string>& metadata,
     const RomaJsEngineCompilationContext& context) noexcept {
-  // temp solution for CompileAndRunWasm(). This will update in next PR soon.
-  auto isolate_or = CreateIsolate();
-  RETURN_IF_FAILURE(isolate_or.result());
-  v8_isolate_ = *isolate_or;
+  JsEngineExecutionResponse execution_response;
+  shared_ptr<WasmCompilationContext> current_compilation_context;
+  if (!context.has_context) {
+    string err_msg;
+    auto context_or = CreateWasmCompilationContext(code, err_msg);
+    if (!context_or.result().Successful()) {
+      _ROMA_LOG_ERROR(string("CreateWasmCompilationContext failed with ") +
+                      err_msg);
+      return context_or.result();
+    }
 
-  if (!v8_isolate_) {
+    execution_response.compilation_context = context_or.value();
+    current_compilation_context =
+        std::static_pointer_cast<WasmCompilationContext>(
+            context_or.value().context);
+  } else {
+    execution_response.compilation_context = context;
+    current_compilation_context =
+        std::static_pointer_cast<WasmCompilationContext>(context.context);
+  }
+
+  auto isolate = current_compilation_context->v8_isolate;
+
+  if (!isolate) {
     return FailureExecutionResult(SC_ROMA_V8_ENGINE_ISOLATE_NOT_INITIALIZED);
   }
 
-  // Start execution watchdog to timeout the execution if it runs too long.
-  StartWatchdogTimer(v8_isolate_, metadata);
+  // No function_name just return execution_response which may contain
+  // RomaJsEngineCompilationContext.
+  if (function_name.empty()) {
+    return execution_response;
+  }
 
-  string input_code;
-  RomaJsEngineCompilationContext out_context;
-  // For now we just store and reuse the actual code as context.
-  auto context_code = GetCodeFromContext(context);
-  if (context_code) {
-    input_code = *context_code;
-    out_context = context;
-  } else {
-    input_code = code;
-    out_context.has_context = true;
-    out_context.context = make_shared<string>(code);
+  // The WASM handlers only support JSON inputs and responses.
+  auto io_format_or = GetIoFormat(metadata);
+  RETURN_IF_FAILURE(io_format_or.result());
+  if (*io_format_or != kIoFormatJson) {
+    return FailureExecutionResult(SC_ROMA_V8_ENGINE_INVALID_IO_FORMAT);
   }
 
-  auto isolate = v8_isolate_;
+  // Start execution watchdog to timeout the execution if it runs too long.
+  StartWatchdogTimer(isolate, metadata);
+  // End execution_watchdog_ on every return, in case it terminates the cached
+  // isolate while it runs the next invocation.
+  absl::Cleanup stop_watchdog_timer = [this]() { StopWatchdogTimer(); };
+
   string execution_response_string;
   vector<string> errors;
 
@@ -556,72 +856,68 @@ ExecutionResultOr<JsEngineExecutionResponse> V8JsEngine::CompileAndRunWasm(
     Local<Context> context(isolate->GetCurrentContext());
     TryCatch try_catch(isolate);
 
+    // The module is instantiated from the compiled module of the context,
+    // without recompiling it.
     std::string errors;
-    auto result = ExecutionUtils::CompileRunWASM(input_code, errors);
+    auto result = ExecutionUtils::InstantiateWASM(
+        current_compilation_context->wasm_module.Get(isolate), errors);
     if (!result.Successful()) {
       _ROMA_LOG_ERROR(errors);
       return result;
     }
 
-    if (!function_name.empty()) {
-      Local<Value> wasm_handler;
-      result =
-          ExecutionUtils::GetWasmHandler(function_name, wasm_handler, errors);
-      if (!result.Successful()) {
-        _ROMA_LOG_ERROR(errors);
-        return result;
-      }
+    Local<Value> wasm_handler;
+    result =
+        ExecutionUtils::GetWasmHandler(function_name, wasm_handler, errors);
+    if (!result.Successful()) {
+      _ROMA_LOG_ERROR(errors);
+      return result;
+    }
 
-      auto wasm_input_array =
-          ExecutionUtils::ParseAsWasmInput(v8_isolate_, context, input);
+    auto wasm_input_array =
+        ExecutionUtils::ParseAsWasmInput(isolate, context, input);
 
-      if (wasm_input_array.IsEmpty() ||
-          wasm_input_array->Length() != input.size()) {
-        return GetError(isolate, try_catch,
-                        SC_ROMA_V8_ENGINE_COULD_NOT_PARSE_SCRIPT_INPUT);
-      }
+    if (wasm_input_array.IsEmpty() ||
+        wasm_input_array->Length() != input.size()) {
+      return GetError(isolate, try_catch,
+                      SC_ROMA_V8_ENGINE_COULD_NOT_PARSE_SCRIPT_INPUT);
+    }
 
-      auto input_length = wasm_input_array->Length();
-      Local<Value> wasm_input[input_length];
-      for (size_t i = 0; i < input_length; ++i) {
-        wasm_input[i] = wasm_input_array->Get(context, i).ToLocalChecked();
-      }
+    auto input_length = wasm_input_array->Length();
+    Local<Value> wasm_input[input_length];
+    for (size_t i = 0; i < input_length; ++i) {
+      wasm_input[i] = wasm_input_array->Get(context, i).ToLocalChecked();
+    }
 
-      auto handler_function = wasm_handler.As<Function>();
+    auto handler_function = wasm_handler.As<Function>();
 
-      Local<Value> wasm_result;
-      if (!handler_function
-               ->Call(context, context->Global(), input_length, wasm_input)
-               .ToLocal(&wasm_result)) {
-        return GetError(v8_isolate_, try_catch,
-                        SC_ROMA_V8_ENGINE_ERROR_INVOKING_HANDLER);
-      }
+    Local<Value> wasm_result;
+    if (!handler_function
+             ->Call(context, context->Global(), input_length, wasm_input)
+             .ToLocal(&wasm_result)) {
+      return GetError(isolate, try_catch,
+                      SC_ROMA_V8_ENGINE_ERROR_INVOKING_HANDLER);
+    }
 
-      auto offset = wasm_result.As<Int32>()->Value();
-      auto wasm_execution_output = ExecutionUtils::ReadFromWasmMemory(
-          v8_isolate_, context, offset, WasmDataType::kString);
-      auto result_json_maybe = JSON::Stringify(context, wasm_execution_output);
-      Local<String> result_json;
-      if (!result_json_maybe.ToLocal(&result_json)) {
-        return GetError(v8_isolate_, try_catch,
-                        SC_ROMA_V8_ENGINE_COULD_NOT_CONVERT_OUTPUT_TO_STRING);
-      }
+    auto offset = wasm_result.As<Int32>()->Value();
+    auto wasm_execution_output = ExecutionUtils::ReadFromWasmMemory(
+        isolate, context, offset, WasmDataType::kString);
+    auto result_json_maybe = JSON::Stringify(context, wasm_execution_output);
+    Local<String> result_json;
+    if (!result_json_maybe.ToLocal(&result_json)) {
+      return GetError(isolate, try_catch,
+                      SC_ROMA_V8_ENGINE_COULD_NOT_CONVERT_OUTPUT_TO_STRING);
+    }
 
-      auto conversion_worked = TypeConverter<string>::FromV8(
-          isolate, result_json, &execution_response_string);
-      if (!conversion_worked) {
-        return GetError(isolate, try_catch,
-                        SC_ROMA_V8_ENGINE_COULD_NOT_CONVERT_OUTPUT_TO_STRING);
-      }
+    auto conversion_worked = TypeConverter<string>::FromV8(
+        isolate, result_json, &execution_response_string);
+    if (!conversion_worked) {
+      return GetError(isolate, try_catch,
+                      SC_ROMA_V8_ENGINE_COULD_NOT_CONVERT_OUTPUT_TO_STRING);
     }
   }
 
-  // End execution_watchdog_ in case it terminate the standby isolate.
-  StopWatchdogTimer();
-
-  JsEngineExecutionResponse execution_response;
   execution_response.response = execution_response_string;
-  execution_response.compilation_context = out_context;
 
   return execution_response;
 }
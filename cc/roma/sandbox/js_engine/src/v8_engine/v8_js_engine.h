@@ -35,6 +35,7 @@
 #include "error_codes.h"
 #include "snapshot_compilation_context.h"
 #include "v8_isolate_visitor.h"
+#include "wasm_compilation_context.h"
 
 namespace google::scp::roma::sandbox::js_engine::v8_js_engine {
 /**
@@ -47,9 +48,13 @@ class V8JsEngine : public JsEngine {
       const std::vector<std::shared_ptr<V8IsolateVisitor>>& isolate_visitors =
           std::vector<std::shared_ptr<V8IsolateVisitor>>(),
       const JsEngineResourceConstraints& v8_resource_constraints =
-          JsEngineResourceConstraints())
+          JsEngineResourceConstraints(),
+      const JsContextPoolOptions& context_pool_options = JsContextPoolOptions(),
+      const std::string& startup_snapshot = std::string())
       : isolate_visitors_(isolate_visitors),
         v8_resource_constraints_(v8_resource_constraints),
+        context_pool_options_(context_pool_options),
+        startup_snapshot_(startup_snapshot),
         execution_watchdog_(
             std::make_unique<roma::worker::ExecutionWatchDog>()) {
     for (const auto& visitor : isolate_visitors_) {
@@ -84,6 +89,17 @@ class V8JsEngine : public JsEngine {
       const js_engine::RomaJsEngineCompilationContext& context =
           RomaJsEngineCompilationContext()) noexcept override;
 
+  /**
+   * @brief Creates a startup snapshot whose default context has the global
+   * object template of the isolate visitors, such as the function bindings,
+   * already built in it.
+   *
+   * @return core::ExecutionResultOr<std::string> The snapshot blob, to be
+   * passed to the constructor of the engines to boot from it.
+   */
+  core::ExecutionResultOr<std::string> CreateStartupSnapshot() noexcept
+      override;
+
  private:
   /**
    * @brief Create a Snapshot object
@@ -108,12 +124,70 @@ class V8JsEngine : public JsEngine {
   CreateCompilationContext(const std::string& code,
                            std::string& err_msg) noexcept;
 
+  /**
+   * @brief Create a Wasm Compilation Context object which compiles the module
+   * once in an isolate of its own, and validates that it can be instantiated.
+   *
+   * @param code
+   * @param err_msg
+   * @return core::ExecutionResultOr<js_engine::RomaJsEngineCompilationContext>
+   */
+  core::ExecutionResultOr<js_engine::RomaJsEngineCompilationContext>
+  CreateWasmCompilationContext(const std::string& code,
+                               std::string& err_msg) noexcept;
+
+  /**
+   * @brief Create a context of the compilation context's isolate, with the
+   * code evaluated in it. Must be called within a handle scope of the
+   * isolate.
+   *
+   * @param compilation_context
+   * @param v8_context the created context.
+   * @param err_msg
+   * @return core::ExecutionResult
+   */
+  core::ExecutionResult CreateExecutionContext(
+      SnapshotCompilationContext& compilation_context,
+      v8::Local<v8::Context>& v8_context, std::string& err_msg) noexcept;
+
+  /**
+   * @brief Tops up the pool of contexts of the compilation context to the
+   * configured size. Creating a context runs the top-level code of the code
+   * version, so it is bounded by the timeout of the request, as any other run
+   * of the code.
+   *
+   * @param compilation_context
+   * @param metadata The metadata of the request the pool is filled for.
+   */
+  void FillContextPool(
+      SnapshotCompilationContext& compilation_context,
+      const std::unordered_map<std::string, std::string>& metadata) noexcept;
+
+  /**
+   * @brief Get the IO format of the request from its metadata.
+   *
+   * @param metadata metadata from the request which may contain a
+   * kIoFormatTag. If there is no kIoFormatTag, kIoFormatJson is used.
+   * @return core::ExecutionResultOr<std::string> The IO format, or a failure
+   * if it is not supported.
+   */
+  static core::ExecutionResultOr<std::string> GetIoFormat(
+      const std::unordered_map<std::string, std::string>& metadata) noexcept;
+
   /// @brief Create a v8 isolate instance.
   virtual core::ExecutionResultOr<v8::Isolate*> CreateIsolate(
       const v8::StartupData& startup_data = {nullptr, 0}) noexcept;
 
-  /// @brief Dispose v8 isolate.
-  virtual void DisposeIsolate() noexcept;
+  /**
+   * @brief Get the execution timeout of the request from its metadata.
+   *
+   * @param metadata metadata from the request which may contain a
+   * kTimeoutMsTag. If there is no kTimeoutMsTag, kDefaultExecutionTimeoutMs is
+   * used.
+   * @return int The timeout in milliseconds.
+   */
+  static int GetExecutionTimeoutMs(
+      const std::unordered_map<std::string, std::string>& metadata) noexcept;
 
   /**
    * @brief Start timing the execution running in the isolate with watchdog.
@@ -141,7 +215,6 @@ class V8JsEngine : public JsEngine {
    */
   core::ExecutionResult InitAndRunWatchdog() noexcept;
 
-  v8::Isolate* v8_isolate_ = nullptr;
   const std::vector<std::shared_ptr<V8IsolateVisitor>> isolate_visitors_;
 
   /// @brief These are external references (pointers to data outside of the v8
@@ -154,5 +227,12 @@ class V8JsEngine : public JsEngine {
 
   /// v8 heap resource constraints.
   const JsEngineResourceConstraints v8_resource_constraints_;
+
+  /// The pool of pre-initialized contexts of each compilation context.
+  const JsContextPoolOptions context_pool_options_;
+
+  /// The startup snapshot the code snapshots are built on, if not empty. See
+  /// CreateStartupSnapshot.
+  const std::string startup_snapshot_;
 };
 }  // namespace google::scp::roma::sandbox::js_engine::v8_js_engine
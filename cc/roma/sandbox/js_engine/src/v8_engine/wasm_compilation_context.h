@@ -0,0 +1,43 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "include/v8.h"
+
+namespace google::scp::roma::sandbox::js_engine::v8_js_engine {
+/**
+ * @brief A V8 isolate with a WASM module compiled in it, which is instantiated
+ * in a new context on every execution instead of recompiling the module.
+ *
+ */
+class WasmCompilationContext {
+ public:
+  v8::Isolate* v8_isolate{nullptr};
+
+  /// The compiled module of the code.
+  v8::Global<v8::WasmModuleObject> wasm_module;
+
+  ~WasmCompilationContext() {
+    wasm_module.Reset();
+
+    if (v8_isolate) {
+      v8_isolate->Dispose();
+      v8_isolate = nullptr;
+    }
+  }
+};
+}  // namespace google::scp::roma::sandbox::js_engine::v8_js_engine
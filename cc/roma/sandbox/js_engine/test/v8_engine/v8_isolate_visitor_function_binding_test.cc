@@ -20,6 +20,7 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <gmock/gmock.h>
@@ -29,25 +30,35 @@
 #include "core/test/utils/auto_init_run_stop.h"
 #include "include/v8.h"
 #include "public/core/test/interface/execution_result_matchers.h"
+#include "roma/sandbox/constants/constants.h"
 #include "roma/sandbox/js_engine/src/v8_engine/v8_js_engine.h"
 #include "roma/sandbox/native_function_binding/src/native_function_invoker.h"
 
 using google::scp::core::ExecutionResult;
+using google::scp::core::ExecutionResultOr;
+using google::scp::core::FailureExecutionResult;
 using google::scp::core::SuccessExecutionResult;
+using google::scp::core::TimeDuration;
 using google::scp::core::test::AutoInitRunStop;
 using google::scp::roma::proto::FunctionBindingIoProto;
+using google::scp::roma::sandbox::constants::kExecutionMetricBindingCallCount;
+using google::scp::roma::sandbox::constants::kExecutionMetricBindingWallNs;
 using google::scp::roma::sandbox::js_engine::v8_js_engine::V8IsolateVisitor;
 using google::scp::roma::sandbox::js_engine::v8_js_engine::V8JsEngine;
 using google::scp::roma::sandbox::native_function_binding::
     NativeFunctionInvoker;
 
 using std::make_shared;
+using std::pair;
 using std::shared_ptr;
 using std::string;
 using std::vector;
 using ::testing::_;
+using ::testing::DoAll;
+using ::testing::ElementsAre;
 using ::testing::Ref;
 using testing::Return;
+using testing::SetArgReferee;
 using v8::Context;
 using v8::FunctionCallbackInfo;
 using v8::HandleScope;
@@ -63,9 +74,20 @@ class V8IsolateVisitorFunctionBindingTest : public ::testing::Test {
   }
 };
 
+using CompletedCalls = vector<pair<uint64_t, FunctionBindingIoProto>>;
+
 class NativeFunctionInvokerMock : public NativeFunctionInvoker {
  public:
-  MOCK_METHOD(ExecutionResult, Invoke, (const string&, FunctionBindingIoProto&),
+  MOCK_METHOD(ExecutionResult, Invoke, (uint32_t, FunctionBindingIoProto&),
+              (noexcept, override));
+
+  MOCK_METHOD(ExecutionResultOr<uint64_t>, InvokeAsync,
+              (uint32_t, FunctionBindingIoProto&), (noexcept, override));
+
+  MOCK_METHOD(ExecutionResult, WaitForCompletedCalls,
+              (CompletedCalls&, TimeDuration), (noexcept, override));
+
+  MOCK_METHOD(void, AbandonCalls, (const vector<uint64_t>&),
               (noexcept, override));
 
   virtual ~NativeFunctionInvokerMock() {}
@@ -83,10 +105,281 @@ TEST_F(V8IsolateVisitorFunctionBindingTest,
   V8JsEngine js_engine(isolate_visitors);
   AutoInitRunStop to_handle_engine(js_engine);
 
-  EXPECT_CALL(*function_invoker, Invoke("cool_func", _))
+  EXPECT_CALL(*function_invoker, Invoke(0, _))
+      .WillOnce(Return(SuccessExecutionResult()));
+
+  auto result_or = js_engine.CompileAndRunJs(
+      "function func() { cool_func(); return \"\"; }", "func", {}, {});
+}
+
+TEST_F(V8IsolateVisitorFunctionBindingTest, FunctionsAreCalledByTheirIds) {
+  auto function_invoker = make_shared<NativeFunctionInvokerMock>();
+  vector<string> function_names = {"cool_func", "other_cool_func"};
+  vector<string> async_function_names = {"cool_async_func"};
+  auto visitor = make_shared<v8_js_engine::V8IsolateVisitorFunctionBinding>(
+      function_names, function_invoker, async_function_names);
+  vector<shared_ptr<V8IsolateVisitor>> isolate_visitors;
+  isolate_visitors.push_back(visitor);
+
+  V8JsEngine js_engine(isolate_visitors);
+  AutoInitRunStop to_handle_engine(js_engine);
+
+  FunctionBindingIoProto output_proto;
+  output_proto.set_output_string("output");
+  EXPECT_CALL(*function_invoker, Invoke(1, _))
+      .WillOnce(DoAll(SetArgReferee<1>(output_proto),
+                      Return(SuccessExecutionResult())));
+  EXPECT_CALL(*function_invoker, InvokeAsync(2, _))
+      .WillOnce(Return(ExecutionResultOr<uint64_t>(uint64_t{1})));
+  CompletedCalls completed_calls(1);
+  completed_calls[0].first = 1;
+  completed_calls[0].second = output_proto;
+  EXPECT_CALL(*function_invoker, WaitForCompletedCalls(_, _))
+      .WillOnce(DoAll(SetArgReferee<0>(completed_calls),
+                      Return(SuccessExecutionResult())));
+
+  auto result_or = js_engine.CompileAndRunJs(
+      R"(async function func() {
+        return other_cool_func() + " " + await cool_async_func();
+      })",
+      "func", {}, {});
+  EXPECT_SUCCESS(result_or.result());
+  EXPECT_EQ(result_or->response, "\"output output\"");
+}
+
+TEST_F(V8IsolateVisitorFunctionBindingTest,
+       FunctionsAreCalledByTheIdsTheyWereGiven) {
+  auto function_invoker = make_shared<NativeFunctionInvokerMock>();
+  vector<string> function_names = {"cool_func"};
+  vector<string> async_function_names = {"cool_async_func"};
+  vector<uint32_t> function_ids = {5};
+  vector<uint32_t> async_function_ids = {3};
+  auto visitor = make_shared<v8_js_engine::V8IsolateVisitorFunctionBinding>(
+      function_names, function_invoker, async_function_names, function_ids,
+      async_function_ids);
+  vector<shared_ptr<V8IsolateVisitor>> isolate_visitors;
+  isolate_visitors.push_back(visitor);
+
+  V8JsEngine js_engine(isolate_visitors);
+  AutoInitRunStop to_handle_engine(js_engine);
+
+  FunctionBindingIoProto output_proto;
+  output_proto.set_output_string("output");
+  EXPECT_CALL(*function_invoker, Invoke(5, _))
+      .WillOnce(DoAll(SetArgReferee<1>(output_proto),
+                      Return(SuccessExecutionResult())));
+  EXPECT_CALL(*function_invoker, InvokeAsync(3, _))
+      .WillOnce(Return(ExecutionResultOr<uint64_t>(uint64_t{1})));
+  CompletedCalls completed_calls(1);
+  completed_calls[0].first = 1;
+  completed_calls[0].second = output_proto;
+  EXPECT_CALL(*function_invoker, WaitForCompletedCalls(_, _))
+      .WillOnce(DoAll(SetArgReferee<0>(completed_calls),
+                      Return(SuccessExecutionResult())));
+
+  auto result_or = js_engine.CompileAndRunJs(
+      R"(async function func() {
+        return cool_func() + " " + await cool_async_func();
+      })",
+      "func", {}, {});
+  EXPECT_SUCCESS(result_or.result());
+  EXPECT_EQ(result_or->response, "\"output output\"");
+}
+
+TEST_F(V8IsolateVisitorFunctionBindingTest,
+       CallsOfTheInvocationAreCountedInTheMetrics) {
+  auto function_invoker = make_shared<NativeFunctionInvokerMock>();
+  vector<string> function_names = {"cool_func"};
+  auto visitor = make_shared<v8_js_engine::V8IsolateVisitorFunctionBinding>(
+      function_names, function_invoker);
+  vector<shared_ptr<V8IsolateVisitor>> isolate_visitors;
+  isolate_visitors.push_back(visitor);
+
+  V8JsEngine js_engine(isolate_visitors);
+  AutoInitRunStop to_handle_engine(js_engine);
+
+  FunctionBindingIoProto output_proto;
+  output_proto.set_output_string("output");
+  EXPECT_CALL(*function_invoker, Invoke(0, _))
+      .Times(3)
+      .WillRepeatedly(DoAll(SetArgReferee<1>(output_proto),
+                            Return(SuccessExecutionResult())));
+
+  auto js_code = R"(function func(n) {
+        for (let i = 0; i < n; i++) cool_func();
+        return "";
+      })";
+  auto result_or = js_engine.CompileAndRunJs(js_code, "func", {"2"}, {});
+  EXPECT_SUCCESS(result_or.result());
+  EXPECT_EQ(result_or->metrics.at(kExecutionMetricBindingCallCount), 2);
+  EXPECT_GE(result_or->metrics.at(kExecutionMetricBindingWallNs), 0);
+
+  // The count starts over with each invocation.
+  result_or = js_engine.CompileAndRunJs(js_code, "func", {"1"}, {});
+  EXPECT_SUCCESS(result_or.result());
+  EXPECT_EQ(result_or->metrics.at(kExecutionMetricBindingCallCount), 1);
+}
+
+TEST_F(V8IsolateVisitorFunctionBindingTest,
+       FunctionIsAvailableWhenBootedFromStartupSnapshot) {
+  auto function_invoker = make_shared<NativeFunctionInvokerMock>();
+  vector<string> function_names = {"cool_func"};
+  auto visitor = make_shared<v8_js_engine::V8IsolateVisitorFunctionBinding>(
+      function_names, function_invoker);
+  vector<shared_ptr<V8IsolateVisitor>> isolate_visitors;
+  isolate_visitors.push_back(visitor);
+
+  string startup_snapshot;
+  {
+    V8JsEngine js_engine(isolate_visitors);
+    AutoInitRunStop to_handle_engine(js_engine);
+    auto startup_snapshot_or = js_engine.CreateStartupSnapshot();
+    EXPECT_SUCCESS(startup_snapshot_or.result());
+    startup_snapshot = *startup_snapshot_or;
+  }
+  EXPECT_FALSE(startup_snapshot.empty());
+
+  V8JsEngine js_engine(isolate_visitors, JsEngineResourceConstraints(),
+                       JsContextPoolOptions(), startup_snapshot);
+  AutoInitRunStop to_handle_engine(js_engine);
+
+  EXPECT_CALL(*function_invoker, Invoke(0, _))
       .WillOnce(Return(SuccessExecutionResult()));
 
   auto result_or = js_engine.CompileAndRunJs(
       "function func() { cool_func(); return \"\"; }", "func", {}, {});
+  EXPECT_SUCCESS(result_or.result());
+}
+
+TEST_F(V8IsolateVisitorFunctionBindingTest,
+       AsyncFunctionReturnsPromiseResolvedWithTheOutput) {
+  auto function_invoker = make_shared<NativeFunctionInvokerMock>();
+  vector<string> async_function_names = {"cool_async_func"};
+  auto visitor = make_shared<v8_js_engine::V8IsolateVisitorFunctionBinding>(
+      vector<string>(), function_invoker, async_function_names);
+  vector<shared_ptr<V8IsolateVisitor>> isolate_visitors;
+  isolate_visitors.push_back(visitor);
+
+  V8JsEngine js_engine(isolate_visitors);
+  AutoInitRunStop to_handle_engine(js_engine);
+
+  CompletedCalls completed_calls(2);
+  completed_calls[0].first = 2;
+  completed_calls[0].second.set_output_string("World");
+  completed_calls[1].first = 1;
+  completed_calls[1].second.set_output_string("Hello");
+
+  EXPECT_CALL(*function_invoker, InvokeAsync(0, _))
+      .WillOnce(Return(ExecutionResultOr<uint64_t>(uint64_t{1})))
+      .WillOnce(Return(ExecutionResultOr<uint64_t>(uint64_t{2})));
+  EXPECT_CALL(*function_invoker, WaitForCompletedCalls(_, _))
+      .WillOnce(DoAll(SetArgReferee<0>(completed_calls),
+                      Return(SuccessExecutionResult())));
+
+  auto result_or = js_engine.CompileAndRunJs(
+      R"(async function func() {
+        const outputs = await Promise.all(
+            [cool_async_func("a"), cool_async_func("b")]);
+        return outputs.join(" ");
+      })",
+      "func", {}, {});
+  EXPECT_SUCCESS(result_or.result());
+  EXPECT_EQ(result_or->response, "\"Hello World\"");
+}
+
+TEST_F(V8IsolateVisitorFunctionBindingTest,
+       AsyncFunctionPromiseIsRejectedWhenTheCallFails) {
+  auto function_invoker = make_shared<NativeFunctionInvokerMock>();
+  vector<string> async_function_names = {"cool_async_func"};
+  auto visitor = make_shared<v8_js_engine::V8IsolateVisitorFunctionBinding>(
+      vector<string>(), function_invoker, async_function_names);
+  vector<shared_ptr<V8IsolateVisitor>> isolate_visitors;
+  isolate_visitors.push_back(visitor);
+
+  V8JsEngine js_engine(isolate_visitors);
+  AutoInitRunStop to_handle_engine(js_engine);
+
+  CompletedCalls completed_calls(1);
+  completed_calls[0].first = 1;
+  completed_calls[0].second.add_errors("Failed");
+
+  EXPECT_CALL(*function_invoker, InvokeAsync(0, _))
+      .WillOnce(Return(ExecutionResultOr<uint64_t>(uint64_t{1})));
+  EXPECT_CALL(*function_invoker, WaitForCompletedCalls(_, _))
+      .WillOnce(DoAll(SetArgReferee<0>(completed_calls),
+                      Return(SuccessExecutionResult())));
+
+  auto result_or = js_engine.CompileAndRunJs(
+      R"(async function func() {
+        try {
+          await cool_async_func("a");
+        } catch (error) {
+          return "rejected";
+        }
+        return "resolved";
+      })",
+      "func", {}, {});
+  EXPECT_SUCCESS(result_or.result());
+  EXPECT_EQ(result_or->response, "\"rejected\"");
+}
+
+TEST_F(V8IsolateVisitorFunctionBindingTest,
+       AsyncFunctionPromiseIsRejectedWhenTheCallTimesOut) {
+  auto function_invoker = make_shared<NativeFunctionInvokerMock>();
+  vector<string> async_function_names = {"cool_async_func"};
+  auto visitor = make_shared<v8_js_engine::V8IsolateVisitorFunctionBinding>(
+      vector<string>(), function_invoker, async_function_names);
+  vector<shared_ptr<V8IsolateVisitor>> isolate_visitors;
+  isolate_visitors.push_back(visitor);
+
+  V8JsEngine js_engine(isolate_visitors);
+  AutoInitRunStop to_handle_engine(js_engine);
+
+  EXPECT_CALL(*function_invoker, InvokeAsync(0, _))
+      .WillOnce(Return(ExecutionResultOr<uint64_t>(uint64_t{1})));
+  EXPECT_CALL(*function_invoker, WaitForCompletedCalls(_, _))
+      .WillOnce(Return(FailureExecutionResult(SC_UNKNOWN)));
+  // The call is given up on, so that its response is dropped.
+  EXPECT_CALL(*function_invoker, AbandonCalls(ElementsAre(1)));
+
+  auto result_or = js_engine.CompileAndRunJs(
+      R"(async function func() {
+        try {
+          await cool_async_func("a");
+        } catch (error) {
+          return "rejected";
+        }
+        return "resolved";
+      })",
+      "func", {}, {});
+  EXPECT_SUCCESS(result_or.result());
+  EXPECT_EQ(result_or->response, "\"rejected\"");
+}
+
+TEST_F(V8IsolateVisitorFunctionBindingTest,
+       CallsInFlightAreAbandonedWhenTheInvocationEnds) {
+  auto function_invoker = make_shared<NativeFunctionInvokerMock>();
+  vector<string> async_function_names = {"cool_async_func"};
+  auto visitor = make_shared<v8_js_engine::V8IsolateVisitorFunctionBinding>(
+      vector<string>(), function_invoker, async_function_names);
+  vector<shared_ptr<V8IsolateVisitor>> isolate_visitors;
+  isolate_visitors.push_back(visitor);
+
+  V8JsEngine js_engine(isolate_visitors);
+  AutoInitRunStop to_handle_engine(js_engine);
+
+  EXPECT_CALL(*function_invoker, InvokeAsync(0, _))
+      .WillOnce(Return(ExecutionResultOr<uint64_t>(uint64_t{1})));
+  EXPECT_CALL(*function_invoker, WaitForCompletedCalls(_, _)).Times(0);
+  EXPECT_CALL(*function_invoker, AbandonCalls(ElementsAre(1)));
+
+  auto result_or = js_engine.CompileAndRunJs(
+      R"(async function func() {
+        cool_async_func("a");
+        return "done";
+      })",
+      "func", {}, {});
+  EXPECT_SUCCESS(result_or.result());
+  EXPECT_EQ(result_or->response, "\"done\"");
 }
 }  // namespace google::scp::roma::sandbox::js_engine::test
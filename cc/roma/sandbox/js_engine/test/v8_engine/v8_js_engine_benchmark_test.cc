@@ -0,0 +1,130 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/common/time_provider/src/time_provider.h"
+#include "core/test/utils/auto_init_run_stop.h"
+#include "public/core/test/interface/execution_result_matchers.h"
+#include "roma/sandbox/js_engine/src/v8_engine/v8_js_engine.h"
+
+using absl::string_view;
+using google::scp::core::common::TimeProvider;
+using google::scp::core::test::AutoInitRunStop;
+using google::scp::roma::kIoFormatJson;
+using google::scp::roma::kIoFormatSerialized;
+using google::scp::roma::kIoFormatString;
+using google::scp::roma::kIoFormatTag;
+using google::scp::roma::sandbox::js_engine::v8_js_engine::V8JsEngine;
+using std::cout;
+using std::endl;
+using std::string;
+using std::to_string;
+using std::unordered_map;
+using std::vector;
+
+namespace google::scp::roma::sandbox::js_engine::test {
+class V8JsEngineBenchmarkTest : public ::testing::Test {
+ public:
+  static void SetUpTestSuite() {
+    V8JsEngine engine;
+    engine.OneTimeSetup();
+  }
+};
+
+/**
+ * @brief Runs a handler echoing a structured payload of about payload_size
+ * bytes of JSON text, and reports the average time of an invocation with each
+ * IO format.
+ */
+static void RunEchoWorkload(size_t payload_size) {
+  constexpr size_t kIterationCount = 100;
+
+  V8JsEngine engine;
+  AutoInitRunStop to_handle_engine(engine);
+
+  // Each record takes about 100 bytes of JSON text.
+  auto js_code = R"JS_CODE(
+    function MakePayload() {
+      const records = [];
+      for (let i = 0; i < )JS_CODE" +
+                 to_string(payload_size / 100) + R"JS_CODE(; i++) {
+        records.push({
+          id: i,
+          name: "record-" + i,
+          score: i / 7,
+          tags: ["alpha", "beta"],
+          active: i % 2 == 0,
+        });
+      }
+      return { records: records };
+    }
+    function Echo(payload) { return payload; }
+  )JS_CODE";
+  auto load_response_or =
+      engine.CompileAndRunJs(js_code, "", {} /*input*/, {} /*metadata*/);
+  ASSERT_SUCCESS(load_response_or.result());
+  auto compilation_context = load_response_or->compilation_context;
+
+  for (auto io_format : {kIoFormatJson, kIoFormatString, kIoFormatSerialized}) {
+    unordered_map<string, string> metadata = {{kIoFormatTag, io_format}};
+    // The string format takes the JSON text as an opaque string.
+    unordered_map<string, string> make_metadata = {
+        {kIoFormatTag,
+         io_format == kIoFormatSerialized ? kIoFormatSerialized
+                                          : kIoFormatJson}};
+    auto payload_or =
+        engine.CompileAndRunJs("" /*code*/, "MakePayload", {} /*input*/,
+                               make_metadata, compilation_context);
+    ASSERT_SUCCESS(payload_or.result());
+    auto payload = payload_or->response;
+    vector<string_view> input = {payload};
+
+    auto start = TimeProvider::GetSteadyTimestampInNanoseconds();
+    for (size_t i = 0; i < kIterationCount; i++) {
+      auto response_or = engine.CompileAndRunJs(
+          "" /*code*/, "Echo", input, metadata, compilation_context);
+      ASSERT_SUCCESS(response_or.result());
+    }
+    auto elapsed_ns =
+        (TimeProvider::GetSteadyTimestampInNanoseconds() - start).count();
+
+    cout << io_format << " IO format, " << payload.size()
+         << " bytes payload: " << elapsed_ns / kIterationCount / 1000
+         << " us per invocation" << endl;
+  }
+}
+
+TEST_F(V8JsEngineBenchmarkTest, EchoOneKilobytePayload) {
+  GTEST_SKIP();
+  RunEchoWorkload(1024);
+}
+
+TEST_F(V8JsEngineBenchmarkTest, EchoOneHundredKilobytePayload) {
+  GTEST_SKIP();
+  RunEchoWorkload(100 * 1024);
+}
+
+TEST_F(V8JsEngineBenchmarkTest, EchoOneMegabytePayload) {
+  GTEST_SKIP();
+  RunEchoWorkload(1024 * 1024);
+}
+}  // namespace google::scp::roma::sandbox::js_engine::test
@@ -18,26 +18,51 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <iostream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "core/test/utils/auto_init_run_stop.h"
 #include "public/core/test/interface/execution_result_matchers.h"
+#include "roma/sandbox/constants/constants.h"
 #include "roma/wasm/test/testing_utils.h"
 
 using absl::string_view;
 using google::scp::core::FailureExecutionResult;
+using google::scp::core::errors::
+    SC_ROMA_V8_ENGINE_COULD_NOT_CONVERT_OUTPUT_TO_STRING;
 using google::scp::core::errors::SC_ROMA_V8_ENGINE_COULD_NOT_PARSE_SCRIPT_INPUT;
 using google::scp::core::errors::SC_ROMA_V8_ENGINE_ERROR_INVOKING_HANDLER;
+using google::scp::core::errors::SC_ROMA_V8_ENGINE_INVALID_IO_FORMAT;
+using google::scp::core::errors::SC_ROMA_V8_ENGINE_INVALID_STARTUP_SNAPSHOT;
 using google::scp::core::errors::SC_ROMA_V8_WORKER_CODE_COMPILE_FAILURE;
 using google::scp::core::test::AutoInitRunStop;
 using google::scp::core::test::ResultIs;
 using google::scp::roma::kDefaultExecutionTimeoutMs;
+using google::scp::roma::kIoFormatSerialized;
+using google::scp::roma::kIoFormatString;
+using google::scp::roma::kIoFormatTag;
 using google::scp::roma::kTimeoutMsTag;
+using google::scp::roma::sandbox::constants::kExecutionMetricContextSetupNs;
+using google::scp::roma::sandbox::constants::
+    kExecutionMetricHandlerExecutionNs;
+using google::scp::roma::sandbox::constants::kExecutionMetricInputParsingNs;
+using google::scp::roma::sandbox::constants::kExecutionMetricJsHeapUsedBytes;
+using google::scp::roma::sandbox::constants::
+    kExecutionMetricOutputSerializationNs;
+using std::cout;
+using std::endl;
 using std::string;
 using std::unordered_map;
 using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+using std::this_thread::sleep_for;
 
 using google::scp::roma::sandbox::js_engine::v8_js_engine::V8JsEngine;
 using google::scp::roma::wasm::testing::WasmTestingUtils;
@@ -67,6 +92,105 @@ TEST_F(V8JsEngineTest, CanRunJsCode) {
   EXPECT_EQ(response_string, "\"Hello World! vec input 1 vec input 2\"");
 }
 
+TEST_F(V8JsEngineTest, ReportsTheMetricsOfTheInvocation) {
+  V8JsEngine engine;
+  AutoInitRunStop to_handle_engine(engine);
+
+  auto js_code = "function hello_js(input) { return \"Hello \" + input; }";
+  vector<string_view> input = {"\"World!\""};
+  auto response_or =
+      engine.CompileAndRunJs(js_code, "hello_js", input, {} /*metadata*/);
+
+  EXPECT_SUCCESS(response_or.result());
+  auto& metrics = response_or->metrics;
+  for (auto metric :
+       {kExecutionMetricContextSetupNs, kExecutionMetricInputParsingNs,
+        kExecutionMetricHandlerExecutionNs,
+        kExecutionMetricOutputSerializationNs}) {
+    ASSERT_NE(metrics.find(metric), metrics.end()) << metric;
+    EXPECT_GE(metrics.at(metric), 0);
+  }
+  ASSERT_NE(metrics.find(kExecutionMetricJsHeapUsedBytes), metrics.end());
+  EXPECT_GT(metrics.at(kExecutionMetricJsHeapUsedBytes), 0);
+}
+
+TEST_F(V8JsEngineTest, CanRunJsCodeWhenBootedFromStartupSnapshot) {
+  string startup_snapshot;
+  {
+    V8JsEngine engine;
+    AutoInitRunStop to_handle_engine(engine);
+    auto startup_snapshot_or = engine.CreateStartupSnapshot();
+    EXPECT_SUCCESS(startup_snapshot_or.result());
+    startup_snapshot = *startup_snapshot_or;
+  }
+
+  V8JsEngine engine({}, JsEngineResourceConstraints(), JsContextPoolOptions(),
+                    startup_snapshot);
+  AutoInitRunStop to_handle_engine(engine);
+
+  auto js_code = "function hello_js(input) { return \"Hello \" + input; }";
+  vector<string_view> input = {"\"World!\""};
+  auto response_or =
+      engine.CompileAndRunJs(js_code, "hello_js", input, {} /*metadata*/);
+
+  EXPECT_SUCCESS(response_or.result());
+  EXPECT_EQ(response_or->response, "\"Hello World!\"");
+}
+
+TEST_F(V8JsEngineTest, ShouldFailToInitWithInvalidStartupSnapshot) {
+  V8JsEngine engine({}, JsEngineResourceConstraints(), JsContextPoolOptions(),
+                    "not a snapshot");
+
+  EXPECT_THAT(engine.Init(), ResultIs(FailureExecutionResult(
+                                 SC_ROMA_V8_ENGINE_INVALID_STARTUP_SNAPSHOT)));
+}
+
+TEST_F(V8JsEngineTest, CanRunJsCodeOnPooledContexts) {
+  JsContextPoolOptions context_pool_options;
+  context_pool_options.pool_size = 1;
+  context_pool_options.max_context_uses = 2;
+  V8JsEngine engine({} /*isolate_visitors*/, JsEngineResourceConstraints(),
+                    context_pool_options);
+  AutoInitRunStop to_handle_engine(engine);
+
+  // The global state shows which context ran the handler.
+  auto js_code = "var calls = 0; function Handler() { return ++calls; }";
+  auto load_response_or =
+      engine.CompileAndRunJs(js_code, "", {} /*input*/, {} /*metadata*/);
+  EXPECT_SUCCESS(load_response_or.result());
+  auto compilation_context = load_response_or->compilation_context;
+
+  vector<string> responses;
+  for (int i = 0; i < 5; i++) {
+    auto response_or =
+        engine.CompileAndRunJs("" /*code*/, "Handler", {} /*input*/,
+                               {} /*metadata*/, compilation_context);
+    EXPECT_SUCCESS(response_or.result());
+    responses.push_back(response_or->response);
+  }
+  // Each context serves two invocations before it is replaced.
+  EXPECT_EQ(responses, vector<string>({"1", "2", "1", "2", "1"}));
+}
+
+TEST_F(V8JsEngineTest, RunsEachInvocationOnANewContextWithoutAPool) {
+  V8JsEngine engine;
+  AutoInitRunStop to_handle_engine(engine);
+
+  auto js_code = "var calls = 0; function Handler() { return ++calls; }";
+  auto load_response_or =
+      engine.CompileAndRunJs(js_code, "", {} /*input*/, {} /*metadata*/);
+  EXPECT_SUCCESS(load_response_or.result());
+  auto compilation_context = load_response_or->compilation_context;
+
+  for (int i = 0; i < 3; i++) {
+    auto response_or =
+        engine.CompileAndRunJs("" /*code*/, "Handler", {} /*input*/,
+                               {} /*metadata*/, compilation_context);
+    EXPECT_SUCCESS(response_or.result());
+    EXPECT_EQ(response_or->response, "1");
+  }
+}
+
 TEST_F(V8JsEngineTest, CanRunAsyncJsCodeReturningPromiseExplicitly) {
   V8JsEngine engine;
   AutoInitRunStop to_handle_engine(engine);
@@ -209,6 +333,93 @@ TEST_F(V8JsEngineTest, ShouldFailIfInputIsBadJsonInput) {
                   SC_ROMA_V8_ENGINE_COULD_NOT_PARSE_SCRIPT_INPUT)));
 }
 
+TEST_F(V8JsEngineTest, CanRunCodeRequestWithStringInputAndOutput) {
+  V8JsEngine engine;
+  AutoInitRunStop to_handle_engine(engine);
+
+  auto js_code = "function Handler(a, b) { return a + b; }";
+  // The inputs are not JSON, and are not parsed.
+  vector<string_view> input = {"{\"value\":", "1"};
+  auto response_or = engine.CompileAndRunJs(
+      js_code, "Handler", input, {{kIoFormatTag, kIoFormatString}});
+
+  EXPECT_SUCCESS(response_or.result());
+  EXPECT_EQ(response_or->response, "{\"value\":1");
+}
+
+TEST_F(V8JsEngineTest, ShouldFailIfStringOutputIsNotAString) {
+  V8JsEngine engine;
+  AutoInitRunStop to_handle_engine(engine);
+
+  auto js_code = "function Handler(a) { return { value: a }; }";
+  vector<string_view> input = {"1"};
+  auto response_or = engine.CompileAndRunJs(
+      js_code, "Handler", input, {{kIoFormatTag, kIoFormatString}});
+
+  EXPECT_THAT(response_or.result(),
+              ResultIs(FailureExecutionResult(
+                  SC_ROMA_V8_ENGINE_COULD_NOT_CONVERT_OUTPUT_TO_STRING)));
+}
+
+TEST_F(V8JsEngineTest, CanRunCodeRequestWithSerializedInputAndOutput) {
+  V8JsEngine engine;
+  AutoInitRunStop to_handle_engine(engine);
+
+  auto js_code = R"JS_CODE(
+    function Make() { return { values: [1, 2], date: new Date(0) }; }
+    function Add(a, b) {
+      return { values: a.values.concat(b.values), date: a.date };
+    }
+    function Describe(a) {
+      return a.values.join(",") + " " + a.date.toISOString();
+    }
+    function Expected() { return "1,2,1,2 1970-01-01T00:00:00.000Z"; }
+  )JS_CODE";
+  unordered_map<string, string> metadata = {
+      {kIoFormatTag, kIoFormatSerialized}};
+  auto run = [&](const string& handler_name,
+                 const vector<string_view>& input) {
+    auto response_or =
+        engine.CompileAndRunJs(js_code, handler_name, input, metadata);
+    EXPECT_SUCCESS(response_or.result());
+    return response_or->response;
+  };
+
+  // The values keep their types, which JSON would not, as they go through
+  // the blobs.
+  auto made = run("Make", {});
+  auto added = run("Add", {made, made});
+  EXPECT_EQ(run("Describe", {added}), run("Expected", {}));
+}
+
+TEST_F(V8JsEngineTest, ShouldFailIfSerializedInputIsInvalid) {
+  V8JsEngine engine;
+  AutoInitRunStop to_handle_engine(engine);
+
+  auto js_code = "function Handler(a) { return a; }";
+  vector<string_view> input = {"{\"value\":1}"};
+  auto response_or = engine.CompileAndRunJs(
+      js_code, "Handler", input, {{kIoFormatTag, kIoFormatSerialized}});
+
+  EXPECT_THAT(response_or.result(),
+              ResultIs(FailureExecutionResult(
+                  SC_ROMA_V8_ENGINE_COULD_NOT_PARSE_SCRIPT_INPUT)));
+}
+
+TEST_F(V8JsEngineTest, ShouldFailIfIoFormatIsNotSupported) {
+  V8JsEngine engine;
+  AutoInitRunStop to_handle_engine(engine);
+
+  auto js_code = "function Handler(a) { return a; }";
+  vector<string_view> input = {"1"};
+  auto response_or = engine.CompileAndRunJs(js_code, "Handler", input,
+                                            {{kIoFormatTag, "Xml"}});
+
+  EXPECT_THAT(
+      response_or.result(),
+      ResultIs(FailureExecutionResult(SC_ROMA_V8_ENGINE_INVALID_IO_FORMAT)));
+}
+
 TEST_F(V8JsEngineTest, ShouldSucceedWithEmptyResponseIfHandlerNameIsEmpty) {
   V8JsEngine engine;
   AutoInitRunStop to_handle_engine(engine);
@@ -280,6 +491,56 @@ TEST_F(V8JsEngineTest, CanRunWasmCode) {
   EXPECT_EQ(response_string, "\"Some input string Hello World from WASM\"");
 }
 
+TEST_F(V8JsEngineTest, CanRunWasmCodeFromTheCompilationContext) {
+  V8JsEngine engine;
+  AutoInitRunStop to_handle_engine(engine);
+
+  auto wasm_bin = WasmTestingUtils::LoadWasmFile(
+      "./cc/roma/testing/cpp_wasm_string_in_string_out_example/"
+      "string_in_string_out.wasm");
+
+  auto wasm_code =
+      string(reinterpret_cast<char*>(wasm_bin.data()), wasm_bin.size());
+  vector<string_view> input = {"\"Some input string\""};
+
+  // Loading compiles the module into the compilation context.
+  auto load_response_or =
+      engine.CompileAndRunWasm(wasm_code, "", input, {} /*metadata*/);
+  EXPECT_SUCCESS(load_response_or.result());
+  auto compilation_context = load_response_or->compilation_context;
+  EXPECT_TRUE(compilation_context.has_context);
+
+  // Reports the latency of an invocation with and without the compiled
+  // module, which used to be recompiled in a new isolate every time.
+  constexpr int kInvocationCount = 20;
+  auto start = steady_clock::now();
+  for (int i = 0; i < kInvocationCount; i++) {
+    auto response_or = engine.CompileAndRunWasm(wasm_code, "Handler", input,
+                                                {} /*metadata*/);
+    EXPECT_SUCCESS(response_or.result());
+  }
+  auto uncached_us =
+      duration_cast<microseconds>(steady_clock::now() - start).count() /
+      kInvocationCount;
+
+  start = steady_clock::now();
+  for (int i = 0; i < kInvocationCount; i++) {
+    auto response_or =
+        engine.CompileAndRunWasm("" /*code*/, "Handler", input,
+                                 {} /*metadata*/, compilation_context);
+    EXPECT_SUCCESS(response_or.result());
+    EXPECT_EQ(response_or->response,
+              "\"Some input string Hello World from WASM\"");
+  }
+  auto cached_us =
+      duration_cast<microseconds>(steady_clock::now() - start).count() /
+      kInvocationCount;
+
+  cout << "WASM invocation latency: " << uncached_us
+       << " us compiling the module, " << cached_us
+       << " us from the compilation context" << endl;
+}
+
 TEST_F(V8JsEngineTest, WasmShouldSucceedWithEmptyResponseIfHandlerNameIsEmpty) {
   V8JsEngine engine;
   AutoInitRunStop to_handle_engine(engine);
@@ -320,6 +581,40 @@ TEST_F(V8JsEngineTest, WasmShouldFailIfInputCannotBeParsed) {
   EXPECT_FALSE(response_or.result().Successful());
 }
 
+TEST_F(V8JsEngineTest, FailedWasmCallDoesNotTimeOutTheNextCall) {
+  V8JsEngine engine;
+  AutoInitRunStop to_handle_engine(engine);
+
+  auto wasm_bin = WasmTestingUtils::LoadWasmFile(
+      "./cc/roma/testing/cpp_wasm_string_in_string_out_example/"
+      "string_in_string_out.wasm");
+
+  auto wasm_code =
+      string(reinterpret_cast<char*>(wasm_bin.data()), wasm_bin.size());
+  auto load_response_or =
+      engine.CompileAndRunWasm(wasm_code, "", {}, {} /*metadata*/);
+  EXPECT_SUCCESS(load_response_or.result());
+  auto compilation_context = load_response_or->compilation_context;
+
+  unordered_map<string, string> metadata;
+  metadata[kTimeoutMsTag] = "100";
+  vector<string_view> bad_input = {"\"Some input string"};
+  auto response_or = engine.CompileAndRunWasm(
+      "" /*code*/, "Handler", bad_input, metadata, compilation_context);
+  EXPECT_FALSE(response_or.result().Successful());
+
+  // The timer of the failed call would have expired by now, and terminated
+  // the isolate of the compilation context.
+  sleep_for(milliseconds(300));
+
+  vector<string_view> input = {"\"Some input string\""};
+  response_or = engine.CompileAndRunWasm("" /*code*/, "Handler", input,
+                                         {} /*metadata*/, compilation_context);
+  EXPECT_SUCCESS(response_or.result());
+  EXPECT_EQ(response_or->response,
+            "\"Some input string Hello World from WASM\"");
+}
+
 TEST_F(V8JsEngineTest, WasmShouldFailIfBadWasm) {
   V8JsEngine engine;
   AutoInitRunStop to_handle_engine(engine);
@@ -39,6 +39,16 @@ DEFINE_ERROR_CODE(
     "Could not receive a response from the parent process.",
     HttpStatusCode::BAD_REQUEST)
 
+DEFINE_ERROR_CODE(SC_ROMA_FUNCTION_INVOKER_SAPI_IPC_NO_CALLS_IN_FLIGHT,
+                  SC_ROMA_FUNCTION_INVOKER_SAPI_IPC, 0x0004,
+                  "There are no async calls in flight to wait for.",
+                  HttpStatusCode::BAD_REQUEST)
+
+DEFINE_ERROR_CODE(SC_ROMA_FUNCTION_INVOKER_SAPI_IPC_TIMED_OUT_WAITING_FOR_CALLS,
+                  SC_ROMA_FUNCTION_INVOKER_SAPI_IPC, 0x0005,
+                  "Timed out waiting for the async calls in flight.",
+                  HttpStatusCode::REQUEST_TIMEOUT)
+
 REGISTER_COMPONENT_CODE(SC_ROMA_FUNCTION_TABLE, 0x0CC0)
 
 DEFINE_ERROR_CODE(SC_ROMA_FUNCTION_TABLE_COULD_NOT_FIND_FUNCTION_NAME,
@@ -57,4 +67,9 @@ DEFINE_ERROR_CODE(
     0x0003,
     "A function with this name has already been registered in the table.",
     HttpStatusCode::BAD_REQUEST)
+
+DEFINE_ERROR_CODE(SC_ROMA_FUNCTION_TABLE_COULD_NOT_FIND_FUNCTION_ID,
+                  SC_ROMA_FUNCTION_TABLE, 0x0004,
+                  "Could not find the function by ID in the table.",
+                  HttpStatusCode::BAD_REQUEST)
 }  // namespace google::scp::core::errors
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "function_binding_frame.h"
+
+#include <cstring>
+#include <vector>
+
+using google::scp::roma::proto::FunctionBindingIoProto;
+using std::memcpy;
+using std::vector;
+
+namespace {
+constexpr size_t kFunctionIdOffset = 0;
+constexpr size_t kCallIdOffset = kFunctionIdOffset + sizeof(uint32_t);
+constexpr size_t kHeaderSize = kCallIdOffset + sizeof(uint64_t);
+
+/// The frame buffer of the thread, which is reused across the frames it sends
+/// and receives.
+vector<uint8_t>& GetFrameBuffer() {
+  thread_local vector<uint8_t> frame_buffer;
+  return frame_buffer;
+}
+}  // namespace
+
+namespace google::scp::roma::sandbox::native_function_binding {
+bool FunctionBindingFrame::Send(
+    sandbox2::Comms& comms, const Header& header,
+    const FunctionBindingIoProto& function_binding_proto) noexcept {
+  auto& frame = GetFrameBuffer();
+  auto proto_size = function_binding_proto.ByteSizeLong();
+  frame.resize(kHeaderSize + proto_size);
+  // Both ends of the channel run on the same host, so the IDs are copied in
+  // its byte order.
+  memcpy(frame.data() + kFunctionIdOffset, &header.function_id,
+         sizeof(header.function_id));
+  memcpy(frame.data() + kCallIdOffset, &header.call_id,
+         sizeof(header.call_id));
+  function_binding_proto.SerializeWithCachedSizesToArray(frame.data() +
+                                                         kHeaderSize);
+  return comms.SendTLV(kTag, frame.size(), frame.data());
+}
+
+bool FunctionBindingFrame::Receive(
+    sandbox2::Comms& comms, Header& header,
+    FunctionBindingIoProto& function_binding_proto) noexcept {
+  auto& frame = GetFrameBuffer();
+  uint32_t tag;
+  if (!comms.RecvTLV(&tag, &frame) || tag != kTag ||
+      frame.size() < kHeaderSize) {
+    return false;
+  }
+  memcpy(&header.function_id, frame.data() + kFunctionIdOffset,
+         sizeof(header.function_id));
+  memcpy(&header.call_id, frame.data() + kCallIdOffset,
+         sizeof(header.call_id));
+  return function_binding_proto.ParseFromArray(frame.data() + kHeaderSize,
+                                               frame.size() - kHeaderSize);
+}
+}  // namespace google::scp::roma::sandbox::native_function_binding
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "cc/roma/interface/function_binding_io.pb.h"
+#include "sandboxed_api/sandbox2/comms.h"
+
+namespace google::scp::roma::sandbox::native_function_binding {
+/**
+ * @brief The frame in which the function binding calls and their responses
+ * are exchanged over the comms channel. A fixed size header carries the ID of
+ * the function and the ID of the call, and is followed by the serialized
+ * FunctionBindingIoProto. Neither ID is looked up by name in the metadata.
+ *
+ */
+class FunctionBindingFrame {
+ public:
+  /// The TLV tag of the frames on the comms channel.
+  static constexpr uint32_t kTag = 0x0000F001;
+
+  struct Header {
+    /// The ID of the function, which the function table assigned to it.
+    uint32_t function_id = 0;
+    /// The ID of the call, which the response carries back.
+    uint64_t call_id = 0;
+  };
+
+  /**
+   * @brief Send a frame over the comms channel.
+   *
+   * @param comms The comms channel.
+   * @param header The header of the frame.
+   * @param function_binding_proto The payload of the frame.
+   * @return Whether the frame was sent.
+   */
+  static bool Send(
+      sandbox2::Comms& comms, const Header& header,
+      const proto::FunctionBindingIoProto& function_binding_proto) noexcept;
+
+  /**
+   * @brief Receive a frame from the comms channel, blocking until one
+   * arrives.
+   *
+   * @param comms The comms channel.
+   * @param[out] header The header of the frame.
+   * @param[out] function_binding_proto The payload of the frame.
+   * @return Whether a valid frame was received.
+   */
+  static bool Receive(
+      sandbox2::Comms& comms, Header& header,
+      proto::FunctionBindingIoProto& function_binding_proto) noexcept;
+};
+}  // namespace google::scp::roma::sandbox::native_function_binding
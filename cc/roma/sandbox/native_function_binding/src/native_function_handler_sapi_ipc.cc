@@ -17,24 +17,26 @@
 #include "native_function_handler_sapi_ipc.h"
 
 #include <memory>
-#include <string>
+#include <mutex>
 #include <vector>
 
-#include "roma/sandbox/constants/constants.h"
+#include "error_codes.h"
+#include "function_binding_frame.h"
 
 using google::scp::core::ExecutionResult;
 using google::scp::core::SuccessExecutionResult;
-using google::scp::roma::sandbox::constants::
-    kFuctionBindingMetadataFunctionName;
+using google::scp::core::errors::
+    SC_ROMA_FUNCTION_TABLE_COULD_NOT_FIND_FUNCTION_ID;
+using std::lock_guard;
 using std::make_shared;
+using std::mutex;
 using std::shared_ptr;
-using std::string;
 using std::vector;
 
 static constexpr char kFailedNativeHandlerExecution[] =
     "ROMA: Failed to execute the C++ function.";
-static constexpr char kCouldNotFindFunctionName[] =
-    "ROMA: Could not find C++ function by name.";
+static constexpr char kCouldNotFindFunction[] =
+    "ROMA: Could not find C++ function by ID.";
 
 namespace google::scp::roma::sandbox::native_function_binding {
 NativeFunctionHandlerSapiIpc::NativeFunctionHandlerSapiIpc(
@@ -46,6 +48,7 @@ NativeFunctionHandlerSapiIpc::NativeFunctionHandlerSapiIpc(
 
   for (int i = 0; i < process_count; i++) {
     ipc_comms_.push_back(make_shared<sandbox2::Comms>(local_fds.at(i)));
+    send_mutexes_.push_back(make_shared<mutex>());
   }
 
   remote_fds_ = remote_fds;
@@ -60,10 +63,15 @@ ExecutionResult NativeFunctionHandlerSapiIpc::Run() noexcept {
     function_handler_threads_.emplace_back([this, i] {
       while (true) {
         auto comms = ipc_comms_.at(i);
-        proto::FunctionBindingIoProto io_proto;
+        auto send_mutex = send_mutexes_.at(i);
+        // Async calls complete after the next calls are received, so the proto
+        // is kept alive until the response is sent.
+        auto io_proto = make_shared<proto::FunctionBindingIoProto>();
+        FunctionBindingFrame::Header header;
 
         // This unblocks once a call is issued from the other side
-        bool received = comms->RecvProtoBuf(&io_proto);
+        bool received =
+            FunctionBindingFrame::Receive(*comms, header, *io_proto);
 
         if (stop_.load()) {
           break;
@@ -73,23 +81,23 @@ ExecutionResult NativeFunctionHandlerSapiIpc::Run() noexcept {
           continue;
         }
 
-        // Get function name
-        string function_name;
-        if (io_proto.metadata().find(kFuctionBindingMetadataFunctionName) ==
-            io_proto.metadata().end()) {
-          // If we can't find the function, add errors to the proto to return
-          io_proto.mutable_errors()->Add(kCouldNotFindFunctionName);
-        } else {
-          function_name =
-              io_proto.metadata().at(kFuctionBindingMetadataFunctionName);
-          if (!function_table_->Call(function_name, io_proto).Successful()) {
-            // If execution failed, add errors to the proto to return
-            io_proto.mutable_errors()->Add(kFailedNativeHandlerExecution);
-          }
-        }
-
-        if (!comms->SendProtoBuf(io_proto)) {
-          continue;
+        // The response carries the call ID of the request back.
+        auto send_response = [comms, send_mutex, header, io_proto]() {
+          lock_guard<mutex> lock(*send_mutex);
+          FunctionBindingFrame::Send(*comms, header, *io_proto);
+        };
+
+        auto result =
+            function_table_->Call(header.function_id, *io_proto, send_response);
+        if (!result.Successful()) {
+          // If the function is not found or its execution failed, add errors
+          // to the proto to return
+          io_proto->mutable_errors()->Add(
+              result.status_code ==
+                      SC_ROMA_FUNCTION_TABLE_COULD_NOT_FIND_FUNCTION_ID
+                  ? kCouldNotFindFunction
+                  : kFailedNativeHandlerExecution);
+          send_response();
         }
       }
     });
@@ -106,7 +114,8 @@ ExecutionResult NativeFunctionHandlerSapiIpc::Stop() noexcept {
   for (auto fd : remote_fds_) {
     sandbox2::Comms remote_comms(fd);
     proto::FunctionBindingIoProto io_proto;
-    remote_comms.SendProtoBuf(io_proto);
+    FunctionBindingFrame::Send(remote_comms, FunctionBindingFrame::Header(),
+                               io_proto);
   }
 
   // Wait for the function binding threads to stop before terminating the comms
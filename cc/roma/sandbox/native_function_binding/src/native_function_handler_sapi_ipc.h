@@ -18,6 +18,7 @@
 
 #include <atomic>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -55,6 +56,9 @@ class NativeFunctionHandlerSapiIpc : public core::ServiceInterface {
   std::shared_ptr<NativeFunctionTable> function_table_;
   std::vector<std::thread> function_handler_threads_;
   std::vector<std::shared_ptr<sandbox2::Comms>> ipc_comms_;
+  // Async function bindings send their responses from their own threads, so
+  // the sends over each comms object are serialized.
+  std::vector<std::shared_ptr<std::mutex>> send_mutexes_;
   // We need the remote file descriptors to unblock the local ones when stopping
   std::vector<int> remote_fds_;
 };
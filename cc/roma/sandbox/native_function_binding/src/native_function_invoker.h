@@ -16,9 +16,12 @@
 
 #pragma once
 
-#include <string>
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 #include "cc/roma/interface/function_binding_io.pb.h"
+#include "core/interface/type_def.h"
 #include "public/core/interface/execution_result.h"
 
 namespace google::scp::roma::sandbox::native_function_binding {
@@ -34,16 +37,50 @@ class NativeFunctionInvoker {
  public:
   /**
    * @brief Invoke a native function linked to the given function invocation.
-   * @param function_name is the name of the function to invoke. This is the
-   * name that was used to register the function on the JS side.
+   * @param function_id is the ID of the function to invoke, which it was
+   * assigned when it was registered in the native function table.
    * @param[inout] function_binding_proto is the function binding context. It
    * contains both the input to be passed to the c++ function as well as the
    * return value that is set by the c++ function and which is passed to the JS
    * function as a return. This is a two-way proto.
    */
   virtual core::ExecutionResult Invoke(
-      const std::string& function_name,
+      uint32_t function_id,
       google::scp::roma::proto::FunctionBindingIoProto&
           function_binding_proto) noexcept = 0;
+
+  /**
+   * @brief Start a call of a native function without waiting for it to
+   * complete, so that several calls can be in flight at once.
+   * @param function_id is the ID of the function to invoke.
+   * @param function_binding_proto is the input of the call.
+   * @return The ID of the call, by which its completion is reported.
+   */
+  virtual core::ExecutionResultOr<uint64_t> InvokeAsync(
+      uint32_t function_id,
+      google::scp::roma::proto::FunctionBindingIoProto&
+          function_binding_proto) noexcept = 0;
+
+  /**
+   * @brief Wait until at least one of the calls started with InvokeAsync
+   * completes.
+   * @param[out] completed_calls the ID and the function binding proto, with
+   * the output set by the c++ function, of each of the completed calls.
+   * @param timeout_ms how long to wait for a call to complete, which is
+   * usually what is left of the timeout of the invocation.
+   */
+  virtual core::ExecutionResult WaitForCompletedCalls(
+      std::vector<std::pair<uint64_t,
+                            google::scp::roma::proto::FunctionBindingIoProto>>&
+          completed_calls,
+      core::TimeDuration timeout_ms) noexcept = 0;
+
+  /**
+   * @brief Give up on calls started with InvokeAsync, whose invocation is
+   * over. They are no longer waited for, and their responses are dropped when
+   * they arrive.
+   * @param call_ids the IDs of the calls.
+   */
+  virtual void AbandonCalls(const std::vector<uint64_t>& call_ids) noexcept = 0;
 };
 }  // namespace google::scp::roma::sandbox::native_function_binding
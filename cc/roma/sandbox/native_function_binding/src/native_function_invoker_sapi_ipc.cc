@@ -16,24 +16,43 @@
 
 #include "native_function_invoker_sapi_ipc.h"
 
-#include "roma/sandbox/constants/constants.h"
+#include <poll.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <limits>
+#include <utility>
+#include <vector>
 
 #include "error_codes.h"
+#include "function_binding_frame.h"
 
 using google::scp::core::ExecutionResult;
+using google::scp::core::ExecutionResultOr;
 using google::scp::core::FailureExecutionResult;
 using google::scp::core::SuccessExecutionResult;
+using google::scp::core::TimeDuration;
 using google::scp::core::errors::
     SC_ROMA_FUNCTION_INVOKER_SAPI_IPC_COULD_NOT_RECV_RESPONSE_FROM_PARENT;
 using google::scp ::core::errors ::
     SC_ROMA_FUNCTION_INVOKER_SAPI_IPC_COULD_NOT_SEND_CALL_TO_PARENT;
 using google::scp::core::errors::
     SC_ROMA_FUNCTION_INVOKER_SAPI_IPC_INVOKE_WITH_UNINITIALIZED_COMMS;
+using google::scp::core::errors::
+    SC_ROMA_FUNCTION_INVOKER_SAPI_IPC_NO_CALLS_IN_FLIGHT;
+using google::scp::core::errors::
+    SC_ROMA_FUNCTION_INVOKER_SAPI_IPC_TIMED_OUT_WAITING_FOR_CALLS;
 using google::scp::roma::proto::FunctionBindingIoProto;
-using google::scp::roma::sandbox::constants::
-    kFuctionBindingMetadataFunctionName;
 using std::make_unique;
-using std::string;
+using std::min;
+using std::move;
+using std::numeric_limits;
+using std::pair;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
 
 static constexpr int kBadFd = -1;
 
@@ -45,30 +64,133 @@ NativeFunctionInvokerSapiIpc::NativeFunctionInvokerSapiIpc(int comms_fd) {
 }
 
 ExecutionResult NativeFunctionInvokerSapiIpc::Invoke(
-    const string& function_name,
+    uint32_t function_id,
+    FunctionBindingIoProto& function_binding_proto) noexcept {
+  auto call_id_or = SendCall(function_id, function_binding_proto);
+  RETURN_IF_FAILURE(call_id_or.result());
+
+  // The responses of the async calls in flight may arrive first.
+  while (true) {
+    uint64_t call_id;
+    FunctionBindingIoProto response;
+    auto result = ReceiveResponse(call_id, response);
+    RETURN_IF_FAILURE(result);
+
+    if (call_id == *call_id_or) {
+      function_binding_proto = move(response);
+      return SuccessExecutionResult();
+    }
+    AddCompletedCall(call_id, move(response));
+  }
+}
+
+ExecutionResultOr<uint64_t> NativeFunctionInvokerSapiIpc::InvokeAsync(
+    uint32_t function_id,
+    FunctionBindingIoProto& function_binding_proto) noexcept {
+  auto call_id_or = SendCall(function_id, function_binding_proto);
+  RETURN_IF_FAILURE(call_id_or.result());
+  pending_call_ids_.insert(*call_id_or);
+  return call_id_or;
+}
+
+ExecutionResult NativeFunctionInvokerSapiIpc::WaitForCompletedCalls(
+    vector<pair<uint64_t, FunctionBindingIoProto>>& completed_calls,
+    TimeDuration timeout_ms) noexcept {
+  if (pending_call_ids_.empty() && completed_calls_.empty()) {
+    return FailureExecutionResult(
+        SC_ROMA_FUNCTION_INVOKER_SAPI_IPC_NO_CALLS_IN_FLIGHT);
+  }
+
+  // Responses of abandoned calls, or repeated responses, may arrive before the
+  // ones waited for.
+  auto deadline =
+      steady_clock::now() +
+      milliseconds(min<TimeDuration>(timeout_ms, numeric_limits<int>::max()));
+  while (completed_calls_.empty()) {
+    auto remaining_ms =
+        duration_cast<milliseconds>(deadline - steady_clock::now()).count();
+    pollfd comms_fd{};
+    comms_fd.fd = ipc_comms_->GetConnectionFD();
+    comms_fd.events = POLLIN;
+    auto ready = poll(&comms_fd, 1, remaining_ms > 0 ? remaining_ms : 0);
+    if (ready == 0) {
+      return FailureExecutionResult(
+          SC_ROMA_FUNCTION_INVOKER_SAPI_IPC_TIMED_OUT_WAITING_FOR_CALLS);
+    }
+    if (ready < 0 && errno != EINTR) {
+      return FailureExecutionResult(
+          SC_ROMA_FUNCTION_INVOKER_SAPI_IPC_COULD_NOT_RECV_RESPONSE_FROM_PARENT);
+    }
+    if (ready < 0) {
+      continue;
+    }
+
+    uint64_t call_id;
+    FunctionBindingIoProto response;
+    auto result = ReceiveResponse(call_id, response);
+    RETURN_IF_FAILURE(result);
+    AddCompletedCall(call_id, move(response));
+  }
+
+  for (auto& completed_call : completed_calls_) {
+    completed_calls.emplace_back(completed_call.first,
+                                 move(completed_call.second));
+  }
+  completed_calls_.clear();
+  return SuccessExecutionResult();
+}
+
+void NativeFunctionInvokerSapiIpc::AbandonCalls(
+    const vector<uint64_t>& call_ids) noexcept {
+  // The responses of the calls still in flight are dropped once they arrive.
+  for (auto call_id : call_ids) {
+    pending_call_ids_.erase(call_id);
+    completed_calls_.erase(call_id);
+  }
+}
+
+void NativeFunctionInvokerSapiIpc::AddCompletedCall(
+    uint64_t call_id, FunctionBindingIoProto&& response) noexcept {
+  if (pending_call_ids_.erase(call_id) == 0) {
+    return;
+  }
+  completed_calls_[call_id] = move(response);
+}
+
+ExecutionResultOr<uint64_t> NativeFunctionInvokerSapiIpc::SendCall(
+    uint32_t function_id,
     FunctionBindingIoProto& function_binding_proto) noexcept {
   if (!ipc_comms_) {
     return FailureExecutionResult(
         SC_ROMA_FUNCTION_INVOKER_SAPI_IPC_INVOKE_WITH_UNINITIALIZED_COMMS);
   }
 
-  // Set the function name so that it can be retrieved on the other side.
-  (*function_binding_proto
-        .mutable_metadata())[kFuctionBindingMetadataFunctionName] =
-      function_name;
-
-  auto sent = ipc_comms_->SendProtoBuf(function_binding_proto);
+  // The other side calls the function by its ID, and returns the call ID with
+  // the response.
+  FunctionBindingFrame::Header header{.function_id = function_id,
+                                      .call_id = next_call_id_++};
+  auto sent =
+      FunctionBindingFrame::Send(*ipc_comms_, header, function_binding_proto);
   if (!sent) {
     return FailureExecutionResult(
         SC_ROMA_FUNCTION_INVOKER_SAPI_IPC_COULD_NOT_SEND_CALL_TO_PARENT);
   }
 
-  auto recv = ipc_comms_->RecvProtoBuf(&function_binding_proto);
+  return header.call_id;
+}
+
+ExecutionResult NativeFunctionInvokerSapiIpc::ReceiveResponse(
+    uint64_t& call_id,
+    FunctionBindingIoProto& function_binding_proto) noexcept {
+  FunctionBindingFrame::Header header;
+  auto recv = FunctionBindingFrame::Receive(*ipc_comms_, header,
+                                            function_binding_proto);
   if (!recv) {
     return FailureExecutionResult(
         SC_ROMA_FUNCTION_INVOKER_SAPI_IPC_COULD_NOT_RECV_RESPONSE_FROM_PARENT);
   }
 
+  call_id = header.call_id;
   return SuccessExecutionResult();
 }
 }  // namespace google::scp::roma::sandbox::native_function_binding
@@ -16,10 +16,15 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
-#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "cc/roma/interface/function_binding_io.pb.h"
+#include "core/interface/type_def.h"
 #include "public/core/interface/execution_result.h"
 #include "sandboxed_api/sandbox2/comms.h"
 
@@ -28,18 +33,60 @@
 namespace google::scp::roma::sandbox::native_function_binding {
 /**
  * @brief Native function invoker that uses SAPI IPC to "call" a function by
- * sending data over a socket.
+ * sending data over a socket. Each call carries an ID, by which the responses
+ * of the calls in flight are told apart. It is not thread safe, as the worker
+ * runs one invocation at a time.
  *
  */
 class NativeFunctionInvokerSapiIpc : public NativeFunctionInvoker {
  public:
   explicit NativeFunctionInvokerSapiIpc(int comms_fd);
 
-  core::ExecutionResult Invoke(const std::string& function_name,
+  core::ExecutionResult Invoke(uint32_t function_id,
                                google::scp::roma::proto::FunctionBindingIoProto&
                                    function_binding_proto) noexcept override;
 
+  core::ExecutionResultOr<uint64_t> InvokeAsync(
+      uint32_t function_id,
+      google::scp::roma::proto::FunctionBindingIoProto&
+          function_binding_proto) noexcept override;
+
+  core::ExecutionResult WaitForCompletedCalls(
+      std::vector<std::pair<uint64_t,
+                            google::scp::roma::proto::FunctionBindingIoProto>>&
+          completed_calls,
+      core::TimeDuration timeout_ms) noexcept override;
+
+  void AbandonCalls(const std::vector<uint64_t>& call_ids) noexcept override;
+
  private:
+  /// Sends the call, tagged with a new call ID.
+  core::ExecutionResultOr<uint64_t> SendCall(
+      uint32_t function_id,
+      google::scp::roma::proto::FunctionBindingIoProto&
+          function_binding_proto) noexcept;
+
+  /// Receives the response of a call, with its call ID.
+  core::ExecutionResult ReceiveResponse(
+      uint64_t& call_id,
+      google::scp::roma::proto::FunctionBindingIoProto&
+          function_binding_proto) noexcept;
+
+  /// Keeps the response of an async call until it is waited for. Responses
+  /// of calls that are not pending, which were abandoned or already answered,
+  /// are dropped.
+  void AddCompletedCall(
+      uint64_t call_id,
+      google::scp::roma::proto::FunctionBindingIoProto&& response) noexcept;
+
   std::unique_ptr<sandbox2::Comms> ipc_comms_;
+  uint64_t next_call_id_ = 0;
+  /// The async calls in flight whose responses did not arrive yet, and that
+  /// were not abandoned.
+  std::unordered_set<uint64_t> pending_call_ids_;
+  /// The async calls that completed and are not yet returned by
+  /// WaitForCompletedCalls.
+  std::unordered_map<uint64_t, google::scp::roma::proto::FunctionBindingIoProto>
+      completed_calls_;
 };
 }  // namespace google::scp::roma::sandbox::native_function_binding
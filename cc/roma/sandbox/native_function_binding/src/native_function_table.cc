@@ -16,17 +16,26 @@
 
 #include "native_function_table.h"
 
+#include <atomic>
+#include <memory>
+
 #include "error_codes.h"
 
 using google::scp::core::ExecutionResult;
+using google::scp::core::ExecutionResultOr;
 using google::scp::core::FailureExecutionResult;
 using google::scp::core::SuccessExecutionResult;
+using google::scp::core::errors::
+    SC_ROMA_FUNCTION_TABLE_COULD_NOT_FIND_FUNCTION_ID;
 using google::scp::core::errors::
     SC_ROMA_FUNCTION_TABLE_COULD_NOT_FIND_FUNCTION_NAME;
 using google::scp::core::errors::
     SC_ROMA_FUNCTION_TABLE_FAILED_WHILE_CALLING_USER_PROVIDED_FUNC;
 using google::scp::core::errors::SC_ROMA_FUNCTION_TABLE_NAME_ALREADY_REGISTERED;
+using std::atomic;
+using std::function;
 using std::lock_guard;
+using std::make_shared;
 using std::string;
 
 namespace google::scp::roma::sandbox::native_function_binding {
@@ -34,37 +43,107 @@ ExecutionResult NativeFunctionTable::Register(string function_name,
                                               NativeBinding binding) {
   lock_guard lock(native_functions_map_mutex_);
 
-  if (native_functions_.find(function_name) != native_functions_.end()) {
+  if (function_ids_.find(function_name) != function_ids_.end()) {
     return FailureExecutionResult(
         SC_ROMA_FUNCTION_TABLE_NAME_ALREADY_REGISTERED);
   }
 
-  native_functions_[function_name] = binding;
+  function_ids_[function_name] = native_functions_.size();
+  native_functions_.push_back(NativeFunction{.binding = binding});
+  return SuccessExecutionResult();
+}
+
+ExecutionResult NativeFunctionTable::Register(string function_name,
+                                              AsyncNativeBinding binding) {
+  lock_guard lock(native_functions_map_mutex_);
+
+  if (function_ids_.find(function_name) != function_ids_.end()) {
+    return FailureExecutionResult(
+        SC_ROMA_FUNCTION_TABLE_NAME_ALREADY_REGISTERED);
+  }
 
+  function_ids_[function_name] = native_functions_.size();
+  native_functions_.push_back(NativeFunction{.async_binding = binding});
   return SuccessExecutionResult();
 }
 
+ExecutionResultOr<uint32_t> NativeFunctionTable::GetFunctionId(
+    const string& function_name) {
+  lock_guard lock(native_functions_map_mutex_);
+
+  auto it = function_ids_.find(function_name);
+  if (it == function_ids_.end()) {
+    return FailureExecutionResult(
+        SC_ROMA_FUNCTION_TABLE_COULD_NOT_FIND_FUNCTION_NAME);
+  }
+  return it->second;
+}
+
 ExecutionResult NativeFunctionTable::Call(
     string function_name,
     proto::FunctionBindingIoProto& function_binding_proto) {
   NativeBinding func;
+  {
+    lock_guard lock(native_functions_map_mutex_);
+    auto it = function_ids_.find(function_name);
+    if (it != function_ids_.end()) {
+      func = native_functions_[it->second].binding;
+    }
+  }
+
+  if (!func) {
+    return FailureExecutionResult(
+        SC_ROMA_FUNCTION_TABLE_COULD_NOT_FIND_FUNCTION_NAME);
+  }
+
+  try {
+    func(function_binding_proto);
+  } catch (...) {
+    return FailureExecutionResult(
+        SC_ROMA_FUNCTION_TABLE_FAILED_WHILE_CALLING_USER_PROVIDED_FUNC);
+  }
 
+  return SuccessExecutionResult();
+}
+
+ExecutionResult NativeFunctionTable::Call(
+    uint32_t function_id, proto::FunctionBindingIoProto& function_binding_proto,
+    function<void()> on_completed) {
+  NativeFunction native_function;
   {
     lock_guard lock(native_functions_map_mutex_);
-    if (native_functions_.find(function_name) == native_functions_.end()) {
+    if (function_id >= native_functions_.size()) {
       return FailureExecutionResult(
-          SC_ROMA_FUNCTION_TABLE_COULD_NOT_FIND_FUNCTION_NAME);
+          SC_ROMA_FUNCTION_TABLE_COULD_NOT_FIND_FUNCTION_ID);
     }
-    func = native_functions_[function_name];
+    native_function = native_functions_[function_id];
   }
 
+  // An async function may call back more than once, or throw after calling
+  // back, and the call must still complete only once.
+  auto is_completed = make_shared<atomic<bool>>(false);
+  auto complete_once = [on_completed, is_completed]() {
+    if (!is_completed->exchange(true)) {
+      on_completed();
+    }
+  };
+
   try {
-    func(function_binding_proto);
+    if (native_function.async_binding) {
+      native_function.async_binding(function_binding_proto, complete_once);
+      return SuccessExecutionResult();
+    }
+    native_function.binding(function_binding_proto);
   } catch (...) {
+    if (is_completed->exchange(true)) {
+      // The function completed before throwing.
+      return SuccessExecutionResult();
+    }
     return FailureExecutionResult(
         SC_ROMA_FUNCTION_TABLE_FAILED_WHILE_CALLING_USER_PROVIDED_FUNC);
   }
 
+  complete_once();
   return SuccessExecutionResult();
 }
 }  // namespace google::scp::roma::sandbox::native_function_binding
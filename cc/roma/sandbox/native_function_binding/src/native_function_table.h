@@ -16,10 +16,12 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "cc/roma/interface/function_binding_io.pb.h"
 #include "public/core/interface/execution_result.h"
@@ -29,10 +31,17 @@ typedef std::function<void(
     proto::FunctionBindingIoProto& function_binding_proto)>
     NativeBinding;
 
+typedef std::function<void(
+    proto::FunctionBindingIoProto& function_binding_proto,
+    std::function<void()> on_completed)>
+    AsyncNativeBinding;
+
 class NativeFunctionTable {
  public:
   /**
-   * @brief Register a function binding in the table.
+   * @brief Register a function binding in the table. The functions are
+   * assigned IDs in the order in which they are registered, starting at zero,
+   * by which they are called from the sandbox.
    *
    * @param function_name The name of the function.
    * @param binding The actual function.
@@ -41,6 +50,25 @@ class NativeFunctionTable {
   core::ExecutionResult Register(std::string function_name,
                                  NativeBinding binding);
 
+  /**
+   * @brief Register an async function binding in the table.
+   *
+   * @param function_name The name of the function.
+   * @param binding The actual function, which calls back once it completes.
+   * @return core::ExecutionResult
+   */
+  core::ExecutionResult Register(std::string function_name,
+                                 AsyncNativeBinding binding);
+
+  /**
+   * @brief Get the ID that a function was assigned when it was registered.
+   *
+   * @param function_name The function name.
+   * @return core::ExecutionResultOr<uint32_t> The ID of the function.
+   */
+  core::ExecutionResultOr<uint32_t> GetFunctionId(
+      const std::string& function_name);
+
   /**
    * @brief Call a function that has been previously registered.
    *
@@ -52,8 +80,33 @@ class NativeFunctionTable {
       std::string function_name,
       proto::FunctionBindingIoProto& function_binding_proto);
 
+  /**
+   * @brief Call a function that has been previously registered, either sync
+   * or async.
+   *
+   * @param function_id The function ID.
+   * @param function_binding_proto The function parameters, which must stay
+   * valid until on_completed is called.
+   * @param on_completed Called once the function completed, only if the call
+   * is successful. It is called at most once, even if an async function calls
+   * back more than once or throws after calling back.
+   * @return core::ExecutionResult
+   */
+  core::ExecutionResult Call(
+      uint32_t function_id,
+      proto::FunctionBindingIoProto& function_binding_proto,
+      std::function<void()> on_completed);
+
  private:
-  std::unordered_map<std::string, NativeBinding> native_functions_;
+  /// A registered function, which is either sync or async.
+  struct NativeFunction {
+    NativeBinding binding;
+    AsyncNativeBinding async_binding;
+  };
+
+  /// The registered functions, indexed by ID.
+  std::vector<NativeFunction> native_functions_;
+  std::unordered_map<std::string, uint32_t> function_ids_;
   std::mutex native_functions_map_mutex_;
 };
 }  // namespace google::scp::roma::sandbox::native_function_binding
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/common/time_provider/src/time_provider.h"
+#include "core/test/utils/auto_init_run_stop.h"
+#include "public/core/test/interface/execution_result_matchers.h"
+#include "roma/sandbox/native_function_binding/src/native_function_handler_sapi_ipc.h"
+#include "roma/sandbox/native_function_binding/src/native_function_invoker_sapi_ipc.h"
+#include "roma/sandbox/native_function_binding/src/native_function_table.h"
+
+using google::scp::core::common::TimeProvider;
+using google::scp::core::test::AutoInitRunStop;
+using google::scp::roma::sandbox::native_function_binding::
+    NativeFunctionHandlerSapiIpc;
+using google::scp::roma::sandbox::native_function_binding::
+    NativeFunctionInvokerSapiIpc;
+using google::scp::roma::sandbox::native_function_binding::NativeFunctionTable;
+using std::cout;
+using std::endl;
+using std::make_shared;
+using std::pair;
+using std::string;
+using std::to_string;
+using std::vector;
+
+namespace google::scp::roma::sandbox::native_function_binding::test {
+namespace {
+constexpr size_t kCallCount = 100000;
+constexpr uint64_t kWaitTimeoutMs = 10000;
+
+void NoOpFunction(proto::FunctionBindingIoProto& io_proto) {}
+
+void ReportCallRate(const string& mode, int64_t elapsed_ns) {
+  cout << mode << ": " << kCallCount * 1000 * 1000 * 1000 / elapsed_ns
+       << " calls/s" << endl;
+}
+}  // namespace
+
+/**
+ * @brief Reports the number of calls per second of a binding that does
+ * nothing, from the invoker in the sandbox to the handler and back, one call
+ * at a time.
+ */
+TEST(NativeFunctionBindingBenchmarkTest, SyncNoOpCalls) {
+  GTEST_SKIP();
+  int fd_pair[2];
+  EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fd_pair));
+  auto function_table = make_shared<NativeFunctionTable>();
+  function_table->Register("no_op", NoOpFunction);
+  NativeFunctionHandlerSapiIpc handler(function_table, {fd_pair[0]},
+                                       {fd_pair[1]});
+  AutoInitRunStop for_handler(handler);
+  NativeFunctionInvokerSapiIpc invoker(fd_pair[1]);
+
+  auto start = TimeProvider::GetSteadyTimestampInNanoseconds();
+  for (size_t i = 0; i < kCallCount; i++) {
+    proto::FunctionBindingIoProto io_proto;
+    io_proto.set_input_string("input");
+    EXPECT_SUCCESS(invoker.Invoke(0, io_proto));
+  }
+  ReportCallRate(
+      "Sync",
+      (TimeProvider::GetSteadyTimestampInNanoseconds() - start).count());
+}
+
+/**
+ * @brief Same as above, with a number of async calls in flight at once.
+ */
+TEST(NativeFunctionBindingBenchmarkTest, AsyncNoOpCalls) {
+  GTEST_SKIP();
+  constexpr size_t kCallsInFlight = 16;
+  int fd_pair[2];
+  EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fd_pair));
+  auto function_table = make_shared<NativeFunctionTable>();
+  function_table->Register("no_op", NoOpFunction);
+  NativeFunctionHandlerSapiIpc handler(function_table, {fd_pair[0]},
+                                       {fd_pair[1]});
+  AutoInitRunStop for_handler(handler);
+  NativeFunctionInvokerSapiIpc invoker(fd_pair[1]);
+
+  auto start = TimeProvider::GetSteadyTimestampInNanoseconds();
+  for (size_t i = 0; i < kCallCount; i += kCallsInFlight) {
+    for (size_t j = 0; j < kCallsInFlight; j++) {
+      proto::FunctionBindingIoProto io_proto;
+      io_proto.set_input_string("input");
+      EXPECT_SUCCESS(invoker.InvokeAsync(0, io_proto).result());
+    }
+    size_t completed_count = 0;
+    while (completed_count < kCallsInFlight) {
+      vector<pair<uint64_t, proto::FunctionBindingIoProto>> completed_calls;
+      EXPECT_SUCCESS(
+          invoker.WaitForCompletedCalls(completed_calls, kWaitTimeoutMs));
+      completed_count += completed_calls.size();
+    }
+  }
+  ReportCallRate(
+      "Async, " + to_string(kCallsInFlight) + " calls in flight",
+      (TimeProvider::GetSteadyTimestampInNanoseconds() - start).count());
+}
+}  // namespace google::scp::roma::sandbox::native_function_binding::test
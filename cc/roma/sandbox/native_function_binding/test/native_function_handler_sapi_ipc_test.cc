@@ -21,24 +21,29 @@
 #include <sys/socket.h>
 
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "core/test/utils/auto_init_run_stop.h"
 #include "public/core/test/interface/execution_result_matchers.h"
-#include "roma/sandbox/constants/constants.h"
+#include "roma/sandbox/native_function_binding/src/function_binding_frame.h"
 #include "roma/sandbox/native_function_binding/src/native_function_table.h"
 #include "sandboxed_api/sandbox2/comms.h"
 
 using google::scp::core::test::AutoInitRunStop;
-using google::scp::roma::sandbox::constants::
-    kFuctionBindingMetadataFunctionName;
+using google::scp::roma::sandbox::native_function_binding::
+    FunctionBindingFrame;
 using google::scp::roma::sandbox::native_function_binding::
     NativeFunctionHandlerSapiIpc;
 using google::scp::roma::sandbox::native_function_binding::NativeFunctionTable;
+using std::function;
 using std::make_shared;
 using std::string;
+using std::thread;
+using std::to_string;
 using std::vector;
 
 namespace google::scp::roma::sandbox::native_function_binding::test {
@@ -76,53 +81,21 @@ TEST(NativeFunctionHandlerSapiIpcTest, ShouldCallFunctionWhenRegistered) {
 
   auto remote_fd = remote_fds.at(0);
   sandbox2::Comms comms(remote_fd);
+  FunctionBindingFrame::Header header{.function_id = 0, .call_id = 1};
   proto::FunctionBindingIoProto io_proto;
-  (*io_proto.mutable_metadata())[kFuctionBindingMetadataFunctionName] =
-      "cool_function_name";
   // Send the request over so that it's handled and the registered function
   // can be called
-  EXPECT_TRUE(comms.SendProtoBuf(io_proto));
+  EXPECT_TRUE(FunctionBindingFrame::Send(comms, header, io_proto));
   // Receive the response
-  EXPECT_TRUE(comms.RecvProtoBuf(&io_proto));
+  EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
 
   EXPECT_TRUE(g_called_registered_function);
+  EXPECT_EQ(header.call_id, 1);
   EXPECT_EQ("I'm an output standalone string", io_proto.output_string());
 }
 
 TEST(NativeFunctionHandlerSapiIpcTest,
-     ShouldAddErrorsIfFunctionNameIsNotFoundInTable) {
-  int fd_pair[2];
-  EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fd_pair));
-  vector<int> local_fds = {fd_pair[0]};
-  vector<int> remote_fds = {fd_pair[1]};
-  auto function_table = make_shared<NativeFunctionTable>();
-  // We don't register any functions with the function table
-  NativeFunctionHandlerSapiIpc handler(function_table, local_fds, remote_fds);
-  AutoInitRunStop for_handler(handler);
-
-  g_called_registered_function = false;
-
-  auto remote_fd = remote_fds.at(0);
-  sandbox2::Comms comms(remote_fd);
-  proto::FunctionBindingIoProto io_proto;
-  (*io_proto.mutable_metadata())[kFuctionBindingMetadataFunctionName] =
-      "cool_function_name";
-  // Send the request over so that it's handled and the registered function
-  // can be called
-  EXPECT_TRUE(comms.SendProtoBuf(io_proto));
-  // Receive the response
-  EXPECT_TRUE(comms.RecvProtoBuf(&io_proto));
-
-  EXPECT_FALSE(g_called_registered_function);
-  EXPECT_FALSE(io_proto.has_input_string() ||
-               io_proto.has_input_list_of_string() ||
-               io_proto.has_input_map_of_string());
-  EXPECT_GE(io_proto.errors().size(), 0);
-  EXPECT_EQ(io_proto.errors(0), "ROMA: Failed to execute the C++ function.");
-}
-
-TEST(NativeFunctionHandlerSapiIpcTest,
-     ShouldAddErrorsIfFunctionNameIsNotInMetadata) {
+     ShouldAddErrorsIfFunctionIdIsNotFoundInTable) {
   int fd_pair[2];
   EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fd_pair));
   vector<int> local_fds = {fd_pair[0]};
@@ -136,19 +109,20 @@ TEST(NativeFunctionHandlerSapiIpcTest,
 
   auto remote_fd = remote_fds.at(0);
   sandbox2::Comms comms(remote_fd);
+  FunctionBindingFrame::Header header{.function_id = 0};
   proto::FunctionBindingIoProto io_proto;
   // Send the request over so that it's handled and the registered function
   // can be called
-  EXPECT_TRUE(comms.SendProtoBuf(io_proto));
+  EXPECT_TRUE(FunctionBindingFrame::Send(comms, header, io_proto));
   // Receive the response
-  EXPECT_TRUE(comms.RecvProtoBuf(&io_proto));
+  EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
 
   EXPECT_FALSE(g_called_registered_function);
   EXPECT_FALSE(io_proto.has_input_string() ||
                io_proto.has_input_list_of_string() ||
                io_proto.has_input_map_of_string());
   EXPECT_GE(io_proto.errors().size(), 0);
-  EXPECT_EQ(io_proto.errors(0), "ROMA: Could not find C++ function by name.");
+  EXPECT_EQ(io_proto.errors(0), "ROMA: Could not find C++ function by ID.");
 }
 
 void FunctionThatThrows(proto::FunctionBindingIoProto& io_proto) {
@@ -171,14 +145,13 @@ TEST(NativeFunctionHandlerSapiIpcTest,
 
   auto remote_fd = remote_fds.at(0);
   sandbox2::Comms comms(remote_fd);
+  FunctionBindingFrame::Header header{.function_id = 0};
   proto::FunctionBindingIoProto io_proto;
-  (*io_proto.mutable_metadata())[kFuctionBindingMetadataFunctionName] =
-      "cool_function_name";
   // Send the request over so that it's handled and the registered function
   // can be called
-  EXPECT_TRUE(comms.SendProtoBuf(io_proto));
+  EXPECT_TRUE(FunctionBindingFrame::Send(comms, header, io_proto));
   // Receive the response
-  EXPECT_TRUE(comms.RecvProtoBuf(&io_proto));
+  EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
 
   EXPECT_TRUE(g_called_registered_function);
   EXPECT_FALSE(io_proto.has_input_string() ||
@@ -217,30 +190,119 @@ TEST(NativeFunctionHandlerSapiIpcTest, ShouldBeAbleToCallMultipleFunctions) {
 
   auto remote_fd = remote_fds.at(0);
   sandbox2::Comms comms(remote_fd);
+  FunctionBindingFrame::Header header{
+      .function_id = *function_table->GetFunctionId("cool_function_name_one")};
   proto::FunctionBindingIoProto io_proto;
-  (*io_proto.mutable_metadata())[kFuctionBindingMetadataFunctionName] =
-      "cool_function_name_one";
   // Send the request over so that it's handled and the registered function
   // can be called
-  EXPECT_TRUE(comms.SendProtoBuf(io_proto));
+  EXPECT_TRUE(FunctionBindingFrame::Send(comms, header, io_proto));
   // Receive the response
-  EXPECT_TRUE(comms.RecvProtoBuf(&io_proto));
+  EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
 
   EXPECT_TRUE(g_called_registered_function_one);
   EXPECT_EQ(io_proto.errors().size(), 0);
   EXPECT_EQ("From function one", io_proto.output_string());
 
   io_proto.Clear();
-  (*io_proto.mutable_metadata())[kFuctionBindingMetadataFunctionName] =
-      "cool_function_name_two";
+  header.function_id =
+      *function_table->GetFunctionId("cool_function_name_two");
   // Send the request over so that it's handled and the registered function
   // can be called
-  EXPECT_TRUE(comms.SendProtoBuf(io_proto));
+  EXPECT_TRUE(FunctionBindingFrame::Send(comms, header, io_proto));
   // Receive the response
-  EXPECT_TRUE(comms.RecvProtoBuf(&io_proto));
+  EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
 
   EXPECT_TRUE(g_called_registered_function_two);
   EXPECT_EQ(io_proto.errors().size(), 0);
   EXPECT_EQ("From function two", io_proto.output_string());
 }
+
+TEST(NativeFunctionHandlerSapiIpcTest,
+     ShouldRespondToAsyncCallsAsTheyComplete) {
+  int fd_pair[2];
+  EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fd_pair));
+  vector<int> local_fds = {fd_pair[0]};
+  vector<int> remote_fds = {fd_pair[1]};
+  auto function_table = make_shared<NativeFunctionTable>();
+  // The calls complete once both of them are in flight, the second first.
+  vector<function<void()>> completions;
+  function_table->Register(
+      "async_function",
+      [&completions](proto::FunctionBindingIoProto& io_proto,
+                     function<void()> on_completed) {
+        io_proto.set_output_string("Output of " + io_proto.input_string());
+        completions.push_back(on_completed);
+        if (completions.size() == 2) {
+          thread([completions]() {
+            completions.at(1)();
+            completions.at(0)();
+          }).detach();
+        }
+      });
+  NativeFunctionHandlerSapiIpc handler(function_table, local_fds, remote_fds);
+  AutoInitRunStop for_handler(handler);
+
+  sandbox2::Comms comms(remote_fds.at(0));
+  for (uint64_t call_id : {1, 2}) {
+    FunctionBindingFrame::Header header{.function_id = 0, .call_id = call_id};
+    proto::FunctionBindingIoProto io_proto;
+    io_proto.set_input_string("call " + to_string(call_id));
+    EXPECT_TRUE(FunctionBindingFrame::Send(comms, header, io_proto));
+  }
+
+  FunctionBindingFrame::Header header;
+  proto::FunctionBindingIoProto io_proto;
+  EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
+  EXPECT_EQ(header.call_id, 2);
+  EXPECT_EQ(io_proto.output_string(), "Output of call 2");
+
+  EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
+  EXPECT_EQ(header.call_id, 1);
+  EXPECT_EQ(io_proto.output_string(), "Output of call 1");
+}
+
+TEST(NativeFunctionHandlerSapiIpcTest,
+     ShouldRespondOnceToAsyncCallThatThrowsAfterCompleting) {
+  int fd_pair[2];
+  EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fd_pair));
+  vector<int> local_fds = {fd_pair[0]};
+  vector<int> remote_fds = {fd_pair[1]};
+  auto function_table = make_shared<NativeFunctionTable>();
+  function_table->Register(
+      "async_function", [](proto::FunctionBindingIoProto& io_proto,
+                           function<void()> on_completed) {
+        io_proto.set_output_string("Output of " + io_proto.input_string());
+        on_completed();
+        on_completed();
+        throw std::runtime_error("Thrown after completing");
+      });
+  function_table->Register("function", [](proto::FunctionBindingIoProto&
+                                              io_proto) {
+    io_proto.set_output_string("Output of " + io_proto.input_string());
+  });
+  NativeFunctionHandlerSapiIpc handler(function_table, local_fds, remote_fds);
+  AutoInitRunStop for_handler(handler);
+
+  sandbox2::Comms comms(remote_fds.at(0));
+  for (uint32_t function_id : {0, 1}) {
+    FunctionBindingFrame::Header header{.function_id = function_id,
+                                        .call_id = function_id};
+    proto::FunctionBindingIoProto io_proto;
+    io_proto.set_input_string("call " + to_string(function_id));
+    EXPECT_TRUE(FunctionBindingFrame::Send(comms, header, io_proto));
+  }
+
+  // The async call is responded to once, without errors, and the next
+  // response is the one of the second call.
+  FunctionBindingFrame::Header header;
+  proto::FunctionBindingIoProto io_proto;
+  EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
+  EXPECT_EQ(header.call_id, 0);
+  EXPECT_EQ(io_proto.output_string(), "Output of call 0");
+  EXPECT_EQ(io_proto.errors().size(), 0);
+
+  EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
+  EXPECT_EQ(header.call_id, 1);
+  EXPECT_EQ(io_proto.output_string(), "Output of call 1");
+}
 }  // namespace google::scp::roma::sandbox::native_function_binding::test
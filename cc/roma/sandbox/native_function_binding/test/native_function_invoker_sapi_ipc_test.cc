@@ -27,25 +27,28 @@
 
 #include "core/test/utils/auto_init_run_stop.h"
 #include "public/core/test/interface/execution_result_matchers.h"
-#include "roma/sandbox/constants/constants.h"
+#include "roma/sandbox/native_function_binding/src/function_binding_frame.h"
 #include "sandboxed_api/sandbox2/comms.h"
 
 using google::scp::core::test::AutoInitRunStop;
-using google::scp::roma::sandbox::constants::
-    kFuctionBindingMetadataFunctionName;
+using google::scp::roma::sandbox::native_function_binding::
+    FunctionBindingFrame;
 using google::scp::roma::sandbox::native_function_binding::
     NativeFunctionInvokerSapiIpc;
 using std::make_shared;
+using std::pair;
 using std::string;
 using std::thread;
 using std::vector;
 
 namespace google::scp::roma::sandbox::native_function_binding::test {
+static constexpr uint64_t kWaitTimeoutMs = 10000;
+
 TEST(NativeFunctionHandlerSapiIpcTest, ShouldReturnFailureOnInvokeIfBadFd) {
   NativeFunctionInvokerSapiIpc invoker(-1);
 
   proto::FunctionBindingIoProto io_proto;
-  EXPECT_FALSE(invoker.Invoke("func_name", io_proto).Successful());
+  EXPECT_FALSE(invoker.Invoke(0, io_proto).Successful());
 }
 
 TEST(NativeFunctionHandlerSapiIpcTest, ShouldMakeCallOnFd) {
@@ -56,21 +59,22 @@ TEST(NativeFunctionHandlerSapiIpcTest, ShouldMakeCallOnFd) {
 
   thread to_handle_message([fd = fd_pair[1]]() {
     sandbox2::Comms comms(fd);
+    FunctionBindingFrame::Header header;
     proto::FunctionBindingIoProto io_proto;
-    EXPECT_TRUE(comms.RecvProtoBuf(&io_proto));
+    EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
     io_proto.set_output_string("Some string");
-    EXPECT_TRUE(comms.SendProtoBuf(io_proto));
+    EXPECT_TRUE(FunctionBindingFrame::Send(comms, header, io_proto));
   });
 
   proto::FunctionBindingIoProto io_proto;
-  EXPECT_SUCCESS(invoker.Invoke("func_name", io_proto));
+  EXPECT_SUCCESS(invoker.Invoke(0, io_proto));
 
   to_handle_message.join();
 
   EXPECT_EQ("Some string", io_proto.output_string());
 }
 
-TEST(NativeFunctionHandlerSapiIpcTest, ShouldAppendFunctionNameToMetadata) {
+TEST(NativeFunctionHandlerSapiIpcTest, ShouldSendFunctionIdInFrame) {
   int fd_pair[2];
   EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fd_pair));
 
@@ -78,19 +82,189 @@ TEST(NativeFunctionHandlerSapiIpcTest, ShouldAppendFunctionNameToMetadata) {
 
   thread to_handle_message([fd = fd_pair[1]]() {
     sandbox2::Comms comms(fd);
+    FunctionBindingFrame::Header header;
     proto::FunctionBindingIoProto io_proto;
-    EXPECT_TRUE(comms.RecvProtoBuf(&io_proto));
-    EXPECT_EQ("func_name",
-              io_proto.metadata().at(kFuctionBindingMetadataFunctionName));
+    EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
+    EXPECT_EQ(7, header.function_id);
+    EXPECT_TRUE(io_proto.metadata().empty());
     io_proto.set_output_string("Some string");
-    EXPECT_TRUE(comms.SendProtoBuf(io_proto));
+    EXPECT_TRUE(FunctionBindingFrame::Send(comms, header, io_proto));
   });
 
   proto::FunctionBindingIoProto io_proto;
-  EXPECT_SUCCESS(invoker.Invoke("func_name", io_proto));
+  EXPECT_SUCCESS(invoker.Invoke(7, io_proto));
 
   to_handle_message.join();
 
   EXPECT_EQ("Some string", io_proto.output_string());
 }
+
+TEST(NativeFunctionHandlerSapiIpcTest, ShouldMatchResponsesOfCallsById) {
+  int fd_pair[2];
+  EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fd_pair));
+
+  NativeFunctionInvokerSapiIpc invoker(fd_pair[0]);
+
+  // Responds to the second async call, the sync call and then the first async
+  // call.
+  thread to_handle_message([fd = fd_pair[1]]() {
+    sandbox2::Comms comms(fd);
+    vector<pair<FunctionBindingFrame::Header, proto::FunctionBindingIoProto>>
+        calls(3);
+    for (auto& [header, io_proto] : calls) {
+      EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
+      io_proto.set_output_string("Output of " + io_proto.input_string());
+    }
+    for (auto index : {1, 2, 0}) {
+      EXPECT_TRUE(FunctionBindingFrame::Send(comms, calls.at(index).first,
+                                             calls.at(index).second));
+    }
+  });
+
+  proto::FunctionBindingIoProto first_async_proto;
+  first_async_proto.set_input_string("first async");
+  auto first_call_id_or = invoker.InvokeAsync(0, first_async_proto);
+  EXPECT_SUCCESS(first_call_id_or.result());
+
+  proto::FunctionBindingIoProto second_async_proto;
+  second_async_proto.set_input_string("second async");
+  auto second_call_id_or = invoker.InvokeAsync(0, second_async_proto);
+  EXPECT_SUCCESS(second_call_id_or.result());
+  EXPECT_NE(*first_call_id_or, *second_call_id_or);
+
+  proto::FunctionBindingIoProto io_proto;
+  io_proto.set_input_string("sync");
+  EXPECT_SUCCESS(invoker.Invoke(0, io_proto));
+  EXPECT_EQ("Output of sync", io_proto.output_string());
+
+  vector<pair<uint64_t, proto::FunctionBindingIoProto>> completed_calls;
+  EXPECT_SUCCESS(
+      invoker.WaitForCompletedCalls(completed_calls, kWaitTimeoutMs));
+  EXPECT_EQ(completed_calls.size(), 1);
+  EXPECT_EQ(completed_calls.at(0).first, *second_call_id_or);
+  EXPECT_EQ("Output of second async",
+            completed_calls.at(0).second.output_string());
+
+  completed_calls.clear();
+  EXPECT_SUCCESS(
+      invoker.WaitForCompletedCalls(completed_calls, kWaitTimeoutMs));
+  EXPECT_EQ(completed_calls.size(), 1);
+  EXPECT_EQ(completed_calls.at(0).first, *first_call_id_or);
+  EXPECT_EQ("Output of first async",
+            completed_calls.at(0).second.output_string());
+
+  to_handle_message.join();
+
+  // There is nothing left to wait for.
+  completed_calls.clear();
+  EXPECT_FALSE(invoker.WaitForCompletedCalls(completed_calls, kWaitTimeoutMs)
+                   .Successful());
+}
+
+TEST(NativeFunctionHandlerSapiIpcTest, ShouldDropResponsesOfAbandonedCalls) {
+  int fd_pair[2];
+  EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fd_pair));
+
+  NativeFunctionInvokerSapiIpc invoker(fd_pair[0]);
+
+  proto::FunctionBindingIoProto first_async_proto;
+  first_async_proto.set_input_string("first async");
+  auto first_call_id_or = invoker.InvokeAsync(0, first_async_proto);
+  EXPECT_SUCCESS(first_call_id_or.result());
+
+  // No response arrives in time.
+  vector<pair<uint64_t, proto::FunctionBindingIoProto>> completed_calls;
+  EXPECT_FALSE(invoker.WaitForCompletedCalls(completed_calls, 10).Successful());
+  EXPECT_TRUE(completed_calls.empty());
+  invoker.AbandonCalls({*first_call_id_or});
+
+  proto::FunctionBindingIoProto second_async_proto;
+  second_async_proto.set_input_string("second async");
+  auto second_call_id_or = invoker.InvokeAsync(0, second_async_proto);
+  EXPECT_SUCCESS(second_call_id_or.result());
+
+  // Responds to the abandoned call ahead of the second call.
+  thread to_handle_message([fd = fd_pair[1]]() {
+    sandbox2::Comms comms(fd);
+    vector<pair<FunctionBindingFrame::Header, proto::FunctionBindingIoProto>>
+        calls(2);
+    for (auto& [header, io_proto] : calls) {
+      EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
+      io_proto.set_output_string("Output of " + io_proto.input_string());
+      EXPECT_TRUE(FunctionBindingFrame::Send(comms, header, io_proto));
+    }
+  });
+
+  EXPECT_SUCCESS(
+      invoker.WaitForCompletedCalls(completed_calls, kWaitTimeoutMs));
+  EXPECT_EQ(completed_calls.size(), 1);
+  EXPECT_EQ(completed_calls.at(0).first, *second_call_id_or);
+  EXPECT_EQ("Output of second async",
+            completed_calls.at(0).second.output_string());
+
+  to_handle_message.join();
+
+  // The abandoned call is not waited for.
+  completed_calls.clear();
+  EXPECT_FALSE(invoker.WaitForCompletedCalls(completed_calls, kWaitTimeoutMs)
+                   .Successful());
+}
+
+TEST(NativeFunctionHandlerSapiIpcTest,
+     ShouldDropRepeatedAndUnknownResponses) {
+  int fd_pair[2];
+  EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fd_pair));
+
+  NativeFunctionInvokerSapiIpc invoker(fd_pair[0]);
+
+  proto::FunctionBindingIoProto first_async_proto;
+  first_async_proto.set_input_string("first async");
+  auto first_call_id_or = invoker.InvokeAsync(0, first_async_proto);
+  EXPECT_SUCCESS(first_call_id_or.result());
+
+  proto::FunctionBindingIoProto second_async_proto;
+  second_async_proto.set_input_string("second async");
+  auto second_call_id_or = invoker.InvokeAsync(0, second_async_proto);
+  EXPECT_SUCCESS(second_call_id_or.result());
+
+  // Responds to the first call twice and to a call that was never made, ahead
+  // of the second call.
+  thread to_handle_message([fd = fd_pair[1]]() {
+    sandbox2::Comms comms(fd);
+    vector<pair<FunctionBindingFrame::Header, proto::FunctionBindingIoProto>>
+        calls(2);
+    for (auto& [header, io_proto] : calls) {
+      EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
+      io_proto.set_output_string("Output of " + io_proto.input_string());
+    }
+    auto& [first_header, first_proto] = calls.at(0);
+    EXPECT_TRUE(FunctionBindingFrame::Send(comms, first_header, first_proto));
+    EXPECT_TRUE(FunctionBindingFrame::Send(comms, first_header, first_proto));
+    FunctionBindingFrame::Header unknown_header{
+        .function_id = 0, .call_id = calls.at(1).first.call_id + 1};
+    EXPECT_TRUE(FunctionBindingFrame::Send(comms, unknown_header, first_proto));
+    EXPECT_TRUE(FunctionBindingFrame::Send(comms, calls.at(1).first,
+                                           calls.at(1).second));
+  });
+
+  vector<pair<uint64_t, proto::FunctionBindingIoProto>> completed_calls;
+  while (completed_calls.size() < 2) {
+    ASSERT_SUCCESS(
+        invoker.WaitForCompletedCalls(completed_calls, kWaitTimeoutMs));
+  }
+  EXPECT_EQ(completed_calls.size(), 2);
+  EXPECT_EQ(completed_calls.at(0).first, *first_call_id_or);
+  EXPECT_EQ("Output of first async",
+            completed_calls.at(0).second.output_string());
+  EXPECT_EQ(completed_calls.at(1).first, *second_call_id_or);
+  EXPECT_EQ("Output of second async",
+            completed_calls.at(1).second.output_string());
+
+  to_handle_message.join();
+
+  // Nothing is left to wait for, the extra responses are not counted.
+  completed_calls.clear();
+  EXPECT_FALSE(invoker.WaitForCompletedCalls(completed_calls, kWaitTimeoutMs)
+                   .Successful());
+}
 }  // namespace google::scp::roma::sandbox::native_function_binding::test
@@ -33,6 +33,7 @@ using google::scp::core::FailureExecutionResult;
 using google::scp::core::SuccessExecutionResult;
 using google::scp::core::errors::SC_ROMA_SERVICE_COULD_NOT_CREATE_FD_PAIR;
 using google::scp::roma::sandbox::dispatcher::Dispatcher;
+using google::scp::roma::sandbox::dispatcher::DispatchMode;
 using google::scp::roma::sandbox::native_function_binding::
     NativeFunctionHandlerSapiIpc;
 using google::scp::roma::sandbox::native_function_binding::NativeFunctionTable;
@@ -76,7 +77,11 @@ ExecutionResult RomaService::Init() noexcept {
   dispatcher_ = make_shared<class Dispatcher>(
       async_executor_, worker_pool_,
       concurrency * worker_queue_cap /*max_pending_requests*/,
-      config_.code_version_cache_size);
+      config_.code_version_cache_size,
+      config_.enable_worker_request_queues
+          ? DispatchMode::WorkerRequestQueues
+          : DispatchMode::AsyncExecutor,
+      config_.worker_selection_policy);
   result = dispatcher_->Init();
   RETURN_IF_FAILURE(result);
 
@@ -130,14 +135,41 @@ RomaService::SetupNativeFunctionHandler(size_t concurrency) {
   vector<shared_ptr<FunctionBindingObjectV2>> function_bindings;
   config_.GetFunctionBindings(function_bindings);
 
+  // The functions are called from the sandbox by the ID the table assigned
+  // to them, which is passed to the workers along with their names.
   vector<string> function_names;
+  vector<uint32_t> function_ids;
 
   for (auto& binding : function_bindings) {
     auto result = native_function_binding_table_->Register(
         binding->function_name, binding->function);
     RETURN_IF_FAILURE(result);
 
+    auto function_id_or =
+        native_function_binding_table_->GetFunctionId(binding->function_name);
+    RETURN_IF_FAILURE(function_id_or.result());
+
     function_names.push_back(binding->function_name);
+    function_ids.push_back(*function_id_or);
+  }
+
+  vector<shared_ptr<AsyncFunctionBindingObjectV2>> async_function_bindings;
+  config_.GetFunctionBindings(async_function_bindings);
+
+  vector<string> async_function_names;
+  vector<uint32_t> async_function_ids;
+
+  for (auto& binding : async_function_bindings) {
+    auto result = native_function_binding_table_->Register(
+        binding->function_name, binding->function);
+    RETURN_IF_FAILURE(result);
+
+    auto function_id_or =
+        native_function_binding_table_->GetFunctionId(binding->function_name);
+    RETURN_IF_FAILURE(function_id_or.result());
+
+    async_function_names.push_back(binding->function_name);
+    async_function_ids.push_back(*function_id_or);
   }
 
   vector<int> local_fds;
@@ -162,6 +194,9 @@ RomaService::SetupNativeFunctionHandler(size_t concurrency) {
       .remote_file_descriptors = remote_fds,
       .local_file_descriptors = local_fds,
       .js_function_names = function_names,
+      .js_async_function_names = async_function_names,
+      .js_function_ids = function_ids,
+      .js_async_function_ids = async_function_ids,
   };
 
   return setup;
@@ -188,7 +223,17 @@ ExecutionResult RomaService::SetupWorkers(
         .max_worker_virtual_memory_mb = config_.max_worker_virtual_memory_mb,
         .js_engine_resource_constraints = resource_constraints,
         .js_engine_max_wasm_memory_number_of_pages =
-            config_.max_wasm_memory_number_of_pages};
+            config_.max_wasm_memory_number_of_pages,
+        .js_engine_context_pool_options = config_.js_context_pool_options,
+        .shared_memory_arena_size_mb =
+            config_.worker_shared_memory_arena_size_mb,
+        .boot_from_startup_snapshot =
+            config_.boot_workers_from_startup_snapshot,
+        .native_js_async_function_names =
+            native_binding_setup.js_async_function_names,
+        .native_js_function_ids = native_binding_setup.js_function_ids,
+        .native_js_async_function_ids =
+            native_binding_setup.js_async_function_ids};
 
     worker_configs.push_back(worker_api_sapi_config);
   }
@@ -62,6 +62,9 @@ class RomaService : public core::ServiceInterface {
     std::vector<int> remote_file_descriptors;
     std::vector<int> local_file_descriptors;
     std::vector<std::string> js_function_names;
+    std::vector<std::string> js_async_function_names;
+    std::vector<uint32_t> js_function_ids;
+    std::vector<uint32_t> js_async_function_ids;
   };
 
   explicit RomaService(const Config& config = Config()) { config_ = config; }
@@ -60,9 +60,14 @@ ExecutionResult Worker::Stop() noexcept {
   return js_engine_->Stop();
 }
 
+ExecutionResultOr<string> Worker::CreateStartupSnapshot() noexcept {
+  return js_engine_->CreateStartupSnapshot();
+}
+
 ExecutionResultOr<string> Worker::RunCode(
     const string& code, const vector<string_view>& input,
-    const unordered_map<string, string>& metadata) {
+    const unordered_map<string, string>& metadata,
+    unordered_map<string, int64_t>* metrics) {
   auto request_type_or =
       WorkerUtils::GetValueFromMetadata(metadata, kRequestType);
   RETURN_IF_FAILURE(request_type_or.result());
@@ -106,6 +111,10 @@ ExecutionResultOr<string> Worker::RunCode(
       compilation_contexts_.Set(*code_version_or,
                                 response_or->compilation_context);
     }
+    if (metrics) {
+      metrics->insert(response_or->metrics.begin(),
+                      response_or->metrics.end());
+    }
 
     return response_or->response;
   } else if (*request_type_or == kRequestTypeWasm) {
@@ -118,6 +127,10 @@ ExecutionResultOr<string> Worker::RunCode(
       compilation_contexts_.Set(*code_version_or,
                                 response_or->compilation_context);
     }
+    if (metrics) {
+      metrics->insert(response_or->metrics.begin(),
+                      response_or->metrics.end());
+    }
     return response_or->response;
   }
 
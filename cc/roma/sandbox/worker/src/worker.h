@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -60,11 +61,21 @@ class Worker : public core::ServiceInterface {
    * @param code The code to compile and run
    * @param input The input to pass to the code
    * @param metadata The metadata associated with the code request
+   * @param metrics If set, gets the metrics of the execution
    * @return core::ExecutionResultOr<std::string>
    */
   virtual core::ExecutionResultOr<std::string> RunCode(
       const std::string& code, const std::vector<absl::string_view>& input,
-      const std::unordered_map<std::string, std::string>& metadata);
+      const std::unordered_map<std::string, std::string>& metadata,
+      std::unordered_map<std::string, int64_t>* metrics = nullptr);
+
+  /**
+   * @brief Create a startup snapshot of the JS engine, from which the engines
+   * of other workers can be booted.
+   *
+   * @return core::ExecutionResultOr<std::string>
+   */
+  core::ExecutionResultOr<std::string> CreateStartupSnapshot() noexcept;
 
  private:
   std::shared_ptr<js_engine::JsEngine> js_engine_;
@@ -93,4 +93,56 @@ DEFINE_ERROR_CODE(SC_ROMA_WORKER_API_COULD_NOT_SERIALIZE_RUN_CODE_RESPONSE_DATA,
                   SC_ROMA_WORKER_API, 0x000F,
                   "Failed to serialize run_code response data.",
                   HttpStatusCode::BAD_REQUEST)
+DEFINE_ERROR_CODE(SC_ROMA_WORKER_API_COULD_NOT_CREATE_SHARED_MEMORY,
+                  SC_ROMA_WORKER_API, 0x0010,
+                  "Could not create the shared memory arena of the sandbox.",
+                  HttpStatusCode::BAD_REQUEST)
+
+DEFINE_ERROR_CODE(SC_ROMA_WORKER_API_COULD_NOT_MAP_SHARED_MEMORY,
+                  SC_ROMA_WORKER_API, 0x0011,
+                  "Could not map the shared memory arena of the sandbox.",
+                  HttpStatusCode::BAD_REQUEST)
+
+DEFINE_ERROR_CODE(
+    SC_ROMA_WORKER_API_COULD_NOT_TRANSFER_SHARED_MEMORY_FD_TO_SANDBOX,
+    SC_ROMA_WORKER_API, 0x0012,
+    "Could not transfer the shared memory arena fd to sandbox.",
+    HttpStatusCode::BAD_REQUEST)
+
+DEFINE_ERROR_CODE(SC_ROMA_WORKER_API_SHARED_MEMORY_NOT_INITIALIZED,
+                  SC_ROMA_WORKER_API, 0x0013,
+                  "The shared memory arena of the sandbox is not initialized.",
+                  HttpStatusCode::BAD_REQUEST)
+
+DEFINE_ERROR_CODE(SC_ROMA_WORKER_API_REQUEST_DOES_NOT_FIT_SHARED_MEMORY,
+                  SC_ROMA_WORKER_API, 0x0014,
+                  "The request does not fit in the shared memory arena.",
+                  HttpStatusCode::REQUEST_ENTITY_TOO_LARGE)
+
+DEFINE_ERROR_CODE(SC_ROMA_WORKER_API_RESPONSE_DOES_NOT_FIT_SHARED_MEMORY,
+                  SC_ROMA_WORKER_API, 0x0015,
+                  "The response does not fit in the shared memory arena.",
+                  HttpStatusCode::REQUEST_ENTITY_TOO_LARGE)
+
+DEFINE_ERROR_CODE(SC_ROMA_WORKER_API_INVALID_SHARED_MEMORY_DATA,
+                  SC_ROMA_WORKER_API, 0x0016,
+                  "The data in the shared memory arena is malformed.",
+                  HttpStatusCode::BAD_REQUEST)
+
+DEFINE_ERROR_CODE(SC_ROMA_WORKER_API_COULD_NOT_CREATE_STARTUP_SNAPSHOT,
+                  SC_ROMA_WORKER_API, 0x0017,
+                  "Could not create the startup snapshot in the sandbox.",
+                  HttpStatusCode::BAD_REQUEST)
+
+DEFINE_ERROR_CODE(SC_ROMA_WORKER_API_NO_OVERSIZED_RESPONSE, SC_ROMA_WORKER_API,
+                  0x0018,
+                  "There is no response that did not fit in the shared memory "
+                  "arena to read.",
+                  HttpStatusCode::BAD_REQUEST)
+
+DEFINE_ERROR_CODE(SC_ROMA_WORKER_API_INVALID_FUNCTION_IDS, SC_ROMA_WORKER_API,
+                  0x0019,
+                  "The native function IDs do not match the native function "
+                  "names.",
+                  HttpStatusCode::BAD_REQUEST)
 }  // namespace google::scp::core::errors
@@ -0,0 +1,242 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "shared_memory_arena.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "error_codes.h"
+
+using absl::string_view;
+using google::scp::core::ExecutionResult;
+using google::scp::core::ExecutionResultOr;
+using google::scp::core::FailureExecutionResult;
+using google::scp::core::SuccessExecutionResult;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_COULD_NOT_CREATE_SHARED_MEMORY;
+using google::scp::core::errors::SC_ROMA_WORKER_API_COULD_NOT_MAP_SHARED_MEMORY;
+using google::scp::core::errors::SC_ROMA_WORKER_API_INVALID_SHARED_MEMORY_DATA;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_REQUEST_DOES_NOT_FIT_SHARED_MEMORY;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_RESPONSE_DOES_NOT_FIT_SHARED_MEMORY;
+using std::string;
+using std::unique_ptr;
+using std::unordered_map;
+using std::vector;
+
+namespace {
+constexpr char kSharedMemoryArenaName[] = "roma_worker_arena";
+
+/// Writes sizes and length prefixed bytes into the arena.
+class ArenaWriter {
+ public:
+  ArenaWriter(uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  bool WriteSize(uint64_t value) { return Write(&value, sizeof(value)); }
+
+  bool WriteBytes(string_view bytes) {
+    return WriteSize(bytes.size()) && Write(bytes.data(), bytes.size());
+  }
+
+ private:
+  bool Write(const void* source, size_t length) {
+    if (length > size_ - offset_) {
+      return false;
+    }
+    memcpy(data_ + offset_, source, length);
+    offset_ += length;
+    return true;
+  }
+
+  uint8_t* const data_;
+  const size_t size_;
+  size_t offset_ = 0;
+};
+
+/// Reads what ArenaWriter wrote, pointing into the arena for the bytes.
+class ArenaReader {
+ public:
+  ArenaReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  bool ReadSize(uint64_t& value) {
+    if (sizeof(value) > size_ - offset_) {
+      return false;
+    }
+    memcpy(&value, data_ + offset_, sizeof(value));
+    offset_ += sizeof(value);
+    return true;
+  }
+
+  /// Reads the number of the entries that follow, each taking at least
+  /// min_entry_size bytes.
+  bool ReadCount(uint64_t& count, size_t min_entry_size) {
+    return ReadSize(count) && count <= (size_ - offset_) / min_entry_size;
+  }
+
+  bool ReadBytes(string_view& bytes) {
+    uint64_t length;
+    if (!ReadSize(length) || length > size_ - offset_) {
+      return false;
+    }
+    bytes = string_view(reinterpret_cast<const char*>(data_ + offset_), length);
+    offset_ += length;
+    return true;
+  }
+
+ private:
+  const uint8_t* const data_;
+  const size_t size_;
+  size_t offset_ = 0;
+};
+}  // namespace
+
+namespace google::scp::roma::sandbox::worker_api {
+SharedMemoryArena::~SharedMemoryArena() {
+  munmap(data_, size_);
+  close(fd_);
+}
+
+ExecutionResultOr<unique_ptr<SharedMemoryArena>> SharedMemoryArena::Create(
+    size_t size) noexcept {
+  int fd = memfd_create(kSharedMemoryArenaName, MFD_CLOEXEC);
+  if (fd < 0) {
+    return FailureExecutionResult(
+        SC_ROMA_WORKER_API_COULD_NOT_CREATE_SHARED_MEMORY);
+  }
+  if (ftruncate(fd, size) != 0) {
+    close(fd);
+    return FailureExecutionResult(
+        SC_ROMA_WORKER_API_COULD_NOT_CREATE_SHARED_MEMORY);
+  }
+  return Map(fd, size);
+}
+
+ExecutionResultOr<unique_ptr<SharedMemoryArena>> SharedMemoryArena::Map(
+    int fd, size_t size) noexcept {
+  auto data =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, /*offset=*/0);
+  if (data == MAP_FAILED) {
+    close(fd);
+    return FailureExecutionResult(
+        SC_ROMA_WORKER_API_COULD_NOT_MAP_SHARED_MEMORY);
+  }
+  return unique_ptr<SharedMemoryArena>(
+      new SharedMemoryArena(fd, static_cast<uint8_t*>(data), size));
+}
+
+ExecutionResult SharedMemoryArena::WriteRequest(
+    string_view code, const vector<string_view>& input,
+    const unordered_map<string, string>& metadata) noexcept {
+  ArenaWriter writer(data_, size_);
+  auto written = writer.WriteBytes(code) && writer.WriteSize(input.size());
+  for (size_t i = 0; written && i < input.size(); i++) {
+    written = writer.WriteBytes(input[i]);
+  }
+  written = written && writer.WriteSize(metadata.size());
+  for (auto it = metadata.begin(); written && it != metadata.end(); ++it) {
+    written = writer.WriteBytes(it->first) && writer.WriteBytes(it->second);
+  }
+  if (!written) {
+    return FailureExecutionResult(
+        SC_ROMA_WORKER_API_REQUEST_DOES_NOT_FIT_SHARED_MEMORY);
+  }
+  return SuccessExecutionResult();
+}
+
+ExecutionResult SharedMemoryArena::ReadRequest(
+    string_view& code, vector<string_view>& input,
+    unordered_map<string, string>& metadata) noexcept {
+  ArenaReader reader(data_, size_);
+  uint64_t input_count;
+  if (!reader.ReadBytes(code) ||
+      !reader.ReadCount(input_count, sizeof(uint64_t))) {
+    return FailureExecutionResult(
+        SC_ROMA_WORKER_API_INVALID_SHARED_MEMORY_DATA);
+  }
+  input.resize(input_count);
+  for (auto& element : input) {
+    if (!reader.ReadBytes(element)) {
+      return FailureExecutionResult(
+          SC_ROMA_WORKER_API_INVALID_SHARED_MEMORY_DATA);
+    }
+  }
+
+  uint64_t metadata_count;
+  if (!reader.ReadCount(metadata_count, 2 * sizeof(uint64_t))) {
+    return FailureExecutionResult(
+        SC_ROMA_WORKER_API_INVALID_SHARED_MEMORY_DATA);
+  }
+  for (uint64_t i = 0; i < metadata_count; i++) {
+    string_view key;
+    string_view value;
+    if (!reader.ReadBytes(key) || !reader.ReadBytes(value)) {
+      return FailureExecutionResult(
+          SC_ROMA_WORKER_API_INVALID_SHARED_MEMORY_DATA);
+    }
+    metadata[string(key)] = string(value);
+  }
+  return SuccessExecutionResult();
+}
+
+ExecutionResult SharedMemoryArena::WriteResponse(
+    string_view response,
+    const unordered_map<string, int64_t>& metrics) noexcept {
+  ArenaWriter writer(data_, size_);
+  auto written =
+      writer.WriteBytes(response) && writer.WriteSize(metrics.size());
+  for (auto it = metrics.begin(); written && it != metrics.end(); ++it) {
+    written = writer.WriteBytes(it->first) &&
+              writer.WriteSize(static_cast<uint64_t>(it->second));
+  }
+  if (!written) {
+    return FailureExecutionResult(
+        SC_ROMA_WORKER_API_RESPONSE_DOES_NOT_FIT_SHARED_MEMORY);
+  }
+  return SuccessExecutionResult();
+}
+
+ExecutionResult SharedMemoryArena::ReadResponse(
+    string& response, unordered_map<string, int64_t>& metrics) noexcept {
+  ArenaReader reader(data_, size_);
+  string_view response_view;
+  uint64_t metrics_count;
+  if (!reader.ReadBytes(response_view) ||
+      !reader.ReadCount(metrics_count, 2 * sizeof(uint64_t))) {
+    return FailureExecutionResult(
+        SC_ROMA_WORKER_API_INVALID_SHARED_MEMORY_DATA);
+  }
+  response = string(response_view);
+
+  for (uint64_t i = 0; i < metrics_count; i++) {
+    string_view key;
+    uint64_t value;
+    if (!reader.ReadBytes(key) || !reader.ReadSize(value)) {
+      return FailureExecutionResult(
+          SC_ROMA_WORKER_API_INVALID_SHARED_MEMORY_DATA);
+    }
+    metrics[string(key)] = static_cast<int64_t>(value);
+  }
+  return SuccessExecutionResult();
+}
+}  // namespace google::scp::roma::sandbox::worker_api
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "public/core/interface/execution_result.h"
+
+namespace google::scp::roma::sandbox::worker_api {
+/**
+ * @brief A region of memory mapped both by the host and by the sandboxee,
+ * through which the run code requests and responses are exchanged in place.
+ * Only a call without arguments crosses the SAPI RPC: the host writes the
+ * request into the arena, and the sandboxee reads the code and inputs right
+ * where they are and writes the response over the request.
+ *
+ * The arena holds one request at a time, so its users must serialize the
+ * calls.
+ */
+class SharedMemoryArena {
+ public:
+  ~SharedMemoryArena();
+
+  /**
+   * @brief Creates an arena backed by a new memory file, whose fd is to be
+   * transferred to the sandboxee.
+   *
+   * @param size The size of the arena in bytes.
+   */
+  static core::ExecutionResultOr<std::unique_ptr<SharedMemoryArena>> Create(
+      size_t size) noexcept;
+
+  /**
+   * @brief Maps the arena created on the other side of the sandbox.
+   *
+   * @param fd The fd of the memory file of the arena, owned by the arena from
+   * here on.
+   * @param size The size of the arena in bytes.
+   */
+  static core::ExecutionResultOr<std::unique_ptr<SharedMemoryArena>> Map(
+      int fd, size_t size) noexcept;
+
+  int GetFd() const noexcept { return fd_; }
+
+  size_t GetSize() const noexcept { return size_; }
+
+  /**
+   * @brief Writes a run code request into the arena.
+   *
+   * @return core::ExecutionResult
+   * SC_ROMA_WORKER_API_REQUEST_DOES_NOT_FIT_SHARED_MEMORY if the request is
+   * larger than the arena, in which case it is to be sent otherwise.
+   */
+  core::ExecutionResult WriteRequest(
+      absl::string_view code, const std::vector<absl::string_view>& input,
+      const std::unordered_map<std::string, std::string>& metadata) noexcept;
+
+  /**
+   * @brief Reads the run code request of the arena. The code and inputs point
+   * into the arena, and stay valid until the response is written.
+   */
+  core::ExecutionResult ReadRequest(
+      absl::string_view& code, std::vector<absl::string_view>& input,
+      std::unordered_map<std::string, std::string>& metadata) noexcept;
+
+  /**
+   * @brief Writes a run code response into the arena, over the request.
+   *
+   * @return core::ExecutionResult
+   * SC_ROMA_WORKER_API_RESPONSE_DOES_NOT_FIT_SHARED_MEMORY if the response is
+   * larger than the arena, in which case the caller is to pass it some other
+   * way.
+   */
+  core::ExecutionResult WriteResponse(
+      absl::string_view response,
+      const std::unordered_map<std::string, int64_t>& metrics) noexcept;
+
+  /// Reads the run code response of the arena.
+  core::ExecutionResult ReadResponse(
+      std::string& response,
+      std::unordered_map<std::string, int64_t>& metrics) noexcept;
+
+ private:
+  SharedMemoryArena(int fd, uint8_t* data, size_t size)
+      : fd_(fd), data_(data), size_(size) {}
+
+  const int fd_;
+  uint8_t* const data_;
+  const size_t size_;
+};
+}  // namespace google::scp::roma::sandbox::worker_api
@@ -23,9 +23,12 @@
 #include <chrono>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "core/common/time_provider/src/stopwatch.h"
+#include "roma/sandbox/constants/constants.h"
 #include "roma/sandbox/logging/src/logging.h"
 #include "roma/sandbox/worker_api/sapi/src/worker_init_params.pb.h"
 #include "roma/sandbox/worker_api/sapi/src/worker_params.pb.h"
@@ -39,10 +42,14 @@
 #define ROMA_SAPI_USE_SERIALIZED_DATA 1
 
 using google::scp::core::ExecutionResult;
+using google::scp::core::ExecutionResultOr;
 using google::scp::core::FailureExecutionResult;
 using google::scp::core::RetryExecutionResult;
 using google::scp::core::SuccessExecutionResult;
+using google::scp::core::common::Stopwatch;
 using google::scp::core::errors::SC_ROMA_WORKER_API_COULD_NOT_CREATE_IPC_PROTO;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_COULD_NOT_CREATE_STARTUP_SNAPSHOT;
 using google::scp::core::errors::
     SC_ROMA_WORKER_API_COULD_NOT_DESERIALIZE_RUN_CODE_DATA;
 using google::scp::core::errors::
@@ -60,13 +67,42 @@ using google::scp::core::errors::
     SC_ROMA_WORKER_API_COULD_NOT_SERIALIZE_RUN_CODE_DATA;
 using google::scp::core::errors::
     SC_ROMA_WORKER_API_COULD_NOT_TRANSFER_FUNCTION_FD_TO_SANDBOX;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_COULD_NOT_TRANSFER_SHARED_MEMORY_FD_TO_SANDBOX;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_RESPONSE_DOES_NOT_FIT_SHARED_MEMORY;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_SHARED_MEMORY_NOT_INITIALIZED;
 using google::scp::core::errors::SC_ROMA_WORKER_API_UNINITIALIZED_SANDBOX;
 using google::scp::core::errors::SC_ROMA_WORKER_API_WORKER_CRASHED;
+using google::scp::roma::sandbox::constants::kExecutionMetricJsEngineCallNs;
+using google::scp::roma::sandbox::constants::kExecutionMetricSandboxIpcNs;
+using absl::string_view;
+using std::make_unique;
 using std::move;
 using std::string;
+using std::unordered_map;
 using std::vector;
 using std::this_thread::yield;
 
+/**
+ * @brief Sets the time taken to cross the sandbox boundary, which is the time
+ * of the sandboxed run less the time the code ran for inside of the sandbox.
+ *
+ * @tparam MetricsT The map type of the metrics.
+ * @param sandboxed_run_ns The time of the sandboxed run.
+ * @param metrics The metrics returned from the sandbox.
+ */
+template <typename MetricsT>
+static void SetSandboxIpcMetric(int64_t sandboxed_run_ns, MetricsT& metrics) {
+  auto code_run_ns = metrics.find(kExecutionMetricJsEngineCallNs);
+  if (code_run_ns == metrics.end()) {
+    return;
+  }
+  metrics[kExecutionMetricSandboxIpcNs] =
+      sandboxed_run_ns - code_run_ns->second;
+}
+
 namespace google::scp::roma::sandbox::worker_api {
 
 ExecutionResult WorkerSandboxApi::Init() noexcept {
@@ -121,6 +157,32 @@ ExecutionResult WorkerSandboxApi::Init() noexcept {
     remote_fd = sapi_native_js_function_comms_fd_->GetRemoteFd();
   }
 
+  // A new arena per sandbox instance, as a restarted sandbox has to map it
+  // again.
+  int remote_arena_fd = kBadFd;
+  sapi_shared_memory_arena_fd_.reset();
+  shared_memory_arena_.reset();
+  if (shared_memory_arena_size_mb_ > 0) {
+    auto arena_or = SharedMemoryArena::Create(
+        ROMA_CONVERT_MB_TO_BYTES(shared_memory_arena_size_mb_));
+    RETURN_IF_FAILURE(arena_or.result());
+    shared_memory_arena_ = move(*arena_or);
+
+    // The arena owns the local fd, and the sandboxee closes the remote one
+    // when it exits.
+    sapi_shared_memory_arena_fd_ =
+        make_unique<::sapi::v::Fd>(shared_memory_arena_->GetFd());
+    sapi_shared_memory_arena_fd_->OwnLocalFd(false);
+    auto transferred = worker_sapi_sandbox_->TransferToSandboxee(
+        sapi_shared_memory_arena_fd_.get());
+    if (!transferred.ok()) {
+      return FailureExecutionResult(
+          SC_ROMA_WORKER_API_COULD_NOT_TRANSFER_SHARED_MEMORY_FD_TO_SANDBOX);
+    }
+    sapi_shared_memory_arena_fd_->OwnRemoteFd(false);
+    remote_arena_fd = sapi_shared_memory_arena_fd_->GetRemoteFd();
+  }
+
   ::worker_api::WorkerInitParamsProto worker_init_params;
   worker_init_params.set_worker_factory_js_engine(
       static_cast<int>(worker_engine_));
@@ -130,12 +192,32 @@ ExecutionResult WorkerSandboxApi::Init() noexcept {
   worker_init_params.set_native_js_function_comms_fd(remote_fd);
   worker_init_params.mutable_native_js_function_names()->Assign(
       native_js_function_names_.begin(), native_js_function_names_.end());
+  worker_init_params.mutable_native_js_async_function_names()->Assign(
+      native_js_async_function_names_.begin(),
+      native_js_async_function_names_.end());
+  worker_init_params.mutable_native_js_function_ids()->Assign(
+      native_js_function_ids_.begin(), native_js_function_ids_.end());
+  worker_init_params.mutable_native_js_async_function_ids()->Assign(
+      native_js_async_function_ids_.begin(),
+      native_js_async_function_ids_.end());
   worker_init_params.set_js_engine_initial_heap_size_mb(
       js_engine_initial_heap_size_mb_);
   worker_init_params.set_js_engine_maximum_heap_size_mb(
       js_engine_maximum_heap_size_mb_);
   worker_init_params.set_js_engine_max_wasm_memory_number_of_pages(
       js_engine_max_wasm_memory_number_of_pages_);
+  worker_init_params.set_js_engine_context_pool_size(
+      js_engine_context_pool_size_);
+  worker_init_params.set_js_engine_context_pool_max_context_uses(
+      js_engine_context_pool_max_context_uses_);
+  if (shared_memory_arena_) {
+    worker_init_params.set_shared_memory_arena_fd(remote_arena_fd);
+    worker_init_params.set_shared_memory_arena_size(
+        shared_memory_arena_->GetSize());
+  }
+  if (startup_snapshot_) {
+    worker_init_params.set_js_engine_startup_snapshot(*startup_snapshot_);
+  }
 
 #if ROMA_SAPI_USE_SERIALIZED_DATA
   int serialized_size = worker_init_params.ByteSizeLong();
@@ -292,7 +374,10 @@ ExecutionResult WorkerSandboxApi::RunCode(
     return FailureExecutionResult(SC_ROMA_WORKER_API_UNINITIALIZED_SANDBOX);
   }
 
+  Stopwatch stopwatch;
+  stopwatch.Start();
   auto run_code_result = InternalRunCode(params);
+  auto run_code_elapsed_ns = stopwatch.Stop();
 
   if (!run_code_result.Successful()) {
     if (run_code_result.Retryable()) {
@@ -306,9 +391,95 @@ ExecutionResult WorkerSandboxApi::RunCode(
     return run_code_result;
   }
 
+  SetSandboxIpcMetric(run_code_elapsed_ns.count(), *params.mutable_metrics());
+  return SuccessExecutionResult();
+}
+
+ExecutionResult WorkerSandboxApi::RunCodeInSharedMemory(
+    string_view code, const vector<string_view>& input,
+    const unordered_map<string, string>& metadata, string& response,
+    unordered_map<string, int64_t>& metrics) noexcept {
+  if (!worker_sapi_sandbox_ || !worker_wrapper_api_) {
+    return FailureExecutionResult(SC_ROMA_WORKER_API_UNINITIALIZED_SANDBOX);
+  }
+  if (!shared_memory_arena_) {
+    return FailureExecutionResult(
+        SC_ROMA_WORKER_API_SHARED_MEMORY_NOT_INITIALIZED);
+  }
+
+  Stopwatch stopwatch;
+  stopwatch.Start();
+  auto result = shared_memory_arena_->WriteRequest(code, input, metadata);
+  RETURN_IF_FAILURE(result);
+
+  auto status_or = worker_wrapper_api_->RunCodeFromSharedMemory();
+  if (!status_or.ok()) {
+    // This means that the sandbox died so we need to restart it.
+    result = Init();
+    RETURN_IF_FAILURE(result);
+    result = Run();
+    RETURN_IF_FAILURE(result);
+    return RetryExecutionResult(SC_ROMA_WORKER_API_WORKER_CRASHED);
+  } else if (*status_or ==
+             SC_ROMA_WORKER_API_RESPONSE_DOES_NOT_FIT_SHARED_MEMORY) {
+    result = ReadOversizedResponse(response, metrics);
+  } else if (*status_or != SC_OK) {
+    return FailureExecutionResult(*status_or);
+  } else {
+    result = shared_memory_arena_->ReadResponse(response, metrics);
+  }
+  RETURN_IF_FAILURE(result);
+  SetSandboxIpcMetric(stopwatch.Stop().count(), metrics);
   return SuccessExecutionResult();
 }
 
+ExecutionResult WorkerSandboxApi::ReadOversizedResponse(
+    string& response, unordered_map<string, int64_t>& metrics) noexcept {
+  // A placeholder, which the sandboxee replaces with the response.
+  char placeholder = 0;
+  sapi::v::LenVal sapi_len_val(&placeholder, sizeof(placeholder));
+
+  auto status_or =
+      worker_wrapper_api_->ReadOversizedResponse(sapi_len_val.PtrBoth());
+  if (!status_or.ok()) {
+    return FailureExecutionResult(SC_ROMA_WORKER_API_COULD_NOT_RUN_WRAPPER_API);
+  } else if (*status_or != SC_OK) {
+    return FailureExecutionResult(*status_or);
+  }
+
+  ::worker_api::WorkerParamsProto out_params;
+  if (!out_params.ParseFromArray(sapi_len_val.GetData(),
+                                 sapi_len_val.GetDataSize())) {
+    return FailureExecutionResult(
+        SC_ROMA_WORKER_API_COULD_NOT_DESERIALIZE_RUN_CODE_DATA);
+  }
+  response = move(*out_params.mutable_response());
+  metrics.insert(out_params.metrics().begin(), out_params.metrics().end());
+  return SuccessExecutionResult();
+}
+
+ExecutionResultOr<string> WorkerSandboxApi::CreateStartupSnapshot() noexcept {
+  if (!worker_sapi_sandbox_ || !worker_wrapper_api_) {
+    return FailureExecutionResult(SC_ROMA_WORKER_API_UNINITIALIZED_SANDBOX);
+  }
+
+  // A placeholder, which the sandboxee replaces with the snapshot.
+  char placeholder = 0;
+  sapi::v::LenVal sapi_len_val(&placeholder, sizeof(placeholder));
+
+  auto status_or =
+      worker_wrapper_api_->CreateStartupSnapshot(sapi_len_val.PtrBoth());
+  if (!status_or.ok()) {
+    return FailureExecutionResult(
+        SC_ROMA_WORKER_API_COULD_NOT_CREATE_STARTUP_SNAPSHOT);
+  } else if (*status_or != SC_OK) {
+    return FailureExecutionResult(*status_or);
+  }
+
+  return string(reinterpret_cast<const char*>(sapi_len_val.GetData()),
+                sapi_len_val.GetDataSize());
+}
+
 ExecutionResult WorkerSandboxApi::Terminate() noexcept {
   worker_sapi_sandbox_->Terminate();
   return SuccessExecutionResult();
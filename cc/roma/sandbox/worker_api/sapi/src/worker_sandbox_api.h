@@ -22,10 +22,15 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "absl/strings/string_view.h"
 #include "core/interface/service_interface.h"
+#include "roma/config/src/config.h"
 #include "roma/sandbox/worker_api/sapi/src/roma_worker_wrapper_lib-sapi.sapi.h"
+#include "roma/sandbox/worker_api/sapi/src/shared_memory_arena.h"
 #include "roma/sandbox/worker_api/sapi/src/worker_params.pb.h"
 #include "roma/sandbox/worker_factory/src/worker_factory.h"
 #include "sandboxed_api/sandbox2/policy.h"
@@ -61,6 +66,20 @@ class WorkerSandboxApi : public core::ServiceInterface {
    * JS engine.
    * @param js_engine_max_wasm_memory_number_of_pages The maximum number of WASM
    * pages. Each page is 64KiB. Max 65536 pages (4GiB).
+   * @param js_engine_context_pool_size The number of pre-initialized JS
+   * contexts to keep per code version, zero to disable the pool.
+   * @param js_engine_context_pool_max_context_uses The number of invocations
+   * a pooled JS context serves before it is replaced, defaults to the one of
+   * JsContextPoolOptions.
+   * @param shared_memory_arena_size_mb The size in MB of the arena shared
+   * with the sandbox to exchange the requests and responses in place, zero
+   * to serialize them over the SAPI RPC instead.
+   * @param native_js_async_function_names The names of the functions that
+   * should be registered to be available in JS and return a promise.
+   * @param native_js_function_ids The IDs by which the functions of
+   * native_js_function_names are called.
+   * @param native_js_async_function_ids The IDs by which the functions of
+   * native_js_async_function_names are called.
    */
   WorkerSandboxApi(const worker::WorkerFactory::WorkerEngine& worker_engine,
                    bool require_preload, size_t compilation_context_cache_size,
@@ -69,7 +88,16 @@ class WorkerSandboxApi : public core::ServiceInterface {
                    size_t max_worker_virtual_memory_mb,
                    size_t js_engine_initial_heap_size_mb,
                    size_t js_engine_maximum_heap_size_mb,
-                   size_t js_engine_max_wasm_memory_number_of_pages) {
+                   size_t js_engine_max_wasm_memory_number_of_pages,
+                   size_t js_engine_context_pool_size = 0,
+                   size_t js_engine_context_pool_max_context_uses =
+                       JsContextPoolOptions().max_context_uses,
+                   size_t shared_memory_arena_size_mb = 0,
+                   const std::vector<std::string>&
+                       native_js_async_function_names = {},
+                   const std::vector<uint32_t>& native_js_function_ids = {},
+                   const std::vector<uint32_t>& native_js_async_function_ids =
+                       {}) {
     worker_engine_ = worker_engine;
     require_preload_ = require_preload;
     compilation_context_cache_size_ = compilation_context_cache_size;
@@ -80,6 +108,13 @@ class WorkerSandboxApi : public core::ServiceInterface {
     js_engine_maximum_heap_size_mb_ = js_engine_maximum_heap_size_mb;
     js_engine_max_wasm_memory_number_of_pages_ =
         js_engine_max_wasm_memory_number_of_pages;
+    js_engine_context_pool_size_ = js_engine_context_pool_size;
+    js_engine_context_pool_max_context_uses_ =
+        js_engine_context_pool_max_context_uses;
+    shared_memory_arena_size_mb_ = shared_memory_arena_size_mb;
+    native_js_async_function_names_ = native_js_async_function_names;
+    native_js_function_ids_ = native_js_function_ids;
+    native_js_async_function_ids_ = native_js_async_function_ids;
   }
 
   core::ExecutionResult Init() noexcept override;
@@ -97,12 +132,66 @@ class WorkerSandboxApi : public core::ServiceInterface {
   core::ExecutionResult RunCode(
       ::worker_api::WorkerParamsProto& params) noexcept;
 
+  /**
+   * @brief Send a request to run code to a worker running within a sandbox
+   * through the shared memory arena, without serializing it.
+   *
+   * @param code The code to load, if any.
+   * @param input The inputs of the invocation.
+   * @param metadata The metadata of the request.
+   * @param response The response of the worker.
+   * @param metrics The metrics of the execution in the sandbox.
+   * @return core::ExecutionResult
+   * SC_ROMA_WORKER_API_REQUEST_DOES_NOT_FIT_SHARED_MEMORY if the request is
+   * larger than the arena, in which case RunCode is to be used instead. A
+   * response larger than the arena is passed through a serialized call.
+   */
+  core::ExecutionResult RunCodeInSharedMemory(
+      absl::string_view code, const std::vector<absl::string_view>& input,
+      const std::unordered_map<std::string, std::string>& metadata,
+      std::string& response,
+      std::unordered_map<std::string, int64_t>& metrics) noexcept;
+
+  /**
+   * @brief Create a startup snapshot of the JS engine of the worker running
+   * within the sandbox, which already has the function bindings registered in
+   * it.
+   *
+   * @return core::ExecutionResultOr<std::string> The snapshot, to be passed to
+   * SetStartupSnapshot of the sandboxes to boot from it.
+   */
+  core::ExecutionResultOr<std::string> CreateStartupSnapshot() noexcept;
+
+  /**
+   * @brief Set the startup snapshot the JS engine of the worker is booted from
+   * on the next Init, which includes the restarts of the sandbox.
+   *
+   * @param startup_snapshot
+   */
+  void SetStartupSnapshot(
+      std::shared_ptr<const std::string> startup_snapshot) noexcept {
+    startup_snapshot_ = std::move(startup_snapshot);
+  }
+
+  /// Whether the requests can be sent through the shared memory arena.
+  bool IsSharedMemoryArenaEnabled() const noexcept {
+    return shared_memory_arena_size_mb_ > 0;
+  }
+
   core::ExecutionResult Terminate() noexcept;
 
  protected:
   core::ExecutionResult InternalRunCode(
       ::worker_api::WorkerParamsProto& params) noexcept;
 
+  /**
+   * @brief Reads the response of the last run from shared memory that did not
+   * fit in the arena, through a serialized call.
+   */
+  core::ExecutionResult ReadOversizedResponse(
+      std::string& response,
+      std::unordered_map<std::string, int64_t>& metrics) noexcept;
+
   /**
    * @brief Class to allow overwriting the policy for the SAPI sandbox.
    *
@@ -136,6 +225,9 @@ class WorkerSandboxApi : public core::ServiceInterface {
           .AllowReadlink()
           .AllowMmap()
           .AllowFork()
+          // Waiting for the responses of async function bindings polls the
+          // comms.
+          .AllowPoll()
           .AllowSyscall(__NR_tgkill)
           .AllowSyscall(__NR_recvmsg)
           .AllowSyscall(__NR_sendmsg)
@@ -175,5 +267,14 @@ class WorkerSandboxApi : public core::ServiceInterface {
   size_t js_engine_initial_heap_size_mb_;
   size_t js_engine_maximum_heap_size_mb_;
   size_t js_engine_max_wasm_memory_number_of_pages_;
+  size_t js_engine_context_pool_size_;
+  size_t js_engine_context_pool_max_context_uses_;
+  size_t shared_memory_arena_size_mb_;
+  std::unique_ptr<SharedMemoryArena> shared_memory_arena_;
+  std::unique_ptr<sapi::v::Fd> sapi_shared_memory_arena_fd_;
+  std::shared_ptr<const std::string> startup_snapshot_;
+  std::vector<std::string> native_js_async_function_names_;
+  std::vector<uint32_t> native_js_function_ids_;
+  std::vector<uint32_t> native_js_async_function_ids_;
 };
 }  // namespace google::scp::roma::sandbox::worker_api
@@ -18,9 +18,11 @@
 
 #include <unistd.h>
 
+#include <cstring>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "core/common/time_provider/src/stopwatch.h"
@@ -32,27 +34,45 @@
 #include "roma/sandbox/worker_factory/src/worker_factory.h"
 
 #include "error_codes.h"
+#include "shared_memory_arena.h"
 
 using absl::string_view;
 using google::scp::core::StatusCode;
 using google::scp::core::common::Stopwatch;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_COULD_NOT_CREATE_STARTUP_SNAPSHOT;
 using google::scp::core::errors::
     SC_ROMA_WORKER_API_COULD_NOT_DESERIALIZE_INIT_DATA;
 using google::scp::core::errors::
     SC_ROMA_WORKER_API_COULD_NOT_DESERIALIZE_RUN_CODE_DATA;
 using google::scp::core::errors::
     SC_ROMA_WORKER_API_COULD_NOT_SERIALIZE_RUN_CODE_RESPONSE_DATA;
+using google::scp::core::errors::SC_ROMA_WORKER_API_INVALID_FUNCTION_IDS;
+using google::scp::core::errors::SC_ROMA_WORKER_API_NO_OVERSIZED_RESPONSE;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_RESPONSE_DOES_NOT_FIT_SHARED_MEMORY;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_SHARED_MEMORY_NOT_INITIALIZED;
 using google::scp::core::errors::SC_ROMA_WORKER_API_UNINITIALIZED_WORKER;
+using google::scp::roma::JsContextPoolOptions;
 using google::scp::roma::JsEngineResourceConstraints;
 using google::scp::roma::sandbox::constants::kExecutionMetricJsEngineCallNs;
 using google::scp::roma::sandbox::worker::Worker;
 using google::scp::roma::sandbox::worker::WorkerFactory;
+using google::scp::roma::sandbox::worker_api::SharedMemoryArena;
+using std::make_unique;
+using std::move;
 using std::shared_ptr;
 using std::string;
+using std::unique_ptr;
 using std::unordered_map;
 using std::vector;
 
 shared_ptr<Worker> worker_;
+unique_ptr<SharedMemoryArena> shared_memory_arena_;
+// The response of the last request run from the shared memory, when it did not
+// fit the arena.
+unique_ptr<worker_api::WorkerParamsProto> oversized_response_;
 
 StatusCode Init(worker_api::WorkerInitParamsProto* init_params) {
   if (worker_) {
@@ -73,6 +93,22 @@ StatusCode Init(worker_api::WorkerInitParamsProto* init_params) {
     vector<string> native_js_function_names(
         init_params->native_js_function_names().begin(),
         init_params->native_js_function_names().end());
+    vector<string> native_js_async_function_names(
+        init_params->native_js_async_function_names().begin(),
+        init_params->native_js_async_function_names().end());
+    // The functions are called by the IDs the host assigned to them.
+    if (init_params->native_js_function_ids_size() !=
+            init_params->native_js_function_names_size() ||
+        init_params->native_js_async_function_ids_size() !=
+            init_params->native_js_async_function_names_size()) {
+      return SC_ROMA_WORKER_API_INVALID_FUNCTION_IDS;
+    }
+    vector<uint32_t> native_js_function_ids(
+        init_params->native_js_function_ids().begin(),
+        init_params->native_js_function_ids().end());
+    vector<uint32_t> native_js_async_function_ids(
+        init_params->native_js_async_function_ids().begin(),
+        init_params->native_js_async_function_ids().end());
 
     JsEngineResourceConstraints resource_constraints;
     resource_constraints.initial_heap_size_in_mb =
@@ -80,13 +116,24 @@ StatusCode Init(worker_api::WorkerInitParamsProto* init_params) {
     resource_constraints.maximum_heap_size_in_mb =
         static_cast<size_t>(init_params->js_engine_maximum_heap_size_mb());
 
+    JsContextPoolOptions context_pool_options;
+    context_pool_options.pool_size =
+        static_cast<size_t>(init_params->js_engine_context_pool_size());
+    context_pool_options.max_context_uses = static_cast<size_t>(
+        init_params->js_engine_context_pool_max_context_uses());
+
     WorkerFactory::V8WorkerEngineParams v8_params{
         .native_js_function_comms_fd =
             init_params->native_js_function_comms_fd(),
         .native_js_function_names = native_js_function_names,
         .resource_constraints = resource_constraints,
         .max_wasm_memory_number_of_pages = static_cast<size_t>(
-            init_params->js_engine_max_wasm_memory_number_of_pages())};
+            init_params->js_engine_max_wasm_memory_number_of_pages()),
+        .context_pool_options = context_pool_options,
+        .startup_snapshot = init_params->js_engine_startup_snapshot(),
+        .native_js_async_function_names = native_js_async_function_names,
+        .native_js_function_ids = native_js_function_ids,
+        .native_js_async_function_ids = native_js_async_function_ids};
 
     factory_params.v8_worker_engine_params = v8_params;
   }
@@ -98,6 +145,17 @@ StatusCode Init(worker_api::WorkerInitParamsProto* init_params) {
 
   worker_ = *worker_or;
 
+  shared_memory_arena_.reset();
+  if (init_params->shared_memory_arena_size() > 0) {
+    auto arena_or = SharedMemoryArena::Map(
+        init_params->shared_memory_arena_fd(),
+        static_cast<size_t>(init_params->shared_memory_arena_size()));
+    if (!arena_or.result().Successful()) {
+      return arena_or.result().status_code;
+    }
+    shared_memory_arena_ = move(*arena_or);
+  }
+
   return worker_->Init().status_code;
 }
 
@@ -142,12 +200,13 @@ StatusCode RunCode(worker_api::WorkerParamsProto* params) {
     metadata[element.first] = element.second;
   }
 
+  unordered_map<string, int64_t> metrics;
   Stopwatch stopwatch;
   stopwatch.Start();
-  auto response_or = worker_->RunCode(code, input, metadata);
+  auto response_or = worker_->RunCode(code, input, metadata, &metrics);
   auto run_code_elapsed_ns = stopwatch.Stop();
-  (*params->mutable_metrics())[kExecutionMetricJsEngineCallNs] =
-      run_code_elapsed_ns.count();
+  metrics[kExecutionMetricJsEngineCallNs] = run_code_elapsed_ns.count();
+  params->mutable_metrics()->insert(metrics.begin(), metrics.end());
 
   if (!response_or.result().Successful()) {
     return response_or.result().status_code;
@@ -190,3 +249,95 @@ StatusCode RunCodeFromSerializedData(sapi::LenValStruct* data) {
 
   return result;
 }
+
+StatusCode CreateStartupSnapshot(sapi::LenValStruct* data) {
+  if (!worker_) {
+    return SC_ROMA_WORKER_API_UNINITIALIZED_WORKER;
+  }
+
+  auto startup_snapshot_or = worker_->CreateStartupSnapshot();
+  if (!startup_snapshot_or.result().Successful()) {
+    return startup_snapshot_or.result().status_code;
+  }
+
+  auto snapshot_data =
+      static_cast<uint8_t*>(malloc(startup_snapshot_or->size()));
+  if (!snapshot_data) {
+    return SC_ROMA_WORKER_API_COULD_NOT_CREATE_STARTUP_SNAPSHOT;
+  }
+  memcpy(snapshot_data, startup_snapshot_or->data(),
+         startup_snapshot_or->size());
+
+  free(data->data);
+
+  data->data = snapshot_data;
+  data->size = startup_snapshot_or->size();
+
+  return SC_OK;
+}
+
+StatusCode RunCodeFromSharedMemory() {
+  if (!worker_) {
+    return SC_ROMA_WORKER_API_UNINITIALIZED_WORKER;
+  }
+  if (!shared_memory_arena_) {
+    return SC_ROMA_WORKER_API_SHARED_MEMORY_NOT_INITIALIZED;
+  }
+
+  // The inputs are read in place, without being copied out of the arena.
+  string_view code;
+  vector<string_view> input;
+  unordered_map<string, string> metadata;
+  auto result = shared_memory_arena_->ReadRequest(code, input, metadata);
+  if (!result.Successful()) {
+    return result.status_code;
+  }
+
+  unordered_map<string, int64_t> metrics;
+  Stopwatch stopwatch;
+  stopwatch.Start();
+  auto response_or = worker_->RunCode(string(code), input, metadata, &metrics);
+  metrics[kExecutionMetricJsEngineCallNs] = stopwatch.Stop().count();
+
+  if (!response_or.result().Successful()) {
+    return response_or.result().status_code;
+  }
+
+  oversized_response_.reset();
+  result = shared_memory_arena_->WriteResponse(*response_or, metrics);
+  if (result.status_code ==
+      SC_ROMA_WORKER_API_RESPONSE_DOES_NOT_FIT_SHARED_MEMORY) {
+    // The code already ran, so the response is handed over through the
+    // serialized call instead of running the request again.
+    oversized_response_ = make_unique<worker_api::WorkerParamsProto>();
+    oversized_response_->set_response(move(*response_or));
+    oversized_response_->mutable_metrics()->insert(metrics.begin(),
+                                                    metrics.end());
+  }
+  return result.status_code;
+}
+
+StatusCode ReadOversizedResponse(sapi::LenValStruct* data) {
+  if (!oversized_response_) {
+    return SC_ROMA_WORKER_API_NO_OVERSIZED_RESPONSE;
+  }
+
+  int serialized_size = oversized_response_->ByteSizeLong();
+  uint8_t* serialized_data = static_cast<uint8_t*>(malloc(serialized_size));
+  if (!serialized_data) {
+    return SC_ROMA_WORKER_API_COULD_NOT_SERIALIZE_RUN_CODE_RESPONSE_DATA;
+  }
+  if (!oversized_response_->SerializeToArray(serialized_data,
+                                             serialized_size)) {
+    free(serialized_data);
+    return SC_ROMA_WORKER_API_COULD_NOT_SERIALIZE_RUN_CODE_RESPONSE_DATA;
+  }
+  oversized_response_.reset();
+
+  free(data->data);
+
+  data->data = serialized_data;
+  data->size = serialized_size;
+
+  return SC_OK;
+}
@@ -41,3 +41,19 @@ extern "C" google::scp::core::StatusCode RunCode(
 
 extern "C" google::scp::core::StatusCode RunCodeFromSerializedData(
     sapi::LenValStruct* data);
+
+// Creates a startup snapshot of the JS engine of the worker, which other
+// workers can be booted from, and returns it in the data.
+extern "C" google::scp::core::StatusCode CreateStartupSnapshot(
+    sapi::LenValStruct* data);
+
+// Runs the request written in the shared memory arena, and writes the response
+// over it. If the response does not fit the arena, the call fails with
+// SC_ROMA_WORKER_API_RESPONSE_DOES_NOT_FIT_SHARED_MEMORY and the response is
+// kept for ReadOversizedResponse.
+extern "C" google::scp::core::StatusCode RunCodeFromSharedMemory();
+
+// Returns the serialized WorkerParamsProto with the response and metrics of
+// the last request run from the shared memory, when they did not fit the arena.
+extern "C" google::scp::core::StatusCode ReadOversizedResponse(
+    sapi::LenValStruct* data);
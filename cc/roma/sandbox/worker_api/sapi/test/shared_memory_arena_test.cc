@@ -0,0 +1,105 @@
+/*
+ * Copyright 2023 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "roma/sandbox/worker_api/sapi/src/shared_memory_arena.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "public/core/test/interface/execution_result_matchers.h"
+#include "roma/sandbox/worker_api/sapi/src/error_codes.h"
+
+using absl::string_view;
+using google::scp::core::FailureExecutionResult;
+using google::scp::core::errors::SC_ROMA_WORKER_API_INVALID_SHARED_MEMORY_DATA;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_REQUEST_DOES_NOT_FIT_SHARED_MEMORY;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_RESPONSE_DOES_NOT_FIT_SHARED_MEMORY;
+using google::scp::core::test::ResultIs;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+namespace google::scp::roma::sandbox::worker_api::test {
+TEST(SharedMemoryArenaTest, ExchangesTheRequestInPlace) {
+  auto arena_or = SharedMemoryArena::Create(4096);
+  ASSERT_SUCCESS(arena_or.result());
+  auto& arena = **arena_or;
+
+  string large_input(1000, 'a');
+  ASSERT_SUCCESS(arena.WriteRequest("function Handler() {}",
+                                    {"\"input\"", large_input, ""},
+                                    {{"roma.request.id", "id"}}));
+
+  // The other side maps the same memory.
+  auto mapped_arena_or =
+      SharedMemoryArena::Map(dup(arena.GetFd()), arena.GetSize());
+  ASSERT_SUCCESS(mapped_arena_or.result());
+  auto& mapped_arena = **mapped_arena_or;
+
+  string_view code;
+  vector<string_view> input;
+  unordered_map<string, string> metadata;
+  ASSERT_SUCCESS(mapped_arena.ReadRequest(code, input, metadata));
+  EXPECT_EQ(code, "function Handler() {}");
+  EXPECT_EQ(input, vector<string_view>({"\"input\"", large_input, ""}));
+  EXPECT_EQ(metadata,
+            (unordered_map<string, string>{{"roma.request.id", "id"}}));
+
+  ASSERT_SUCCESS(
+      mapped_arena.WriteResponse("\"response\"", {{"roma.metric", -5}}));
+  string response;
+  unordered_map<string, int64_t> metrics;
+  ASSERT_SUCCESS(arena.ReadResponse(response, metrics));
+  EXPECT_EQ(response, "\"response\"");
+  EXPECT_EQ(metrics, (unordered_map<string, int64_t>{{"roma.metric", -5}}));
+}
+
+TEST(SharedMemoryArenaTest, FailsWhenTheDataDoesNotFit) {
+  auto arena_or = SharedMemoryArena::Create(64);
+  ASSERT_SUCCESS(arena_or.result());
+  auto& arena = **arena_or;
+
+  string large_input(100, 'a');
+  EXPECT_THAT(arena.WriteRequest("", {large_input}, {}),
+              ResultIs(FailureExecutionResult(
+                  SC_ROMA_WORKER_API_REQUEST_DOES_NOT_FIT_SHARED_MEMORY)));
+  EXPECT_THAT(arena.WriteResponse(large_input, {}),
+              ResultIs(FailureExecutionResult(
+                  SC_ROMA_WORKER_API_RESPONSE_DOES_NOT_FIT_SHARED_MEMORY)));
+}
+
+TEST(SharedMemoryArenaTest, RejectsMalformedData) {
+  auto arena_or = SharedMemoryArena::Create(64);
+  ASSERT_SUCCESS(arena_or.result());
+  auto& arena = **arena_or;
+
+  // Read as a request, the metric value is a metadata count larger than what
+  // the arena can hold.
+  ASSERT_SUCCESS(arena.WriteResponse("", {{"", -1}}));
+  string_view code;
+  vector<string_view> input;
+  unordered_map<string, string> metadata;
+  EXPECT_THAT(arena.ReadRequest(code, input, metadata),
+              ResultIs(FailureExecutionResult(
+                  SC_ROMA_WORKER_API_INVALID_SHARED_MEMORY_DATA)));
+}
+}  // namespace google::scp::roma::sandbox::worker_api::test
@@ -27,6 +27,7 @@
 #include "cc/roma/interface/function_binding_io.pb.h"
 #include "public/core/test/interface/execution_result_matchers.h"
 #include "roma/sandbox/constants/constants.h"
+#include "roma/sandbox/native_function_binding/src/function_binding_frame.h"
 #include "roma/sandbox/worker_factory/src/worker_factory.h"
 
 using google::scp::roma::proto::FunctionBindingIoProto;
@@ -36,6 +37,8 @@ using google::scp::roma::sandbox::constants::kRequestAction;
 using google::scp::roma::sandbox::constants::kRequestActionExecute;
 using google::scp::roma::sandbox::constants::kRequestType;
 using google::scp::roma::sandbox::constants::kRequestTypeJavascript;
+using google::scp::roma::sandbox::native_function_binding::
+    FunctionBindingFrame;
 using google::scp::roma::sandbox::worker::WorkerFactory;
 using std::string;
 using std::thread;
@@ -97,7 +100,11 @@ TEST(WorkerSandboxApiTest, WorkerCanCallHooksThroughSandbox) {
   WorkerSandboxApi sandbox_api(
       WorkerFactory::WorkerEngine::v8, false /*require_preload*/,
       5 /*compilation_context_cache_size*/,
-      fds[1] /*native_js_function_comms_fd*/, {"my_great_func"}, 0, 0, 0, 0);
+      fds[1] /*native_js_function_comms_fd*/, {"my_great_func"}, 0, 0, 0, 0,
+      0 /*js_engine_context_pool_size*/,
+      JsContextPoolOptions().max_context_uses,
+      0 /*shared_memory_arena_size_mb*/, {} /*native_js_async_function_names*/,
+      {7} /*native_js_function_ids*/);
 
   auto result = sandbox_api.Init();
   EXPECT_SUCCESS(result);
@@ -105,13 +112,16 @@ TEST(WorkerSandboxApiTest, WorkerCanCallHooksThroughSandbox) {
   thread to_handle_function_call(
       [](int fd) {
         sandbox2::Comms comms(fd);
+        FunctionBindingFrame::Header header;
         FunctionBindingIoProto io_proto;
-        EXPECT_TRUE(comms.RecvProtoBuf(&io_proto));
+        EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
+        // The function is called by the ID it was given.
+        EXPECT_EQ(header.function_id, 7);
 
         auto result = "from C++ " + io_proto.input_string();
         io_proto.set_output_string(result);
 
-        EXPECT_TRUE(comms.SendProtoBuf(io_proto));
+        EXPECT_TRUE(FunctionBindingFrame::Send(comms, header, io_proto));
       },
       fds[0]);
 
@@ -143,10 +153,12 @@ class WorkerSandboxApiForTests : public WorkerSandboxApi {
   WorkerSandboxApiForTests(
       const worker::WorkerFactory::WorkerEngine& worker_engine,
       bool require_preload, int native_js_function_comms_fd,
-      const std::vector<std::string>& native_js_function_names)
+      const std::vector<std::string>& native_js_function_names,
+      const std::vector<uint32_t>& native_js_function_ids = {})
       : WorkerSandboxApi(worker_engine, require_preload, 5,
                          native_js_function_comms_fd, native_js_function_names,
-                         0, 0, 0, 0) {}
+                         0, 0, 0, 0, 0, JsContextPoolOptions().max_context_uses,
+                         0, {}, native_js_function_ids) {}
 
   ::sapi::Sandbox* GetUnderlyingSandbox() { return worker_sapi_sandbox_.get(); }
 };
@@ -198,7 +210,8 @@ TEST(WorkerSandboxApiTest,
   WorkerSandboxApiForTests sandbox_api(
       WorkerFactory::WorkerEngine::v8, false /*require_preload*/,
       fds[1] /*native_js_function_comms_fd*/,
-      {"my_great_func"} /*native_js_function_names*/);
+      {"my_great_func"} /*native_js_function_names*/,
+      {0} /*native_js_function_ids*/);
 
   auto result = sandbox_api.Init();
   EXPECT_SUCCESS(result);
@@ -206,13 +219,14 @@ TEST(WorkerSandboxApiTest,
   thread to_handle_function_call(
       [](int fd) {
         sandbox2::Comms comms(fd);
+        FunctionBindingFrame::Header header;
         FunctionBindingIoProto io_proto;
-        EXPECT_TRUE(comms.RecvProtoBuf(&io_proto));
+        EXPECT_TRUE(FunctionBindingFrame::Receive(comms, header, io_proto));
 
         auto result = "from C++ hook :) " + io_proto.input_string();
         io_proto.set_output_string(result);
 
-        EXPECT_TRUE(comms.SendProtoBuf(io_proto));
+        EXPECT_TRUE(FunctionBindingFrame::Send(comms, header, io_proto));
       },
       fds[0]);
 
@@ -18,8 +18,19 @@
 
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/string_view.h"
 #include "public/core/test/interface/execution_result_matchers.h"
 #include "roma/sandbox/constants/constants.h"
+#include "roma/sandbox/worker_api/sapi/src/error_codes.h"
+#include "roma/sandbox/worker_api/sapi/src/shared_memory_arena.h"
 #include "roma/sandbox/worker_api/sapi/src/worker_init_params.pb.h"
 #include "roma/sandbox/worker_factory/src/worker_factory.h"
 
@@ -30,6 +41,13 @@ using google::scp::roma::sandbox::constants::kRequestActionExecute;
 using google::scp::roma::sandbox::constants::kRequestType;
 using google::scp::roma::sandbox::constants::kRequestTypeJavascript;
 using google::scp::roma::sandbox::worker::WorkerFactory;
+using absl::string_view;
+using google::scp::core::errors::SC_ROMA_WORKER_API_INVALID_FUNCTION_IDS;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_RESPONSE_DOES_NOT_FIT_SHARED_MEMORY;
+using std::string;
+using std::unordered_map;
+using std::vector;
 
 namespace google::scp::roma::sandbox::worker_api::test {
 static ::worker_api::WorkerInitParamsProto GetDefaultInitParams() {
@@ -97,4 +115,105 @@ TEST(WorkerWrapperTest, FailsToRunCodeWhenPreloadIsRequiredAndExecuteIsSent) {
   result = ::Stop();
   EXPECT_EQ(SC_OK, result);
 }
+
+TEST(WorkerWrapperTest, FailsToInitWhenFunctionIdsDoNotMatchTheNames) {
+  auto init_params = GetDefaultInitParams();
+  init_params.add_native_js_function_names("cool_func");
+  auto result = ::Init(&init_params);
+  EXPECT_EQ(SC_ROMA_WORKER_API_INVALID_FUNCTION_IDS, result);
+
+  init_params.add_native_js_function_ids(0);
+  result = ::Init(&init_params);
+  EXPECT_EQ(SC_OK, result);
+
+  result = ::Stop();
+  EXPECT_EQ(SC_OK, result);
+}
+
+TEST(WorkerWrapperTest, CanRunCodeFromSharedMemory) {
+  auto arena_or = SharedMemoryArena::Create(1024 * 1024);
+  ASSERT_SUCCESS(arena_or.result());
+  auto& arena = *arena_or;
+
+  auto init_params = GetDefaultInitParams();
+  init_params.set_shared_memory_arena_fd(dup(arena->GetFd()));
+  init_params.set_shared_memory_arena_size(arena->GetSize());
+  auto result = ::Init(&init_params);
+  EXPECT_EQ(SC_OK, result);
+
+  result = ::Run();
+  EXPECT_EQ(SC_OK, result);
+
+  unordered_map<string, string> metadata = {
+      {kRequestType, kRequestTypeJavascript},
+      {kHandlerName, "cool_func"},
+      {kCodeVersion, "1"},
+      {kRequestAction, kRequestActionExecute}};
+  vector<string_view> input = {"\"JS\""};
+  ASSERT_SUCCESS(arena->WriteRequest(
+      "function cool_func(name) { return \"Hi there from \" + name }", input,
+      metadata));
+
+  result = ::RunCodeFromSharedMemory();
+  EXPECT_EQ(SC_OK, result);
+
+  string response;
+  unordered_map<string, int64_t> metrics;
+  ASSERT_SUCCESS(arena->ReadResponse(response, metrics));
+  EXPECT_EQ(response, "\"Hi there from JS\"");
+  EXPECT_FALSE(metrics.empty());
+
+  result = ::Stop();
+  EXPECT_EQ(SC_OK, result);
+}
+
+TEST(WorkerWrapperTest,
+     HandsOverResponseThatDoesNotFitSharedMemoryThroughSerializedCall) {
+  auto arena_or = SharedMemoryArena::Create(4096);
+  ASSERT_SUCCESS(arena_or.result());
+  auto& arena = *arena_or;
+
+  auto init_params = GetDefaultInitParams();
+  init_params.set_shared_memory_arena_fd(dup(arena->GetFd()));
+  init_params.set_shared_memory_arena_size(arena->GetSize());
+  auto result = ::Init(&init_params);
+  EXPECT_EQ(SC_OK, result);
+
+  result = ::Run();
+  EXPECT_EQ(SC_OK, result);
+
+  // Nothing to read before a response did not fit.
+  sapi::LenValStruct data;
+  data.size = 0;
+  data.data = nullptr;
+  EXPECT_NE(SC_OK, ::ReadOversizedResponse(&data));
+
+  unordered_map<string, string> metadata = {
+      {kRequestType, kRequestTypeJavascript},
+      {kHandlerName, "cool_func"},
+      {kCodeVersion, "1"},
+      {kRequestAction, kRequestActionExecute}};
+  ASSERT_SUCCESS(arena->WriteRequest(
+      "function cool_func() { return \"x\".repeat(10000) }", {}, metadata));
+
+  result = ::RunCodeFromSharedMemory();
+  EXPECT_EQ(SC_ROMA_WORKER_API_RESPONSE_DOES_NOT_FIT_SHARED_MEMORY, result);
+
+  result = ::ReadOversizedResponse(&data);
+  EXPECT_EQ(SC_OK, result);
+
+  ::worker_api::WorkerParamsProto response_proto;
+  EXPECT_TRUE(response_proto.ParseFromArray(data.data, data.size));
+  free(data.data);
+  EXPECT_EQ(response_proto.response(), "\"" + string(10000, 'x') + "\"");
+  EXPECT_FALSE(response_proto.metrics().empty());
+
+  // The response is handed over once.
+  data.size = 0;
+  data.data = nullptr;
+  EXPECT_NE(SC_OK, ::ReadOversizedResponse(&data));
+
+  result = ::Stop();
+  EXPECT_EQ(SC_OK, result);
+}
 }  // namespace google::scp::roma::sandbox::worker_api::test
@@ -24,16 +24,20 @@
 #include "core/common/time_provider/src/stopwatch.h"
 #include "public/core/interface/execution_result.h"
 #include "roma/sandbox/constants/constants.h"
+#include "roma/sandbox/worker_api/sapi/src/error_codes.h"
 
 using google::scp::core::ExecutionResult;
 using google::scp::core::ExecutionResultOr;
 using google::scp::core::common::Stopwatch;
+using google::scp::core::errors::
+    SC_ROMA_WORKER_API_REQUEST_DOES_NOT_FIT_SHARED_MEMORY;
 using google::scp::roma::sandbox::constants::
     kExecutionMetricSandboxedJsEngineCallNs;
 using std::lock_guard;
 using std::make_shared;
 using std::move;
 using std::mutex;
+using std::shared_ptr;
 using std::string;
 
 namespace google::scp::roma::sandbox::worker_api {
@@ -49,10 +53,43 @@ ExecutionResult WorkerApiSapi::Stop() noexcept {
   return sandbox_api_->Stop();
 }
 
+ExecutionResultOr<string> WorkerApiSapi::CreateStartupSnapshot() noexcept {
+  lock_guard<mutex> lock(run_code_mutex_);
+  return sandbox_api_->CreateStartupSnapshot();
+}
+
+void WorkerApiSapi::SetStartupSnapshot(
+    shared_ptr<const string> startup_snapshot) noexcept {
+  lock_guard<mutex> lock(run_code_mutex_);
+  sandbox_api_->SetStartupSnapshot(move(startup_snapshot));
+}
+
 ExecutionResultOr<WorkerApi::RunCodeResponse> WorkerApiSapi::RunCode(
     const WorkerApi::RunCodeRequest& request) noexcept {
   lock_guard<mutex> lock(run_code_mutex_);
 
+  if (sandbox_api_->IsSharedMemoryArenaEnabled()) {
+    WorkerApi::RunCodeResponse code_response;
+    string response;
+    Stopwatch stopwatch;
+    stopwatch.Start();
+    auto result = sandbox_api_->RunCodeInSharedMemory(
+        request.code, request.input, request.metadata, response,
+        code_response.metrics);
+    auto run_code_elapsed_ns = stopwatch.Stop();
+    if (result.Successful()) {
+      code_response.metrics[kExecutionMetricSandboxedJsEngineCallNs] =
+          run_code_elapsed_ns.count();
+      code_response.response = make_shared<string>(move(response));
+      return code_response;
+    }
+    // A request larger than the arena is serialized instead.
+    if (result.status_code !=
+        SC_ROMA_WORKER_API_REQUEST_DOES_NOT_FIT_SHARED_MEMORY) {
+      return result;
+    }
+  }
+
   ::worker_api::WorkerParamsProto params_proto;
   params_proto.set_code(string(request.code));
   params_proto.mutable_input()->Add(request.input.begin(), request.input.end());
@@ -38,6 +38,17 @@ struct WorkerApiSapiConfig {
   size_t max_worker_virtual_memory_mb;
   JsEngineResourceConstraints js_engine_resource_constraints;
   size_t js_engine_max_wasm_memory_number_of_pages;
+  JsContextPoolOptions js_engine_context_pool_options;
+  size_t shared_memory_arena_size_mb = 0;
+  // Whether to boot the sandbox from a startup snapshot which the worker pool
+  // creates once in the first sandbox.
+  bool boot_from_startup_snapshot = false;
+  // The names of the functions which return a promise in JS.
+  std::vector<std::string> native_js_async_function_names;
+  // The IDs by which the functions of native_js_function_names and
+  // native_js_async_function_names are called, in the same order.
+  std::vector<uint32_t> native_js_function_ids;
+  std::vector<uint32_t> native_js_async_function_ids;
 };
 
 class WorkerApiSapi : public WorkerApi {
@@ -50,7 +61,12 @@ class WorkerApiSapi : public WorkerApi {
         config.max_worker_virtual_memory_mb,
         config.js_engine_resource_constraints.initial_heap_size_in_mb,
         config.js_engine_resource_constraints.maximum_heap_size_in_mb,
-        config.js_engine_max_wasm_memory_number_of_pages);
+        config.js_engine_max_wasm_memory_number_of_pages,
+        config.js_engine_context_pool_options.pool_size,
+        config.js_engine_context_pool_options.max_context_uses,
+        config.shared_memory_arena_size_mb,
+        config.native_js_async_function_names, config.native_js_function_ids,
+        config.native_js_async_function_ids);
   }
 
   core::ExecutionResult Init() noexcept override;
@@ -64,6 +80,13 @@ class WorkerApiSapi : public WorkerApi {
 
   core::ExecutionResult Terminate() noexcept override;
 
+  /// Create a startup snapshot of the JS engine within the sandbox.
+  core::ExecutionResultOr<std::string> CreateStartupSnapshot() noexcept;
+
+  /// Set the startup snapshot the sandbox is booted from on the next Init.
+  void SetStartupSnapshot(
+      std::shared_ptr<const std::string> startup_snapshot) noexcept;
+
  private:
   std::unique_ptr<WorkerSandboxApi> sandbox_api_;
   std::mutex run_code_mutex_;
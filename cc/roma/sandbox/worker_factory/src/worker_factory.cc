@@ -64,10 +64,15 @@ ExecutionResultOr<shared_ptr<Worker>> WorkerFactory::Create(
     vector<shared_ptr<V8IsolateVisitor>> isolate_visitors = {
         make_shared<V8IsolateVisitorFunctionBinding>(
             params.v8_worker_engine_params.native_js_function_names,
-            native_function_invoker)};
+            native_function_invoker,
+            params.v8_worker_engine_params.native_js_async_function_names,
+            params.v8_worker_engine_params.native_js_function_ids,
+            params.v8_worker_engine_params.native_js_async_function_ids)};
 
     auto v8_engine = make_shared<V8JsEngine>(
-        isolate_visitors, params.v8_worker_engine_params.resource_constraints);
+        isolate_visitors, params.v8_worker_engine_params.resource_constraints,
+        params.v8_worker_engine_params.context_pool_options,
+        params.v8_worker_engine_params.startup_snapshot);
 
     auto one_time_setup = GetEngineOneTimeSetup(params);
     v8_engine->OneTimeSetup(one_time_setup);
@@ -34,6 +34,15 @@ class WorkerFactory {
     std::vector<std::string> native_js_function_names;
     JsEngineResourceConstraints resource_constraints;
     size_t max_wasm_memory_number_of_pages;
+    JsContextPoolOptions context_pool_options;
+    // The startup snapshot to boot the engine from, if not empty.
+    std::string startup_snapshot;
+    // The names of the functions whose calls return a promise.
+    std::vector<std::string> native_js_async_function_names;
+    // The IDs by which the functions of native_js_function_names and
+    // native_js_async_function_names are called, in the same order.
+    std::vector<uint32_t> native_js_function_ids;
+    std::vector<uint32_t> native_js_async_function_ids;
   };
 
   struct FactoryParams {
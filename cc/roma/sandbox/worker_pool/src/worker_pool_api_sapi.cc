@@ -16,6 +16,9 @@
 
 #include "worker_pool_api_sapi.h"
 
+#include <memory>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "error_codes.h"
@@ -25,6 +28,14 @@ using google::scp::core::ExecutionResultOr;
 using google::scp::core::FailureExecutionResult;
 using google::scp::core::SuccessExecutionResult;
 using google::scp::core::errors::SC_ROMA_WORKER_POOL_WORKER_INDEX_OUT_OF_BOUNDS;
+using google::scp::roma::sandbox::worker_api::WorkerApi;
+using google::scp::roma::sandbox::worker_api::WorkerApiSapi;
+using std::function;
+using std::make_shared;
+using std::move;
+using std::static_pointer_cast;
+using std::string;
+using std::thread;
 using std::vector;
 
 static constexpr char kConfigAndPoolSizeDoNotMatch[] =
@@ -38,6 +49,8 @@ WorkerPoolApiSapi::WorkerPoolApiSapi(
   }
 
   size_ = size;
+  boot_from_startup_snapshot_ =
+      !config.empty() && config.front().boot_from_startup_snapshot;
   for (auto i = 0; i < size_; i++) {
     workers_.push_back(
         std::make_shared<worker_api::WorkerApiSapi>(config.at(i)));
@@ -45,19 +58,57 @@ WorkerPoolApiSapi::WorkerPoolApiSapi(
 }
 
 ExecutionResult WorkerPoolApiSapi::Init() noexcept {
-  for (auto& w : workers_) {
-    auto result = w->Init();
-    if (!result.Successful()) {
-      return result;
-    }
+  if (boot_from_startup_snapshot_ && size_ > 0) {
+    return InitFromStartupSnapshot();
   }
 
-  return SuccessExecutionResult();
+  return ForEachWorkerConcurrently(
+      0, [](WorkerApi& worker) { return worker.Init(); });
 }
 
 ExecutionResult WorkerPoolApiSapi::Run() noexcept {
-  for (auto& w : workers_) {
-    auto result = w->Run();
+  return ForEachWorkerConcurrently(
+      0, [](WorkerApi& worker) { return worker.Run(); });
+}
+
+ExecutionResult WorkerPoolApiSapi::InitFromStartupSnapshot() noexcept {
+  auto first_worker = static_pointer_cast<WorkerApiSapi>(workers_.front());
+  auto result = first_worker->Init();
+  if (!result.Successful()) {
+    return result;
+  }
+
+  auto startup_snapshot_or = first_worker->CreateStartupSnapshot();
+  if (!startup_snapshot_or.result().Successful()) {
+    return startup_snapshot_or.result();
+  }
+
+  // The workers share the snapshot, which also boots them on restarts.
+  auto startup_snapshot =
+      make_shared<const string>(move(*startup_snapshot_or));
+  for (auto& worker : workers_) {
+    static_pointer_cast<WorkerApiSapi>(worker)->SetStartupSnapshot(
+        startup_snapshot);
+  }
+
+  return ForEachWorkerConcurrently(
+      1, [](WorkerApi& worker) { return worker.Init(); });
+}
+
+ExecutionResult WorkerPoolApiSapi::ForEachWorkerConcurrently(
+    size_t first_index,
+    const function<ExecutionResult(WorkerApi&)>& worker_function) noexcept {
+  vector<ExecutionResult> results(size_, SuccessExecutionResult());
+  vector<thread> threads;
+  for (size_t i = first_index; i < size_; i++) {
+    threads.emplace_back(
+        [&, i]() { results.at(i) = worker_function(*workers_.at(i)); });
+  }
+  for (auto& worker_thread : threads) {
+    worker_thread.join();
+  }
+
+  for (auto& result : results) {
     if (!result.Successful()) {
       return result;
     }
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -31,7 +32,10 @@ namespace google::scp::roma::sandbox::worker_pool {
 class WorkerPoolApiSapi : public WorkerPool {
  public:
   /**
-   * @brief Construct a new Worker Pool Api Sapi object
+   * @brief Construct a new Worker Pool Api Sapi object. The workers are
+   * brought up concurrently, and if the first config has
+   * boot_from_startup_snapshot set, the first worker creates a startup
+   * snapshot which the others are booted from.
    *
    * @param config The configs for the worker API objects.
    * @param size The size of the pool.
@@ -51,7 +55,30 @@ class WorkerPoolApiSapi : public WorkerPool {
       size_t index) noexcept override;
 
  protected:
+  /**
+   * @brief Runs the function for each of the workers from the first index on,
+   * on a thread per worker.
+   *
+   * @param first_index The index of the first worker to run it for.
+   * @param worker_function The function to run for a worker.
+   * @return core::ExecutionResult The first failure in the order of the
+   * workers, if any.
+   */
+  core::ExecutionResult ForEachWorkerConcurrently(
+      size_t first_index,
+      const std::function<core::ExecutionResult(worker_api::WorkerApi&)>&
+          worker_function) noexcept;
+
+  /**
+   * @brief Brings up the first worker, and boots the rest of the workers from
+   * the startup snapshot it creates.
+   *
+   * @return core::ExecutionResult
+   */
+  core::ExecutionResult InitFromStartupSnapshot() noexcept;
+
   size_t size_;
+  bool boot_from_startup_snapshot_;
   std::vector<std::shared_ptr<worker_api::WorkerApi>> workers_;
 };
 }  // namespace google::scp::roma::sandbox::worker_pool
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2022 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/common/time_provider/src/time_provider.h"
+#include "public/core/test/interface/execution_result_matchers.h"
+#include "roma/sandbox/constants/constants.h"
+#include "roma/sandbox/worker_api/src/worker_api_sapi.h"
+#include "roma/sandbox/worker_pool/src/worker_pool_api_sapi.h"
+
+using google::scp::core::common::TimeProvider;
+using google::scp::roma::sandbox::constants::kCodeVersion;
+using google::scp::roma::sandbox::constants::kHandlerName;
+using google::scp::roma::sandbox::constants::kRequestAction;
+using google::scp::roma::sandbox::constants::kRequestActionLoad;
+using google::scp::roma::sandbox::constants::kRequestType;
+using google::scp::roma::sandbox::constants::kRequestTypeJavascript;
+using google::scp::roma::sandbox::worker_api::WorkerApi;
+using google::scp::roma::sandbox::worker_api::WorkerApiSapi;
+using google::scp::roma::sandbox::worker_api::WorkerApiSapiConfig;
+using std::cout;
+using std::endl;
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace google::scp::roma::sandbox::worker_pool::test {
+namespace {
+constexpr size_t kWorkerCounts[] = {1, 2, 4, 8, 16};
+
+vector<WorkerApiSapiConfig> GetConfigs(size_t worker_count,
+                                       bool boot_from_startup_snapshot) {
+  vector<WorkerApiSapiConfig> configs;
+  for (size_t i = 0; i < worker_count; i++) {
+    WorkerApiSapiConfig config;
+    config.worker_js_engine = worker::WorkerFactory::WorkerEngine::v8;
+    config.js_engine_require_code_preload = true;
+    config.compilation_context_cache_size = 5;
+    config.native_js_function_comms_fd = -1;
+    config.native_js_function_names = vector<string>();
+    config.max_worker_virtual_memory_mb = 0;
+    config.js_engine_resource_constraints.initial_heap_size_in_mb = 0;
+    config.js_engine_resource_constraints.maximum_heap_size_in_mb = 0;
+    config.js_engine_max_wasm_memory_number_of_pages = 0;
+    config.js_engine_context_pool_options.pool_size = 0;
+    config.js_engine_context_pool_options.max_context_uses = 0;
+    config.shared_memory_arena_size_mb = 0;
+    config.boot_from_startup_snapshot = boot_from_startup_snapshot;
+    configs.push_back(config);
+  }
+  return configs;
+}
+
+/// Loads the code in the worker, as the worker is not ready to serve requests
+/// until then.
+void LoadCode(WorkerApi& worker) {
+  WorkerApi::RunCodeRequest request = {
+      .code = "function Handler(input) { return input; }",
+      .metadata = {{kRequestType, kRequestTypeJavascript},
+                   {kHandlerName, "Handler"},
+                   {kCodeVersion, "1"},
+                   {kRequestAction, kRequestActionLoad}}};
+  auto response_or = worker.RunCode(request);
+  EXPECT_SUCCESS(response_or.result());
+}
+
+void ReportStartupTime(const string& mode, size_t worker_count,
+                       int64_t elapsed_ns) {
+  cout << mode << ", " << worker_count
+       << " workers: " << elapsed_ns / 1000 / 1000 << " ms to start" << endl;
+}
+}  // namespace
+
+/**
+ * @brief Reports the time from constructing the workers until every one of
+ * them has loaded a code version, when they are brought up one after another
+ * as the pool used to do.
+ */
+TEST(WorkerPoolBenchmarkTest, SequentialStartup) {
+  GTEST_SKIP();
+  for (auto worker_count : kWorkerCounts) {
+    auto start = TimeProvider::GetSteadyTimestampInNanoseconds();
+    vector<shared_ptr<WorkerApiSapi>> workers;
+    for (auto& config : GetConfigs(worker_count, false)) {
+      auto worker = make_shared<WorkerApiSapi>(config);
+      EXPECT_SUCCESS(worker->Init());
+      EXPECT_SUCCESS(worker->Run());
+      workers.push_back(worker);
+    }
+    for (auto& worker : workers) {
+      LoadCode(*worker);
+    }
+    auto elapsed_ns =
+        (TimeProvider::GetSteadyTimestampInNanoseconds() - start).count();
+    ReportStartupTime("Sequential", worker_count, elapsed_ns);
+
+    for (auto& worker : workers) {
+      EXPECT_SUCCESS(worker->Stop());
+    }
+  }
+}
+
+/**
+ * @brief Reports the same startup time for the pool, which brings the workers
+ * up concurrently, with and without the startup snapshot.
+ */
+TEST(WorkerPoolBenchmarkTest, ConcurrentStartup) {
+  GTEST_SKIP();
+  for (auto boot_from_startup_snapshot : {false, true}) {
+    for (auto worker_count : kWorkerCounts) {
+      auto start = TimeProvider::GetSteadyTimestampInNanoseconds();
+      WorkerPoolApiSapi pool(
+          GetConfigs(worker_count, boot_from_startup_snapshot), worker_count);
+      EXPECT_SUCCESS(pool.Init());
+      EXPECT_SUCCESS(pool.Run());
+      for (size_t i = 0; i < worker_count; i++) {
+        auto worker_or = pool.GetWorker(i);
+        EXPECT_SUCCESS(worker_or.result());
+        LoadCode(**worker_or);
+      }
+      auto elapsed_ns =
+          (TimeProvider::GetSteadyTimestampInNanoseconds() - start).count();
+      ReportStartupTime(boot_from_startup_snapshot
+                            ? "Concurrent from startup snapshot"
+                            : "Concurrent",
+                        worker_count, elapsed_ns);
+
+      EXPECT_SUCCESS(pool.Stop());
+    }
+  }
+}
+}  // namespace google::scp::roma::sandbox::worker_pool::test
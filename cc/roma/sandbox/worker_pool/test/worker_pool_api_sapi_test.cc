@@ -56,6 +56,31 @@ TEST(WorkerPoolTest, CanInitRunAndStop) {
   EXPECT_SUCCESS(result);
 }
 
+TEST(WorkerPoolTest, CanInitRunAndStopFromStartupSnapshot) {
+  int num_workers = 4;
+  vector<WorkerApiSapiConfig> configs;
+  for (int i = 0; i < num_workers; i++) {
+    WorkerApiSapiConfig config;
+    config.worker_js_engine = worker::WorkerFactory::WorkerEngine::v8;
+    config.js_engine_require_code_preload = false;
+    config.native_js_function_comms_fd = -1;
+    config.native_js_function_names = vector<string>();
+    config.boot_from_startup_snapshot = true;
+    configs.push_back(config);
+  }
+
+  auto pool = WorkerPoolApiSapi(configs, num_workers);
+
+  auto result = pool.Init();
+  EXPECT_SUCCESS(result);
+
+  result = pool.Run();
+  EXPECT_SUCCESS(result);
+
+  result = pool.Stop();
+  EXPECT_SUCCESS(result);
+}
+
 TEST(WorkerPoolTest, CanGetPoolCount) {
   int num_workers = 2;
   vector<WorkerApiSapiConfig> configs;
@@ -17,6 +17,7 @@
 #include "execution_utils.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -57,6 +58,7 @@ using v8::Int32;
 using v8::Isolate;
 using v8::JSON;
 using v8::Local;
+using v8::MaybeLocal;
 using v8::MemorySpan;
 using v8::Message;
 using v8::Name;
@@ -70,6 +72,8 @@ using v8::TryCatch;
 using v8::UnboundScript;
 using v8::Undefined;
 using v8::Value;
+using v8::ValueDeserializer;
+using v8::ValueSerializer;
 using v8::WasmMemoryObject;
 using v8::WasmModuleObject;
 
@@ -179,6 +183,34 @@ string ExecutionUtils::ExtractMessage(Isolate* isolate,
   return absl::StrFormat("line %i: %s", line, exception_msg);
 }
 
+bool ExecutionUtils::SerializeValue(Isolate* isolate, Local<Context> context,
+                                    Local<Value> value,
+                                    string& serialized) noexcept {
+  ValueSerializer serializer(isolate);
+  serializer.WriteHeader();
+  if (!serializer.WriteValue(context, value).FromMaybe(false)) {
+    return false;
+  }
+  // The buffer is allocated by the default delegate, with realloc.
+  auto buffer = serializer.Release();
+  serialized.assign(reinterpret_cast<const char*>(buffer.first),
+                    buffer.second);
+  free(buffer.first);
+  return true;
+}
+
+MaybeLocal<Value> ExecutionUtils::DeserializeValue(Isolate* isolate,
+                                                   Local<Context> context,
+                                                   const char* data,
+                                                   size_t size) noexcept {
+  ValueDeserializer deserializer(
+      isolate, reinterpret_cast<const uint8_t*>(data), size);
+  if (!deserializer.ReadHeader(context).FromMaybe(false)) {
+    return MaybeLocal<Value>();
+  }
+  return deserializer.ReadValue(context);
+}
+
 string ExecutionUtils::DescribeError(Isolate* isolate,
                                      TryCatch* try_catch) noexcept {
   const Local<Message> message = try_catch->Message();
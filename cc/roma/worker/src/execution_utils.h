@@ -136,20 +136,60 @@ class ExecutionUtils {
                                               StringT& err_msg) noexcept {
     auto isolate = v8::Isolate::GetCurrent();
     v8::HandleScope handle_scope(isolate);
+
+    v8::Local<v8::WasmModuleObject> wasm_module;
+    auto result = CompileWASM(wasm, wasm_module, err_msg);
+    if (!result.Successful()) {
+      return result;
+    }
+    return InstantiateWASM(wasm_module, err_msg);
+  }
+
+  /**
+   * @brief Compiles WASM code object into a module, which can be instantiated
+   * any number of times without recompiling it.
+   *
+   * @param wasm the byte object of WASM code.
+   * @param wasm_module the compiled module, in the handle scope of the caller.
+   * @param err_msg the error message to output.
+   * @return core::ExecutionResult
+   */
+  template <typename StringT = common::RomaString>
+  static core::ExecutionResult CompileWASM(
+      const StringT& wasm, v8::Local<v8::WasmModuleObject>& wasm_module,
+      StringT& err_msg) noexcept {
+    auto isolate = v8::Isolate::GetCurrent();
     v8::TryCatch try_catch(isolate);
-    v8::Local<v8::Context> context(isolate->GetCurrentContext());
 
     auto module_maybe = v8::WasmModuleObject::Compile(
         isolate, v8::MemorySpan<const uint8_t>(
                      reinterpret_cast<const unsigned char*>(wasm.c_str()),
                      wasm.length()));
-    v8::Local<v8::WasmModuleObject> wasm_module;
     if (!module_maybe.ToLocal(&wasm_module)) {
       ExecutionUtils::ReportException(&try_catch, err_msg);
       return core::FailureExecutionResult(
           core::errors::SC_ROMA_V8_WORKER_WASM_COMPILE_FAILURE);
     }
 
+    return core::SuccessExecutionResult();
+  }
+
+  /**
+   * @brief Instantiates a compiled WASM module in the current context, and
+   * registers its exports in the context.
+   *
+   * @param wasm_module the compiled module.
+   * @param err_msg the error message to output.
+   * @return core::ExecutionResult
+   */
+  template <typename StringT = common::RomaString>
+  static core::ExecutionResult InstantiateWASM(
+      v8::Local<v8::WasmModuleObject> wasm_module, StringT& err_msg) noexcept {
+    auto isolate = v8::Isolate::GetCurrent();
+    v8::HandleScope handle_scope(isolate);
+    v8::TryCatch try_catch(isolate);
+    v8::Local<v8::Context> context(isolate->GetCurrentContext());
+
     v8::Local<v8::Value> web_assembly;
     if (!context->Global()
              ->Get(context, v8::String::NewFromUtf8(isolate, kWebAssemblyTag)
@@ -366,6 +406,93 @@ class ExecutionUtils {
     return argv;
   }
 
+  /**
+   * @brief Pass the input as JS strings, without parsing it.
+   *
+   * @param input
+   * @return Local<Array> The array of string values
+   */
+  template <typename InputT = common::RomaVector<common::RomaString>>
+  static v8::Local<v8::Array> StringsAsJsInput(const InputT& input) {
+    auto isolate = v8::Isolate::GetCurrent();
+    auto context = isolate->GetCurrentContext();
+
+    const int argc = input.size();
+
+    v8::Local<v8::Array> argv = v8::Array::New(isolate, argc);
+    for (auto i = 0; i < argc; ++i) {
+      v8::Local<v8::String> arg;
+      if (!v8::String::NewFromUtf8(isolate, input[i].data(),
+                                   v8::NewStringType::kNormal,
+                                   static_cast<uint32_t>(input[i].length()))
+               .ToLocal(&arg) ||
+          !argv->Set(context, i, arg).ToChecked()) {
+        return v8::Local<v8::Array>();
+      }
+    }
+
+    return argv;
+  }
+
+  /**
+   * @brief Deserialize the input from v8::ValueSerializer blobs to turn it
+   * into the right JS types, without a JSON text round trip.
+   *
+   * @param input
+   * @return Local<Array> The array of deserialized values
+   */
+  template <typename InputT = common::RomaVector<common::RomaString>>
+  static v8::Local<v8::Array> DeserializeAsJsInput(const InputT& input) {
+    auto isolate = v8::Isolate::GetCurrent();
+    auto context = isolate->GetCurrentContext();
+
+    const int argc = input.size();
+
+    v8::Local<v8::Array> argv = v8::Array::New(isolate, argc);
+    for (auto i = 0; i < argc; ++i) {
+      v8::Local<v8::Value> arg = v8::Undefined(isolate);
+      if (input[i].length() > 0 &&
+          !DeserializeValue(isolate, context, input[i].data(),
+                            input[i].length())
+               .ToLocal(&arg)) {
+        return v8::Local<v8::Array>();
+      }
+      if (!argv->Set(context, i, arg).ToChecked()) {
+        return v8::Local<v8::Array>();
+      }
+    }
+
+    return argv;
+  }
+
+  /**
+   * @brief Serialize the value with a v8::ValueSerializer.
+   *
+   * @param isolate
+   * @param context
+   * @param value
+   * @param serialized The serialized value.
+   * @return true if the value could be serialized.
+   */
+  static bool SerializeValue(v8::Isolate* isolate,
+                             v8::Local<v8::Context> context,
+                             v8::Local<v8::Value> value,
+                             std::string& serialized) noexcept;
+
+  /**
+   * @brief Deserialize a value serialized with a v8::ValueSerializer.
+   *
+   * @param isolate
+   * @param context
+   * @param data
+   * @param size
+   * @return v8::MaybeLocal<v8::Value> The value, empty if the data is not a
+   * valid serialized value.
+   */
+  static v8::MaybeLocal<v8::Value> DeserializeValue(
+      v8::Isolate* isolate, v8::Local<v8::Context> context, const char* data,
+      size_t size) noexcept;
+
   /**
    * @brief Parse the handler input to be provided to a WASM handler.
    * This function handles writing to the WASM memory if necessary.